@@ -9,7 +9,10 @@
  */
 #pragma once
 #include "common/network/if/gen-cpp2/Address_types.h"
+#include <folly/Bits.h>
+#include <folly/Hash.h>
 #include <folly/IPAddress.h>
+#include <folly/MacAddress.h>
 
 namespace facebook { namespace network {
 
@@ -69,3 +72,94 @@ inline folly::IPAddress toIPAddress(const thrift::BinaryAddress& addr) {
 }
 
 } /* namespace network */ } /* namespace facebook */
+
+namespace facebook { namespace fboss {
+
+/*
+ * Fixed-width comparison and hash kernels for the address types on the
+ * packet hot path.
+ *
+ * The generic folly operators branch on address family and compare byte
+ * by byte; since callers here know the width statically, these helpers
+ * compile down to a couple of word loads and compares (the two 64-bit
+ * IPv6 equality compares combine into a single 128-bit vector compare
+ * where the target supports it).
+ */
+
+inline bool equalsFast(const folly::IPAddressV4& a,
+                       const folly::IPAddressV4& b) {
+  return a.toLong() == b.toLong();
+}
+
+inline bool equalsFast(const folly::IPAddressV6& a,
+                       const folly::IPAddressV6& b) {
+  auto a0 = folly::loadUnaligned<uint64_t>(a.bytes());
+  auto a1 = folly::loadUnaligned<uint64_t>(a.bytes() + 8);
+  auto b0 = folly::loadUnaligned<uint64_t>(b.bytes());
+  auto b1 = folly::loadUnaligned<uint64_t>(b.bytes() + 8);
+  return ((a0 ^ b0) | (a1 ^ b1)) == 0;
+}
+
+inline bool equalsFast(folly::MacAddress a, folly::MacAddress b) {
+  // 6 address bytes plus the 2 zero pad bytes in one 64-bit compare
+  return a.u64HBO() == b.u64HBO();
+}
+
+inline bool lessFast(const folly::IPAddressV4& a,
+                     const folly::IPAddressV4& b) {
+  return a.toLongHBO() < b.toLongHBO();
+}
+
+inline bool lessFast(const folly::IPAddressV6& a,
+                     const folly::IPAddressV6& b) {
+  // Byte-lexicographic order equals numeric order on big-endian words
+  auto a0 = folly::Endian::big(folly::loadUnaligned<uint64_t>(a.bytes()));
+  auto b0 = folly::Endian::big(folly::loadUnaligned<uint64_t>(b.bytes()));
+  if (a0 != b0) {
+    return a0 < b0;
+  }
+  auto a1 = folly::Endian::big(folly::loadUnaligned<uint64_t>(a.bytes() + 8));
+  auto b1 = folly::Endian::big(folly::loadUnaligned<uint64_t>(b.bytes() + 8));
+  return a1 < b1;
+}
+
+inline uint64_t hashFast(const folly::IPAddressV4& a) {
+  return folly::hash::twang_mix64(a.toLong());
+}
+
+inline uint64_t hashFast(const folly::IPAddressV6& a) {
+  return folly::hash::hash_128_to_64(
+      folly::loadUnaligned<uint64_t>(a.bytes()),
+      folly::loadUnaligned<uint64_t>(a.bytes() + 8));
+}
+
+inline uint64_t hashFast(folly::MacAddress a) {
+  return folly::hash::twang_mix64(a.u64HBO());
+}
+
+/*
+ * Functor wrappers so the kernels can be plugged into standard and boost
+ * containers as Compare/Hash/KeyEqual parameters.
+ */
+struct AddressLessFast {
+  template <typename Addr>
+  bool operator()(const Addr& a, const Addr& b) const {
+    return lessFast(a, b);
+  }
+};
+
+struct AddressEqualFast {
+  template <typename Addr>
+  bool operator()(const Addr& a, const Addr& b) const {
+    return equalsFast(a, b);
+  }
+};
+
+struct AddressHashFast {
+  template <typename Addr>
+  size_t operator()(const Addr& a) const {
+    return hashFast(a);
+  }
+};
+
+}} // facebook::fboss
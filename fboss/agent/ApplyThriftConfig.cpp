@@ -12,6 +12,7 @@
 #include <folly/FileUtil.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
+#include "fboss/agent/BootProfiler.h"
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/Platform.h"
 #include "fboss/agent/state/AclEntry.h"
@@ -164,9 +165,34 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
   auto newState = orig_->clone();
   bool changed = false;
 
-  processVlanPorts();
-
-  {
+  // Section-level change detection: a rebuild step below is skipped
+  // outright when every config section it derives its output from
+  // matches the previous config, since orig_ already reflects that
+  // config (callers pass in the config that produced the current
+  // state). A one-line port change then rebuilds just the ports,
+  // reuses the vlan, interface, route and ACL subtrees from orig_
+  // untouched, and yields a one-node delta.
+  //
+  // Thrift-generated structs provide deep equality, so the sections are
+  // compared directly instead of through serialized fingerprints.
+  bool vlanPortsSame = (prevCfg_->vlanPorts == cfg_->vlanPorts);
+  bool portsSame = vlanPortsSame && (prevCfg_->ports == cfg_->ports);
+  bool intfsSame = (prevCfg_->interfaces == cfg_->interfaces);
+  // Vlans consume the vlan --> interface mapping computed by
+  // updateInterfaces(), so an interface change dirties them as well.
+  bool vlansSame =
+      vlanPortsSame && intfsSame && (prevCfg_->vlans == cfg_->vlans);
+  bool aclsSame = (prevCfg_->acls == cfg_->acls);
+  bool staticRoutesSame =
+      (prevCfg_->staticRoutesToNull == cfg_->staticRoutesToNull) &&
+      (prevCfg_->staticRoutesToCPU == cfg_->staticRoutesToCPU) &&
+      (prevCfg_->staticRoutesWithNhops == cfg_->staticRoutesWithNhops);
+
+  if (!portsSame || !vlansSame) {
+    processVlanPorts();
+  }
+
+  if (!portsSame) {
     auto newPorts = updatePorts();
     if (newPorts) {
       newState->resetPorts(std::move(newPorts));
@@ -174,7 +200,11 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
     }
   }
 
-  {
+  if (!intfsSame || !vlansSame) {
+    // updateInterfaces() also populates the vlanInterfaces_ and
+    // intfRouteTables_ data structures consumed below, so it has to run
+    // whenever the vlan section is dirty even if the interfaces
+    // themselves are unchanged.
     auto newIntfs = updateInterfaces();
     if (newIntfs) {
       newState->resetIntfs(std::move(newIntfs));
@@ -184,7 +214,7 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
 
   // Note: updateInterfaces() must be called before updateVlans(),
   // as updateInterfaces() populates the vlanInterfaces_ data structure.
-  {
+  if (!vlansSame) {
     auto newVlans = updateVlans();
     if (newVlans) {
       newState->resetVlans(std::move(newVlans));
@@ -194,14 +224,18 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
 
   // Note: updateInterfaces() must be called before updateInterfaceRoutes(),
   // as updateInterfaces() populates the intfRouteTables_ data structure.
-  {
+  if (!intfsSame) {
     auto newTables = updateInterfaceRoutes();
     if (newTables) {
       newState->resetRouteTables(newTables);
       changed = true;
     }
-    auto newerTables = updateStaticRoutes(newTables ? newTables :
-        orig_->getRouteTables());
+  }
+  if (!staticRoutesSame) {
+    // Static routes already in the tables are carried forward by the
+    // interface route update above, so this only needs to run when the
+    // static route sections themselves changed.
+    auto newerTables = updateStaticRoutes(newState->getRouteTables());
     if (newerTables) {
       newState->resetRouteTables(std::move(newerTables));
       changed = true;
@@ -237,7 +271,7 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
    }
   }
 
-  {
+  if (!aclsSame) {
     auto newAcls = updateAcls();
     if (newAcls) {
       newState->resetAcls(std::move(newAcls));
@@ -273,6 +307,11 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
     changed = true;
   }
 
+  if (orig_->getCpuQueues() != cfg_->cpuQueues) {
+    newState->setCpuQueues(cfg_->cpuQueues);
+    changed = true;
+  }
+
 
   if (!changed) {
     return nullptr;
@@ -971,6 +1010,7 @@ shared_ptr<SwitchState> applyThriftConfig(
     const cfg::SwitchConfig* config,
     const Platform* platform,
     const cfg::SwitchConfig* prevConfig) {
+  BootProfiler::Phase phase("applyThriftConfig");
   cfg::SwitchConfig emptyConfig;
   return ThriftConfigApplier(state, config, platform,
       prevConfig ? prevConfig : &emptyConfig).run();
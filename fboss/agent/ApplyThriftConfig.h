@@ -26,6 +26,10 @@ class SwitchState;
  *
  * Returns a new SwitchState object with the resulting state, or null if
  * the config file results in no changes.
+ *
+ * prevConfig, when supplied, must be the config that produced the input
+ * state: sections that are unchanged from it are skipped entirely and
+ * the corresponding SwitchState subtrees reused as-is.
  */
 std::shared_ptr<SwitchState> applyThriftConfig(
   const std::shared_ptr<SwitchState>& state,
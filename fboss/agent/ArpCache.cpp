@@ -34,6 +34,10 @@ void ArpCache::receivedArpMine(folly::IPAddressV4 ip,
                                ArpOpCode op) {
   // always set an entry, even if the reply was unsolicited
   setEntry(ip, mac, port, NeighborEntryState::REACHABLE);
+
+  // The neighbor is resolved now; release any packets that were queued
+  // up waiting for it.
+  flushPendingPackets(ip);
 }
 
 void ArpCache::receivedArpNotMine(folly::IPAddressV4 ip,
@@ -46,13 +50,10 @@ void ArpCache::receivedArpNotMine(folly::IPAddressV4 ip,
   setExistingEntry(ip, mac, port, NeighborEntryState::REACHABLE);
 }
 
-inline void ArpCache::probeFor(folly::IPAddressV4 ip) const {
-  auto vlan = getSw()->getState()->getVlans()->getVlanIf(getVlanID());
-  if (!vlan) {
-    VLOG(2) << "Vlan " << getVlanID() << " not found. Skip sending probe";
-    return;
-  }
-  ArpHandler::sendArpRequest(getSw(), vlan, ip);
+void ArpCache::restoreEntry(folly::IPAddressV4 ip,
+                            folly::MacAddress mac,
+                            PortID port) {
+  setEntry(ip, mac, port, NeighborEntryState::STALE);
 }
 
 std::list<ArpEntryThrift> ArpCache::getArpCacheData() {
@@ -37,7 +37,15 @@ class ArpCache : public NeighborCache<ArpTable> {
                           PortID port,
                           ArpOpCode op);
 
-  void probeFor(folly::IPAddressV4 ip) const override;
+  /*
+   * Restore an entry checkpointed by the previous run on warm boot.
+   * The entry enters in STALE state: it is programmed and usable right
+   * away, but gets revalidated on the cache's own (jittered) stale
+   * timers instead of being re-probed immediately.
+   */
+  void restoreEntry(folly::IPAddressV4 ip,
+                    folly::MacAddress mac,
+                    PortID port);
 
   std::list<ArpEntryThrift> getArpCacheData();
 
@@ -18,6 +18,7 @@
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/SwitchStats.h"
 #include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/NeighborResponseIndex.h"
 #include "fboss/agent/NeighborUpdater.h"
 #include "fboss/agent/TxPacket.h"
 #include "fboss/agent/packet/PktUtil.h"
@@ -47,6 +48,11 @@ enum : uint8_t {
   ARP_PLEN_IPV4 = 4,
 };
 
+namespace {
+// Safety cap on the number of cached ARP reply templates
+const size_t kMaxArpReplyTemplates = 1024;
+}
+
 namespace facebook { namespace fboss {
 
 ArpHandler::ArpHandler(SwSwitch* sw)
@@ -108,7 +114,7 @@ void ArpHandler::handlePacket(unique_ptr<RxPacket> pkt,
 
   auto updater = sw_->getNeighborUpdater();
   // Check to see if this IP address is in our ARP response table.
-  auto entry = vlan->getArpResponseTable()->getEntry(targetIP);
+  auto entry = sw_->getNeighborResponseIndex()->lookup(vlan->getID(), targetIP);
   if (!entry) {
     // The target IP does not refer to us.
     VLOG(5) << "ignoring ARP message for " << targetIP.str()
@@ -129,6 +135,8 @@ void ArpHandler::handlePacket(unique_ptr<RxPacket> pkt,
     sendArpReply(pkt->getSrcVlan(), pkt->getSrcPort(),
                  entry.value().mac, targetIP,
                  senderMac, senderIP);
+    // The reply we just queued for tx completes this packet's slow path
+    sw_->recordRxPacketTrace(pkt.get());
     return;
   } else {
     stats->port(port)->arpReplyRx();
@@ -203,7 +211,30 @@ void ArpHandler::sendArpReply(VlanID vlan,
                               MacAddress targetMac,
                               IPAddressV4 targetIP) {
   sw_->stats()->port(port)->arpReplyTx();
-  sendArp(sw_, vlan, ARP_OP_REPLY, senderMac, senderIP, targetMac, targetIP);
+  VLOG(3) << "sending ARP reply on vlan " << vlan
+          << " to " << targetIP.str() << " (" << targetMac << "): "
+          << senderIP.str() << " is " << senderMac;
+
+  // Replies for a given (vlan, mac, IP) only differ in the requester's
+  // MAC and IP, so we serialize the frame once per tuple and patch those
+  // fields into a copy of the template.
+  auto pkt = sw_->allocatePacket(ArpReplyTemplate::SIZE);
+  {
+    std::lock_guard<std::mutex> g(arpTemplatesLock_);
+    auto key = std::make_tuple(vlan, senderMac, senderIP);
+    auto it = arpTemplates_.find(key);
+    if (it == arpTemplates_.end()) {
+      if (arpTemplates_.size() >= kMaxArpReplyTemplates) {
+        // The tuples mirror the ARP response table, which is bounded by
+        // the configured interface addresses; this is just a safety net.
+        arpTemplates_.clear();
+      }
+      it = arpTemplates_.emplace(
+          key, ArpReplyTemplate(vlan, senderMac, senderIP)).first;
+    }
+    it->second.writeReply(pkt.get(), targetMac, targetIP);
+  }
+  sw_->sendPacketSwitched(std::move(pkt));
 }
 
 void ArpHandler::sendArpRequest(SwSwitch* sw,
@@ -10,12 +10,16 @@
 #pragma once
 
 #include "fboss/agent/types.h"
+#include "fboss/agent/NeighborResponseTemplates.h"
 #include "fboss/agent/state/NeighborEntry.h"
 #include "fboss/agent/state/Interface.h"
 #include "fboss/agent/state/Vlan.h"
 
 #include <memory>
+#include <mutex>
+#include <tuple>
 
+#include <boost/container/flat_map.hpp>
 #include <folly/IPAddressV4.h>
 #include <folly/MacAddress.h>
 
@@ -79,6 +83,15 @@ class ArpHandler {
                     folly::IPAddressV4 targetIP);
 
   SwSwitch* sw_{nullptr};
+
+  // Cached pre-serialized ARP replies, keyed by the (vlan, sender MAC,
+  // sender IP) tuple they were built for. The frame content is fully
+  // determined by the key, so entries never go stale and no invalidation
+  // on state changes is needed.
+  std::mutex arpTemplatesLock_;
+  boost::container::flat_map<
+      std::tuple<VlanID, folly::MacAddress, folly::IPAddressV4>,
+      ArpReplyTemplate> arpTemplates_;
 };
 
 }} // facebook::fboss
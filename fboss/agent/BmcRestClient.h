@@ -21,6 +21,9 @@ class BmcRestClient: public RestClient {
     * Endpoints for BMC Rest api
     */
     bool resetCP2112();
+    // Async variant; the reset round trip overlaps with the caller's
+    // other work.
+    folly::Future<bool> resetCP2112Async();
  };
 
 }} // namespace facebook::fboss
@@ -0,0 +1,140 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/BootProfiler.h"
+
+#include <folly/FileUtil.h>
+#include <folly/ThreadId.h>
+#include <folly/dynamic.h>
+#include <folly/json.h>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <pthread.h>
+
+#include <set>
+
+DEFINE_string(boot_trace_file, "",
+              "If set, record agent initialization phases and write them to "
+              "this file as a chrome://tracing JSON trace once boot "
+              "completes");
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+namespace facebook { namespace fboss {
+
+BootProfiler& BootProfiler::get() {
+  static BootProfiler profiler;
+  return profiler;
+}
+
+BootProfiler::BootProfiler()
+    : origin_(steady_clock::now()) {
+  recording_.store(!FLAGS_boot_trace_file.empty(),
+                   std::memory_order_relaxed);
+}
+
+BootProfiler::Phase::Phase(folly::StringPiece name) {
+  auto& profiler = BootProfiler::get();
+  if (!profiler.isRecording()) {
+    return;
+  }
+  name_ = name.str();
+  start_ = steady_clock::now();
+  active_ = true;
+}
+
+BootProfiler::Phase::~Phase() {
+  end();
+}
+
+void BootProfiler::Phase::end() {
+  if (!active_) {
+    return;
+  }
+  active_ = false;
+  auto& profiler = BootProfiler::get();
+  Event event;
+  event.name = std::move(name_);
+  event.tid = folly::getCurrentThreadID();
+  char threadName[16];
+  if (pthread_getname_np(pthread_self(), threadName,
+                         sizeof(threadName)) == 0) {
+    event.threadName = threadName;
+  }
+  event.startUs =
+      duration_cast<microseconds>(start_ - profiler.origin_).count();
+  event.durationUs =
+      duration_cast<microseconds>(steady_clock::now() - start_).count();
+  profiler.record(std::move(event));
+}
+
+void BootProfiler::record(Event event) {
+  std::lock_guard<std::mutex> g(mutex_);
+  // finish() may have raced with the tail of a phase; such stragglers
+  // are simply dropped.
+  if (!isRecording()) {
+    return;
+  }
+  events_.push_back(std::move(event));
+}
+
+void BootProfiler::finish() {
+  std::vector<Event> events;
+  {
+    std::lock_guard<std::mutex> g(mutex_);
+    if (!isRecording()) {
+      return;
+    }
+    recording_.store(false, std::memory_order_relaxed);
+    events.swap(events_);
+  }
+
+  folly::dynamic traceEvents = folly::dynamic::array;
+  // Complete ("X") events carry a start and a duration; the viewer
+  // nests them per thread by interval containment.
+  for (const auto& event : events) {
+    traceEvents.push_back(folly::dynamic::object
+        ("name", event.name)
+        ("ph", "X")
+        ("ts", event.startUs)
+        ("dur", event.durationUs)
+        ("pid", 0)
+        ("tid", event.tid));
+  }
+  // Metadata events label each thread with its name.
+  std::set<std::pair<uint64_t, std::string>> threads;
+  for (const auto& event : events) {
+    if (!event.threadName.empty()) {
+      threads.emplace(event.tid, event.threadName);
+    }
+  }
+  for (const auto& thread : threads) {
+    traceEvents.push_back(folly::dynamic::object
+        ("name", "thread_name")
+        ("ph", "M")
+        ("pid", 0)
+        ("tid", thread.first)
+        ("args", folly::dynamic::object("name", thread.second)));
+  }
+  folly::dynamic trace = folly::dynamic::object
+      ("traceEvents", std::move(traceEvents));
+
+  if (folly::writeFile(folly::toJson(trace), FLAGS_boot_trace_file.c_str())) {
+    LOG(INFO) << "wrote boot trace with " << events.size() << " phases to "
+              << FLAGS_boot_trace_file;
+  } else {
+    LOG(ERROR) << "failed to write boot trace to " << FLAGS_boot_trace_file;
+  }
+}
+
+}} // facebook::fboss
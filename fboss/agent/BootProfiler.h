@@ -0,0 +1,102 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+/*
+ * BootProfiler records scoped phase markers through agent
+ * initialization (SwSwitch::init, the hardware init, the initial
+ * config apply, the TUN interface sync) and writes them out as a
+ * chrome://tracing JSON trace once boot completes.  Loading the trace
+ * in chrome://tracing (or any flame-graph viewer that reads the
+ * format) shows the phases nested per thread, so a cold-boot
+ * regression can be attributed to a phase in one look instead of
+ * bisecting builds against the coarse publishInitTimes() counters.
+ *
+ * Recording is enabled by setting --boot_trace_file.  Markers are
+ * dropped once finish() has written the trace, so steady-state code
+ * paths that happen to pass through an instrumented function pay one
+ * relaxed atomic load.
+ */
+class BootProfiler {
+ public:
+  static BootProfiler& get();
+
+  /*
+   * A scoped phase marker.  Construct it at the top of the phase; the
+   * destructor records the completed interval.  Phases nest: the
+   * tracing format infers nesting from interval containment within a
+   * thread, so no parent bookkeeping is needed here.
+   */
+  class Phase {
+   public:
+    explicit Phase(folly::StringPiece name);
+    ~Phase();
+
+    // Record the phase now instead of at scope exit, for callers that
+    // need the marker flushed before they hand off (e.g. to finish()).
+    void end();
+
+   private:
+    // Forbidden copy constructor and assignment operator
+    Phase(Phase const &) = delete;
+    Phase& operator=(Phase const &) = delete;
+
+    std::string name_;
+    std::chrono::steady_clock::time_point start_;
+    bool active_{false};
+  };
+
+  bool isRecording() const {
+    return recording_.load(std::memory_order_relaxed);
+  }
+
+  /*
+   * Stop recording and write the trace to --boot_trace_file.  Called
+   * once boot completes; later calls (and calls with recording never
+   * enabled) are no-ops.
+   */
+  void finish();
+
+ private:
+  struct Event {
+    std::string name;
+    uint64_t tid;
+    std::string threadName;
+    uint64_t startUs;
+    uint64_t durationUs;
+  };
+
+  BootProfiler();
+
+  // Forbidden copy constructor and assignment operator
+  BootProfiler(BootProfiler const &) = delete;
+  BootProfiler& operator=(BootProfiler const &) = delete;
+
+  void record(Event event);
+
+  const std::chrono::steady_clock::time_point origin_;
+  std::atomic<bool> recording_{false};
+  std::mutex mutex_;
+  std::vector<Event> events_;
+
+  friend class Phase;
+};
+
+}} // facebook::fboss
@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/CounterDeltaExporter.h"
+
+#include <folly/Varint.h>
+
+#include "common/stats/ServiceData.h"
+#include "fboss/agent/FbossError.h"
+
+DEFINE_int32(counter_batch_cache_ms, 500,
+             "How long a counter delta batch is served from cache before "
+             "the counters are read again. Scrapers sharing a manifest "
+             "within this window cost a single counter read.");
+DEFINE_int32(max_counter_manifests, 32,
+             "Maximum number of counter manifests that may be registered "
+             "at once");
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace {
+
+void appendValue(std::string* out, int64_t value) {
+  uint8_t buf[folly::kMaxVarintLength64];
+  auto len = folly::encodeVarint(folly::encodeZigZag(value), buf);
+  out->append(reinterpret_cast<const char*>(buf), len);
+}
+
+} // unnamed namespace
+
+namespace facebook { namespace fboss {
+
+int64_t CounterDeltaExporter::registerManifest(
+    const std::vector<std::string>& names) {
+  if (names.empty()) {
+    throw FbossError("cannot register an empty counter manifest");
+  }
+  std::lock_guard<std::mutex> g(lock_);
+  if (manifests_.size() >=
+      static_cast<size_t>(FLAGS_max_counter_manifests)) {
+    throw FbossError("counter manifest limit (", FLAGS_max_counter_manifests,
+                     ") reached");
+  }
+  auto id = nextId_++;
+  auto& manifest = manifests_[id];
+  manifest.names = names;
+  return id;
+}
+
+CounterDeltaExporter::Batch CounterDeltaExporter::getDeltas(
+    int64_t manifestId, int64_t sinceVersion) {
+  std::lock_guard<std::mutex> g(lock_);
+  auto it = manifests_.find(manifestId);
+  if (it == manifests_.end()) {
+    throw FbossError("unknown counter manifest ", manifestId);
+  }
+  auto& manifest = it->second;
+
+  // Another scraper on the same manifest and base gets the reply we
+  // just computed, without touching the counters again.
+  if (manifest.cachedBase == sinceVersion &&
+      steady_clock::now() - manifest.cachedAt <
+          milliseconds(FLAGS_counter_batch_cache_ms)) {
+    return manifest.cached;
+  }
+
+  std::vector<int64_t> values;
+  values.reserve(manifest.names.size());
+  for (const auto& name : manifest.names) {
+    values.push_back(readCounter(name));
+  }
+
+  Batch batch;
+  batch.version = ++manifest.version;
+  // Deltas are only meaningful when the caller's base is the snapshot
+  // we still hold; anything else (first read, or a scraper that fell
+  // behind the cache window) gets absolute values to resync.
+  batch.absolute =
+      manifest.lastValues.empty() || sinceVersion != batch.version - 1;
+  batch.values.reserve(values.size() * 2);
+  for (size_t idx = 0; idx < values.size(); ++idx) {
+    auto value = batch.absolute ? values[idx]
+                                : values[idx] - manifest.lastValues[idx];
+    appendValue(&batch.values, value);
+  }
+
+  manifest.lastValues.swap(values);
+  manifest.cached = batch;
+  manifest.cachedBase = sinceVersion;
+  manifest.cachedAt = steady_clock::now();
+  return batch;
+}
+
+int64_t CounterDeltaExporter::readCounter(const std::string& name) const {
+  return fbData->getCounter(name);
+}
+
+}} // facebook::fboss
@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+/*
+ * CounterDeltaExporter backs the batched counter export thrift calls
+ * (registerCounterManifest / getCounterDeltas).
+ *
+ * fb303 getCounters() materializes the full name-to-value map on every
+ * scrape, which is measurable server-side work once hundreds of
+ * counters are scraped every few seconds.  A scraper instead registers
+ * the list of counters it wants once; the manifest fixes the slot
+ * order, so every subsequent reply is one packed varint per slot with
+ * no names or map nodes on the wire.  Values are zigzag/varint encoded
+ * deltas against the previously served snapshot, which keeps
+ * steady-state replies to a couple of bytes per counter.  Replies are
+ * cached for --counter_batch_cache_ms, so several scrapers sharing one
+ * manifest cost a single counter read per interval.
+ */
+class CounterDeltaExporter {
+ public:
+  struct Batch {
+    int64_t version{0};
+    /*
+     * When true the packed values are absolute counter values rather
+     * than deltas: the first read of a manifest, or the caller's
+     * sinceVersion no longer matches the served base snapshot.
+     */
+    bool absolute{true};
+    // One zigzag/varint encoded value per manifest entry, in
+    // registration order.
+    std::string values;
+  };
+
+  CounterDeltaExporter() {}
+  virtual ~CounterDeltaExporter() {}
+
+  /*
+   * Register a counter manifest and return its id.  The slot order of
+   * later delta batches is the order of names here.  Throws FbossError
+   * if names is empty or the manifest limit has been reached.
+   */
+  int64_t registerManifest(const std::vector<std::string>& names);
+
+  /*
+   * Read the manifest's counters and return them packed into a single
+   * buffer: deltas against the caller's sinceVersion when it matches
+   * the served base snapshot, absolute values otherwise.  Throws
+   * FbossError for an unknown manifest id.
+   */
+  Batch getDeltas(int64_t manifestId, int64_t sinceVersion);
+
+ protected:
+  // Reads via fbData; overridden by tests to serve synthetic values.
+  virtual int64_t readCounter(const std::string& name) const;
+
+ private:
+  struct Manifest {
+    std::vector<std::string> names;
+    // Values of the snapshot identified by version; the base the next
+    // delta batch is encoded against.
+    std::vector<int64_t> lastValues;
+    int64_t version{0};
+    // Last reply and the base version it was encoded against, kept so
+    // scrapers sharing the manifest within the cache window reuse it.
+    Batch cached;
+    int64_t cachedBase{-1};
+    std::chrono::steady_clock::time_point cachedAt;
+  };
+
+  // Forbidden copy constructor and assignment operator
+  CounterDeltaExporter(CounterDeltaExporter const&) = delete;
+  CounterDeltaExporter& operator=(CounterDeltaExporter const&) = delete;
+
+  std::mutex lock_;
+  int64_t nextId_{1};
+  std::map<int64_t, Manifest> manifests_;
+};
+
+}} // facebook::fboss
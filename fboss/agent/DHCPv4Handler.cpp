@@ -14,11 +14,13 @@
 #include <folly/io/Cursor.h>
 #include <folly/IPAddress.h>
 #include "FbossError.h"
+#include "fboss/agent/DhcpTransactionCache.h"
 #include "fboss/agent/packet/DHCPv4Packet.h"
 #include "fboss/agent/packet/IPv4Hdr.h"
 #include "fboss/agent/packet/IPProto.h"
 #include "fboss/agent/packet/EthHdr.h"
 #include "fboss/agent/packet/Ethertype.h"
+#include "fboss/agent/packet/PktUtil.h"
 #include "fboss/agent/state/Interface.h"
 #include "fboss/agent/state/InterfaceMap.h"
 #include "fboss/agent/state/SwitchState.h"
@@ -96,7 +98,11 @@ void sendDHCPPacket(SwSwitch* sw, const EthHdr& ethHdr, const IPv4Hdr& ipHdr,
   folly::io::Cursor payloadStart(rwCursor);
 
   dhcpPacket.write(&rwCursor);
-  uint16_t csum = udpHdr.computeChecksum(ipHdr, payloadStart);
+  // A non-zero checksum was already patched incrementally from the
+  // received packet; only fall back to a full-payload computation when
+  // the sender didn't checksum the original.
+  uint16_t csum = udpHdr.csum != 0 ? udpHdr.csum
+                                   : udpHdr.computeChecksum(ipHdr, payloadStart);
   csumCursor.writeBE<uint16_t>(csum);
 
   VLOG (4) << " Sent dhcp packet :"
@@ -107,6 +113,42 @@ void sendDHCPPacket(SwSwitch* sw, const EthHdr& ethHdr, const IPv4Hdr& ipHdr,
   sw->sendPacketSwitched(std::move(txPacket));
 }
 
+/*
+ * RFC 1624 incremental update of the relayed packet's UDP checksum.
+ *
+ * The relay only rewrites the IP addresses, ports, length, hops, giaddr
+ * and the option list, so fold just those words into the received
+ * checksum instead of re-checksumming the whole payload. If the
+ * received packet carried no checksum there is nothing to patch, and
+ * sendDHCPPacket() computes one from scratch.
+ */
+void patchRelayedPktChecksum(const IPv4Hdr& origIPHdr,
+    const UDPHeader& origUDPHdr, const IPv4Hdr& ipHdr, UDPHeader& udpHdr,
+    const DHCPv4Packet& origPkt, const DHCPv4Packet& pkt) {
+  if (origUDPHdr.csum == 0) {
+    return;
+  }
+  udpHdr.csum = origUDPHdr.csum;
+  // Pseudo-header: addresses, plus the UDP length which is covered both
+  // there and in the UDP header itself.
+  udpHdr.patchChecksum(origIPHdr.srcAddr, ipHdr.srcAddr);
+  udpHdr.patchChecksum(origIPHdr.dstAddr, ipHdr.dstAddr);
+  udpHdr.patchChecksum(origUDPHdr.length, udpHdr.length);
+  udpHdr.patchChecksum(origUDPHdr.length, udpHdr.length);
+  udpHdr.patchChecksum(origUDPHdr.srcPort, udpHdr.srcPort);
+  udpHdr.patchChecksum(origUDPHdr.dstPort, udpHdr.dstPort);
+  // hops shares a 16-bit word with hlen in the fixed BOOTP header
+  udpHdr.patchChecksum(
+      static_cast<uint16_t>((origPkt.hlen << 8) | origPkt.hops),
+      static_cast<uint16_t>((pkt.hlen << 8) | pkt.hops));
+  udpHdr.patchChecksum(origPkt.giaddr, pkt.giaddr);
+  // The option list starts at an even offset (the fixed header and
+  // cookie are 240 bytes), so the rewritten list patches as one block.
+  udpHdr.patchChecksumPartial(
+      PktUtil::checksumFast(origPkt.options.data(), origPkt.options.size()),
+      PktUtil::checksumFast(pkt.options.data(), pkt.options.size()));
+}
+
 int processOption(const DHCPv4Packet::Options& optionsIn, int optIndex,
     DHCPv4Packet& dhcpPacketOut, bool toAppend) {
 
@@ -149,7 +191,9 @@ void DHCPv4Handler::handlePacket(SwSwitch* sw, std::unique_ptr<RxPacket> pkt,
     return;
   }
 
-  // Parse dhcp packet
+  // Parse dhcp packet. This copies the payload out of the rx buffer into
+  // the DHCPv4Packet, count it against the zero-copy rx pipeline.
+  sw->stats()->rxPktCopied(cursor.totalLength());
   DHCPv4Packet dhcpPkt;
   try {
     dhcpPkt.parse(&cursor);
@@ -161,11 +205,11 @@ void DHCPv4Handler::handlePacket(SwSwitch* sw, std::unique_ptr<RxPacket> pkt,
     switch(dhcpPkt.op) {
       case BOOTREQUEST:
         VLOG(4) << " Got boot request ";
-        processRequest(sw, std::move(pkt), srcMac, ipHdr, dhcpPkt);
+        processRequest(sw, std::move(pkt), srcMac, ipHdr, udpHdr, dhcpPkt);
         break;
       case BOOTREPLY:
         VLOG(4) << " Got boot reply";
-        processReply(sw, std::move(pkt), ipHdr, dhcpPkt);
+        processReply(sw, std::move(pkt), ipHdr, udpHdr, dhcpPkt);
         break;
       default:
         VLOG(4)<<" Unknown DHCP Packet type "<<(uint)dhcpPkt.op;
@@ -183,44 +227,36 @@ void DHCPv4Handler::handlePacket(SwSwitch* sw, std::unique_ptr<RxPacket> pkt,
 
 
 void DHCPv4Handler::processRequest(SwSwitch* sw, std::unique_ptr<RxPacket> pkt,
-    MacAddress srcMac, const IPv4Hdr& origIPHdr,
+    MacAddress srcMac, const IPv4Hdr& origIPHdr, const UDPHeader& origUDPHdr,
     const DHCPv4Packet& dhcpPacket) {
   auto dhcpPacketOut(dhcpPacket);
-  auto vlan = sw->getState()->getVlans()->getVlanIf(pkt->getSrcVlan());
-  if (!vlan) {
+  // One table index resolves the relay, overrides and SVI address,
+  // instead of walking the published VLAN and interface maps per packet
+  auto relayEntry = sw->getDhcpRelayTable()->getEntry(pkt->getSrcVlan());
+  if (!relayEntry) {
     sw->stats()->dhcpV4DropPkt();
     VLOG(4) << " VLAN  "<< pkt->getSrcVlan() << " is no longer present "
       << " dropped dhcp packet received on a port in this VLAN";
     return;
   }
-  auto dhcpServer = vlan->getDhcpV4Relay();
+  auto dhcpServer = relayEntry->relay;
 
   VLOG(4) << "srcMac: " << srcMac.toString();
   // look in the override map, and use relevant destination
-  auto dhcpOverrideMap = vlan->getDhcpV4RelayOverrides();
-  if (dhcpOverrideMap.find(srcMac) != dhcpOverrideMap.end()) {
-    dhcpServer = dhcpOverrideMap[srcMac];
+  auto overrideItr = relayEntry->overrides.find(srcMac);
+  if (overrideItr != relayEntry->overrides.end()) {
+    dhcpServer = overrideItr->second;
     VLOG(4) << "dhcpServer: " << dhcpServer;
   }
 
   if (dhcpServer.isZero()) {
     sw->stats()->dhcpV4DropPkt();
-    VLOG(4) << " No relay configured for VLAN : "<< vlan->getID()
+    VLOG(4) << " No relay configured for VLAN : "<< pkt->getSrcVlan()
       << " dropped dhcp packet ";
     return;
   }
 
-  IPAddressV4 switchIp;
-  auto vlanInterface = sw->getState()->getInterfaces()->getInterfaceInVlanIf(
-      pkt->getSrcVlan());
-  auto& addresses = vlanInterface->getAddresses();
-  for (auto address: addresses) {
-    if (address.first.isV4()) {
-      switchIp = address.first.asV4();
-      break;
-    }
-  }
-
+  IPAddressV4 switchIp = relayEntry->switchIp;
   if (switchIp.isZero()) {
     sw->stats()->dhcpV4DropPkt();
     LOG(ERROR) << "Could not find a SVI interface on vlan : "
@@ -259,12 +295,22 @@ void DHCPv4Handler::processRequest(SwSwitch* sw, std::unique_ptr<RxPacket> pkt,
       IPv4Hdr::minSize() + UDPHeader::size() + dhcpPacketOut.size());
   UDPHeader udpHdr(kBootPSPort, kBootPSPort,
       UDPHeader::size() + dhcpPacketOut.size());
+  patchRelayedPktChecksum(origIPHdr, origUDPHdr, ipHdr, udpHdr,
+      dhcpPacket, dhcpPacketOut);
+  // Remember where this transaction came from, so the reply can go
+  // straight to building the outgoing frame instead of deriving the
+  // client VLAN from the switch state.
+  auto clientMac = MacAddress::fromBinary(
+      folly::ByteRange(dhcpPacket.chaddr.data(), MacAddress::SIZE));
+  sw->getDhcpTransactionCache()->recordRequest(dhcpPacket.xid.toLong(),
+      clientMac, pkt->getSrcVlan(), pkt->getSrcPort());
   // Send packet
   sendDHCPPacket(sw, ethHdr, ipHdr, udpHdr, dhcpPacketOut);
 }
 
 void DHCPv4Handler::processReply(SwSwitch* sw, std::unique_ptr<RxPacket> pkt,
-      const IPv4Hdr& origIPHdr, const DHCPv4Packet& dhcpPacket) {
+      const IPv4Hdr& origIPHdr, const UDPHeader& origUDPHdr,
+      const DHCPv4Packet& dhcpPacket) {
   auto dhcpPacketOut(dhcpPacket);
   if (!stripAgentOptions(sw, pkt->getSrcPort(), dhcpPacket, dhcpPacketOut)) {
     sw->stats()->port(pkt->getSrcPort())->dhcpV4BadPkt();
@@ -287,24 +333,41 @@ void DHCPv4Handler::processReply(SwSwitch* sw, std::unique_ptr<RxPacket> pkt,
   // Clear out the relay address field
   dhcpPacketOut.giaddr = IPAddressV4();
 
-  // TODO we should add router id information to the packet
-  // to get the VRF of the interface that this packet came
-  // in on. Assuming 0 for now since we have only one VRF
-  auto intf = sw->getState()->getInterfaces()->getInterface(RouterID(0),
-      IPAddress(switchIp));
-  if (!intf) {
-    sw->stats()->port(pkt->getSrcPort())->dhcpV4DropPkt();
-    LOG (INFO) << "Could not lookup interface for : " << switchIp
-      << "DHCP packet dropped ";
-    return;
+  // Fast path: if we relayed the request, the transaction cache
+  // remembers the client's VLAN, and the reply can go straight to
+  // building the frame.
+  VlanID clientVlan(0);
+  auto txn = sw->getDhcpTransactionCache()->lookup(dhcpPacket.xid.toLong(),
+      dstMac);
+  if (txn) {
+    clientVlan = txn->vlan;
+  } else {
+    // We did not relay this transaction (or its cache entry was
+    // evicted), so derive the client VLAN from the interface the
+    // server addressed.
+    //
+    // TODO we should add router id information to the packet
+    // to get the VRF of the interface that this packet came
+    // in on. Assuming 0 for now since we have only one VRF
+    auto intf = sw->getState()->getInterfaces()->getInterface(RouterID(0),
+        IPAddress(switchIp));
+    if (!intf) {
+      sw->stats()->port(pkt->getSrcPort())->dhcpV4DropPkt();
+      LOG (INFO) << "Could not lookup interface for : " << switchIp
+        << "DHCP packet dropped ";
+      return;
+    }
+    clientVlan = intf->getVlanID();
   }
 
   // Prepare the packet to be sent out
-  EthHdr ethHdr = makeEthHdr(cpuMac, dstMac, intf->getVlanID());
+  EthHdr ethHdr = makeEthHdr(cpuMac, dstMac, clientVlan);
   auto ipHdr = makeIpv4Header(switchIp, clientIP, origIPHdr.ttl - 1,
       IPv4Hdr::minSize() + UDPHeader::size() + dhcpPacketOut.size());
   UDPHeader udpHdr(kBootPSPort, kBootPCPort,
       UDPHeader::size() + dhcpPacketOut.size());
+  patchRelayedPktChecksum(origIPHdr, origUDPHdr, ipHdr, udpHdr,
+      dhcpPacket, dhcpPacketOut);
 
   sendDHCPPacket(sw, ethHdr, ipHdr, udpHdr, dhcpPacketOut);
 }
@@ -319,15 +382,13 @@ bool DHCPv4Handler::addAgentOptions(SwSwitch* sw, PortID port,
   bool isDHCP = false;
   bool done = false;
   uint16_t maxMsgSize = 0;
+  dhcpPacketIn.getOptionUint16(DHCP_MAX_MESSAGE_SIZE, maxMsgSize);
   while (optIndex < optionsIn.size() && !done) {
     bool appendOption = true;
     switch(optionsIn[optIndex]) {
       case DHCP_MESSAGE_TYPE:
         isDHCP = true;
         break;
-      case DHCP_MAX_MESSAGE_SIZE:
-        maxMsgSize = ntohs(optionsIn[optIndex + 2]);
-        break;
       case DHCP_AGENT_OPTIONS:
         if (isDHCP) {
           // FIXME We should really forward this along unchanged.
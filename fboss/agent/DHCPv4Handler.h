@@ -45,9 +45,10 @@ class DHCPv4Handler {
  private:
   static void processRequest(SwSwitch* sw, std::unique_ptr<RxPacket> pkt,
       folly::MacAddress srcMac, const IPv4Hdr& ipHdr,
-      const DHCPv4Packet& dhcpPacket);
+      const UDPHeader& udpHdr, const DHCPv4Packet& dhcpPacket);
   static void processReply(SwSwitch* sw, std::unique_ptr<RxPacket> pkt,
-      const IPv4Hdr& ipHdr, const DHCPv4Packet& dhcpPacket);
+      const IPv4Hdr& ipHdr, const UDPHeader& udpHdr,
+      const DHCPv4Packet& dhcpPacket);
   static bool addAgentOptions(SwSwitch* sw, PortID port,
       folly::IPAddressV4 relayAddr,
       const DHCPv4Packet& dhcpPacketIn, DHCPv4Packet& dhcpPacketOut);
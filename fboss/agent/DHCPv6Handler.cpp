@@ -14,6 +14,7 @@
 #include <folly/io/Cursor.h>
 #include <folly/IPAddressV6.h>
 #include "FbossError.h"
+#include "fboss/agent/DhcpRelayTable.h"
 #include "fboss/agent/packet/DHCPv6Packet.h"
 #include "fboss/agent/packet/IPv6Hdr.h"
 #include "fboss/agent/packet/IPProto.h"
@@ -22,8 +23,6 @@
 #include "fboss/agent/state/Interface.h"
 #include "fboss/agent/state/InterfaceMap.h"
 #include "fboss/agent/state/SwitchState.h"
-#include "fboss/agent/state/Vlan.h"
-#include "fboss/agent/state/VlanMap.h"
 #include "fboss/agent/Platform.h"
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/SwSwitch.h"
@@ -114,7 +113,9 @@ void DHCPv6Handler::handlePacket(SwSwitch* sw, std::unique_ptr<RxPacket> pkt,
     MacAddress srcMac, MacAddress dstMac, const IPv6Hdr& ipHdr,
     const UDPHeader& udpHdr, Cursor cursor) {
   sw->stats()->port(pkt->getSrcPort())->dhcpV6Pkt();
-  // Parse dhcp packet
+  // Parse dhcp packet. This copies the payload out of the rx buffer into
+  // the DHCPv6Packet, count it against the zero-copy rx pipeline.
+  sw->stats()->rxPktCopied(cursor.totalLength());
   DHCPv6Packet dhcp6Pkt;
   try {
     dhcp6Pkt.parse(&cursor);
@@ -140,42 +141,55 @@ void DHCPv6Handler::processDHCPv6Packet(SwSwitch* sw,
     std::unique_ptr<RxPacket> pkt, MacAddress srcMac, MacAddress dstMac,
     const IPv6Hdr& ipHdr, const DHCPv6Packet& dhcpPacket) {
   auto vlanId = pkt->getSrcVlan();
-  auto states = sw->getState();
-  auto vlan = states->getVlans()->getVlanIf(vlanId);
-  if (!vlan) {
+  // One table index resolves the relay, overrides and SVI address,
+  // instead of walking the published VLAN and interface maps per packet
+  auto* relayTable = sw->getDhcpRelayTable();
+  auto relayEntry = relayTable->getEntry(vlanId);
+  if (!relayEntry) {
     sw->stats()->dhcpV6DropPkt();
+    relayTable->countV6RelayDrop(vlanId);
     VLOG(2) << "VLAN " << vlanId << " is no longer present"
             << "DHCPv6Packet dropped.";
     return;
   }
 
-  auto dhcp6ServerIp = vlan->getDhcpV6Relay();
+  auto dhcp6ServerIp = relayEntry->relay6;
 
   // look in the override map, and use relevant destination
   VLOG(4) << "srcMac: " << srcMac.toString();
-  auto dhcpOverrideMap = vlan->getDhcpV6RelayOverrides();
-  for (auto o : dhcpOverrideMap) {
-    if (MacAddress(o.first) == srcMac) {
-      dhcp6ServerIp = o.second;
-      VLOG(4) << "dhcp6ServerIp: " << dhcp6ServerIp;
-      break;
-    }
+  auto overrideItr = relayEntry->overrides6.find(srcMac);
+  if (overrideItr != relayEntry->overrides6.end()) {
+    dhcp6ServerIp = overrideItr->second;
+    VLOG(4) << "dhcp6ServerIp: " << dhcp6ServerIp;
   }
 
   if (dhcp6ServerIp.isZero()) {
-    VLOG(4) << "No DHCPv6 relay configured for Vlan " << vlan->getID()
+    VLOG(4) << "No DHCPv6 relay configured for Vlan " << vlanId
             << " dropped DHCPv6 packet";
     sw->stats()->dhcpV6DropPkt();
+    relayTable->countV6RelayDrop(vlanId);
+    return;
+  }
+
+  IPAddressV6 switchIp = relayEntry->switchIp6;
+  if (switchIp.isZero()) {
+    sw->stats()->dhcpV6DropPkt();
+    relayTable->countV6RelayDrop(vlanId);
+    VLOG(2) << "Could not find a SVI interface on vlan " << vlanId
+            << " DHCPv6 packet dropped";
     return;
   }
 
-  IPAddressV6 switchIp = getSwitchVlanIPv6(states, vlanId);
   // link address set to unspecified
   IPAddressV6 la("::");
   // ip src -> peer-address
   IPAddressV6 pa = ipHdr.srcAddr;
   DHCPv6Packet relayFwdPkt(DHCPv6_RELAY_FORWARD, 0, la, pa);
 
+  // Reserve the options buffer once; both options below then append
+  // into pre-allocated storage instead of growing it per option
+  relayFwdPkt.reserveOptions(4 + MacAddress::SIZE +
+                             4 + dhcpPacket.computePacketLength());
   // use the client src mac address as the interface id
   relayFwdPkt.addInterfaceIDOption(srcMac);
   // add relay message option
@@ -0,0 +1,96 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/DhcpRelayTable.h"
+
+#include "fboss/agent/state/Interface.h"
+#include "fboss/agent/state/InterfaceMap.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+
+namespace facebook { namespace fboss {
+
+DhcpRelayTable::DhcpRelayTable(SwSwitch* sw)
+    : AutoRegisterStateObserver(sw, "DhcpRelayTable",
+                                INTEREST_VLANS | INTEREST_INTERFACES) {}
+
+DhcpRelayTable::~DhcpRelayTable() {}
+
+void DhcpRelayTable::stateUpdated(const StateDelta& delta) {
+  // We are only notified when the VLAN or interface sections changed,
+  // and those change rarely; a full rebuild keeps the table trivially
+  // consistent with the published state.
+  rebuildTable(delta.newState());
+}
+
+void DhcpRelayTable::rebuildTable(const std::shared_ptr<SwitchState>& state) {
+  auto table = std::make_shared<Table>();
+  for (const auto& vlan : *state->getVlans()) {
+    auto id = static_cast<size_t>(vlan->getID());
+    if (id >= kMaxVlans) {
+      continue;
+    }
+    auto& entry = (*table)[id];
+    entry.relay = vlan->getDhcpV4Relay();
+    for (const auto& relayOverride : vlan->getDhcpV4RelayOverrides()) {
+      entry.overrides.emplace(relayOverride.first, relayOverride.second);
+    }
+    entry.relay6 = vlan->getDhcpV6Relay();
+    for (const auto& relayOverride : vlan->getDhcpV6RelayOverrides()) {
+      entry.overrides6.emplace(relayOverride.first, relayOverride.second);
+    }
+    auto intf = state->getInterfaces()->getInterfaceInVlanIf(vlan->getID());
+    if (intf) {
+      for (const auto& address : intf->getAddresses()) {
+        if (address.first.isV4() && entry.switchIp.isZero()) {
+          entry.switchIp = address.first.asV4();
+        } else if (address.first.isV6() && entry.switchIp6.isZero()) {
+          entry.switchIp6 = address.first.asV6();
+        }
+      }
+    }
+    entry.valid = true;
+  }
+  folly::SpinLockGuard guard(lock_);
+  table_.swap(table);
+}
+
+std::shared_ptr<const DhcpRelayTable::RelayEntry> DhcpRelayTable::getEntry(
+    VlanID vlan) const {
+  std::shared_ptr<const Table> table;
+  {
+    folly::SpinLockGuard guard(lock_);
+    table = table_;
+  }
+  auto id = static_cast<size_t>(vlan);
+  if (!table || id >= kMaxVlans || !(*table)[id].valid) {
+    return nullptr;
+  }
+  // Aliasing constructor: the entry pins the whole table
+  return std::shared_ptr<const RelayEntry>(table, &(*table)[id]);
+}
+
+void DhcpRelayTable::countV6RelayDrop(VlanID vlan) {
+  auto id = static_cast<size_t>(vlan);
+  if (id < kMaxVlans) {
+    v6RelayDrops_[id].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+uint64_t DhcpRelayTable::getV6RelayDrops(VlanID vlan) const {
+  auto id = static_cast<size_t>(vlan);
+  if (id >= kMaxVlans) {
+    return 0;
+  }
+  return v6RelayDrops_[id].load(std::memory_order_relaxed);
+}
+
+}} // facebook::fboss
@@ -0,0 +1,93 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+#include <folly/IPAddressV4.h>
+#include <folly/IPAddressV6.h>
+#include <folly/MacAddress.h>
+#include <folly/SpinLock.h>
+
+#include "fboss/agent/StateObserver.h"
+#include "fboss/agent/types.h"
+
+namespace facebook { namespace fboss {
+
+class SwitchState;
+
+/*
+ * DhcpRelayTable maintains a derived, flat table of per-VLAN DHCPv4
+ * and DHCPv6 relay configuration, rebuilt whenever the VLAN or
+ * interface sections of the switch state change.
+ *
+ * The per-packet relay decision in DHCPv4Handler used to walk the
+ * published VlanMap and InterfaceMap; under a lease-renewal wave that
+ * walk ran for every trapped DHCP packet. With this table the decision
+ * is a single array index by VlanID, with the relay address, the
+ * per-client-MAC override map (re-hashed for O(1) probes) and the
+ * VLAN's SVI address all pre-resolved at state publish time.
+ */
+class DhcpRelayTable : public AutoRegisterStateObserver {
+ public:
+  struct RelayEntry {
+    // Configured DHCPv4 relay for the VLAN; isZero() if none
+    folly::IPAddressV4 relay;
+    // First V4 address of the VLAN's interface; isZero() if none
+    folly::IPAddressV4 switchIp;
+    // Per client MAC relay overrides
+    std::unordered_map<folly::MacAddress, folly::IPAddressV4> overrides;
+    // Configured DHCPv6 relay for the VLAN; isZero() if none
+    folly::IPAddressV6 relay6;
+    // First V6 address of the VLAN's interface; isZero() if none
+    folly::IPAddressV6 switchIp6;
+    // Per client MAC DHCPv6 relay overrides
+    std::unordered_map<folly::MacAddress, folly::IPAddressV6> overrides6;
+    bool valid{false};
+  };
+
+  explicit DhcpRelayTable(SwSwitch* sw);
+  ~DhcpRelayTable() override;
+
+  void stateUpdated(const StateDelta& delta) override;
+
+  /*
+   * Look up the relay entry for a VLAN. Returns null if the VLAN is not
+   * present in the current state. The returned pointer keeps the
+   * underlying table alive, so it remains valid across state updates.
+   */
+  std::shared_ptr<const RelayEntry> getEntry(VlanID vlan) const;
+
+  /*
+   * Per-VLAN DHCPv6 relay drop accounting. The counters live outside
+   * the rebuilt table, so they survive state updates.
+   */
+  void countV6RelayDrop(VlanID vlan);
+  uint64_t getV6RelayDrops(VlanID vlan) const;
+
+ private:
+  enum : size_t { kMaxVlans = 4096 };
+  typedef std::array<RelayEntry, kMaxVlans> Table;
+
+  // Forbidden copy constructor and assignment operator
+  DhcpRelayTable(const DhcpRelayTable&) = delete;
+  DhcpRelayTable& operator=(const DhcpRelayTable&) = delete;
+
+  void rebuildTable(const std::shared_ptr<SwitchState>& state);
+
+  std::shared_ptr<const Table> table_;
+  mutable folly::SpinLock lock_;
+  std::array<std::atomic<uint64_t>, kMaxVlans> v6RelayDrops_{};
+};
+
+}} // facebook::fboss
@@ -0,0 +1,38 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/DhcpTransactionCache.h"
+
+namespace facebook { namespace fboss {
+
+void DhcpTransactionCache::recordRequest(uint32_t xid,
+                                         folly::MacAddress clientMac,
+                                         VlanID vlan,
+                                         PortID port) {
+  auto& entry = entries_[slotForXid(xid)];
+  folly::SpinLockGuard guard(lock_);
+  entry.xid = xid;
+  entry.clientMac = clientMac;
+  entry.txn.vlan = vlan;
+  entry.txn.port = port;
+  entry.valid = true;
+}
+
+folly::Optional<DhcpTransactionCache::Transaction>
+DhcpTransactionCache::lookup(uint32_t xid,
+                             folly::MacAddress clientMac) const {
+  const auto& entry = entries_[slotForXid(xid)];
+  folly::SpinLockGuard guard(lock_);
+  if (!entry.valid || entry.xid != xid || entry.clientMac != clientMac) {
+    return folly::none;
+  }
+  return entry.txn;
+}
+
+}} // facebook::fboss
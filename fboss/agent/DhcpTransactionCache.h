@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <folly/MacAddress.h>
+#include <folly/Optional.h>
+#include <folly/SpinLock.h>
+
+#include "fboss/agent/types.h"
+
+namespace facebook { namespace fboss {
+
+/*
+ * DhcpTransactionCache remembers which VLAN and port a relayed DHCPv4
+ * request came from, keyed by the transaction ID.
+ *
+ * When the server's reply comes back, the relay needs the client's
+ * VLAN to build the outgoing frame.  The reply path used to derive it
+ * by looking the relay address up in the published interface map for
+ * every reply; with the cache a reply is a single probe instead, with
+ * the map lookup kept as the fallback on a miss.
+ *
+ * The table is a fixed-size, direct-mapped cache: inserting over a
+ * colliding slot simply evicts it, which bounds the memory and makes
+ * both operations O(1) with no allocation.  An evicted or stale entry
+ * is harmless -- the reply just takes the fallback path.  Entries are
+ * verified against the client MAC as well as the transaction ID, so a
+ * reply can never match a different client's transaction.  Entries
+ * are not removed on a hit, since one transaction sees two replies
+ * (OFFER and ACK) under the same ID.
+ */
+class DhcpTransactionCache {
+ public:
+  struct Transaction {
+    VlanID vlan{0};
+    PortID port{0};
+  };
+
+  DhcpTransactionCache() {}
+
+  /*
+   * Record the origin of a relayed request.
+   */
+  void recordRequest(uint32_t xid,
+                     folly::MacAddress clientMac,
+                     VlanID vlan,
+                     PortID port);
+
+  /*
+   * Look up the transaction a reply belongs to.
+   *
+   * Returns none if we did not relay a matching request (or its entry
+   * was evicted); the caller should fall back to deriving the VLAN
+   * from the switch state.
+   */
+  folly::Optional<Transaction> lookup(uint32_t xid,
+                                      folly::MacAddress clientMac) const;
+
+ private:
+  // Must be a power of two
+  enum : uint32_t { kNumEntries = 1024 };
+
+  struct Entry {
+    uint32_t xid{0};
+    folly::MacAddress clientMac;
+    Transaction txn;
+    bool valid{false};
+  };
+
+  // Forbidden copy constructor and assignment operator
+  DhcpTransactionCache(DhcpTransactionCache const &) = delete;
+  DhcpTransactionCache& operator=(DhcpTransactionCache const &) = delete;
+
+  static uint32_t slotForXid(uint32_t xid) {
+    // Clients typically use sequential transaction IDs, so mix the
+    // bits before taking the low ones.
+    return (xid * 2654435761u) & (kNumEntries - 1);
+  }
+
+  mutable folly::SpinLock lock_;
+  std::array<Entry, kNumEntries> entries_;
+};
+
+}} // facebook::fboss
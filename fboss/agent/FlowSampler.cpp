@@ -0,0 +1,174 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/FlowSampler.h"
+
+#include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/RxPacket.h"
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/SwitchStats.h"
+#include "fboss/agent/if/gen-cpp2/ctrl_types.h"
+
+#include <folly/Hash.h>
+#include <folly/io/Cursor.h>
+
+using folly::io::Cursor;
+
+DEFINE_int32(max_sampled_flows, 8192,
+             "Maximum number of concurrent flows tracked by the flow "
+             "sampler; samples for new flows beyond this are dropped");
+
+namespace {
+
+enum : uint16_t {
+  ETHERTYPE_VLAN = 0x8100,
+  ETHERTYPE_IPV4 = 0x0800,
+  ETHERTYPE_IPV6 = 0x86dd,
+};
+enum : uint8_t {
+  IP_PROTO_TCP = 6,
+  IP_PROTO_UDP = 17,
+};
+
+inline int64_t toMsecSinceEpoch(std::chrono::system_clock::time_point tp) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      tp.time_since_epoch()).count();
+}
+
+}
+
+namespace facebook { namespace fboss {
+
+FlowSampler::FlowSampler(SwSwitch* sw)
+  : sw_(sw) {
+}
+
+size_t FlowSampler::FlowKeyHash::operator()(const FlowKey& key) const {
+  return folly::hash::hash_combine(
+      std::hash<folly::IPAddress>()(key.srcIp),
+      std::hash<folly::IPAddress>()(key.dstIp),
+      key.srcL4Port, key.dstL4Port,
+      key.ingressPort, key.vlan, key.proto);
+}
+
+bool FlowSampler::extractFlowKey(const RxPacket* pkt, FlowKey* key) {
+  key->ingressPort = pkt->getSrcPort();
+  key->vlan = pkt->getSrcVlan();
+
+  Cursor cursor(pkt->buf());
+  try {
+    uint16_t etherType;
+    auto l3Offset = pkt->getL3HdrOffset();
+    if (l3Offset >= sizeof(uint16_t)) {
+      // handlePacket already annotated where L3 starts; the ethertype
+      // is the last two bytes of the L2 header.
+      cursor.skip(l3Offset - sizeof(uint16_t));
+      etherType = cursor.readBE<uint16_t>();
+    } else {
+      cursor.skip(12); // dst + src MAC
+      etherType = cursor.readBE<uint16_t>();
+      while (etherType == ETHERTYPE_VLAN) {
+        cursor.skip(2);
+        etherType = cursor.readBE<uint16_t>();
+      }
+    }
+
+    uint8_t addr[16];
+    if (etherType == ETHERTYPE_IPV4) {
+      auto versionAndIHL = cursor.read<uint8_t>();
+      auto ihl = (versionAndIHL & 0x0f) * 4;
+      if (ihl < 20) {
+        return false;
+      }
+      cursor.skip(8); // to the protocol field
+      key->proto = cursor.read<uint8_t>();
+      cursor.skip(2); // checksum
+      cursor.pull(addr, 4);
+      key->srcIp = folly::IPAddress::fromBinary(folly::ByteRange(addr, 4));
+      cursor.pull(addr, 4);
+      key->dstIp = folly::IPAddress::fromBinary(folly::ByteRange(addr, 4));
+      cursor.skip(ihl - 20); // IPv4 options, if any
+    } else if (etherType == ETHERTYPE_IPV6) {
+      cursor.skip(6); // version/class/flow label, payload length
+      key->proto = cursor.read<uint8_t>();
+      cursor.skip(1); // hop limit
+      cursor.pull(addr, 16);
+      key->srcIp = folly::IPAddress::fromBinary(folly::ByteRange(addr, 16));
+      cursor.pull(addr, 16);
+      key->dstIp = folly::IPAddress::fromBinary(folly::ByteRange(addr, 16));
+    } else {
+      return false;
+    }
+
+    if (key->proto == IP_PROTO_TCP || key->proto == IP_PROTO_UDP) {
+      key->srcL4Port = cursor.readBE<uint16_t>();
+      key->dstL4Port = cursor.readBE<uint16_t>();
+    }
+  } catch (const std::out_of_range&) {
+    // Truncated sample. If we got as far as the addresses the flow is
+    // still attributable; without them there is nothing to aggregate.
+    if (key->srcIp.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void FlowSampler::sampledPacketReceived(const RxPacket* pkt) {
+  FlowKey key;
+  if (!extractFlowKey(pkt, &key)) {
+    sw_->stats()->flowSampleDropped();
+    return;
+  }
+
+  auto now = std::chrono::system_clock::now();
+  std::lock_guard<std::mutex> g(mutex_);
+  auto it = flows_.find(key);
+  if (it == flows_.end()) {
+    if (flows_.size() >= static_cast<size_t>(FLAGS_max_sampled_flows)) {
+      // The cache is full; keep accounting existing flows but drop
+      // samples for new ones rather than growing without bound.
+      sw_->stats()->flowSampleDropped();
+      return;
+    }
+    it = flows_.emplace(std::move(key), FlowEntry()).first;
+    it->second.firstSeen = now;
+  }
+  auto& entry = it->second;
+  entry.packets += 1;
+  entry.bytes += pkt->getLength();
+  entry.lastSeen = now;
+  sw_->stats()->flowSample();
+}
+
+void FlowSampler::exportFlows(std::vector<SampledFlow>* flows,
+                              bool clearFlows) {
+  std::lock_guard<std::mutex> g(mutex_);
+  flows->reserve(flows->size() + flows_.size());
+  for (const auto& kv : flows_) {
+    SampledFlow flow;
+    flow.srcIp = network::toBinaryAddress(kv.first.srcIp);
+    flow.dstIp = network::toBinaryAddress(kv.first.dstIp);
+    flow.ipProtocol = kv.first.proto;
+    flow.srcL4Port = kv.first.srcL4Port;
+    flow.dstL4Port = kv.first.dstL4Port;
+    flow.ingressPort = kv.first.ingressPort;
+    flow.vlan = kv.first.vlan;
+    flow.packets = kv.second.packets;
+    flow.bytes = kv.second.bytes;
+    flow.firstSeenMsec = toMsecSinceEpoch(kv.second.firstSeen);
+    flow.lastSeenMsec = toMsecSinceEpoch(kv.second.lastSeen);
+    flows->push_back(std::move(flow));
+  }
+  if (clearFlows) {
+    flows_.clear();
+  }
+}
+
+}} // facebook::fboss
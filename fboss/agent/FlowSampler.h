@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/agent/types.h"
+
+#include <folly/IPAddress.h>
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+class RxPacket;
+class SampledFlow;
+class SwSwitch;
+
+/*
+ * FlowSampler aggregates hardware-sampled packets into flow records.
+ *
+ * Ports configured with an ingress sample rate (--sflow_sample_rate)
+ * copy one of every N forwarded packets to the CPU with the sample rx
+ * reason set. SwSwitch::handlePacket diverts those copies here instead
+ * of running them through the protocol handlers: a lightweight
+ * extractor pulls the 5-tuple (plus ingress port and vlan) out of the
+ * already-annotated headers and bumps the matching entry in a bounded
+ * flow cache. Collectors drain the cache periodically through the
+ * getSampledFlows() thrift call.
+ *
+ * The sample path is a hash lookup and a couple of counter increments
+ * under a mutex that the export path takes only briefly, so the sampler
+ * comfortably absorbs tens of thousands of samples per second without
+ * feeding back into the protocol packet queues.
+ */
+class FlowSampler {
+ public:
+  explicit FlowSampler(SwSwitch* sw);
+
+  /*
+   * Account one sampled packet. Called from the packet handling
+   * threads; packets whose headers we cannot parse are counted and
+   * dropped.
+   */
+  void sampledPacketReceived(const RxPacket* pkt);
+
+  /*
+   * Export the current flow records, converted to thrift. When
+   * clearFlows is set the cache is reset afterwards, so a periodic
+   * poller sees each flow's activity exactly once.
+   */
+  void exportFlows(std::vector<SampledFlow>* flows, bool clearFlows);
+
+ private:
+  struct FlowKey {
+    folly::IPAddress srcIp;
+    folly::IPAddress dstIp;
+    uint16_t srcL4Port{0};
+    uint16_t dstL4Port{0};
+    uint16_t ingressPort{0};
+    uint16_t vlan{0};
+    uint8_t proto{0};
+
+    bool operator==(const FlowKey& other) const {
+      return proto == other.proto &&
+        srcL4Port == other.srcL4Port &&
+        dstL4Port == other.dstL4Port &&
+        ingressPort == other.ingressPort &&
+        vlan == other.vlan &&
+        srcIp == other.srcIp &&
+        dstIp == other.dstIp;
+    }
+  };
+  struct FlowKeyHash {
+    size_t operator()(const FlowKey& key) const;
+  };
+  struct FlowEntry {
+    uint64_t packets{0};
+    uint64_t bytes{0};
+    std::chrono::system_clock::time_point firstSeen;
+    std::chrono::system_clock::time_point lastSeen;
+  };
+
+  // Forbidden copy constructor and assignment operator
+  FlowSampler(FlowSampler const &) = delete;
+  FlowSampler& operator=(FlowSampler const &) = delete;
+
+  // Extract the flow key from a sampled packet. Returns false if the
+  // packet is not IPv4/IPv6 or is too short to parse.
+  static bool extractFlowKey(const RxPacket* pkt, FlowKey* key);
+
+  SwSwitch* sw_{nullptr};
+  std::mutex mutex_;
+  std::unordered_map<FlowKey, FlowEntry, FlowKeyHash> flows_;
+};
+
+}} // facebook::fboss
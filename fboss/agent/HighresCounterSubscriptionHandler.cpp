@@ -9,7 +9,12 @@
  */
 #include "HighresCounterSubscriptionHandler.h"
 
+#include <algorithm>
+
 #include <folly/MoveWrapper.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include "common/stats/ServiceData.h"
 
 using folly::EventBase;
 using std::make_unique;
@@ -24,8 +29,43 @@ using std::chrono::seconds;
 
 namespace facebook { namespace fboss {
 
+// fb303 counter keys for the producer-side publish instrumentation
+constexpr folly::StringPiece kPublishDropsCounter = "highres.publish.drops";
+constexpr folly::StringPiece kPublishQueueLatencyCounter =
+    "highres.publish.queue_latency_us";
+constexpr folly::StringPiece kPublishEvictionsCounter =
+    "highres.publish.evictions";
+constexpr folly::StringPiece kDecimationCounter =
+    "highres.sample.decimation";
+constexpr folly::StringPiece kDecimatedSamplesCounter =
+    "highres.sample.decimated";
+
+std::chrono::milliseconds SampleSender::finishPending(
+    high_resolution_clock::time_point enqueueTime) {
+  pendingPubs_.fetch_sub(1, std::memory_order_acq_rel);
+  auto latency = duration_cast<std::chrono::microseconds>(
+      high_resolution_clock::now() - enqueueTime);
+  fbData->setCounter(kPublishQueueLatencyCounter, latency.count());
+  return duration_cast<std::chrono::milliseconds>(latency);
+}
+
+bool SampleSender::shouldEvict(std::chrono::milliseconds queueLatency) {
+  if (queueLatency <= kMaxPublicationQueueLatency) {
+    return false;
+  }
+  ++evictedPubs_;
+  fbData->setCounter(kPublishEvictionsCounter, evictedPubs_);
+  return true;
+}
+
 // Wrapper for the actual Thrift call
-inline void SampleSender::publish(unique_ptr<CounterPublication> pub) {
+inline void SampleSender::publish(
+    unique_ptr<CounterPublication> pub,
+    high_resolution_clock::time_point enqueueTime) {
+  auto queueLatency = finishPending(enqueueTime);
+  if (shouldEvict(queueLatency)) {
+    return;
+  }
   if (!killSwitch_->isSet()) {
     // Note that it's okay to give the callback a shared_ptr to the client
     // without the eventBase because the actual call and callback are run in
@@ -51,6 +91,36 @@ inline void SampleSender::publish(unique_ptr<CounterPublication> pub) {
   }
 }
 
+inline void SampleSender::publishBinary(
+    unique_ptr<folly::fbstring> buf,
+    int numSamples,
+    high_resolution_clock::time_point enqueueTime) {
+  auto queueLatency = finishPending(enqueueTime);
+  if (shouldEvict(queueLatency)) {
+    return;
+  }
+  if (!killSwitch_->isSet()) {
+    auto& client = client_;
+    auto& killSwitch = killSwitch_;
+    client->publishCountersBinary(
+        [killSwitch, client](
+            apache::thrift::ClientReceiveState&& state) mutable {
+          // For oneway functions like this one, only exceptions make it here.
+          if (state.isException()) {
+            if (!killSwitch->set()) {
+              LOG(ERROR) << "Exception sending binary publication: "
+                         << folly::exceptionStr(state.exception());
+            }
+            // else, we were already dying so don't beat a dead horse
+          } else {
+            LOG(ERROR) << "There was a result to a oneway call";
+          }
+        },
+        *buf);
+    rateCalc_.finishedSamples(numSamples * numCounters_);
+  }
+}
+
 // Helper function to get the current machine's hostname
 string getLocalHostname() {
   const size_t kHostnameMaxLen = 256;  // from gethostname man page
@@ -79,6 +149,7 @@ SampleProducer::SampleProducer(unique_ptr<HighresSamplerList> samplers,
       interval_(nanoseconds(req.intervalInNs)),
       batchSize_(req.batchSize),
       sleepMethod_(req.sleepMethod),
+      binaryFraming_(req.binaryFraming),
       rateCalc_("SampleProducer"),
       numCounters_(numCounters) {
   overloadWarningCounter_ = 0;
@@ -151,13 +222,60 @@ inline void SampleProducer::buildPublication(
   }
 }
 
+void SampleProducer::increaseDecimation() {
+  decimation_ = std::min(decimation_ * 2, kMaxDecimation);
+  batchesSinceBackoff_ = 0;
+  fbData->setCounter(kDecimationCounter, decimation_);
+}
+
+void SampleProducer::maybeRelaxDecimation() {
+  if (decimation_ > 1 &&
+      ++batchesSinceBackoff_ >= kDecimationDecayBatches) {
+    decimation_ /= 2;
+    batchesSinceBackoff_ = 0;
+    fbData->setCounter(kDecimationCounter, decimation_);
+  }
+}
+
 void SampleProducer::publish(unique_ptr<CounterPublication> pub) {
+  if (!sender_->tryEnqueue()) {
+    // The event base thread has fallen behind.  Drop the batch here on
+    // the producer side rather than queueing up unboundedly; the
+    // counter lets us see how often that happens in production.  Also
+    // back off the sampling rate until the subscriber catches up.
+    ++droppedPubs_;
+    fbData->setCounter(kPublishDropsCounter, droppedPubs_);
+    increaseDecimation();
+    return;
+  }
+  maybeRelaxDecimation();
+
   auto& sender = sender_;
-  auto wrappedPub = folly::makeMoveWrapper(std::move(pub));
-  // Schedule the send in a eb thread.  We include the a shared pointer to the
-  // sender so it doesn't get destroyed too early.
-  eventBase_->runInEventBaseThread(
-      [sender, wrappedPub]() mutable { sender->publish(wrappedPub.move()); });
+  auto enqueueTime = high_resolution_clock::now();
+  if (binaryFraming_) {
+    // Serialize on the producer thread into one contiguous buffer,
+    // pre-sized from the previous batch, so the event base thread does
+    // a single write of an opaque blob instead of re-walking the
+    // publication struct.
+    auto numSamples = pub->times.size();
+    auto buf = make_unique<folly::fbstring>();
+    buf->reserve(serializedSizeHint_);
+    apache::thrift::BinarySerializer::serialize(*pub, buf.get());
+    serializedSizeHint_ = std::max(serializedSizeHint_, buf->size());
+    auto wrappedBuf = folly::makeMoveWrapper(std::move(buf));
+    eventBase_->runInEventBaseThread(
+        [sender, wrappedBuf, numSamples, enqueueTime]() mutable {
+          sender->publishBinary(wrappedBuf.move(), numSamples, enqueueTime);
+        });
+  } else {
+    auto wrappedPub = folly::makeMoveWrapper(std::move(pub));
+    // Schedule the send in a eb thread.  We include the a shared pointer to
+    // the sender so it doesn't get destroyed too early.
+    eventBase_->runInEventBaseThread(
+        [sender, wrappedPub, enqueueTime]() mutable {
+          sender->publish(wrappedPub.move(), enqueueTime);
+        });
+  }
 }
 
 void SampleProducer::produce() {
@@ -174,6 +292,15 @@ void SampleProducer::produce() {
   for (int i = 0;
        !killSwitch_->isSet() && i < maxCount_ && currentTime < timeout;
        ++i) {
+    // While the subscriber is lagging, skip all but every Nth round so
+    // the batches we do build are ones the client can actually absorb.
+    if (decimation_ > 1 && (i % decimation_) != 0) {
+      ++decimatedSamples_;
+      fbData->setCounter(kDecimatedSamplesCounter, decimatedSamples_);
+      sleepNs(&currentTime);
+      continue;
+    }
+
     buildPublication(pub.get(), currentTime);
 
     // Check if we have a full batch.  If so move it to the queue and make a new
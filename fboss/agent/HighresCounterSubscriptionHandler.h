@@ -36,6 +36,9 @@
  */
 #pragma once
 
+#include <atomic>
+#include <chrono>
+
 #include <folly/MoveWrapper.h>
 
 #include "fboss/agent/HighresCounterUtil.h"
@@ -46,6 +49,26 @@ namespace facebook { namespace fboss {
 // How often to print out load warnings
 const int kOverloadWarningEveryN = 1000;
 
+// Cap on publications handed to the event base thread but not yet
+// written out.  The slots act as per-subscription send credits:  the
+// producer takes one per batch and gets it back when the batch hits
+// the wire.  Beyond this the producer drops new batches (and counts
+// the drops) instead of queueing up unboundedly behind a slow sender.
+const int kMaxPendingPublications = 4;
+
+// Cap on how far the producer will decimate (sample every Nth round)
+// while the subscriber is lagging.
+const int kMaxDecimation = 64;
+
+// Number of batches that must be accepted at the current rate before
+// the producer relaxes decimation one step.
+const int kDecimationDecayBatches = 16;
+
+// A batch that has waited longer than this behind the event base
+// thread is too stale to be useful; the sender evicts it instead of
+// pushing it onto the wire behind an already-lagging client.
+const std::chrono::milliseconds kMaxPublicationQueueLatency(1000);
+
 /*
  * A simple, atomic flag that starts unset, but can later be set.  Wrapped in a
  * folly::Synchronized wrapper and shared_ptr, it becomes an atomic, thread-safe
@@ -95,6 +118,21 @@ class SampleSender {
         rateCalc_("SampleSender"),
         numCounters_(numCounters) {}
 
+  /*
+   * Try to reserve a slot for a publication about to be scheduled on
+   * the event base thread.  Fails when kMaxPendingPublications batches
+   * are already in flight, i.e. the event base thread has fallen
+   * behind; the caller should drop the batch rather than queue more.
+   */
+  bool tryEnqueue() {
+    if (pendingPubs_.load(std::memory_order_acquire) >=
+        kMaxPendingPublications) {
+      return false;
+    }
+    pendingPubs_.fetch_add(1, std::memory_order_acq_rel);
+    return true;
+  }
+
   /*
    * Destructor that ensures that the client is destroyed in the event base
    * thread.
@@ -114,21 +152,54 @@ class SampleSender {
    * Publish the counters back to the duplex client.  This should be called from
    * the event base thread where client_ came from.
    *
-   * @param[in]   pub    The finished publication to send. It will be destroyed
-   *                     after this function returns.
+   * @param[in]   pub          The finished publication to send. It will be
+   *                           destroyed after this function returns.
+   * @param[in]   enqueueTime  When the producer scheduled this publication,
+   *                           for the queue latency counter.
    */
-  void publish(std::unique_ptr<CounterPublication> pub);
+  void publish(std::unique_ptr<CounterPublication> pub,
+               std::chrono::high_resolution_clock::time_point enqueueTime);
+
+  /*
+   * Like publish(), but for a publication the producer already
+   * serialized into one contiguous buffer.  Sends the blob with a
+   * single publishCountersBinary call.
+   *
+   * @param[in]   buf          The Thrift binary serialized publication.
+   * @param[in]   numSamples   Number of sample rounds in the buffer, for
+   *                           rate calculations.
+   * @param[in]   enqueueTime  When the producer scheduled this publication.
+   */
+  void publishBinary(std::unique_ptr<folly::fbstring> buf,
+                     int numSamples,
+                     std::chrono::high_resolution_clock::time_point
+                         enqueueTime);
 
  private:
   // Non-copyable
   SampleSender(const SampleSender&) = delete;
   SampleSender& operator=(const SampleSender&) = delete;
 
+  // Release the in-flight slot taken by tryEnqueue() and export how
+  // long the publication sat behind the event base thread.  Returns
+  // that queue latency so callers can evict stale batches.
+  std::chrono::milliseconds finishPending(
+      std::chrono::high_resolution_clock::time_point enqueueTime);
+
+  // Returns true (and counts the eviction) if a batch with the given
+  // queue latency should be evicted rather than sent.
+  bool shouldEvict(std::chrono::milliseconds queueLatency);
+
   std::shared_ptr<FbossHighresClientAsyncClient> client_;
   std::shared_ptr<Signal> killSwitch_;
   folly::EventBase* const eventBase_;
   SharedRateCalculator rateCalc_;
   const int numCounters_;
+
+  // Publications scheduled to the event base thread but not yet sent
+  std::atomic<int> pendingPubs_{0};
+  // Stale batches evicted at the high-water mark instead of being sent
+  uint64_t evictedPubs_{0};
 };
 
 /*
@@ -192,6 +263,13 @@ class SampleProducer {
   // Schedule the SampleSender in a tm thread
   inline void publish(std::unique_ptr<CounterPublication> pub);
 
+  // Adaptive flow control:  each dropped batch doubles the decimation
+  // factor (sample only every Nth round), and a run of accepted
+  // batches relaxes it one step, so memory stays bounded at any
+  // subscriber speed while fast subscribers see full-rate data.
+  void increaseDecimation();
+  void maybeRelaxDecimation();
+
   // For the normal polling loop
   std::unique_ptr<HighresSamplerList> samplers_;
   std::shared_ptr<Signal> killSwitch_;
@@ -207,6 +285,18 @@ class SampleProducer {
   const std::chrono::nanoseconds interval_;
   const int32_t batchSize_;
   const SleepMethod sleepMethod_;
+  const bool binaryFraming_;
+
+  // Batches dropped because the event base thread fell behind
+  uint64_t droppedPubs_{0};
+  // Current decimation factor:  1 means every sample round is taken
+  int decimation_{1};
+  // Sample rounds skipped due to decimation
+  uint64_t decimatedSamples_{0};
+  // Batches accepted since decimation last changed
+  int batchesSinceBackoff_{0};
+  // Size of the last serialized batch, used to pre-size the next buffer
+  size_t serializedSizeHint_{0};
 
   // For keeping track of the rate at which we are processing updates
   SingleThreadRateCalculator rateCalc_;
@@ -0,0 +1,151 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/HighresShmExporter.h"
+
+#include <folly/Exception.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+
+DEFINE_int32(highres_shm_interval_us, 1000,
+             "Interval between shared-memory counter samples, in "
+             "microseconds");
+
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::system_clock;
+
+namespace facebook { namespace fboss {
+
+HighresShmExporter::HighresShmExporter(
+    folly::StringPiece path,
+    std::unique_ptr<HighresSamplerList> samplers,
+    int numCounters)
+  : path_(path.str()),
+    samplers_(std::move(samplers)),
+    numSlots_(numCounters) {
+  createSegment();
+}
+
+HighresShmExporter::~HighresShmExporter() {
+  stop();
+  if (header_ != nullptr) {
+    ::munmap(header_, segmentSize_);
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  // The segment file is deliberately left behind:  scrapers may still
+  // have it mapped, and a stale timestamp is their signal that the
+  // agent went away.
+}
+
+void HighresShmExporter::createSegment() {
+  segmentSize_ = sizeof(ShmCounterHeader) +
+      static_cast<size_t>(numSlots_) * sizeof(ShmCounterSlot);
+
+  fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  folly::checkUnixError(fd_, "failed to open counter segment ", path_);
+  int rc = ::ftruncate(fd_, segmentSize_);
+  folly::checkUnixError(rc, "failed to size counter segment ", path_);
+
+  void* mem = ::mmap(nullptr, segmentSize_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd_, 0);
+  if (mem == MAP_FAILED) {
+    folly::throwSystemError("failed to mmap counter segment ", path_);
+  }
+
+  header_ = static_cast<ShmCounterHeader*>(mem);
+  slots_ = reinterpret_cast<ShmCounterSlot*>(header_ + 1);
+
+  // The file was truncated to zeroes; fill in the header last so a
+  // scraper that races with us sees either no magic or a fully valid
+  // segment.
+  header_->numSlots = numSlots_;
+  header_->slotsUsed.store(0, std::memory_order_relaxed);
+  header_->version = kShmCounterVersion;
+  header_->magic = kShmCounterMagic;
+}
+
+void HighresShmExporter::start() {
+  CHECK(!running_);
+  running_ = true;
+  thread_ = std::thread([this] { loop(); });
+}
+
+void HighresShmExporter::stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+  thread_.join();
+}
+
+ShmCounterSlot* HighresShmExporter::slotFor(const CounterRequest& req) {
+  auto it = slotIndex_.find(req);
+  if (it != slotIndex_.end()) {
+    return &slots_[it->second];
+  }
+
+  auto idx = header_->slotsUsed.load(std::memory_order_relaxed);
+  if (idx >= numSlots_) {
+    LOG(ERROR) << "out of counter slots; dropping "
+               << req.namespaceName << "::" << req.counterName;
+    return nullptr;
+  }
+
+  auto slot = &slots_[idx];
+  strncpy(slot->namespaceName, req.namespaceName.c_str(),
+          kShmCounterNameLen - 1);
+  strncpy(slot->counterName, req.counterName.c_str(),
+          kShmCounterNameLen - 1);
+  // Publish the slot to scrapers only once its identity is in place.
+  header_->slotsUsed.store(idx + 1, std::memory_order_release);
+
+  slotIndex_[req] = idx;
+  return slot;
+}
+
+void HighresShmExporter::loop() {
+  while (running_.load(std::memory_order_relaxed)) {
+    CounterPublication pub;
+    for (const auto& sampler : *samplers_) {
+      sampler->sample(&pub);
+    }
+    auto now = duration_cast<nanoseconds>(
+        system_clock::now().time_since_epoch()).count();
+
+    for (const auto& entry : pub.counterValues) {
+      if (entry.second.empty()) {
+        continue;
+      }
+      auto slot = slotFor(entry.first);
+      if (slot == nullptr) {
+        continue;
+      }
+
+      // Seqlock write:  go odd, update, go even.
+      auto seq = slot->seq.load(std::memory_order_relaxed);
+      slot->seq.store(seq + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      slot->timestampNs.store(now, std::memory_order_relaxed);
+      slot->value.store(entry.second.back(), std::memory_order_relaxed);
+      slot->seq.store(seq + 2, std::memory_order_release);
+    }
+
+    usleep(FLAGS_highres_shm_interval_us);
+  }
+}
+
+}} // facebook::fboss
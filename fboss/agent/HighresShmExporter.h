@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+/*
+ * Shared-memory export for high-resolution counters.
+ *
+ * The duplex-Thrift subscription path (HighresCounterSubscriptionHandler)
+ * serializes every batch of samples, which is wasted work when the
+ * consumer is on the same box.  This exporter publishes the latest value
+ * of each counter into a fixed-layout memory-mapped file instead.  Local
+ * scrapers mmap the same file read-only and read values with no
+ * syscalls, no copies, and no coordination with the agent beyond the
+ * seqlock protocol described below.
+ *
+ * Segment layout:
+ *
+ *    ShmCounterHeader
+ *    ShmCounterSlot[numSlots]
+ *
+ * Slots are claimed in order as counters are first sampled; the header's
+ * slotsUsed field only grows.  Each slot holds its counter's identity
+ * (fixed-size strings, so the layout is position independent) and a
+ * seqlock-protected (timestamp, value) pair: the sequence number is odd
+ * while the writer is mid-update, and readers retry until they observe
+ * the same even sequence before and after reading.
+ */
+#pragma once
+
+#include <folly/Range.h>
+
+#include "fboss/agent/HighresCounterUtil.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace facebook { namespace fboss {
+
+constexpr uint32_t kShmCounterMagic = 0x48524353;  // "HRCS"
+constexpr uint32_t kShmCounterVersion = 1;
+constexpr size_t kShmCounterNameLen = 64;
+
+struct ShmCounterHeader {
+  uint32_t magic;
+  uint32_t version;
+  // Slot capacity of the segment.
+  uint32_t numSlots;
+  // Number of slots with valid identities.  Incremented with release
+  // ordering after a new slot's names are filled in, so scrapers that
+  // load it with acquire ordering never see a half-initialized slot.
+  std::atomic<uint32_t> slotsUsed;
+};
+
+struct ShmCounterSlot {
+  // Seqlock guarding timestampNs/value.
+  std::atomic<uint32_t> seq;
+  uint32_t pad;
+  // NUL-terminated counter identity, fixed at slot creation.
+  char namespaceName[kShmCounterNameLen];
+  char counterName[kShmCounterNameLen];
+  std::atomic<uint64_t> timestampNs;
+  std::atomic<int64_t> value;
+};
+
+class HighresShmExporter {
+ public:
+  HighresShmExporter(folly::StringPiece path,
+                     std::unique_ptr<HighresSamplerList> samplers,
+                     int numCounters);
+  ~HighresShmExporter();
+
+  void start();
+  void stop();
+
+  /*
+   * Reader-side helper implementing the seqlock protocol.  Returns
+   * false if the writer was mid-update and the caller should retry.
+   */
+  static bool readSlot(const ShmCounterSlot* slot,
+                       int64_t* value,
+                       uint64_t* timestampNs) {
+    auto before = slot->seq.load(std::memory_order_acquire);
+    if (before & 1) {
+      return false;
+    }
+    *value = slot->value.load(std::memory_order_relaxed);
+    *timestampNs = slot->timestampNs.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot->seq.load(std::memory_order_relaxed) == before;
+  }
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  HighresShmExporter(HighresShmExporter const &) = delete;
+  HighresShmExporter& operator=(HighresShmExporter const &) = delete;
+
+  void createSegment();
+  // Find (or claim) the slot for a counter.  Returns nullptr if the
+  // segment is out of slots.
+  ShmCounterSlot* slotFor(const CounterRequest& req);
+  void loop();
+
+  std::string path_;
+  std::unique_ptr<HighresSamplerList> samplers_;
+  uint32_t numSlots_{0};
+  int fd_{-1};
+  size_t segmentSize_{0};
+  ShmCounterHeader* header_{nullptr};
+  ShmCounterSlot* slots_{nullptr};
+  // Writer-private index from counter identity to claimed slot.
+  std::map<CounterRequest, uint32_t> slotIndex_;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+};
+
+}} // facebook::fboss
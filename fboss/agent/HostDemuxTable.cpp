@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/HostDemuxTable.h"
+
+#include "fboss/agent/packet/PktUtil.h"
+#include "fboss/agent/state/Interface.h"
+#include "fboss/agent/state/InterfaceMap.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+
+#include <netinet/in.h>
+
+namespace {
+constexpr uint16_t kEtherTypeIPv4 = 0x0800;
+constexpr uint16_t kEtherTypeIPv6 = 0x86dd;
+// Local BGP sessions are the control plane flows whose latency we
+// care about most
+constexpr uint16_t kBgpPort = 179;
+}
+
+namespace facebook { namespace fboss {
+
+HostDemuxTable::HostDemuxTable(SwSwitch* sw)
+    : AutoRegisterStateObserver(sw, "HostDemuxTable",
+                                INTEREST_INTERFACES) {}
+
+HostDemuxTable::~HostDemuxTable() {}
+
+void HostDemuxTable::stateUpdated(const StateDelta& delta) {
+  // We are only notified when the interface section changed, which is
+  // rare; a full rebuild keeps the table trivially consistent with the
+  // published state.
+  rebuildTable(delta.newState());
+}
+
+void HostDemuxTable::rebuildTable(
+    const std::shared_ptr<SwitchState>& state) {
+  auto table = std::make_shared<Table>();
+  for (const auto& intf : *state->getInterfaces()) {
+    for (const auto& address : intf->getAddresses()) {
+      table->emplace(FlowKey(address.first, IPPROTO_TCP, kBgpPort),
+                     intf->getID());
+    }
+  }
+  folly::SpinLockGuard guard(lock_);
+  table_.swap(table);
+}
+
+bool HostDemuxTable::lookup(uint16_t ethertype, folly::io::Cursor c,
+                            InterfaceID* intf) const {
+  std::shared_ptr<const Table> table;
+  {
+    folly::SpinLockGuard guard(lock_);
+    table = table_;
+  }
+  if (!table || table->empty()) {
+    return false;
+  }
+
+  auto available = c.totalLength();
+  uint8_t proto{0};
+  folly::IPAddress dst;
+  if (ethertype == kEtherTypeIPv4) {
+    if (available < 24) { // fixed v4 header plus the L4 ports
+      return false;
+    }
+    auto verIhl = c.read<uint8_t>();
+    if ((verIhl >> 4) != 4) {
+      return false;
+    }
+    size_t hdrLen = (verIhl & 0x0f) * 4;
+    if (hdrLen < 20 || available < hdrLen + 4) {
+      return false;
+    }
+    c.skip(5); // DSCP/ECN, total length, identification
+    auto fragment = c.readBE<uint16_t>();
+    if ((fragment & 0x3fff) != 0) {
+      // Fragments go through the slow path
+      return false;
+    }
+    c.skip(1); // TTL
+    proto = c.read<uint8_t>();
+    c.skip(6); // checksum, src IP
+    dst = folly::IPAddress(PktUtil::readIPv4(&c));
+    c.skip(hdrLen - 20); // v4 options, if any
+  } else if (ethertype == kEtherTypeIPv6) {
+    if (available < 44) { // fixed v6 header plus the L4 ports
+      return false;
+    }
+    c.skip(6); // version/class/flow label, payload length
+    proto = c.read<uint8_t>(); // extension headers simply miss here
+    c.skip(17); // hop limit, src IP
+    dst = folly::IPAddress(PktUtil::readIPv6(&c));
+  } else {
+    return false;
+  }
+
+  if (proto != IPPROTO_TCP && proto != IPPROTO_UDP) {
+    return false;
+  }
+  auto srcPort = c.readBE<uint16_t>();
+  auto dstPort = c.readBE<uint16_t>();
+  auto itr = table->find(FlowKey(dst, proto, dstPort));
+  if (itr == table->end()) {
+    // Locally initiated sessions carry the well known port in the
+    // source field instead
+    itr = table->find(FlowKey(dst, proto, srcPort));
+  }
+  if (itr == table->end()) {
+    return false;
+  }
+  *intf = itr->second;
+  return true;
+}
+
+}} // facebook::fboss
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <tuple>
+
+#include <boost/container/flat_map.hpp>
+
+#include <folly/IPAddress.h>
+#include <folly/SpinLock.h>
+#include <folly/io/Cursor.h>
+
+#include "fboss/agent/StateObserver.h"
+#include "fboss/agent/types.h"
+
+namespace facebook { namespace fboss {
+
+class SwitchState;
+
+/*
+ * HostDemuxTable answers, right after the L2 header parse, whether a
+ * trapped packet belongs to a control plane flow terminating on the
+ * switch itself (e.g. a local BGP session). Matching packets can be
+ * handed straight to the corresponding host interface, skipping the
+ * generic IPv4/IPv6 slow path, so protocol keepalive latency through
+ * the agent stays constant even when the slow path is busy.
+ *
+ * The table is a small exact match on (dst IP, IP protocol, TCP/UDP
+ * port), rebuilt from the local interface addresses whenever the
+ * interface section of the switch state changes.
+ */
+class HostDemuxTable : public AutoRegisterStateObserver {
+ public:
+  explicit HostDemuxTable(SwSwitch* sw);
+  ~HostDemuxTable() override;
+
+  void stateUpdated(const StateDelta& delta) override;
+
+  /*
+   * Check a trapped packet against the table. The cursor must point at
+   * the start of the L3 header. Returns true and fills in *intf for a
+   * matching control plane flow. Only the fixed parts of the headers
+   * are peeked at; anything unusual (IPv6 extension headers, v4
+   * options pushing the ports out of reach, fragments, short packets)
+   * misses and takes the normal slow path.
+   */
+  bool lookup(uint16_t ethertype, folly::io::Cursor c,
+              InterfaceID* intf) const;
+
+ private:
+  // Exact match key: (dst IP, IP protocol, TCP/UDP port)
+  typedef std::tuple<folly::IPAddress, uint8_t, uint16_t> FlowKey;
+  typedef boost::container::flat_map<FlowKey, InterfaceID> Table;
+
+  // Forbidden copy constructor and assignment operator
+  HostDemuxTable(const HostDemuxTable&) = delete;
+  HostDemuxTable& operator=(const HostDemuxTable&) = delete;
+
+  void rebuildTable(const std::shared_ptr<SwitchState>& state);
+
+  std::shared_ptr<const Table> table_;
+  mutable folly::SpinLock lock_;
+};
+
+}} // facebook::fboss
@@ -9,6 +9,27 @@
  */
 #include "fboss/agent/HwSwitch.h"
 
+#include <algorithm>
+
+#include <glog/logging.h>
+
 namespace facebook { namespace fboss {
 
+void HwSwitch::fetchL2TableBatched(
+    uint32_t batchSize,
+    const std::function<bool(std::vector<L2EntryThrift>)>& fn) {
+  CHECK_GT(batchSize, 0);
+  std::vector<L2EntryThrift> table;
+  fetchL2Table(&table);
+  for (size_t start = 0; start < table.size(); start += batchSize) {
+    auto stop = std::min(table.size(), start + batchSize);
+    std::vector<L2EntryThrift> batch(
+        std::make_move_iterator(table.begin() + start),
+        std::make_move_iterator(table.begin() + stop));
+    if (!fn(std::move(batch))) {
+      return;
+    }
+  }
+}
+
 }} // facebook::fboss
@@ -9,13 +9,16 @@
  */
 #pragma once
 
+#include "fboss/agent/FbossError.h"
 #include "fboss/agent/HighresCounterUtil.h"
 #include "fboss/agent/types.h"
 #include "fboss/agent/if/gen-cpp2/FbossCtrl.h"
 #include "fboss/agent/gen-cpp2/switch_config_types.h"
 
 #include <folly/IPAddress.h>
+#include <folly/Range.h>
 
+#include <functional>
 #include <memory>
 #include <utility>
 
@@ -179,6 +182,20 @@ class HwSwitch {
 
   virtual void fetchL2Table(std::vector<L2EntryThrift> *l2Table) = 0;
 
+  /*
+   * Visit the L2 table in bounded batches instead of materializing the
+   * whole table in one vector. fn is invoked with successive batches of
+   * at most batchSize entries; returning false stops the walk early.
+   *
+   * The default implementation falls back to fetchL2Table() and slices
+   * the result. Hardware implementations that can resume a table
+   * traversal should override it so a full-table walk never holds a
+   * single allocation (or the calling thread) for the entire table.
+   */
+  virtual void fetchL2TableBatched(
+      uint32_t batchSize,
+      const std::function<bool(std::vector<L2EntryThrift>)>& fn);
+
   /*
    * Allow hardware to perform any warm boot related cleanup
    * before we exit the application.
@@ -242,6 +259,25 @@ class HwSwitch {
    */
   virtual bool getAndClearNeighborHit(RouterID vrf,
                                       folly::IPAddress& ip) = 0;
+
+  /*
+   * Trace a probe frame through the hardware pipeline, as if it had
+   * been received on the given port, and fill in the per-stage
+   * resolution. The frame is not forwarded. Implementations without a
+   * hardware trace facility report no support.
+   */
+  virtual void getPacketTrace(PortID /* port */,
+                              folly::StringPiece /* data */,
+                              PacketTraceInfo* /* info */) {
+    throw FbossError("packet trace is not supported on this platform");
+  }
+
+  /*
+   * Fill in occupancy, capacity and high-water marks of the hardware
+   * forwarding tables. Implementations that don't track table usage
+   * leave the output empty.
+   */
+  virtual void getHwTableUsage(std::vector<HwTableUsage>& /* usage */) const {}
  private:
   // Forbidden copy constructor and assignment operator
   HwSwitch(HwSwitch const &) = delete;
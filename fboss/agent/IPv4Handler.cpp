@@ -14,6 +14,7 @@
 #include <folly/MacAddress.h>
 #include <folly/io/Cursor.h>
 #include "fboss/agent/HwSwitch.h"
+#include "fboss/agent/IcmpErrorRateLimiter.h"
 #include "fboss/agent/PortStats.h"
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/TxPacket.h"
@@ -34,6 +35,7 @@
 #include "fboss/agent/state/RouteTable.h"
 #include "fboss/agent/state/RouteTableRib.h"
 #include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteLookupCache.h"
 #include "fboss/agent/DHCPv4Handler.h"
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/UDPHeader.h"
@@ -70,8 +72,10 @@ std::unique_ptr<TxPacket> createICMPv4Pkt(SwSwitch* sw,
 
   auto pkt = sw->allocatePacket(pktLen);
   RWPrivateCursor cursor(pkt->buf());
+  bool hwCsum = pkt->enableCsumOffload(TxPacket::CSUM_OFFLOAD_L4) &
+      TxPacket::CSUM_OFFLOAD_L4;
   icmp4.serializeFullPacket(&cursor, dstMac, srcMac, vlan, ipv4,
-                               bodyLength, serializeBody);
+                               bodyLength, serializeBody, !hwCsum);
   return pkt;
 }
 
@@ -84,6 +88,15 @@ void IPv4Handler::sendICMPTimeExceeded(VlanID srcVlan,
                                        MacAddress src,
                                        IPv4Hdr& v4Hdr,
                                        Cursor cursor) {
+  // Consult the rate limiter before doing any of the serialization
+  // work, so a suppressed response costs only a hash probe.
+  if (!sw_->getIcmpErrorRateLimiter()->allow(v4Hdr.srcAddr.hash())) {
+    sw_->stats()->icmpErrorSuppressed();
+    VLOG(4) << "suppressed rate limited ICMP Time Exceeded to "
+            << v4Hdr.srcAddr.str();
+    return;
+  }
+
   auto state = sw_->getState();
 
   // payload serialization function
@@ -121,6 +134,7 @@ void IPv4Handler::handlePacket(unique_ptr<RxPacket> pkt,
   const uint32_t l3Len = pkt->getLength() - (cursor - Cursor(pkt->buf()));
   stats->port(port)->ipv4Rx();
   IPv4Hdr v4Hdr(cursor);
+  pkt->setL4HdrOffset(cursor - Cursor(pkt->buf()));
   VLOG(4) << "Rx IPv4 packet (" << l3Len << " bytes) " << v4Hdr.srcAddr.str()
           << " --> " << v4Hdr.dstAddr.str()
           << " proto: 0x" << std::hex << static_cast<int>(v4Hdr.protocol);
@@ -215,21 +229,22 @@ void IPv4Handler::handlePacket(unique_ptr<RxPacket> pkt,
   // We will need to manage the rate somehow. Either from HW
   // or a SW control here
   stats->port(port)->ipv4Nexthop();
-  if (!resolveMac(state.get(), port, v4Hdr.dstAddr)) {
+  if (!resolveMac(state.get(), pkt.get(), v4Hdr.dstAddr)) {
     stats->port(port)->ipv4NoArp();
     VLOG(3) << "Cannot find the interface to send out ARP request for "
       << v4Hdr.dstAddr.str();
   }
-  // TODO: ideally, we need to store this packet until the ARP is done and
-  // then send this pkt out. For now, just drop it.
+  // resolveMac() queued a copy of the packet for transmission once the
+  // ARP exchange completes (if it could); this rx copy is done.
   stats->port(port)->pktDropped();
 }
 
 // Return true if we successfully sent an ARP request, false otherwise
 bool IPv4Handler::resolveMac(
     SwitchState* state,
-    PortID ingressPort,
+    const RxPacket* pkt,
     IPAddressV4 dest) {
+  auto ingressPort = pkt->getSrcPort();
   // need to find out our own IP and MAC addresses so that we can send the
   // ARP request out. Since the request will be broadcast, there is no need to
   // worry about which port to send the packet out.
@@ -240,7 +255,10 @@ bool IPv4Handler::resolveMac(
     throw FbossError("No routing tables found");
   }
 
-  auto route = routeTable->getRibV4()->longestMatch(dest);
+  // Punted traffic is heavily skewed towards a few destinations, so go
+  // through the per-thread lookup cache rather than walking the rib.
+  auto route = RouteLookupCache<IPAddressV4>::threadLocal()->longestMatch(
+      routeTable->getRibV4().get(), dest);
   if (!route || !route->isResolved()) {
     sw_->stats()->port(ingressPort)->ipv4DstLookupFailure();
     // No way to reach dest
@@ -249,6 +267,9 @@ bool IPv4Handler::resolveMac(
 
   auto intfs = state->getInterfaces();
   auto nhs = route->getForwardInfo().getNexthops();
+  // Only queue the packet with the first unresolved nexthop; queueing
+  // it with each one would transmit duplicates as they resolve.
+  bool queued = false;
   for (auto nh : nhs) {
     auto intf = intfs->getInterfaceIf(nh.intf);
     if (intf) {
@@ -264,16 +285,31 @@ bool IPv4Handler::resolveMac(
       if (vlan) {
         auto entry = vlan->getArpTable()->getEntryIf(target);
         if (entry == nullptr) {
-          // No entry in ARP table, send ARP request
-          auto mac = intf->getMac();
-          ArpHandler::sendArpRequest(sw_, vlanID, mac, source, target);
+          if (sw_->getNeighborUpdater()->shouldSendArpRequest(vlanID, target)) {
+            // No entry in ARP table, send ARP request
+            auto mac = intf->getMac();
+            ArpHandler::sendArpRequest(sw_, vlanID, mac, source, target);
 
-          // Notify the updater that we sent an arp request
-          sw_->getNeighborUpdater()->sentArpRequest(vlanID, target);
+            // Notify the updater that we sent an arp request
+            sw_->getNeighborUpdater()->sentArpRequest(vlanID, target);
+          } else {
+            VLOG(4) << "not sending arp for " << target.str()
+                    << ", request already in flight";
+          }
+          if (!queued) {
+            sw_->getNeighborUpdater()->queuePendingPacket(vlanID, target, pkt);
+            queued = true;
+          }
+        } else if (entry->isPending()) {
+          VLOG(4) << "not sending arp for " << target.str()
+                  << ", pending entry already exists";
+          if (!queued) {
+            sw_->getNeighborUpdater()->queuePendingPacket(vlanID, target, pkt);
+            queued = true;
+          }
         } else {
-          VLOG(4) << "not sending arp for " << target.str() << ", "
-                  << ((entry->isPending()) ? "pending " : "")
-                  << "entry already exists";
+          VLOG(4) << "not sending arp for " << target.str()
+                  << ", entry already exists";
         }
       }
     }
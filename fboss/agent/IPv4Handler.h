@@ -50,8 +50,12 @@ class IPv4Handler {
   IPv4Handler(IPv4Handler const &) = delete;
   IPv4Handler& operator=(IPv4Handler const &) = delete;
 
-  bool
-  resolveMac(SwitchState* state, PortID ingressPort, folly::IPAddressV4 dest);
+  // Send ARP requests to resolve the nexthop(s) for dest. If pkt is
+  // non-null a copy of it is queued with the neighbor cache so it can
+  // be transmitted once the nexthop resolves.
+  bool resolveMac(SwitchState* state,
+                  const RxPacket* pkt,
+                  folly::IPAddressV4 dest);
 
   SwSwitch* sw_{nullptr};
 };
@@ -12,9 +12,11 @@
 #include <folly/MacAddress.h>
 #include <folly/Format.h>
 #include "fboss/agent/FbossError.h"
+#include "fboss/agent/IcmpErrorRateLimiter.h"
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/SwitchStats.h"
 #include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/NeighborResponseIndex.h"
 #include "fboss/agent/NeighborUpdater.h"
 #include "fboss/agent/TxPacket.h"
 #include "fboss/agent/Platform.h"
@@ -35,6 +37,7 @@
 #include "fboss/agent/state/RouteTable.h"
 #include "fboss/agent/state/RouteTableRib.h"
 #include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteLookupCache.h"
 #include "fboss/agent/Utils.h"
 #include "fboss/agent/UDPHeader.h"
 
@@ -45,6 +48,11 @@ using folly::io::RWPrivateCursor;
 using std::unique_ptr;
 using std::shared_ptr;
 
+namespace {
+// Safety cap on the number of cached neighbor advertisement templates
+const size_t kMaxNeighborResponseTemplates = 1024;
+}
+
 namespace facebook { namespace fboss {
 
 template<typename BodyFn>
@@ -69,8 +77,10 @@ std::unique_ptr<TxPacket> createICMPv6Pkt(SwSwitch* sw,
   uint32_t pktLen = icmp6.computeTotalLengthV6(bodyLength);
   auto pkt = sw->allocatePacket(pktLen);
   RWPrivateCursor cursor(pkt->buf());
+  bool hwCsum = pkt->enableCsumOffload(TxPacket::CSUM_OFFLOAD_L4) &
+      TxPacket::CSUM_OFFLOAD_L4;
   icmp6.serializeFullPacket(&cursor, dstMac, srcMac, vlan,
-                               ipv6, bodyLength, serializeBody);
+                               ipv6, bodyLength, serializeBody, !hwCsum);
   return pkt;
 }
 
@@ -82,7 +92,7 @@ struct IPv6Handler::ICMPHeaders {
 };
 
 IPv6Handler::IPv6Handler(SwSwitch* sw)
-    : AutoRegisterStateObserver(sw, "IPv6Handler"),
+    : AutoRegisterStateObserver(sw, "IPv6Handler", INTEREST_INTERFACES),
       sw_(sw) {
 }
 
@@ -93,10 +103,9 @@ void IPv6Handler::stateUpdated(const StateDelta& delta) {
     } else if (!entry.getNew()) {
       intfDeleted(entry.getOld().get());
     } else {
-      // TODO: We could add an intfChanged() method to re-use the existing
-      // IPv6RouteAdvertiser object.
-      intfDeleted(entry.getOld().get());
-      intfAdded(delta.newState().get(), entry.getNew().get());
+      intfChanged(delta.newState().get(),
+                  entry.getOld().get(),
+                  entry.getNew().get());
     }
   }
 }
@@ -116,6 +125,25 @@ void IPv6Handler::intfAdded(const SwitchState* state, const Interface* intf) {
   CHECK(ret.second);
 }
 
+void IPv6Handler::intfChanged(const SwitchState* state,
+                              const Interface* oldIntf,
+                              const Interface* newIntf) {
+  // The route advertiser serializes its advertisement frame once up
+  // front, so it only needs to be rebuilt when something that actually
+  // goes into the frame changed.  Other interface changes are ignored,
+  // which also keeps the advertiser's timer phase intact.
+  if (raEnabled(oldIntf) == raEnabled(newIntf) &&
+      oldIntf->getNdpConfig() == newIntf->getNdpConfig() &&
+      oldIntf->getMac() == newIntf->getMac() &&
+      oldIntf->getMtu() == newIntf->getMtu() &&
+      oldIntf->getVlanID() == newIntf->getVlanID() &&
+      oldIntf->getAddresses() == newIntf->getAddresses()) {
+    return;
+  }
+  intfDeleted(oldIntf);
+  intfAdded(state, newIntf);
+}
+
 void IPv6Handler::intfDeleted(const Interface* intf) {
   if (!raEnabled(intf)) {
     return;
@@ -130,6 +158,7 @@ void IPv6Handler::handlePacket(unique_ptr<RxPacket> pkt,
                                Cursor cursor) {
   const uint32_t l3Len = pkt->getLength() - (cursor - Cursor(pkt->buf()));
   IPv6Hdr ipv6(cursor);  // note: advances our cursor object
+  pkt->setL4HdrOffset(cursor - Cursor(pkt->buf()));
   VLOG(4) << "IPv6 (" << l3Len << " bytes)"
     " port: " << pkt->getSrcPort() <<
     " vlan: " << pkt->getSrcVlan() <<
@@ -228,10 +257,9 @@ void IPv6Handler::handlePacket(unique_ptr<RxPacket> pkt,
   }
 
   // For now, assume we need to resolve the IP for this packet.
-  // TODO: Add rate limiting so we don't generate too many requests for the
-  // same IP.  Following the rules in RFC 4861 should be sufficient.
-  sendNeighborSolicitations(pkt->getSrcPort(), ipv6.dstAddr);
-  // We drop the packet while waiting on a response.
+  sendNeighborSolicitations(pkt->getSrcPort(), ipv6.dstAddr, pkt.get());
+  // A copy of the packet was queued for transmission once the neighbor
+  // resolves; this rx copy is done.
   sw_->portStats(pkt)->pktDropped();
 }
 
@@ -251,31 +279,37 @@ unique_ptr<RxPacket> IPv6Handler::handleICMPv6Packet(
   }
 
   ICMPHeaders hdr{dst, src, &ipv6, &icmp6};
-  switch (icmp6.type) {
-    case ICMPV6_TYPE_NDP_ROUTER_SOLICITATION:
-      handleRouterSolicitation(std::move(pkt), hdr, cursor);
-      return nullptr;
-    case ICMPV6_TYPE_NDP_ROUTER_ADVERTISEMENT:
-      handleRouterAdvertisement(std::move(pkt), hdr, cursor);
-      return nullptr;
-    case ICMPV6_TYPE_NDP_NEIGHBOR_SOLICITATION:
-      handleNeighborSolicitation(std::move(pkt), hdr, cursor);
-      return nullptr;
-    case ICMPV6_TYPE_NDP_NEIGHBOR_ADVERTISEMENT:
-      handleNeighborAdvertisement(std::move(pkt), hdr, cursor);
-      return nullptr;
-    case ICMPV6_TYPE_NDP_REDIRECT_MESSAGE:
-      sw_->portStats(pkt)->ipv6NdpPkt();
-      // TODO: Do we need to bother handling this yet?
-      sw_->portStats(pkt)->pktDropped();
-      return nullptr;
-    default:
-      break;
+  auto handler = icmpDispatch_.lookup(icmp6.type);
+  if (handler) {
+    (this->*handler)(std::move(pkt), hdr, cursor);
+    return nullptr;
   }
 
   return pkt;
 }
 
+const IPv6Handler::IcmpDispatch IPv6Handler::icmpDispatch_ =
+    IPv6Handler::IcmpDispatch::make({
+      {ICMPV6_TYPE_NDP_ROUTER_SOLICITATION,
+        &IPv6Handler::handleRouterSolicitation},
+      {ICMPV6_TYPE_NDP_ROUTER_ADVERTISEMENT,
+        &IPv6Handler::handleRouterAdvertisement},
+      {ICMPV6_TYPE_NDP_NEIGHBOR_SOLICITATION,
+        &IPv6Handler::handleNeighborSolicitation},
+      {ICMPV6_TYPE_NDP_NEIGHBOR_ADVERTISEMENT,
+        &IPv6Handler::handleNeighborAdvertisement},
+      {ICMPV6_TYPE_NDP_REDIRECT_MESSAGE,
+        &IPv6Handler::handleNeighborRedirect},
+    });
+
+void IPv6Handler::handleNeighborRedirect(unique_ptr<RxPacket> pkt,
+                                         const ICMPHeaders& /* hdr */,
+                                         Cursor /* cursor */) {
+  sw_->portStats(pkt)->ipv6NdpPkt();
+  // TODO: Do we need to bother handling this yet?
+  sw_->portStats(pkt)->pktDropped();
+}
+
 void IPv6Handler::handleRouterSolicitation(unique_ptr<RxPacket> pkt,
                                            const ICMPHeaders& hdr,
                                            Cursor cursor) {
@@ -386,7 +420,8 @@ void IPv6Handler::handleNeighborSolicitation(unique_ptr<RxPacket> pkt,
   auto type = ICMPV6_TYPE_NDP_NEIGHBOR_SOLICITATION;
 
   // Check to see if this IP address is in our NDP response table.
-  auto entry = vlan->getNdpResponseTable()->getEntry(targetIP);
+  auto entry =
+      sw_->getNeighborResponseIndex()->lookup(vlan->getID(), targetIP);
   if (!entry) {
     updater->receivedNdpNotMine(vlan->getID(), hdr.ipv6->srcAddr, hdr.src,
                                 pkt->getSrcPort(), type, 0);
@@ -403,6 +438,9 @@ void IPv6Handler::handleNeighborSolicitation(unique_ptr<RxPacket> pkt,
   sendNeighborAdvertisement(pkt->getSrcVlan(),
                             entry.value().mac, targetIP,
                             hdr.src, hdr.ipv6->srcAddr);
+  // The advertisement we just queued for tx completes this packet's
+  // slow path
+  sw_->recordRxPacketTrace(pkt.get());
 }
 
 void IPv6Handler::handleNeighborAdvertisement(unique_ptr<RxPacket> pkt,
@@ -461,7 +499,8 @@ void IPv6Handler::handleNeighborAdvertisement(unique_ptr<RxPacket> pkt,
   auto type = ICMPV6_TYPE_NDP_NEIGHBOR_ADVERTISEMENT;
 
   // Check to see if this IP address is in our NDP response table.
-  auto entry = vlan->getNdpResponseTable()->getEntry(hdr.ipv6->dstAddr);
+  auto entry =
+      sw_->getNeighborResponseIndex()->lookup(vlan->getID(), hdr.ipv6->dstAddr);
   if (!entry) {
     updater->receivedNdpNotMine(vlan->getID(), targetIP, hdr.src,
                                 pkt->getSrcPort(), type, flags);
@@ -478,6 +517,15 @@ void IPv6Handler::sendICMPv6TimeExceeded(VlanID srcVlan,
                               MacAddress src,
                               IPv6Hdr& v6Hdr,
                               folly::io::Cursor cursor) {
+  // Consult the rate limiter before doing any of the serialization
+  // work, so a suppressed response costs only a hash probe.
+  if (!sw_->getIcmpErrorRateLimiter()->allow(v6Hdr.srcAddr.hash())) {
+    sw_->stats()->icmpErrorSuppressed();
+    VLOG(4) << "suppressed rate limited ICMPv6 Time Exceeded to "
+            << v6Hdr.srcAddr.str();
+    return;
+  }
+
   auto state = sw_->getState();
 
   // payload serialization function
@@ -535,25 +583,27 @@ void IPv6Handler::sendNeighborSolicitation(SwSwitch* sw,
                                            const IPAddressV6& targetIP,
                                            const MacAddress& srcMac,
                                            const VlanID vlanID) {
-  uint32_t bodyLength = 4 + 16 + 8;
-
-  auto serializeBody = [&](RWPrivateCursor* cursor) {
-    cursor->writeBE<uint32_t>(0); // reserved
-    cursor->push(targetIP.bytes(), 16);
-    cursor->write<uint8_t>(1); // Source link layer address option
-    cursor->write<uint8_t>(1); // Option l5ength = 1 (x8)
-    cursor->push(srcMac.bytes(), MacAddress::SIZE);
-  };
-
-  IPAddressV6 solicitedNodeAddr = targetIP.getSolicitedNodeAddress();
-  MacAddress dstMac = MacAddress::createMulticast(solicitedNodeAddr);
-  // For now, we always use our link local IP as the source.
-  IPAddressV6 srcIP(IPAddressV6::LINK_LOCAL, srcMac);
-  auto pkt = createICMPv6Pkt(sw, dstMac, srcMac, vlanID,
-                             solicitedNodeAddr, srcIP,
-                             ICMPV6_TYPE_NDP_NEIGHBOR_SOLICITATION,
-                             ICMPV6_CODE_NDP_MESSAGE_CODE,
-                             bodyLength, serializeBody);
+  // Solicitations from a given (vlan, source MAC) only differ in the
+  // target, so we serialize the frame once per pair and patch the
+  // target dependent fields (and the checksum) into a copy of the
+  // template. The source IP is always our link local address.
+  auto pkt = sw->allocatePacket(NdpSolicitationTemplate::SIZE);
+  auto* self = sw->getIPv6Handler();
+  {
+    std::lock_guard<std::mutex> g(self->nsTemplatesLock_);
+    auto key = std::make_pair(vlanID, srcMac);
+    auto it = self->nsTemplates_.find(key);
+    if (it == self->nsTemplates_.end()) {
+      if (self->nsTemplates_.size() >= kMaxNeighborResponseTemplates) {
+        // Bounded by the (vlan, interface MAC) pairs in the config;
+        // this is just a safety net.
+        self->nsTemplates_.clear();
+      }
+      it = self->nsTemplates_.emplace(
+          key, NdpSolicitationTemplate(vlanID, srcMac)).first;
+    }
+    it->second.writeSolicitation(pkt.get(), targetIP);
+  }
 
   VLOG(4) << "sending neighbor solicitation for " << targetIP <<
     " on vlan " << vlanID;
@@ -581,7 +631,9 @@ void IPv6Handler::sendNeighborSolicitation(SwSwitch* sw,
 }
 
 void IPv6Handler::sendNeighborSolicitations(
-    PortID ingressPort, const folly::IPAddressV6& targetIP) {
+    PortID ingressPort,
+    const folly::IPAddressV6& targetIP,
+    const RxPacket* pkt) {
   // Don't send solicitations for multicast or broadcast addresses.
   if (targetIP.isMulticast() || targetIP.isLinkLocalBroadcast()) {
     return;
@@ -595,7 +647,10 @@ void IPv6Handler::sendNeighborSolicitations(
     return;
   }
 
-  auto route = routeTable->getRibV6()->longestMatch(targetIP);
+  // Punted traffic is heavily skewed towards a few destinations, so go
+  // through the per-thread lookup cache rather than walking the rib.
+  auto route = RouteLookupCache<IPAddressV6>::threadLocal()->longestMatch(
+      routeTable->getRibV6().get(), targetIP);
   if (!route || !route->isResolved()) {
     sw_->stats()->port(ingressPort)->ipv6DstLookupFailure();
     // No way to reach targetIP
@@ -604,6 +659,9 @@ void IPv6Handler::sendNeighborSolicitations(
 
   auto intfs = state->getInterfaces();
   auto nhs = route->getForwardInfo().getNexthops();
+  // Only queue the packet with the first unresolved nexthop; queueing
+  // it with each one would transmit duplicates as they resolve.
+  bool queued = false;
   for (auto nh : nhs) {
     auto intf = intfs->getInterfaceIf(nh.intf);
     if (intf) {
@@ -619,16 +677,33 @@ void IPv6Handler::sendNeighborSolicitations(
       if (vlan) {
         auto entry = vlan->getNdpTable()->getEntryIf(target);
         if (entry == nullptr) {
-          // No entry in NDP table, create a neighbor solicitation packet
-          sendNeighborSolicitation(sw_, target, intf->getMac(), vlan->getID());
-
-          // Notify the updater that we sent a solicitation out
-          sw_->getNeighborUpdater()->sentNeighborSolicitation(vlanID, target);
+          if (sw_->getNeighborUpdater()->shouldSendNeighborSolicitation(
+                  vlanID, target)) {
+            // No entry in NDP table, create a neighbor solicitation packet
+            sendNeighborSolicitation(sw_, target, intf->getMac(),
+                                     vlan->getID());
+
+            // Notify the updater that we sent a solicitation out
+            sw_->getNeighborUpdater()->sentNeighborSolicitation(vlanID,
+                                                                target);
+          } else {
+            VLOG(5) << "not sending neighbor solicitation for "
+                    << target.str() << ", solicitation already in flight";
+          }
+          if (pkt && !queued) {
+            sw_->getNeighborUpdater()->queuePendingPacket(vlanID, target, pkt);
+            queued = true;
+          }
+        } else if (entry->isPending()) {
+          VLOG(5) << "not sending neighbor solicitation for " << target.str()
+                  << ", pending entry already exists";
+          if (pkt && !queued) {
+            sw_->getNeighborUpdater()->queuePendingPacket(vlanID, target, pkt);
+            queued = true;
+          }
         } else {
           VLOG(5) << "not sending neighbor solicitation for " << target.str()
-                  << ", " << ((entry->isPending()) ? "pending" : "")
-                  << " entry already exists";
-
+                  << ", entry already exists";
         }
       }
     }
@@ -664,19 +739,26 @@ void IPv6Handler::sendNeighborAdvertisement(VlanID vlan,
     flags |= 0x40000000;
   }
 
-  uint32_t bodyLength = 4 + 16 + 8;
-  auto serializeBody = [&](RWPrivateCursor* cursor) {
-    cursor->writeBE<uint32_t>(flags);
-    cursor->push(srcIP.bytes(), IPAddressV6::byteCount());
-    cursor->write<uint8_t>(NDPOptionType::TARGET_LL_ADDRESS);
-    cursor->write<uint8_t>(NDPOptionLength::TARGET_LL_ADDRESS_IEEE802);
-    cursor->push(srcMac.bytes(), MacAddress::SIZE);
-  };
-
-  auto pkt = createICMPv6Pkt(sw_, dstMac, srcMac, vlan, dstIP, srcIP,
-                             ICMPV6_TYPE_NDP_NEIGHBOR_ADVERTISEMENT,
-                             ICMPV6_CODE_NDP_MESSAGE_CODE,
-                             bodyLength, serializeBody);
+  // Advertisements for a given (vlan, mac, IP) only differ in the
+  // requester's MAC, the destination IP and the flags word, so we serialize
+  // the frame once per tuple and patch those fields (and the checksum)
+  // into a copy of the template.
+  auto pkt = sw_->allocatePacket(NdpAdvertisementTemplate::SIZE);
+  {
+    std::lock_guard<std::mutex> g(naTemplatesLock_);
+    auto key = std::make_tuple(vlan, srcMac, srcIP);
+    auto it = naTemplates_.find(key);
+    if (it == naTemplates_.end()) {
+      if (naTemplates_.size() >= kMaxNeighborResponseTemplates) {
+        // The tuples mirror the NDP response table, which is bounded by
+        // the configured interface addresses; this is just a safety net.
+        naTemplates_.clear();
+      }
+      it = naTemplates_.emplace(
+          key, NdpAdvertisementTemplate(vlan, srcMac, srcIP)).first;
+    }
+    it->second.writeAdvertisement(pkt.get(), dstMac, dstIP, flags);
+  }
   sw_->sendPacketSwitched(std::move(pkt));
 }
 
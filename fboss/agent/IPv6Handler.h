@@ -10,10 +10,14 @@
 #pragma once
 
 #include "fboss/agent/types.h"
+#include "fboss/agent/NeighborResponseTemplates.h"
+#include "fboss/agent/packet/DispatchTable.h"
 #include "fboss/agent/ndp/IPv6RouteAdvertiser.h"
 #include "fboss/agent/StateObserver.h"
 
 #include <memory>
+#include <mutex>
+#include <tuple>
 #include <boost/container/flat_map.hpp>
 #include <folly/IPAddressV6.h>
 #include <folly/MacAddress.h>
@@ -73,6 +77,9 @@ class IPv6Handler : public AutoRegisterStateObserver {
 
   bool raEnabled(const Interface* intf) const;
   void intfAdded(const SwitchState* state, const Interface* intf);
+  void intfChanged(const SwitchState* state,
+                   const Interface* oldIntf,
+                   const Interface* newIntf);
   void intfDeleted(const Interface* intf);
 
   void sendICMPv6TimeExceeded(VlanID srcVlan,
@@ -109,13 +116,31 @@ class IPv6Handler : public AutoRegisterStateObserver {
   void handleNeighborAdvertisement(std::unique_ptr<RxPacket> pkt,
                                    const ICMPHeaders& hdr,
                                    folly::io::Cursor cursor);
+  void handleNeighborRedirect(std::unique_ptr<RxPacket> pkt,
+                              const ICMPHeaders& hdr,
+                              folly::io::Cursor cursor);
+
+  /*
+   * Per-ICMPv6-type handlers invoked through icmpDispatch_. The table
+   * is built at compile time from the registry in IPv6Handler.cpp; as
+   * the key is the full 8-bit ICMPv6 type the table is direct-indexed.
+   */
+  typedef void (IPv6Handler::*IcmpHandler)(std::unique_ptr<RxPacket> pkt,
+                                           const ICMPHeaders& hdr,
+                                           folly::io::Cursor cursor);
+  typedef DispatchTable<uint8_t, IcmpHandler, 8> IcmpDispatch;
+  static const IcmpDispatch icmpDispatch_;
 
   bool checkNdpPacket(const ICMPHeaders& hdr,
                       const RxPacket* pkt) const;
 
+  // Send neighbor solicitations to resolve the nexthop(s) for
+  // targetIP. If pkt is non-null a copy of it is queued with the
+  // neighbor cache so it can be transmitted once the nexthop resolves.
   void sendNeighborSolicitations(
       PortID ingressPort,
-      const folly::IPAddressV6& targetIP);
+      const folly::IPAddressV6& targetIP,
+      const RxPacket* pkt = nullptr);
   void sendNeighborAdvertisement(VlanID vlan,
                                  folly::MacAddress srcMac,
                                  folly::IPAddressV6 srcIP,
@@ -123,6 +148,24 @@ class IPv6Handler : public AutoRegisterStateObserver {
                                  folly::IPAddressV6 dstIP);
   SwSwitch* sw_{nullptr};
   RAMap routeAdvertisers_;
+
+  // Cached pre-serialized neighbor advertisements, keyed by the
+  // (vlan, source MAC, advertised IP) tuple they were built for. The
+  // frame content is fully determined by the key, so entries never go
+  // stale and no invalidation on state changes is needed.
+  std::mutex naTemplatesLock_;
+  boost::container::flat_map<
+      std::tuple<VlanID, folly::MacAddress, folly::IPAddressV6>,
+      NdpAdvertisementTemplate> naTemplates_;
+
+  // Cached pre-serialized neighbor solicitations, keyed by the
+  // (vlan, source MAC) pair they were built for. Like the
+  // advertisement templates, the content is fully determined by the
+  // key, so no invalidation is needed.
+  std::mutex nsTemplatesLock_;
+  boost::container::flat_map<
+      std::pair<VlanID, folly::MacAddress>,
+      NdpSolicitationTemplate> nsTemplates_;
 };
 
 }} // facebook::fboss
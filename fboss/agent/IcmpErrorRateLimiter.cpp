@@ -0,0 +1,58 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/IcmpErrorRateLimiter.h"
+
+#include <algorithm>
+
+namespace facebook { namespace fboss {
+
+IcmpErrorRateLimiter::IcmpErrorRateLimiter(
+    uint32_t perSourcePps, uint32_t globalPps)
+    : perSourcePps_(perSourcePps),
+      globalPps_(globalPps) {
+  // All buckets start full, so short bursts right after start are not
+  // penalized.
+  auto now = std::chrono::steady_clock::now();
+  global_.tokens = globalPps_;
+  global_.lastRefill = now;
+  for (auto& bucket : buckets_) {
+    bucket.tokens = perSourcePps_;
+    bucket.lastRefill = now;
+  }
+}
+
+bool IcmpErrorRateLimiter::take(TokenBucket* bucket, uint32_t rate,
+                                std::chrono::steady_clock::time_point now) {
+  folly::SpinLockGuard guard(bucket->lock);
+  std::chrono::duration<double> elapsed = now - bucket->lastRefill;
+  if (elapsed.count() > 0) {
+    bucket->tokens = std::min<double>(
+        rate, bucket->tokens + elapsed.count() * rate);
+    bucket->lastRefill = now;
+  }
+  if (bucket->tokens < 1) {
+    return false;
+  }
+  --bucket->tokens;
+  return true;
+}
+
+bool IcmpErrorRateLimiter::allow(size_t srcHash,
+                                 std::chrono::steady_clock::time_point now) {
+  // Check the per-source bucket first, so a source that is over its own
+  // budget cannot drain the global bucket for everyone else.
+  if (perSourcePps_ != 0 &&
+      !take(&buckets_[srcHash % kNumBuckets], perSourcePps_, now)) {
+    return false;
+  }
+  return globalPps_ == 0 || take(&global_, globalPps_, now);
+}
+
+}} // facebook::fboss
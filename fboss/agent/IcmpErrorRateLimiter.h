@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+
+#include <folly/SpinLock.h>
+
+namespace facebook { namespace fboss {
+
+/*
+ * Rate limiter for slow-path generated ICMP error responses (TTL/hop
+ * limit exceeded and friends).
+ *
+ * Without one, a traceroute storm turns into a packet-generation storm:
+ * every qualifying packet costs an allocation and a full ICMP
+ * serialization. The limiter is consulted before any of that work
+ * starts, so a suppressed response costs only a hash probe and a couple
+ * of arithmetic operations, bounding worst-case slow-path CPU
+ * regardless of offered load.
+ *
+ * Fairness comes from hashing the offending source address into a fixed
+ * array of token buckets: a noisy source exhausts its own bucket (or at
+ * worst the sources sharing its hash slot) without silencing responses
+ * to everyone else. A global bucket on top caps the total generation
+ * rate no matter how many sources participate.
+ */
+class IcmpErrorRateLimiter {
+ public:
+  /*
+   * Rates are in responses per second; burst capacity is one second's
+   * worth of tokens. A rate of 0 disables that particular check.
+   */
+  IcmpErrorRateLimiter(uint32_t perSourcePps, uint32_t globalPps);
+
+  /*
+   * Returns true if a response to the source with the given address
+   * hash may be generated, consuming one token from that source's
+   * bucket and from the global bucket.
+   */
+  bool allow(size_t srcHash) {
+    return allow(srcHash, std::chrono::steady_clock::now());
+  }
+  // Time-explicit variant, exposed for tests.
+  bool allow(size_t srcHash, std::chrono::steady_clock::time_point now);
+
+ private:
+  struct TokenBucket {
+    folly::SpinLock lock;
+    double tokens{0};
+    std::chrono::steady_clock::time_point lastRefill;
+  };
+
+  // Refill the bucket for the time elapsed since the last call and take
+  // one token; returns false if the bucket is empty.
+  static bool take(TokenBucket* bucket, uint32_t rate,
+                   std::chrono::steady_clock::time_point now);
+
+  // Forbidden copy constructor and assignment operator
+  IcmpErrorRateLimiter(const IcmpErrorRateLimiter&) = delete;
+  IcmpErrorRateLimiter& operator=(const IcmpErrorRateLimiter&) = delete;
+
+  static constexpr size_t kNumBuckets = 256;
+
+  const uint32_t perSourcePps_;
+  const uint32_t globalPps_;
+  TokenBucket global_;
+  std::array<TokenBucket, kNumBuckets> buckets_;
+};
+
+}} // facebook::fboss
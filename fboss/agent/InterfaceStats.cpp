@@ -0,0 +1,46 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/InterfaceStats.h"
+
+#include "fboss/agent/SwitchStats.h"
+
+#include <folly/Conv.h>
+
+using facebook::stats::SUM;
+using facebook::stats::RATE;
+
+namespace facebook { namespace fboss {
+
+InterfaceStats::InterfaceStats(
+    stats::ThreadCachedServiceData::ThreadLocalStatsMap* map,
+    InterfaceID intfID)
+  : intfID_(intfID),
+    toHostPkts_(map, statName("host.rx"), SUM, RATE),
+    toHostBytes_(map, statName("host.rx.bytes"), SUM, RATE),
+    fromHostPkts_(map, statName("host.tx"), SUM, RATE),
+    fromHostBytes_(map, statName("host.tx.bytes"), SUM, RATE) {
+}
+
+std::string InterfaceStats::statName(folly::StringPiece name) const {
+  return folly::to<std::string>(SwitchStats::kCounterPrefix, "intf.",
+                                static_cast<int>(intfID_), ".", name);
+}
+
+void InterfaceStats::toHostBatch(uint64_t pkts, uint64_t bytes) {
+  toHostPkts_.addValue(pkts);
+  toHostBytes_.addValue(bytes);
+}
+
+void InterfaceStats::fromHostBatch(uint64_t pkts, uint64_t bytes) {
+  fromHostPkts_.addValue(pkts);
+  fromHostBytes_.addValue(bytes);
+}
+
+}} // facebook::fboss
@@ -0,0 +1,60 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "common/stats/ThreadCachedServiceData.h"
+#include "fboss/agent/types.h"
+
+namespace facebook { namespace fboss {
+
+/*
+ * Per-interface counters for the host-bound (tun) packet path.
+ *
+ * These are thread-local timeseries like the aggregate host.rx/host.tx
+ * counters, so they are cheap enough to leave enabled in production.
+ * Blocks are created lazily by SwitchStats and handed out through a
+ * flat InterfaceID-indexed array (see SwitchStats::intf()), and the
+ * tun code counts once per drained batch, so the per-packet path never
+ * pays a map lookup for interface accounting.
+ */
+class InterfaceStats {
+ public:
+  InterfaceStats(stats::ThreadCachedServiceData::ThreadLocalStatsMap* map,
+                 InterfaceID intfID);
+
+  /*
+   * Count a batch of packets sent to (resp. received from) the host
+   * over this interface's tun device.
+   */
+  void toHostBatch(uint64_t pkts, uint64_t bytes);
+  void fromHostBatch(uint64_t pkts, uint64_t bytes);
+
+  InterfaceID getID() const {
+    return intfID_;
+  }
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  InterfaceStats(InterfaceStats const &) = delete;
+  InterfaceStats& operator=(InterfaceStats const &) = delete;
+
+  std::string statName(folly::StringPiece name) const;
+
+  InterfaceID intfID_;
+
+  // Packets and bytes delivered to the host over this interface
+  stats::ThreadCachedServiceData::TLTimeseries toHostPkts_;
+  stats::ThreadCachedServiceData::TLTimeseries toHostBytes_;
+  // Packets and bytes injected by the host over this interface
+  stats::ThreadCachedServiceData::TLTimeseries fromHostPkts_;
+  stats::ThreadCachedServiceData::TLTimeseries fromHostBytes_;
+};
+
+}} // facebook::fboss
@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/InternedString.h"
+
+#include <folly/Hash.h>
+#include <folly/Synchronized.h>
+
+#include <deque>
+#include <unordered_map>
+
+namespace facebook { namespace fboss {
+
+namespace {
+
+struct Pool {
+  // The arena. A deque never moves its elements, so the std::strings
+  // (and the pointers handed out as handles) stay valid for the life
+  // of the process.
+  std::deque<std::string> arena;
+  // Index into the arena, keyed by pieces of the arena strings
+  // themselves so the index holds no second copy.
+  std::unordered_map<folly::StringPiece, const std::string*, folly::Hash>
+      index;
+};
+
+folly::Synchronized<Pool>* pool() {
+  static auto* p = new folly::Synchronized<Pool>();
+  return p;
+}
+
+} // unnamed namespace
+
+InternedString::InternedString() : str_(intern("").str_) {}
+
+InternedString InternedString::intern(folly::StringPiece str) {
+  const std::string* result{nullptr};
+  SYNCHRONIZED_CONST(p, *pool()) {
+    auto itr = p.index.find(str);
+    if (itr != p.index.end()) {
+      result = itr->second;
+    }
+  }
+  if (result) {
+    return InternedString(result);
+  }
+  SYNCHRONIZED(p, *pool()) {
+    // Re-check under the write lock; another thread may have raced us.
+    auto itr = p.index.find(str);
+    if (itr != p.index.end()) {
+      result = itr->second;
+    } else {
+      p.arena.emplace_back(str.data(), str.size());
+      const auto& stored = p.arena.back();
+      p.index.emplace(folly::StringPiece(stored), &stored);
+      result = &stored;
+    }
+  }
+  return InternedString(result);
+}
+
+}} // facebook::fboss
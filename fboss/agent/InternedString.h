@@ -0,0 +1,78 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+
+#include <string>
+
+namespace facebook { namespace fboss {
+
+/*
+ * An immutable handle to a string in the global intern pool.
+ *
+ * Names and labels repeat heavily: port and VLAN names live in every
+ * SwitchState generation, and the same names are baked into counter
+ * keys like "<port>.up". Interning stores each distinct string once,
+ * in an arena whose entries never move or die, and hands out
+ * pointer-sized handles. Copying a handle is copying a pointer,
+ * equality is pointer comparison, and the backing std::string can be
+ * referenced for as long as the process runs - so a counter key built
+ * from an interned name can be handed around as a StringPiece without
+ * ever copying it again.
+ *
+ * Intended for bounded vocabularies (config-derived names, counter
+ * keys). Entries are never freed, so do not intern unbounded or
+ * attacker-controlled strings.
+ *
+ * intern() takes a lock; do it at config apply or construction time,
+ * not per packet.
+ */
+class InternedString {
+ public:
+  /*
+   * The empty string, interned; same handle as intern("").
+   */
+  InternedString();
+
+  /*
+   * Get the handle for a string, adding it to the pool on first use.
+   * Thread safe.
+   */
+  static InternedString intern(folly::StringPiece str);
+
+  const std::string& str() const {
+    return *str_;
+  }
+  folly::StringPiece piece() const {
+    return *str_;
+  }
+  const char* c_str() const {
+    return str_->c_str();
+  }
+  bool empty() const {
+    return str_->empty();
+  }
+
+  bool operator==(const InternedString& other) const {
+    return str_ == other.str_;
+  }
+  bool operator!=(const InternedString& other) const {
+    return str_ != other.str_;
+  }
+
+ private:
+  explicit InternedString(const std::string* str) : str_(str) {}
+
+  // Points into the pool arena; never null, never dangles.
+  const std::string* str_;
+};
+
+}} // facebook::fboss
@@ -14,6 +14,7 @@
 #include <folly/io/Cursor.h>
 #include <folly/MacAddress.h>
 #include <folly/Range.h>
+#include "fboss/agent/PortSendContextTable.h"
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/TxPacket.h"
@@ -31,20 +32,24 @@ namespace facebook { namespace fboss {
 const MacAddress LldpManager::LLDP_DEST_MAC("01:80:c2:00:00:0e");
 
 LldpManager::LldpManager(SwSwitch* sw)
-  : folly::AsyncTimeout(sw->getBackgroundEVB()),
+  : LldpManager(sw, sw->pickBackgroundEVB()) {}
+
+LldpManager::LldpManager(SwSwitch* sw, folly::EventBase* evb)
+  : folly::AsyncTimeout(evb),
     sw_(sw),
+    evb_(evb),
     interval_(LLDP_INTERVAL) {}
 
 LldpManager::~LldpManager() {}
 
 void LldpManager::start() {
-  sw_->getBackgroundEVB()->runInEventBaseThread([this] {
+  evb_->runInEventBaseThread([this] {
     this->timeoutExpired();
   });
 }
 
 void LldpManager::stop() {
-  auto f = via(sw_->getBackgroundEVB())
+  auto f = via(evb_)
     .then([this] { this->cancelTimeout(); });
   f.get();
 }
@@ -71,20 +76,50 @@ void LldpManager::handlePacket(std::unique_ptr<RxPacket> pkt,
 
 void LldpManager::timeoutExpired() noexcept {
   try {
-    sendLldpOnAllPorts(true);
+    if (sliceIndex_ == 0) {
+      // update() no longer prunes inline, so age out neighbors we have
+      // stopped hearing from once per interval instead.
+      db_.pruneExpiredNeighbors();
+    }
+    sendNextSlice(sw_->getState());
   } catch (const std::exception& ex) {
-    LOG(ERROR) << "Failed to send LLDP on all ports. Error:"
+    LOG(ERROR) << "Failed to send LLDP. Error:"
                << folly::exceptionStr(ex);
   }
-  scheduleTimeout(interval_);
+  // The interval is divided into kSendSlices ticks, each sending its
+  // share of the ports, so every port still sends once per interval.
+  scheduleTimeout(interval_ / kSendSlices);
+}
+
+void LldpManager::sendNextSlice(const std::shared_ptr<SwitchState>& state) {
+  rebuildFramesIfNeeded(state);
+  // Send the sliceIndex_'th slice of the cached frames
+  size_t numFrames = frames_.size();
+  size_t begin = numFrames * sliceIndex_ / kSendSlices;
+  size_t end = numFrames * (sliceIndex_ + 1) / kSendSlices;
+  auto itr = frames_.begin() + begin;
+  for (size_t idx = begin; idx < end; ++idx, ++itr) {
+    auto port = state->getPorts()->getPortIf(itr->first);
+    if (port && port->isPortUp()) {
+      sendCachedFrame(itr->first, itr->second);
+    } else {
+      VLOG(5) << "Skipping LLDP send as this port is disabled " <<
+        itr->first;
+    }
+  }
+  sliceIndex_ = (sliceIndex_ + 1) % kSendSlices;
 }
 
 void LldpManager::sendLldpOnAllPorts(bool checkPortStatusFlag) {
   // send lldp frames through all the ports here.
   std::shared_ptr<SwitchState> state = sw_->getState();
+  rebuildFramesIfNeeded(state);
   for (const auto& port : *state->getPorts()) {
     if (checkPortStatusFlag == false || port->isPortUp()) {
-      sendLldpInfo(sw_, state, port);
+      auto itr = frames_.find(port->getID());
+      if (itr != frames_.end()) {
+        sendCachedFrame(itr->first, itr->second);
+      }
     } else {
       VLOG(5) << "Skipping LLDP send as this port is disabled " <<
         port->getID();
@@ -92,6 +127,28 @@ void LldpManager::sendLldpOnAllPorts(bool checkPortStatusFlag) {
   }
 }
 
+void LldpManager::rebuildFramesIfNeeded(
+    const std::shared_ptr<SwitchState>& state) {
+  auto ports = state->getPorts();
+  if (ports == cachedPorts_) {
+    return;
+  }
+  const size_t kMaxLen = 64;
+  char hostname[kMaxLen];
+  if (0 == gethostname(hostname, kMaxLen)) {
+    // make sure it is null terminated
+    hostname[kMaxLen - 1] = '\0';
+  } else {
+    hostname[0] = '\0';
+  }
+  frames_.clear();
+  frames_.reserve(ports->numPorts());
+  for (const auto& port : *ports) {
+    frames_.emplace(port->getID(), buildLldpFrame(port, hostname));
+  }
+  cachedPorts_ = ports;
+}
+
 uint16_t tlvHeader(uint16_t type, uint16_t length) {
   DCHECK_EQ((type & ~0x7f), 0);
   DCHECK_EQ((length & ~0x01ff), 0);
@@ -128,28 +185,27 @@ void writeTlv(uint16_t type, const ByteRange& value,
   cursor->push(value.data(), value.size());
 }
 
-void LldpManager::sendLldpInfo(SwSwitch* sw,
-                               const std::shared_ptr<SwitchState>& swState,
-                               const std::shared_ptr<Port>& port) {
-  MacAddress cpuMac = sw->getPlatform()->getLocalMac();
-  const size_t kMaxLen = 64;
-  char hostname[kMaxLen];
-
-  if (0 == gethostname(hostname, kMaxLen)) {
-    // make sure it is null terminated
-    hostname[kMaxLen - 1] = '\0';
-  } else {
-    hostname[0] = '\0';
-  }
+LldpManager::CachedPkt LldpManager::buildLldpFrame(
+    const std::shared_ptr<Port>& port,
+    StringPiece hostname) {
+  MacAddress cpuMac = sw_->getPlatform()->getLocalMac();
 
   // The minimum packet length is 64.We use 68 on the assumption that
   // the packet will go out untagged, which will remove 4 bytes.
   uint32_t frameLen = 98;
-  auto pkt = sw->allocatePacket(frameLen);
-  PortID thisPortID = port->getID();
-  RWPrivateCursor cursor(pkt->buf());
-  pkt->writeEthHeader(&cursor, LLDP_DEST_MAC,
-                      cpuMac, port->getIngressVlan(), ETHERTYPE_LLDP);
+  CachedPkt cached;
+  cached.frame = folly::IOBuf::create(frameLen);
+  cached.frame->append(frameLen);
+  RWPrivateCursor cursor(cached.frame.get());
+  // Use the pre-resolved send context where available, so the rebuild
+  // doesn't re-derive the VLAN tag and header fields per port.
+  auto sendCtx = sw_->getPortSendContextTable()->getContext(port->getID());
+  if (sendCtx) {
+    sendCtx->writeEthHeader(&cursor, LLDP_DEST_MAC, ETHERTYPE_LLDP);
+  } else {
+    TxPacket::writeEthHeader(&cursor, LLDP_DEST_MAC,
+                             cpuMac, port->getIngressVlan(), ETHERTYPE_LLDP);
+  }
   // now write chassis ID TLV
   writeTlv(CHASSIS_TLV_TYPE, CHASSIS_TLV_SUB_TYPE_MAC,
            ByteRange(cpuMac.bytes(), 6), &cursor);
@@ -161,14 +217,16 @@ void LldpManager::sendLldpInfo(SwSwitch* sw,
   writeTlv(PORT_TLV_TYPE, PORT_TLV_SUB_TYPE_INTERFACE,
            StringPiece(port->getName()), &cursor);
 
-  // now write TTL TLV
+  // now write TTL TLV, remembering where its value lives so each
+  // transmitted copy can refresh it
+  cached.ttlValueOffset =
+      frameLen - cursor.length() + sizeof(uint16_t);
   writeTlv(TTL_TLV_TYPE, (uint16_t) TTL_TLV_VALUE, &cursor);
 
   // now write optional TLVs
   // system name TLV
-  if (strlen(hostname) > 0) {
-    writeTlv(SYSTEM_NAME_TLV_TYPE,
-             StringPiece(hostname), &cursor);
+  if (!hostname.empty()) {
+    writeTlv(SYSTEM_NAME_TLV_TYPE, hostname, &cursor);
   }
 
   // system description TLV
@@ -184,13 +242,25 @@ void LldpManager::sendLldpInfo(SwSwitch* sw,
 
   // Fill the padding with 0s
   memset(cursor.writableData(), 0, cursor.length());
-  // this LLDP packet HAS to exit out of the port specified here.
-  sw->sendPacketOutOfPort(std::move(pkt), thisPortID);
-  VLOG(4) << "sent LLDP "
-    << " on port " << port->getID()
+  VLOG(4) << "built LLDP frame"
+    << " for port " << port->getID()
     << " with CPU MAC " << cpuMac.toString()
     << " port id " << port->getName()
     << " and vlan " << port->getIngressVlan();
+  return cached;
+}
+
+void LldpManager::sendCachedFrame(PortID port, const CachedPkt& cached) {
+  auto pkt = sw_->allocatePacket(cached.frame->length());
+  RWPrivateCursor cursor(pkt->buf());
+  cursor.push(cached.frame->data(), cached.frame->length());
+  // Refresh the TTL TLV value in the transmitted copy
+  RWPrivateCursor ttlCursor(pkt->buf());
+  ttlCursor.skip(cached.ttlValueOffset);
+  ttlCursor.writeBE<uint16_t>(TTL_TLV_VALUE);
+  // this LLDP packet HAS to exit out of the port specified here.
+  sw_->sendPacketOutOfPort(std::move(pkt), port);
+  VLOG(4) << "sent LLDP on port " << port;
 }
 
 }} // facebook::fboss
@@ -9,7 +9,10 @@
  */
 // Copyright 2014-present Facebook. All Rights Reserved.
 #pragma once
+#include <boost/container/flat_map.hpp>
 #include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/IOBuf.h>
+#include <folly/Range.h>
 #include <unordered_map>
 #include <memory>
 #include "fboss/agent/Platform.h"
@@ -89,13 +92,45 @@ class LldpManager : private folly::AsyncTimeout {
   }
 
  private:
+  // Number of timer ticks one LLDP interval is divided into. Each tick
+  // sends 1/kSendSlices of the ports, so a high-port-count system
+  // spreads its sends over the interval instead of bursting them all
+  // in one EventBase callback.
+  enum : uint32_t { kSendSlices = 8 };
+
+  /*
+   * A fully serialized LLDP frame for one port, built once and reused
+   * every interval until the port section of the switch state changes.
+   */
+  struct CachedPkt {
+    std::unique_ptr<folly::IOBuf> frame;
+    // Offset of the TTL TLV value, refreshed in each transmitted copy
+    uint32_t ttlValueOffset{0};
+  };
+
+  // Pins the manager to the given background worker EventBase
+  LldpManager(SwSwitch* sw, folly::EventBase* evb);
+
   void timeoutExpired() noexcept override;
-  void sendLldpInfo(SwSwitch* sw, const std::shared_ptr<SwitchState>& swState,
-                    const std::shared_ptr<Port>& port);
+  void rebuildFramesIfNeeded(const std::shared_ptr<SwitchState>& state);
+  CachedPkt buildLldpFrame(const std::shared_ptr<Port>& port,
+                           folly::StringPiece hostname);
+  void sendCachedFrame(PortID port, const CachedPkt& pkt);
+  void sendNextSlice(const std::shared_ptr<SwitchState>& state);
 
   SwSwitch* sw_{nullptr};
+  // Background worker EventBase all timer work runs on
+  folly::EventBase* evb_{nullptr};
   std::chrono::milliseconds interval_;
   LinkNeighborDB db_;
+  // Pre-serialized frames, keyed by port. Only touched from the
+  // background EventBase thread, like the timer itself.
+  boost::container::flat_map<PortID, CachedPkt> frames_;
+  // The PortMap the frames were built from; a pointer change means the
+  // port section was republished and the cache is stale.
+  std::shared_ptr<PortMap> cachedPorts_;
+  // Position of the next slice within the current interval
+  uint32_t sliceIndex_{0};
 };
 
 }} // facebook::fboss
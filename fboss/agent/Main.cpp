@@ -15,17 +15,21 @@
 #include <folly/String.h>
 #include "fboss/agent/ApplyThriftConfig.h"
 #include "fboss/agent/HwSwitch.h"
+#include "fboss/agent/PeriodicScheduler.h"
 #include "fboss/agent/Platform.h"
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/ThriftHandler.h"
 #include "fboss/agent/TunManager.h"
 #include "common/stats/ServiceData.h"
-#include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/AsyncSignalHandler.h>
 #include <folly/io/async/EventBase.h>
+#include <thrift/lib/cpp/concurrency/PosixThreadFactory.h>
+#include <thrift/lib/cpp/concurrency/ThreadManager.h>
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 #include <folly/SocketAddress.h>
 
+#include <sched.h>
+
 #include <chrono>
 #include <condition_variable>
 #include <csignal>
@@ -39,7 +43,6 @@
 using folly::FunctionScheduler;
 using apache::thrift::ThriftServer;
 using folly::AsyncSignalHandler;
-using folly::AsyncTimeout;
 using folly::EventBase;
 using folly::SocketAddress;
 using std::shared_ptr;
@@ -58,6 +61,14 @@ DEFINE_int32(thrift_idle_timeout, 60, "Thrift idle timeout in seconds.");
 // Programming 16K routes can take 20+ seconds
 DEFINE_int32(thrift_task_expire_timeout, 30,
     "Thrift task expire timeout in seconds.");
+DEFINE_int32(thrift_cpu_threads, 4,
+    "Number of worker threads servicing thrift requests.  Handler "
+    "methods run here, not on the packet or update threads, so a big "
+    "dump cannot distort slow-path latency.");
+DEFINE_string(thrift_cpu_set, "",
+    "Comma-separated list of CPUs to pin the thrift worker threads to "
+    "(empty = no pinning).  Pick CPUs distinct from the ones the packet "
+    "threads run on.");
 DEFINE_bool(tun_intf, true,
             "Create tun interfaces to allow other processes to "
             "send and receive traffic via the switch ports");
@@ -82,6 +93,84 @@ void updateStats(SwSwitch *swSwitch) {
   swSwitch->getHw()->updateStats(swSwitch->stats());
 }
 
+namespace {
+
+using apache::thrift::concurrency::PosixThreadFactory;
+using apache::thrift::concurrency::Runnable;
+using apache::thrift::concurrency::Thread;
+
+/*
+ * A Runnable wrapper that pins the thread to a caller-supplied CPU set
+ * before running the real task.
+ */
+class PinnedRunnable : public Runnable {
+ public:
+  PinnedRunnable(std::shared_ptr<Runnable> runnable, cpu_set_t cpus)
+    : runnable_(std::move(runnable)),
+      cpus_(cpus) {}
+
+  void run() override {
+    if (sched_setaffinity(0, sizeof(cpus_), &cpus_) != 0) {
+      LOG(ERROR) << "failed to set thrift worker CPU affinity: "
+                 << folly::errnoStr(errno);
+    }
+    runnable_->run();
+  }
+
+  std::shared_ptr<Thread> thread() override {
+    return runnable_->thread();
+  }
+  void thread(std::shared_ptr<Thread> value) override {
+    runnable_->thread(value);
+  }
+
+ private:
+  std::shared_ptr<Runnable> runnable_;
+  cpu_set_t cpus_;
+};
+
+class PinnedThreadFactory : public PosixThreadFactory {
+ public:
+  explicit PinnedThreadFactory(cpu_set_t cpus)
+    : PosixThreadFactory(PosixThreadFactory::OTHER,
+                         PosixThreadFactory::NORMAL),
+      cpus_(cpus) {}
+
+  std::shared_ptr<Thread> newThread(
+      const std::shared_ptr<Runnable>& runnable) const override {
+    return PosixThreadFactory::newThread(
+        std::make_shared<PinnedRunnable>(runnable, cpus_));
+  }
+
+ private:
+  cpu_set_t cpus_;
+};
+
+/*
+ * Build the thread factory for the thrift worker pool.
+ *
+ * The factory always requests the default scheduling policy at normal
+ * priority, so thrift workers never inherit elevated scheduling
+ * parameters from whichever thread spawns them.  With --thrift_cpu_set
+ * the workers are additionally pinned away from the packet threads.
+ */
+std::shared_ptr<PosixThreadFactory> createThriftThreadFactory() {
+  if (FLAGS_thrift_cpu_set.empty()) {
+    return std::make_shared<PosixThreadFactory>(
+        PosixThreadFactory::OTHER, PosixThreadFactory::NORMAL);
+  }
+  std::vector<int> cpus;
+  folly::split(',', FLAGS_thrift_cpu_set, cpus);
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  for (int cpu : cpus) {
+    CPU_SET(cpu, &cpuSet);
+  }
+  return std::make_shared<PinnedThreadFactory>(cpuSet);
+}
+
+} // unnamed namespace
+
 class Initializer {
  public:
   Initializer(SwSwitch* sw, Platform* platform)
@@ -190,28 +279,6 @@ class Initializer {
   condition_variable initCondition_;
 };
 
-class StatsPublisher : public AsyncTimeout {
- public:
-  StatsPublisher(EventBase* eventBase, SwSwitch* sw,
-                 std::chrono::milliseconds interval)
-    : AsyncTimeout(eventBase),
-      sw_(sw),
-      interval_(interval) {}
-
-  void start() {
-    scheduleTimeout(interval_);
-  }
-
-  void timeoutExpired() noexcept override {
-    sw_->publishStats();
-    scheduleTimeout(interval_);
-  }
-
- private:
-  SwSwitch* sw_{nullptr};
-  std::chrono::milliseconds interval_;
-};
-
 /*
  */
 class SignalHandler : public AsyncSignalHandler {
@@ -272,6 +339,19 @@ int fbossMain(int argc, char** argv, PlatformInitFn initPlatform) {
   server.setTaskExpireTime(std::chrono::milliseconds(
         FLAGS_thrift_task_expire_timeout * 1000));
   server.getEventBaseManager()->setEventBase(&eventBase, false);
+
+  // Run handler methods on a dedicated worker pool, not on the shared
+  // EventBase above.  The main loop only does I/O for thrift, stats
+  // publishing and signals, so a monitoring client pulling a big dump
+  // (e.g. getAllRoutes) cannot stall packet rx or state updates.
+  auto thriftThreadManager =
+      apache::thrift::concurrency::ThreadManager::newSimpleThreadManager(
+          FLAGS_thrift_cpu_threads);
+  thriftThreadManager->setNamePrefix("FbossThriftCpu");
+  thriftThreadManager->threadFactory(createThriftThreadFactory());
+  thriftThreadManager->start();
+  server.setThreadManager(thriftThreadManager);
+
   server.setInterface(handler);
   server.setDuplex(true);
   handler->setEventBaseManager(server.getEventBaseManager());
@@ -295,14 +375,16 @@ int fbossMain(int argc, char** argv, PlatformInitFn initPlatform) {
   // Thrift port 5909
   init.start();
 
-  // Create a timeout to call sw->publishStats() once every second.
-  StatsPublisher statsPublisher(
-      &eventBase, &sw,
-      std::chrono::milliseconds(FLAGS_stat_publish_interval_ms));
-  statsPublisher.start();
+  // Register the stats publishing tick with the central periodic
+  // scheduler.  It runs HIGH tier since dashboards and counter-delta
+  // consumers depend on its cadence.
+  sw.getPeriodicScheduler()->addTask(
+      "publish_stats", PeriodicScheduler::Tier::HIGH,
+      std::chrono::milliseconds(FLAGS_stat_publish_interval_ms),
+      [&sw]() { sw.publishStats(); });
 
   auto stopServices = [&]() {
-    statsPublisher.cancelTimeout();
+    sw.getPeriodicScheduler()->removeTask("publish_stats");
     init.stopFunctionScheduler();
     fbossFinalize();
   };
@@ -68,6 +68,10 @@ void NdpCache::receivedNdpMine(folly::IPAddressV6 ip,
   } else {
     throw FbossError("Unexpected NDP packet type ", type);
   }
+
+  // Whichever branch we took above, the neighbor's mac is known now;
+  // release any packets that were queued up waiting for it.
+  flushPendingPackets(ip);
 }
 
 void NdpCache::receivedNdpNotMine(folly::IPAddressV6 ip,
@@ -81,13 +85,10 @@ void NdpCache::receivedNdpNotMine(folly::IPAddressV6 ip,
   // discard the packet if the target IP isn't ours.
 }
 
-inline void NdpCache::probeFor(folly::IPAddressV6 ip) const {
-  auto vlan = getSw()->getState()->getVlans()->getVlanIf(getVlanID());
-  if (!vlan) {
-    VLOG(2) << "Vlan " << getVlanID() << " not found. Skip sending probe";
-    return;
-  }
-  IPv6Handler::sendNeighborSolicitation(getSw(), ip, vlan);
+void NdpCache::restoreEntry(folly::IPAddressV6 ip,
+                            folly::MacAddress mac,
+                            PortID port) {
+  setEntry(ip, mac, port, NeighborEntryState::STALE);
 }
 
 std::list<NdpEntryThrift> NdpCache::getNdpCacheData() {
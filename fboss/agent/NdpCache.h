@@ -39,7 +39,15 @@ class NdpCache : public NeighborCache<NdpTable> {
                           ICMPv6Type type,
                           uint32_t flags);
 
-  void probeFor(folly::IPAddressV6 ip) const override;
+  /*
+   * Restore an entry checkpointed by the previous run on warm boot.
+   * The entry enters in STALE state: it is programmed and usable right
+   * away, but gets revalidated on the cache's own (jittered) stale
+   * timers instead of being re-probed immediately.
+   */
+  void restoreEntry(folly::IPAddressV6 ip,
+                    folly::MacAddress mac,
+                    PortID port);
 
   std::list<NdpEntryThrift> getNdpCacheData();
 
@@ -12,24 +12,33 @@
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/NeighborCacheImpl-defs.h"
 #include "fboss/agent/NeighborCacheEntry.h"
+#include "fboss/agent/RxPacket.h"
+#include "fboss/agent/SwitchStats.h"
+#include "fboss/agent/TxPacket.h"
 
 #include <chrono>
 #include <folly/Memory.h>
 #include <folly/MacAddress.h>
 #include <folly/IPAddress.h>
+#include <folly/Optional.h>
+#include <folly/io/Cursor.h>
 #include <folly/io/async/EventBase.h>
 #include <list>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace facebook { namespace fboss {
 
 /*
  * This class manages the sw state of the neighbor tables. All of the
- * actual work is done by NeighborCacheImpl. This class is used to
- * provide the locking for those calls. All calls into the cache should
- * go through this class and SHOULD NOT call into the NeighborCacheImpl
- * directly. NeighborCacheImpl assumes that it does not need to worry
- * about synchronization because of this.
+ * actual work is done by NeighborCacheImpl. All calls into the cache
+ * should go through this class and SHOULD NOT call into the
+ * NeighborCacheImpl directly. Synchronization is handled inside
+ * NeighborCacheImpl, which shards its entry map by IP hash and guards
+ * each shard with its own lock, so operations on different entries
+ * rarely contend and table dumps never stall the whole cache.
  *
  * This class wraps the common logic for a NeighborCache. It is meant to be
  * extended for ARP/NDP specific caches.
@@ -43,12 +52,80 @@ class NeighborCache {
   virtual ~NeighborCache() {}
 
   bool flushEntryBlocking (AddressType ip) {
-    std::lock_guard<std::mutex> g(cacheLock_);
+    dropPendingPackets(ip);
     return impl_->flushEntryBlocking(ip);
   }
 
+  /*
+   * Returns true if a solicitation for ip should actually be sent,
+   * registering it as in flight. If one was already sent within the
+   * retry window this returns false and the caller should skip the
+   * send; the cache's own probe timers take care of retransmission.
+   */
+  bool shouldSolicit(AddressType ip) {
+    constexpr std::chrono::seconds kRetryWindow(1);
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> g(solicitLock_);
+    auto& inflight = inflight_[ip];
+    if (now - inflight.lastSolicited < kRetryWindow) {
+      return false;
+    }
+    inflight.lastSolicited = now;
+    return true;
+  }
+
+  /*
+   * Hold on to a copy of a packet that could not be forwarded because
+   * ip is still unresolved. The queue is bounded per neighbor; once the
+   * neighbor resolves the queued packets are re-injected into the
+   * switched path instead of being lost.
+   */
+  void queuePacketForResolution(AddressType ip, const RxPacket* pkt) {
+    std::lock_guard<std::mutex> g(solicitLock_);
+    auto& inflight = inflight_[ip];
+    if (inflight.pendingPackets.size() >= kMaxPendingPacketsPerNeighbor) {
+      sw_->stats()->pendingNeighborPktDropped();
+      return;
+    }
+    // Deep copy the frame into a TxPacket: the rx buffer goes back to
+    // the rx ring as soon as the caller's RxPacket is destroyed.
+    auto txPkt = sw_->allocatePacket(pkt->getLength());
+    folly::io::Cursor in(pkt->buf());
+    folly::io::RWPrivateCursor out(txPkt->buf());
+    uint32_t remaining = pkt->getLength();
+    while (remaining > 0) {
+      auto segment = in.peek();
+      auto n = std::min<uint32_t>(segment.second, remaining);
+      out.push(segment.first, n);
+      in.skip(n);
+      remaining -= n;
+    }
+    inflight.pendingPackets.push_back(std::move(txPkt));
+  }
+
+  /*
+   * Hold on to a host-originated L3 packet that could not be framed
+   * because ip is still unresolved. Unlike the switched-path copies
+   * above, these packets have no L2 header yet; once the neighbor
+   * resolves they are re-sent through sendL3Packet(), which can then
+   * fill in the neighbor's mac address. Shares the per-neighbor bound
+   * with the switched-path queue.
+   */
+  void queueL3PacketForResolution(AddressType ip,
+                                  std::unique_ptr<TxPacket> pkt,
+                                  folly::Optional<InterfaceID> ifID) {
+    std::lock_guard<std::mutex> g(solicitLock_);
+    auto& inflight = inflight_[ip];
+    if (inflight.pendingPackets.size() + inflight.pendingL3Packets.size() >=
+        kMaxPendingPacketsPerNeighbor) {
+      sw_->stats()->pendingNeighborPktDropped();
+      return;
+    }
+    inflight.pendingL3Packets.push_back(
+        PendingL3Packet{std::move(pkt), ifID});
+  }
+
   void repopulate(std::shared_ptr<NTable> table) {
-    std::lock_guard<std::mutex> g(cacheLock_);
     impl_->repopulate(table);
   }
 
@@ -61,13 +138,11 @@ class NeighborCache {
   }
 
   void portDown(PortID port) {
-    std::lock_guard<std::mutex> g(cacheLock_);
     impl_->portDown(port);
   }
 
   template <typename NeighborEntryThrift>
   std::list<NeighborEntryThrift> getCacheData() {
-    std::lock_guard<std::mutex> g(cacheLock_);
     return impl_->template getCacheData<NeighborEntryThrift>();
   }
 
@@ -84,9 +159,53 @@ class NeighborCache {
   }
 
   void clearEntries() {
+    dropAllPendingPackets();
     impl_->clearEntries();
   }
  protected:
+  /*
+   * Called by subclasses once ip has resolved. Re-injects any packets
+   * queued for the neighbor and clears the in-flight solicitation
+   * state. The entry itself has only been scheduled into the
+   * SwitchState at this point, so the packets ride a no-op state update
+   * through the (FIFO) update queue and are transmitted once the
+   * hardware has actually been programmed and can forward them.
+   */
+  void flushPendingPackets(AddressType ip) {
+    std::vector<std::unique_ptr<TxPacket>> pkts;
+    std::vector<PendingL3Packet> l3Pkts;
+    {
+      std::lock_guard<std::mutex> g(solicitLock_);
+      auto it = inflight_.find(ip);
+      if (it == inflight_.end()) {
+        return;
+      }
+      pkts.swap(it->second.pendingPackets);
+      l3Pkts.swap(it->second.pendingL3Packets);
+      inflight_.erase(it);
+    }
+    if (pkts.empty() && l3Pkts.empty()) {
+      return;
+    }
+    auto sw = sw_;
+    auto sharedPkts = std::make_shared<std::vector<std::unique_ptr<TxPacket>>>(
+        std::move(pkts));
+    auto sharedL3Pkts = std::make_shared<std::vector<PendingL3Packet>>(
+        std::move(l3Pkts));
+    sw_->updateStateFuture(
+        "flush packets pending neighbor resolution",
+        [](const std::shared_ptr<SwitchState>&) { return nullptr; })
+      .then([sw, sharedPkts, sharedL3Pkts]() {
+        for (auto& pkt : *sharedPkts) {
+          sw->sendPacketSwitched(std::move(pkt));
+        }
+        // The entry rode the update queue ahead of us, so sendL3Packet()
+        // will find it in the state and frame these properly this time.
+        for (auto& l3Pkt : *sharedL3Pkts) {
+          sw->sendL3Packet(std::move(l3Pkt.pkt), l3Pkt.ifID);
+        }
+      });
+  }
   // protected constructor since this is only meant to be inherited from
   NeighborCache(SwSwitch* sw,
                 VlanID vlanID,
@@ -104,7 +223,6 @@ class NeighborCache {
 
   // Methods useful for subclasses
   void setPendingEntry(AddressType ip) {
-    std::lock_guard<std::mutex> g(cacheLock_);
     impl_->setPendingEntry(ip);
   }
 
@@ -112,7 +230,6 @@ class NeighborCache {
                         folly::MacAddress mac,
                         PortID port,
                         NeighborEntryState state) {
-    std::lock_guard<std::mutex> g(cacheLock_);
     impl_->setExistingEntry(ip, mac, port, state);
   }
 
@@ -120,19 +237,16 @@ class NeighborCache {
                 folly::MacAddress mac,
                 PortID port,
                 NeighborEntryState state) {
-    std::lock_guard<std::mutex> g(cacheLock_);
     impl_->setEntry(ip, mac, port, state);
   }
 
   void updateEntryState(AddressType ip,
                          NeighborEntryState state) {
-    std::lock_guard<std::mutex> g(cacheLock_);
     impl_->updateEntryState(ip, state);
   }
 
   std::unique_ptr<typename NeighborCacheImpl<NTable>::EntryFields>
   cloneEntryFields(AddressType ip) {
-    std::lock_guard<std::mutex> g(cacheLock_);
     // this intentionally makes a copy so that callers do not have a
     // reference to memory that could be deleted.
     return impl_->cloneEntryFields(ip);
@@ -169,18 +283,53 @@ class NeighborCache {
 
 
  private:
-  // This should only be called by a NeighborCacheEntry
-  virtual void probeFor(AddressType ip) const {
-    LOG(DFATAL) << " Only derived class probeFor should ever be called";
+  // This should only be called by a NeighborCacheEntry. The probe
+  // packet builder is selected at compile time per table type (ARP
+  // request vs NDP neighbor solicitation), see
+  // ncachehelpers::ProbeSender.
+  void probeFor(AddressType ip) const {
+    auto vlan = sw_->getState()->getVlans()->getVlanIf(getVlanID());
+    if (!vlan) {
+      VLOG(2) << "Vlan " << getVlanID() << " not found. Skip sending probe";
+      return;
+    }
+    ncachehelpers::ProbeSender<NTable>::send(sw_, vlan, ip);
   }
 
   void flushEntry(AddressType ip) {
-    std::lock_guard<std::mutex> g(cacheLock_);
+    // The neighbor never resolved, so any packets waiting on it will
+    // never become sendable.
+    dropPendingPackets(ip);
     return impl_->flushEntry(ip);
   }
 
+  void dropPendingPackets(AddressType ip) {
+    std::lock_guard<std::mutex> g(solicitLock_);
+    auto it = inflight_.find(ip);
+    if (it == inflight_.end()) {
+      return;
+    }
+    auto numDropped =
+        it->second.pendingPackets.size() + it->second.pendingL3Packets.size();
+    for (size_t i = 0; i < numDropped; ++i) {
+      sw_->stats()->pendingNeighborPktDropped();
+    }
+    inflight_.erase(it);
+  }
+
+  void dropAllPendingPackets() {
+    std::lock_guard<std::mutex> g(solicitLock_);
+    for (const auto& inflight : inflight_) {
+      auto numDropped = inflight.second.pendingPackets.size() +
+          inflight.second.pendingL3Packets.size();
+      for (size_t i = 0; i < numDropped; ++i) {
+        sw_->stats()->pendingNeighborPktDropped();
+      }
+    }
+    inflight_.clear();
+  }
+
   void processEntry(AddressType ip) {
-    std::lock_guard<std::mutex> g(cacheLock_);
     return impl_->processEntry(ip);
   }
 
@@ -193,12 +342,38 @@ class NeighborCache {
   NeighborCache(NeighborCache const &) = delete;
   NeighborCache& operator=(NeighborCache const &) = delete;
 
+  // Upper bound on packets held per unresolved neighbor
+  static constexpr size_t kMaxPendingPacketsPerNeighbor = 16;
+
+  // A host-originated packet waiting on resolution, still without its
+  // L2 header; re-sent through sendL3Packet() once the neighbor is known
+  struct PendingL3Packet {
+    std::unique_ptr<TxPacket> pkt;
+    folly::Optional<InterfaceID> ifID;
+  };
+
+  // Dedup state for an unresolved neighbor: when we last sent a
+  // solicitation for it and the packets waiting on its resolution
+  struct InflightSolicitation {
+    std::chrono::steady_clock::time_point lastSolicited;
+    std::vector<std::unique_ptr<TxPacket>> pendingPackets;
+    std::vector<PendingL3Packet> pendingL3Packets;
+  };
+
   SwSwitch* sw_;
   std::chrono::seconds timeout_;
   uint32_t maxNeighborProbes_{0};
   std::chrono::seconds staleEntryInterval_;
   std::unique_ptr<NeighborCacheImpl<NTable>> impl_;
-  std::mutex cacheLock_;
+
+  // In-flight solicitations, keyed by target IP. This is intentionally
+  // separate from the entry map in impl_: it only ever holds the small
+  // set of neighbors currently being resolved. Probed per packet while
+  // a neighbor resolves, so it uses the fixed-width AddressUtil kernels
+  // like the entry map does.
+  std::mutex solicitLock_;
+  std::unordered_map<AddressType, InflightSolicitation,
+                     AddressHashFast, AddressEqualFast> inflight_;
 };
 
 }} // facebook::fboss
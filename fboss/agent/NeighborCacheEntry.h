@@ -19,6 +19,7 @@
 #include <folly/MacAddress.h>
 #include <folly/IPAddress.h>
 #include <folly/Random.h>
+#include <folly/io/async/HHWheelTimer.h>
 
 /**
  * This class implements much of the neighbor resolution and unreachable
@@ -55,11 +56,15 @@
  * next update is scheduled. If the entry ever transitions to the EXPIRED state,
  * we do not schedule another update and the cache will flush the entry.
  *
+ * Timeouts are scheduled on a single timer wheel shared by all entries in a
+ * cache, rather than each entry being its own kernel-armed timer, so a cache
+ * with tens of thousands of entries still only arms one timeout at a time.
+ *
  * There is no locking in this class. Instead, the class relies on the
- * synchronization provided by NeighborCache, which should lock around all calls
- * into the cache with a single cache level lock. This class should take care
- * not to call into NeighborCache functions multiple times, as this will likely
- * cause a deadlock.
+ * synchronization provided by NeighborCacheImpl, which locks the shard for
+ * this entry's IP around all calls into the cache. This class should take
+ * care not to call into NeighborCache functions multiple times, as this will
+ * likely cause a deadlock.
  */
 namespace facebook { namespace fboss {
 
@@ -77,7 +82,7 @@ enum class NeighborEntryState : uint8_t {
 template <typename NTable> class NeighborCache;
 
 template <typename NTable>
-class NeighborCacheEntry : private folly::AsyncTimeout {
+class NeighborCacheEntry : private folly::HHWheelTimer::Callback {
  public:
   typedef typename NTable::Entry::AddressType AddressType;
   typedef NeighborCache<NTable> Cache;
@@ -85,12 +90,13 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
   typedef NeighborEntryFields<AddressType> EntryFields;
   NeighborCacheEntry(EntryFields fields,
                      folly::EventBase* evb,
+                     folly::HHWheelTimer* timer,
                      Cache* cache,
                      NeighborEntryState state)
-      : AsyncTimeout(evb),
-        fields_(fields),
+      : fields_(fields),
         cache_(cache),
         evb_(evb),
+        timer_(timer),
         probesLeft_(cache_->getMaxNeighborProbes()) {
     enter(state);
   }
@@ -100,18 +106,21 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
                      PortID port,
                      InterfaceID intf,
                      folly::EventBase* evb,
+                     folly::HHWheelTimer* timer,
                      Cache* cache,
                      NeighborEntryState state)
       : NeighborCacheEntry(EntryFields(ip, mac, port, intf),
-                           evb, cache, state) {}
+                           evb, timer, cache, state) {}
 
   NeighborCacheEntry(AddressType ip,
                      InterfaceID intf,
                      NeighborState ignored,
                      folly::EventBase* evb,
+                     folly::HHWheelTimer* timer,
                      Cache* cache)
       : NeighborCacheEntry(EntryFields(ip, intf, ignored),
-                           evb, cache, NeighborEntryState::INCOMPLETE) {}
+                           evb, timer, cache,
+                           NeighborEntryState::INCOMPLETE) {}
 
   ~NeighborCacheEntry() {}
 
@@ -205,7 +214,9 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
 
   template <typename NeighborEntryThrift>
   void populateThriftEntry(NeighborEntryThrift& entry) const {
-    entry.ip = facebook::network::toBinaryAddress(getIP());
+    // getIP() is already the fixed-width address type, so convert
+    // without bouncing through the generic folly::IPAddress
+    entry.ip = facebook::network::toBinaryAddressImpl(getIP());
     entry.mac = getMac().toString();
     entry.port = getPortID();
     entry.vlanName = cache_->getVlanName();
@@ -220,10 +231,17 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
    * responsible for serializing this with other flush or rx events to prevent
    * races.
    */
-  virtual void timeoutExpired() noexcept {
+  virtual void timeoutExpired() noexcept override {
     cache_->processEntry(getIP());
   }
 
+  /*
+   * Schedule this entry's next update on the shared timer wheel.
+   */
+  void scheduleTimeout(std::chrono::milliseconds timeout) {
+    timer_->scheduleTimeout(this, timeout);
+  }
+
   /*
    * Schedules an update on the evb_. This is done synchronously so that we
    * can have a destructor guard around both running the state machine and
@@ -243,7 +261,7 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
         break;
       case NeighborEntryState::PROBE:
       case NeighborEntryState::INCOMPLETE:
-        scheduleTimeout(std::chrono::seconds(1));
+        scheduleTimeout(probeInterval());
         break;
       case NeighborEntryState::EXPIRED:
         // This entry is expired and is already flushed. Don't schedule a
@@ -271,6 +289,16 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
     return std::chrono::milliseconds(lifetime);
   }
 
+  /*
+   * Calculates the retransmit interval for a probing entry.  With a fixed
+   * interval, the probes for all entries that went stale around the same
+   * time (e.g. after a restart) fire in synchronized waves forever, so
+   * jitter the interval +/- 10% to spread the waves out.
+   */
+  std::chrono::milliseconds probeInterval() const {
+    return std::chrono::milliseconds(900 + folly::Random::rand32(200));
+  }
+
   bool hasProbesLeft() const {
     return probesLeft_ > 0;
   }
@@ -393,6 +421,9 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
   // Additional state kept per cache entry.
   Cache* cache_;
   folly::EventBase* evb_;
+  // The timer wheel shared by all entries in the cache.  Owned by the
+  // NeighborCacheImpl, which outlives the entries.
+  folly::HHWheelTimer* timer_;
   NeighborEntryState state_{NeighborEntryState::UNINITIALIZED};
   uint8_t probesLeft_{0};
   std::chrono::time_point<std::chrono::steady_clock> expireTime_;
@@ -57,6 +57,34 @@ bool checkVlanAndIntf(
   return true;
 }
 
+/*
+ * Family-specific probe packet builders, selected at compile time per
+ * table type instead of through a virtual dispatch at probe time. The
+ * ARP instantiation only ever builds ARP requests and the NDP one only
+ * neighbor solicitations, so nothing on the probe path inspects the
+ * address family at runtime.
+ */
+template <typename NTable>
+struct ProbeSender;
+
+template <>
+struct ProbeSender<ArpTable> {
+  static void send(SwSwitch* sw,
+                   const std::shared_ptr<Vlan>& vlan,
+                   folly::IPAddressV4 ip) {
+    ArpHandler::sendArpRequest(sw, vlan, ip);
+  }
+};
+
+template <>
+struct ProbeSender<NdpTable> {
+  static void send(SwSwitch* sw,
+                   const std::shared_ptr<Vlan>& vlan,
+                   folly::IPAddressV6 ip) {
+    IPv6Handler::sendNeighborSolicitation(sw, ip, vlan);
+  }
+};
+
 }
 
 template <typename NTable>
@@ -146,6 +174,13 @@ void NeighborCacheImpl<NTable>::programPendingEntry(Entry* entry, bool force) {
 template <typename NTable>
 NeighborCacheImpl<NTable>::~NeighborCacheImpl() {
   clearEntries();
+
+  // The timer wheel must be destroyed on the background thread, after all
+  // of the entries have cancelled their timeouts.
+  auto evb = sw_->getBackgroundEVB();
+  evb->runInEventBaseThreadAndWait([this]() {
+    timer_.reset();
+  });
 }
 
 template <typename NTable>
@@ -154,12 +189,22 @@ void NeighborCacheImpl<NTable>::clearEntries() {
    * the background thread. Because we do not want to exit
    * the destructor until all of the entries have stopped
    * executing, we use folly futures to wait for all entries
-   * to destroy themselves.
+   * to destroy themselves. The wait happens with no shard lock
+   * held so that entries currently executing on the background
+   * thread can finish up.
    */
+  std::vector<std::shared_ptr<Entry>> toDestroy;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> g(shard.lock);
+    for (auto& item : shard.entries) {
+      toDestroy.push_back(std::move(item.second));
+    }
+    shard.entries.clear();
+  }
+
   std::vector<folly::Future<folly::Unit>> stopTasks;
-  for (auto item : entries_) {
-    auto addr = item.first;
-    auto entry = item.second;
+  for (auto& entry : toDestroy) {
+    auto addr = entry->getIP();
     stopTasks.push_back(
         Entry::destroy(std::move(entry), sw_->getBackgroundEVB())
             .onError([=](const std::exception& e) {
@@ -168,7 +213,6 @@ void NeighborCacheImpl<NTable>::clearEntries() {
             }));
   }
   folly::collectAll(stopTasks).get();
-  entries_.clear();
 }
 
 template <typename NTable>
@@ -177,6 +221,7 @@ void NeighborCacheImpl<NTable>::repopulate(std::shared_ptr<NTable> table) {
     auto entry = *it;
     auto state = entry->isPending() ? NeighborEntryState::INCOMPLETE :
       NeighborEntryState::STALE;
+    std::lock_guard<std::mutex> g(shardFor(entry->getIP()).lock);
     setEntryInternal(*entry->getFields(), state);
   }
 }
@@ -186,6 +231,7 @@ void NeighborCacheImpl<NTable>::setEntry(AddressType ip,
                                          folly::MacAddress mac,
                                          PortID portID,
                                          NeighborEntryState state) {
+  std::lock_guard<std::mutex> g(shardFor(ip).lock);
   auto entry = setEntryInternal(
     EntryFields(ip, mac, portID, intfID_), state);
   if (entry) {
@@ -198,6 +244,7 @@ void NeighborCacheImpl<NTable>::setExistingEntry(AddressType ip,
                                                  folly::MacAddress mac,
                                                  PortID portID,
                                                  NeighborEntryState state) {
+  std::lock_guard<std::mutex> g(shardFor(ip).lock);
   auto entry = setEntryInternal(
     EntryFields(ip, mac, portID, intfID_), state, false);
   if (entry) {
@@ -209,6 +256,7 @@ void NeighborCacheImpl<NTable>::setExistingEntry(AddressType ip,
 template <typename NTable>
 void NeighborCacheImpl<NTable>::updateEntryState(AddressType ip,
                                                  NeighborEntryState state) {
+  std::lock_guard<std::mutex> g(shardFor(ip).lock);
   auto entry = getCacheEntry(ip);
   if (entry) {
     entry->updateState(state);
@@ -230,7 +278,8 @@ NeighborCacheEntry<NTable>* NeighborCacheImpl<NTable>::setEntryInternal(
     return changed ? entry : nullptr;
   } else if (add) {
     auto evb = sw_->getBackgroundEVB();
-    auto to_store = std::make_shared<Entry>(fields, evb, cache_, state);
+    auto to_store = std::make_shared<Entry>(fields, evb, timer_.get(), cache_,
+                                            state);
     entry = to_store.get();
     setCacheEntry(std::move(to_store));
   }
@@ -240,6 +289,13 @@ NeighborCacheEntry<NTable>* NeighborCacheImpl<NTable>::setEntryInternal(
 template <typename NTable>
 void NeighborCacheImpl<NTable>::setPendingEntry(AddressType ip,
                                                 bool force) {
+  std::lock_guard<std::mutex> g(shardFor(ip).lock);
+  setPendingEntryInternal(ip, force);
+}
+
+template <typename NTable>
+void NeighborCacheImpl<NTable>::setPendingEntryInternal(AddressType ip,
+                                                        bool force) {
   if (!force && getCacheEntry(ip)) {
     // only overwrite an existing entry with a pending entry if we say it is
     // ok with the 'force' parameter
@@ -256,11 +312,12 @@ void NeighborCacheImpl<NTable>::setPendingEntry(AddressType ip,
 
 template <typename NTable>
 void NeighborCacheImpl<NTable>::processEntry(AddressType ip) {
+  std::lock_guard<std::mutex> g(shardFor(ip).lock);
   auto entry = getCacheEntry(ip);
   if (entry) {
     entry->process();
     if (entry->getState() == NeighborEntryState::EXPIRED) {
-      flushEntry(ip);
+      flushEntryInternal(ip, nullptr);
     }
   }
 }
@@ -268,8 +325,9 @@ void NeighborCacheImpl<NTable>::processEntry(AddressType ip) {
 template <typename NTable>
 NeighborCacheEntry<NTable>* NeighborCacheImpl<NTable>::getCacheEntry(
     AddressType ip) const {
-  auto it = entries_.find(ip);
-  if (it != entries_.end()) {
+  const auto& entries = shardFor(ip).entries;
+  auto it = entries.find(ip);
+  if (it != entries.end()) {
     return it->second.get();
   }
   return nullptr;
@@ -278,13 +336,14 @@ NeighborCacheEntry<NTable>* NeighborCacheImpl<NTable>::getCacheEntry(
 template <typename NTable>
 void NeighborCacheImpl<NTable>::setCacheEntry(std::shared_ptr<Entry> entry) {
   const auto& ip = entry->getIP();
-  entries_[ip] = std::move(entry);
+  shardFor(ip).entries[ip] = std::move(entry);
 }
 
 template <typename NTable>
 bool NeighborCacheImpl<NTable>::removeEntry(AddressType ip) {
-  auto it = entries_.find(ip);
-  if (it == entries_.end()) {
+  auto& entries = shardFor(ip).entries;
+  auto it = entries.find(ip);
+  if (it == entries.end()) {
     return false;
   }
 
@@ -295,7 +354,7 @@ bool NeighborCacheImpl<NTable>::removeEntry(AddressType ip) {
   // around in a shared_ptr for a bit longer and then destroy it later.
   Entry::destroy(std::move(it->second), sw_->getBackgroundEVB());
 
-  entries_.erase(it);
+  entries.erase(it);
 
   return true;
 }
@@ -322,12 +381,20 @@ bool NeighborCacheImpl<NTable>::flushEntryFromSwitchState(
 template <typename NTable>
 bool NeighborCacheImpl<NTable>::flushEntryBlocking(AddressType ip) {
   bool flushed{false};
-  flushEntry(ip, &flushed);
+  std::lock_guard<std::mutex> g(shardFor(ip).lock);
+  flushEntryInternal(ip, &flushed);
   return flushed;
 }
 
 template <typename NTable>
 void NeighborCacheImpl<NTable>::flushEntry(AddressType ip, bool* flushed) {
+  std::lock_guard<std::mutex> g(shardFor(ip).lock);
+  flushEntryInternal(ip, flushed);
+}
+
+template <typename NTable>
+void NeighborCacheImpl<NTable>::flushEntryInternal(AddressType ip,
+                                                   bool* flushed) {
   // remove from cache
   if (!removeEntry(ip)) {
     return;
@@ -347,18 +414,24 @@ void NeighborCacheImpl<NTable>::flushEntry(AddressType ip, bool* flushed) {
     return nullptr;
   };
 
+  // Neighbor flushes are typically fixing the dataplane (an operator
+  // evicting a stale entry), so they must not wait behind bulk work
+  // such as a FIB sync.
   if (flushed) {
     // need a blocking state update if the caller wants to know if an entry
     // was actually flushed
-    sw_->updateStateBlocking("flush neighbor entry", std::move(updateFn));
+    sw_->updateStateBlocking("flush neighbor entry", std::move(updateFn),
+                             StateUpdate::Priority::URGENT);
   } else {
-    sw_->updateState("remove neighbor entry", std::move(updateFn));
+    sw_->updateState("remove neighbor entry", std::move(updateFn),
+                     StateUpdate::Priority::URGENT);
   }
 }
 
 template <typename NTable>
 std::unique_ptr<typename NeighborCacheImpl<NTable>::EntryFields>
 NeighborCacheImpl<NTable>::cloneEntryFields(AddressType ip) {
+  std::lock_guard<std::mutex> g(shardFor(ip).lock);
   auto entry = getCacheEntry(ip);
   if (entry) {
     return std::make_unique<EntryFields>(entry->getFields());
@@ -368,20 +441,23 @@ NeighborCacheImpl<NTable>::cloneEntryFields(AddressType ip) {
 
 template <typename NTable>
 void NeighborCacheImpl<NTable>::portDown(PortID port) {
-  for (auto item : entries_) {
-    if (item.second->getPortID() != port) {
-      continue;
-    }
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> g(shard.lock);
+    for (auto item : shard.entries) {
+      if (item.second->getPortID() != port) {
+        continue;
+      }
 
-    // TODO(aeckert): It would be nicer if we could just mark this
-    // entry stale on port down so we don't need to unprogram the
-    // entry (for fast port flaps).  However, we have seen packet
-    // losses if we start forwarding packets on a port up event before
-    // we receive a neighbor reply so it may not be worth leaving it
-    // programmed. Also we need to notify the HwSwitch for ECMP expand
-    // when the port comes back up and changing an entry from pending
-    // to reachable is how we currently do this.
-    setPendingEntry(item.second->getIP(), true);
+      // TODO(aeckert): It would be nicer if we could just mark this
+      // entry stale on port down so we don't need to unprogram the
+      // entry (for fast port flaps).  However, we have seen packet
+      // losses if we start forwarding packets on a port up event before
+      // we receive a neighbor reply so it may not be worth leaving it
+      // programmed. Also we need to notify the HwSwitch for ECMP expand
+      // when the port comes back up and changing an entry from pending
+      // to reachable is how we currently do this.
+      setPendingEntryInternal(item.second->getIP(), true);
+    }
   }
 }
 
@@ -389,10 +465,17 @@ template <typename NTable>
 template <typename NeighborEntryThrift>
 std::list<NeighborEntryThrift> NeighborCacheImpl<NTable>::getCacheData() const {
   std::list<NeighborEntryThrift> thriftEntries;
-  for (const auto& item : entries_) {
-    NeighborEntryThrift thriftEntry;
-    item.second->populateThriftEntry(thriftEntry);
-    thriftEntries.push_back(thriftEntry);
+  // Snapshot one shard at a time. A dump sees each shard atomically but
+  // not the cache as a whole, and only ever holds one of the shard locks,
+  // so dumping a large table no longer stalls entry processing for the
+  // whole cache.
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> g(shard.lock);
+    for (const auto& item : shard.entries) {
+      NeighborEntryThrift thriftEntry;
+      item.second->populateThriftEntry(thriftEntry);
+      thriftEntries.push_back(thriftEntry);
+    }
   }
   return thriftEntries;
 }
@@ -9,17 +9,21 @@
  */
 #pragma once
 
+#include "fboss/agent/AddressUtil.h"
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/types.h"
 #include "fboss/agent/NeighborCacheEntry.h"
 #include "fboss/agent/state/NeighborEntry.h"
 
+#include <array>
 #include <chrono>
 #include <folly/MacAddress.h>
 #include <folly/IPAddress.h>
 #include <folly/Random.h>
+#include <folly/io/async/HHWheelTimer.h>
 #include <list>
+#include <mutex>
 #include <string>
 
 namespace facebook { namespace fboss {
@@ -34,9 +38,12 @@ template <typename NTable> class NeighborCache;
  * information and manage the logic for NDP-like expiration and unreachable
  * neighbor detection.
  *
- * All calls into this should have acquired a cache level lock through
- * NeighborCache so only one thread should ever be operating on the
- * cache at a given time.
+ * The entry map is sharded by IP hash and each shard is guarded by its
+ * own lock, acquired by the public methods here. Operations on entries
+ * whose IPs hash to different shards never contend, and whole-cache
+ * operations such as getCacheData() only ever hold one shard lock at a
+ * time. Callers should go through NeighborCache and must not do any
+ * locking of their own.
  */
 template <typename NTable>
 class NeighborCacheImpl {
@@ -60,7 +67,9 @@ class NeighborCacheImpl {
         sw_(sw),
         vlanID_(vlanID),
         vlanName_(vlanName),
-        intfID_(intfID) {}
+        intfID_(intfID),
+        timer_(new folly::HHWheelTimer(sw->getBackgroundEVB(),
+                                       std::chrono::milliseconds(100))) {}
 
   // Methods useful for subclasses
   void setPendingEntry(AddressType ip,
@@ -115,6 +124,25 @@ class NeighborCacheImpl {
 
   void clearEntries();
  private:
+  // Number of shards the entry map is split into. Must be a power of two.
+  static constexpr size_t kShards = 16;
+
+  struct Shard {
+    // mutable so the read-only paths (getCacheData) can lock as well
+    mutable std::mutex lock;
+    // Hashed and compared with the fixed-width AddressUtil kernels;
+    // these maps are probed for every trapped packet
+    std::unordered_map<AddressType, std::shared_ptr<Entry>,
+                       AddressHashFast, AddressEqualFast> entries;
+  };
+
+  Shard& shardFor(const AddressType& ip) {
+    return shards_[AddressHashFast()(ip) & (kShards - 1)];
+  }
+  const Shard& shardFor(const AddressType& ip) const {
+    return shards_[AddressHashFast()(ip) & (kShards - 1)];
+  }
+
   // These are used to program entries into the SwitchState
   void programEntry(Entry* entry);
   void programPendingEntry(Entry* entry, bool force = false);
@@ -125,6 +153,11 @@ class NeighborCacheImpl {
   // was actually flushed from the switch state
   void flushEntry (AddressType ip, bool* flushed = nullptr);
 
+  // Versions of the above that expect the caller to already hold the
+  // shard lock for ip
+  void setPendingEntryInternal(AddressType ip, bool force);
+  void flushEntryInternal(AddressType ip, bool* flushed);
+
   bool flushEntryFromSwitchState(std::shared_ptr<SwitchState>* state,
                                  AddressType ip);
 
@@ -146,8 +179,14 @@ class NeighborCacheImpl {
   std::string vlanName_;
   InterfaceID intfID_;
 
-  // Map of all entries
-  std::unordered_map<AddressType, std::shared_ptr<Entry>> entries_;
+  // The timer wheel that all of this cache's entries schedule their
+  // expirations on.  A single wheel arms one timeout at a time no matter
+  // how many entries are waiting, instead of one kernel timer per entry.
+  // It is only used (and destroyed) on the background event base thread.
+  folly::HHWheelTimer::UniquePtr timer_;
+
+  // All entries, sharded by IP hash
+  std::array<Shard, kShards> shards_;
 };
 
 }} // facebook::fboss
@@ -0,0 +1,149 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/NeighborResponseIndex.h"
+
+#include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/state/ArpResponseTable.h"
+#include "fboss/agent/state/NdpResponseTable.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+
+#include <folly/Bits.h>
+
+namespace facebook { namespace fboss {
+
+template <typename AddrT>
+size_t NeighborResponseIndex::Table<AddrT>::hashKey(VlanID vlan,
+                                                    const AddrT& ip) {
+  return hashFast(ip) ^ folly::hash::twang_mix64(vlan);
+}
+
+template <typename AddrT>
+void NeighborResponseIndex::Table<AddrT>::reserve(size_t entries) {
+  // Keep the table at most half full so probe sequences stay short
+  size_t size = folly::nextPowTwo(std::max<size_t>(entries * 2, 1));
+  slots_.clear();
+  slots_.resize(size);
+  mask_ = size - 1;
+}
+
+template <typename AddrT>
+void NeighborResponseIndex::Table<AddrT>::insert(
+    VlanID vlan,
+    const AddrT& ip,
+    const NeighborResponseEntry& entry) {
+  size_t idx = hashKey(vlan, ip) & mask_;
+  while (slots_[idx].used) {
+    idx = (idx + 1) & mask_;
+  }
+  slots_[idx].ip = ip;
+  slots_[idx].entry = entry;
+  slots_[idx].vlan = vlan;
+  slots_[idx].used = true;
+}
+
+template <typename AddrT>
+const NeighborResponseEntry* NeighborResponseIndex::Table<AddrT>::lookup(
+    VlanID vlan,
+    const AddrT& ip) const {
+  if (slots_.empty()) {
+    return nullptr;
+  }
+  size_t idx = hashKey(vlan, ip) & mask_;
+  while (slots_[idx].used) {
+    if (slots_[idx].vlan == vlan && equalsFast(slots_[idx].ip, ip)) {
+      return &slots_[idx].entry;
+    }
+    idx = (idx + 1) & mask_;
+  }
+  return nullptr;
+}
+
+NeighborResponseIndex::NeighborResponseIndex(SwSwitch* sw)
+    : AutoRegisterStateObserver(sw, "NeighborResponseIndex",
+                                INTEREST_VLANS) {}
+
+NeighborResponseIndex::~NeighborResponseIndex() {}
+
+void NeighborResponseIndex::stateUpdated(const StateDelta& delta) {
+  // The vlan section also holds the neighbor tables, which churn with
+  // every resolution; only rebuild when a response table itself was
+  // replaced, which happens on config application.
+  for (const auto& entry : delta.getVlansDelta()) {
+    const auto& oldVlan = entry.getOld();
+    const auto& newVlan = entry.getNew();
+    if (!oldVlan || !newVlan ||
+        oldVlan->getArpResponseTable() != newVlan->getArpResponseTable() ||
+        oldVlan->getNdpResponseTable() != newVlan->getNdpResponseTable()) {
+      rebuildIndex(delta.newState());
+      return;
+    }
+  }
+}
+
+void NeighborResponseIndex::rebuildIndex(
+    const std::shared_ptr<SwitchState>& state) {
+  auto index = std::make_shared<Index>();
+
+  size_t numV4{0};
+  size_t numV6{0};
+  for (const auto& vlan : *state->getVlans()) {
+    numV4 += vlan->getArpResponseTable()->getTable().size();
+    numV6 += vlan->getNdpResponseTable()->getTable().size();
+  }
+  index->v4.reserve(numV4);
+  index->v6.reserve(numV6);
+
+  for (const auto& vlan : *state->getVlans()) {
+    for (const auto& entry : vlan->getArpResponseTable()->getTable()) {
+      index->v4.insert(vlan->getID(), entry.first, entry.second);
+    }
+    for (const auto& entry : vlan->getNdpResponseTable()->getTable()) {
+      index->v6.insert(vlan->getID(), entry.first, entry.second);
+    }
+  }
+
+  folly::SpinLockGuard guard(lock_);
+  index_.swap(index);
+}
+
+std::shared_ptr<const NeighborResponseIndex::Index>
+NeighborResponseIndex::getIndex() const {
+  folly::SpinLockGuard guard(lock_);
+  return index_;
+}
+
+folly::Optional<NeighborResponseEntry> NeighborResponseIndex::lookup(
+    VlanID vlan,
+    folly::IPAddressV4 ip) const {
+  auto index = getIndex();
+  const NeighborResponseEntry* entry =
+      index ? index->v4.lookup(vlan, ip) : nullptr;
+  if (!entry) {
+    return folly::Optional<NeighborResponseEntry>();
+  }
+  return *entry;
+}
+
+folly::Optional<NeighborResponseEntry> NeighborResponseIndex::lookup(
+    VlanID vlan,
+    const folly::IPAddressV6& ip) const {
+  auto index = getIndex();
+  const NeighborResponseEntry* entry =
+      index ? index->v6.lookup(vlan, ip) : nullptr;
+  if (!entry) {
+    return folly::Optional<NeighborResponseEntry>();
+  }
+  return *entry;
+}
+
+}} // facebook::fboss
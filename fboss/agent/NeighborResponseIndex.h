@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <folly/IPAddressV4.h>
+#include <folly/IPAddressV6.h>
+#include <folly/Optional.h>
+#include <folly/SpinLock.h>
+
+#include "fboss/agent/StateObserver.h"
+#include "fboss/agent/state/NeighborResponseTable.h"
+#include "fboss/agent/types.h"
+
+namespace facebook { namespace fboss {
+
+class SwitchState;
+
+/*
+ * NeighborResponseIndex answers "should we respond to this ARP request
+ * or NDP solicitation, and with which MAC" with a single hash probe.
+ *
+ * The per-vlan ArpResponseTable/NdpResponseTable flat_maps are binary
+ * searched for every received request, which makes them the per-packet
+ * hot spot during address scanner sweeps. This class folds all vlans'
+ * response entries into one open-addressing hash table keyed by
+ * (vlan, IP). The entries are derived from the interface configuration,
+ * so the index only needs rebuilding on the rare state updates that
+ * replace a vlan's response table; readers snapshot the current table
+ * via shared_ptr and never block a rebuild.
+ */
+class NeighborResponseIndex : public AutoRegisterStateObserver {
+ public:
+  explicit NeighborResponseIndex(SwSwitch* sw);
+  ~NeighborResponseIndex() override;
+
+  void stateUpdated(const StateDelta& delta) override;
+
+  /*
+   * Look up the response entry for an IP on a vlan. Returns the same
+   * result as probing that vlan's response table directly.
+   */
+  folly::Optional<NeighborResponseEntry> lookup(
+      VlanID vlan, folly::IPAddressV4 ip) const;
+  folly::Optional<NeighborResponseEntry> lookup(
+      VlanID vlan, const folly::IPAddressV6& ip) const;
+
+ private:
+  /*
+   * Open-addressing hash table with linear probing, at most half full.
+   * A table is populated once during rebuildIndex() and immutable
+   * afterwards, so there are no tombstones and a probe always
+   * terminates at the first empty slot.
+   */
+  template <typename AddrT>
+  class Table {
+   public:
+    void reserve(size_t entries);
+    void insert(VlanID vlan, const AddrT& ip,
+                const NeighborResponseEntry& entry);
+    const NeighborResponseEntry* lookup(VlanID vlan, const AddrT& ip) const;
+
+   private:
+    struct Slot {
+      AddrT ip;
+      NeighborResponseEntry entry;
+      VlanID vlan{0};
+      bool used{false};
+    };
+    static size_t hashKey(VlanID vlan, const AddrT& ip);
+
+    std::vector<Slot> slots_;
+    size_t mask_{0};
+  };
+
+  struct Index {
+    Table<folly::IPAddressV4> v4;
+    Table<folly::IPAddressV6> v6;
+  };
+
+  // Forbidden copy constructor and assignment operator
+  NeighborResponseIndex(const NeighborResponseIndex&) = delete;
+  NeighborResponseIndex& operator=(const NeighborResponseIndex&) = delete;
+
+  void rebuildIndex(const std::shared_ptr<SwitchState>& state);
+  std::shared_ptr<const Index> getIndex() const;
+
+  std::shared_ptr<const Index> index_;
+  mutable folly::SpinLock lock_;
+};
+
+}} // facebook::fboss
@@ -0,0 +1,261 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/NeighborResponseTemplates.h"
+
+#include <cstring>
+
+#include <glog/logging.h>
+
+#include "fboss/agent/ArpHandler.h"
+#include "fboss/agent/TxPacket.h"
+#include "fboss/agent/packet/Ethertype.h"
+#include "fboss/agent/packet/ICMPHdr.h"
+#include "fboss/agent/packet/IPProto.h"
+#include "fboss/agent/packet/IPv6Hdr.h"
+#include "fboss/agent/packet/NDP.h"
+#include "fboss/agent/packet/PktUtil.h"
+
+using folly::IPAddressV4;
+using folly::IPAddressV6;
+using folly::MacAddress;
+
+namespace {
+
+// Ethernet header with a VLAN tag
+enum : uint32_t {
+  kDstMacOffset = 0,
+  kSrcMacOffset = 6,
+  kEthHdrSize = 18,
+};
+
+// ARP payload, relative to the start of the frame
+enum : uint32_t {
+  kArpTargetMacOffset = kEthHdrSize + 18,
+  kArpTargetIPOffset = kEthHdrSize + 24,
+};
+
+enum : uint16_t {
+  ARP_HTYPE_ETHERNET = 1,
+  ARP_PTYPE_IPV4 = 0x0800,
+};
+
+enum : uint8_t {
+  ARP_HLEN_ETHERNET = 6,
+  ARP_PLEN_IPV4 = 4,
+};
+
+// IPv6 header and neighbor advertisement body, relative to the start of
+// the frame
+enum : uint32_t {
+  kNdpSrcIPOffset = kEthHdrSize + 8,
+  kNdpDstIPOffset = kEthHdrSize + 24,
+  kNdpIcmpOffset = kEthHdrSize + facebook::fboss::IPv6Hdr::SIZE,
+  kNdpCsumOffset = kNdpIcmpOffset + 2,
+  kNdpFlagsOffset = kNdpIcmpOffset + 4,
+  kNdpTargetIPOffset = kNdpFlagsOffset + 4,
+  kNdpOptionOffset = kNdpTargetIPOffset + 16,
+  // NDP flags (or reserved word) + target address + link-layer option
+  kNdpBodyLength = 4 + 16 + 8,
+  kNdpPayloadLength = facebook::fboss::ICMPHdr::SIZE + kNdpBodyLength,
+};
+
+uint8_t* writeMac(uint8_t* p, MacAddress mac) {
+  memcpy(p, mac.bytes(), MacAddress::SIZE);
+  return p + MacAddress::SIZE;
+}
+
+uint8_t* writeBE16(uint8_t* p, uint16_t value) {
+  p[0] = value >> 8;
+  p[1] = value & 0xff;
+  return p + 2;
+}
+
+// Add the given bytes to an internet checksum accumulator as big endian
+// 16 bit words. length must be even.
+uint32_t sumWords(const uint8_t* data, uint32_t length, uint32_t sum) {
+  DCHECK_EQ(length % 2, 0);
+  for (uint32_t idx = 0; idx < length; idx += 2) {
+    sum += (data[idx] << 8) | data[idx + 1];
+  }
+  return sum;
+}
+
+} // anonymous namespace
+
+namespace facebook { namespace fboss {
+
+ArpReplyTemplate::ArpReplyTemplate(VlanID vlan,
+                                   MacAddress senderMac,
+                                   IPAddressV4 senderIP) {
+  memset(frame_, 0, sizeof(frame_));
+  uint8_t* p = frame_;
+  p = writeMac(p, MacAddress::ZERO); // dst mac, patched per reply
+  p = writeMac(p, senderMac);
+  p = writeBE16(p, ETHERTYPE_VLAN);
+  p = writeBE16(p, vlan);
+  p = writeBE16(p, ArpHandler::ETHERTYPE_ARP);
+  p = writeBE16(p, ARP_HTYPE_ETHERNET);
+  p = writeBE16(p, ARP_PTYPE_IPV4);
+  *p++ = ARP_HLEN_ETHERNET;
+  *p++ = ARP_PLEN_IPV4;
+  p = writeBE16(p, ARP_OP_REPLY);
+  p = writeMac(p, senderMac);
+  memcpy(p, senderIP.bytes(), ARP_PLEN_IPV4);
+  p += ARP_PLEN_IPV4;
+  // The target MAC and IP are patched per reply; the rest of the frame
+  // stays zero padding up to the minimum packet length.
+  DCHECK_EQ(p - frame_, kArpTargetMacOffset);
+}
+
+void ArpReplyTemplate::writeReply(TxPacket* pkt,
+                                  MacAddress targetMac,
+                                  IPAddressV4 targetIP) const {
+  auto buf = pkt->buf();
+  DCHECK_GE(buf->length(), SIZE);
+  uint8_t* data = buf->writableData();
+  memcpy(data, frame_, SIZE);
+  memcpy(data + kDstMacOffset, targetMac.bytes(), MacAddress::SIZE);
+  memcpy(data + kArpTargetMacOffset, targetMac.bytes(), MacAddress::SIZE);
+  memcpy(data + kArpTargetIPOffset, targetIP.bytes(), ARP_PLEN_IPV4);
+}
+
+NdpAdvertisementTemplate::NdpAdvertisementTemplate(VlanID vlan,
+                                                   MacAddress srcMac,
+                                                   IPAddressV6 srcIP) {
+  memset(frame_, 0, sizeof(frame_));
+  uint8_t* p = frame_;
+  p = writeMac(p, MacAddress::ZERO); // dst mac, patched per advertisement
+  p = writeMac(p, srcMac);
+  p = writeBE16(p, ETHERTYPE_VLAN);
+  p = writeBE16(p, vlan);
+  p = writeBE16(p, ETHERTYPE_IPV6);
+  // version 6, traffic class CS7 (network control), flow label 0
+  *p++ = (IPV6_VERSION << 4) | (0xe0 >> 4);
+  *p++ = 0;
+  p = writeBE16(p, 0);
+  p = writeBE16(p, kNdpPayloadLength);
+  *p++ = IP_PROTO_IPV6_ICMP;
+  *p++ = 255; // hop limit
+  memcpy(p, srcIP.bytes(), IPAddressV6::byteCount());
+  p += IPAddressV6::byteCount();
+  p += IPAddressV6::byteCount(); // dst addr, patched per advertisement
+  *p++ = ICMPV6_TYPE_NDP_NEIGHBOR_ADVERTISEMENT;
+  *p++ = ICMPV6_CODE_NDP_MESSAGE_CODE;
+  p += 2; // checksum, patched per advertisement
+  p += 4; // flags, patched per advertisement
+  memcpy(p, srcIP.bytes(), IPAddressV6::byteCount()); // target address
+  p += IPAddressV6::byteCount();
+  *p++ = NDPOptionType::TARGET_LL_ADDRESS;
+  *p++ = NDPOptionLength::TARGET_LL_ADDRESS_IEEE802;
+  p = writeMac(p, srcMac);
+  DCHECK_EQ(p - frame_, SIZE);
+
+  // Precompute the checksum over everything that does not depend on the
+  // destination: the pseudo-header minus the destination address, the
+  // ICMPv6 type/code (the checksum field itself counts as zero), and the
+  // body minus the flags word.
+  uint32_t sum = kNdpPayloadLength + IP_PROTO_IPV6_ICMP;
+  sum = sumWords(frame_ + kNdpSrcIPOffset, IPAddressV6::byteCount(), sum);
+  sum = sumWords(frame_ + kNdpIcmpOffset, 2, sum);
+  sum = sumWords(frame_ + kNdpTargetIPOffset,
+                 IPAddressV6::byteCount() + 8, sum);
+  partialSum_ = sum;
+}
+
+void NdpAdvertisementTemplate::writeAdvertisement(
+    TxPacket* pkt,
+    MacAddress dstMac,
+    const IPAddressV6& dstIP,
+    uint32_t flags) const {
+  auto buf = pkt->buf();
+  DCHECK_GE(buf->length(), SIZE);
+  uint8_t* data = buf->writableData();
+  memcpy(data, frame_, SIZE);
+  memcpy(data + kDstMacOffset, dstMac.bytes(), MacAddress::SIZE);
+  memcpy(data + kNdpDstIPOffset, dstIP.bytes(), IPAddressV6::byteCount());
+  data[kNdpFlagsOffset] = flags >> 24;
+  data[kNdpFlagsOffset + 1] = (flags >> 16) & 0xff;
+  data[kNdpFlagsOffset + 2] = (flags >> 8) & 0xff;
+  data[kNdpFlagsOffset + 3] = flags & 0xff;
+
+  // Fold the patched words into the precomputed partial sum
+  uint32_t sum = partialSum_;
+  sum = sumWords(data + kNdpDstIPOffset, IPAddressV6::byteCount(), sum);
+  sum += (flags >> 16) + (flags & 0xffff);
+  writeBE16(data + kNdpCsumOffset, PktUtil::finalizeChecksum(sum));
+}
+
+NdpSolicitationTemplate::NdpSolicitationTemplate(VlanID vlan,
+                                                 MacAddress srcMac) {
+  // We always solicit from our link local address
+  IPAddressV6 srcIP(IPAddressV6::LINK_LOCAL, srcMac);
+
+  memset(frame_, 0, sizeof(frame_));
+  uint8_t* p = frame_;
+  p = writeMac(p, MacAddress::ZERO); // dst mac, patched per solicitation
+  p = writeMac(p, srcMac);
+  p = writeBE16(p, ETHERTYPE_VLAN);
+  p = writeBE16(p, vlan);
+  p = writeBE16(p, ETHERTYPE_IPV6);
+  // version 6, traffic class CS7 (network control), flow label 0
+  *p++ = (IPV6_VERSION << 4) | (0xe0 >> 4);
+  *p++ = 0;
+  p = writeBE16(p, 0);
+  p = writeBE16(p, kNdpPayloadLength);
+  *p++ = IP_PROTO_IPV6_ICMP;
+  *p++ = 255; // hop limit
+  memcpy(p, srcIP.bytes(), IPAddressV6::byteCount());
+  p += IPAddressV6::byteCount();
+  p += IPAddressV6::byteCount(); // dst addr, patched per solicitation
+  *p++ = ICMPV6_TYPE_NDP_NEIGHBOR_SOLICITATION;
+  *p++ = ICMPV6_CODE_NDP_MESSAGE_CODE;
+  p += 2; // checksum, patched per solicitation
+  p += 4; // reserved
+  p += IPAddressV6::byteCount(); // target address, patched
+  *p++ = NDPOptionType::SRC_LL_ADDRESS;
+  *p++ = NDPOptionLength::SRC_LL_ADDRESS_IEEE802;
+  p = writeMac(p, srcMac);
+  DCHECK_EQ(p - frame_, SIZE);
+
+  // Precompute the checksum over everything that does not depend on
+  // the target: the pseudo-header minus the destination address, the
+  // ICMPv6 type/code, the reserved word (zero), and the source
+  // link-layer option.
+  uint32_t sum = kNdpPayloadLength + IP_PROTO_IPV6_ICMP;
+  sum = sumWords(frame_ + kNdpSrcIPOffset, IPAddressV6::byteCount(), sum);
+  sum = sumWords(frame_ + kNdpIcmpOffset, 2, sum);
+  sum = sumWords(frame_ + kNdpOptionOffset, 8, sum);
+  partialSum_ = sum;
+}
+
+void NdpSolicitationTemplate::writeSolicitation(
+    TxPacket* pkt,
+    const IPAddressV6& targetIP) const {
+  IPAddressV6 solicitedNodeAddr = targetIP.getSolicitedNodeAddress();
+  MacAddress dstMac = MacAddress::createMulticast(solicitedNodeAddr);
+
+  auto buf = pkt->buf();
+  DCHECK_GE(buf->length(), SIZE);
+  uint8_t* data = buf->writableData();
+  memcpy(data, frame_, SIZE);
+  memcpy(data + kDstMacOffset, dstMac.bytes(), MacAddress::SIZE);
+  memcpy(data + kNdpDstIPOffset, solicitedNodeAddr.bytes(),
+         IPAddressV6::byteCount());
+  memcpy(data + kNdpTargetIPOffset, targetIP.bytes(),
+         IPAddressV6::byteCount());
+
+  // Fold the patched addresses into the precomputed partial sum
+  uint32_t sum = partialSum_;
+  sum = sumWords(data + kNdpDstIPOffset, IPAddressV6::byteCount(), sum);
+  sum = sumWords(data + kNdpTargetIPOffset, IPAddressV6::byteCount(), sum);
+  writeBE16(data + kNdpCsumOffset, PktUtil::finalizeChecksum(sum));
+}
+
+}} // facebook::fboss
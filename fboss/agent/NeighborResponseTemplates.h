@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/agent/types.h"
+
+#include <folly/IPAddressV4.h>
+#include <folly/IPAddressV6.h>
+#include <folly/MacAddress.h>
+
+namespace facebook { namespace fboss {
+
+class TxPacket;
+
+/*
+ * Pre-serialized ARP reply frame for one (vlan, sender MAC, sender IP)
+ * tuple, i.e. one interface address we answer ARP for. Everything except
+ * the requester's MAC and IP is fixed for a given tuple, so generating a
+ * reply boils down to copying the template into the tx buffer and
+ * patching those fields. The frame content is fully determined by the
+ * tuple the template was built for, so cached templates never need to be
+ * invalidated.
+ */
+class ArpReplyTemplate {
+ public:
+  enum : uint32_t { SIZE = 68 };
+
+  ArpReplyTemplate(VlanID vlan,
+                   folly::MacAddress senderMac,
+                   folly::IPAddressV4 senderIP);
+
+  /*
+   * Fill pkt with a reply to targetMac/targetIP. The packet must have
+   * been allocated with SIZE bytes.
+   */
+  void writeReply(TxPacket* pkt,
+                  folly::MacAddress targetMac,
+                  folly::IPAddressV4 targetIP) const;
+
+ private:
+  uint8_t frame_[SIZE];
+};
+
+/*
+ * Pre-serialized NDP neighbor advertisement for one (vlan, source MAC,
+ * advertised IP) tuple. The requester's MAC, the destination IP, and the
+ * flags word vary per advertisement and are patched into a copy of the
+ * template; the ICMPv6 checksum over everything else, including the
+ * pseudo-header minus the destination address, is kept as a precomputed
+ * partial sum that the patched words are folded into.
+ */
+class NdpAdvertisementTemplate {
+ public:
+  enum : uint32_t { SIZE = 90 };
+
+  NdpAdvertisementTemplate(VlanID vlan,
+                           folly::MacAddress srcMac,
+                           folly::IPAddressV6 srcIP);
+
+  /*
+   * Fill pkt with an advertisement to dstMac/dstIP. The packet must have
+   * been allocated with SIZE bytes. flags is the NDP flags word (router/
+   * solicited/override bits).
+   */
+  void writeAdvertisement(TxPacket* pkt,
+                          folly::MacAddress dstMac,
+                          const folly::IPAddressV6& dstIP,
+                          uint32_t flags) const;
+
+ private:
+  uint8_t frame_[SIZE];
+  // Sum of all checksummed 16 bit words that do not depend on the
+  // destination: the pseudo-header minus the destination address, the
+  // ICMPv6 type/code, and the body minus the flags word.
+  uint32_t partialSum_{0};
+};
+
+/*
+ * Pre-serialized NDP neighbor solicitation for one (vlan, source MAC)
+ * pair; the source IP is the link local address derived from the MAC.
+ * Only the target varies per solicitation: it determines the solicited
+ * node destination address, the multicast destination MAC, the target
+ * field in the body, and the checksum, all of which are patched into a
+ * copy of the template.
+ */
+class NdpSolicitationTemplate {
+ public:
+  enum : uint32_t { SIZE = 90 };
+
+  NdpSolicitationTemplate(VlanID vlan, folly::MacAddress srcMac);
+
+  /*
+   * Fill pkt with a solicitation for targetIP. The packet must have
+   * been allocated with SIZE bytes.
+   */
+  void writeSolicitation(TxPacket* pkt,
+                         const folly::IPAddressV6& targetIP) const;
+
+ private:
+  uint8_t frame_[SIZE];
+  // Sum of the checksummed words that do not depend on the target: the
+  // pseudo-header minus the destination address, the ICMPv6 type/code,
+  // and the body minus the target address.
+  uint32_t partialSum_{0};
+};
+
+}} // facebook::fboss
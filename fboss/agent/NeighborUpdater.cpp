@@ -8,6 +8,7 @@
  *
  */
 #include "NeighborUpdater.h"
+#include "fboss/agent/AddressUtil.h"
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/ArpHandler.h"
@@ -36,10 +37,15 @@ using folly::MacAddress;
 using folly::IPAddressV4;
 using folly::IPAddressV6;
 
+DEFINE_int32(neighbor_delta_batch_interval_ms, 1000,
+             "How long to accumulate neighbor entry deltas before pushing "
+             "a batch to registered delta subscribers");
+
 namespace facebook { namespace fboss {
 
 NeighborUpdater::NeighborUpdater(SwSwitch* sw)
-    : AutoRegisterStateObserver(sw, "NeighborUpdater"),
+    : AutoRegisterStateObserver(sw, "NeighborUpdater",
+                                INTEREST_VLANS | INTEREST_SWITCH_SETTINGS),
       sw_(sw) {}
 
 NeighborUpdater::~NeighborUpdater() {
@@ -115,6 +121,16 @@ shared_ptr<NdpCache> NeighborUpdater::getNdpCacheInternal(VlanID vlan) {
   return res->second->ndpCache;
 }
 
+bool NeighborUpdater::shouldSendNeighborSolicitation(VlanID vlan,
+                                                     IPAddressV6 ip) {
+  auto cache = getNdpCacheFor(vlan);
+  if (cache->shouldSolicit(ip)) {
+    return true;
+  }
+  sw_->stats()->ipv6NdpSolicitSuppressed();
+  return false;
+}
+
 void NeighborUpdater::sentNeighborSolicitation(VlanID vlan,
                                                IPAddressV6 ip) {
   auto cache = getNdpCacheFor(vlan);
@@ -141,6 +157,16 @@ void NeighborUpdater::receivedNdpNotMine(VlanID vlan,
   cache->receivedNdpNotMine(ip, mac, port, type, flags);
 }
 
+bool NeighborUpdater::shouldSendArpRequest(VlanID vlan,
+                                           IPAddressV4 ip) {
+  auto cache = getArpCacheFor(vlan);
+  if (cache->shouldSolicit(ip)) {
+    return true;
+  }
+  sw_->stats()->arpRequestSuppressed();
+  return false;
+}
+
 void NeighborUpdater::sentArpRequest(VlanID vlan,
                                      IPAddressV4 ip) {
   auto cache = getArpCacheFor(vlan);
@@ -165,6 +191,66 @@ void NeighborUpdater::receivedArpNotMine(VlanID vlan,
   cache->receivedArpNotMine(ip, mac, port, op);
 }
 
+void NeighborUpdater::restoreArpEntry(VlanID vlan,
+                                      IPAddressV4 ip,
+                                      MacAddress mac,
+                                      PortID port) {
+  shared_ptr<ArpCache> cache;
+  {
+    std::lock_guard<std::mutex> g(cachesMutex_);
+    auto res = caches_.find(vlan);
+    if (res == caches_.end()) {
+      // The vlan disappeared from the config across the restart
+      VLOG(2) << "No cache for vlan " << vlan
+              << ", skipping restore of " << ip;
+      return;
+    }
+    cache = res->second->arpCache;
+  }
+  cache->restoreEntry(ip, mac, port);
+}
+
+void NeighborUpdater::restoreNdpEntry(VlanID vlan,
+                                      IPAddressV6 ip,
+                                      MacAddress mac,
+                                      PortID port) {
+  shared_ptr<NdpCache> cache;
+  {
+    std::lock_guard<std::mutex> g(cachesMutex_);
+    auto res = caches_.find(vlan);
+    if (res == caches_.end()) {
+      // The vlan disappeared from the config across the restart
+      VLOG(2) << "No cache for vlan " << vlan
+              << ", skipping restore of " << ip;
+      return;
+    }
+    cache = res->second->ndpCache;
+  }
+  cache->restoreEntry(ip, mac, port);
+}
+
+void NeighborUpdater::queuePendingPacket(VlanID vlan,
+                                         IPAddressV4 nexthop,
+                                         const RxPacket* pkt) {
+  auto cache = getArpCacheFor(vlan);
+  cache->queuePacketForResolution(nexthop, pkt);
+}
+
+void NeighborUpdater::queuePendingPacket(VlanID vlan,
+                                         IPAddressV6 nexthop,
+                                         const RxPacket* pkt) {
+  auto cache = getNdpCacheFor(vlan);
+  cache->queuePacketForResolution(nexthop, pkt);
+}
+
+void NeighborUpdater::queuePendingL3Packet(VlanID vlan,
+                                           IPAddressV6 nexthop,
+                                           std::unique_ptr<TxPacket> pkt,
+                                           folly::Optional<InterfaceID> ifID) {
+  auto cache = getNdpCacheFor(vlan);
+  cache->queueL3PacketForResolution(nexthop, std::move(pkt), ifID);
+}
+
 void NeighborUpdater::portDown(PortID port) {
   for (auto vlanCaches : caches_) {
     auto arpCache = vlanCaches.second->arpCache;
@@ -271,6 +357,45 @@ void collectPresenceChange(const T& delta,
   }
 }
 
+template<typename EntryT>
+NeighborEntryDelta makeEntryDelta(NeighborEntryOp op,
+                                  const EntryT& entry,
+                                  VlanID vlan) {
+  NeighborEntryDelta d;
+  d.op = op;
+  d.ip = network::toBinaryAddress(entry->getIP());
+  d.vlanID = vlan;
+  d.mac = folly::to<std::string>(entry->getMac());
+  d.port = entry->getPort();
+  return d;
+}
+
+template<typename T>
+void collectEntryDeltas(const T& delta,
+                        VlanID vlan,
+                        std::vector<NeighborEntryDelta>* deltas) {
+  for (const auto& entry : delta) {
+    auto oldEntry = entry.getOld();
+    auto newEntry = entry.getNew();
+    // Unresolved (pending) entries are invisible to subscribers, just as
+    // they are to collectPresenceChange() above.
+    bool oldResolved = oldEntry && oldEntry->nonZeroPort();
+    bool newResolved = newEntry && newEntry->nonZeroPort();
+    if (!oldResolved && newResolved) {
+      deltas->push_back(
+          makeEntryDelta(NeighborEntryOp::ADD, newEntry, vlan));
+    } else if (oldResolved && !newResolved) {
+      deltas->push_back(
+          makeEntryDelta(NeighborEntryOp::REMOVE, oldEntry, vlan));
+    } else if (oldResolved && newResolved &&
+               (oldEntry->getMac() != newEntry->getMac() ||
+                oldEntry->getPort() != newEntry->getPort())) {
+      deltas->push_back(
+          makeEntryDelta(NeighborEntryOp::CHANGE, newEntry, vlan));
+    }
+  }
+}
+
 void NeighborUpdater::sendNeighborUpdates(const VlanDelta& delta) {
   std::vector<std::string> added;
   std::vector<std::string> deleted;
@@ -279,6 +404,32 @@ void NeighborUpdater::sendNeighborUpdates(const VlanDelta& delta) {
   if (!(added.empty() && deleted.empty())) {
     sw_->invokeNeighborListener(added, deleted);
   }
+
+  auto vlan = (delta.getNew() ? delta.getNew() : delta.getOld())->getID();
+  collectEntryDeltas(delta.getArpDelta(), vlan, &pendingEntryDeltas_);
+  collectEntryDeltas(delta.getNdpDelta(), vlan, &pendingEntryDeltas_);
+  if (pendingEntryDeltas_.empty()) {
+    return;
+  }
+  // Batch deltas for a short interval so that subscribers see one push
+  // per burst of churn rather than one push per state update.
+  if (!entryDeltaFlushTimeout_) {
+    entryDeltaFlushTimeout_ = folly::AsyncTimeout::make(
+        *sw_->getUpdateEVB(), [this]() noexcept { flushEntryDeltas(); });
+  }
+  if (!entryDeltaFlushTimeout_->isScheduled()) {
+    entryDeltaFlushTimeout_->scheduleTimeout(
+        FLAGS_neighbor_delta_batch_interval_ms);
+  }
+}
+
+void NeighborUpdater::flushEntryDeltas() {
+  std::vector<NeighborEntryDelta> batch;
+  batch.swap(pendingEntryDeltas_);
+  if (batch.empty()) {
+    return;
+  }
+  sw_->invokeNeighborEntryDeltaListener(batch);
 }
 
 void NeighborUpdater::vlanAdded(const SwitchState* state, const Vlan* vlan) {
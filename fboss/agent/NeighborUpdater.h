@@ -10,6 +10,7 @@
 #pragma once
 
 #include <boost/container/flat_map.hpp>
+#include <folly/io/async/AsyncTimeout.h>
 #include "fboss/agent/StateObserver.h"
 #include "fboss/agent/types.h"
 #include "fboss/agent/ArpCache.h"
@@ -17,6 +18,7 @@
 #include <list>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace facebook { namespace fboss {
 
@@ -52,6 +54,8 @@ class NeighborUpdater : public AutoRegisterStateObserver {
   uint32_t flushEntry (VlanID vlan, folly::IPAddress ip);
 
   // Ndp events
+  bool shouldSendNeighborSolicitation(VlanID vlan,
+                                      folly::IPAddressV6 ip);
   void sentNeighborSolicitation(VlanID vlan,
                                 folly::IPAddressV6 ip);
   void receivedNdpMine(VlanID vlan,
@@ -68,6 +72,8 @@ class NeighborUpdater : public AutoRegisterStateObserver {
                           uint32_t flags);
 
   // Arp events
+  bool shouldSendArpRequest(VlanID vlan,
+                            folly::IPAddressV4 ip);
   void sentArpRequest(VlanID vlan,
                       folly::IPAddressV4 ip);
   void receivedArpMine(VlanID vlan,
@@ -83,6 +89,38 @@ class NeighborUpdater : public AutoRegisterStateObserver {
 
   void portDown(PortID port);
 
+  // Restore neighbor entries checkpointed by the previous run on warm
+  // boot, see SwSwitch::preloadNeighbors(). The entries enter the
+  // caches in STALE state, so they are usable immediately but get
+  // revalidated on the caches' paced timers. Entries for vlans that
+  // disappeared across the restart are skipped.
+  void restoreArpEntry(VlanID vlan,
+                       folly::IPAddressV4 ip,
+                       folly::MacAddress mac,
+                       PortID port);
+  void restoreNdpEntry(VlanID vlan,
+                       folly::IPAddressV6 ip,
+                       folly::MacAddress mac,
+                       PortID port);
+
+  // Queue a copy of a packet that cannot be forwarded until its
+  // nexthop resolves. The caches hold a bounded number of packets per
+  // neighbor and re-inject them once the neighbor is resolved.
+  void queuePendingPacket(VlanID vlan,
+                          folly::IPAddressV4 nexthop,
+                          const RxPacket* pkt);
+  void queuePendingPacket(VlanID vlan,
+                          folly::IPAddressV6 nexthop,
+                          const RxPacket* pkt);
+
+  // Queue a host-originated L3 packet that can't be framed until its
+  // (v6 link-local) destination resolves. It is re-sent through
+  // SwSwitch::sendL3Packet() once the neighbor is known.
+  void queuePendingL3Packet(VlanID vlan,
+                            folly::IPAddressV6 nexthop,
+                            std::unique_ptr<TxPacket> pkt,
+                            folly::Optional<InterfaceID> ifID);
+
   void getArpCacheData(std::vector<ArpEntryThrift>& arpTable);
 
   void getNdpCacheData(std::vector<NdpEntryThrift>& ndpTable);
@@ -93,6 +131,7 @@ class NeighborUpdater : public AutoRegisterStateObserver {
   void vlanChanged(const Vlan* oldVlan, const Vlan* newVlan);
 
   void sendNeighborUpdates(const VlanDelta& delta);
+  void flushEntryDeltas();
 
   std::shared_ptr<ArpCache> getArpCacheFor(VlanID vlan);
   std::shared_ptr<ArpCache> getArpCacheInternal(VlanID vlan);
@@ -133,6 +172,15 @@ class NeighborUpdater : public AutoRegisterStateObserver {
   boost::container::flat_map<VlanID, std::shared_ptr<NeighborCaches>> caches_;
   std::mutex cachesMutex_;
   SwSwitch* sw_{nullptr};
+
+  /**
+   * Neighbor entry deltas accumulated for the current batching interval.
+   * Only touched from the update thread, so no locking is needed. The
+   * timeout is also scheduled and fired on the update event base, and is
+   * cancelled automatically when it is destroyed.
+   */
+  std::vector<NeighborEntryDelta> pendingEntryDeltas_;
+  std::unique_ptr<folly::AsyncTimeout> entryDeltaFlushTimeout_;
 };
 
 }} // facebook::fboss
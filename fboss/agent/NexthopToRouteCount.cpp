@@ -63,6 +63,19 @@ void NexthopToRouteCount::stateChanged(const StateDelta& delta) {
 template<typename RouteT>
 void NexthopToRouteCount::processChangedRoute(const RouterID rid,
    const shared_ptr<RouteT>& oldRoute, const shared_ptr<RouteT>& newRoute) {
+  // The ref counts only depend on the resolved forwarding info. Route
+  // updates frequently change other attributes (flags, unresolved nexthop
+  // lists), so during convergence events the forwarding info is often
+  // unchanged - skip those updates entirely.
+  bool oldCounted = oldRoute->isResolved() && oldRoute->isWithNexthops();
+  bool newCounted = newRoute->isResolved() && newRoute->isWithNexthops();
+  if (!oldCounted && !newCounted) {
+    return;
+  }
+  if (oldCounted && newCounted &&
+      oldRoute->getForwardInfo() == newRoute->getForwardInfo()) {
+    return;
+  }
   // We could compute set differences of nexthops from old and new routes,
   // but since we would need to compute 2 set differences (new - old and
   // old - new), it is similar complexity wise to just decrement reference
@@ -77,8 +90,11 @@ template<typename RouteT>
 void NexthopToRouteCount::processAddedRoute(const RouterID rid,
     const shared_ptr<RouteT>& newRoute) {
   if (newRoute->isResolved() && newRoute->isWithNexthops()) {
+    // Look up the per-router table once for the whole nexthop set, rather
+    // than once per nexthop - ECMP routes carry many nexthops.
+    auto& nhop2RefCount = rid2nhopRefCounts_[rid];
     for (const auto& nhop : newRoute->getForwardInfo().getNexthops()) {
-      incNexthopReference(rid, nhop);
+      incNexthopReference(nhop2RefCount, nhop);
     }
   }
 }
@@ -87,15 +103,19 @@ template<typename RouteT>
 void NexthopToRouteCount::processRemovedRoute(const RouterID rid,
    const shared_ptr<RouteT>& oldRoute) {
   if (oldRoute->isResolved() && oldRoute->isWithNexthops()) {
+    auto ritr = rid2nhopRefCounts_.find(rid);
+    CHECK(ritr != rid2nhopRefCounts_.end());
     for (const auto& nhop : oldRoute->getForwardInfo().getNexthops()) {
-      decNexthopReference(rid, nhop);
+      decNexthopReference(ritr->second, nhop);
+    }
+    if (ritr->second.empty()) {
+      rid2nhopRefCounts_.erase(ritr);
     }
   }
 }
 
-void NexthopToRouteCount::incNexthopReference(RouterID rid,
+void NexthopToRouteCount::incNexthopReference(Nhop2RefCount& nhop2RefCount,
     const Nexthop& nhop) {
-  auto& nhop2RefCount = rid2nhopRefCounts_[rid];
   auto itr = nhop2RefCount.find(nhop);
   if (itr == nhop2RefCount.end()) {
     nhop2RefCount.emplace(nhop, 1);
@@ -105,9 +125,8 @@ void NexthopToRouteCount::incNexthopReference(RouterID rid,
   }
 }
 
-void NexthopToRouteCount::decNexthopReference(RouterID rid,
+void NexthopToRouteCount::decNexthopReference(Nhop2RefCount& nhop2RefCount,
     const Nexthop& nhop) {
-  auto& nhop2RefCount = rid2nhopRefCounts_[rid];
   auto itr = nhop2RefCount.find(nhop);
   CHECK(itr != nhop2RefCount.end());
   itr->second--;
@@ -115,8 +134,5 @@ void NexthopToRouteCount::decNexthopReference(RouterID rid,
   if (itr->second == 0) {
     nhop2RefCount.erase(itr);
   }
-  if (nhop2RefCount.empty()) {
-    rid2nhopRefCounts_.erase(rid);
-  }
 }
 }}
@@ -36,8 +36,9 @@ class NexthopToRouteCount {
    using Nexthop = RouteForwardInfo::Nexthop;
    // Using int rather than uint to check against bugs where we
    // get -ve reference counts
+   using Nhop2RefCount = boost::container::flat_map<Nexthop, int64_t>;
    using RouterID2NhopRefCounts = boost::container::flat_map<RouterID,
-         boost::container::flat_map<Nexthop, int64_t>>;
+         Nhop2RefCount>;
 
   using const_iterator = RouterID2NhopRefCounts::const_iterator;
   const_iterator begin() const { return rid2nhopRefCounts_.begin(); }
@@ -59,8 +60,10 @@ class NexthopToRouteCount {
     void processRemovedRoute(const RouterID id,
         const std::shared_ptr<RouteT>& newRoute);
 
-    void incNexthopReference(RouterID rid, const Nexthop& nhop);
-    void decNexthopReference(RouterID rid, const Nexthop& nhop);
+    void incNexthopReference(Nhop2RefCount& nhop2RefCount,
+        const Nexthop& nhop);
+    void decNexthopReference(Nhop2RefCount& nhop2RefCount,
+        const Nexthop& nhop);
 
     RouterID2NhopRefCounts rid2nhopRefCounts_;
 };
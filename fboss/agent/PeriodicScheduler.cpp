@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/PeriodicScheduler.h"
+
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/SwitchStats.h"
+
+#include <folly/Random.h>
+#include <folly/io/async/EventBase.h>
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+DEFINE_int32(periodic_tick_budget_ms, 20,
+             "Time budget for the periodic tasks firing on one timer tick; "
+             "once a tick has spent it, remaining low tier tasks are "
+             "deferred to a later tick (0 disables the budget)");
+
+namespace {
+// Resolution of the wheel timer.  Budget accounting also rolls over to
+// a new tick once this much time has passed since the tick's first
+// callback fired.
+constexpr std::chrono::milliseconds kTickInterval(10);
+}
+
+namespace facebook { namespace fboss {
+
+PeriodicScheduler::PeriodicScheduler(SwSwitch* sw, folly::EventBase* evb)
+    : sw_(sw),
+      evb_(evb),
+      wheel_(new folly::HHWheelTimer(evb, kTickInterval)) {
+}
+
+PeriodicScheduler::~PeriodicScheduler() {
+  evb_->runImmediatelyOrRunInEventBaseThreadAndWait([this]() {
+    // Destroying a Task cancels its pending timeout.
+    tasks_.clear();
+  });
+}
+
+PeriodicScheduler::Task::Task(PeriodicScheduler* scheduler, std::string name,
+                              Tier tier, std::chrono::milliseconds interval,
+                              folly::Function<void()> fn)
+    : scheduler(scheduler),
+      name(std::move(name)),
+      tier(tier),
+      interval(interval),
+      fn(std::move(fn)) {
+}
+
+void PeriodicScheduler::Task::timeoutExpired() noexcept {
+  scheduler->runTask(this);
+}
+
+void PeriodicScheduler::addTask(folly::StringPiece name, Tier tier,
+                                std::chrono::milliseconds interval,
+                                folly::Function<void()> fn) {
+  CHECK_GT(interval.count(), 0);
+  auto task = std::make_unique<Task>(this, name.str(), tier, interval,
+                                     std::move(fn));
+  evb_->runInEventBaseThread([this, task = std::move(task)]() mutable {
+    // Phase-randomize the first run within the interval, so tasks
+    // with equal intervals registered at the same moment spread out
+    // across the interval instead of ticking in lockstep forever.
+    auto firstDelay = milliseconds(
+        folly::Random::rand32(static_cast<uint32_t>(task->interval.count())));
+    auto* t = task.get();
+    auto ret = tasks_.emplace(t->name, std::move(task));
+    CHECK(ret.second) << "duplicate periodic task " << t->name;
+    wheel_->scheduleTimeout(t, firstDelay);
+  });
+}
+
+void PeriodicScheduler::removeTask(folly::StringPiece name) {
+  evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [this, name = name.str()]() {
+        tasks_.erase(name);
+      });
+}
+
+void PeriodicScheduler::runTask(Task* task) {
+  auto now = steady_clock::now();
+  // Callbacks due on the same wheel tick run back to back on the
+  // EventBase, so everything within one tick interval of the tick's
+  // first callback shares its budget.
+  if (now - tickStart_ >= kTickInterval) {
+    tickStart_ = now;
+    tickSpent_ = microseconds(0);
+  }
+  if (task->tier == Tier::LOW && FLAGS_periodic_tick_budget_ms > 0 &&
+      tickSpent_ >= milliseconds(FLAGS_periodic_tick_budget_ms)) {
+    // This tick is over budget.  Push the task back a few ticks with
+    // jitter, so the deferred tasks don't all re-align on the same
+    // later tick, and count the deferral so overruns are observable.
+    sw_->stats()->periodicTaskDeferred();
+    VLOG(3) << "periodic task " << task->name << " deferred; tick already "
+      "spent " << tickSpent_.count() << "us";
+    wheel_->scheduleTimeout(task,
+                            kTickInterval * (1 + folly::Random::rand32(4)));
+    return;
+  }
+  task->fn();
+  auto elapsed = duration_cast<microseconds>(steady_clock::now() - now);
+  tickSpent_ += elapsed;
+  sw_->stats()->periodicTaskRun(elapsed);
+  wheel_->scheduleTimeout(task, task->interval);
+}
+
+}} // facebook::fboss
@@ -0,0 +1,112 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/Range.h>
+#include <folly/io/async/HHWheelTimer.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace folly {
+class EventBase;
+}
+
+namespace facebook { namespace fboss {
+
+class SwSwitch;
+
+/*
+ * A central timer service for the agent's periodic work.
+ *
+ * Each periodic component used to run its own AsyncTimeout, so tasks
+ * with the same interval that happened to start together ticked in
+ * lockstep forever, stacking their work into one EventBase pass and
+ * showing up as a periodic CPU sawtooth in latency monitoring.
+ * PeriodicScheduler hashes all periodic work onto a single wheel
+ * timer on the background EventBase and randomizes each task's phase
+ * within its interval, so equal-interval tasks spread out instead of
+ * aligning.
+ *
+ * The scheduler also enforces a per-tick time budget
+ * (--periodic_tick_budget_ms): when the tasks that fired on one wheel
+ * tick have already spent the budget, remaining LOW tier tasks are
+ * pushed back by a short randomized delay instead of piling on.
+ * Deferrals and task runtimes are exported via SwitchStats, so an
+ * overrunning tick is observable rather than silent.
+ */
+class PeriodicScheduler {
+ public:
+  /*
+   * HIGH tier tasks always run when due; they are for work whose
+   * cadence callers depend on, like stats publishing.  LOW tier tasks
+   * are best-effort maintenance (port remediation, next hop probing)
+   * that may be pushed back when a tick overruns its budget.
+   */
+  enum class Tier : uint8_t { HIGH = 0, LOW = 1 };
+
+  PeriodicScheduler(SwSwitch* sw, folly::EventBase* evb);
+  ~PeriodicScheduler();
+
+  /*
+   * Register fn to run every interval on the scheduler's EventBase.
+   * The first run is phase-randomized within [0, interval); after
+   * that the task reschedules interval after each completion, like
+   * the AsyncTimeout-based components it replaces.
+   *
+   * This method is safe to call from any thread.
+   */
+  void addTask(folly::StringPiece name, Tier tier,
+               std::chrono::milliseconds interval,
+               folly::Function<void()> fn);
+
+  /*
+   * Cancel the named task, blocking until it is guaranteed not to run
+   * again.  Safe to call from any thread except the task itself.
+   */
+  void removeTask(folly::StringPiece name);
+
+ private:
+  struct Task : public folly::HHWheelTimer::Callback {
+    Task(PeriodicScheduler* scheduler, std::string name, Tier tier,
+         std::chrono::milliseconds interval, folly::Function<void()> fn);
+    void timeoutExpired() noexcept override;
+
+    PeriodicScheduler* scheduler{nullptr};
+    std::string name;
+    Tier tier;
+    std::chrono::milliseconds interval;
+    folly::Function<void()> fn;
+  };
+
+  // Forbidden copy constructor and assignment operator
+  PeriodicScheduler(PeriodicScheduler const &) = delete;
+  PeriodicScheduler& operator=(PeriodicScheduler const &) = delete;
+
+  void runTask(Task* task);
+
+  SwSwitch* sw_{nullptr};
+  folly::EventBase* evb_{nullptr};
+  folly::HHWheelTimer::UniquePtr wheel_;
+
+  // All state below is only touched on the EventBase thread.
+  std::map<std::string, std::unique_ptr<Task>> tasks_;
+  // Budget accounting for the current wheel tick: callbacks that fire
+  // on the same tick run back to back on the EventBase, so everything
+  // within one tick interval of the first callback counts against the
+  // same budget.
+  std::chrono::steady_clock::time_point tickStart_;
+  std::chrono::microseconds tickSpent_{0};
+};
+
+}} // facebook::fboss
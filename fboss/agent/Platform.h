@@ -115,6 +115,16 @@ class Platform {
   std::string getWarmBootDir() const {
     return getVolatileStateDir() + "/warm_boot";
   }
+  /*
+   * Get filename where the compiled config cache is stored.
+   *
+   * The cache holds the SwitchState produced by the last successful
+   * config apply, keyed by a hash of the config file, so a restart with
+   * an unchanged config can skip rebuilding it.  See SwSwitch::applyConfig().
+   */
+  std::string getCompiledConfigCacheFile() const {
+    return getPersistentStateDir() + "/compiled_config_cache";
+  }
   /*
    * Get filename for where we dump hw state on crash
    */
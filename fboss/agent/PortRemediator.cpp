@@ -9,41 +9,27 @@
  */
 
 #include "fboss/agent/PortRemediator.h"
-#include "fboss/agent/FbossError.h"
+#include "fboss/agent/PeriodicScheduler.h"
 
 namespace {
 constexpr int kPortRemedyIntervalSec = 10;
+constexpr auto kPortRemediatorTask = "port_remediator";
 }
 
 namespace facebook { namespace fboss {
 
-void PortRemediator::timeoutExpired() noexcept {
-  sw_->getHw()->remedyPorts();
-  scheduleTimeout(interval_);
-}
-
 PortRemediator::PortRemediator(SwSwitch* swSwitch)
-    : AsyncTimeout(swSwitch->getBackgroundEVB()),
-      sw_(swSwitch),
-      interval_(kPortRemedyIntervalSec) {
-  // Schedule the port remedy handler to run
-  bool ret = sw_->getBackgroundEVB()->runInEventBaseThread(
-      PortRemediator::start, (void*)this);
-  if (!ret) {
-    // Throw error from the constructor because this object is unusable if we
-    // cannot start it in event base.
-    throw FbossError("Failed to start PortRemediator");
-  }
+    : sw_(swSwitch) {
+  sw_->getPeriodicScheduler()->addTask(
+      kPortRemediatorTask, PeriodicScheduler::Tier::LOW,
+      std::chrono::seconds(kPortRemedyIntervalSec),
+      [this]() {
+        sw_->getHw()->remedyPorts();
+      });
 }
 
 PortRemediator::~PortRemediator() {
-  int stopPortRemediator =
-      sw_->getBackgroundEVB()->runImmediatelyOrRunInEventBaseThreadAndWait(
-          PortRemediator::stop, (void*)this);
-  // At this point, PortRemediator must not be running.
-  if (!stopPortRemediator) {
-    throw FbossError("Failed to stop port remediation handler");
-  }
+  sw_->getPeriodicScheduler()->removeTask(kPortRemediatorTask);
 }
 
 }} // facebook::fboss
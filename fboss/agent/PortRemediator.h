@@ -10,33 +10,28 @@
 
 #pragma once
 
-#include <chrono>
-#include <folly/io/async/AsyncTimeout.h>
-
 #include "fboss/agent/SwSwitch.h"
 
 namespace facebook { namespace fboss {
 
-class PortRemediator : private folly::AsyncTimeout {
+/*
+ * Periodically asks the hardware to remedy misbehaving ports.
+ *
+ * The periodic tick runs as a LOW tier task on the central
+ * PeriodicScheduler: remediation is best-effort maintenance, so it is
+ * among the first work to be deferred when a tick overruns its budget.
+ */
+class PortRemediator {
  public:
   explicit PortRemediator(SwSwitch* swSwitch);
   ~PortRemediator();
 
-  static void start(void *arg) {
-    auto me = static_cast<PortRemediator*>(arg);
-    me->scheduleTimeout(me->interval_);
-  }
-
-  static void stop(void* arg) {
-    auto me = static_cast<PortRemediator*>(arg);
-    me->cancelTimeout();
-  }
-
-  void timeoutExpired() noexcept override;
-
  private:
+  // Forbidden copy constructor and assignment operator
+  PortRemediator(PortRemediator const &) = delete;
+  PortRemediator& operator=(PortRemediator const &) = delete;
+
   SwSwitch* sw_;
-  std::chrono::seconds interval_;
 };
 
 } // fboss
@@ -0,0 +1,81 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/PortSendContextTable.h"
+
+#include <arpa/inet.h>
+#include <cstring>
+
+#include "fboss/agent/Platform.h"
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/state/Port.h"
+#include "fboss/agent/state/PortMap.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+
+namespace facebook { namespace fboss {
+
+PortSendContextTable::PortSendContextTable(SwSwitch* sw)
+    : AutoRegisterStateObserver(sw, "PortSendContextTable", INTEREST_PORTS),
+      sw_(sw) {}
+
+PortSendContextTable::~PortSendContextTable() {}
+
+void PortSendContextTable::stateUpdated(const StateDelta& delta) {
+  // We are only notified when the port section changed, and that
+  // changes rarely; a full rebuild keeps the table trivially consistent
+  // with the published state.
+  rebuildTable(delta.newState());
+}
+
+void PortSendContextTable::rebuildTable(
+    const std::shared_ptr<SwitchState>& state) {
+  const auto srcMac = sw_->getPlatform()->getLocalMac();
+  auto table = std::make_shared<Table>();
+  for (const auto& port : *state->getPorts()) {
+    auto id = static_cast<size_t>(port->getID());
+    if (id >= kMaxPorts) {
+      continue;
+    }
+    auto& entry = (*table)[id];
+    entry.port = port->getID();
+    entry.vlan = port->getIngressVlan();
+    entry.srcMac = srcMac;
+    // Build the header template: zeroed destination MAC, then source
+    // MAC, 802.1Q TPID, the VLAN tag and a zeroed ethertype.
+    uint8_t* hdr = entry.hdrTemplate.data();
+    memcpy(hdr + folly::MacAddress::SIZE, srcMac.bytes(),
+           folly::MacAddress::SIZE);
+    const uint16_t tpid = htons(0x8100); // 802.1Q
+    const uint16_t tag = htons(static_cast<uint16_t>(entry.vlan));
+    memcpy(hdr + 2 * folly::MacAddress::SIZE, &tpid, sizeof(tpid));
+    memcpy(hdr + 2 * folly::MacAddress::SIZE + sizeof(tpid), &tag,
+           sizeof(tag));
+    entry.valid = true;
+  }
+  folly::SpinLockGuard guard(lock_);
+  table_.swap(table);
+}
+
+std::shared_ptr<const PortSendContextTable::SendContext>
+PortSendContextTable::getContext(PortID port) const {
+  std::shared_ptr<const Table> table;
+  {
+    folly::SpinLockGuard guard(lock_);
+    table = table_;
+  }
+  auto id = static_cast<size_t>(port);
+  if (!table || id >= kMaxPorts || !(*table)[id].valid) {
+    return nullptr;
+  }
+  // Aliasing constructor: the entry pins the whole table
+  return std::shared_ptr<const SendContext>(table, &(*table)[id]);
+}
+
+}} // facebook::fboss
@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <memory>
+
+#include <folly/MacAddress.h>
+#include <folly/SpinLock.h>
+
+#include "fboss/agent/StateObserver.h"
+#include "fboss/agent/packet/EthHdr.h"
+#include "fboss/agent/types.h"
+
+namespace facebook { namespace fboss {
+
+class SwitchState;
+
+/*
+ * PortSendContextTable maintains a derived, flat table of per-port
+ * packet send context, rebuilt whenever the port section of the switch
+ * state changes.
+ *
+ * Periodic senders such as LldpManager and the neighbor probers used to
+ * re-derive the same VLAN tag, source MAC and ethernet header fields
+ * from the published state for every packet on every port. Each context
+ * pre-resolves those at state publish time and carries a partially
+ * built 802.1Q header, so the per-packet work is copying the template
+ * and appending the payload.
+ */
+class PortSendContextTable : public AutoRegisterStateObserver {
+ public:
+  struct SendContext {
+    PortID port{0};
+    // Port's ingress VLAN, already encoded in the header template
+    VlanID vlan{0};
+    // CPU MAC used as the source address on this port
+    folly::MacAddress srcMac;
+    // Pre-built tagged ethernet header: the source MAC, 802.1Q TPID and
+    // VLAN tag are filled in; the destination MAC and ethertype are
+    // left zero for the sender to patch.
+    std::array<uint8_t, EthHdr::SIZE> hdrTemplate{};
+    bool valid{false};
+
+    /*
+     * Write the full ethernet header at the cursor, patching the
+     * destination MAC and ethertype into the pre-built template.
+     */
+    template<typename CursorType>
+    void writeEthHeader(CursorType* cursor,
+                        folly::MacAddress dst,
+                        uint16_t protocol) const {
+      cursor->push(dst.bytes(), folly::MacAddress::SIZE);
+      // src MAC + 802.1Q TPID + VLAN tag, pre-built at state publish
+      cursor->push(hdrTemplate.data() + folly::MacAddress::SIZE,
+                   EthHdr::SIZE - folly::MacAddress::SIZE - 2);
+      cursor->template writeBE<uint16_t>(protocol);
+    }
+  };
+
+  explicit PortSendContextTable(SwSwitch* sw);
+  ~PortSendContextTable() override;
+
+  void stateUpdated(const StateDelta& delta) override;
+
+  /*
+   * Look up the send context for a port. Returns null if the port is
+   * not present in the current state. The returned pointer keeps the
+   * underlying table alive, so it remains valid across state updates.
+   */
+  std::shared_ptr<const SendContext> getContext(PortID port) const;
+
+ private:
+  enum : size_t { kMaxPorts = 1024 };
+  typedef std::array<SendContext, kMaxPorts> Table;
+
+  // Forbidden copy constructor and assignment operator
+  PortSendContextTable(const PortSendContextTable&) = delete;
+  PortSendContextTable& operator=(const PortSendContextTable&) = delete;
+
+  void rebuildTable(const std::shared_ptr<SwitchState>& state);
+
+  SwSwitch* sw_{nullptr};
+  std::shared_ptr<const Table> table_;
+  mutable folly::SpinLock lock_;
+};
+
+}} // facebook::fboss
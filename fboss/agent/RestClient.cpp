@@ -13,6 +13,8 @@
 
 #include "fboss/agent/FbossError.h"
 
+#include <folly/io/async/ScopedEventBaseThread.h>
+
 #include <curl/curl.h>
 
 namespace facebook { namespace fboss {
@@ -36,6 +38,12 @@ RestClient::RestClient(folly::IPAddress ipAddress, int port,
   createEndpoint();
 }
 
+RestClient::~RestClient() {
+  if (curlHandle_ != nullptr) {
+    curl_easy_cleanup(static_cast<CURL*>(curlHandle_));
+  }
+}
+
 void RestClient::createEndpoint() {
   if (!hostname_.empty()) {
     endpoint_ = hostname_;
@@ -54,39 +62,49 @@ void RestClient::setTimeout(std::chrono::milliseconds timeout) {
 }
 
 std::string RestClient::requestWithOutput(std::string path) {
-  CURL* curl;
   CURLcode resp;
   std::stringbuf write_buffer;
-  endpoint_ = endpoint_ + path;
+  std::string url = endpoint_ + path;
   /* for curl errors */
   char error[CURL_ERROR_SIZE];
+  error[0] = '\0';
 
-  curl = curl_easy_init();
-  if (curl) {
-    /* Set the curl options */
-    curl_easy_setopt(curl, CURLOPT_URL, endpoint_.c_str());
-    curl_easy_setopt(curl, CURLOPT_PROTOCOLS,CURLPROTO_HTTP);
-    curl_easy_setopt(curl, CURLOPT_PORT, port_);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_.count());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, RestClient::writer);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &write_buffer);
-    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, error);
-    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
-
-    /* if an interface is specified use that */
-    if (!interface_.empty()) {
-      curl_easy_setopt(curl, CURLOPT_INTERFACE, interface_.c_str());
+  // Reuse the easy handle across requests: curl keeps the underlying
+  // connection alive, so repeated queries skip connection setup.
+  auto curl = static_cast<CURL*>(curlHandle_);
+  if (curl == nullptr) {
+    curl = curl_easy_init();
+    if (curl == nullptr) {
+      throw FbossError("Error initializing curl interface");
     }
+    curlHandle_ = curl;
+  }
 
-    resp = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
-    if (resp == CURLE_OK) {
-      return write_buffer.str();
-    } else {
-      throw FbossError("Error querying api: ", endpoint_, " error: ", error);
-    }
+  /* Set the curl options */
+  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(curl, CURLOPT_PROTOCOLS, CURLPROTO_HTTP);
+  curl_easy_setopt(curl, CURLOPT_PORT, port_);
+  curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_.count());
+  curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, RestClient::writer);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &write_buffer);
+  curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, error);
+  curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+
+  /* if an interface is specified use that */
+  if (!interface_.empty()) {
+    curl_easy_setopt(curl, CURLOPT_INTERFACE, interface_.c_str());
   }
-  throw FbossError("Error initializing curl interface");
+
+  resp = curl_easy_perform(curl);
+  if (resp == CURLE_OK) {
+    return write_buffer.str();
+  }
+  // Drop the handle so a broken connection is not reused; the next
+  // request will reconnect.
+  curl_easy_cleanup(curl);
+  curlHandle_ = nullptr;
+  throw FbossError("Error querying api: ", url, " error: ", error);
 }
 
 bool RestClient::request(std::string path) {
@@ -98,6 +116,28 @@ bool RestClient::request(std::string path) {
   return false;
 }
 
+folly::Future<std::string> RestClient::requestWithOutputFuture(
+    std::string path) {
+  return folly::via(ensureRequestThread(),
+                    [this, path = std::move(path)]() {
+                      return requestWithOutput(path);
+                    });
+}
+
+folly::Future<bool> RestClient::requestFuture(std::string path) {
+  return folly::via(ensureRequestThread(),
+                    [this, path = std::move(path)]() {
+                      return request(path);
+                    });
+}
+
+folly::EventBase* RestClient::ensureRequestThread() {
+  if (!requestThread_) {
+    requestThread_.reset(new folly::ScopedEventBaseThread());
+  }
+  return requestThread_->getEventBase();
+}
+
 size_t RestClient::writer(char *buffer, size_t size,
                                 size_t entries, std::stringbuf *writer_buffer) {
   std::streamsize data_put = writer_buffer->sputn(buffer, size * entries);
@@ -9,9 +9,16 @@
  */
 #pragma once
 
+#include <memory>
 #include <string>
 #include <chrono>
 #include <folly/IPAddress.h>
+#include <folly/futures/Future.h>
+
+namespace folly {
+class EventBase;
+class ScopedEventBaseThread;
+}
 
 namespace facebook { namespace fboss {
 
@@ -20,11 +27,29 @@ class RestClient {
   RestClient(std::string hostname, int port);
   RestClient(folly::IPAddress ipAddress, int port);
   RestClient(folly::IPAddress ipAddress, int port, std::string interface);
+  ~RestClient();
   /*
    * Calls the particular Rest api
+   *
+   * The underlying connection is persistent: it is established on the
+   * first request and reused by later ones, so only the first call pays
+   * the connection setup cost.  A failed request drops the connection
+   * and the next one reconnects.
    */
   bool request(std::string path);
   std::string requestWithOutput(std::string path);
+  /*
+   * Asynchronous variants.  Requests run on a private EventBase thread
+   * over the persistent connection; multiple outstanding requests are
+   * queued and sent back to back, so callers can issue several and
+   * overlap the round trips with other work.  The configured timeout
+   * applies to each request individually.
+   *
+   * Mixing the synchronous calls above with the async variants is not
+   * supported; pick one style per client.
+   */
+  folly::Future<bool> requestFuture(std::string path);
+  folly::Future<std::string> requestWithOutputFuture(std::string path);
   void setTimeout(std::chrono::milliseconds timeout);
 
  private:
@@ -35,12 +60,18 @@ class RestClient {
   static size_t writer(char *buffer, size_t size,
                         size_t entries, std::stringbuf *writer_buffer);
   void createEndpoint();
+  folly::EventBase* ensureRequestThread();
   std::string hostname_;
   folly::IPAddress ipAddress_;
   std::string interface_;
   int port_;
   std::chrono::milliseconds timeout_{1000};
   std::string endpoint_;
+  // Persistent curl easy handle (CURL* is an opaque typedef for void,
+  // kept untyped here to avoid pulling curl.h into the header).
+  void* curlHandle_{nullptr};
+  // Lazily created; only exists once an async request has been issued.
+  std::unique_ptr<folly::ScopedEventBaseThread> requestThread_;
 };
 
 }} // namespace facebook::fboss
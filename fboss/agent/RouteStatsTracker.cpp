@@ -0,0 +1,120 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "RouteStatsTracker.h"
+
+#include "fboss/agent/state/DeltaFunctions.h"
+#include "fboss/agent/state/NodeMapDelta.h"
+#include "fboss/agent/state/NodeMapDelta-defs.h"
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/StateDelta.h"
+
+using std::shared_ptr;
+using facebook::fboss::DeltaFunctions::forEachChanged;
+using facebook::fboss::DeltaFunctions::forEachRemoved;
+
+namespace facebook { namespace fboss {
+
+RouteStatsTracker::RouteStatsTracker(SwSwitch* sw)
+    : AutoRegisterStateObserver(sw, "RouteStatsTracker",
+                                INTEREST_ROUTE_TABLES) {}
+
+void RouteStatsTracker::stateUpdated(const StateDelta& delta) {
+  for (auto const& rtDelta : delta.getRouteTablesDelta()) {
+    if (rtDelta.getNew()) {
+      forEachChanged(
+          rtDelta.getRoutesV4Delta(),
+          &RouteStatsTracker::processChangedRoute<RouteV4>,
+          &RouteStatsTracker::processAddedRoute<RouteV4>,
+          [&](RouteStatsTracker*, const shared_ptr<RouteV4>&) {},
+          this);
+      forEachChanged(
+          rtDelta.getRoutesV6Delta(),
+          &RouteStatsTracker::processChangedRoute<RouteV6>,
+          &RouteStatsTracker::processAddedRoute<RouteV6>,
+          [&](RouteStatsTracker*, const shared_ptr<RouteV6>&) {},
+          this);
+    }
+    // Process removed routes.  This also covers removal of a whole route
+    // table, where every old route shows up as removed.
+    if (rtDelta.getOld()) {
+      forEachRemoved(
+          rtDelta.getRoutesV4Delta(),
+          &RouteStatsTracker::processRemovedRoute<RouteV4>,
+          this);
+      forEachRemoved(
+          rtDelta.getRoutesV6Delta(),
+          &RouteStatsTracker::processRemovedRoute<RouteV6>,
+          this);
+    }
+  }
+}
+
+RouteStatsTracker::RouteStats RouteStatsTracker::getRouteStats() const {
+  folly::SpinLockGuard guard(lock_);
+  return stats_;
+}
+
+template <typename RouteT>
+void RouteStatsTracker::processChangedRoute(
+    const shared_ptr<RouteT>& oldRoute,
+    const shared_ptr<RouteT>& newRoute) {
+  // The prefix (and hence the total and per-mask-length counts) cannot
+  // change for a changed route; only the set of clients can.  Route
+  // updates frequently change just flags or resolved forwarding info, so
+  // during convergence events the client set is usually unchanged - skip
+  // those updates without taking the lock.
+  auto oldClients = oldRoute->getClientIds();
+  auto newClients = newRoute->getClientIds();
+  if (oldClients == newClients) {
+    return;
+  }
+  folly::SpinLockGuard guard(lock_);
+  for (auto clientId : newClients) {
+    adjustClientCount(clientId, 1);
+  }
+  for (auto clientId : oldClients) {
+    adjustClientCount(clientId, -1);
+  }
+}
+
+template <typename RouteT>
+void RouteStatsTracker::processAddedRoute(const shared_ptr<RouteT>& newRoute) {
+  folly::SpinLockGuard guard(lock_);
+  accountRoute(newRoute, 1);
+}
+
+template <typename RouteT>
+void RouteStatsTracker::processRemovedRoute(
+    const shared_ptr<RouteT>& oldRoute) {
+  folly::SpinLockGuard guard(lock_);
+  accountRoute(oldRoute, -1);
+}
+
+template <typename RouteT>
+void RouteStatsTracker::accountRoute(
+    const shared_ptr<RouteT>& route, int64_t sign) {
+  const auto& prefix = route->prefix();
+  *totalFor(prefix.network) += sign;
+  maskLenCountersFor(prefix.network)[prefix.mask] += sign;
+  for (auto clientId : route->getClientIds()) {
+    adjustClientCount(clientId, sign);
+  }
+}
+
+void RouteStatsTracker::adjustClientCount(ClientID clientId, int64_t sign) {
+  auto itr = stats_.routesByClient.find(clientId);
+  if (itr == stats_.routesByClient.end()) {
+    itr = stats_.routesByClient.emplace(clientId, 0).first;
+  }
+  itr->second += sign;
+  DCHECK_GE(itr->second, 0);
+}
+
+}} // facebook::fboss
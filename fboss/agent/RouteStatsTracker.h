@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <boost/container/flat_map.hpp>
+#include <folly/IPAddressV4.h>
+#include <folly/IPAddressV6.h>
+#include <folly/SpinLock.h>
+
+#include "fboss/agent/StateObserver.h"
+#include "fboss/agent/types.h"
+
+namespace facebook { namespace fboss {
+
+class StateDelta;
+
+/*
+ * Incrementally maintained route table statistics.
+ *
+ * Computing route counts by walking the route tables is O(number of
+ * routes) work, which is too expensive to repeat on every stats interval
+ * once the tables hold hundreds of thousands of routes. This observer
+ * keeps the counts up to date from state deltas instead: each update only
+ * touches the routes that actually changed, so reading the statistics is
+ * O(1), and breakdowns (per prefix length, per client) that would be
+ * unaffordable to recompute by scanning come essentially for free.
+ *
+ * Counts are updated on the update thread via stateUpdated() and read
+ * from the stats publishing thread via getRouteStats(); a spin lock
+ * protects the (small) aggregate structures.
+ */
+class RouteStatsTracker : public AutoRegisterStateObserver {
+ public:
+  struct RouteStats {
+    int64_t v4Routes{0};
+    int64_t v6Routes{0};
+    // Route counts indexed by prefix length.
+    int64_t v4RoutesByMaskLen[33] = {0};
+    int64_t v6RoutesByMaskLen[129] = {0};
+    // Number of routes each client has next hops for. Entries that drop
+    // to zero are kept, so published counters get zeroed rather than
+    // going stale.
+    boost::container::flat_map<ClientID, int64_t> routesByClient;
+  };
+
+  explicit RouteStatsTracker(SwSwitch* sw);
+  ~RouteStatsTracker() override = default;
+
+  void stateUpdated(const StateDelta& delta) override;
+
+  // Return a copy of the current statistics.
+  RouteStats getRouteStats() const;
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  RouteStatsTracker(RouteStatsTracker const&) = delete;
+  RouteStatsTracker& operator=(RouteStatsTracker const&) = delete;
+
+  // Process route changes
+  template <typename RouteT>
+  void processChangedRoute(
+      const std::shared_ptr<RouteT>& oldRoute,
+      const std::shared_ptr<RouteT>& newRoute);
+  template <typename RouteT>
+  void processAddedRoute(const std::shared_ptr<RouteT>& newRoute);
+  template <typename RouteT>
+  void processRemovedRoute(const std::shared_ptr<RouteT>& oldRoute);
+
+  // Add sign (+1 or -1) to every count the route contributes to.
+  // The caller must hold lock_.
+  template <typename RouteT>
+  void accountRoute(const std::shared_ptr<RouteT>& route, int64_t sign);
+  // The caller must hold lock_.
+  void adjustClientCount(ClientID clientId, int64_t sign);
+
+  // Overloads selecting the per-family counters by address type.
+  int64_t* totalFor(const folly::IPAddressV4& /* network */) {
+    return &stats_.v4Routes;
+  }
+  int64_t* totalFor(const folly::IPAddressV6& /* network */) {
+    return &stats_.v6Routes;
+  }
+  int64_t* maskLenCountersFor(const folly::IPAddressV4& /* network */) {
+    return stats_.v4RoutesByMaskLen;
+  }
+  int64_t* maskLenCountersFor(const folly::IPAddressV6& /* network */) {
+    return stats_.v6RoutesByMaskLen;
+  }
+
+  mutable folly::SpinLock lock_;
+  RouteStats stats_;
+};
+
+}} // facebook::fboss
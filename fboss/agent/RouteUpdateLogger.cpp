@@ -11,47 +11,14 @@
 #include "RouteUpdateLogger.h"
 #include "fboss/agent/state/DeltaFunctions.h"
 
-namespace facebook {
-namespace fboss {
+#include <chrono>
 
-namespace {
-template <typename AddrT>
-void handleChangedRoute(
-    const RouteUpdateLoggingPrefixTracker& tracker,
-    const std::unique_ptr<RouteLogger<AddrT>>& logger,
-    const std::shared_ptr<Route<AddrT>>& oldRoute,
-    const std::shared_ptr<Route<AddrT>>& newRoute) {
-  std::vector<std::string> matchedIdentifiers;
-  auto prefix = oldRoute->prefix();
-  if (tracker.tracking(prefix, matchedIdentifiers)) {
-    logger->logChangedRoute(oldRoute, newRoute, matchedIdentifiers);
-  }
-}
-
-template <typename AddrT>
-void handleRemovedRoute(
-    const RouteUpdateLoggingPrefixTracker& tracker,
-    const std::unique_ptr<RouteLogger<AddrT>>& logger,
-    const std::shared_ptr<Route<AddrT>>& oldRoute) {
-  std::vector<std::string> matchedIdentifiers;
-  auto prefix = oldRoute->prefix();
-  if (tracker.tracking(prefix, matchedIdentifiers)) {
-    logger->logRemovedRoute(oldRoute, matchedIdentifiers);
-  }
-}
+DEFINE_int32(route_update_log_queue_size, 65536,
+             "Capacity of the route update logging capture queue; records "
+             "beyond this are dropped rather than stalling state updates");
 
-template <typename AddrT>
-void handleAddedRoute(
-    const RouteUpdateLoggingPrefixTracker& tracker,
-    const std::unique_ptr<RouteLogger<AddrT>>& logger,
-    const std::shared_ptr<Route<AddrT>>& newRoute) {
-  std::vector<std::string> matchedIdentifiers;
-  auto prefix = newRoute->prefix();
-  if (tracker.tracking(prefix, matchedIdentifiers)) {
-    logger->logAddedRoute(newRoute, matchedIdentifiers);
-  }
-}
-} // anonymous namespace
+namespace facebook {
+namespace fboss {
 
 RouteUpdateLogger::RouteUpdateLogger(SwSwitch* sw)
     : RouteUpdateLogger(
@@ -61,26 +28,135 @@ RouteUpdateLogger::RouteUpdateLogger(
     SwSwitch* sw,
     std::unique_ptr<RouteLogger<folly::IPAddressV4>> routeLoggerV4,
     std::unique_ptr<RouteLogger<folly::IPAddressV6>> routeLoggerV6)
-    : AutoRegisterStateObserver(sw, "RouteUpdateLogger"),
+    : AutoRegisterStateObserver(sw, "RouteUpdateLogger",
+                                INTEREST_ROUTE_TABLES),
       routeLoggerV4_(std::move(routeLoggerV4)),
-      routeLoggerV6_(std::move(routeLoggerV6)) {}
+      routeLoggerV6_(std::move(routeLoggerV6)),
+      recordQueue_(FLAGS_route_update_log_queue_size) {
+  formatThread_ = std::thread([this] { formatLoop(); });
+}
+
+RouteUpdateLogger::~RouteUpdateLogger() {
+  // A default-constructed record is the STOP sentinel; it is written
+  // blocking so the formatter drains everything captured before it.
+  recordQueue_.blockingWrite(UpdateRecord());
+  formatThread_.join();
+}
 
 void RouteUpdateLogger::stateUpdated(const StateDelta& delta) {
   for (const auto& rtDelta : delta.getRouteTablesDelta()) {
     DeltaFunctions::forEachChanged(
         rtDelta.getRoutesV4Delta(),
-        &handleChangedRoute<folly::IPAddressV4>,
-        &handleAddedRoute<folly::IPAddressV4>,
-        &handleRemovedRoute<folly::IPAddressV4>,
-        prefixTracker_,
-        routeLoggerV4_);
+        [&](const std::shared_ptr<RouteV4>& oldRoute,
+            const std::shared_ptr<RouteV4>& newRoute) {
+          captureRoute(UpdateRecord::Type::CHANGED, oldRoute, newRoute);
+        },
+        [&](const std::shared_ptr<RouteV4>& newRoute) {
+          captureRoute<folly::IPAddressV4>(UpdateRecord::Type::ADDED,
+                                           nullptr, newRoute);
+        },
+        [&](const std::shared_ptr<RouteV4>& oldRoute) {
+          captureRoute<folly::IPAddressV4>(UpdateRecord::Type::REMOVED,
+                                           oldRoute, nullptr);
+        });
     DeltaFunctions::forEachChanged(
         rtDelta.getRoutesV6Delta(),
-        &handleChangedRoute<folly::IPAddressV6>,
-        &handleAddedRoute<folly::IPAddressV6>,
-        &handleRemovedRoute<folly::IPAddressV6>,
-        prefixTracker_,
-        routeLoggerV6_);
+        [&](const std::shared_ptr<RouteV6>& oldRoute,
+            const std::shared_ptr<RouteV6>& newRoute) {
+          captureRoute(UpdateRecord::Type::CHANGED, oldRoute, newRoute);
+        },
+        [&](const std::shared_ptr<RouteV6>& newRoute) {
+          captureRoute<folly::IPAddressV6>(UpdateRecord::Type::ADDED,
+                                           nullptr, newRoute);
+        },
+        [&](const std::shared_ptr<RouteV6>& oldRoute) {
+          captureRoute<folly::IPAddressV6>(UpdateRecord::Type::REMOVED,
+                                           oldRoute, nullptr);
+        });
+  }
+}
+
+template <typename AddrT>
+void RouteUpdateLogger::captureRoute(
+    UpdateRecord::Type type,
+    const std::shared_ptr<Route<AddrT>>& oldRoute,
+    const std::shared_ptr<Route<AddrT>>& newRoute) {
+  std::vector<std::string> matchedIdentifiers;
+  const auto& prefix = oldRoute ? oldRoute->prefix() : newRoute->prefix();
+  if (!prefixTracker_.tracking(prefix, matchedIdentifiers)) {
+    return;
+  }
+  UpdateRecord record;
+  record.type = type;
+  setRoutes(&record, oldRoute, newRoute);
+  record.identifiers = std::move(matchedIdentifiers);
+  enqueue(std::move(record));
+}
+
+void RouteUpdateLogger::enqueue(UpdateRecord&& record) {
+  if (!recordQueue_.write(std::move(record))) {
+    // Shedding is preferable to stalling the update thread; the count
+    // tells an operator their logging subscription is too broad for the
+    // formatter to keep up with.
+    auto dropped = droppedRecords_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (dropped % 10000 == 1) {
+      LOG(WARNING) << "route update log queue full; dropped " << dropped
+                   << " records so far";
+    }
+    return;
+  }
+  enqueuedRecords_.fetch_add(1, std::memory_order_release);
+}
+
+void RouteUpdateLogger::formatLoop() {
+  while (true) {
+    UpdateRecord record;
+    recordQueue_.blockingRead(record);
+    if (record.type == UpdateRecord::Type::STOP) {
+      return;
+    }
+    writeRecord(record);
+    writtenRecords_.fetch_add(1, std::memory_order_release);
+  }
+}
+
+void RouteUpdateLogger::writeRecord(const UpdateRecord& record) {
+  switch (record.type) {
+    case UpdateRecord::Type::ADDED:
+      if (record.newRouteV4) {
+        routeLoggerV4_->logAddedRoute(record.newRouteV4, record.identifiers);
+      } else {
+        routeLoggerV6_->logAddedRoute(record.newRouteV6, record.identifiers);
+      }
+      break;
+    case UpdateRecord::Type::CHANGED:
+      if (record.newRouteV4) {
+        routeLoggerV4_->logChangedRoute(record.oldRouteV4, record.newRouteV4,
+                                        record.identifiers);
+      } else {
+        routeLoggerV6_->logChangedRoute(record.oldRouteV6, record.newRouteV6,
+                                        record.identifiers);
+      }
+      break;
+    case UpdateRecord::Type::REMOVED:
+      if (record.oldRouteV4) {
+        routeLoggerV4_->logRemovedRoute(record.oldRouteV4,
+                                        record.identifiers);
+      } else {
+        routeLoggerV6_->logRemovedRoute(record.oldRouteV6,
+                                        record.identifiers);
+      }
+      break;
+    case UpdateRecord::Type::STOP:
+      break;
+  }
+}
+
+void RouteUpdateLogger::flush() const {
+  auto target = enqueuedRecords_.load(std::memory_order_acquire);
+  while (writtenRecords_.load(std::memory_order_acquire) < target) {
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
 }
 
@@ -89,6 +165,11 @@ void RouteUpdateLogger::startLoggingForPrefix(
   prefixTracker_.track(req);
 }
 
+void RouteUpdateLogger::startLoggingForPrefixes(
+    const std::vector<RouteUpdateLoggingInstance>& reqs) {
+  prefixTracker_.track(reqs);
+}
+
 void RouteUpdateLogger::stopLoggingForPrefix(
     const folly::IPAddress& network,
     uint8_t mask,
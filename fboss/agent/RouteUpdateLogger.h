@@ -15,8 +15,11 @@
 #include "fboss/agent/state/RouteTypes.h"
 #include "fboss/agent/state/StateDelta.h"
 #include <folly/IPAddress.h>
+#include <folly/MPMCQueue.h>
 
+#include <atomic>
 #include <memory>
+#include <thread>
 #include <vector>
 
 namespace facebook { namespace fboss {
@@ -77,6 +80,15 @@ class GlogRouteLogger : public RouteLogger<AddrT> {
  * (or more specific location with that prefix) is added, removed, or
  * changes, log that information. The logger is pluggable, but by default
  * we use GLOG.
+ *
+ * Logging is asynchronous: the observer callback only copies route
+ * pointers into a bounded queue (routes are immutable once published,
+ * so formatting them later is safe), and a background thread does all
+ * the string formatting and writing.  This keeps the per-route cost on
+ * the update thread tiny even when a subscription like 0.0.0.0/0
+ * matches every route during convergence.  If the formatter cannot keep
+ * up, further records are dropped and counted rather than stalling
+ * state updates.
  */
 class RouteUpdateLogger : public AutoRegisterStateObserver {
  public:
@@ -86,10 +98,22 @@ class RouteUpdateLogger : public AutoRegisterStateObserver {
       std::unique_ptr<RouteLogger<folly::IPAddressV4>> routeLoggerV4,
       std::unique_ptr<RouteLogger<folly::IPAddressV6>> routeLoggerV6);
 
-  ~RouteUpdateLogger() override = default;
+  ~RouteUpdateLogger() override;
 
   void stateUpdated(const StateDelta& delta) override;
+
+  /*
+   * Block until every record captured so far has been formatted and
+   * written.  Mostly useful in tests.
+   */
+  void flush() const;
+
+  uint64_t getDroppedRecordCount() const {
+    return droppedRecords_.load(std::memory_order_relaxed);
+  }
   void startLoggingForPrefix(const RouteUpdateLoggingInstance& req);
+  void startLoggingForPrefixes(
+      const std::vector<RouteUpdateLoggingInstance>& reqs);
   void stopLoggingForPrefix(
       const folly::IPAddress& network,
       uint8_t mask,
@@ -105,13 +129,58 @@ class RouteUpdateLogger : public AutoRegisterStateObserver {
   }
 
  private:
+  /*
+   * A captured route change, format deferred.  Exactly one family's
+   * route pointers are set; STOP is a sentinel that shuts the formatter
+   * thread down.
+   */
+  struct UpdateRecord {
+    enum class Type { ADDED, CHANGED, REMOVED, STOP };
+    Type type{Type::STOP};
+    std::shared_ptr<RouteV4> oldRouteV4;
+    std::shared_ptr<RouteV4> newRouteV4;
+    std::shared_ptr<RouteV6> oldRouteV6;
+    std::shared_ptr<RouteV6> newRouteV6;
+    std::vector<std::string> identifiers;
+  };
+
   static std::unique_ptr<RouteLogger<folly::IPAddressV4>>
     getDefaultV4RouteLogger();
   static std::unique_ptr<RouteLogger<folly::IPAddressV6>>
     getDefaultV6RouteLogger();
+
+  static void setRoutes(UpdateRecord* record,
+                        const std::shared_ptr<RouteV4>& oldRoute,
+                        const std::shared_ptr<RouteV4>& newRoute) {
+    record->oldRouteV4 = oldRoute;
+    record->newRouteV4 = newRoute;
+  }
+  static void setRoutes(UpdateRecord* record,
+                        const std::shared_ptr<RouteV6>& oldRoute,
+                        const std::shared_ptr<RouteV6>& newRoute) {
+    record->oldRouteV6 = oldRoute;
+    record->newRouteV6 = newRoute;
+  }
+
+  // Capture stage, run in the observer callback.
+  template <typename AddrT>
+  void captureRoute(UpdateRecord::Type type,
+                    const std::shared_ptr<Route<AddrT>>& oldRoute,
+                    const std::shared_ptr<Route<AddrT>>& newRoute);
+  void enqueue(UpdateRecord&& record);
+
+  // Format stage, run on the background thread.
+  void formatLoop();
+  void writeRecord(const UpdateRecord& record);
+
   RouteUpdateLoggingPrefixTracker prefixTracker_;
   std::unique_ptr<RouteLogger<folly::IPAddressV4>> routeLoggerV4_;
   std::unique_ptr<RouteLogger<folly::IPAddressV6>> routeLoggerV6_;
+  folly::MPMCQueue<UpdateRecord> recordQueue_;
+  std::atomic<uint64_t> enqueuedRecords_{0};
+  std::atomic<uint64_t> writtenRecords_{0};
+  std::atomic<uint64_t> droppedRecords_{0};
+  std::thread formatThread_;
 };
 
 }} // facebook::fboss
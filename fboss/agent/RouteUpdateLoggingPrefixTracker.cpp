@@ -27,15 +27,32 @@ void RouteUpdateLoggingPrefixTracker::track(
     const RouteUpdateLoggingInstance& req) {
   LOG(INFO) << "Tracking " << req.str();
   SYNCHRONIZED(trackedPrefixes_) {
-    auto found = trackedPrefixes_[req.identifier].insert(
-        req.prefix.network, req.prefix.mask, req);
-    // Use the most recently set configuration
-    if (!found.second) {
-      found.first.value() = req;
+    trackLocked(trackedPrefixes_, req);
+  }
+}
+
+void RouteUpdateLoggingPrefixTracker::track(
+    const std::vector<RouteUpdateLoggingInstance>& reqs) {
+  LOG(INFO) << "Tracking " << reqs.size() << " prefixes";
+  SYNCHRONIZED(trackedPrefixes_) {
+    for (const auto& req : reqs) {
+      VLOG(2) << "Tracking " << req.str();
+      trackLocked(trackedPrefixes_, req);
     }
   }
 }
 
+void RouteUpdateLoggingPrefixTracker::trackLocked(
+    TrackedPrefixes& trackedPrefixes,
+    const RouteUpdateLoggingInstance& req) {
+  auto found = trackedPrefixes[req.identifier].insert(
+      req.prefix.network, req.prefix.mask, req);
+  // Use the most recently set configuration
+  if (!found.second) {
+    found.first.value() = req;
+  }
+}
+
 // stop tracking a particular requested prefix
 void RouteUpdateLoggingPrefixTracker::stopTracking(
     const RoutePrefix<folly::IPAddress>& prefix,
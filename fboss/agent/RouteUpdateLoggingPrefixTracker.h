@@ -53,6 +53,13 @@ class RouteUpdateLoggingPrefixTracker {
    * track allowing for longest match, tracking() will use longest match.
    */
   void track(const RouteUpdateLoggingInstance& req);
+  /*
+   * Start tracking a batch of prefixes under a single lock acquisition.
+   * Preferable to repeated track() calls when enabling tracking for many
+   * prefixes at once, since route updates arriving in between only contend
+   * for the lock once.
+   */
+  void track(const std::vector<RouteUpdateLoggingInstance>& reqs);
   // Stop a particular tracking instance
   void stopTracking(
       const RoutePrefix<folly::IPAddress>& prefix,
@@ -75,13 +82,16 @@ class RouteUpdateLoggingPrefixTracker {
   }
 
  private:
+  using TrackedPrefixes = std::unordered_map<
+      std::string,
+      network::RadixTree<folly::IPAddress, RouteUpdateLoggingInstance>>;
   bool trackingImpl(
       const RoutePrefix<folly::IPAddress>& prefix,
       std::vector<std::string>& identifiers) const;
-  folly::Synchronized<std::unordered_map<
-      std::string,
-      network::RadixTree<folly::IPAddress, RouteUpdateLoggingInstance>>>
-      trackedPrefixes_;
+  static void trackLocked(
+      TrackedPrefixes& trackedPrefixes,
+      const RouteUpdateLoggingInstance& req);
+  folly::Synchronized<TrackedPrefixes> trackedPrefixes_;
 };
 
 }} // facebook::fboss
@@ -12,8 +12,13 @@
 #include "fboss/agent/Packet.h"
 #include "fboss/agent/types.h"
 
+#include <chrono>
 #include <string>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 namespace facebook { namespace fboss {
 
 /*
@@ -39,6 +44,18 @@ class RxPacket : public Packet {
   uint32_t getLength() const {
     return len_;
   }
+  /*
+   * Whether this packet is a sampled copy of forwarded traffic (e.g.
+   * trapped with the hardware sampler rx reason) rather than a packet
+   * addressed to the switch. Sampled packets feed the flow sampler and
+   * skip the protocol handlers.
+   */
+  bool isSampled() const {
+    return sampled_;
+  }
+  void setSampled(bool sampled) {
+    sampled_ = sampled;
+  }
   /**
    * Get the router ID of the packet
    */
@@ -47,6 +64,120 @@ class RxPacket : public Packet {
     return RouterID(0);
   }
 
+  /*
+   * Header offset annotations.
+   *
+   * The packet handlers record where each layer starts as they parse the
+   * frame, so that downstream consumers (TunIntf, the DHCP relay, packet
+   * capture) can work directly on the underlying buffer rather than
+   * re-parsing or copying it. An offset of 0 means the layer has not been
+   * annotated (the L2 header always starts at 0).
+   */
+  uint32_t getL3HdrOffset() const {
+    return l3HdrOffset_;
+  }
+  void setL3HdrOffset(uint32_t offset) {
+    l3HdrOffset_ = offset;
+  }
+  uint32_t getL4HdrOffset() const {
+    return l4HdrOffset_;
+  }
+  void setL4HdrOffset(uint32_t offset) {
+    l4HdrOffset_ = offset;
+  }
+
+  /*
+   * Parse-once demux context.
+   *
+   * The first cursor walk over the frame (the rx dispatcher's
+   * classifier, or handlePacket() itself when dispatch threads are
+   * disabled) caches what it learned here: the ethertype behind any
+   * VLAN tag and, for IP packets, the L4 protocol from the fixed part
+   * of the IP header. Later stages demux on the cached values instead
+   * of walking the same headers again.
+   */
+  static constexpr uint8_t kL4ProtoUnknown = 0xff;
+  bool hasParseContext() const {
+    return hasParseCtx_;
+  }
+  uint16_t getEthertype() const {
+    return ethertype_;
+  }
+  uint8_t getL4Proto() const {
+    return l4Proto_;
+  }
+  void setParseContext(uint16_t ethertype, uint8_t l4Proto) {
+    ethertype_ = ethertype;
+    l4Proto_ = l4Proto;
+    hasParseCtx_ = true;
+  }
+
+  /*
+   * Arrival timestamps.
+   *
+   * Stamped by the hardware-specific subclass as soon as the SDK hands
+   * the packet to its rx callback, before any queueing or dispatch.
+   * OpenNSL does not surface the ASIC's own rx timestamp, so this is
+   * the closest software can get to the punt time. The TSC stamp feeds
+   * the latency tracing histograms below (arrival to dispatch covers
+   * the rx callback itself); the wall-clock stamp gives packet captures
+   * a true arrival time instead of the time the capture thread got
+   * around to the packet. An arrival TSC of 0 means the packet was
+   * never stamped (e.g. packets injected by tests).
+   */
+  void stampArrival() {
+    arrivalTsc_ = readTsc();
+    arrivalTime_ = std::chrono::system_clock::now();
+  }
+  uint64_t getArrivalTsc() const {
+    return arrivalTsc_;
+  }
+  std::chrono::system_clock::time_point getArrivalTime() const {
+    return arrivalTime_;
+  }
+
+  /*
+   * Slow-path latency tracing.
+   *
+   * A sampled subset of trapped packets (see --rx_pkt_trace_interval)
+   * carries TSC timestamps stamped as the packet moves through the
+   * pipeline: when it is handed to the switch, when classification
+   * starts, when the protocol handler is entered, and when it is
+   * forwarded to tx or the host. The deltas between consecutive stages
+   * are aggregated into per-stage histograms in SwitchStats, telling us
+   * whether a slow-path latency spike comes from queueing, parsing or
+   * handler work. traceStamp() is a single branch plus rdtsc for
+   * sampled packets and just the branch for everyone else.
+   */
+  enum TraceStage : uint8_t {
+    TRACE_DISPATCH = 0,  // handed to SwSwitch by the hardware rx path
+    TRACE_CLASSIFY = 1,  // dequeued, classification starting
+    TRACE_HANDLER = 2,   // entering the protocol handler
+    TRACE_FORWARD = 3,   // forwarded to tx or the host
+    TRACE_NUM_STAGES = 4,
+  };
+  bool isTraced() const {
+    return traced_;
+  }
+  void enableTrace() {
+    traced_ = true;
+  }
+  void traceStamp(TraceStage stage) {
+    if (traced_) {
+      traceTsc_[stage] = readTsc();
+    }
+  }
+  uint64_t getTraceTsc(TraceStage stage) const {
+    return traceTsc_[stage];
+  }
+  static uint64_t readTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+  }
+
   /*
    * Return a human-readable string describing additional detailed information
    * about the packet.
@@ -62,6 +193,16 @@ class RxPacket : public Packet {
   PortID srcPort_{0};
   VlanID srcVlan_{0};
   uint32_t len_{0};
+  uint32_t l3HdrOffset_{0};
+  uint32_t l4HdrOffset_{0};
+  uint16_t ethertype_{0};
+  uint8_t l4Proto_{kL4ProtoUnknown};
+  bool hasParseCtx_{false};
+  bool sampled_{false};
+  uint64_t arrivalTsc_{0};
+  std::chrono::system_clock::time_point arrivalTime_;
+  bool traced_{false};
+  uint64_t traceTsc_[TRACE_NUM_STAGES] = {0};
 };
 
 }} // facebook::fboss
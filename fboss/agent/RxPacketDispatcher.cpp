@@ -0,0 +1,199 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/RxPacketDispatcher.h"
+
+#include <folly/ThreadName.h>
+#include <folly/io/Cursor.h>
+
+#include "fboss/agent/RxPacket.h"
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/SwitchStats.h"
+#include "fboss/agent/packet/Ethertype.h"
+#include "fboss/agent/packet/ICMPHdr.h"
+#include "fboss/agent/packet/IPProto.h"
+
+DEFINE_bool(rx_dispatch_threads, true,
+            "Dispatch trapped packets to per-class rings served by "
+            "dedicated threads instead of handling them all on the "
+            "HwSwitch rx thread");
+DEFINE_int32(rx_ring_depth, 1024,
+             "Depth of each per-class rx packet ring. When a ring is full "
+             "further packets of that class are dropped.");
+
+using folly::io::Cursor;
+
+namespace {
+const char* ringThreadName(uint8_t cls) {
+  switch (cls) {
+    case facebook::fboss::RxPacketDispatcher::PROTOCOL:
+      return "fbossRxProto";
+    case facebook::fboss::RxPacketDispatcher::NEIGHBOR:
+      return "fbossRxNbr";
+    default:
+      return "fbossRxOther";
+  }
+}
+}
+
+namespace facebook { namespace fboss {
+
+RxPacketDispatcher::RxPacketDispatcher(SwSwitch* sw) : sw_(sw) {
+  for (size_t cls = 0; cls < kNumClasses; ++cls) {
+    rings_[cls] = std::make_unique<Ring>(FLAGS_rx_ring_depth);
+  }
+}
+
+RxPacketDispatcher::~RxPacketDispatcher() {
+  stop();
+}
+
+void RxPacketDispatcher::start() {
+  for (size_t cls = 0; cls < kNumClasses; ++cls) {
+    auto packetClass = static_cast<PacketClass>(cls);
+    rings_[cls]->thread = std::thread([this, packetClass] {
+      folly::setThreadName(pthread_self(), ringThreadName(packetClass));
+      SwSwitch::applyThreadScheduling(ringThreadName(packetClass));
+      serveRing(packetClass);
+    });
+  }
+}
+
+void RxPacketDispatcher::stop() {
+  if (stopping_.exchange(true)) {
+    return;
+  }
+  for (const auto& ring : rings_) {
+    {
+      std::lock_guard<std::mutex> g(ring->mutex);
+    }
+    ring->cv.notify_one();
+  }
+  for (const auto& ring : rings_) {
+    if (ring->thread.joinable()) {
+      ring->thread.join();
+    }
+  }
+}
+
+void RxPacketDispatcher::packetReceived(
+    std::unique_ptr<RxPacket> pkt) noexcept {
+  auto cls = classify(pkt.get());
+  auto* ring = rings_[cls].get();
+  if (!ring->queue.write(std::move(pkt))) {
+    // The ring is full. Drop the packet rather than blocking the rx
+    // thread; a flood in one class must not back up the others.
+    countDrop(cls);
+    return;
+  }
+  // The empty critical section makes sure the notify cannot race with
+  // the handler thread going to sleep between its empty-check and wait.
+  {
+    std::lock_guard<std::mutex> g(ring->mutex);
+  }
+  ring->cv.notify_one();
+}
+
+RxPacketDispatcher::PacketClass
+RxPacketDispatcher::classify(RxPacket* pkt) noexcept {
+  if (pkt->isSampled()) {
+    // Flow samples of forwarded traffic must never queue ahead of
+    // protocol packets, whatever their payload looks like.
+    return OTHER;
+  }
+  try {
+    Cursor c(pkt->buf());
+    c += 12; // src mac + dst mac
+    auto ethertype = c.readBE<uint16_t>();
+    if (ethertype == ETHERTYPE_VLAN) {
+      c += 2; // VLAN tag
+      ethertype = c.readBE<uint16_t>();
+    }
+    // This is the first walk over the frame; annotate what it finds so
+    // handlePacket() and the host demux don't repeat it.
+    pkt->setL3HdrOffset(c - Cursor(pkt->buf()));
+    uint8_t l4Proto = RxPacket::kL4ProtoUnknown;
+    PacketClass cls = OTHER;
+    switch (ethertype) {
+      case ETHERTYPE_ARP:
+        cls = NEIGHBOR;
+        break;
+      case ETHERTYPE_LLDP:
+        cls = PROTOCOL;
+        break;
+      case ETHERTYPE_IPV4: {
+        c += 9; // to the protocol field
+        l4Proto = c.read<uint8_t>();
+        if (l4Proto == IP_PROTO_TCP) {
+          cls = PROTOCOL;
+        }
+        break;
+      }
+      case ETHERTYPE_IPV6: {
+        c += 6; // to the next header field
+        l4Proto = c.read<uint8_t>();
+        if (l4Proto == IP_PROTO_TCP) {
+          cls = PROTOCOL;
+        } else if (l4Proto == IP_PROTO_IPV6_ICMP) {
+          c += 33; // rest of the fixed IPv6 header, to the ICMPv6 type
+          auto icmpType = c.read<uint8_t>();
+          if (icmpType >= ICMPV6_TYPE_NDP_ROUTER_SOLICITATION &&
+              icmpType <= ICMPV6_TYPE_NDP_REDIRECT_MESSAGE) {
+            cls = NEIGHBOR;
+          }
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    pkt->setParseContext(ethertype, l4Proto);
+    return cls;
+  } catch (const std::out_of_range&) {
+    // Too short to parse; let the regular handler path count it as bogus
+    return OTHER;
+  }
+}
+
+void RxPacketDispatcher::serveRing(PacketClass cls) {
+  SwSwitch::markPacketPathThread();
+  auto* ring = rings_[cls].get();
+  while (true) {
+    {
+      std::unique_lock<std::mutex> l(ring->mutex);
+      ring->cv.wait(l, [&] {
+        return stopping_.load() || !ring->queue.isEmpty();
+      });
+    }
+    std::unique_ptr<RxPacket> pkt;
+    while (ring->queue.read(pkt)) {
+      sw_->processRxPacket(std::move(pkt));
+    }
+    if (stopping_.load()) {
+      // Drained above after stopping_ was set, so nothing is left behind
+      return;
+    }
+  }
+}
+
+void RxPacketDispatcher::countDrop(PacketClass cls) noexcept {
+  switch (cls) {
+    case PROTOCOL:
+      sw_->stats()->rxRingDropProtocol();
+      break;
+    case NEIGHBOR:
+      sw_->stats()->rxRingDropNeighbor();
+      break;
+    case OTHER:
+      sw_->stats()->rxRingDropOther();
+      break;
+  }
+}
+
+}} // facebook::fboss
@@ -0,0 +1,97 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <folly/ProducerConsumerQueue.h>
+
+namespace facebook { namespace fboss {
+
+class RxPacket;
+class SwSwitch;
+
+/*
+ * RxPacketDispatcher fans trapped packets out of the HwSwitch rx callback
+ * into per-class rings, each served by a dedicated handler thread.
+ *
+ * Without it every trapped packet runs through SwSwitch::handlePacket on
+ * the rx thread, so a flood of low priority traffic (e.g. an ARP storm)
+ * queues ahead of protocol traffic and can delay BGP keepalives. With the
+ * dispatcher, a cheap classifier peeks at the L2/L3 headers and enqueues
+ * the packet on the ring for its class. Each ring is a single-producer
+ * single-consumer lock free queue; when a ring fills up, further packets
+ * of that class are dropped and counted, leaving the other classes
+ * unaffected.
+ */
+class RxPacketDispatcher {
+ public:
+  enum PacketClass : uint8_t {
+    // Routing/control protocol traffic (TCP e.g. BGP, LLDP)
+    PROTOCOL = 0,
+    // Neighbor discovery (ARP, NDP)
+    NEIGHBOR = 1,
+    // Everything else (sampled packets, packets for the host, ...)
+    OTHER = 2,
+  };
+  static constexpr size_t kNumClasses = 3;
+
+  explicit RxPacketDispatcher(SwSwitch* sw);
+  ~RxPacketDispatcher();
+
+  void start();
+  void stop();
+
+  /*
+   * Classify a trapped packet and enqueue it on the ring for its class.
+   * Called on the HwSwitch rx thread. If the ring is full the packet is
+   * dropped and the ring's drop counter incremented.
+   */
+  void packetReceived(std::unique_ptr<RxPacket> pkt) noexcept;
+
+  /*
+   * Peek at the L2/L3 headers to decide which ring a packet belongs to.
+   * Anything we fail to parse goes to the OTHER ring. As the first
+   * walk over the frame this also annotates the packet with its parse
+   * context (L3 offset, ethertype, L4 protocol), so the handler chain
+   * demuxes on the cached values instead of re-walking the headers.
+   */
+  static PacketClass classify(RxPacket* pkt) noexcept;
+
+ private:
+  struct Ring {
+    explicit Ring(uint32_t depth) : queue(depth) {}
+
+    folly::ProducerConsumerQueue<std::unique_ptr<RxPacket>> queue;
+    // The queue itself is lock free; the mutex only guards the condition
+    // variable used to wake the handler thread up.
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+  };
+
+  // Handler thread loop for one ring
+  void serveRing(PacketClass cls);
+  void countDrop(PacketClass cls) noexcept;
+
+  // No copy or assignment.
+  RxPacketDispatcher(const RxPacketDispatcher&) = delete;
+  RxPacketDispatcher& operator=(const RxPacketDispatcher&) = delete;
+
+  SwSwitch* sw_{nullptr};
+  std::unique_ptr<Ring> rings_[kNumClasses];
+  std::atomic<bool> stopping_{false};
+};
+
+}} // facebook::fboss
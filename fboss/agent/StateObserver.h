@@ -22,9 +22,10 @@ class StateObserver : public boost::noncopyable {
 
 class AutoRegisterStateObserver : public StateObserver {
  public:
-  AutoRegisterStateObserver(SwSwitch* sw, const std::string name)
+  AutoRegisterStateObserver(SwSwitch* sw, const std::string name,
+                            uint32_t interests = INTEREST_ALL)
       : sw_(sw) {
-    sw_->registerStateObserver(this, name);
+    sw_->registerStateObserver(this, name, interests);
   }
   ~AutoRegisterStateObserver() override { sw_->unregisterStateObserver(this); }
 
@@ -12,42 +12,79 @@
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include "fboss/agent/ArpHandler.h"
+#include "fboss/agent/BootProfiler.h"
 #include "fboss/agent/Constants.h"
+#include "fboss/agent/IcmpErrorRateLimiter.h"
+#include "fboss/agent/InternedString.h"
 #include "fboss/agent/IPv4Handler.h"
 #include "fboss/agent/IPv6Handler.h"
+#include "fboss/agent/DhcpRelayTable.h"
+#include "fboss/agent/DhcpTransactionCache.h"
+#include "fboss/agent/HostDemuxTable.h"
+#include "fboss/agent/NeighborResponseIndex.h"
+#include "fboss/agent/PortSendContextTable.h"
+#include "fboss/agent/RouteStatsTracker.h"
 #include "fboss/agent/RouteUpdateLogger.h"
 #include "fboss/agent/NeighborUpdater.h"
 #include "fboss/agent/UnresolvedNhopsProber.h"
+#include "fboss/agent/UpdateJournal.h"
 #include "fboss/agent/FbossError.h"
+#include "fboss/agent/FlowSampler.h"
 #include "fboss/agent/HwSwitch.h"
+#include "fboss/agent/HighresShmExporter.h"
 #include "fboss/agent/Platform.h"
 #include "fboss/agent/PortStats.h"
 #include "fboss/agent/RxPacket.h"
+#include "fboss/agent/RxPacketDispatcher.h"
 #include "fboss/agent/TunManager.h"
 #include "fboss/agent/TxPacket.h"
 #include "fboss/agent/SwitchStats.h"
 #include "fboss/agent/Utils.h"
 #include "fboss/agent/capture/PktCaptureManager.h"
 #include "fboss/agent/packet/EthHdr.h"
+#include "fboss/agent/packet/IPProto.h"
 #include "fboss/agent/packet/IPv4Hdr.h"
 #include "fboss/agent/packet/IPv6Hdr.h"
 #include "fboss/agent/packet/PktUtil.h"
+#include "fboss/lib/HugePages.h"
+#include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/state/ArpTable.h"
+#include "fboss/agent/state/NdpTable.h"
+#include "fboss/agent/state/NodeCloneProfiler.h"
+#include "fboss/agent/state/Port.h"
+#include "fboss/agent/state/PortMap.h"
+#include "fboss/agent/state/PublishTracker.h"
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/RouteTableMap.h"
+#include "fboss/agent/state/RouteTableRib.h"
+#include "fboss/agent/state/RouteUpdater.h"
+#include "fboss/agent/state/gen-cpp2/switch_state_types.h"
 #include "fboss/agent/state/StateDelta.h"
 #include "fboss/agent/state/StateUpdateHelpers.h"
 #include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
 #include "fboss/agent/ApplyThriftConfig.h"
 #include "fboss/agent/LldpManager.h"
+#include "fboss/agent/PeriodicScheduler.h"
 #include "fboss/agent/PortRemediator.h"
 #include "fboss/agent/gen-cpp2/switch_config_types_custom_protocol.h"
 #include "common/stats/ServiceData.h"
 #include <folly/FileUtil.h>
+#include <folly/Hash.h>
+#include <folly/json.h>
 #include <folly/MacAddress.h>
 #include <folly/String.h>
 #include <folly/Demangle.h>
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
 #include <glog/logging.h>
 
+#include <pthread.h>
+#include <sched.h>
+
 using folly::EventBase;
 using folly::io::Cursor;
 using folly::io::RWPrivateCursor;
@@ -65,9 +102,101 @@ using namespace std::chrono;
 
 DEFINE_string(config, "", "The path to the local JSON configuration file");
 DEFINE_int32(thread_heartbeat_ms, 5000, "Thread hearbeat interval (ms)");
+DEFINE_int32(bg_worker_threads, 1,
+             "Number of additional background worker threads deferrable "
+             "work (LLDP, port remediation, nexthop probing) is spread "
+             "over, besides the main background thread");
+DECLARE_bool(rx_dispatch_threads);
+DEFINE_int32(icmp_error_pps_per_src, 100,
+             "Max ICMP error responses (TTL exceeded etc.) generated per "
+             "second per source; 0 disables the per-source limit");
+DEFINE_int32(icmp_error_pps_total, 1000,
+             "Max ICMP error responses generated per second across all "
+             "sources; 0 disables the global limit");
+DEFINE_int32(rx_pkt_trace_interval, 0,
+             "Sample 1 in N trapped packets for per-stage latency tracing "
+             "(rx_trace.* histograms); 0 disables tracing");
+DEFINE_string(highres_shm_export, "",
+              "Comma-separated namespace:counter list to publish into a "
+              "shared-memory segment for local scrapers; empty disables "
+              "the export");
+DEFINE_string(highres_shm_path, "/dev/shm/fboss_highres_counters",
+              "Path of the shared-memory counter segment");
+DEFINE_string(fib_snapshot_file, "",
+              "File to save a compact binary FIB snapshot to on FIB sync "
+              "and graceful exit, and to preload routes from on warm boot "
+              "before the route server replays the table; empty disables "
+              "snapshotting");
+DEFINE_string(neighbor_snapshot_file, "",
+              "File to save a compact binary snapshot of the resolved "
+              "ARP/NDP entries to on graceful exit, and to restore the "
+              "neighbor caches from on warm boot; empty disables "
+              "snapshotting");
+DEFINE_string(update_journal_file, "",
+              "Memory-mapped ring file to journal applied route changes "
+              "to; after a crash restart the surviving records are "
+              "replayed over the last FIB snapshot. Empty disables the "
+              "journal");
+DEFINE_int32(update_journal_size_mb, 16,
+             "Size of the update journal ring in MB; older records are "
+             "overwritten once the ring wraps, bounding how far back "
+             "crash recovery can reach");
+DEFINE_int32(memory_stats_interval_secs, 10,
+             "How often to recompute the per-subsystem memory breakdown "
+             "exported as memory.* gauges; the recomputation walks the "
+             "route tables, so it runs less often than the per-second "
+             "stats tick (0 disables the gauges)");
+DEFINE_int32(live_switch_states_warn_threshold, 32,
+             "Log a warning when more than this many SwitchState "
+             "generations are alive at once (0 disables the warning)");
+DEFINE_int32(link_state_debounce_ms, 10,
+             "Time to wait and coalesce port up/down events before applying "
+             "them to the SwitchState as a single update");
+DEFINE_int32(state_update_coalescing_min_window, 1,
+             "Smallest number of state updates applied per SwitchState clone "
+             "when the update queue is idle");
+DEFINE_int32(state_update_coalescing_max_window, 256,
+             "Largest number of state updates applied per SwitchState clone "
+             "under sustained update pressure");
+DEFINE_int32(state_update_coalescing_grow_threshold, 8,
+             "Update queue backlog above which the coalescing window doubles; "
+             "at or below it the window halves back toward the minimum");
+DEFINE_int32(state_update_aging_ms, 500,
+             "Promote a queued state update one scheduling class (BULK -> "
+             "NORMAL -> URGENT) for each multiple of this many milliseconds "
+             "it has waited, so bulk updates cannot be starved indefinitely "
+             "by higher classes; 0 disables aging");
+DEFINE_int32(convergence_trace_history, 128,
+             "Number of recently completed state update traces retained "
+             "for getConvergenceTraces()");
+DEFINE_string(thread_cpu_sets, "",
+              "Semicolon-separated name=cpus entries pinning agent threads "
+              "to CPUs, e.g. 'fbossUpdateThread=1;fbossBgWorker=2,3'. An "
+              "entry matches a full thread name, or the prefix before the "
+              "'-' for the indexed worker threads. Empty = no pinning.");
+DEFINE_string(fifo_threads, "",
+              "Comma-separated names of agent threads to run under "
+              "SCHED_FIFO, so stats flushers and other SCHED_OTHER work "
+              "can't preempt them, e.g. 'fbossUpdateThread'. Requires "
+              "CAP_SYS_NICE; a spinning FIFO thread can starve its CPU, "
+              "so pair this with --thread_cpu_sets");
+DEFINE_int32(fifo_priority, 1,
+             "Real-time priority for the threads named in --fifo_threads");
+DEFINE_bool(config_cache, true,
+            "Persist the SwitchState compiled from the config file and "
+            "reuse it on restart when the config is unchanged, skipping "
+            "the config rebuild and validation pass");
 
 namespace {
 
+// Keys of the compiled config cache file.
+constexpr auto kConfigHash = "configHash";
+constexpr auto kCachedSwitchState = "switchState";
+
+// Set on the rx, update and background threads, and checked by the
+// Thrift handler as a guardrail against running handler work there.
+thread_local bool packetPathThread{false};
+
 std::string switchRunStateStr(
   facebook::fboss::SwSwitch::SwitchRunState runstate) {
   switch (runstate) {
@@ -126,10 +255,21 @@ facebook::fboss::PortStatus fillInPortStatus(
   return status;
 }
 
-string getPortUpName(const shared_ptr<facebook::fboss::Port>& port) {
-  return port->getName().empty()
-    ? folly::to<string>("port", port->getID(), ".up")
-    : port->getName() + ".up";
+// The keys are built from port names (a bounded, config-derived set),
+// so they are interned: repeated link events reuse the pooled string
+// instead of reallocating the key each time.
+const string& getPortUpName(const shared_ptr<facebook::fboss::Port>& port) {
+  return facebook::fboss::InternedString::intern(
+      port->getName().empty()
+        ? folly::to<string>("port", port->getID(), ".up")
+        : port->getName() + ".up").str();
+}
+
+const string& getPortFlapName(const shared_ptr<facebook::fboss::Port>& port) {
+  return facebook::fboss::InternedString::intern(
+      port->getName().empty()
+        ? folly::to<string>("port", port->getID(), ".flaps")
+        : port->getName() + ".flaps").str();
 }
 
 inline void updatePortStatusCounters(const facebook::fboss::StateDelta& delta) {
@@ -154,6 +294,37 @@ inline void updatePortStatusCounters(const facebook::fboss::StateDelta& delta) {
   );
 }
 
+/*
+ * Map which sections of the SwitchState changed between the two states
+ * in a delta to a StateObserverInterests mask. The classification itself
+ * comes from StateDelta::changedSections(), which detects unchanged
+ * sections with pointer comparisons rather than walking the delta.
+ */
+uint32_t computeChangedInterests(const facebook::fboss::StateDelta& delta) {
+  using namespace facebook::fboss;
+  auto sections = delta.changedSections();
+  uint32_t changed = 0;
+  if (sections & StateDelta::SECTION_PORTS) {
+    changed |= INTEREST_PORTS;
+  }
+  if (sections & StateDelta::SECTION_VLANS) {
+    changed |= INTEREST_VLANS;
+  }
+  if (sections & StateDelta::SECTION_INTERFACES) {
+    changed |= INTEREST_INTERFACES;
+  }
+  if (sections & StateDelta::SECTION_ROUTE_TABLES) {
+    changed |= INTEREST_ROUTE_TABLES;
+  }
+  if (sections & StateDelta::SECTION_ACLS) {
+    changed |= INTEREST_ACLS;
+  }
+  if (sections & StateDelta::SECTION_SWITCH_SETTINGS) {
+    changed |= INTEREST_SWITCH_SETTINGS;
+  }
+  return changed;
+}
+
 } // anonymous namespace
 
 namespace facebook { namespace fboss {
@@ -161,13 +332,23 @@ namespace facebook { namespace fboss {
 SwSwitch::SwSwitch(std::unique_ptr<Platform> platform)
   : hw_(platform->getHwSwitch()),
     platform_(std::move(platform)),
+    periodicScheduler_(new PeriodicScheduler(this, &backgroundEventBase_)),
     portRemediator_(new PortRemediator(this)),
     arp_(new ArpHandler(this)),
     ipv4_(new IPv4Handler(this)),
     ipv6_(new IPv6Handler(this)),
     nUpdater_(new NeighborUpdater(this)),
     pcapMgr_(new PktCaptureManager(this)),
-    routeUpdateLogger_(new RouteUpdateLogger(this)) {
+    flowSampler_(new FlowSampler(this)),
+    routeUpdateLogger_(new RouteUpdateLogger(this)),
+    routeStatsTracker_(new RouteStatsTracker(this)),
+    dhcpRelayTable_(new DhcpRelayTable(this)),
+    dhcpTransactionCache_(new DhcpTransactionCache()),
+    portSendContextTable_(new PortSendContextTable(this)),
+    hostDemuxTable_(new HostDemuxTable(this)),
+    neighborResponseIndex_(new NeighborResponseIndex(this)),
+    icmpErrorRateLimiter_(new IcmpErrorRateLimiter(
+        FLAGS_icmp_error_pps_per_src, FLAGS_icmp_error_pps_total)) {
   // Create the platform-specific state directories if they
   // don't exist already.
   utilCreateDir(platform_->getVolatileStateDir());
@@ -188,6 +369,10 @@ void SwSwitch::stop() {
   // while we are destroying ourselves
   hw_->unregisterCallbacks();
 
+  // Drain and stop the rx dispatch threads before tearing down the packet
+  // handlers they feed into.
+  rxDispatcher_.reset();
+
   // Several member variables are performing operations in the background
   // thread.  Ask them to stop, before we shut down the background thread.
   //
@@ -214,9 +399,21 @@ void SwSwitch::stop() {
   tunMgr_.reset();
 
   routeUpdateLogger_.reset();
+  routeStatsTracker_.reset();
+  dhcpRelayTable_.reset();
+  portSendContextTable_.reset();
+  hostDemuxTable_.reset();
+  neighborResponseIndex_.reset();
+
+  highresShmExporter_.reset();
+
+  // All periodic task owners have unregistered by now; tear down the
+  // timer service itself before stopping the background thread.
+  periodicScheduler_.reset();
 
   bgThreadHeartbeat_.reset();
   updThreadHeartbeat_.reset();
+  bgWorkerHeartbeats_.clear();
 
   // stops the background and update threads.
   stopThreads();
@@ -265,6 +462,10 @@ void SwSwitch::gracefulExit() {
   if (isFullyInitialized()) {
     ipv6_->floodNeighborAdvertisements();
     arp_->floodGratuituousArp();
+    // Snapshot the FIB and the resolved neighbors for preload on the
+    // next warm boot
+    saveFibSnapshot();
+    saveNeighborSnapshot();
     // Stop handlers and threads before uninitializing h/w
     stop();
     folly::dynamic switchState = folly::dynamic::object;
@@ -295,6 +496,21 @@ void SwSwitch::invokeNeighborListener(
   }
 }
 
+void SwSwitch::registerNeighborEntryDeltaListener(
+    std::function<void(const std::vector<NeighborEntryDelta>&)> callback) {
+  VLOG(2) << "Registering neighbor entry delta listener";
+  lock_guard<mutex> g(neighborListenerMutex_);
+  neighborEntryDeltaListener_ = std::move(callback);
+}
+
+void SwSwitch::invokeNeighborEntryDeltaListener(
+    const std::vector<NeighborEntryDelta>& deltas) {
+  lock_guard<mutex> g(neighborListenerMutex_);
+  if (neighborEntryDeltaListener_) {
+    neighborEntryDeltaListener_(deltas);
+  }
+}
+
 bool SwSwitch::getAndClearNeighborHit(RouterID vrf, folly::IPAddress ip) {
   return hw_->getAndClearNeighborHit(vrf, ip);
 }
@@ -313,8 +529,13 @@ void SwSwitch::clearWarmBootCache() {
 }
 
 void SwSwitch::init(std::unique_ptr<TunManager> tunMgr, SwitchFlags flags) {
+  BootProfiler::Phase initPhase("SwSwitch::init");
+  auto begin = steady_clock::now();
   flags_ = flags;
-  auto hwInitRet = hw_->init(this);
+  auto hwInitRet = [&] {
+    BootProfiler::Phase phase("HwSwitch::init");
+    return hw_->init(this);
+  }();
   auto initialState = hwInitRet.switchState;
   bootType_ = hwInitRet.bootType;
 
@@ -349,7 +570,24 @@ void SwSwitch::init(std::unique_ptr<TunManager> tunMgr, SwitchFlags flags) {
 
   startThreads();
 
-  // Publish timers after we aked TunManager to do a probe. This
+  // Start probing the kernel TUN interface state right away, so the
+  // netlink dump runs on the background thread concurrently with the
+  // rest of initialization and the initial config apply, instead of
+  // lazily on the first sync after the config is applied.
+  if (tunMgr_) {
+    tunMgr_->startProbe();
+  }
+
+  if (FLAGS_rx_dispatch_threads) {
+    rxDispatcher_ = std::make_unique<RxPacketDispatcher>(this);
+    rxDispatcher_->start();
+  }
+
+  if (!FLAGS_highres_shm_export.empty()) {
+    startHighresShmExport();
+  }
+
+  // Publish timers after we asked TunManager to do a probe. This
   // is not required but since both stats publishing and tunnel
   // interface probing happens on backgroundEventBase_ its somewhat
   // nicer to have tun inteface probing finish faster since then
@@ -357,6 +595,7 @@ void SwSwitch::init(std::unique_ptr<TunManager> tunMgr, SwitchFlags flags) {
   // applying initial config.
   if (flags & SwitchFlags::PUBLISH_STATS) {
     publishSwitchInfo(hwInitRet);
+    publishInitTimes("fboss.ctrl.hw_initialized", hwInitRet.bootTime);
   }
 
   if (flags & SwitchFlags::ENABLE_LLDP) {
@@ -386,14 +625,37 @@ void SwSwitch::init(std::unique_ptr<TunManager> tunMgr, SwitchFlags flags) {
     &updateEventBase_, "fbossUpdateThread", FLAGS_thread_heartbeat_ms,
     updHeartbeatStatsFunc);
 
+  // Each worker hosts its own class of deferrable tasks, so a per-worker
+  // heartbeat gives queue-latency visibility per task class.
+  for (size_t idx = 0; idx < bgWorkerEventBases_.size(); ++idx) {
+    bgWorkerHeartbeats_.push_back(std::make_unique<ThreadHeartbeat>(
+        bgWorkerEventBases_[idx].get(),
+        folly::to<std::string>("fbossBgWorker-", idx),
+        FLAGS_thread_heartbeat_ms, bgHeartbeatStatsFunc));
+  }
+
   setSwitchRunState(SwitchRunState::INITIALIZED);
 }
 
 void SwSwitch::initialConfigApplied(const steady_clock::time_point& startTime) {
+  BootProfiler::Phase phase("SwSwitch::initialConfigApplied");
   // notify the hw
   hw_->initialConfigApplied();
   setSwitchRunState(SwitchRunState::CONFIGURED);
 
+  // On warm boot, preload routes from the last FIB snapshot so hardware
+  // converges in seconds instead of waiting for the route server to
+  // replay the full table; the first live sync reconciles.
+  preloadFib();
+
+  // Likewise, restore the neighbor caches from the last snapshot so the
+  // post-restart resolution storm becomes paced background refresh.
+  preloadNeighbors();
+
+  // Open the update journal and, if the previous run crashed, replay
+  // the route changes the snapshot missed.
+  replayUpdateJournal();
+
   if (tunMgr_) {
     // We check for syncing tun interface only on state changes after the
     // initial configuration is applied. This is really a hack to get around
@@ -423,6 +685,14 @@ void SwSwitch::initialConfigApplied(const steady_clock::time_point& startTime) {
     publishInitTimes("fboss.ctrl.switch_configured",
        duration_cast<duration<float>>(steady_clock::now() - startTime).count());
   }
+
+  // Boot is complete; write the trace once the work this function queued
+  // on the background thread (notably the initial TUN sync) has drained,
+  // so those phases are included. The event base runs its queue in
+  // order, so this lambda executes after the sync.
+  phase.end();
+  backgroundEventBase_.runInEventBaseThread(
+      []() { BootProfiler::get().finish(); });
 }
 
 void SwSwitch::logRouteUpdates(
@@ -442,17 +712,419 @@ void SwSwitch::fibSynced() {
     routeUpdateLogger_->stopLoggingForIdentifier("fboss-agent-warmboot");
   }
   setSwitchRunState(SwitchRunState::FIB_SYNCED);
+  // The live sync has replaced whatever was preloaded; refresh the
+  // snapshot now that the table is authoritative.
+  fibPreloaded_.store(false, std::memory_order_release);
+  saveFibSnapshot();
+}
+
+namespace {
+
+state::FibSnapshot buildFibSnapshot(const shared_ptr<SwitchState>& state,
+                                    const folly::Optional<RouterID>& vrf) {
+  state::FibSnapshot snapshot;
+  for (const auto& rt : *state->getRouteTables()) {
+    if (vrf && rt->getID() != *vrf) {
+      continue;
+    }
+    state::RouteTableFields table;
+    table.routerId = rt->getID();
+    for (const auto& ritr : rt->getRibV4()->routes()) {
+      table.routesV4.push_back(ritr.value()->toThrift());
+    }
+    for (const auto& ritr : rt->getRibV6()->routes()) {
+      table.routesV6.push_back(ritr.value()->toThrift());
+    }
+    snapshot.tables.push_back(std::move(table));
+  }
+  return snapshot;
+}
+
+state::NeighborSnapshot buildNeighborSnapshot(
+    const shared_ptr<SwitchState>& state) {
+  state::NeighborSnapshot snapshot;
+  for (const auto& vlan : *state->getVlans()) {
+    state::NeighborTableFields table;
+    table.vlanId = vlan->getID();
+    for (const auto& entry : *vlan->getArpTable()) {
+      if (entry->isPending()) {
+        // A pending entry carries no mac; it would just be re-probed
+        continue;
+      }
+      state::NeighborEntryFields fields;
+      fields.ip = network::toBinaryAddressImpl(entry->getIP());
+      fields.mac = entry->getMac().toString();
+      fields.port = entry->getPort();
+      fields.interfaceId = entry->getIntfID();
+      table.entriesV4.push_back(std::move(fields));
+    }
+    for (const auto& entry : *vlan->getNdpTable()) {
+      if (entry->isPending()) {
+        continue;
+      }
+      state::NeighborEntryFields fields;
+      fields.ip = network::toBinaryAddressImpl(entry->getIP());
+      fields.mac = entry->getMac().toString();
+      fields.port = entry->getPort();
+      fields.interfaceId = entry->getIntfID();
+      table.entriesV6.push_back(std::move(fields));
+    }
+    if (table.entriesV4.empty() && table.entriesV6.empty()) {
+      continue;
+    }
+    snapshot.tables.push_back(std::move(table));
+  }
+  return snapshot;
+}
+
+state::PortSnapshot buildPortSnapshot(const shared_ptr<SwitchState>& state) {
+  state::PortSnapshot snapshot;
+  for (const auto& port : *state->getPorts()) {
+    state::PortFields fields;
+    fields.portId = port->getID();
+    fields.name = port->getName();
+    fields.description = port->getDescription();
+    fields.adminState = static_cast<int32_t>(port->getState());
+    fields.operUp = port->getOperState();
+    fields.speedMbps = static_cast<int32_t>(port->getSpeed());
+    fields.ingressVlan = port->getIngressVlan();
+    snapshot.ports.push_back(std::move(fields));
+  }
+  return snapshot;
+}
+
+} // unnamed namespace
+
+void SwSwitch::saveFibSnapshot() {
+  if (FLAGS_fib_snapshot_file.empty()) {
+    return;
+  }
+  auto state = getState();
+  uint64_t journalSeq{0};
+  if (updateJournal_) {
+    // Capture the (state, journal sequence) pair on the update thread.
+    // Journal appends only happen there, so between updates the
+    // published state and the last written sequence are consistent;
+    // reading them from this thread could pair a state containing an
+    // update with a cutoff sequence that predates its journal record,
+    // and crash recovery would then skip that record.
+    updateStateBlocking(
+        "capture FIB snapshot",
+        [&](const shared_ptr<SwitchState>& updateState)
+            -> shared_ptr<SwitchState> {
+          state = updateState;
+          journalSeq = updateJournal_->currentSequence();
+          return nullptr;
+        });
+  }
+  auto snapshot = buildFibSnapshot(state, folly::none);
+  if (updateJournal_) {
+    snapshot.journalSequence = journalSeq;
+    snapshot.__isset.journalSequence = true;
+  }
+  std::string out;
+  apache::thrift::CompactSerializer::serialize(snapshot, &out);
+  if (!folly::writeFile(out, FLAGS_fib_snapshot_file.c_str())) {
+    LOG(ERROR) << "failed to write FIB snapshot to "
+      << FLAGS_fib_snapshot_file;
+    return;
+  }
+  VLOG(1) << "saved FIB snapshot (" << out.size() << " bytes) to "
+    << FLAGS_fib_snapshot_file;
+}
+
+void SwSwitch::preloadFib() {
+  // With the update journal enabled the snapshot is also preloaded on
+  // cold boot: a crash restart comes up as a cold boot, but the last
+  // snapshot plus the journaled records still describe the pre-crash
+  // FIB.
+  if (FLAGS_fib_snapshot_file.empty() ||
+      (getBootType() != BootType::WARM_BOOT &&
+       FLAGS_update_journal_file.empty())) {
+    return;
+  }
+  std::string in;
+  if (!folly::readFile(FLAGS_fib_snapshot_file.c_str(), in)) {
+    VLOG(1) << "no FIB snapshot at " << FLAGS_fib_snapshot_file
+      << ", waiting for the route server to sync";
+    return;
+  }
+  state::FibSnapshot snapshot;
+  try {
+    apache::thrift::CompactSerializer::deserialize(in, snapshot);
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "could not parse FIB snapshot "
+      << FLAGS_fib_snapshot_file << ": " << folly::exceptionStr(ex);
+    return;
+  }
+  if (snapshot.__isset.journalSequence) {
+    fibSnapshotJournalSeq_ = snapshot.journalSequence;
+  }
+  uint64_t numRoutes{0};
+  auto preloadFn = [&](const shared_ptr<SwitchState>& state)
+      -> shared_ptr<SwitchState> {
+    RouteUpdater updater(state->getRouteTables());
+    for (const auto& table : snapshot.tables) {
+      RouterID routerId(table.routerId);
+      auto addRoutes = [&](const std::vector<state::RouteFields>& routes) {
+        for (const auto& fields : routes) {
+          auto network = network::toIPAddress(fields.prefix.network);
+          auto mask = static_cast<uint8_t>(fields.prefix.mask);
+          // Connected routes carry no per-client next hops; they are
+          // recreated from the config, so only client routes are
+          // preloaded here.
+          for (const auto& clientNhs : fields.nexthopsMulti) {
+            RouteNextHops nexthops;
+            nexthops.reserve(clientNhs.nextHopAddrs.size());
+            for (const auto& nh : clientNhs.nextHopAddrs) {
+              nexthops.emplace(network::toIPAddress(nh));
+            }
+            updater.addRoute(routerId, network, mask,
+                             ClientID(clientNhs.clientId),
+                             std::move(nexthops));
+            ++numRoutes;
+          }
+        }
+      };
+      addRoutes(table.routesV4);
+      addRoutes(table.routesV6);
+    }
+    auto newRt = updater.updateDone();
+    if (!newRt) {
+      return nullptr;
+    }
+    auto newState = state->clone();
+    newState->resetRouteTables(std::move(newRt));
+    return newState;
+  };
+  // Blocking on purpose: this runs before the thrift server comes up,
+  // so the preloaded table is programmed (reusing the warm boot cache's
+  // host and route entries) before the route server can even connect.
+  updateStateBlocking("preload fib from snapshot", preloadFn);
+  if (numRoutes > 0) {
+    fibPreloaded_.store(true, std::memory_order_release);
+    LOG(INFO) << "preloaded " << numRoutes << " routes from FIB snapshot "
+      << FLAGS_fib_snapshot_file;
+  }
+}
+
+void SwSwitch::saveNeighborSnapshot() {
+  if (FLAGS_neighbor_snapshot_file.empty()) {
+    return;
+  }
+  auto snapshot = buildNeighborSnapshot(getState());
+  std::string out;
+  apache::thrift::CompactSerializer::serialize(snapshot, &out);
+  if (!folly::writeFile(out, FLAGS_neighbor_snapshot_file.c_str())) {
+    LOG(ERROR) << "failed to write neighbor snapshot to "
+      << FLAGS_neighbor_snapshot_file;
+    return;
+  }
+  VLOG(1) << "saved neighbor snapshot (" << out.size() << " bytes) to "
+    << FLAGS_neighbor_snapshot_file;
+}
+
+void SwSwitch::preloadNeighbors() {
+  if (FLAGS_neighbor_snapshot_file.empty() ||
+      getBootType() != BootType::WARM_BOOT) {
+    return;
+  }
+  std::string in;
+  if (!folly::readFile(FLAGS_neighbor_snapshot_file.c_str(), in)) {
+    VLOG(1) << "no neighbor snapshot at " << FLAGS_neighbor_snapshot_file
+      << ", neighbors will be re-resolved on demand";
+    return;
+  }
+  state::NeighborSnapshot snapshot;
+  try {
+    apache::thrift::CompactSerializer::deserialize(in, snapshot);
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "could not parse neighbor snapshot "
+      << FLAGS_neighbor_snapshot_file << ": " << folly::exceptionStr(ex);
+    return;
+  }
+  // Feed the checkpointed entries into the caches as STALE: they are
+  // programmed (reusing the warm boot cache's host entries) and usable
+  // immediately, and the caches revalidate them on their own jittered
+  // stale/probe timers instead of probing everything at once. Entries
+  // whose vlan or interface went away are dropped by the caches.
+  uint64_t numEntries{0};
+  for (const auto& table : snapshot.tables) {
+    VlanID vlanID(table.vlanId);
+    for (const auto& fields : table.entriesV4) {
+      auto ip = network::toIPAddress(fields.ip);
+      if (!ip.isV4()) {
+        continue;
+      }
+      nUpdater_->restoreArpEntry(vlanID, ip.asV4(),
+                                 folly::MacAddress(fields.mac),
+                                 PortID(fields.port));
+      ++numEntries;
+    }
+    for (const auto& fields : table.entriesV6) {
+      auto ip = network::toIPAddress(fields.ip);
+      if (!ip.isV6()) {
+        continue;
+      }
+      nUpdater_->restoreNdpEntry(vlanID, ip.asV6(),
+                                 folly::MacAddress(fields.mac),
+                                 PortID(fields.port));
+      ++numEntries;
+    }
+  }
+  if (numEntries > 0) {
+    LOG(INFO) << "restored " << numEntries
+      << " neighbor entries from snapshot " << FLAGS_neighbor_snapshot_file;
+  }
+}
+
+void SwSwitch::replayUpdateJournal() {
+  if (FLAGS_update_journal_file.empty()) {
+    return;
+  }
+  try {
+    updateJournal_.reset(new UpdateJournal(
+        FLAGS_update_journal_file,
+        static_cast<uint64_t>(FLAGS_update_journal_size_mb) * 1024 * 1024));
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "could not open update journal "
+      << FLAGS_update_journal_file << ": " << folly::exceptionStr(ex)
+      << "; running without journaling";
+    return;
+  }
+  auto records = updateJournal_->recover();
+  // A graceful exit saves a snapshot covering the whole journal, so
+  // after a clean restart every recovered record is already in the
+  // preloaded FIB. Only a crash leaves newer records behind.
+  while (!records.empty() &&
+         records.front().sequence <= fibSnapshotJournalSeq_) {
+    records.erase(records.begin());
+  }
+  if (records.empty()) {
+    return;
+  }
+  uint64_t numChanges{0};
+  auto replayFn = [&](const shared_ptr<SwitchState>& state)
+      -> shared_ptr<SwitchState> {
+    RouteUpdater updater(state->getRouteTables());
+    for (const auto& record : records) {
+      for (const auto& entry : record.routes) {
+        RouterID routerId(entry.routerId);
+        auto network = network::toIPAddress(entry.prefix.network);
+        auto mask = static_cast<uint8_t>(entry.prefix.mask);
+        for (const auto& clientId : entry.removedClients) {
+          updater.delNexthopsForClient(routerId, network, mask,
+                                       ClientID(clientId));
+        }
+        for (const auto& clientNhs : entry.nexthopsMulti) {
+          RouteNextHops nexthops;
+          nexthops.reserve(clientNhs.nextHopAddrs.size());
+          for (const auto& nh : clientNhs.nextHopAddrs) {
+            nexthops.emplace(network::toIPAddress(nh));
+          }
+          updater.addRoute(routerId, network, mask,
+                           ClientID(clientNhs.clientId),
+                           std::move(nexthops));
+        }
+        ++numChanges;
+      }
+    }
+    auto newRt = updater.updateDone();
+    if (!newRt) {
+      return nullptr;
+    }
+    auto newState = state->clone();
+    newState->resetRouteTables(std::move(newRt));
+    return newState;
+  };
+  updateStateBlocking("replay update journal", replayFn);
+  LOG(INFO) << "replayed " << records.size() << " journal records ("
+    << numChanges << " route changes, sequences "
+    << records.front().sequence << ".." << records.back().sequence
+    << ") over the FIB snapshot after unclean shutdown";
+}
+
+void SwSwitch::dumpOperState(const std::string& subtrees,
+                             const std::string& outFile) {
+  auto state = getState();
+  state::OperStateSnapshot snapshot;
+  snapshot.timestampMs = duration_cast<milliseconds>(
+      system_clock::now().time_since_epoch()).count();
+  std::vector<std::string> parts;
+  folly::split(',', subtrees, parts, true);
+  if (parts.empty()) {
+    throw FbossError("no oper state subtrees requested");
+  }
+  for (const auto& part : parts) {
+    if (part == "ports") {
+      snapshot.ports = buildPortSnapshot(state);
+      snapshot.__isset.ports = true;
+    } else if (part == "neighbors") {
+      snapshot.neighbors = buildNeighborSnapshot(state);
+      snapshot.__isset.neighbors = true;
+    } else if (part == "routes") {
+      snapshot.fib = buildFibSnapshot(state, folly::none);
+      snapshot.__isset.fib = true;
+    } else if (part.compare(0, 7, "routes:") == 0) {
+      RouterID vrf(folly::to<int32_t>(part.substr(7)));
+      if (!state->getRouteTables()->getRouteTableIf(vrf)) {
+        throw FbossError("no route table for vrf ", part.substr(7));
+      }
+      snapshot.fib = buildFibSnapshot(state, vrf);
+      snapshot.__isset.fib = true;
+    } else {
+      throw FbossError("unknown oper state subtree \"", part,
+                       "\"; expected ports, neighbors, routes or "
+                       "routes:<vrf>");
+    }
+  }
+  std::string out;
+  apache::thrift::CompactSerializer::serialize(snapshot, &out);
+  if (!folly::writeFile(out, outFile.c_str())) {
+    throw FbossError("failed to write oper state dump to ", outFile);
+  }
+  VLOG(1) << "dumped oper state (" << subtrees << ", " << out.size()
+    << " bytes) to " << outFile;
+}
+
+void SwSwitch::logFibPreloadReconciliation(const StateDelta& delta) {
+  uint64_t added{0};
+  uint64_t removed{0};
+  uint64_t changed{0};
+  for (const auto& rtDelta : delta.getRouteTablesDelta()) {
+    DeltaFunctions::forEachChanged(
+        rtDelta.getRoutesV4Delta(),
+        [&](const shared_ptr<RouteV4>&, const shared_ptr<RouteV4>&) {
+          ++changed;
+        },
+        [&](const shared_ptr<RouteV4>&) { ++added; },
+        [&](const shared_ptr<RouteV4>&) { ++removed; });
+    DeltaFunctions::forEachChanged(
+        rtDelta.getRoutesV6Delta(),
+        [&](const shared_ptr<RouteV6>&, const shared_ptr<RouteV6>&) {
+          ++changed;
+        },
+        [&](const shared_ptr<RouteV6>&) { ++added; },
+        [&](const shared_ptr<RouteV6>&) { ++removed; });
+  }
+  fbData->setCounter("fib_preload.reconcile.added", added);
+  fbData->setCounter("fib_preload.reconcile.removed", removed);
+  fbData->setCounter("fib_preload.reconcile.changed", changed);
+  LOG(INFO) << "first FIB sync reconciled the preloaded snapshot: "
+    << added << " routes added, " << removed << " removed, "
+    << changed << " changed";
 }
 
 void SwSwitch::registerStateObserver(StateObserver* observer,
-                                     const string name) {
+                                     const string name,
+                                     uint32_t interests) {
   VLOG(2) << "Registering state observer: " << name;
   if (!updateEventBase_.isInEventBaseThread()) {
     updateEventBase_.runInEventBaseThreadAndWait([=]() {
-        addStateObserver(observer, name);
+        addStateObserver(observer, name, interests);
     });
   } else {
-    addStateObserver(observer, name);
+    addStateObserver(observer, name, interests);
   }
 }
 
@@ -479,12 +1151,13 @@ void SwSwitch::removeStateObserver(StateObserver* observer) {
   }
 }
 
-void SwSwitch::addStateObserver(StateObserver* observer, const string& name) {
+void SwSwitch::addStateObserver(StateObserver* observer, const string& name,
+                                uint32_t interests) {
   DCHECK(updateEventBase_.isInEventBaseThread());
   if (stateObserverRegistered(observer)) {
     throw FbossError("State observer add failed: ", name, " already exists");
   }
-  stateObservers_.emplace(observer, name);
+  stateObservers_.emplace(observer, ObserverInfo{name, interests});
 }
 
 void SwSwitch::notifyStateObservers(const StateDelta& delta) {
@@ -493,25 +1166,32 @@ void SwSwitch::notifyStateObservers(const StateDelta& delta) {
     // Make sure the SwSwitch is not already being destroyed
     return;
   }
-  updatePortStatusCounters(delta);
-  for (auto observerName : stateObservers_) {
+  auto changed = computeChangedInterests(delta);
+  if (changed & INTEREST_PORTS) {
+    updatePortStatusCounters(delta);
+  }
+  for (const auto& entry : stateObservers_) {
+    if (!(entry.second.interests & changed)) {
+      continue;
+    }
     try {
-      auto observer = observerName.first;
+      auto observer = entry.first;
       observer->stateUpdated(delta);
     } catch (const std::exception& ex) {
     // TODO: Figure out the best way to handle errors here.
-      LOG(FATAL) << "error notifying " << observerName.second << " of update: "
+      LOG(FATAL) << "error notifying " << entry.second.name << " of update: "
                  << folly::exceptionStr(ex);
     }
   }
 }
 
 void SwSwitch::updateState(unique_ptr<StateUpdate> update) {
-  // Put the update function on the queue.
-  {
-    folly::SpinLockGuard guard(pendingUpdatesLock_);
-    pendingUpdates_.push_back(*update.release());
-  }
+  update->traceStamp(StateUpdate::TRACE_ENQUEUE);
+  // Put the update function on the queue.  The queue is a lock-free MPSC
+  // list, so concurrent producers (Thrift, neighbor, link-scan threads)
+  // never block each other here.
+  pendingUpdates_.insertHead(update.release());
+  stats()->updateQueueDepth(++pendingUpdatesDepth_);
 
   // Signal the background thread that updates are pending.
   // (We're using backgroundEventBase_ for now because it is convenient.
@@ -528,53 +1208,66 @@ void SwSwitch::updateState(StringPiece name, StateUpdateFn fn) {
   updateState(std::move(update));
 }
 
+void SwSwitch::updateState(StringPiece name, StateUpdateFn fn,
+                           StateUpdate::Priority priority) {
+  auto update = make_unique<FunctionStateUpdate>(
+      name, std::move(fn), true /* allowCoalesce */, priority);
+  updateState(std::move(update));
+}
+
 void SwSwitch::updateStateNoCoalescing(StringPiece name, StateUpdateFn fn) {
   auto update = make_unique<FunctionStateUpdate>(name, std::move(fn), false);
   updateState(std::move(update));
 }
 
-void SwSwitch::updateStateBlocking(folly::StringPiece name, StateUpdateFn fn) {
+void SwSwitch::updateStateUrgent(StringPiece name, StateUpdateFn fn) {
+  updateState(name, std::move(fn), StateUpdate::Priority::URGENT);
+}
+
+void SwSwitch::updateStateBlocking(folly::StringPiece name, StateUpdateFn fn,
+                                   StateUpdate::Priority priority) {
   auto result = std::make_shared<BlockingUpdateResult>();
-  auto update = make_unique<BlockingStateUpdate>(name, std::move(fn), result);
+  auto update = make_unique<BlockingStateUpdate>(
+      name, std::move(fn), result, true /* allowCoalesce */, priority);
   updateState(std::move(update));
   result->wait();
 }
 
+folly::Future<folly::Unit> SwSwitch::updateStateFuture(
+    folly::StringPiece name, StateUpdateFn fn,
+    StateUpdate::Priority priority) {
+  folly::Promise<folly::Unit> promise;
+  auto future = promise.getFuture();
+  auto update = make_unique<FutureStateUpdate>(
+      name, std::move(fn), std::move(promise),
+      true /* allowCoalesce */, priority);
+  updateState(std::move(update));
+  return future;
+}
+
 void SwSwitch::handlePendingUpdatesHelper(SwSwitch* sw) {
   sw->handlePendingUpdates();
 }
 
 void SwSwitch::handlePendingUpdates() {
-  // Get the list of updates to run.
+  // Drain everything that has been queued so far in a single sweep.  The
+  // queue is MPSC, so this (the update thread) is the only consumer, and
+  // sweepOnce() hands the updates back in the order they were enqueued.
   //
-  // We might pull multiple updates off the list at once if several updates
+  // We might pull multiple updates off the queue at once if several updates
   // were scheduled before we had a chance to process them.  In some cases we
   // might also end up finding 0 updates to process if a previous
   // handlePendingUpdates() call processed multiple updates.
-  StateUpdateList updates;
-  {
-    folly::SpinLockGuard guard(pendingUpdatesLock_);
-
-    // When deciding how many elements to pull off the pendingUpdates_
-    // list, we pull as many as we can, while making sure we don't
-    // include any updates after an update that does not allow
-    // coalescing.
-    auto iter = pendingUpdates_.begin();
-    while (iter != pendingUpdates_.end()) {
-      StateUpdate* update = &(*iter);
-      ++iter;
-      if (!update->allowsCoalescing()) {
-        break;
-      }
-    }
-    updates.splice(updates.begin(), pendingUpdates_,
-                   pendingUpdates_.begin(), iter);
-  }
+  StateUpdateList drained;
+  pendingUpdates_.sweepOnce([&](StateUpdate* update) {
+    drained.push_back(*update);
+    --pendingUpdatesDepth_;
+  });
 
   // handlePendingUpdates() is invoked once for each update, but a previous
   // call might have already processed everything.  If we don't have anything
   // to do just return early.
-  if (updates.empty()) {
+  if (drained.empty()) {
     return;
   }
 
@@ -582,46 +1275,168 @@ void SwSwitch::handlePendingUpdates() {
   // not initialized yet
   DCHECK(isInitialized());
 
-  // Call all of the update functions to prepare the new SwitchState
-  auto origState = getState();
-  auto state = origState;
-  auto iter = updates.begin();
-  while (iter != updates.end()) {
-    StateUpdate* update = &(*iter);
-    ++iter;
-
-    shared_ptr<SwitchState> newState;
-    LOG(INFO) << "preparing state update " << update->getName();
-    try {
-      newState = update->applyUpdate(state);
-    } catch (const std::exception& ex) {
-      // Call the update's onError() function, and then immediately delete
-      // it (therefore removing it from the intrusive list).  This way we won't
-      // call it's onSuccess() function later.
-      update->onError(ex);
-      delete update;
+  // Adapt the coalescing window to the backlog.  Under sustained churn we
+  // widen the window so that more update functions share one SwitchState
+  // clone and one hardware delta; once the queue drains we shrink it back
+  // down so a lone update is applied with minimum latency.  The window is
+  // only read and written on the update thread.
+  size_t backlog = drained.size() + pendingUpdatesDepth_.load();
+  if (backlog > size_t(FLAGS_state_update_coalescing_grow_threshold)) {
+    updateCoalescingWindow_ =
+        std::min(updateCoalescingWindow_ * 2,
+                 size_t(FLAGS_state_update_coalescing_max_window));
+  } else {
+    updateCoalescingWindow_ =
+        std::max(updateCoalescingWindow_ / 2,
+                 size_t(FLAGS_state_update_coalescing_min_window));
+  }
+  stats()->coalescingWindow(updateCoalescingWindow_);
+
+  // Reorder the drained updates by scheduling class so urgent updates
+  // (port down, neighbor flush) run before normal ones, and normal ones
+  // before bulk work (a full FIB sync, a monitoring-triggered config
+  // reapply) queued ahead of them. Relative order within each class is
+  // preserved. An update that has already waited longer than the aging
+  // interval is promoted one class per interval waited, so a steady
+  // stream of higher-class updates cannot starve bulk work forever.
+  auto classifyTime = std::chrono::steady_clock::now();
+  auto effectiveClass = [&](const StateUpdate& update) {
+    int cls = static_cast<int>(update.getPriority());
+    if (FLAGS_state_update_aging_ms > 0) {
+      auto waited = duration_cast<std::chrono::milliseconds>(
+          classifyTime - update.getTraceTime(StateUpdate::TRACE_ENQUEUE));
+      cls -= waited.count() / FLAGS_state_update_aging_ms;
     }
-    if (newState) {
-      // Call publish after applying each StateUpdate.  This guarantees that
-      // the next StateUpdate function will have clone the SwitchState before
-      // making any changes.  This ensures that if a StateUpdate function ever
-      // fails partway through it can't have partially modified our existing
-      // state, leaving it in an invalid state.
-      newState->publish();
-      state = newState;
+    return std::max(cls, 0);
+  };
+  bool mixedClasses = false;
+  int firstClass = effectiveClass(drained.front());
+  for (const auto& update : drained) {
+    if (effectiveClass(update) != firstClass) {
+      mixedClasses = true;
+      break;
     }
   }
-
-  // Now apply the update and notify subscribers
-  if (state != origState) {
-    applyUpdate(origState, state);
+  if (mixedClasses) {
+    StateUpdateList classes[StateUpdate::kNumPriorities];
+    while (!drained.empty()) {
+      StateUpdate* update = &drained.front();
+      drained.pop_front();
+      classes[effectiveClass(*update)].push_back(*update);
+    }
+    for (auto& cls : classes) {
+      drained.splice(drained.end(), cls);
+    }
   }
 
-  // Notify all of the updates of success, and delete them
-  while (!updates.empty()) {
-    unique_ptr<StateUpdate> update(&updates.front());
-    updates.pop_front();
-    update->onSuccess();
+  // Since the sweep above removed everything from the queue, we have to
+  // process all of the drained updates here; batches can't extend past an
+  // update that does not allow coalescing, or past the current window.
+  while (!drained.empty()) {
+    StateUpdateList updates;
+    auto boundary = drained.begin();
+    size_t batched = 0;
+    while (boundary != drained.end() && batched < updateCoalescingWindow_) {
+      StateUpdate* update = &(*boundary);
+      ++boundary;
+      ++batched;
+      if (!update->allowsCoalescing()) {
+        break;
+      }
+    }
+    updates.splice(updates.begin(), drained, drained.begin(), boundary);
+
+    // Compose all of the update functions against a single new SwitchState,
+    // so the entire batch results in at most one delta being pushed to the
+    // hardware.  Track how big the batch was and how long it took so we can
+    // see how well coalescing is working under heavy route churn.
+    auto batchStart = std::chrono::steady_clock::now();
+    size_t batchSize = updates.size();
+
+    // When clone profiling is compiled in, attribute the COW traffic of
+    // this batch to it.  isEnabled() is constexpr, so unprofiled builds
+    // drop all of this.
+    std::vector<NodeCloneProfiler::Snapshot> cloneStatsBefore;
+    if (NodeCloneProfiler::isEnabled()) {
+      cloneStatsBefore = NodeCloneProfiler::get().snapshot();
+    }
+
+    // Call all of the update functions to prepare the new SwitchState
+    auto origState = getState();
+    auto state = origState;
+    {
+      // Track the nodes the update functions construct, so publishing each
+      // intermediate state below only visits those nodes instead of
+      // recursively walking the whole tree (which is dominated by the route
+      // table).  The tracker must be destroyed before applyUpdate() shares
+      // the new state with other threads.
+      PublishTracker publishTracker;
+      auto iter = updates.begin();
+      while (iter != updates.end()) {
+        StateUpdate* update = &(*iter);
+        ++iter;
+
+        shared_ptr<SwitchState> newState;
+        VLOG(3) << "preparing state update " << update->getName();
+        update->traceStamp(StateUpdate::TRACE_APPLY);
+        stats()->stateUpdateQueueLatency(
+            update->getPriority(),
+            duration_cast<microseconds>(
+                update->getTraceTime(StateUpdate::TRACE_APPLY) -
+                update->getTraceTime(StateUpdate::TRACE_ENQUEUE)));
+        try {
+          newState = update->applyUpdate(state);
+        } catch (const std::exception& ex) {
+          // Call the update's onError() function, and then immediately delete
+          // it (therefore removing it from the intrusive list).  This way we
+          // won't call it's onSuccess() function later.
+          update->onError(ex);
+          delete update;
+        }
+        if (newState) {
+          // Publish after applying each StateUpdate.  This guarantees that
+          // the next StateUpdate function will have clone the SwitchState
+          // before making any changes.  This ensures that if a StateUpdate
+          // function ever fails partway through it can't have partially
+          // modified our existing state, leaving it in an invalid state.
+          // Every node the update left unpublished was constructed while the
+          // tracker was active, so this publishes the whole new state.
+          publishTracker.publishTracked();
+          DCHECK(newState->isPublished());
+          state = newState;
+        }
+      }
+    }
+
+    // Now apply the update and notify subscribers
+    auto hwSyncTime = std::chrono::steady_clock::now();
+    if (state != origState) {
+      applyUpdate(origState, state);
+    }
+    auto hwDoneTime = std::chrono::steady_clock::now();
+
+    auto batchDuration = duration_cast<microseconds>(
+        std::chrono::steady_clock::now() - batchStart);
+    stats()->stateUpdateBatch(batchSize, batchDuration);
+
+    if (NodeCloneProfiler::isEnabled() && !updates.empty()) {
+      NodeCloneProfiler::logDelta(
+          folly::to<std::string>(updates.front().getName(), " (batch of ",
+                                 batchSize, ")"),
+          cloneStatsBefore, NodeCloneProfiler::get().snapshot());
+    }
+
+    // Notify all of the updates of success, and delete them.  The
+    // hardware sync stamps are shared by the whole batch: every update
+    // in it converged when the batch's delta finished programming.
+    while (!updates.empty()) {
+      unique_ptr<StateUpdate> update(&updates.front());
+      updates.pop_front();
+      update->traceStampAt(StateUpdate::TRACE_HW_SYNC, hwSyncTime);
+      update->traceStampAt(StateUpdate::TRACE_HW_DONE, hwDoneTime);
+      recordConvergenceTrace(*update);
+      update->onSuccess();
+    }
   }
 }
 
@@ -669,6 +1484,169 @@ int SwSwitch::getHighresSamplers(HighresSamplerList* samplers,
   return numCountersAdded;
 }
 
+void SwSwitch::startHighresShmExport() {
+  // Parse the namespace:counter list from the flag.
+  set<CounterRequest> counters;
+  std::vector<std::string> entries;
+  folly::split(',', FLAGS_highres_shm_export, entries, true);
+  for (const auto& entry : entries) {
+    CounterRequest req;
+    if (!folly::split(':', entry, req.namespaceName, req.counterName)) {
+      LOG(ERROR) << "malformed --highres_shm_export entry \"" << entry
+                 << "\"; expected namespace:counter";
+      continue;
+    }
+    counters.insert(std::move(req));
+  }
+
+  auto samplers = make_unique<HighresSamplerList>();
+  auto numCounters = getHighresSamplers(samplers.get(), counters);
+  if (numCounters <= 0) {
+    LOG(ERROR) << "none of the counters in --highres_shm_export are valid; "
+      "not starting the shared-memory export";
+    return;
+  }
+
+  highresShmExporter_ = std::make_unique<HighresShmExporter>(
+      FLAGS_highres_shm_path, std::move(samplers), numCounters);
+  highresShmExporter_->start();
+  LOG(INFO) << "publishing " << numCounters << " high-resolution counters "
+    "to " << FLAGS_highres_shm_path;
+}
+
+void SwSwitch::updateHwStatsAsync() {
+  if (!isFullyInitialized()) {
+    return;
+  }
+  if (hwStatsCollectionInProgress_.exchange(true,
+                                            std::memory_order_acq_rel)) {
+    VLOG(1) << "previous hardware counter collection still in progress; "
+      "skipping this pass";
+    return;
+  }
+  backgroundEventBase_.runInEventBaseThread([this]() {
+    hw_->updateStats(stats());
+    hwStatsCollectionInProgress_.store(false, std::memory_order_release);
+  });
+}
+
+void SwSwitch::publishRouteStats() {
+  if (!routeStatsTracker_) {
+    return;
+  }
+  // The counts are maintained incrementally by RouteStatsTracker as
+  // state deltas are applied, so this is just a copy of some small
+  // aggregates - no route table walk.
+  auto routeStats = routeStatsTracker_->getRouteStats();
+  fbData->setCounter("routes.v4", routeStats.v4Routes);
+  fbData->setCounter("routes.v6", routeStats.v6Routes);
+  for (int len = 0; len <= 32; ++len) {
+    fbData->setCounter(folly::to<std::string>("routes.v4.mask_len.", len),
+                       routeStats.v4RoutesByMaskLen[len]);
+  }
+  for (int len = 0; len <= 128; ++len) {
+    fbData->setCounter(folly::to<std::string>("routes.v6.mask_len.", len),
+                       routeStats.v6RoutesByMaskLen[len]);
+  }
+  for (const auto& entry : routeStats.routesByClient) {
+    fbData->setCounter(folly::to<std::string>("routes.client.", entry.first),
+                       entry.second);
+  }
+}
+
+void SwSwitch::publishSwitchStateStats() {
+  auto liveStates = SwitchState::getLiveStateCount();
+  fbData->setCounter("switch_state.live_generations", liveStates);
+  fbData->setCounter("switch_state.generation", getState()->getGeneration());
+  if (FLAGS_live_switch_states_warn_threshold > 0 &&
+      liveStates >
+          static_cast<uint32_t>(FLAGS_live_switch_states_warn_threshold)) {
+    // Old generations are pinned by readers holding on to the result of
+    // getState(); the usual culprit is a slow dump walking a snapshot.
+    LOG(WARNING) << liveStates << " SwitchState generations are alive; "
+      "a slow reader is probably pinning old copy-on-write state";
+  }
+}
+
+void SwSwitch::publishMemoryStats() {
+  // Whether pools that asked for hugepage backing actually got explicit
+  // 2MB pages, or fell back to normal pages because the pool configured
+  // via vm.nr_hugepages was empty.
+  fbData->setCounter("hugepages.maps", facebook::network::numHugePageMaps());
+  fbData->setCounter("hugepages.map_fallbacks",
+                     facebook::network::numHugePageMapFallbacks());
+
+  // Per-subsystem memory gauges, so RSS growth can be attributed to
+  // route tables, neighbor caches, or capture buffers rather than
+  // guessed at.  Recomputing the breakdown walks the route tables, so
+  // it runs every FLAGS_memory_stats_interval_secs, not every tick.
+  if (FLAGS_memory_stats_interval_secs <= 0) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (now - lastMemoryStatsWalk_ <
+      seconds(FLAGS_memory_stats_interval_secs)) {
+    return;
+  }
+  lastMemoryStatsWalk_ = now;
+  for (const auto& entry : computeMemoryBreakdown()) {
+    fbData->setCounter(folly::to<std::string>("memory.", entry.first,
+                                              "_bytes"),
+                       entry.second);
+  }
+}
+
+namespace {
+
+// Approximate heap footprint of one route node: the node itself (the
+// fields are stored inline) plus the per-client next hop sets and the
+// resolved forwarding set, which live in out-of-line flat containers.
+// The per-client sets are estimated as the best list's size times the
+// client count; in practice clients announce similar-width ECMP.
+template<typename RouteT>
+int64_t routeMemoryBytes(const RouteT& route) {
+  int64_t bytes = sizeof(route);
+  if (!route.nexthopsIsEmpty()) {
+    bytes += route.bestNextHopList().size() * route.numClients() *
+        sizeof(folly::IPAddress);
+  }
+  bytes += route.getForwardInfo().getNexthops().size() *
+      sizeof(RouteForwardInfo::Nexthop);
+  return bytes;
+}
+
+} // unnamed namespace
+
+std::map<std::string, int64_t> SwSwitch::computeMemoryBreakdown() {
+  std::map<std::string, int64_t> breakdown;
+  auto state = getState();
+
+  int64_t routesBytes = 0;
+  for (const auto& rt : *state->getRouteTables()) {
+    for (const auto& ritr : rt->getRibV4()->routes()) {
+      routesBytes += routeMemoryBytes(*ritr.value());
+    }
+    for (const auto& ritr : rt->getRibV6()->routes()) {
+      routesBytes += routeMemoryBytes(*ritr.value());
+    }
+  }
+  breakdown["routes"] = routesBytes;
+
+  int64_t neighborsBytes = 0;
+  for (const auto& vlan : *state->getVlans()) {
+    neighborsBytes += vlan->getArpTable()->size() * sizeof(ArpEntry);
+    neighborsBytes += vlan->getNdpTable()->size() * sizeof(NdpEntry);
+  }
+  breakdown["neighbors"] = neighborsBytes;
+
+  // The capture queues already maintain byte accounting on their hot
+  // paths; this is just a sum of those counters plus a walk of the
+  // small flight recorder rings.
+  breakdown["capture"] = pcapMgr_->bytesBuffered();
+
+  return breakdown;
+}
+
 void SwSwitch::setStateInternal(std::shared_ptr<SwitchState> newState) {
   // This is one of the only two places that should ever directly access
   // stateDontUseDirectly_.  (getState() being the other one.)
@@ -719,6 +1697,12 @@ void SwSwitch::applyUpdate(const shared_ptr<SwitchState>& oldState,
       folly::exceptionStr(ex);
   }
 
+  // Journal the applied route changes now that the hardware has them;
+  // appends run on the update thread only, so no locking is needed.
+  if (updateJournal_) {
+    updateJournal_->append(delta);
+  }
+
   // Notifies all observers of the current state update.
   notifyStateObservers(delta);
 
@@ -729,6 +1713,60 @@ void SwSwitch::applyUpdate(const shared_ptr<SwitchState>& oldState,
   VLOG(0) << "Update state took " << duration.count() << "us";
 }
 
+void SwSwitch::recordConvergenceTrace(const StateUpdate& update) {
+  auto enqueue = update.getTraceTime(StateUpdate::TRACE_ENQUEUE);
+  auto apply = update.getTraceTime(StateUpdate::TRACE_APPLY);
+  auto hwSync = update.getTraceTime(StateUpdate::TRACE_HW_SYNC);
+  auto hwDone = update.getTraceTime(StateUpdate::TRACE_HW_DONE);
+  if (enqueue == StateUpdate::TracePoint() ||
+      apply == StateUpdate::TracePoint()) {
+    // Updates constructed outside updateState() (e.g. in tests) may not
+    // have been stamped; there is nothing meaningful to record.
+    return;
+  }
+
+  auto queueUs = duration_cast<microseconds>(apply - enqueue);
+  auto applyUs = duration_cast<microseconds>(hwSync - apply);
+  auto hwUs = duration_cast<microseconds>(hwDone - hwSync);
+  auto totalUs = duration_cast<microseconds>(hwDone - enqueue);
+  stats()->convergenceTrace(queueUs, applyUs, hwUs, totalUs);
+
+  ConvergenceTraceRecord record;
+  record.name = update.getName();
+  record.enqueuedMsec = std::chrono::duration_cast<std::chrono::milliseconds>(
+      update.getEnqueuedAt().time_since_epoch()).count();
+  record.queueUsec = queueUs.count();
+  record.applyUsec = applyUs.count();
+  record.hwUsec = hwUs.count();
+  record.totalUsec = totalUs.count();
+
+  std::lock_guard<std::mutex> g(convergenceTracesLock_);
+  convergenceTraces_.push_back(std::move(record));
+  while (convergenceTraces_.size() >
+         static_cast<size_t>(FLAGS_convergence_trace_history)) {
+    convergenceTraces_.pop_front();
+  }
+}
+
+std::vector<SwSwitch::ConvergenceTraceRecord> SwSwitch::getConvergenceTraces(
+    int32_t numTraces) const {
+  std::vector<ConvergenceTraceRecord> traces;
+  {
+    std::lock_guard<std::mutex> g(convergenceTracesLock_);
+    traces.assign(convergenceTraces_.begin(), convergenceTraces_.end());
+  }
+  // Slowest first; ties keep their completion order
+  std::stable_sort(traces.begin(), traces.end(),
+                   [] (const ConvergenceTraceRecord& a,
+                       const ConvergenceTraceRecord& b) {
+                     return a.totalUsec > b.totalUsec;
+                   });
+  if (numTraces > 0 && traces.size() > static_cast<size_t>(numTraces)) {
+    traces.resize(numTraces);
+  }
+  return traces;
+}
+
 PortStats* SwSwitch::portStats(PortID portID) {
   return stats()->port(portID);
 }
@@ -738,9 +1776,13 @@ PortStats* SwSwitch::portStats(const RxPacket* pkt) {
 }
 
 map<int32_t, PortStatus> SwSwitch::getPortStatus() {
+  return getPortStatus(getState());
+}
+
+map<int32_t, PortStatus> SwSwitch::getPortStatus(
+    const std::shared_ptr<SwitchState>& state) {
   map<int32_t, PortStatus> statusMap;
-  std::shared_ptr<PortMap> portMap = getState()->getPorts();
-  for (const auto& p : *portMap) {
+  for (const auto& p : *state->getPorts()) {
     statusMap[p->getID()] = fillInPortStatus(*p, this);
   }
   return statusMap;
@@ -775,7 +1817,42 @@ void SwSwitch::setPortStatusCounter(PortID port, bool up) {
   fbData->setCounter(getPortUpName(state->getPort(port)), int(up));
 }
 
+void SwSwitch::setPortFlapCounter(PortID port) {
+  auto state = getState();
+  if (!state) {
+    // Make sure the state actually exists, this could be an issue if
+    // called during initialization
+    return;
+  }
+  uint64_t count;
+  {
+    std::lock_guard<mutex> guard(linkStateLock_);
+    count = ++linkFlapCounts_[port];
+  }
+  fbData->setCounter(getPortFlapName(state->getPort(port)), count);
+}
+
 void SwSwitch::packetReceived(std::unique_ptr<RxPacket> pkt) noexcept {
+  // This runs on the hardware rx callback thread, which we did not
+  // create ourselves; the mark is an idempotent thread local store.
+  markPacketPathThread();
+  // Sample packets for latency tracing before any queueing, so the
+  // dispatch stamp captures time spent waiting in the rx rings too
+  if (FLAGS_rx_pkt_trace_interval > 0 &&
+      ++rxTraceCounter_ % FLAGS_rx_pkt_trace_interval == 0) {
+    pkt->enableTrace();
+    pkt->traceStamp(RxPacket::TRACE_DISPATCH);
+  }
+  if (rxDispatcher_) {
+    // Hand the packet off to the ring for its class, so a flood of low
+    // priority traffic cannot queue ahead of protocol traffic here.
+    rxDispatcher_->packetReceived(std::move(pkt));
+    return;
+  }
+  processRxPacket(std::move(pkt));
+}
+
+void SwSwitch::processRxPacket(std::unique_ptr<RxPacket> pkt) noexcept {
   PortID port = pkt->getSrcPort();
   try {
     handlePacket(std::move(pkt));
@@ -800,6 +1877,7 @@ void SwSwitch::handlePacket(std::unique_ptr<RxPacket> pkt) {
   if (!isFullyInitialized()) {
     return;
   }
+  pkt->traceStamp(RxPacket::TRACE_CLASSIFY);
   PortID port = pkt->getSrcPort();
   stats()->port(port)->trappedPkt();
 
@@ -817,11 +1895,24 @@ void SwSwitch::handlePacket(std::unique_ptr<RxPacket> pkt) {
   Cursor c(pkt->buf());
   auto dstMac = PktUtil::readMac(&c);
   auto srcMac = PktUtil::readMac(&c);
-  auto ethertype = c.readBE<uint16_t>();
-  if (ethertype == 0x8100) {
-    // 802.1Q
-    c += 2; // Advance over the VLAN tag.  We ignore it for now
+  uint16_t ethertype{0};
+  if (pkt->hasParseContext()) {
+    // The rx dispatcher's classifier already walked the L2 header;
+    // reuse what it found instead of re-branching on the VLAN tag.
+    ethertype = pkt->getEthertype();
+    c += pkt->getL3HdrOffset() - (c - Cursor(pkt->buf()));
+  } else {
     ethertype = c.readBE<uint16_t>();
+    if (ethertype == 0x8100) {
+      // 802.1Q
+      c += 2; // Advance over the VLAN tag.  We ignore it for now
+      ethertype = c.readBE<uint16_t>();
+    }
+    // Annotate where the L3 header starts, so that consumers further down
+    // the pipeline can use the rx buffer directly instead of re-parsing the
+    // L2 header (which may or may not carry a VLAN tag).
+    pkt->setL3HdrOffset(c - Cursor(pkt->buf()));
+    pkt->setParseContext(ethertype, RxPacket::kL4ProtoUnknown);
   }
 
   VLOG(5) << "trapped packet: src_port=" << pkt->getSrcPort() <<
@@ -832,24 +1923,38 @@ void SwSwitch::handlePacket(std::unique_ptr<RxPacket> pkt) {
     " ethertype=0x" << std::hex << ethertype <<
     " :: " << pkt->describeDetails();
 
-  switch (ethertype) {
-  case ArpHandler::ETHERTYPE_ARP:
-    arp_->handlePacket(std::move(pkt), dstMac, srcMac, c);
+  // Hardware flow samples are copies of forwarded traffic; hand them
+  // to the flow sampler instead of the protocol handlers.
+  if (pkt->isSampled()) {
+    flowSampler_->sampledPacketReceived(pkt.get());
     return;
-  case LldpManager::ETHERTYPE_LLDP:
-    if (lldpManager_) {
-      lldpManager_->handlePacket(std::move(pkt), dstMac, srcMac, c);
-      return;
+  }
+
+  // Early demux for control plane flows (e.g. BGP) terminating on the
+  // switch: matching packets go straight to the host interface with no
+  // further classification, so keepalive latency stays constant even
+  // when the slow path is loaded.
+  // The demux table only holds TCP/UDP flows; when the classifier
+  // already saw some other L4 protocol, skip the header walk entirely.
+  auto l4Proto = pkt->getL4Proto();
+  bool demuxable = l4Proto == RxPacket::kL4ProtoUnknown ||
+      l4Proto == IP_PROTO_TCP || l4Proto == IP_PROTO_UDP;
+  InterfaceID demuxIntf(0);
+  if (demuxable && hostDemuxTable_->lookup(ethertype, c, &demuxIntf)) {
+    auto l3Len = len - pkt->getL3HdrOffset();
+    if (sendPacketToHost(demuxIntf, std::move(pkt))) {
+      stats()->port(port)->pktToHost(l3Len);
+    } else {
+      stats()->port(port)->pktDropped();
     }
-    break;
-  case IPv4Handler::ETHERTYPE_IPV4:
-    ipv4_->handlePacket(std::move(pkt), dstMac, srcMac, c);
     return;
-  case IPv6Handler::ETHERTYPE_IPV6:
-    ipv6_->handlePacket(std::move(pkt), dstMac, srcMac, c);
+  }
+
+  pkt->traceStamp(RxPacket::TRACE_HANDLER);
+  auto handler = ethertypeDispatch_.lookup(ethertype);
+  if (handler) {
+    (this->*handler)(std::move(pkt), dstMac, srcMac, c);
     return;
-  default:
-    break;
   }
 
   // If we are still here, we don't know what to do with this packet.
@@ -857,30 +1962,56 @@ void SwSwitch::handlePacket(std::unique_ptr<RxPacket> pkt) {
   stats()->port(port)->pktUnhandled();
 }
 
-void SwSwitch::linkStateChanged(PortID portId, bool up) {
-  LOG(INFO) << "Link state changed: " << portId << "->" << (up ? "UP" : "DOWN");
-  if (not isFullyInitialized()) {
+const SwSwitch::EthertypeDispatch SwSwitch::ethertypeDispatch_ =
+    SwSwitch::EthertypeDispatch::make({
+      {ArpHandler::ETHERTYPE_ARP, &SwSwitch::handleArpPacket},
+      {LldpManager::ETHERTYPE_LLDP, &SwSwitch::handleLldpPacket},
+      {IPv4Handler::ETHERTYPE_IPV4, &SwSwitch::handleIPv4Packet},
+      {IPv6Handler::ETHERTYPE_IPV6, &SwSwitch::handleIPv6Packet},
+    });
+
+void SwSwitch::handleArpPacket(std::unique_ptr<RxPacket> pkt,
+                               folly::MacAddress dst,
+                               folly::MacAddress src,
+                               folly::io::Cursor cursor) {
+  arp_->handlePacket(std::move(pkt), dst, src, cursor);
+}
+
+void SwSwitch::handleLldpPacket(std::unique_ptr<RxPacket> pkt,
+                                folly::MacAddress dst,
+                                folly::MacAddress src,
+                                folly::io::Cursor cursor) {
+  if (!lldpManager_) {
+    stats()->port(pkt->getSrcPort())->pktUnhandled();
     return;
   }
+  lldpManager_->handlePacket(std::move(pkt), dst, src, cursor);
+}
 
-  // Schedule an update for port's operational status
-  auto updateFn = [=] (const std::shared_ptr<SwitchState>& state) {
-    std::shared_ptr<SwitchState> newState(state);
-    auto* port = newState->getPorts()->getPortIf(portId).get();
-    if (not port) {
-      throw FbossError("Port ", portId, " doesn't exists in SwitchState.");
-    }
+void SwSwitch::handleIPv4Packet(std::unique_ptr<RxPacket> pkt,
+                                folly::MacAddress dst,
+                                folly::MacAddress src,
+                                folly::io::Cursor cursor) {
+  ipv4_->handlePacket(std::move(pkt), dst, src, cursor);
+}
 
-    port = port->modify(&newState);
-    port->setOperState(up);
+void SwSwitch::handleIPv6Packet(std::unique_ptr<RxPacket> pkt,
+                                folly::MacAddress dst,
+                                folly::MacAddress src,
+                                folly::io::Cursor cursor) {
+  ipv6_->handlePacket(std::move(pkt), dst, src, cursor);
+}
 
-    return newState;
-  };
-  updateState("Port OperState Update", std::move(updateFn));
+void SwSwitch::linkStateChanged(PortID portId, bool up) {
+  LOG(INFO) << "Link state changed: " << portId << "->" << (up ? "UP" : "DOWN");
+  if (not isFullyInitialized()) {
+    return;
+  }
 
   // Log event and update counters
   logLinkStateEvent(portId, up);
   setPortStatusCounter(portId, up);
+  setPortFlapCounter(portId);
   stats()->port(portId)->linkStateChange();
 
   // Fire explicit callback for purging neighbor entries.
@@ -888,6 +2019,62 @@ void SwSwitch::linkStateChanged(PortID portId, bool up) {
     backgroundEventBase_.runInEventBaseThread(
         [this, portId]() { nUpdater_->portDown(portId); });
   }
+
+  // Record the transition and debounce the SwitchState update: a
+  // flapping transceiver or a linecard reseat can generate hundreds of
+  // transitions in under a second, and cloning the SwitchState for each
+  // one swamps the update thread.  All events that arrive within the
+  // debounce interval are applied as a single PortMap update, with the
+  // latest transition for each port winning.
+  bool scheduleFlush = false;
+  {
+    std::lock_guard<mutex> guard(linkStateLock_);
+    pendingLinkState_[portId] = up;
+    if (!linkStateFlushScheduled_) {
+      linkStateFlushScheduled_ = true;
+      scheduleFlush = true;
+    }
+  }
+  if (scheduleFlush) {
+    uint32_t debounceMs = std::max(FLAGS_link_state_debounce_ms, 0);
+    backgroundEventBase_.runInEventBaseThread([this, debounceMs]() {
+      backgroundEventBase_.runAfterDelay(
+          [this]() { flushPendingLinkStateChanges(); }, debounceMs);
+    });
+  }
+}
+
+void SwSwitch::flushPendingLinkStateChanges() {
+  std::map<PortID, bool> changes;
+  {
+    std::lock_guard<mutex> guard(linkStateLock_);
+    changes.swap(pendingLinkState_);
+    linkStateFlushScheduled_ = false;
+  }
+  if (changes.empty()) {
+    return;
+  }
+
+  auto updateFn = [changes = std::move(changes)](
+      const std::shared_ptr<SwitchState>& state) {
+    std::shared_ptr<SwitchState> newState(state);
+    for (const auto& change : changes) {
+      auto* port = newState->getPorts()->getPortIf(change.first).get();
+      if (not port) {
+        // The port was removed from the config while the update was
+        // pending; nothing left to apply for it.
+        LOG(WARNING) << "Port " << change.first
+                     << " doesn't exist in SwitchState, dropping its "
+                     << "pending link state change";
+        continue;
+      }
+
+      port = port->modify(&newState);
+      port->setOperState(change.second);
+    }
+    return newState;
+  };
+  updateStateUrgent("Port OperState Update", std::move(updateFn));
 }
 
 void SwSwitch::startThreads() {
@@ -895,6 +2082,13 @@ void SwSwitch::startThreads() {
       this->threadLoop("fbossBgThread", &backgroundEventBase_); }));
   updateThread_.reset(new std::thread([=] {
       this->threadLoop("fbossUpdateThread", &updateEventBase_); }));
+  for (int32_t idx = 0; idx < FLAGS_bg_worker_threads; ++idx) {
+    bgWorkerEventBases_.push_back(std::make_unique<EventBase>());
+    auto evb = bgWorkerEventBases_.back().get();
+    auto name = folly::to<std::string>("fbossBgWorker-", idx);
+    bgWorkerThreads_.push_back(std::make_unique<std::thread>([=] {
+        this->threadLoop(name, evb); }));
+  }
 }
 
 void SwSwitch::stopThreads() {
@@ -912,19 +2106,112 @@ void SwSwitch::stopThreads() {
     updateEventBase_.runInEventBaseThread(
         [this] { updateEventBase_.terminateLoopSoon(); });
   }
+  for (const auto& evb : bgWorkerEventBases_) {
+    auto rawEvb = evb.get();
+    rawEvb->runInEventBaseThread([rawEvb] { rawEvb->terminateLoopSoon(); });
+  }
   if (backgroundThread_) {
     backgroundThread_->join();
   }
   if (updateThread_) {
     updateThread_->join();
   }
+  for (const auto& thread : bgWorkerThreads_) {
+    thread->join();
+  }
+}
+
+folly::EventBase* SwSwitch::pickBackgroundEVB() {
+  EventBase* best = &backgroundEventBase_;
+  auto bestBacklog = backgroundEventBase_.getNotificationQueueSize();
+  for (const auto& evb : bgWorkerEventBases_) {
+    auto backlog = evb->getNotificationQueueSize();
+    if (backlog < bestBacklog) {
+      best = evb.get();
+      bestBacklog = backlog;
+    }
+  }
+  return best;
 }
 
 void SwSwitch::threadLoop(StringPiece name, EventBase* eventBase) {
   initThread(name);
+  applyThreadScheduling(name);
+  markPacketPathThread();
   eventBase->loopForever();
 }
 
+/* static */ void SwSwitch::applyThreadScheduling(StringPiece name) {
+  auto role = name.str();
+  // The indexed worker threads ("fbossBgWorker-0", ...) share one
+  // entry, keyed by the name prefix before the '-'.
+  auto base = role.substr(0, role.find('-'));
+  if (!FLAGS_thread_cpu_sets.empty()) {
+    std::vector<std::string> entries;
+    folly::split(';', FLAGS_thread_cpu_sets, entries, true);
+    for (const auto& entry : entries) {
+      auto eq = entry.find('=');
+      if (eq == std::string::npos) {
+        LOG(ERROR) << "malformed --thread_cpu_sets entry \"" << entry << '"';
+        continue;
+      }
+      auto entryName = entry.substr(0, eq);
+      if (entryName != role && entryName != base) {
+        continue;
+      }
+      std::vector<int> cpus;
+      folly::split(',', entry.substr(eq + 1), cpus);
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      for (int cpu : cpus) {
+        CPU_SET(cpu, &cpuSet);
+      }
+      if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+        LOG(ERROR) << "failed to set CPU affinity for " << role << ": "
+                   << folly::errnoStr(errno);
+      }
+      break;
+    }
+  }
+  std::vector<std::string> fifoNames;
+  folly::split(',', FLAGS_fifo_threads, fifoNames, true);
+  if (std::find(fifoNames.begin(), fifoNames.end(), role) != fifoNames.end() ||
+      std::find(fifoNames.begin(), fifoNames.end(), base) != fifoNames.end()) {
+    struct sched_param param = {};
+    param.sched_priority = FLAGS_fifo_priority;
+    auto rv = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rv != 0) {
+      LOG(ERROR) << "failed to set SCHED_FIFO for " << role
+                 << " (missing CAP_SYS_NICE?): " << folly::errnoStr(rv);
+    }
+  }
+  // Export what actually stuck rather than what was asked for, so a
+  // placement that silently failed (bad CPU number, missing
+  // capability) is visible from the counters.
+  cpu_set_t actual;
+  CPU_ZERO(&actual);
+  int64_t mask = 0;
+  if (sched_getaffinity(0, sizeof(actual), &actual) == 0) {
+    for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &actual)) {
+        mask |= int64_t(1) << cpu;
+      }
+    }
+  }
+  fbData->setCounter(folly::to<std::string>("thread.", role, ".cpu_mask"),
+                     mask);
+  fbData->setCounter(folly::to<std::string>("thread.", role, ".sched_fifo"),
+                     sched_getscheduler(0) == SCHED_FIFO ? 1 : 0);
+}
+
+void SwSwitch::markPacketPathThread() {
+  packetPathThread = true;
+}
+
+bool SwSwitch::isPacketPathThread() {
+  return packetPathThread;
+}
+
 std::unique_ptr<TxPacket> SwSwitch::allocatePacket(uint32_t size) {
   return hw_->allocatePacket(size);
 }
@@ -968,6 +2255,24 @@ void SwSwitch::sendPacketSwitched(std::unique_ptr<TxPacket> pkt) noexcept {
 void SwSwitch::sendL3Packet(
     std::unique_ptr<TxPacket> pkt,
     folly::Optional<InterfaceID> maybeIfID) noexcept {
+  sendL3PacketImpl(getState(), std::move(pkt), maybeIfID);
+}
+
+void SwSwitch::sendL3Packets(
+    std::vector<std::unique_ptr<TxPacket>> pkts,
+    folly::Optional<InterfaceID> maybeIfID) noexcept {
+  // One state snapshot for the whole batch; host-originated bursts
+  // (e.g. a BGP table transfer) pay the state access once.
+  auto state = getState();
+  for (auto& pkt : pkts) {
+    sendL3PacketImpl(state, std::move(pkt), maybeIfID);
+  }
+}
+
+void SwSwitch::sendL3PacketImpl(
+    const std::shared_ptr<SwitchState>& state,
+    std::unique_ptr<TxPacket> pkt,
+    folly::Optional<InterfaceID> maybeIfID) noexcept {
 
   // Buffer should not be shared.
   folly::IOBuf *buf = pkt->buf();
@@ -991,7 +2296,7 @@ void SwSwitch::sendL3Packet(
   // Get VlanID associated with interface
   VlanID vlanID = getCPUVlan();
   if (maybeIfID.hasValue()) {
-    auto intf = getState()->getInterfaces()->getInterfaceIf(*maybeIfID);
+    auto intf = state->getInterfaces()->getInterfaceIf(*maybeIfID);
     if (!intf) {
       LOG(ERROR) << "Interface " << *maybeIfID << " doesn't exists in state.";
       return;
@@ -1048,7 +2353,7 @@ void SwSwitch::sendL3Packet(
       // Resolve neighbor mac address for given destination address. If address
       // doesn't exists in NDP table then request neighbor solicitation for it.
       CHECK(dstAddr.isLinkLocal());
-      auto vlan = getState()->getVlans()->getVlan(vlanID);
+      auto vlan = state->getVlans()->getVlan(vlanID);
       if (dstAddr.isV4()) {
         // We do not consult ARP table to forward v4 link local addresses.
         // Reason explained below.
@@ -1065,11 +2370,21 @@ void SwSwitch::sendL3Packet(
           auto entry = vlan->getNdpTable()->getEntry(dstAddrV6);
           dstMac = entry->getMac();
         } catch (...) {
-          // We don't have dstAddr in our NDP table. Request solicitation for
-          // it and let this packet be dropped.
+          // We don't have dstAddr in our NDP table. Request solicitation
+          // for it and park the packet against the pending entry instead
+          // of dropping it; it is re-sent through sendL3Packet() once the
+          // neighbor resolves, so the host doesn't have to wait for a
+          // kernel retransmit. Strip the L2 framing we prepended above
+          // first -- the packet is re-framed with the real mac on resend.
           IPv6Handler::sendNeighborSolicitation(
               this, dstAddrV6, srcMac, vlanID);
-          throw;
+          buf->trimStart(l2Len);
+          if (tailRoom) {
+            buf->trimEnd(tailRoom);
+          }
+          getNeighborUpdater()->queuePendingL3Packet(
+              vlanID, dstAddrV6, std::move(pkt), maybeIfID);
+          return;
         } // try
       }
     } else {
@@ -1103,6 +2418,7 @@ void SwSwitch::sendL3Packet(
 bool SwSwitch::sendPacketToHost(
     InterfaceID dstIfID,
     std::unique_ptr<RxPacket> pkt) {
+  recordRxPacketTrace(pkt.get());
   if (tunMgr_) {
     return tunMgr_->sendPacketToHost(dstIfID, std::move(pkt));
   } else {
@@ -1110,7 +2426,67 @@ bool SwSwitch::sendPacketToHost(
   }
 }
 
+namespace {
+/*
+ * TSC ticks per microsecond, measured once against steady_clock. The
+ * 10ms calibration spin runs on the first sampled packet's recording,
+ * after which the conversion is a single multiply.
+ */
+double tscTicksPerUsec() {
+  static const double ticksPerUsec = [] {
+    auto t0 = std::chrono::steady_clock::now();
+    auto c0 = RxPacket::readTsc();
+    while (std::chrono::steady_clock::now() - t0 <
+        std::chrono::milliseconds(10)) {
+    }
+    auto c1 = RxPacket::readTsc();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - t0);
+    return static_cast<double>(c1 - c0) / elapsed.count();
+  }();
+  return ticksPerUsec;
+}
+} // unnamed namespace
+
+void SwSwitch::recordRxPacketTrace(RxPacket* pkt) {
+  if (!pkt->isTraced()) {
+    return;
+  }
+  pkt->traceStamp(RxPacket::TRACE_FORWARD);
+  auto dispatch = pkt->getTraceTsc(RxPacket::TRACE_DISPATCH);
+  auto classify = pkt->getTraceTsc(RxPacket::TRACE_CLASSIFY);
+  auto handler = pkt->getTraceTsc(RxPacket::TRACE_HANDLER);
+  auto forward = pkt->getTraceTsc(RxPacket::TRACE_FORWARD);
+  if (dispatch == 0 || classify < dispatch || handler < classify ||
+      forward < handler) {
+    // Incomplete trail (e.g. a packet injected below the normal rx
+    // path) or a TSC skew across cores; don't pollute the histograms
+    return;
+  }
+  auto ticksPerUsec = tscTicksPerUsec();
+  auto arrival = pkt->getArrivalTsc();
+  if (arrival != 0 && arrival <= dispatch) {
+    // Time spent in the hardware rx callback itself, from the arrival
+    // stamp to the dispatch stamp. Packets without an arrival stamp
+    // (injected below the normal rx path) simply skip this stage.
+    stats()->rxPktTraceArrival((dispatch - arrival) / ticksPerUsec);
+  }
+  stats()->rxPktTrace(
+      (classify - dispatch) / ticksPerUsec,
+      (handler - classify) / ticksPerUsec,
+      (forward - handler) / ticksPerUsec);
+}
+
 void SwSwitch::applyConfig(const std::string& reason) {
+  // On a cold start with an unchanged config file, the SwitchState we
+  // are about to build is identical to the one the previous run built;
+  // reuse the cached copy and skip the rebuild.  Only the initial apply
+  // is eligible: later reloads start from a state with dynamic entries
+  // that must not end up in the cache.
+  bool initialApply = getSwitchRunState() < SwitchRunState::CONFIGURED;
+  if (FLAGS_config_cache && initialApply && applyCompiledConfigCache(reason)) {
+    return;
+  }
   // We don't need to hold a lock here. updateStateBlocking() does that for us.
   updateStateBlocking(
       reason,
@@ -1141,6 +2517,167 @@ void SwSwitch::applyConfig(const std::string& reason) {
           port->setOperState(hw_->isPortUp(port->getID()));
         }
 
+        return newState;
+      });
+
+  if (FLAGS_config_cache && initialApply) {
+    saveCompiledConfigCache();
+  }
+}
+
+bool SwSwitch::applyCompiledConfigCache(const std::string& reason) {
+  if (FLAGS_config.empty()) {
+    // Only file-based configs are cached; the hash of the config file
+    // is what keys the cache.
+    return false;
+  }
+  std::string configStr;
+  if (!folly::readFile(FLAGS_config.c_str(), configStr)) {
+    return false;
+  }
+  auto cacheFile = platform_->getCompiledConfigCacheFile();
+  std::string cacheStr;
+  if (!folly::readFile(cacheFile.c_str(), cacheStr)) {
+    return false;
+  }
+
+  std::shared_ptr<SwitchState> cachedState;
+  cfg::SwitchConfig config;
+  try {
+    auto cache = folly::parseJson(cacheStr);
+    auto hash = folly::to<std::string>(folly::hash::fnv64(configStr));
+    if (cache[kConfigHash].asString() != hash) {
+      VLOG(1) << "config file changed since last run; not using the "
+        "compiled config cache";
+      return false;
+    }
+    cachedState = SwitchState::fromFollyDynamic(cache[kCachedSwitchState]);
+    apache::thrift::SimpleJSONSerializer::deserialize<cfg::SwitchConfig>(
+        configStr.c_str(), config);
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "failed to load compiled config cache from " << cacheFile
+               << ": " << folly::exceptionStr(ex);
+    return false;
+  }
+
+  LOG(INFO) << "config unchanged since last run; loading pre-built state "
+    "from " << cacheFile;
+  bool applied = true;
+  updateStateBlocking(
+      folly::to<std::string>(reason, " (from compiled config cache)"),
+      [&](const shared_ptr<SwitchState>& state) -> shared_ptr<SwitchState> {
+        auto newState = state->clone();
+        newState->resetPorts(cachedState->getPorts());
+        newState->resetVlans(cachedState->getVlans());
+        newState->resetIntfs(cachedState->getInterfaces());
+        newState->resetRouteTables(cachedState->getRouteTables());
+        newState->resetAcls(cachedState->getAcls());
+        newState->setDefaultVlan(cachedState->getDefaultVlan());
+
+        // The scalar fields are not part of the serialized state; set
+        // them from the config directly, as ThriftConfigApplier would.
+        std::chrono::seconds arpTimeout(config.arpTimeoutSeconds);
+        newState->setArpTimeout(arpTimeout);
+        newState->setNdpTimeout(arpTimeout);
+        newState->setArpAgerInterval(
+            std::chrono::seconds(config.arpAgerInterval));
+        newState->setMaxNeighborProbes(config.maxNeighborProbes);
+        newState->setStaleEntryInterval(
+            std::chrono::seconds(config.staleEntryInterval));
+        newState->setCpuQueues(config.cpuQueues);
+
+        if (!isValidStateUpdate(StateDelta(state, newState))) {
+          // Throwing here would propagate out of applyConfig() and
+          // crash-loop the boot on a stale cache; skip the update and
+          // let the caller fall back to a full config apply instead.
+          LOG(ERROR) << "cached config state failed validation; falling "
+            "back to a full config apply";
+          applied = false;
+          return nullptr;
+        }
+        curConfigStr_ = configStr;
+        curConfig_ = std::move(config);
+
+        // Set oper status of interfaces in SwitchState
+        for (auto const& port : *newState->getPorts()) {
+          port->setOperState(hw_->isPortUp(port->getID()));
+        }
+
+        return newState;
+      });
+  return applied;
+}
+
+void SwSwitch::saveCompiledConfigCache() {
+  if (FLAGS_config.empty()) {
+    return;
+  }
+  folly::dynamic cache = folly::dynamic::object;
+  cache[kConfigHash] =
+      folly::to<std::string>(folly::hash::fnv64(curConfigStr_));
+  cache[kCachedSwitchState] = getState()->toFollyDynamic();
+  auto cacheFile = platform_->getCompiledConfigCacheFile();
+  if (!dumpStateToFile(cacheFile, cache)) {
+    LOG(ERROR) << "failed to write compiled config cache to " << cacheFile;
+  }
+}
+
+void SwSwitch::applyConfigPatch(const std::string& section,
+                                const std::string& patchJson) {
+  cfg::SwitchConfig patch;
+  apache::thrift::SimpleJSONSerializer::deserialize<cfg::SwitchConfig>(
+      patchJson.c_str(), patch);
+
+  updateStateBlocking(
+      folly::to<std::string>("config patch (", section, ")"),
+      [&](const shared_ptr<SwitchState>& state) -> shared_ptr<SwitchState> {
+        // Splice the patched section into a copy of the running config.
+        // Everything else matches curConfig_, so the section-level diff
+        // in applyThriftConfig() skips the corresponding rebuild steps.
+        cfg::SwitchConfig newConfig = curConfig_;
+        if (section == "ports") {
+          newConfig.ports = patch.ports;
+        } else if (section == "vlans") {
+          newConfig.vlans = patch.vlans;
+        } else if (section == "vlanPorts") {
+          newConfig.vlanPorts = patch.vlanPorts;
+        } else if (section == "interfaces") {
+          newConfig.interfaces = patch.interfaces;
+        } else if (section == "acls") {
+          newConfig.acls = patch.acls;
+          newConfig.__isset.acls = patch.__isset.acls;
+        } else if (section == "staticRoutes") {
+          newConfig.staticRoutesWithNhops = patch.staticRoutesWithNhops;
+          newConfig.__isset.staticRoutesWithNhops =
+              patch.__isset.staticRoutesWithNhops;
+          newConfig.staticRoutesToNull = patch.staticRoutesToNull;
+          newConfig.__isset.staticRoutesToNull =
+              patch.__isset.staticRoutesToNull;
+          newConfig.staticRoutesToCPU = patch.staticRoutesToCPU;
+          newConfig.__isset.staticRoutesToCPU =
+              patch.__isset.staticRoutesToCPU;
+        } else {
+          throw FbossError("Unknown config section \"", section, "\"");
+        }
+
+        auto newState = applyThriftConfig(state, &newConfig, platform_.get(),
+                                          &curConfig_);
+        if (!newState) {
+          // The patch matched the running config; nothing to do.
+          return nullptr;
+        }
+        if (!isValidStateUpdate(StateDelta(state, newState))) {
+          throw FbossError("Invalid config patch passed in, skipping");
+        }
+        curConfig_ = std::move(newConfig);
+        apache::thrift::SimpleJSONSerializer::serialize(curConfig_,
+                                                        &curConfigStr_);
+
+        // Set oper status of interfaces in SwitchState
+        for (auto const& port : *newState->getPorts()) {
+          port->setOperState(hw_->isPortUp(port->getID()));
+        }
+
         return newState;
       });
 }
@@ -11,19 +11,25 @@
 
 #include "fboss/agent/HighresCounterUtil.h"
 #include "fboss/agent/HwSwitch.h"
+#include "fboss/agent/packet/DispatchTable.h"
 #include "fboss/agent/state/StateUpdate.h"
 #include "fboss/agent/types.h"
 #include "fboss/agent/ThreadHeartbeat.h"
 #include "fboss/agent/gen-cpp2/switch_config_types.h"
 #include "fboss/agent/Utils.h"
 
+#include <folly/AtomicIntrusiveLinkedList.h>
 #include <folly/SpinLock.h>
+#include <folly/futures/Future.h>
 #include <folly/IntrusiveList.h>
 #include <folly/Range.h>
+#include <folly/io/Cursor.h>
 #include <folly/ThreadLocal.h>
 #include <folly/io/async/EventBase.h>
 
 #include <atomic>
+#include <deque>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -31,10 +37,12 @@
 namespace facebook { namespace fboss {
 
 class ArpHandler;
+class FlowSampler;
 class IPv4Handler;
 class IPv6Handler;
 class LldpManager;
 class PktCaptureManager;
+class RxPacketDispatcher;
 class Platform;
 class Port;
 class PortStats;
@@ -44,9 +52,19 @@ class SwitchStats;
 class StateDelta;
 class NeighborUpdater;
 class RouteUpdateLogger;
+class RouteStatsTracker;
+class DhcpRelayTable;
+class DhcpTransactionCache;
+class HostDemuxTable;
+class NeighborResponseIndex;
+class PortSendContextTable;
+class HighresShmExporter;
+class IcmpErrorRateLimiter;
 class StateObserver;
 class TunManager;
+class PeriodicScheduler;
 class PortRemediator;
+class UpdateJournal;
 class UnresolvedNhopsProber;
 
 enum SwitchFlags : int {
@@ -62,6 +80,29 @@ inline SwitchFlags operator|=(SwitchFlags& a, const SwitchFlags b) {
     (a = static_cast<SwitchFlags>(static_cast<int>(a) | static_cast<int>(b)));
 }
 
+/*
+ * Bitmask of the SwitchState sections a StateObserver is interested in.
+ *
+ * Observers pass a mask of these when registering. Each state update is
+ * classified once (copy-on-write lets us detect unchanged sections with a
+ * pointer comparison) and only observers whose mask intersects the changed
+ * sections are notified, so observers don't all re-walk deltas that contain
+ * nothing for them.
+ *
+ * INTEREST_SWITCH_SETTINGS covers the scalar fields stored directly on the
+ * SwitchState (default VLAN, neighbor timeouts etc.) rather than in one of
+ * the copy-on-write maps.
+ */
+enum StateObserverInterests : uint32_t {
+  INTEREST_PORTS = 0x01,
+  INTEREST_VLANS = 0x02,
+  INTEREST_INTERFACES = 0x04,
+  INTEREST_ROUTE_TABLES = 0x08,
+  INTEREST_ACLS = 0x10,
+  INTEREST_SWITCH_SETTINGS = 0x20,
+  INTEREST_ALL = 0x3f,
+};
+
 /*
  * A software representation of a switch.
  *
@@ -208,6 +249,20 @@ class SwSwitch : public HwSwitch::Callback {
    */
   void updateState(folly::StringPiece name, StateUpdateFn fn);
 
+  /**
+   * A version of updateState() with an explicit scheduling class.
+   *
+   * The update thread runs URGENT updates drained in the same sweep
+   * before NORMAL ones, and NORMAL before BULK, so producers of large
+   * background work (a full FIB sync, a monitoring-triggered config
+   * reapply) should tag it BULK to keep it out of the way of
+   * latency-critical updates. Updates that have waited longer than
+   * state_update_aging_ms are promoted one class per interval waited,
+   * so bulk work cannot be starved indefinitely.
+   */
+  void updateState(folly::StringPiece name, StateUpdateFn fn,
+                   StateUpdate::Priority priority);
+
   /**
    * Schedule an update to the switch state.
    *
@@ -222,6 +277,16 @@ class SwSwitch : public HwSwitch::Callback {
    */
   void updateStateNoCoalescing(folly::StringPiece name, StateUpdateFn fn);
 
+  /*
+   * Shorthand for updateState() with StateUpdate::Priority::URGENT, for
+   * latency-critical updates such as port down handling. The update is
+   * moved ahead of any normal or bulk updates already waiting in the
+   * queue, so its convergence time is bounded regardless of how much
+   * bulk work (e.g. a full FIB sync) is pending. The update function
+   * must not rely on being ordered after earlier queued updates.
+   */
+  void updateStateUrgent(folly::StringPiece name, StateUpdateFn fn);
+
   /*
    * A version of updateState() that doesn't return until the update has been
    * applied.
@@ -236,7 +301,23 @@ class SwSwitch : public HwSwitch::Callback {
    * thread, and would simply block the calling thread until the operation
    * completes.
    */
-  void updateStateBlocking(folly::StringPiece name, StateUpdateFn fn);
+  void updateStateBlocking(
+      folly::StringPiece name, StateUpdateFn fn,
+      StateUpdate::Priority priority = StateUpdate::Priority::NORMAL);
+
+  /*
+   * A version of updateState() that returns a Future fulfilled once the
+   * update has been applied (or has failed).
+   *
+   * Unlike updateStateBlocking() the calling thread is released
+   * immediately, which matters for callers drawn from bounded thread
+   * pools, such as Thrift workers. The future is fulfilled on the update
+   * thread; attach continuations via an executor if the follow-up work
+   * should not run there.
+   */
+  folly::Future<folly::Unit> updateStateFuture(
+      folly::StringPiece name, StateUpdateFn fn,
+      StateUpdate::Priority priority = StateUpdate::Priority::NORMAL);
 
   /**
    * Apply config from the config file (specified in 'config' flag).
@@ -247,6 +328,21 @@ class SwSwitch : public HwSwitch::Callback {
    */
   void applyConfig(const std::string& reason);
 
+  /**
+   * Apply a partial config update to the running config.
+   *
+   * The named section of the running config is replaced wholesale with
+   * the one from the patch (a serialized SwitchConfig carrying just that
+   * section); all other sections are carried forward unchanged, so the
+   * section-level diffing in applyThriftConfig() rebuilds only the
+   * switch state subtrees the patch touches.
+   *
+   * Throws FbossError if the section name is unknown or the resulting
+   * state is rejected by the hardware.
+   */
+  void applyConfigPatch(const std::string& section,
+                        const std::string& patchJson);
+
   /**
    * Get a set of high resolution samplers that we can query quickly.
    *
@@ -268,14 +364,17 @@ class SwSwitch : public HwSwitch::Callback {
                          const std::set<CounterRequest>& counters);
 
   /*
-   * Registers an observer of all state updates. An observer will be notified of
-   * all state updates that occur and all classes that care about state updates
-   * should register using this api.
+   * Registers an observer of state updates. An observer will be notified of
+   * all state updates whose changed sections intersect its interests mask
+   * (a combination of StateObserverInterests bits, INTEREST_ALL by default)
+   * and all classes that care about state updates should register using this
+   * api.
    *
    * The only required method for observers is stateUpdated and observers can
    * count on this always being called from the update thread.
    */
-  void registerStateObserver(StateObserver* observer, const std::string name);
+  void registerStateObserver(StateObserver* observer, const std::string name,
+                             uint32_t interests = INTEREST_ALL);
   void unregisterStateObserver(StateObserver* observer);
 
   /*
@@ -292,15 +391,58 @@ class SwSwitch : public HwSwitch::Callback {
   void initialConfigApplied(
       const std::chrono::steady_clock::time_point& startTime);
   void fibSynced();
+  /*
+   * Whether the FIB was preloaded from a snapshot on this boot and
+   * the route server has not synced over it yet. Used to log how much
+   * reconciliation the first live sync actually had to do.
+   */
+  bool fibPreloaded() const {
+    return fibPreloaded_.load(std::memory_order_acquire);
+  }
+  /*
+   * Count and log the routes the first live FIB sync changed relative
+   * to the preloaded snapshot. Called from the sync's state update
+   * function, with the delta between the preloaded and synced tables.
+   */
+  void logFibPreloadReconciliation(const StateDelta& delta);
   /*
    * Publish all thread-local stats to the main fbData singleton,
    * so they will be visible via fb303 thrift calls.
    *
    * This method should be called once per second.  It can be called from any
    * thread.
+   *
+   * Hardware counter collection is not run inline; publishStats() only
+   * aggregates the snapshots published by the most recent collection
+   * pass and then schedules the next pass via updateHwStatsAsync().
    */
   void publishStats();
 
+  /*
+   * Compute an approximate per-subsystem memory breakdown, in bytes.
+   *
+   * The state trees have no dedicated allocators, so the sizes are
+   * recomputed from node counts on a pinned SwitchState snapshot
+   * (routes plus their next hop storage, neighbor entries) rather
+   * than read from an arena; capture buffer bytes come from the
+   * byte accounting the capture queues already maintain.  The walk
+   * is proportional to the route table size, so callers should not
+   * invoke this every second; publishStats() rate-limits it via
+   * --memory_stats_interval_secs.
+   *
+   * This method is safe to call from any thread.
+   */
+  std::map<std::string, int64_t> computeMemoryBreakdown();
+
+  /*
+   * Schedule a hardware counter collection pass on the background
+   * thread.  The SDK locks taken while walking hardware counters
+   * contend with delta programming, so collection never runs on the
+   * caller's thread or the update thread.  If the previous pass is
+   * still running this tick is skipped rather than queued behind it.
+   */
+  void updateHwStatsAsync();
+
   /*
    * Get the SwitchStats for the current thread.
    *
@@ -347,6 +489,13 @@ class SwSwitch : public HwSwitch::Callback {
    */
   std::map<int32_t, PortStatus> getPortStatus();
 
+  /*
+   * Get PortStatus for all the ports in a particular state snapshot,
+   * for callers that answer several queries from one pinned state.
+   */
+  std::map<int32_t, PortStatus> getPortStatus(
+      const std::shared_ptr<SwitchState>& state);
+
   /*
    * Get PortStatus of the specified port.
    */
@@ -372,6 +521,17 @@ class SwSwitch : public HwSwitch::Callback {
     return &backgroundEventBase_;
   }
 
+  /*
+   * Pick a background EventBase for new deferrable work (periodic
+   * stats, neighbor maintenance, capture distribution and the like).
+   *
+   * Returns the least-loaded member of the background worker pool, so
+   * deferrable task classes spread across the pool instead of piling
+   * onto the single background thread during boot. Tasks stay pinned
+   * to the returned EventBase for their lifetime.
+   */
+  folly::EventBase* pickBackgroundEVB();
+
   /*
    * Get the EventBase for the update thread
    */
@@ -388,6 +548,15 @@ class SwSwitch : public HwSwitch::Callback {
    */
   void packetReceivedThrowExceptionOnError(std::unique_ptr<RxPacket> pkt);
 
+  /*
+   * Process a single trapped packet, swallowing any errors.
+   *
+   * This is the second half of packetReceived(): packets dispatched to
+   * the per-class rx rings are handled here by the RxPacketDispatcher
+   * threads.
+   */
+  void processRxPacket(std::unique_ptr<RxPacket> pkt) noexcept;
+
   // HwSwitch::Callback methods
   void packetReceived(std::unique_ptr<RxPacket> pkt) noexcept override;
   void linkStateChanged(PortID port, bool up) override;
@@ -447,6 +616,16 @@ class SwSwitch : public HwSwitch::Callback {
       std::unique_ptr<TxPacket> pkt,
       folly::Optional<InterfaceID> ifID = folly::none) noexcept;
 
+  /**
+   * Send a batch of L3 packets with the same semantics as
+   * sendL3Packet(), resolving the switch state snapshot once for the
+   * whole batch. Used by the tun rx path to amortize the state access
+   * over host-originated bursts.
+   */
+  void sendL3Packets(
+      std::vector<std::unique_ptr<TxPacket>> pkts,
+      folly::Optional<InterfaceID> ifID = folly::none) noexcept;
+
   /**
    * method to send out a packet from HW to host.
    *
@@ -455,6 +634,17 @@ class SwSwitch : public HwSwitch::Callback {
    */
   bool sendPacketToHost(InterfaceID dstIfID, std::unique_ptr<RxPacket> pkt);
 
+  /**
+   * Record the per-stage latency histograms for a sampled rx packet.
+   *
+   * Stamps the tx/host-forward stage and feeds the stage deltas into
+   * SwitchStats. No-op for packets that were not sampled for tracing
+   * (see --rx_pkt_trace_interval). Called from the points where a
+   * trapped packet leaves the slow path; packet handlers reaching such
+   * a point outside SwSwitch call this directly.
+   */
+  void recordRxPacketTrace(RxPacket* pkt);
+
   /**
    * Get the ArpHandler object.
    *
@@ -475,6 +665,18 @@ class SwSwitch : public HwSwitch::Callback {
     return ipv6_.get();
   }
 
+  /**
+   * Get the PeriodicScheduler, the central timer service all periodic
+   * agent work should register with rather than running its own
+   * AsyncTimeout.
+   *
+   * The PeriodicScheduler returned is owned by the SwSwitch, and is only
+   * valid as long as the SwSwitch object.
+   */
+  PeriodicScheduler* getPeriodicScheduler() {
+    return periodicScheduler_.get();
+  }
+
   /**
    * Get the NeighborUpdater object.
    *
@@ -492,6 +694,65 @@ class SwSwitch : public HwSwitch::Callback {
     return pcapMgr_.get();
   }
 
+  /*
+   * Get the FlowSampler object.
+   */
+  FlowSampler* getFlowSampler() {
+    return flowSampler_.get();
+  }
+
+  /*
+   * One completed state update's trip through the update pipeline, in
+   * the units exposed by getConvergenceTraces() (wall-clock enqueue
+   * time in msec since epoch, stage durations in usec).
+   */
+  struct ConvergenceTraceRecord {
+    std::string name;
+    int64_t enqueuedMsec{0};
+    int64_t queueUsec{0};
+    int64_t applyUsec{0};
+    int64_t hwUsec{0};
+    int64_t totalUsec{0};
+  };
+
+  /*
+   * Return up to numTraces of the recently completed state updates,
+   * slowest (by total enqueue-to-hardware latency) first. numTraces <= 0
+   * returns the whole retained history (--convergence_trace_history).
+   */
+  std::vector<ConvergenceTraceRecord> getConvergenceTraces(
+      int32_t numTraces) const;
+
+  /*
+   * Write a compact binary OperStateSnapshot of the requested subtrees
+   * ("ports", "neighbors", "routes" or "routes:<vrf>", comma separated)
+   * to outFile. Backs the dumpOperState() Thrift call; throws
+   * FbossError on an unknown subtree or a write failure. Works off one
+   * SwitchState snapshot, so it never blocks the update thread.
+   */
+  void dumpOperState(const std::string& subtrees, const std::string& outFile);
+
+  /*
+   * Mark the calling thread as part of the packet path (rx, update and
+   * background threads).
+   *
+   * The Thrift handler uses isPacketPathThread() as a guardrail: Thrift
+   * work should run on the server's own worker pool, and a handler call
+   * that executes on a marked thread is counted and logged so we notice
+   * before big dumps start distorting slow-path latency.
+   */
+  static void markPacketPathThread();
+  static bool isPacketPathThread();
+
+  /*
+   * Apply the CPU affinity and scheduling class configured for the
+   * calling thread via --thread_cpu_sets / --fifo_threads, and export
+   * the resulting placement as thread.<name>.* counters. Called on the
+   * thread itself right after it is named, from threadLoop() and from
+   * the rx dispatch threads.
+   */
+  static void applyThreadScheduling(folly::StringPiece name);
+
   /*
    * Get the LldpManager object
    */
@@ -506,6 +767,50 @@ class SwSwitch : public HwSwitch::Callback {
     return routeUpdateLogger_.get();
   }
 
+  /*
+   * Get the derived per-VLAN DHCP relay table
+   */
+  DhcpRelayTable* getDhcpRelayTable() {
+    return dhcpRelayTable_.get();
+  }
+
+  /*
+   * Get the DHCP relay transaction cache
+   */
+  DhcpTransactionCache* getDhcpTransactionCache() {
+    return dhcpTransactionCache_.get();
+  }
+
+  /*
+   * Get the derived per-port packet send context table
+   */
+  PortSendContextTable* getPortSendContextTable() {
+    return portSendContextTable_.get();
+  }
+
+  /*
+   * Get the derived control plane flow demux table
+   */
+  HostDemuxTable* getHostDemuxTable() {
+    return hostDemuxTable_.get();
+  }
+
+  /*
+   * Get the hash index over all vlans' neighbor response entries
+   */
+  NeighborResponseIndex* getNeighborResponseIndex() {
+    return neighborResponseIndex_.get();
+  }
+
+  /*
+   * Get the rate limiter for slow-path generated ICMP error responses.
+   * Shared by the IPv4 and IPv6 handlers so per-source and global
+   * budgets are enforced across both protocols.
+   */
+  IcmpErrorRateLimiter* getIcmpErrorRateLimiter() {
+    return icmpErrorRateLimiter_.get();
+  }
+
   /*
    * Gets the flags the SwSwitch was initialized with.
    */
@@ -549,6 +854,19 @@ class SwSwitch : public HwSwitch::Callback {
   void invokeNeighborListener(const std::vector<std::string>& added,
                                const std::vector<std::string>& deleted);
 
+  /*
+   * Set the callback for receiving batched neighbor entry deltas
+   * (add/change/remove events), as collected by NeighborUpdater.
+   *
+   * Like the neighbor listener above, only one delta listener is
+   * supported and calling this multiple times overwrites it.
+   */
+  void registerNeighborEntryDeltaListener(
+      std::function<void(const std::vector<NeighborEntryDelta>&)> callback);
+
+  void invokeNeighborEntryDeltaListener(
+      const std::vector<NeighborEntryDelta>& deltas);
+
   /*
    * Returns true if the arp/ndp entry for the passed in ip has been hit.
    */
@@ -570,20 +888,104 @@ class SwSwitch : public HwSwitch::Callback {
    */
   void setStateInternal(std::shared_ptr<SwitchState> newState);
 
+  /*
+   * Try to satisfy an initial config apply from the compiled config
+   * cache.  Returns true if the cached state was applied; false means
+   * the caller should fall back to a full config apply.
+   */
+  bool applyCompiledConfigCache(const std::string& reason);
+  // Persist the config-derived SwitchState for reuse on the next start.
+  void saveCompiledConfigCache();
+
   void publishInitTimes(std::string name, const float& time);
   void publishPortInfo();
   void publishRouteStats();
+  void publishSwitchStateStats();
+  void publishMemoryStats();
+  /*
+   * Save a compact binary snapshot of all route tables to
+   * FLAGS_fib_snapshot_file (no-op when the flag is empty).
+   */
+  void saveFibSnapshot();
+  /*
+   * On warm boot, read routes from the last saved FIB snapshot into a
+   * RouteUpdater and apply them, so hardware is programmed with a
+   * near-correct table while the route server is still replaying; the
+   * first live sync then reconciles any differences.
+   */
+  void preloadFib();
+  /*
+   * Save a compact binary snapshot of the resolved ARP/NDP entries to
+   * FLAGS_neighbor_snapshot_file (no-op when the flag is empty).
+   */
+  void saveNeighborSnapshot();
+  /*
+   * On warm boot, restore the neighbor caches from the last saved
+   * snapshot. The entries come back STALE and get revalidated on the
+   * caches' paced timers, instead of every neighbor being re-probed at
+   * once after the restart.
+   */
+  void preloadNeighbors();
+  /*
+   * Open the always-on update journal (FLAGS_update_journal_file) and,
+   * when it holds records newer than the preloaded FIB snapshot - i.e.
+   * the previous run ended in a crash rather than a graceful exit -
+   * replay those records over the snapshot.  Together with preloadFib()
+   * this brings crash-restart FIB recovery close to warm boot speed.
+   */
+  void replayUpdateJournal();
   void publishSwitchInfo(struct HwInitResult hwInitRet);
   SwitchRunState getSwitchRunState() const;
   void setSwitchRunState(SwitchRunState desiredState);
   SwitchStats* createSwitchStats();
   void handlePacket(std::unique_ptr<RxPacket> pkt);
 
+  /*
+   * Per-ethertype handlers invoked through ethertypeDispatch_. The
+   * table is built at compile time from the registry in SwSwitch.cpp,
+   * so handlePacket() demuxes with a single table lookup no matter how
+   * many ethertypes are registered.
+   */
+  typedef void (SwSwitch::*EthertypeHandler)(std::unique_ptr<RxPacket> pkt,
+                                             folly::MacAddress dst,
+                                             folly::MacAddress src,
+                                             folly::io::Cursor cursor);
+  typedef DispatchTable<uint16_t, EthertypeHandler, 8> EthertypeDispatch;
+  static const EthertypeDispatch ethertypeDispatch_;
+
+  void handleArpPacket(std::unique_ptr<RxPacket> pkt,
+                       folly::MacAddress dst,
+                       folly::MacAddress src,
+                       folly::io::Cursor cursor);
+  void handleLldpPacket(std::unique_ptr<RxPacket> pkt,
+                        folly::MacAddress dst,
+                        folly::MacAddress src,
+                        folly::io::Cursor cursor);
+  void handleIPv4Packet(std::unique_ptr<RxPacket> pkt,
+                        folly::MacAddress dst,
+                        folly::MacAddress src,
+                        folly::io::Cursor cursor);
+  void handleIPv6Packet(std::unique_ptr<RxPacket> pkt,
+                        folly::MacAddress dst,
+                        folly::MacAddress src,
+                        folly::io::Cursor cursor);
+
+  // Shared implementation of sendL3Packet()/sendL3Packets(), working
+  // against a caller-provided state snapshot
+  void sendL3PacketImpl(
+      const std::shared_ptr<SwitchState>& state,
+      std::unique_ptr<TxPacket> pkt,
+      folly::Optional<InterfaceID> ifID) noexcept;
+
   static void handlePendingUpdatesHelper(SwSwitch* sw);
   void handlePendingUpdates();
   void applyUpdate(const std::shared_ptr<SwitchState>& oldState,
                    const std::shared_ptr<SwitchState>& newState);
 
+  // Start the shared-memory counter export configured by
+  // --highres_shm_export, if any of its counters are valid.
+  void startHighresShmExport();
+
   void startThreads();
   void stopThreads();
   void stop();
@@ -595,7 +997,8 @@ class SwSwitch : public HwSwitch::Callback {
    * called from the update thread, if the update thread is running.
    */
   bool stateObserverRegistered(StateObserver* observer);
-  void addStateObserver(StateObserver* observer, const std::string& name);
+  void addStateObserver(StateObserver* observer, const std::string& name,
+                        uint32_t interests);
   void removeStateObserver(StateObserver* observer);
 
   /*
@@ -613,6 +1016,18 @@ class SwSwitch : public HwSwitch::Callback {
   // Sets the counter that tracks port status
   void setPortStatusCounter(PortID port, bool up);
 
+  // Bumps the per-port counter that tracks link flaps
+  void setPortFlapCounter(PortID port);
+
+  // Applies all link state changes that were coalesced during the
+  // debounce interval as a single SwitchState update
+  void flushPendingLinkStateChanges();
+
+  // Turn a completed update's trace stamps into stage durations, feed
+  // them to the convergence histograms, and retain the trace for
+  // getConvergenceTraces()
+  void recordConvergenceTrace(const StateUpdate& update);
+
   std::string curConfigStr_;
   cfg::SwitchConfig curConfig_;
 
@@ -620,6 +1035,13 @@ class SwSwitch : public HwSwitch::Callback {
   HwSwitch* hw_;
   std::unique_ptr<Platform> platform_;
   std::atomic<SwitchRunState> runState_{SwitchRunState::UNINITIALIZED};
+  // Set when preloadFib() applied a snapshot; cleared once the first
+  // live sync has reconciled against it
+  std::atomic<bool> fibPreloaded_{false};
+  // Recently completed update traces, oldest first, bounded by
+  // --convergence_trace_history
+  mutable std::mutex convergenceTracesLock_;
+  std::deque<ConvergenceTraceRecord> convergenceTraces_;
   folly::ThreadLocalPtr<SwitchStats, SwSwitch> stats_;
   /**
    * The object to sync the interfaces to the system. This pointer could
@@ -628,10 +1050,32 @@ class SwSwitch : public HwSwitch::Callback {
   std::unique_ptr<TunManager> tunMgr_;
 
   /*
-   * A list of pending state updates to be applied.
+   * Counter driving the 1-in-N sampling of rx packets for latency
+   * tracing. Incremented from the hardware rx callback threads.
    */
-  folly::SpinLock pendingUpdatesLock_;
-  StateUpdateList pendingUpdates_;
+  std::atomic<uint64_t> rxTraceCounter_{0};
+
+  /*
+   * A lock-free MPSC queue of pending state updates to be applied.
+   *
+   * Producer threads (Thrift handler, neighbor updater, link-scan) push
+   * concurrently without ever blocking each other; only the update thread
+   * drains the queue.
+   */
+  folly::AtomicIntrusiveLinkedList<StateUpdate, &StateUpdate::nextUpdate_>
+    pendingUpdates_;
+  /*
+   * Approximate depth of pendingUpdates_, maintained solely for exporting
+   * queueing delay stats.
+   */
+  std::atomic<int64_t> pendingUpdatesDepth_{0};
+
+  /*
+   * How many coalescable updates handlePendingUpdates() will apply against
+   * a single SwitchState clone.  Adapted to the queue backlog on every
+   * pass; only accessed from the update thread.
+   */
+  size_t updateCoalescingWindow_{1};
 
   /*
    * The current switch state.
@@ -653,6 +1097,15 @@ class SwSwitch : public HwSwitch::Callback {
   std::unique_ptr<std::thread> backgroundThread_;
   folly::EventBase backgroundEventBase_;
 
+  /*
+   * Additional background worker threads. Together with the background
+   * thread above they form the pool that pickBackgroundEVB() assigns
+   * deferrable work to.
+   */
+  std::vector<std::unique_ptr<std::thread>> bgWorkerThreads_;
+  std::vector<std::unique_ptr<folly::EventBase>> bgWorkerEventBases_;
+  std::vector<std::unique_ptr<ThreadHeartbeat>> bgWorkerHeartbeats_;
+
   /*
    * A thread for processing SwitchState updates.
    */
@@ -666,13 +1119,25 @@ class SwSwitch : public HwSwitch::Callback {
   std::function<void(const std::vector<std::string>& added,
                        const std::vector<std::string>& deleted)>
     neighborListener_{nullptr};
+  std::function<void(const std::vector<NeighborEntryDelta>&)>
+    neighborEntryDeltaListener_{nullptr};
+
+  struct ObserverInfo {
+    std::string name;
+    uint32_t interests{INTEREST_ALL};
+  };
 
   /*
-   * The list of classes to notify on a state update. This container should only
-   * be accessed/modified from the update thread. This removes the need for
-   * locking when we access the container during a state update.
+   * The list of classes to notify on a state update, along with the
+   * StateObserverInterests mask each one registered with. This container
+   * should only be accessed/modified from the update thread. This removes the
+   * need for locking when we access the container during a state update.
    */
-  std::map<StateObserver*, std::string> stateObservers_;
+  std::map<StateObserver*, ObserverInfo> stateObservers_;
+
+  // The central timer service for periodic work; declared before the
+  // components that register tasks with it so it outlives them.
+  std::unique_ptr<PeriodicScheduler> periodicScheduler_;
 
   std::unique_ptr<PortRemediator> portRemediator_;
 
@@ -681,9 +1146,49 @@ class SwSwitch : public HwSwitch::Callback {
   std::unique_ptr<IPv6Handler> ipv6_;
   std::unique_ptr<NeighborUpdater> nUpdater_;
   std::unique_ptr<PktCaptureManager> pcapMgr_;
+  std::unique_ptr<FlowSampler> flowSampler_;
+  std::unique_ptr<RxPacketDispatcher> rxDispatcher_;
   std::unique_ptr<RouteUpdateLogger> routeUpdateLogger_;
+  std::unique_ptr<RouteStatsTracker> routeStatsTracker_;
+  // Always-on journal of applied route changes; null unless
+  // --update_journal_file is set. Appended to from the update thread
+  // in applyUpdate(), replayed by replayUpdateJournal() on init.
+  std::unique_ptr<UpdateJournal> updateJournal_;
+  // The journal sequence number stored in the preloaded FIB snapshot;
+  // replayUpdateJournal() only replays records newer than this.
+  // Sequences start at 1, so 0 means "replay everything recovered".
+  int64_t fibSnapshotJournalSeq_{0};
+  std::unique_ptr<DhcpRelayTable> dhcpRelayTable_;
+  std::unique_ptr<DhcpTransactionCache> dhcpTransactionCache_;
+  std::unique_ptr<PortSendContextTable> portSendContextTable_;
+  std::unique_ptr<HostDemuxTable> hostDemuxTable_;
+  std::unique_ptr<NeighborResponseIndex> neighborResponseIndex_;
+  std::unique_ptr<HighresShmExporter> highresShmExporter_;
+
+  // Set while a background hardware counter collection pass is in
+  // flight; lets publishStats() coalesce instead of piling up passes
+  // behind a slow SDK counter walk.
+  std::atomic<bool> hwStatsCollectionInProgress_{false};
+  // When publishMemoryStats() last recomputed the per-subsystem memory
+  // breakdown; the recomputation walks the route tables, so it runs
+  // every --memory_stats_interval_secs rather than every stats tick.
+  std::chrono::steady_clock::time_point lastMemoryStatsWalk_;
+  std::unique_ptr<IcmpErrorRateLimiter> icmpErrorRateLimiter_;
   std::unique_ptr<UnresolvedNhopsProber> unresolvedNhopsProber_;
 
+  /*
+   * Link state changes waiting to be applied to the SwitchState.  Port
+   * up/down events are coalesced here for the debounce interval and
+   * applied as a single PortMap update, so a link storm produces one
+   * SwitchState clone per interval instead of one per transition.  The
+   * latest transition for a port wins.  linkFlapCounts_ tracks the
+   * per-port flap totals exported as "<port>.flaps".
+   */
+  std::mutex linkStateLock_;
+  std::map<PortID, bool> pendingLinkState_;
+  bool linkStateFlushScheduled_{false};
+  std::map<PortID, uint64_t> linkFlapCounts_;
+
   BootType bootType_{BootType::UNINITIALIZED};
   std::unique_ptr<LldpManager> lldpManager_;
   std::unique_ptr<ThreadHeartbeat> bgThreadHeartbeat_;
@@ -27,7 +27,8 @@ SwitchStats::SwitchStats()
 }
 
 SwitchStats::SwitchStats(ThreadLocalStatsMap *map)
-    : trapPkts_(map, kCounterPrefix + "trapped.pkts", SUM, RATE),
+    : statsMap_(map),
+      trapPkts_(map, kCounterPrefix + "trapped.pkts", SUM, RATE),
       trapPktDrops_(map, kCounterPrefix + "trapped.drops", SUM, RATE),
       trapPktBogus_(map, kCounterPrefix + "trapped.bogus", SUM, RATE),
       trapPktErrors_(map, kCounterPrefix + "trapped.error", SUM, RATE),
@@ -36,6 +37,21 @@ SwitchStats::SwitchStats(ThreadLocalStatsMap *map)
       trapPktToHostBytes_(map, kCounterPrefix + "host.rx.bytes", SUM, RATE),
       pktFromHost_(map, kCounterPrefix + "host.tx", SUM, RATE),
       pktFromHostBytes_(map, kCounterPrefix + "host.tx.bytes", SUM, RATE),
+      trapPktCopied_(map, kCounterPrefix + "trapped.copied", SUM, RATE),
+      trapPktCopiedBytes_(map, kCounterPrefix + "trapped.copied.bytes",
+          SUM, RATE),
+      rxRingDropsProtocol_(map, kCounterPrefix + "rx_ring.protocol.drops",
+          SUM, RATE),
+      rxRingDropsNeighbor_(map, kCounterPrefix + "rx_ring.neighbor.drops",
+          SUM, RATE),
+      rxRingDropsOther_(map, kCounterPrefix + "rx_ring.other.drops",
+          SUM, RATE),
+      tunTxRingDrops_(map, kCounterPrefix + "tun.tx_ring.drops",
+          SUM, RATE),
+      flowSamples_(map, kCounterPrefix + "flow_sampler.samples", SUM, RATE),
+      flowSampleDrops_(map, kCounterPrefix + "flow_sampler.drops", SUM, RATE),
+      thriftOnPacketThread_(map, kCounterPrefix + "thrift.on_packet_thread",
+          SUM, RATE),
       trapPktArp_(map, kCounterPrefix + "trapped.arp", SUM, RATE),
       arpUnsupported_(map, kCounterPrefix + "arp.unsupported", SUM, RATE),
       arpNotMine_(map, kCounterPrefix + "arp.not_mine", SUM, RATE),
@@ -44,8 +60,14 @@ SwitchStats::SwitchStats(ThreadLocalStatsMap *map)
       arpRequestsTx_(map, kCounterPrefix + "arp.request.tx", SUM, RATE),
       arpRepliesTx_(map, kCounterPrefix + "arp.reply.tx", SUM, RATE),
       arpBadOp_(map, kCounterPrefix + "arp.bad_op", SUM, RATE),
+      arpRequestsSuppressed_(map, kCounterPrefix + "arp.request.suppressed",
+          SUM, RATE),
       trapPktNdp_(map, kCounterPrefix + "trapped.ndp", SUM, RATE),
       ipv6NdpBad_(map, kCounterPrefix + "ipv6.ndp.bad", SUM, RATE),
+      ipv6NdpSolicitsSuppressed_(map,
+          kCounterPrefix + "ipv6.ndp.solicit.suppressed", SUM, RATE),
+      pendingNeighborPktDrops_(map,
+          kCounterPrefix + "neighbor.pending_pkt.drops", SUM, RATE),
       ipv4Rx_(map, kCounterPrefix + "trapped.ipv4", SUM, RATE),
       ipv4TooSmall_(map, kCounterPrefix + "ipv4.too_small", SUM, RATE),
       ipv4WrongVer_(map, kCounterPrefix + "ipv4.wrong_version", SUM, RATE),
@@ -54,6 +76,8 @@ SwitchStats::SwitchStats(ThreadLocalStatsMap *map)
       ipv4NoArp_(map, kCounterPrefix + "ipv4.no_arp", SUM, RATE),
       ipv4TtlExceeded_(map, kCounterPrefix + "ipv4.ttl_exceeded", SUM, RATE),
       ipv6HopExceeded_(map, kCounterPrefix + "ipv6.hop_exceeded", SUM, RATE),
+      icmpErrorsSuppressed_(map, kCounterPrefix + "icmp.error.suppressed",
+          SUM, RATE),
       udpTooSmall_(map, kCounterPrefix + "udp.too_small", SUM, RATE),
       dhcpV4Pkt_(map, kCounterPrefix + "dhcpV4.pkt", SUM, RATE),
       dhcpV4BadPkt_(map, kCounterPrefix + "dhcpV4.bad_pkt", SUM, RATE),
@@ -72,7 +96,13 @@ SwitchStats::SwitchStats(ThreadLocalStatsMap *map)
       dstLookupFailure_(map, kCounterPrefix + "ip.dst_lookup_failure",
           SUM, RATE),
       updateState_(map, kCounterPrefix + "state_update.us", 50000, 0, 1000000),
+      updateStateBatchSize_(map, kCounterPrefix + "state_update.batch_size",
+                            1, 0, 1000, AVG, 50, 100),
+      updateStateBatchUs_(map, kCounterPrefix + "state_update.batch_us",
+                          50000, 0, 1000000),
       routeUpdate_(map,  kCounterPrefix + "route_update.us", 50, 0, 500),
+      thriftUpdateLatency_(map, kCounterPrefix + "thrift.update_latency.us",
+                           50000, 0, 1000000),
 
       bgHeartbeatDelay_(map, kCounterPrefix + "bg_heartbeat_delay.ms",
                         100, 0, 20000, AVG, 50, 100),
@@ -82,11 +112,42 @@ SwitchStats::SwitchStats(ThreadLocalStatsMap *map)
                       1, 0, 200, AVG, 50, 100),
       updEventBacklog_(map, kCounterPrefix + "upd_event_backlog",
                        1, 0, 200, AVG, 50, 100),
+      updateQueueDepth_(map, kCounterPrefix + "update_queue_depth",
+                        1, 0, 200, AVG, 50, 100),
+      updateQueueUrgentUs_(map, kCounterPrefix + "state_update.queue_us.urgent",
+                           50000, 0, 1000000),
+      updateQueueNormalUs_(map, kCounterPrefix + "state_update.queue_us.normal",
+                           50000, 0, 1000000),
+      updateQueueBulkUs_(map, kCounterPrefix + "state_update.queue_us.bulk",
+                         50000, 0, 1000000),
+      coalescingWindow_(map, kCounterPrefix + "state_update.coalescing_window",
+                        1, 0, 1000, AVG, 50, 100),
+      rxTraceArrivalUs_(map, kCounterPrefix + "rx_trace.arrival_us",
+                        100, 0, 100000),
+      rxTraceQueueUs_(map, kCounterPrefix + "rx_trace.queue_us",
+                      100, 0, 100000),
+      rxTraceClassifyUs_(map, kCounterPrefix + "rx_trace.classify_us",
+                         100, 0, 100000),
+      rxTraceHandlerUs_(map, kCounterPrefix + "rx_trace.handler_us",
+                        100, 0, 100000),
+      convergenceQueueUs_(map, kCounterPrefix + "convergence.queue_us",
+                          50000, 0, 1000000),
+      convergenceApplyUs_(map, kCounterPrefix + "convergence.apply_us",
+                          50000, 0, 1000000),
+      convergenceHwUs_(map, kCounterPrefix + "convergence.hw_us",
+                       50000, 0, 1000000),
+      convergenceTotalUs_(map, kCounterPrefix + "convergence.total_us",
+                          50000, 0, 1000000),
+
+      periodicTaskRunUs_(map, kCounterPrefix + "periodic_task.run_us",
+                         50000, 0, 1000000),
+      periodicTaskDeferrals_(map, kCounterPrefix + "periodic_task.deferrals",
+                             SUM),
 
       linkStateChange_(map, kCounterPrefix + "link_state.down", SUM) {
 }
 
-PortStats* SwitchStats::port(PortID portID) {
+PortStats* SwitchStats::portSlowPath(PortID portID) {
   auto it = ports_.find(portID);
   if (it != ports_.end()) {
     return it->second.get();
@@ -98,7 +159,71 @@ PortStats* SwitchStats::createPortStats(PortID portID) {
   auto rv = ports_.emplace(portID, std::make_unique<PortStats>(portID, this));
   const auto& it = rv.first;
   DCHECK(rv.second);
-  return it->second.get();
+  auto* stats = it->second.get();
+
+  // Register the new object in the flat index used by the port() fast
+  // path
+  auto idx = static_cast<size_t>(portID);
+  if (idx < kMaxIndexedPorts) {
+    if (portStatsIndex_.size() <= idx) {
+      portStatsIndex_.resize(idx + 1, nullptr);
+    }
+    portStatsIndex_[idx] = stats;
+  }
+  return stats;
+}
+
+InterfaceStats* SwitchStats::intfSlowPath(InterfaceID intfID) {
+  auto it = intfs_.find(intfID);
+  if (it != intfs_.end()) {
+    return it->second.get();
+  }
+  return createIntfStats(intfID);
+}
+
+InterfaceStats* SwitchStats::createIntfStats(InterfaceID intfID) {
+  auto rv = intfs_.emplace(
+      intfID, std::make_unique<InterfaceStats>(statsMap_, intfID));
+  const auto& it = rv.first;
+  DCHECK(rv.second);
+  auto* stats = it->second.get();
+
+  // Register the new object in the flat index used by the intf() fast
+  // path
+  auto idx = static_cast<size_t>(intfID);
+  if (idx < kMaxIndexedIntfs) {
+    if (intfStatsIndex_.size() <= idx) {
+      intfStatsIndex_.resize(idx + 1, nullptr);
+    }
+    intfStatsIndex_[idx] = stats;
+  }
+  return stats;
+}
+
+#ifdef FBOSS_HOT_STATS_CACHELINE
+void SwitchStats::flushHotCounters() {
+  if (hot_.trappedPkts) {
+    trapPkts_.addValue(hot_.trappedPkts);
+    hot_.trappedPkts = 0;
+  }
+  if (hot_.pktDrops) {
+    trapPktDrops_.addValue(hot_.pktDrops);
+    hot_.pktDrops = 0;
+  }
+  if (hot_.pktToHost) {
+    trapPktToHost_.addValue(hot_.pktToHost);
+    trapPktToHostBytes_.addValue(hot_.pktToHostBytes);
+    hot_.pktToHost = 0;
+    hot_.pktToHostBytes = 0;
+  }
+  if (hot_.pktFromHost) {
+    pktFromHost_.addValue(hot_.pktFromHost);
+    pktFromHostBytes_.addValue(hot_.pktFromHostBytes);
+    hot_.pktFromHost = 0;
+    hot_.pktFromHostBytes = 0;
+  }
+  hot_.sinceFlush = 0;
 }
+#endif
 
 }} // facebook::fboss
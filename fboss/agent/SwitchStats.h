@@ -10,10 +10,13 @@
 #pragma once
 
 #include <chrono>
+#include <vector>
 #include <boost/container/flat_map.hpp>
 #include <boost/noncopyable.hpp>
 #include "common/stats/ThreadCachedServiceData.h"
+#include "fboss/agent/InterfaceStats.h"
 #include "fboss/agent/PortStats.h"
+#include "fboss/agent/state/StateUpdate.h"
 #include "fboss/agent/types.h"
 
 namespace facebook { namespace fboss {
@@ -23,6 +26,9 @@ class PortStats;
 typedef boost::container::flat_map<PortID,
           std::unique_ptr<PortStats>> PortStatsMap;
 
+typedef boost::container::flat_map<InterfaceID,
+          std::unique_ptr<InterfaceStats>> IntfStatsMap;
+
 class SwitchStats : public boost::noncopyable {
  public:
   /*
@@ -31,11 +37,41 @@ class SwitchStats : public boost::noncopyable {
   static std::string kCounterPrefix;
 
   SwitchStats();
+#ifdef FBOSS_HOT_STATS_CACHELINE
+  ~SwitchStats() {
+    flushHotCounters();
+  }
+#endif
 
   /*
    * Return the PortStats object for the given PortID.
+   *
+   * The common case is a bounds-checked array index; the map lookup
+   * only runs the first time a port is seen, keeping hash/tree lookups
+   * out of the per-packet path.
+   */
+  PortStats* port(PortID portID) {
+    auto idx = static_cast<size_t>(portID);
+    if (idx < portStatsIndex_.size() && portStatsIndex_[idx] != nullptr) {
+      return portStatsIndex_[idx];
+    }
+    return portSlowPath(portID);
+  }
+
+  /*
+   * Return the InterfaceStats object for the given InterfaceID, for
+   * host-path (tun) accounting.  Same shape as port(): a
+   * bounds-checked array index in the common case, with the map
+   * lookup only on first use.  Callers on the packet path should
+   * cache the returned pointer per batch (see TunIntf).
    */
-  PortStats* port(PortID portID);
+  InterfaceStats* intf(InterfaceID intfID) {
+    auto idx = static_cast<size_t>(intfID);
+    if (idx < intfStatsIndex_.size() && intfStatsIndex_[idx] != nullptr) {
+      return intfStatsIndex_[idx];
+    }
+    return intfSlowPath(intfID);
+  }
 
   /*
    * Getters.
@@ -48,10 +84,20 @@ class SwitchStats : public boost::noncopyable {
   }
 
   void trappedPkt() {
+#ifdef FBOSS_HOT_STATS_CACHELINE
+    ++hot_.trappedPkts;
+    maybeFlushHotCounters();
+#else
     trapPkts_.addValue(1);
+#endif
   }
   void pktDropped() {
+#ifdef FBOSS_HOT_STATS_CACHELINE
+    ++hot_.pktDrops;
+    maybeFlushHotCounters();
+#else
     trapPktDrops_.addValue(1);
+#endif
   }
   void pktBogus() {
     trapPktBogus_.addValue(1);
@@ -66,12 +112,53 @@ class SwitchStats : public boost::noncopyable {
     trapPktDrops_.addValue(1);
   }
   void pktToHost(uint32_t bytes) {
+#ifdef FBOSS_HOT_STATS_CACHELINE
+    ++hot_.pktToHost;
+    hot_.pktToHostBytes += bytes;
+    maybeFlushHotCounters();
+#else
     trapPktToHost_.addValue(1);
     trapPktToHostBytes_.addValue(bytes);
+#endif
   }
   void pktFromHost(uint32_t bytes) {
+#ifdef FBOSS_HOT_STATS_CACHELINE
+    ++hot_.pktFromHost;
+    hot_.pktFromHostBytes += bytes;
+    maybeFlushHotCounters();
+#else
     pktFromHost_.addValue(1);
     pktFromHostBytes_.addValue(bytes);
+#endif
+  }
+  void rxPktCopied(uint32_t bytes) {
+    trapPktCopied_.addValue(1);
+    trapPktCopiedBytes_.addValue(bytes);
+  }
+  void rxRingDropProtocol() {
+    rxRingDropsProtocol_.addValue(1);
+    trapPktDrops_.addValue(1);
+  }
+  void rxRingDropNeighbor() {
+    rxRingDropsNeighbor_.addValue(1);
+    trapPktDrops_.addValue(1);
+  }
+  void rxRingDropOther() {
+    rxRingDropsOther_.addValue(1);
+    trapPktDrops_.addValue(1);
+  }
+  void tunTxRingDrop() {
+    tunTxRingDrops_.addValue(1);
+    trapPktDrops_.addValue(1);
+  }
+  void flowSample() {
+    flowSamples_.addValue(1);
+  }
+  void flowSampleDropped() {
+    flowSampleDrops_.addValue(1);
+  }
+  void thriftOnPacketThread() {
+    thriftOnPacketThread_.addValue(1);
   }
 
   void arpPkt() {
@@ -101,6 +188,9 @@ class SwitchStats : public boost::noncopyable {
     arpBadOp_.addValue(1);
     trapPktDrops_.addValue(1);
   }
+  void arpRequestSuppressed() {
+    arpRequestsSuppressed_.addValue(1);
+  }
 
   void ipv6NdpPkt() {
     trapPktNdp_.addValue(1);
@@ -109,6 +199,13 @@ class SwitchStats : public boost::noncopyable {
     ipv6NdpBad_.addValue(1);
     trapPktDrops_.addValue(1);
   }
+  void ipv6NdpSolicitSuppressed() {
+    ipv6NdpSolicitsSuppressed_.addValue(1);
+  }
+
+  void pendingNeighborPktDropped() {
+    pendingNeighborPktDrops_.addValue(1);
+  }
 
   void dhcpV4Pkt() {
     dhcpV4Pkt_.addValue(1);
@@ -144,6 +241,10 @@ class SwitchStats : public boost::noncopyable {
     ipv6HopExceeded_.addValue(1);
   }
 
+  void icmpErrorSuppressed() {
+    icmpErrorsSuppressed_.addValue(1);
+  }
+
   void udpTooSmall() {
     udpTooSmall_.addValue(1);
   }
@@ -197,6 +298,26 @@ class SwitchStats : public boost::noncopyable {
     updateState_.addValue(us.count());
   }
 
+  void stateUpdateBatch(size_t size, std::chrono::microseconds us) {
+    updateStateBatchSize_.addValue(size);
+    updateStateBatchUs_.addValue(us.count());
+  }
+
+  void stateUpdateQueueLatency(StateUpdate::Priority priority,
+                               std::chrono::microseconds us) {
+    switch (priority) {
+      case StateUpdate::Priority::URGENT:
+        updateQueueUrgentUs_.addValue(us.count());
+        break;
+      case StateUpdate::Priority::NORMAL:
+        updateQueueNormalUs_.addValue(us.count());
+        break;
+      case StateUpdate::Priority::BULK:
+        updateQueueBulkUs_.addValue(us.count());
+        break;
+    }
+  }
+
   void routeUpdate(std::chrono::microseconds us, uint64_t routes) {
     // As syncFib() could include no routes.
     if (routes == 0) {
@@ -205,6 +326,20 @@ class SwitchStats : public boost::noncopyable {
     routeUpdate_.addRepeatedValue(us.count() / routes, routes);
   }
 
+  void thriftUpdateDone(std::chrono::microseconds us) {
+    thriftUpdateLatency_.addValue(us.count());
+  }
+
+  void convergenceTrace(std::chrono::microseconds queueUs,
+                        std::chrono::microseconds applyUs,
+                        std::chrono::microseconds hwUs,
+                        std::chrono::microseconds totalUs) {
+    convergenceQueueUs_.addValue(queueUs.count());
+    convergenceApplyUs_.addValue(applyUs.count());
+    convergenceHwUs_.addValue(hwUs.count());
+    convergenceTotalUs_.addValue(totalUs.count());
+  }
+
   void bgHeartbeatDelay(int delay) {
     bgHeartbeatDelay_.addValue(delay);
   }
@@ -221,10 +356,47 @@ class SwitchStats : public boost::noncopyable {
     updEventBacklog_.addValue(value);
   }
 
+  void updateQueueDepth(int value) {
+    updateQueueDepth_.addValue(value);
+  }
+
+  void coalescingWindow(int value) {
+    coalescingWindow_.addValue(value);
+  }
+
+  void rxPktTrace(uint64_t queueUs, uint64_t classifyUs, uint64_t handlerUs) {
+    rxTraceQueueUs_.addValue(queueUs);
+    rxTraceClassifyUs_.addValue(classifyUs);
+    rxTraceHandlerUs_.addValue(handlerUs);
+  }
+
+  void rxPktTraceArrival(uint64_t arrivalUs) {
+    rxTraceArrivalUs_.addValue(arrivalUs);
+  }
+
   void linkStateChange() {
     linkStateChange_.addValue(1);
   }
 
+  void periodicTaskRun(std::chrono::microseconds runUs) {
+    periodicTaskRunUs_.addValue(runUs.count());
+  }
+
+  void periodicTaskDeferred() {
+    periodicTaskDeferrals_.addValue(1);
+  }
+
+#ifdef FBOSS_HOT_STATS_CACHELINE
+  /*
+   * Fold the accumulated hot counter slots into the underlying
+   * thread local timeseries, walking the slots sequentially. Called
+   * automatically every kHotFlushInterval hot events and on
+   * destruction; may also be called by a periodic publisher to bound
+   * counter staleness.
+   */
+  void flushHotCounters();
+#endif
+
  private:
   // Forbidden copy constructor and assignment operator
   SwitchStats(SwitchStats const &) = delete;
@@ -237,6 +409,10 @@ class SwitchStats : public boost::noncopyable {
 
   explicit SwitchStats(ThreadLocalStatsMap *map);
 
+  // The stats map we were created against, kept so that per-object
+  // stat blocks (PortStats, InterfaceStats) can be created lazily.
+  ThreadLocalStatsMap* statsMap_{nullptr};
+
   // Total number of trapped packets
   TLTimeseries trapPkts_;
   // Number of trapped packets that were intentionally dropped.
@@ -256,6 +432,28 @@ class SwitchStats : public boost::noncopyable {
   TLTimeseries pktFromHost_;
   // Packets sent by host in bytes
   TLTimeseries pktFromHostBytes_;
+  // Trapped packets whose payload was copied out of the rx buffer rather
+  // than consumed in place. The rx pipeline is meant to be zero-copy, so
+  // this counter flags the paths that still copy.
+  TLTimeseries trapPktCopied_;
+  // Bytes copied out of rx buffers
+  TLTimeseries trapPktCopiedBytes_;
+  // Trapped packets dropped because their rx dispatch ring was full,
+  // per packet class
+  TLTimeseries rxRingDropsProtocol_;
+  TLTimeseries rxRingDropsNeighbor_;
+  TLTimeseries rxRingDropsOther_;
+  // Packets towards the host dropped because a tun interface's tx ring
+  // was full
+  TLTimeseries tunTxRingDrops_;
+  // Hardware-sampled packets aggregated by the flow sampler, and
+  // samples dropped because they were unparseable or the flow cache
+  // was full
+  TLTimeseries flowSamples_;
+  TLTimeseries flowSampleDrops_;
+  // Thrift handler calls that ran on a packet path thread, where a big
+  // dump can distort slow-path latency
+  TLTimeseries thriftOnPacketThread_;
 
   // ARP Packets
   TLTimeseries trapPktArp_;
@@ -273,10 +471,19 @@ class SwitchStats : public boost::noncopyable {
   TLTimeseries arpRepliesTx_;
   // ARP packets with an unknown op field
   TLTimeseries arpBadOp_;
+  // ARP requests not sent because one was already in flight
+  TLTimeseries arpRequestsSuppressed_;
 
   // IPv6 Neighbor Discovery Protocol packets
   TLTimeseries trapPktNdp_;
   TLTimeseries ipv6NdpBad_;
+  // Neighbor solicitations not sent because one was already in flight
+  TLTimeseries ipv6NdpSolicitsSuppressed_;
+
+  // Packets queued for an unresolved neighbor that we had to drop,
+  // either because the per-neighbor queue was full or because the
+  // neighbor never resolved
+  TLTimeseries pendingNeighborPktDrops_;
 
   // IPv4 Packets
   TLTimeseries ipv4Rx_;
@@ -296,6 +503,9 @@ class SwitchStats : public boost::noncopyable {
   // IPv6 hop count exceeded
   TLTimeseries ipv6HopExceeded_;
 
+  // ICMP error responses suppressed by the slow-path rate limiter
+  TLTimeseries icmpErrorsSuppressed_;
+
   // UDP packets dropped due to smaller packet size
   TLTimeseries udpTooSmall_;
 
@@ -335,11 +545,30 @@ class SwitchStats : public boost::noncopyable {
    */
   TLHistogram updateState_;
 
+  /**
+   * Histogram for number of updates coalesced into a single
+   * handlePendingUpdates() batch
+   */
+  TLHistogram updateStateBatchSize_;
+
+  /**
+   * Histogram for time used to process a coalesced update batch (in
+   * microsecond)
+   */
+  TLHistogram updateStateBatchUs_;
+
   /**
    * Histogram for time used for route update (in microsecond)
    */
   TLHistogram routeUpdate_;
 
+  /**
+   * Histogram for end-to-end latency of Thrift-initiated state updates,
+   * from the call being accepted to the update being applied (in
+   * microsecond)
+   */
+  TLHistogram thriftUpdateLatency_;
+
   /**
    * Background thread heartbeat delay (ms)
    */
@@ -360,6 +589,61 @@ class SwitchStats : public boost::noncopyable {
    */
   TLHistogram updEventBacklog_;
 
+  /**
+   * Depth of the pending state update queue, sampled at enqueue time
+   */
+  TLHistogram updateQueueDepth_;
+
+  /**
+   * Time a state update spent queued before the update thread picked it
+   * up (in microsecond), broken out by scheduling class. The urgent
+   * histogram is the one to alert on: it bounds how long a
+   * fix-the-dataplane update waited behind other work.
+   */
+  TLHistogram updateQueueUrgentUs_;
+  TLHistogram updateQueueNormalUs_;
+  TLHistogram updateQueueBulkUs_;
+
+  /**
+   * Current adaptive coalescing window of the state update thread, sampled
+   * on every handlePendingUpdates() pass
+   */
+  TLHistogram coalescingWindow_;
+
+  /**
+   * Per-stage slow-path latency of sampled rx packets (in microsecond):
+   * time queued before classification, classification/parse time, and
+   * protocol handler time up to tx/host forward. See the tracing
+   * comments in RxPacket.h. The arrival stage covers the packet's
+   * arrival stamp in the SDK rx callback up to the dispatch stamp, and
+   * is only recorded for packets that carry an arrival stamp.
+   */
+  TLHistogram rxTraceArrivalUs_;
+  TLHistogram rxTraceQueueUs_;
+  TLHistogram rxTraceClassifyUs_;
+  TLHistogram rxTraceHandlerUs_;
+
+  /**
+   * Per-stage convergence latency of state updates (in microsecond):
+   * time queued before the update thread picked the update up, update
+   * function and batch preparation time, hardware programming time,
+   * and the end-to-end enqueue-to-hardware total. See the tracing
+   * comments in StateUpdate.h.
+   */
+  TLHistogram convergenceQueueUs_;
+  TLHistogram convergenceApplyUs_;
+  TLHistogram convergenceHwUs_;
+  TLHistogram convergenceTotalUs_;
+
+  /**
+   * Runtime of the periodic tasks run by the PeriodicScheduler, and
+   * how often a tick's time budget forced a low tier task to be
+   * deferred to a later tick.  A growing deferral rate means some
+   * periodic work is overrunning --periodic_tick_budget_ms.
+   */
+  TLHistogram periodicTaskRunUs_;
+  TLTimeseries periodicTaskDeferrals_;
+
   /**
    * Link state up/down change count
    */
@@ -368,8 +652,70 @@ class SwitchStats : public boost::noncopyable {
   // Create a PortStats object for the given PortID
   PortStats* createPortStats(PortID portID);
 
+  // Map lookup half of port(), for ports not (yet) in the flat index
+  PortStats* portSlowPath(PortID portID);
+
   // Individual port stats objects, indexed by PortID
   PortStatsMap ports_;
+
+  // Cap on the size of the flat per-port index below; port IDs at or
+  // above this (not expected in practice) fall back to the map lookup.
+  static constexpr size_t kMaxIndexedPorts = 1024;
+
+  // Flat index over ports_ for the port() fast path. SwitchStats is
+  // thread local, so no synchronization is needed here.
+  std::vector<PortStats*> portStatsIndex_;
+
+  // Create an InterfaceStats object for the given InterfaceID
+  InterfaceStats* createIntfStats(InterfaceID intfID);
+
+  // Map lookup half of intf(), for interfaces not (yet) in the flat index
+  InterfaceStats* intfSlowPath(InterfaceID intfID);
+
+  // Individual interface stats objects, indexed by InterfaceID
+  IntfStatsMap intfs_;
+
+  // Cap on the size of the flat per-interface index below.  Interface
+  // IDs run higher than port IDs (they often encode the VLAN), so the
+  // cap is wider; IDs at or above it fall back to the map lookup.
+  static constexpr size_t kMaxIndexedIntfs = 4096;
+
+  // Flat index over intfs_ for the intf() fast path. SwitchStats is
+  // thread local, so no synchronization is needed here.
+  std::vector<InterfaceStats*> intfStatsIndex_;
+
+#ifdef FBOSS_HOT_STATS_CACHELINE
+  /*
+   * The hot packet path counters, pinned into a single cacheline per
+   * thread (SwitchStats is thread local). The packet path pays one
+   * plain increment on a line that is never shared between threads or
+   * sockets; the slots are folded into the regular timeseries in
+   * batches by flushHotCounters(). Enabled by the
+   * WITH_HOT_STATS_CACHELINE build option.
+   */
+  struct HotCounters {
+    uint64_t trappedPkts{0};
+    uint64_t pktDrops{0};
+    uint64_t pktToHost{0};
+    uint64_t pktToHostBytes{0};
+    uint64_t pktFromHost{0};
+    uint64_t pktFromHostBytes{0};
+    // Hot events since the last flush
+    uint64_t sinceFlush{0};
+  };
+  static constexpr uint64_t kHotFlushInterval = 64;
+  static constexpr size_t kCachelineSize = 64;
+  static_assert(sizeof(HotCounters) <= kCachelineSize,
+                "hot counters must fit in one cacheline");
+
+  void maybeFlushHotCounters() {
+    if (++hot_.sinceFlush >= kHotFlushInterval) {
+      flushHotCounters();
+    }
+  }
+
+  alignas(kCachelineSize) HotCounters hot_;
+#endif
 };
 
 }} // facebook::fboss
@@ -10,25 +10,113 @@
 // Copyright 2014-present Facebook. All Rights Reserved.
 #include "fboss/agent/ThreadHeartbeat.h"
 
+#include <folly/ThreadName.h>
+
+#include <algorithm>
+
 using namespace std::chrono;
 
 namespace facebook { namespace fboss {
 
-void ThreadHeartbeat::timeoutExpired() noexcept {
-  CHECK(evb_->inRunningEventBaseThread());
-  auto now = system_clock::now();
-  auto elapsed = duration_cast<milliseconds>(now - lastTime_);
-  auto delay = elapsed - intervalMsecs_;
-  auto evbQueueSize = evb_->getNotificationQueueSize();
-  heartbeatStatsFunc_(delay.count(), evbQueueSize);
-  if (delay.count() > delayThresholdMsecs_ ||
-      evbQueueSize > backlogThreshold_) {
-    VLOG(2) << threadName_ << ": heartbeat elapsed ms:" << elapsed.count()
-            << " delay ms:" << delay.count() << " event queue size:"
-            << evbQueueSize;
+ThreadHeartbeat::ThreadHeartbeat(
+    folly::EventBase* evb, std::string threadName, int intervalMsecs,
+    std::function<void(int, int)> heartbeatStatsFunc)
+    : evb_(evb),
+      threadName_(threadName),
+      intervalMsecs_(intervalMsecs),
+      heartbeatStatsFunc_(heartbeatStatsFunc) {
+  VLOG(2) << "ThreadHeartbeat intervalMsecs:" << intervalMsecs_.count();
+  lastIterationNsecs_.store(nowNsecs(), std::memory_order_relaxed);
+  evb_->runInEventBaseThread([this]() {
+      evb_->runBeforeLoop(this);
+    });
+  ThreadHeartbeatMonitor::instance()->add(this);
+}
+
+ThreadHeartbeat::~ThreadHeartbeat() {
+  // Stop the monitor from looking at us before tearing down the
+  // loop callback
+  ThreadHeartbeatMonitor::instance()->remove(this);
+  evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
+    [this]() {
+      cancelLoopCallback();
+    });
+}
+
+ThreadHeartbeatMonitor* ThreadHeartbeatMonitor::instance() {
+  static ThreadHeartbeatMonitor monitor;
+  return &monitor;
+}
+
+ThreadHeartbeatMonitor::~ThreadHeartbeatMonitor() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void ThreadHeartbeatMonitor::add(ThreadHeartbeat* heartbeat) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  heartbeats_.push_back(heartbeat);
+  scanInterval_ = std::min(scanInterval_, heartbeat->intervalMsecs_);
+  if (!running_) {
+    running_ = true;
+    thread_ = std::thread([this] { monitorLoop(); });
+  }
+  cv_.notify_all();
+}
+
+void ThreadHeartbeatMonitor::remove(ThreadHeartbeat* heartbeat) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  heartbeats_.erase(
+      std::remove(heartbeats_.begin(), heartbeats_.end(), heartbeat),
+      heartbeats_.end());
+}
+
+void ThreadHeartbeatMonitor::monitorLoop() {
+  folly::setThreadName(pthread_self(), "fbossHbMonitor");
+  std::unique_lock<std::mutex> guard(mutex_);
+  while (!stop_) {
+    cv_.wait_for(guard, scanInterval_);
+    if (stop_) {
+      break;
+    }
+    scanHeartbeats();
+  }
+}
+
+void ThreadHeartbeatMonitor::scanHeartbeats() {
+  // Called with mutex_ held, so heartbeats can't unregister from
+  // under us mid-scan
+  auto now = ThreadHeartbeat::nowNsecs();
+  for (auto hb : heartbeats_) {
+    auto last = hb->lastIterationNsecs_.load(std::memory_order_relaxed);
+    auto lagMsecs = static_cast<int64_t>(now - last) / 1000000;
+    // A loop iterating normally shows ~zero lag; report anything past
+    // the heartbeat interval as delay, matching the old active timer.
+    auto delay = std::max<int64_t>(0, lagMsecs - hb->intervalMsecs_.count());
+    auto evbQueueSize = hb->evb_->getNotificationQueueSize();
+    hb->heartbeatStatsFunc_(delay, evbQueueSize);
+    if (lagMsecs > hb->intervalMsecs_.count()) {
+      if (!hb->wakeupPending_.exchange(true, std::memory_order_relaxed)) {
+        // The loop may just be idle, parked in the event wait with no
+        // iterations to timestamp. Poke it once; the resulting
+        // iteration refreshes the timestamp and clears the flag.
+        hb->evb_->runInEventBaseThread([] {});
+      } else if (delay > hb->delayThresholdMsecs_ ||
+                 evbQueueSize > hb->backlogThreshold_) {
+        // Still no iteration after the poke: the loop is genuinely
+        // stuck or badly backlogged.
+        VLOG(2) << hb->threadName_ << ": heartbeat lag ms:" << lagMsecs
+                << " delay ms:" << delay << " event queue size:"
+                << evbQueueSize;
+      }
+    }
   }
-  lastTime_ = now;
-  scheduleTimeout(intervalMsecs_);
 }
 
 }} // facebook::fboss
@@ -9,57 +9,101 @@
  */
 // Copyright 2014-present Facebook. All Rights Reserved.
 #pragma once
-#include <folly/io/async/AsyncTimeout.h>
-#include <chrono>
 #include <folly/io/async/EventBase.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace facebook { namespace fboss {
 
-class ThreadHeartbeat : private folly::AsyncTimeout {
+class ThreadHeartbeatMonitor;
+
+class ThreadHeartbeat : private folly::EventBase::LoopCallback {
   /*
-   * Send heartbeat at regular interval to thread.  Measure delay between
-   * time we expect heartbeat to be processed vs. time actually processed,
-   * and record it to ods.
+   * Measure event-loop responsiveness of a thread, passively.
+   *
+   * The old design scheduled an AsyncTimeout through the very loop
+   * being monitored, so the measurement itself added timer and
+   * callback work to each monitored thread. Now every loop iteration
+   * just stores an atomic timestamp from a loop callback, and one
+   * shared monitor thread scans all heartbeats, computes the lag,
+   * records it to ods and flags stalls. An idle loop parked in the
+   * event wait is poked once by the monitor before being counted as
+   * stalled, so quiet threads don't raise false alarms.
    */
  public:
   ThreadHeartbeat(folly::EventBase* evb, std::string threadName,
                   int intervalMsecs,
-                  std::function<void(int, int)> heartbeatStatsFunc) :
-      AsyncTimeout(evb),
-      evb_(evb),
-      threadName_(threadName),
-      intervalMsecs_(intervalMsecs),
-      heartbeatStatsFunc_(heartbeatStatsFunc) {
-    VLOG(2) << "ThreadHeartbeat intervalMsecs:" << intervalMsecs_.count();
-    evb_->runInEventBaseThread([this]() {
-        scheduleFirstHeartbeat();
-      });
-  }
+                  std::function<void(int, int)> heartbeatStatsFunc);
 
-  ~ThreadHeartbeat() {
-    evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
-      [this]() {
-        cancelTimeout();
-      });
-  }
+  ~ThreadHeartbeat() override;
 
  private:
-  void timeoutExpired() noexcept override;
+  friend class ThreadHeartbeatMonitor;
+
+  void runLoopCallback() noexcept override {
+    lastIterationNsecs_.store(nowNsecs(), std::memory_order_relaxed);
+    wakeupPending_.store(false, std::memory_order_relaxed);
+    // Re-arm for the next loop iteration
+    evb_->runBeforeLoop(this);
+  }
 
-  void scheduleFirstHeartbeat() {
-    CHECK(evb_->inRunningEventBaseThread());
-    lastTime_ = std::chrono::system_clock::now();
-    scheduleTimeout(intervalMsecs_);
+  static uint64_t nowNsecs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
   }
 
   folly::EventBase* evb_;
   std::string threadName_;
   std::chrono::milliseconds intervalMsecs_;
   std::function<void(int, int)> heartbeatStatsFunc_;
-  std::chrono::time_point<std::chrono::system_clock> lastTime_;
+  // Timestamp of the monitored loop's last iteration, written by the
+  // monitored thread and read by the monitor thread
+  std::atomic<uint64_t> lastIterationNsecs_{0};
+  // Set by the monitor after poking an idle loop; cleared by the next
+  // loop iteration. A heartbeat is only counted as stalled while this
+  // is still pending.
+  std::atomic<bool> wakeupPending_{false};
   //XXX: these thresholds could be made configurable if needed
   int delayThresholdMsecs_ = 1000;
   int backlogThreshold_ = 10;
 };
 
+/*
+ * The single monitor thread shared by all ThreadHeartbeat objects. It
+ * wakes up at the smallest registered heartbeat interval, scans every
+ * heartbeat slot and reports per-thread lag and event-queue backlog.
+ */
+class ThreadHeartbeatMonitor {
+ public:
+  static ThreadHeartbeatMonitor* instance();
+
+  void add(ThreadHeartbeat* heartbeat);
+  void remove(ThreadHeartbeat* heartbeat);
+
+ private:
+  ThreadHeartbeatMonitor() {}
+  ~ThreadHeartbeatMonitor();
+
+  // Forbidden copy constructor and assignment operator
+  ThreadHeartbeatMonitor(const ThreadHeartbeatMonitor&) = delete;
+  ThreadHeartbeatMonitor& operator=(const ThreadHeartbeatMonitor&) = delete;
+
+  void monitorLoop();
+  void scanHeartbeats();
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<ThreadHeartbeat*> heartbeats_;
+  std::chrono::milliseconds scanInterval_{1000};
+  std::thread thread_;
+  bool running_{false};
+  bool stop_{false};
+};
+
 }} // facebook::fboss
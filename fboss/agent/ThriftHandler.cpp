@@ -14,6 +14,7 @@
 #include "common/stats/ServiceData.h"
 #include "fboss/agent/AddressUtil.h"
 #include "fboss/agent/ArpHandler.h"
+#include "fboss/agent/FlowSampler.h"
 #include "fboss/agent/HighresCounterSubscriptionHandler.h"
 #include "fboss/agent/IPv6Handler.h"
 #include "fboss/agent/LldpManager.h"
@@ -31,12 +32,14 @@
 #include "fboss/agent/state/Interface.h"
 #include "fboss/agent/state/InterfaceMap.h"
 #include "fboss/agent/state/NdpTable.h"
+#include "fboss/agent/state/NodeCloneProfiler.h"
 #include "fboss/agent/state/NdpEntry.h"
 #include "fboss/agent/state/Port.h"
 #include "fboss/agent/state/Route.h"
 #include "fboss/agent/state/RouteTable.h"
 #include "fboss/agent/state/RouteTableRib.h"
 #include "fboss/agent/state/RouteUpdater.h"
+#include "fboss/agent/state/StateDelta.h"
 #include "fboss/agent/state/SwitchState.h"
 #include "fboss/agent/state/Vlan.h"
 #include "fboss/agent/state/VlanMap.h"
@@ -74,8 +77,41 @@ using facebook::network::toBinaryAddress;
 using facebook::network::toAddress;
 using facebook::network::toIPAddress;
 
+namespace {
+// Paged route table dumps: default page size when the caller does not
+// specify one, and the cap on concurrently pinned state snapshots.
+constexpr int32_t kDefaultRouteDumpChunkSize = 10000;
+constexpr size_t kMaxRouteDumps = 4;
+
+// Paged L2 table dumps: batch size for the hardware table walk, default
+// page size, and the cap on concurrently buffered dumps.
+constexpr uint32_t kL2FetchBatchSize = 1024;
+constexpr int32_t kDefaultL2DumpChunkSize = 10000;
+constexpr size_t kMaxL2Dumps = 4;
+}
+
 namespace facebook { namespace fboss {
 
+namespace {
+// Build a neighbor table thrift entry from a switch state entry, for
+// the snapshot-consistent query. The switch state only tracks whether
+// an entry is resolved, so entries report PENDING or REACHABLE and
+// carry no TTL.
+template <typename EntryThriftT, typename NeighborEntryT>
+EntryThriftT makeNeighborEntry(const NeighborEntryT& entry,
+                               const Vlan& vlan) {
+  EntryThriftT thriftEntry;
+  thriftEntry.ip = toBinaryAddress(entry.getIP());
+  thriftEntry.mac = entry.getMac().toString();
+  thriftEntry.port = entry.getPort();
+  thriftEntry.vlanName = vlan.getName();
+  thriftEntry.vlanID = vlan.getID();
+  thriftEntry.state = entry.isPending() ? "PENDING" : "REACHABLE";
+  thriftEntry.ttl = 0;
+  return thriftEntry;
+}
+}
+
 class RouteUpdateStats {
  public:
   RouteUpdateStats(SwSwitch *sw, const std::string& func, uint32_t routes)
@@ -112,6 +148,14 @@ ThriftHandler::ThriftHandler(SwSwitch* sw) : FacebookBase2("FBOSS"), sw_(sw) {
               invokeNeighborListeners(listenerPtr, added, deleted); });
       }
   });
+  sw->registerNeighborEntryDeltaListener(
+    [=](const std::vector<NeighborEntryDelta>& deltas) {
+      for (auto& listener : deltaListeners_.accessAllThreads()) {
+        auto listenerPtr = &listener;
+        listener.eventBase->runInEventBaseThread(
+            [=] { invokeNeighborDeltaListeners(listenerPtr, deltas); });
+      }
+  });
 }
 
 fb_status ThriftHandler::getStatus() {
@@ -142,11 +186,26 @@ void ThriftHandler::flushCountersNow() {
   sw_->publishStats();
 }
 
-void ThriftHandler::addUnicastRoute(
+folly::Future<folly::Unit> ThriftHandler::scheduleStateUpdate(
+    folly::StringPiece name,
+    std::function<std::shared_ptr<SwitchState>(
+        const std::shared_ptr<SwitchState>&)> fn,
+    StateUpdate::Priority priority) {
+  auto start = std::chrono::steady_clock::now();
+  auto* sw = sw_;
+  return sw_->updateStateFuture(name, std::move(fn), priority)
+      .ensure([sw, start]() {
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        sw->stats()->thriftUpdateDone(duration);
+      });
+}
+
+folly::Future<folly::Unit> ThriftHandler::future_addUnicastRoute(
     int16_t client, std::unique_ptr<UnicastRoute> route) {
   ensureConfigured("addUnicastRoute");
   ensureFibSynced("addUnicastRoute");
-  RouteUpdateStats stats(sw_, "Add", 1);
+  auto stats = std::make_shared<RouteUpdateStats>(sw_, "Add", 1);
   RouterID routerId = RouterID(0); // TODO, default vrf for now
   folly::IPAddress network = toIPAddress(route->dest.ip);
   uint8_t mask = static_cast<uint8_t>(route->dest.prefixLength);
@@ -178,14 +237,15 @@ void ThriftHandler::addUnicastRoute(
     newState->resetRouteTables(std::move(newRt));
     return newState;
   };
-  sw_->updateStateBlocking("add unicast route", updateFn);
+  return scheduleStateUpdate("add unicast route", updateFn)
+      .ensure([stats]() {});
 }
 
-void ThriftHandler::deleteUnicastRoute(
+folly::Future<folly::Unit> ThriftHandler::future_deleteUnicastRoute(
     int16_t client, std::unique_ptr<IpPrefix> prefix) {
   ensureConfigured("deleteUnicastRoute");
   ensureFibSynced("deleteUnicastRoute");
-  RouteUpdateStats stats(sw_, "Delete", 1);
+  auto stats = std::make_shared<RouteUpdateStats>(sw_, "Delete", 1);
   RouterID routerId = RouterID(0); // TODO, default vrf for now
   folly::IPAddress network =  toIPAddress(prefix->ip);
   uint8_t mask = static_cast<uint8_t>(prefix->prefixLength);
@@ -207,18 +267,50 @@ void ThriftHandler::deleteUnicastRoute(
     newState->resetRouteTables(std::move(newRt));
     return newState;
   };
-  sw_->updateStateBlocking("delete unicast route", updateFn);
+  return scheduleStateUpdate("delete unicast route", updateFn)
+      .ensure([stats]() {});
 }
 
-void ThriftHandler::addUnicastRoutes(
+folly::Future<folly::Unit> ThriftHandler::future_addUnicastRoutes(
     int16_t client, std::unique_ptr<std::vector<UnicastRoute>> routes) {
   ensureConfigured("addUnicastRoutes");
   ensureFibSynced("addUnicastRoutes");
-  RouteUpdateStats stats(sw_, "Add", routes->size());
-  auto updateFn = [&](const shared_ptr<SwitchState>& state) {
+  return addUnicastRoutesImpl(client, std::move(*routes));
+}
+
+folly::Future<folly::Unit> ThriftHandler::future_addUnicastRoutesChunked(
+    int16_t client, std::unique_ptr<std::vector<UnicastRoute>> routes,
+    bool isLast) {
+  ensureConfigured("addUnicastRoutesChunked");
+  ensureFibSynced("addUnicastRoutesChunked");
+  std::vector<UnicastRoute> allRoutes;
+  {
+    std::lock_guard<std::mutex> g(chunkedRouteMutex_);
+    auto& pending = pendingChunkedAddRoutes_[client];
+    pending.insert(pending.end(),
+                   std::make_move_iterator(routes->begin()),
+                   std::make_move_iterator(routes->end()));
+    if (!isLast) {
+      return folly::makeFuture();
+    }
+    allRoutes.swap(pending);
+    pendingChunkedAddRoutes_.erase(client);
+  }
+  // Apply the whole accumulated set in one SwitchState update, outside
+  // the lock so other clients can keep streaming chunks.
+  return addUnicastRoutesImpl(client, std::move(allRoutes));
+}
+
+folly::Future<folly::Unit> ThriftHandler::addUnicastRoutesImpl(
+    int16_t client, std::vector<UnicastRoute> routes) {
+  auto stats = std::make_shared<RouteUpdateStats>(sw_, "Add", routes.size());
+  // The update no longer runs under the caller's stack frame, so the
+  // routes are moved into the lambda rather than captured by reference.
+  auto updateFn = [this, client, routes = std::move(routes)](
+      const shared_ptr<SwitchState>& state) {
     RouteUpdater updater(state->getRouteTables());
     RouterID routerId = RouterID(0); // TODO, default vrf for now
-    for (const auto& route : *routes) {
+    for (const auto& route : routes) {
       auto network = toIPAddress(route.dest.ip);
       auto mask = static_cast<uint8_t>(route.dest.prefixLength);
       RouteNextHops nexthops;
@@ -246,23 +338,30 @@ void ThriftHandler::addUnicastRoutes(
     newState->resetRouteTables(std::move(newRt));
     return newState;
   };
-  sw_->updateStateBlocking("add unicast route", updateFn);
+  // Bulk route adds, like a FIB sync, must not delay latency-critical
+  // updates queued behind them.
+  return scheduleStateUpdate("add unicast route", std::move(updateFn),
+                             StateUpdate::Priority::BULK)
+      .ensure([stats]() {});
 }
 
 void ThriftHandler::getProductInfo(ProductInfo& productInfo) {
   sw_->getProductInfo(productInfo);
 }
 
-void ThriftHandler::deleteUnicastRoutes(
+folly::Future<folly::Unit> ThriftHandler::future_deleteUnicastRoutes(
     int16_t client, std::unique_ptr<std::vector<IpPrefix>> prefixes) {
   ensureConfigured("deleteUnicastRoutes");
   ensureFibSynced("deleteUnicastRoutes");
-  RouteUpdateStats stats(sw_, "Delete", prefixes->size());
-  // Perform the update
-  auto updateFn = [&](const shared_ptr<SwitchState>& state) {
+  auto stats =
+      std::make_shared<RouteUpdateStats>(sw_, "Delete", prefixes->size());
+  // Perform the update; the prefixes move into the lambda since the
+  // update outlives this call.
+  auto updateFn = [this, client, prefixes = std::move(*prefixes)](
+      const shared_ptr<SwitchState>& state) {
     RouteUpdater updater(state->getRouteTables());
     RouterID routerId = RouterID(0); // TODO, default vrf for now
-    for (const auto& prefix : *prefixes) {
+    for (const auto& prefix : prefixes) {
       auto network = toIPAddress(prefix.ip);
       auto mask = static_cast<uint8_t>(prefix.prefixLength);
       if (network.isV4()) {
@@ -280,24 +379,49 @@ void ThriftHandler::deleteUnicastRoutes(
     newState->resetRouteTables(std::move(newRt));
     return newState;
   };
-  sw_->updateStateBlocking("delete unicast route", updateFn);
+  return scheduleStateUpdate("delete unicast route", std::move(updateFn))
+      .ensure([stats]() {});
 }
 
-void ThriftHandler::syncFib(
+folly::Future<folly::Unit> ThriftHandler::future_syncFib(
     int16_t client, std::unique_ptr<std::vector<UnicastRoute>> routes) {
   ensureConfigured("syncFib");
-  RouteUpdateStats stats(sw_, "Sync", routes->size());
+  return syncFibImpl(client, std::move(*routes));
+}
 
-  // Note that we capture routes by reference here, since it is a unique_ptr.
-  // This is safe since we use updateStateBlocking(), so routes will still
-  // be valid in our scope when updateFn() is called.
-  // We could use folly::MoveWrapper if we did need to capture routes by value.
-  auto updateFn = [&](const shared_ptr<SwitchState>& state) {
+folly::Future<folly::Unit> ThriftHandler::future_syncFibChunked(
+    int16_t client, std::unique_ptr<std::vector<UnicastRoute>> routes,
+    bool isLast) {
+  ensureConfigured("syncFibChunked");
+  std::vector<UnicastRoute> allRoutes;
+  {
+    std::lock_guard<std::mutex> g(chunkedRouteMutex_);
+    auto& pending = pendingChunkedSyncRoutes_[client];
+    pending.insert(pending.end(),
+                   std::make_move_iterator(routes->begin()),
+                   std::make_move_iterator(routes->end()));
+    if (!isLast) {
+      return folly::makeFuture();
+    }
+    allRoutes.swap(pending);
+    pendingChunkedSyncRoutes_.erase(client);
+  }
+  return syncFibImpl(client, std::move(allRoutes));
+}
+
+folly::Future<folly::Unit> ThriftHandler::syncFibImpl(
+    int16_t client, std::vector<UnicastRoute> routes) {
+  auto stats = std::make_shared<RouteUpdateStats>(sw_, "Sync", routes.size());
+
+  // The routes move into the lambda: the update runs after this call has
+  // already returned, so capturing them by reference would be unsafe.
+  auto updateFn = [this, client, routes = std::move(routes)](
+      const shared_ptr<SwitchState>& state) {
     // create an update object starting from empty
     RouteUpdater updater(state->getRouteTables());
     RouterID routerId = RouterID(0); // TODO, default vrf for now
     updater.removeAllNexthopsForClient(routerId, ClientID(client));
-    for (auto const& route : *routes) {
+    for (auto const& route : routes) {
       folly::IPAddress network = toIPAddress(route.dest.ip);
       uint8_t mask = static_cast<uint8_t>(route.dest.prefixLength);
       RouteNextHops nexthops;
@@ -319,13 +443,62 @@ void ThriftHandler::syncFib(
     }
     auto newState = state->clone();
     newState->resetRouteTables(std::move(newRt));
+    if (sw_->fibPreloaded() && !sw_->isFibSynced()) {
+      // First live sync over a preloaded FIB: record how far off the
+      // snapshot was from the table the route server replayed.
+      sw_->logFibPreloadReconciliation(StateDelta(state, newState));
+    }
     return newState;
   };
-  sw_->updateStateBlocking("sync fib", updateFn);
+  // A full FIB sync is the canonical bulk update: let queued urgent and
+  // normal updates (port down, neighbor flush) run ahead of it.
+  return scheduleStateUpdate("sync fib", std::move(updateFn),
+                             StateUpdate::Priority::BULK)
+      .then([this]() {
+        // Only mark the FIB synced once the update has actually been
+        // applied; on failure this continuation is skipped.
+        if (!sw_->isFibSynced()) {
+          sw_->fibSynced();
+        }
+      })
+      .ensure([stats]() {});
+}
 
-  if (!sw_->isFibSynced()) {
-    sw_->fibSynced();
-  }
+void ThriftHandler::addUnicastRoute(
+    int16_t client, std::unique_ptr<UnicastRoute> route) {
+  future_addUnicastRoute(client, std::move(route)).get();
+}
+
+void ThriftHandler::deleteUnicastRoute(
+    int16_t client, std::unique_ptr<IpPrefix> prefix) {
+  future_deleteUnicastRoute(client, std::move(prefix)).get();
+}
+
+void ThriftHandler::addUnicastRoutes(
+    int16_t client, std::unique_ptr<std::vector<UnicastRoute>> routes) {
+  future_addUnicastRoutes(client, std::move(routes)).get();
+}
+
+void ThriftHandler::deleteUnicastRoutes(
+    int16_t client, std::unique_ptr<std::vector<IpPrefix>> prefixes) {
+  future_deleteUnicastRoutes(client, std::move(prefixes)).get();
+}
+
+void ThriftHandler::syncFib(
+    int16_t client, std::unique_ptr<std::vector<UnicastRoute>> routes) {
+  future_syncFib(client, std::move(routes)).get();
+}
+
+void ThriftHandler::addUnicastRoutesChunked(
+    int16_t client, std::unique_ptr<std::vector<UnicastRoute>> routes,
+    bool isLast) {
+  future_addUnicastRoutesChunked(client, std::move(routes), isLast).get();
+}
+
+void ThriftHandler::syncFibChunked(
+    int16_t client, std::unique_ptr<std::vector<UnicastRoute>> routes,
+    bool isLast) {
+  future_syncFibChunked(client, std::move(routes), isLast).get();
 }
 
 void ThriftHandler::getAllInterfaces(
@@ -397,6 +570,79 @@ void ThriftHandler::getL2Table(std::vector<L2EntryThrift>& l2Table) {
   VLOG(6) << "L2 Table size:" << l2Table.size();
 }
 
+void ThriftHandler::getHwTableUsage(std::vector<HwTableUsage>& usage) {
+  ensureConfigured();
+  sw_->getHw()->getHwTableUsage(usage);
+}
+
+folly::Future<L2TableChunk> ThriftHandler::future_getL2TableChunk(
+    int64_t cursor, int32_t maxEntries) {
+  ensureConfigured();
+  if (maxEntries <= 0) {
+    maxEntries = kDefaultL2DumpChunkSize;
+  }
+
+  if (cursor == 0) {
+    // Start a new dump. The hardware table walk is the expensive part,
+    // so run it on the background thread in bounded batches and release
+    // the Thrift worker until the first page is ready.
+    return folly::via(sw_->getBackgroundEVB(), [this, maxEntries]() {
+      L2DumpState dump;
+      sw_->getHw()->fetchL2TableBatched(
+          kL2FetchBatchSize, [&](std::vector<L2EntryThrift> batch) {
+            dump.entries.insert(dump.entries.end(),
+                                std::make_move_iterator(batch.begin()),
+                                std::make_move_iterator(batch.end()));
+            return true;
+          });
+      VLOG(6) << "L2 table dump buffered " << dump.entries.size()
+              << " entries";
+      return makeL2Chunk(std::move(dump), maxEntries);
+    });
+  }
+
+  // Later pages come straight out of the buffered snapshot; no hardware
+  // access is involved, so they can be served inline.
+  L2DumpState dump;
+  {
+    std::lock_guard<std::mutex> g(l2DumpMutex_);
+    auto it = l2DumpCursors_.find(cursor);
+    if (it == l2DumpCursors_.end()) {
+      throw FbossError("unknown or expired L2 table dump cursor ", cursor);
+    }
+    dump = std::move(it->second);
+    l2DumpCursors_.erase(it);
+  }
+  return folly::makeFuture(makeL2Chunk(std::move(dump), maxEntries));
+}
+
+L2TableChunk ThriftHandler::makeL2Chunk(L2DumpState dump, int32_t maxEntries) {
+  L2TableChunk chunk;
+  auto remaining = dump.entries.size() - dump.offset;
+  auto count = std::min<size_t>(remaining, maxEntries);
+  chunk.entries.assign(
+      std::make_move_iterator(dump.entries.begin() + dump.offset),
+      std::make_move_iterator(dump.entries.begin() + dump.offset + count));
+  dump.offset += count;
+
+  if (dump.offset >= dump.entries.size()) {
+    chunk.cursor = 0;
+    chunk.isLast = true;
+    return chunk;
+  }
+
+  std::lock_guard<std::mutex> g(l2DumpMutex_);
+  if (l2DumpCursors_.size() >= kMaxL2Dumps) {
+    // Bound the buffered dumps by dropping the least recently started
+    // one; its next page request will error out.
+    l2DumpCursors_.erase(l2DumpCursors_.begin());
+  }
+  chunk.cursor = nextL2DumpCursor_++;
+  chunk.isLast = false;
+  l2DumpCursors_.emplace(chunk.cursor, std::move(dump));
+  return chunk;
+}
+
 void ThriftHandler::fillPortStats(PortInfoThrift& portInfo) {
   auto portId = portInfo.portId;
   auto statMap = fbData->getStatMap();
@@ -425,7 +671,7 @@ void ThriftHandler::fillPortStats(PortInfoThrift& portInfo) {
   fillPortCounters(portInfo.input, "in_");
 }
 
-void ThriftHandler::getPortInfoHelper(
+void ThriftHandler::fillPortInfoFromState(
     PortInfoThrift& portInfo,
     const std::shared_ptr<Port> port) {
   portInfo.portId = port->getID();
@@ -439,8 +685,12 @@ void ThriftHandler::getPortInfoHelper(
   portInfo.adminState = PortAdminState(port->getState() == cfg::PortState::UP);
   portInfo.operState = PortOperState(port->getOperState());
   portInfo.fecEnabled = sw_->getHw()->getPortFECConfig(port->getID());
+}
 
-
+void ThriftHandler::getPortInfoHelper(
+    PortInfoThrift& portInfo,
+    const std::shared_ptr<Port> port) {
+  fillPortInfoFromState(portInfo, port);
   fillPortStats(portInfo);
 }
 
@@ -461,10 +711,19 @@ void ThriftHandler::getAllPortInfo(map<int32_t, PortInfoThrift>& portInfoMap) {
   // NOTE: important to take pointer to switch state before iterating over
   // list of ports
   std::shared_ptr<SwitchState> swState = sw_->getState();
-  for (const auto& port : *(swState->getPorts())) {
-    auto portId = port->getID();
-    auto& portInfo = portInfoMap[portId];
-    getPortInfoHelper(portInfo, port);
+  // The state-derived skeleton is cached per published SwitchState; the
+  // counters change continuously, so they are filled in fresh on every
+  // call on top of a copy of the skeleton.
+  auto skeleton = allPortInfoCache_.get(swState, [&](const SwitchState& state) {
+    map<int32_t, PortInfoThrift> result;
+    for (const auto& port : *(state.getPorts())) {
+      fillPortInfoFromState(result[port->getID()], port);
+    }
+    return result;
+  });
+  portInfoMap = *skeleton;
+  for (auto& entry : portInfoMap) {
+    fillPortStats(entry.second);
   }
 }
 
@@ -493,7 +752,8 @@ void ThriftHandler::getPortStatus(map<int32_t, PortStatus>& statusMap,
   }
 }
 
-void ThriftHandler::setPortState(int32_t portNum, bool enable) {
+folly::Future<folly::Unit> ThriftHandler::future_setPortState(
+    int32_t portNum, bool enable) {
   ensureConfigured();
   PortID portId = PortID(portNum);
   const auto port = sw_->getState()->getPorts()->getPortIf(portId);
@@ -506,7 +766,7 @@ void ThriftHandler::setPortState(int32_t portNum, bool enable) {
 
   if (port->getState() == newPortState) {
     VLOG(2) << "setPortState: port already in state " << (enable? "UP": "DOWN");
-    return;
+    return folly::makeFuture();
   }
 
   auto updateFn = [=](const shared_ptr<SwitchState>& state) {
@@ -515,7 +775,11 @@ void ThriftHandler::setPortState(int32_t portNum, bool enable) {
     newPort->setState(newPortState);
     return newState;
   };
-  sw_->updateStateBlocking("set port state", updateFn);
+  return scheduleStateUpdate("set port state", updateFn);
+}
+
+void ThriftHandler::setPortState(int32_t portNum, bool enable) {
+  future_setPortState(portNum, enable).get();
 }
 
 void ThriftHandler::getRouteTable(std::vector<UnicastRoute>& route) {
@@ -572,6 +836,249 @@ void ThriftHandler::getRouteTableDetails(std::vector<RouteDetails>& route) {
   }
 }
 
+ThriftHandler::RouteDumpCursor ThriftHandler::resumeRouteDump(int64_t cursor) {
+  // Look up (and detach) the dump we are resuming, or start a new one
+  // from the current state. The snapshot is immutable, so iterating it
+  // outside the lock is safe, and entry offsets within it are stable.
+  RouteDumpCursor pos;
+  std::lock_guard<std::mutex> g(routeDumpMutex_);
+  if (cursor == 0) {
+    pos.state = sw_->getState();
+  } else {
+    auto it = routeDumpCursors_.find(cursor);
+    if (it == routeDumpCursors_.end()) {
+      throw FbossError("unknown or expired route dump cursor ", cursor);
+    }
+    pos = std::move(it->second);
+    routeDumpCursors_.erase(it);
+  }
+  return pos;
+}
+
+int64_t ThriftHandler::stashRouteDump(RouteDumpCursor pos) {
+  std::lock_guard<std::mutex> g(routeDumpMutex_);
+  if (routeDumpCursors_.size() >= kMaxRouteDumps) {
+    // Bound the number of pinned snapshots by dropping the least
+    // recently started dump; its next page request will error out.
+    routeDumpCursors_.erase(routeDumpCursors_.begin());
+  }
+  auto cursor = nextRouteDumpCursor_++;
+  routeDumpCursors_.emplace(cursor, std::move(pos));
+  return cursor;
+}
+
+bool ThriftHandler::emitRouteDumpPage(RouteDumpCursor& pos,
+                                      int32_t maxRoutes,
+                                      std::vector<UnicastRoute>& routes) {
+  // Emit routes from one rib, resuming pos.offset entries in. Returns
+  // false if the page filled up with rib entries still left.
+  auto emitRib = [&](const auto* rib) {
+    uint64_t idx = 0;
+    for (const auto& ribNode : rib->routes()) {
+      if (idx < pos.offset) {
+        ++idx;
+        continue;
+      }
+      if (routes.size() >= static_cast<size_t>(maxRoutes)) {
+        return false;
+      }
+      pos.offset = ++idx;
+      const auto& rt = ribNode.value();
+      if (!rt->isResolved()) {
+        VLOG(4) << "Skipping unresolved route: " << rt->toFollyDynamic();
+        continue;
+      }
+      UnicastRoute tempRoute;
+      tempRoute.dest.ip = toBinaryAddress(rt->prefix().network);
+      tempRoute.dest.prefixLength = rt->prefix().mask;
+      for (const auto& hop : rt->getForwardInfo().getNexthops()) {
+        tempRoute.nextHopAddrs.push_back(toBinaryAddress(hop.nexthop));
+      }
+      routes.push_back(std::move(tempRoute));
+    }
+    return true;
+  };
+
+  size_t tableIdx = 0;
+  for (const auto& routeTable : (*pos.state->getRouteTables())) {
+    if (tableIdx++ < pos.tableIdx) {
+      continue;
+    }
+    if (!pos.v6) {
+      if (!emitRib(routeTable->getRibV4())) {
+        return false;
+      }
+      pos.v6 = true;
+      pos.offset = 0;
+    }
+    if (!emitRib(routeTable->getRibV6())) {
+      return false;
+    }
+    pos.tableIdx = tableIdx;
+    pos.v6 = false;
+    pos.offset = 0;
+  }
+  return true;
+}
+
+void ThriftHandler::getRouteTableChunk(RouteTableChunk& chunk,
+                                       int64_t cursor,
+                                       int32_t maxRoutes) {
+  ensureConfigured();
+  if (maxRoutes <= 0) {
+    maxRoutes = kDefaultRouteDumpChunkSize;
+  }
+
+  auto pos = resumeRouteDump(cursor);
+  if (emitRouteDumpPage(pos, maxRoutes, chunk.routes)) {
+    chunk.cursor = 0;
+    chunk.isLast = true;
+  } else {
+    chunk.cursor = stashRouteDump(std::move(pos));
+    chunk.isLast = false;
+  }
+}
+
+void ThriftHandler::getStateSnapshot(
+    StateSnapshotChunk& chunk,
+    std::unique_ptr<std::vector<StateSnapshotSection>> sections,
+    int64_t cursor,
+    int32_t maxRoutes) {
+  ensureConfigured();
+  if (maxRoutes <= 0) {
+    maxRoutes = kDefaultRouteDumpChunkSize;
+  }
+
+  // Pin one SwitchState and answer every requested section from it, so
+  // the caller sees ports, neighbors and routes from the same state
+  // version. Later pages resume the route dump out of the same pinned
+  // snapshot; the scalar sections were already delivered on the first
+  // chunk.
+  auto pos = resumeRouteDump(cursor);
+  const auto& state = pos.state;
+
+  bool wantRoutes = false;
+  for (auto section : *sections) {
+    switch (section) {
+      case StateSnapshotSection::PORTS:
+        if (cursor == 0) {
+          chunk.ports = sw_->getPortStatus(state);
+          chunk.__isset.ports = true;
+        }
+        break;
+      case StateSnapshotSection::INTERFACES:
+        if (cursor == 0) {
+          for (const auto& intf : (*state->getInterfaces())) {
+            auto& interfaceDetail = chunk.interfaces[intf->getID()];
+            interfaceDetail.interfaceName = intf->getName();
+            interfaceDetail.interfaceId = intf->getID();
+            interfaceDetail.vlanId = intf->getVlanID();
+            interfaceDetail.routerId = intf->getRouterID();
+            interfaceDetail.mac = intf->getMac().toString();
+            interfaceDetail.address.reserve(intf->getAddresses().size());
+            for (const auto& addrAndMask : intf->getAddresses()) {
+              IpPrefix temp;
+              temp.ip = toBinaryAddress(addrAndMask.first);
+              temp.prefixLength = addrAndMask.second;
+              interfaceDetail.address.push_back(temp);
+            }
+          }
+          chunk.__isset.interfaces = true;
+        }
+        break;
+      case StateSnapshotSection::ARP:
+        if (cursor == 0) {
+          for (const auto& vlan : (*state->getVlans())) {
+            for (const auto& entry : (*vlan->getArpTable())) {
+              chunk.arpTable.push_back(
+                  makeNeighborEntry<ArpEntryThrift>(*entry, *vlan));
+            }
+          }
+          chunk.__isset.arpTable = true;
+        }
+        break;
+      case StateSnapshotSection::NDP:
+        if (cursor == 0) {
+          for (const auto& vlan : (*state->getVlans())) {
+            for (const auto& entry : (*vlan->getNdpTable())) {
+              chunk.ndpTable.push_back(
+                  makeNeighborEntry<NdpEntryThrift>(*entry, *vlan));
+            }
+          }
+          chunk.__isset.ndpTable = true;
+        }
+        break;
+      case StateSnapshotSection::ROUTES:
+        wantRoutes = true;
+        break;
+    }
+  }
+
+  if (wantRoutes && !emitRouteDumpPage(pos, maxRoutes, chunk.routes)) {
+    chunk.cursor = stashRouteDump(std::move(pos));
+    chunk.isLast = false;
+    return;
+  }
+  chunk.cursor = 0;
+  chunk.isLast = true;
+}
+
+void ThriftHandler::getRouteTableDetailsRange(
+    RouteTableDetailsPage& page,
+    int32_t vrfId,
+    std::unique_ptr<IpPrefix> startPrefix,
+    int32_t maxRoutes) {
+  ensureConfigured();
+  if (maxRoutes <= 0) {
+    maxRoutes = kDefaultRouteDumpChunkSize;
+  }
+  folly::IPAddress start = toIPAddress(startPrefix->ip);
+  uint8_t startMask = startPrefix->prefixLength;
+  auto routeTable = sw_->getState()->getRouteTables()->getRouteTableIf(
+      RouterID(vrfId));
+  if (!routeTable) {
+    throw FbossError("No Such VRF ", vrfId);
+  }
+  page.isLast = true;
+
+  // Total order over prefixes: by network address, with a parent prefix
+  // (shorter mask) before its subdivisions. This matches the radix
+  // tree's DFS/preorder traversal, so a single in-order pass can skip
+  // to the start prefix, emit one page and stop.
+  auto prefixLess = [](const folly::IPAddress& aAddr, uint8_t aMask,
+                       const folly::IPAddress& bAddr, uint8_t bMask) {
+    if (aAddr != bAddr) {
+      return aAddr < bAddr;
+    }
+    return aMask < bMask;
+  };
+
+  auto emitRange = [&](const auto* rib) {
+    for (const auto& ribNode : rib->routes()) {
+      const auto& rt = ribNode.value();
+      folly::IPAddress network(rt->prefix().network);
+      uint8_t mask = rt->prefix().mask;
+      if (prefixLess(network, mask, start, startMask)) {
+        continue;
+      }
+      if (page.routes.size() >= static_cast<size_t>(maxRoutes)) {
+        // Page is full: the first in-order prefix we did not emit is
+        // the cursor for the next page.
+        page.nextPrefix.ip = toBinaryAddress(network);
+        page.nextPrefix.prefixLength = mask;
+        page.isLast = false;
+        return;
+      }
+      page.routes.push_back(rt->toRouteDetails());
+    }
+  };
+  if (start.isV4()) {
+    emitRange(routeTable->getRibV4());
+  } else {
+    emitRange(routeTable->getRibV6());
+  }
+}
+
 void ThriftHandler::getIpRoute(UnicastRoute& route,
                                 std::unique_ptr<Address> addr, int32_t vrfId) {
   ensureConfigured();
@@ -710,6 +1217,28 @@ void ThriftHandler::invokeNeighborListeners(ThreadLocalListener* listener,
   }
 }
 
+void ThriftHandler::invokeNeighborDeltaListeners(
+    ThreadLocalListener* listener,
+    std::vector<NeighborEntryDelta> deltas) {
+  // Collect the iterators to avoid erasing and potentially reordering
+  // the iterators in the list.
+  for (const auto& ctx : brokenClients_) {
+    listener->clients.erase(ctx);
+  }
+  brokenClients_.clear();
+  for (auto& client : listener->clients) {
+    auto clientDone = [&](ClientReceiveState&& state) {
+      try {
+        NeighborListenerClientAsyncClient::recv_neighborEntryDeltas(state);
+      } catch (const std::exception& ex) {
+        LOG(ERROR) << "Exception in neighbor delta listener: " << ex.what();
+        brokenClients_.push_back(client.first);
+      }
+    };
+    client.second->neighborEntryDeltas(clientDone, deltas);
+  }
+}
+
 void ThriftHandler::async_eb_registerForNeighborChanged(
     ThriftCallback<void> cb) {
   auto ctx = cb->getConnectionContext()->getConnectionContext();
@@ -728,10 +1257,29 @@ void ThriftHandler::async_eb_registerForNeighborChanged(
   cb->done();
 }
 
+void ThriftHandler::async_eb_registerForNeighborDeltas(
+    ThriftCallback<void> cb) {
+  auto ctx = cb->getConnectionContext()->getConnectionContext();
+  auto client = ctx->getDuplexClient<NeighborListenerClientAsyncClient>();
+  auto info = deltaListeners_.get();
+  CHECK(cb->getEventBase()->isInEventBaseThread());
+  if (!info) {
+    info = new ThreadLocalListener(cb->getEventBase());
+    deltaListeners_.reset(info);
+  }
+  DCHECK_EQ(info->eventBase, cb->getEventBase());
+  if (!info->eventBase) {
+    info->eventBase = cb->getEventBase();
+  }
+  info->clients.emplace(ctx, client);
+  cb->done();
+}
+
 void ThriftHandler::startPktCapture(unique_ptr<CaptureInfo> info) {
   ensureConfigured();
   auto* mgr = sw_->getCaptureMgr();
-  auto capture = make_unique<PktCapture>(info->name, info->maxPackets);
+  auto capture = make_unique<PktCapture>(
+      info->name, info->maxPackets, info->maxBytes, PktFilter(info->filter));
   mgr->startCapture(std::move(capture));
 }
 
@@ -747,6 +1295,62 @@ void ThriftHandler::stopAllPktCaptures() {
   mgr->forgetAllCaptures();
 }
 
+void ThriftHandler::dumpPcapRing(unique_ptr<std::string> name) {
+  ensureConfigured();
+  auto* mgr = sw_->getCaptureMgr();
+  mgr->dumpPcapRing(*name);
+}
+
+void ThriftHandler::getSampledFlows(std::vector<SampledFlow>& flows,
+                                    bool clearFlows) {
+  ensureConfigured();
+  sw_->getFlowSampler()->exportFlows(&flows, clearFlows);
+}
+
+void ThriftHandler::getConvergenceTraces(std::vector<ConvergenceTrace>& traces,
+                                         int32_t numTraces) {
+  ensureConfigured();
+  for (const auto& record : sw_->getConvergenceTraces(numTraces)) {
+    ConvergenceTrace trace;
+    trace.updateName = record.name;
+    trace.enqueuedMsec = record.enqueuedMsec;
+    trace.queueUsec = record.queueUsec;
+    trace.applyUsec = record.applyUsec;
+    trace.hwUsec = record.hwUsec;
+    trace.totalUsec = record.totalUsec;
+    traces.push_back(std::move(trace));
+  }
+}
+
+void ThriftHandler::getMemoryBreakdown(
+    std::map<std::string, int64_t>& breakdown) {
+  ensureConfigured();
+  breakdown = sw_->computeMemoryBreakdown();
+
+  // Fold in the Thrift-side buffers, which the switch itself cannot
+  // see: routes batched by chunked updates that have not committed yet.
+  // The SwitchState snapshots pinned by paged dumps are copy-on-write
+  // shares of live state, so they have no attributable byte count of
+  // their own; publishSwitchStateStats() tracks the generation count.
+  int64_t pendingRouteBytes = 0;
+  {
+    std::lock_guard<std::mutex> g(chunkedRouteMutex_);
+    for (const auto& entry : pendingChunkedAddRoutes_) {
+      for (const auto& route : entry.second) {
+        pendingRouteBytes += sizeof(route) +
+            route.nextHopAddrs.size() * sizeof(network::thrift::BinaryAddress);
+      }
+    }
+    for (const auto& entry : pendingChunkedSyncRoutes_) {
+      for (const auto& route : entry.second) {
+        pendingRouteBytes += sizeof(route) +
+            route.nextHopAddrs.size() * sizeof(network::thrift::BinaryAddress);
+      }
+    }
+  }
+  breakdown["thrift_pending_routes"] = pendingRouteBytes;
+}
+
 void ThriftHandler::startLoggingRouteUpdates(
     std::unique_ptr<RouteUpdateLoggingInfo> info) {
   auto* routeUpdateLogger = sw_->getRouteUpdateLogger();
@@ -757,6 +1361,20 @@ void ThriftHandler::startLoggingRouteUpdates(
   routeUpdateLogger->startLoggingForPrefix(loggingInstance);
 }
 
+void ThriftHandler::startLoggingRouteUpdatesForPrefixes(
+    std::unique_ptr<std::vector<RouteUpdateLoggingInfo>> infos) {
+  auto* routeUpdateLogger = sw_->getRouteUpdateLogger();
+  std::vector<RouteUpdateLoggingInstance> loggingInstances;
+  loggingInstances.reserve(infos->size());
+  for (const auto& info : *infos) {
+    folly::IPAddress addr = toIPAddress(info.prefix.ip);
+    uint8_t mask = static_cast<uint8_t>(info.prefix.prefixLength);
+    loggingInstances.emplace_back(
+        RoutePrefix<folly::IPAddress>{addr, mask}, info.identifier, info.exact);
+  }
+  routeUpdateLogger->startLoggingForPrefixes(loggingInstances);
+}
+
 void ThriftHandler::stopLoggingRouteUpdates(
     std::unique_ptr<IpPrefix> prefix,
     std::unique_ptr<std::string> identifier) {
@@ -787,12 +1405,46 @@ void ThriftHandler::getRouteUpdateLoggingTrackedPrefixes(
   }
 }
 
+void ThriftHandler::getNodeCloneStats(
+    std::vector<NodeCloneStats>& stats, bool clearAfterRead) {
+  if (!NodeCloneProfiler::isEnabled()) {
+    throw FbossError(
+        "agent was not built with FBOSS_PROFILE_NODE_CLONES");
+  }
+  for (const auto& s : NodeCloneProfiler::get().snapshot(clearAfterRead)) {
+    NodeCloneStats entry;
+    entry.nodeType = s.nodeType;
+    entry.clones = s.clones;
+    entry.publishes = s.publishes;
+    entry.destroys = s.destroys;
+    entry.allocatedBytes = s.bytes;
+    stats.push_back(std::move(entry));
+  }
+}
+
+namespace {
+/*
+ * Copy an IOBuf chain into a freshly allocated TxPacket.  The chain
+ * shares the Thrift request's receive buffers, so this single copy into
+ * the DMA-able packet buffer is the only one on the tx path.
+ */
+std::unique_ptr<TxPacket> iobufToTxPacket(
+    std::unique_ptr<TxPacket> pkt,
+    const IOBuf& chain) {
+  RWPrivateCursor cursor(pkt->buf());
+  for (const auto& range : chain) {
+    cursor.push(range);
+  }
+  return pkt;
+}
+} // anonymous namespace
+
 void ThriftHandler::sendPkt(int32_t port, int32_t vlan,
-                            unique_ptr<fbstring> data) {
+                            unique_ptr<IOBuf> data) {
   ensureConfigured("sendPkt");
-  auto buf = IOBuf::copyBuffer(reinterpret_cast<const uint8_t*>(data->data()),
-                               data->size());
-  auto pkt = make_unique<MockRxPacket>(std::move(buf));
+  // The IOBuf chain shares the Thrift receive buffer; injection is
+  // copy free.
+  auto pkt = make_unique<MockRxPacket>(std::move(data));
   pkt->setSrcPort(PortID(port));
   pkt->setSrcVlan(VlanID(vlan));
   sw_->packetReceived(std::move(pkt));
@@ -807,36 +1459,53 @@ void ThriftHandler::sendPktHex(int32_t port, int32_t vlan,
   sw_->packetReceived(std::move(pkt));
 }
 
-void ThriftHandler::txPkt(int32_t port, unique_ptr<fbstring> data) {
+void ThriftHandler::txPkt(int32_t port, unique_ptr<IOBuf> data) {
   ensureConfigured("txPkt");
 
-  unique_ptr<TxPacket> pkt = sw_->allocatePacket(data->size());
-  RWPrivateCursor cursor(pkt->buf());
-  cursor.push(StringPiece(*data));
-
+  auto pkt = iobufToTxPacket(
+      sw_->allocatePacket(data->computeChainDataLength()), *data);
   sw_->sendPacketOutOfPort(std::move(pkt), PortID(port));
 }
 
-void ThriftHandler::txPktL2(unique_ptr<fbstring> data) {
-  ensureConfigured("txPktL2");
+void ThriftHandler::txPkts(
+    int32_t port,
+    std::unique_ptr<std::vector<std::unique_ptr<IOBuf>>> packets) {
+  ensureConfigured("txPkts");
 
-  unique_ptr<TxPacket> pkt = sw_->allocatePacket(data->size());
-  RWPrivateCursor cursor(pkt->buf());
-  cursor.push(StringPiece(*data));
+  for (const auto& data : *packets) {
+    if (!data) {
+      continue;
+    }
+    auto pkt = iobufToTxPacket(
+        sw_->allocatePacket(data->computeChainDataLength()), *data);
+    sw_->sendPacketOutOfPort(std::move(pkt), PortID(port));
+  }
+}
+
+void ThriftHandler::txPktL2(unique_ptr<IOBuf> data) {
+  ensureConfigured("txPktL2");
 
+  auto pkt = iobufToTxPacket(
+      sw_->allocatePacket(data->computeChainDataLength()), *data);
   sw_->sendPacketSwitched(std::move(pkt));
 }
 
-void ThriftHandler::txPktL3(unique_ptr<fbstring> payload) {
+void ThriftHandler::txPktL3(unique_ptr<IOBuf> payload) {
   ensureConfigured("txPktL3");
 
-  unique_ptr<TxPacket> pkt = sw_->allocateL3TxPacket(payload->size());
-  RWPrivateCursor cursor(pkt->buf());
-  cursor.push(StringPiece(*payload));
-
+  auto pkt = iobufToTxPacket(
+      sw_->allocateL3TxPacket(payload->computeChainDataLength()), *payload);
   sw_->sendL3Packet(std::move(pkt));
 }
 
+void ThriftHandler::getPacketTrace(PacketTraceInfo& info, int32_t port,
+                                   unique_ptr<fbstring> data) {
+  ensureConfigured("getPacketTrace");
+  sw_->getHw()->getPacketTrace(PortID(port),
+                               StringPiece(data->data(), data->size()),
+                               &info);
+}
+
 Vlan* ThriftHandler::getVlan(int32_t vlanId) {
   ensureConfigured();
   return sw_->getState()->getVlans()->getVlan(VlanID(vlanId)).get();
@@ -857,22 +1526,24 @@ int32_t ThriftHandler::flushNeighborEntry(unique_ptr<BinaryAddress> ip,
 }
 
 void ThriftHandler::getVlanAddresses(Addresses& addrs, int32_t vlan) {
-  getVlanAddresses(getVlan(vlan), addrs, toAddress);
+  getVlanAddresses(getVlan(vlan), addrs, toAddress, vlanAddrsCache_);
 }
 
 void ThriftHandler::getVlanAddressesByName(Addresses& addrs,
     unique_ptr<string> vlan) {
-  getVlanAddresses(getVlan(*vlan), addrs, toAddress);
+  getVlanAddresses(getVlan(*vlan), addrs, toAddress, vlanAddrsCache_);
 }
 
 void ThriftHandler::getVlanBinaryAddresses(BinaryAddresses& addrs,
     int32_t vlan) {
-  getVlanAddresses(getVlan(vlan), addrs, toBinaryAddress);
+  getVlanAddresses(getVlan(vlan), addrs, toBinaryAddress,
+                   vlanBinaryAddrsCache_);
 }
 
 void ThriftHandler::getVlanBinaryAddressesByName(BinaryAddresses& addrs,
     const std::unique_ptr<std::string> vlan) {
-  getVlanAddresses(getVlan(*vlan), addrs, toBinaryAddress);
+  getVlanAddresses(getVlan(*vlan), addrs, toBinaryAddress,
+                   vlanBinaryAddrsCache_);
 }
 
 void ThriftHandler::getSfpDomInfo(map<int32_t, SfpDom>& domInfos,
@@ -889,15 +1560,26 @@ void ThriftHandler::getTransceiverInfo(map<int32_t, TransceiverInfo>& info,
 
 template<typename ADDR_TYPE, typename ADDR_CONVERTER>
 void ThriftHandler::getVlanAddresses(const Vlan* vlan,
-    std::vector<ADDR_TYPE>& addrs, ADDR_CONVERTER& converter) {
+    std::vector<ADDR_TYPE>& addrs, ADDR_CONVERTER& converter,
+    StateCachedResponse<std::map<VlanID, std::vector<ADDR_TYPE>>>& cache) {
   ensureConfigured();
   CHECK(vlan);
-  for (auto intf : (*sw_->getState()->getInterfaces())) {
-    if (intf->getVlanID() == vlan->getID()) {
+  // One interface walk per published state builds the converted address
+  // lists for every vlan; repeated queries are then plain map lookups.
+  auto state = sw_->getState();
+  auto byVlan = cache.get(state, [&](const SwitchState& s) {
+    std::map<VlanID, std::vector<ADDR_TYPE>> result;
+    for (auto intf : (*s.getInterfaces())) {
+      auto& vlanAddrs = result[intf->getVlanID()];
       for (const auto& addrAndMask : intf->getAddresses()) {
-          addrs.push_back(converter(addrAndMask.first));
+        vlanAddrs.push_back(converter(addrAndMask.first));
       }
     }
+    return result;
+  });
+  auto itr = byVlan->find(vlan->getID());
+  if (itr != byVlan->end()) {
+    addrs.insert(addrs.end(), itr->second.begin(), itr->second.end());
   }
 }
 
@@ -906,6 +1588,15 @@ BootType ThriftHandler::getBootType() {
 }
 
 void ThriftHandler::ensureConfigured(StringPiece function) {
+  // Thrift work belongs on the server's own worker pool.  A handler
+  // call on a packet path thread means a dump can block rx processing,
+  // so count it and complain rather than fail the call.
+  if (SwSwitch::isPacketPathThread()) {
+    sw_->stats()->thriftOnPacketThread();
+    LOG(ERROR) << "thrift handler running on a packet path thread: "
+               << function;
+  }
+
   if (sw_->isFullyConfigured()) {
     return;
   }
@@ -936,6 +1627,9 @@ void ThriftHandler::connectionDestroyed(TConnectionContext* ctx) {
   if (listeners_) {
     listeners_->clients.erase(ctx);
   }
+  if (deltaListeners_) {
+    deltaListeners_->clients.erase(ctx);
+  }
 
   // If there is an ongoing high-resolution counter subscription, kill it. Don't
   // grab a write lock if there are no active calls
@@ -1004,4 +1698,30 @@ void ThriftHandler::reloadConfig() {
   return sw_->applyConfig("reload config initiated by thrift call");
 }
 
+void ThriftHandler::applyConfigPatch(std::unique_ptr<std::string> section,
+                                     std::unique_ptr<std::string> patchJson) {
+  ensureConfigured();
+  sw_->applyConfigPatch(*section, *patchJson);
+}
+
+void ThriftHandler::dumpOperState(std::unique_ptr<std::string> subtrees,
+                                  std::unique_ptr<std::string> outFile) {
+  ensureConfigured();
+  sw_->dumpOperState(*subtrees, *outFile);
+}
+
+int64_t ThriftHandler::registerCounterManifest(
+    std::unique_ptr<std::vector<std::string>> names) {
+  return counterExporter_.registerManifest(*names);
+}
+
+void ThriftHandler::getCounterDeltas(CounterDeltaBatch& batch,
+                                     int64_t manifestId,
+                                     int64_t sinceVersion) {
+  auto result = counterExporter_.getDeltas(manifestId, sinceVersion);
+  batch.version = result.version;
+  batch.absolute = result.absolute;
+  batch.values = std::move(result.values);
+}
+
 }} // facebook::fboss
@@ -10,19 +10,23 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <map>
 
 #include "common/fb303/cpp/FacebookBase2.h"
+#include "fboss/agent/CounterDeltaExporter.h"
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/types.h"
 #include "fboss/agent/HighresCounterSubscriptionHandler.h"
 #include "fboss/agent/if/gen-cpp2/FbossCtrl.h"
 #include "fboss/agent/if/gen-cpp2/NeighborListenerClient.h"
+#include "fboss/agent/state/StateUpdate.h"
 
 #include <folly/Synchronized.h>
 #include <folly/String.h>
+#include <folly/futures/Future.h>
 #include <thrift/lib/cpp/server/TServer.h>
 #include <thrift/lib/cpp2/async/DuplexChannel.h>
 
@@ -30,6 +34,7 @@ namespace facebook { namespace fboss {
 
 class Port;
 class SwSwitch;
+class SwitchState;
 class Vlan;
 
 class ThriftHandler : virtual public FbossCtrlSvIf,
@@ -55,8 +60,45 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
   void async_eb_registerForNeighborChanged(
       ThriftCallback<void> callback) override;
 
+  void async_eb_registerForNeighborDeltas(
+      ThriftCallback<void> callback) override;
+
   void flushCountersNow() override;
 
+  /*
+   * The state-mutating calls are implemented as future_ overrides so that
+   * the Thrift worker thread is released as soon as the update has been
+   * scheduled, instead of parking until the update thread gets to it.  The
+   * returned Future is fulfilled (on the update thread) once the new
+   * SwitchState has been applied, so the caller still observes the same
+   * completion semantics as before.
+   */
+  folly::Future<folly::Unit> future_addUnicastRoute(
+      int16_t client, std::unique_ptr<UnicastRoute> route) override;
+  folly::Future<folly::Unit> future_deleteUnicastRoute(
+      int16_t client, std::unique_ptr<IpPrefix> prefix) override;
+  folly::Future<folly::Unit> future_addUnicastRoutes(
+      int16_t client,
+      std::unique_ptr<std::vector<UnicastRoute>> routes) override;
+  folly::Future<folly::Unit> future_deleteUnicastRoutes(
+      int16_t client, std::unique_ptr<std::vector<IpPrefix>> prefixes) override;
+  folly::Future<folly::Unit> future_syncFib(
+      int16_t client,
+      std::unique_ptr<std::vector<UnicastRoute>> routes) override;
+  folly::Future<folly::Unit> future_addUnicastRoutesChunked(
+      int16_t client,
+      std::unique_ptr<std::vector<UnicastRoute>> routes,
+      bool isLast) override;
+  folly::Future<folly::Unit> future_syncFibChunked(
+      int16_t client,
+      std::unique_ptr<std::vector<UnicastRoute>> routes,
+      bool isLast) override;
+
+  /*
+   * Synchronous wrappers around the future_ variants above, retained for
+   * direct (non-Thrift) callers such as tests. The generated service code
+   * dispatches to the future_ overrides and never calls these.
+   */
   void addUnicastRoute(
       int16_t client, std::unique_ptr<UnicastRoute> route) override;
   void deleteUnicastRoute(
@@ -69,18 +111,32 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
   void syncFib(
       int16_t client,
       std::unique_ptr<std::vector<UnicastRoute>> routes) override;
+  void addUnicastRoutesChunked(
+      int16_t client,
+      std::unique_ptr<std::vector<UnicastRoute>> routes,
+      bool isLast) override;
+  void syncFibChunked(
+      int16_t client,
+      std::unique_ptr<std::vector<UnicastRoute>> routes,
+      bool isLast) override;
 
   SwSwitch* getSw() const {
     return sw_;
   }
 
   void sendPkt(int32_t port, int32_t vlan,
-      std::unique_ptr<folly::fbstring> data) override;
+      std::unique_ptr<folly::IOBuf> data) override;
   void sendPktHex(int32_t port, int32_t vlan,
       std::unique_ptr<folly::fbstring> hex) override;
-  void txPkt(int32_t port, std::unique_ptr<folly::fbstring> data) override;
-  void txPktL2(std::unique_ptr<folly::fbstring> data) override;
-  void txPktL3(std::unique_ptr<folly::fbstring> payload) override;
+  void txPkt(int32_t port, std::unique_ptr<folly::IOBuf> data) override;
+  void txPkts(int32_t port,
+      std::unique_ptr<std::vector<std::unique_ptr<folly::IOBuf>>> packets)
+      override;
+  void txPktL2(std::unique_ptr<folly::IOBuf> data) override;
+  void txPktL3(std::unique_ptr<folly::IOBuf> payload) override;
+
+  void getPacketTrace(PacketTraceInfo& info, int32_t port,
+      std::unique_ptr<folly::fbstring> data) override;
 
   int32_t flushNeighborEntry(std::unique_ptr<BinaryAddress> ip,
                              int32_t vlan) override;
@@ -101,9 +157,23 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
   void getInterfaceList(std::vector<std::string>& interfaceList) override;
   void getRouteTable(std::vector<UnicastRoute>& routeTable) override;
   void getRouteTableDetails(std::vector<RouteDetails>& routeTable) override;
+  void getRouteTableChunk(RouteTableChunk& chunk,
+                          int64_t cursor,
+                          int32_t maxRoutes) override;
+  void getRouteTableDetailsRange(RouteTableDetailsPage& page,
+                                 int32_t vrfId,
+                                 std::unique_ptr<IpPrefix> startPrefix,
+                                 int32_t maxRoutes) override;
+  void getStateSnapshot(
+      StateSnapshotChunk& chunk,
+      std::unique_ptr<std::vector<StateSnapshotSection>> sections,
+      int64_t cursor,
+      int32_t maxRoutes) override;
   void getPortStatus(std::map<int32_t, PortStatus>& status,
                      std::unique_ptr<std::vector<int32_t>> ports)
                      override;
+  folly::Future<folly::Unit> future_setPortState(
+      int32_t portId, bool enable) override;
   void setPortState(int32_t portId, bool enable) override;
   void getInterfaceDetail(InterfaceDetail& interfaceDetails,
                                           int32_t interfaceId) override;
@@ -114,6 +184,9 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
   void getRunningConfig(std::string& configStr) override;
   void getArpTable(std::vector<ArpEntryThrift>& arpTable) override;
   void getL2Table(std::vector<L2EntryThrift>& l2Table) override;
+  folly::Future<L2TableChunk> future_getL2TableChunk(
+      int64_t cursor, int32_t maxEntries) override;
+  void getHwTableUsage(std::vector<HwTableUsage>& usage) override;
   void getNdpTable(std::vector<NdpEntryThrift>& arpTable) override;
 
   /* returns the product information */
@@ -134,9 +207,17 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
   void startPktCapture(std::unique_ptr<CaptureInfo> info) override;
   void stopPktCapture(std::unique_ptr<std::string> name) override;
   void stopAllPktCaptures() override;
+  void dumpPcapRing(std::unique_ptr<std::string> name) override;
+  void getSampledFlows(std::vector<SampledFlow>& flows,
+                       bool clearFlows) override;
+  void getConvergenceTraces(std::vector<ConvergenceTrace>& traces,
+                            int32_t numTraces) override;
+  void getMemoryBreakdown(std::map<std::string, int64_t>& breakdown) override;
 
   void startLoggingRouteUpdates(
       std::unique_ptr<RouteUpdateLoggingInfo> info) override;
+  void startLoggingRouteUpdatesForPrefixes(
+      std::unique_ptr<std::vector<RouteUpdateLoggingInfo>> infos) override;
   void stopLoggingRouteUpdates(
       std::unique_ptr<IpPrefix> prefix,
       std::unique_ptr<std::string> identifier) override;
@@ -144,6 +225,8 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
       std::unique_ptr<std::string> identifier) override;
   void getRouteUpdateLoggingTrackedPrefixes(
       std::vector<RouteUpdateLoggingInfo>& infos) override;
+  void getNodeCloneStats(
+      std::vector<NodeCloneStats>& stats, bool clearAfterRead) override;
   /*
    * Event handler for when a connection is destroyed.  When there is an ongoing
    * duplex connection, there may be other threads that depend on the connection
@@ -207,6 +290,17 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
    */
   void reloadConfig() override;
 
+  void applyConfigPatch(std::unique_ptr<std::string> section,
+                        std::unique_ptr<std::string> patchJson) override;
+
+  void dumpOperState(std::unique_ptr<std::string> subtrees,
+                     std::unique_ptr<std::string> outFile) override;
+
+  int64_t registerCounterManifest(
+      std::unique_ptr<std::vector<std::string>> names) override;
+  void getCounterDeltas(CounterDeltaBatch& batch, int64_t manifestId,
+                        int64_t sinceVersion) override;
+
  private:
   struct ThreadLocalListener {
     EventBase* eventBase;
@@ -217,6 +311,7 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
     explicit ThreadLocalListener(EventBase* eb) : eventBase(eb){};
   };
   folly::ThreadLocalPtr<ThreadLocalListener, int> listeners_;
+  folly::ThreadLocalPtr<ThreadLocalListener, ThriftHandler> deltaListeners_;
 
   void onPortStatusChanged(PortID id, PortStatus st);
 
@@ -224,16 +319,135 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
                                 std::vector<std::string> added,
                                 std::vector<std::string> deleted);
 
+  void invokeNeighborDeltaListeners(ThreadLocalListener* info,
+                                    std::vector<NeighborEntryDelta> deltas);
+
   void getPortInfoHelper(
       PortInfoThrift& portInfo,
       const std::shared_ptr<Port> port);
+  void fillPortInfoFromState(
+      PortInfoThrift& portInfo,
+      const std::shared_ptr<Port> port);
   void fillPortStats(PortInfoThrift& portInfo);
 
   Vlan* getVlan(int32_t vlanId);
   Vlan* getVlan(const std::string& vlanName);
+
+  /*
+   * Schedule fn as a state update and return a Future fulfilled once the
+   * update has been applied (or has failed). Records the end-to-end
+   * latency of the call in the thrift update latency histogram.
+   */
+  folly::Future<folly::Unit> scheduleStateUpdate(
+      folly::StringPiece name,
+      std::function<std::shared_ptr<SwitchState>(
+          const std::shared_ptr<SwitchState>&)> fn,
+      StateUpdate::Priority priority = StateUpdate::Priority::NORMAL);
+
+  /*
+   * Apply a full set of routes in one SwitchState update. Shared by the
+   * one-shot and chunked variants of addUnicastRoutes/syncFib. The routes
+   * are taken by value since the update outlives the caller's stack frame.
+   */
+  folly::Future<folly::Unit> addUnicastRoutesImpl(
+      int16_t client, std::vector<UnicastRoute> routes);
+  folly::Future<folly::Unit> syncFibImpl(
+      int16_t client, std::vector<UnicastRoute> routes);
+
+  // Routes accumulated by the chunked bulk update calls, keyed by the
+  // client streaming them, until the chunk with isLast set arrives
+  std::mutex chunkedRouteMutex_;
+  std::map<int16_t, std::vector<UnicastRoute>> pendingChunkedAddRoutes_;
+  std::map<int16_t, std::vector<UnicastRoute>> pendingChunkedSyncRoutes_;
+
+  // In-progress paged route table dumps, keyed by the cursor handed to
+  // the client. Each dump pins the immutable SwitchState snapshot it
+  // started from, so pages are served directly from that snapshot
+  // without ever materializing the whole table.
+  struct RouteDumpCursor {
+    std::shared_ptr<SwitchState> state;
+    size_t tableIdx{0};
+    bool v6{false};
+    uint64_t offset{0};
+  };
+  std::mutex routeDumpMutex_;
+  int64_t nextRouteDumpCursor_{1};
+  std::map<int64_t, RouteDumpCursor> routeDumpCursors_;
+
+  // Resume the dump identified by cursor, or start a new one from the
+  // current state when cursor is 0. Shared by getRouteTableChunk() and
+  // getStateSnapshot().
+  RouteDumpCursor resumeRouteDump(int64_t cursor);
+  // Stash an unfinished dump and return the cursor for its next page.
+  int64_t stashRouteDump(RouteDumpCursor pos);
+  // Emit up to maxRoutes resolved routes from pos's snapshot,
+  // advancing pos. Returns true once the snapshot is exhausted.
+  bool emitRouteDumpPage(RouteDumpCursor& pos,
+                         int32_t maxRoutes,
+                         std::vector<UnicastRoute>& routes);
+
+  // In-progress paged L2 table dumps, keyed by cursor. The hardware
+  // table walk runs once per dump on the background thread; later pages
+  // are served from the buffered snapshot.
+  struct L2DumpState {
+    std::vector<L2EntryThrift> entries;
+    size_t offset{0};
+  };
+  std::mutex l2DumpMutex_;
+  int64_t nextL2DumpCursor_{1};
+  std::map<int64_t, L2DumpState> l2DumpCursors_;
+
+  // Emit the next page of dump and, unless it was the last one, park the
+  // remainder under a fresh cursor.
+  L2TableChunk makeL2Chunk(L2DumpState dump, int32_t maxEntries);
+
+  /*
+   * Cache of a response derived purely from a published SwitchState.
+   *
+   * States are immutable once published, so a response computed from one
+   * stays valid for as long as that state is current; the state pointer
+   * itself acts as the version key. Monitoring hits the hot read-only
+   * calls every few seconds from multiple pollers, and between state
+   * updates all of them can be answered from the cached copy. The cached
+   * key is a shared_ptr (not a raw pointer) so a recycled allocation can
+   * never alias a stale entry.
+   */
+  template <typename T>
+  class StateCachedResponse {
+   public:
+    template <typename ComputeFn>
+    std::shared_ptr<const T> get(const std::shared_ptr<SwitchState>& state,
+                                 ComputeFn&& compute) {
+      {
+        auto cached = cache_.rlock();
+        if (cached->first == state) {
+          return cached->second;
+        }
+      }
+      auto response = std::make_shared<const T>(compute(*state));
+      // If another poller raced us here both responses were computed from
+      // immutable states, so last-writer-wins is safe.
+      *cache_.wlock() = std::make_pair(state, response);
+      return response;
+    }
+
+   private:
+    folly::Synchronized<
+        std::pair<std::shared_ptr<SwitchState>, std::shared_ptr<const T>>>
+        cache_;
+  };
+
+  // Manifests and base snapshots for the batched counter export calls
+  CounterDeltaExporter counterExporter_;
+
+  StateCachedResponse<std::map<int32_t, PortInfoThrift>> allPortInfoCache_;
+  StateCachedResponse<std::map<VlanID, Addresses>> vlanAddrsCache_;
+  StateCachedResponse<std::map<VlanID, BinaryAddresses>> vlanBinaryAddrsCache_;
+
   template<typename ADDR_TYPE, typename ADDR_CONVERTER>
   void getVlanAddresses(const Vlan* vlan, std::vector<ADDR_TYPE>& addrs,
-      ADDR_CONVERTER& converter);
+      ADDR_CONVERTER& converter,
+      StateCachedResponse<std::map<VlanID, std::vector<ADDR_TYPE>>>& cache);
   // Forbidden copy constructor and assignment operator
   ThriftHandler(ThriftHandler const &) = delete;
   ThriftHandler& operator=(ThriftHandler const &) = delete;
@@ -12,7 +12,9 @@
 extern "C" {
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <linux/if.h>
 #include <linux/if_tun.h>
@@ -21,12 +23,20 @@ extern "C" {
 
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/SwitchStats.h"
 #include "fboss/agent/SysError.h"
 #include "fboss/agent/TxPacket.h"
 #include "fboss/agent/packet/EthHdr.h"
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventHandler.h>
 
+#include <vector>
+
+DEFINE_int32(tun_tx_ring_depth, 512,
+             "Depth of the per-interface tx ring towards the host. When "
+             "the ring is full further packets to that interface are "
+             "dropped.");
+
 namespace facebook { namespace fboss {
 
 namespace {
@@ -37,6 +47,10 @@ const std::string kTunDev = "/dev/net/tun";
 // Max packets to be processed which are received from host
 const int kMaxSentOneTime = 16;
 
+// Max packets to be written to host per tx wakeup, so that draining a
+// deep tx ring cannot starve the other handlers on the event base
+const int kMaxToHostOneTime = 64;
+
 } // anonymous namespace
 
 TunIntf::TunIntf(
@@ -50,7 +64,9 @@ TunIntf::TunIntf(
       name_(createTunIntfName(ifID)),
       ifID_(ifID),
       ifIndex_(ifIndex),
-      mtu_(mtu) {
+      mtu_(mtu),
+      txQueue_(FLAGS_tun_tx_ring_depth),
+      txWriter_(this, evb) {
   DCHECK(sw) << "NULL pointer to SwSwitch.";
   DCHECK(evb) << "NULL pointer to EventBase";
 
@@ -76,7 +92,9 @@ TunIntf::TunIntf(
       ifID_(ifID),
       status_(status),
       addrs_(addr),
-      mtu_(mtu) {
+      mtu_(mtu),
+      txQueue_(FLAGS_tun_tx_ring_depth),
+      txWriter_(this, evb) {
   DCHECK(sw) << "NULL pointer to SwSwitch.";
   DCHECK(evb) << "NULL pointer to EventBase";
 
@@ -171,6 +189,7 @@ InterfaceID TunIntf::getIDFromTunIntfName(std::string const& ifName) {
 }
 
 void TunIntf::stop() {
+  txWriter_.unregisterHandler();
   unregisterHandler();
 }
 
@@ -178,6 +197,9 @@ void TunIntf::start() {
   if (fd_ != -1 && !isHandlerRegistered()) {
     changeHandlerFD(fd_);
     registerHandler(folly::EventHandler::READ | folly::EventHandler::PERSIST);
+    txWriter_.changeHandlerFD(txEventFd_);
+    txWriter_.registerHandler(
+        folly::EventHandler::READ | folly::EventHandler::PERSIST);
   }
 }
 
@@ -216,10 +238,23 @@ void TunIntf::openFD() {
   sysCheckError(ret, "Failed to set close-on-exec flags ", flags,
                 " to fd ", fd_);
 
+  // The eventfd used by sendPacketToHost() to wake up the tx writer
+  txEventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  sysCheckError(txEventFd_, "Failed to create tx eventfd for interface ",
+                name_);
+
   LOG(INFO) << "Create/attach to tun interface " << name_ << " @ fd " << fd_;
 }
 
 void TunIntf::closeFD() noexcept {
+  if (txEventFd_ != -1) {
+    auto ret = close(txEventFd_);
+    sysLogError(ret, "Failed to close tx eventfd ", txEventFd_,
+                " for interface ", name_);
+    if (ret == 0) {
+      txEventFd_ = -1;
+    }
+  }
   auto ret = close(fd_);
   sysLogError(ret, "Failed to close fd ", fd_, " for interface ", name_);
   if (ret == 0) {
@@ -259,17 +294,32 @@ void TunIntf::setMtu(int mtu) {
   VLOG(3) << "Set tun " << name_ << " MTU to " << mtu;
 }
 
+InterfaceStats* TunIntf::intfStats() {
+  // sw_->stats() is thread local, and this is only called from the
+  // thread serving the evb, so resolving once and caching is safe.
+  if (intfStats_ == nullptr) {
+    intfStats_ = sw_->stats()->intf(ifID_);
+  }
+  return intfStats_;
+}
+
 void TunIntf::handlerReady(uint16_t events) noexcept {
   CHECK(fd_ != -1);
 
   // Since this is L3 packet size, we should also reserve some space for L2
   // header, which is 18 bytes (including one vlan tag)
-  int sent = 0;
   int dropped = 0;
   uint64_t bytes = 0;
   bool fdFail = false;
+  // A tun fd delivers exactly one packet per read() syscall, so there
+  // is no recvmmsg()-style multi-packet read to lean on. Instead we
+  // drain a burst of reads per wakeup and inject the whole batch
+  // through a single SwitchState snapshot in sendL3Packets(), so the
+  // per-packet cost during a host burst is one syscall and little else.
+  std::vector<std::unique_ptr<TxPacket>> batch;
+  batch.reserve(kMaxSentOneTime);
   try {
-    while (sent + dropped < kMaxSentOneTime) {
+    while (static_cast<int>(batch.size()) + dropped < kMaxSentOneTime) {
       std::unique_ptr<TxPacket> pkt;
       pkt = sw_->allocateL3TxPacket(mtu_);
       auto buf = pkt->buf();
@@ -299,8 +349,7 @@ void TunIntf::handlerReady(uint16_t events) noexcept {
       } else {
         bytes += ret;
         buf->append(ret);
-        sw_->sendL3Packet(std::move(pkt), ifID_);
-        ++sent;
+        batch.push_back(std::move(pkt));
       }
     } // while
   } catch (const std::exception& ex) {
@@ -308,6 +357,13 @@ void TunIntf::handlerReady(uint16_t events) noexcept {
                << folly::exceptionStr(ex);
   }
 
+  const auto sent = batch.size();
+  if (!batch.empty()) {
+    sw_->sendL3Packets(std::move(batch), ifID_);
+    // Per-interface accounting, once per batch
+    intfStats()->fromHostBatch(sent, bytes);
+  }
+
   if (fdFail) {
     unregisterHandler();
   }
@@ -319,7 +375,11 @@ void TunIntf::handlerReady(uint16_t events) noexcept {
 
 bool TunIntf::sendPacketToHost(std::unique_ptr<RxPacket> pkt) {
   CHECK(fd_ != -1);
-  const int l2Len = EthHdr::SIZE;
+  // Use the L3 offset the packet handlers annotated while parsing, if
+  // present. It accounts for a VLAN tag in the L2 header; fall back to an
+  // untagged header for packets that never went through the handlers.
+  const uint32_t l2Len =
+      pkt->getL3HdrOffset() != 0 ? pkt->getL3HdrOffset() : EthHdr::SIZE;
 
   auto buf = pkt->buf();
   if (buf->length() <= l2Len) {
@@ -327,25 +387,98 @@ bool TunIntf::sendPacketToHost(std::unique_ptr<RxPacket> pkt) {
     return false;
   }
 
-  // skip L2 header
+  // skip L2 header; we write straight out of the rx buffer, no copy
   buf->trimStart(l2Len);
 
-  int ret = 0;
-  do {
-    ret = write(fd_, buf->data(), buf->length());
-  } while (ret == -1 && errno == EINTR);
-  if (ret < 0) {
-    sysLogError(ret, "Failed to send packet to host from Interface ", ifID_);
-    return false;
-  } else if (ret < buf->length()) {
-    LOG(ERROR) << "Failed to send full packet to host from Interface " << ifID_
-               << ". " << ret << " bytes sent instead of " << buf->length();
+  if (!txQueue_.write(std::move(pkt))) {
+    // The host is reading too slowly and the ring filled up. Drop the
+    // packet rather than blocking the caller; packet handling must never
+    // stall on the host side.
+    sw_->stats()->tunTxRingDrop();
     return false;
   }
 
-  VLOG(4) << "Send packet (" << ret << " bytes) to host from Interface "
-          << ifID_;
+  // Wake up the tx writer on the thread serving the evb
+  uint64_t one = 1;
+  auto ret = write(txEventFd_, &one, sizeof(one));
+  sysLogError(ret, "Failed to signal tx writer for Interface ", ifID_);
   return true;
 }
 
+void TunIntf::TxWriter::handlerReady(uint16_t /*events*/) noexcept {
+  intf_->drainTxQueue();
+}
+
+void TunIntf::drainTxQueue() noexcept {
+  // Clear the wakeup count. Packets enqueued from here on signal the
+  // eventfd again, so nothing can be left sitting in the ring.
+  uint64_t wakeups = 0;
+  auto readRet = read(txEventFd_, &wakeups, sizeof(wakeups));
+  if (readRet < 0 && errno != EAGAIN) {
+    sysLogError(readRet, "Failed to read tx eventfd for Interface ", ifID_);
+  }
+
+  int sent = 0;
+  int dropped = 0;
+  uint64_t bytes = 0;
+  std::unique_ptr<RxPacket> pkt;
+  while (sent + dropped < kMaxToHostOneTime && txQueue_.read(pkt)) {
+    auto buf = pkt->buf();
+    // The tun fd turns every write syscall into one L3 frame, so packets
+    // cannot be coalesced across writes. writev() still lets a chained
+    // buffer go out in a single syscall.
+    iovec iov[16];
+    if (buf->isChained() &&
+        buf->countChainElements() > sizeof(iov) / sizeof(iov[0])) {
+      buf->coalesce();
+    }
+    size_t iovCnt = 0;
+    const folly::IOBuf* cur = buf;
+    do {
+      if (cur->length() > 0) {
+        iov[iovCnt].iov_base = const_cast<uint8_t*>(cur->data());
+        iov[iovCnt].iov_len = cur->length();
+        ++iovCnt;
+      }
+      cur = cur->next();
+    } while (cur != buf);
+    const auto len = buf->computeChainDataLength();
+
+    ssize_t ret = 0;
+    do {
+      ret = writev(fd_, iov, iovCnt);
+    } while (ret == -1 && errno == EINTR);
+    if (ret < 0) {
+      // EAGAIN means the device queue is full. Drop here as well;
+      // retrying would just delay the rest of the ring.
+      sysLogError(ret, "Failed to send packet to host from Interface ", ifID_);
+      ++dropped;
+    } else if (ret < static_cast<ssize_t>(len)) {
+      LOG(ERROR) << "Failed to send full packet to host from Interface "
+                 << ifID_ << ". " << ret << " bytes sent instead of " << len;
+      ++dropped;
+    } else {
+      bytes += ret;
+      ++sent;
+    }
+  }
+
+  if (sent > 0) {
+    // Per-interface accounting, once per batch
+    intfStats()->toHostBatch(sent, bytes);
+  }
+
+  if (!txQueue_.isEmpty()) {
+    // Hit the per-wakeup cap. Re-signal so the event loop serves its
+    // other handlers before we continue draining.
+    uint64_t one = 1;
+    auto ret = write(txEventFd_, &one, sizeof(one));
+    sysLogError(ret, "Failed to re-signal tx writer for Interface ", ifID_);
+  }
+
+  VLOG(4) << "Sent " << sent << " packets (" << bytes
+          << " bytes) to host @ fd " << fd_ << " for interface " << name_
+          << " dropped:" << dropped;
+}
+
 }}  // namespace facebook::fboss
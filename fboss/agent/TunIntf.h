@@ -11,11 +11,13 @@
 
 #include "fboss/agent/types.h"
 #include "fboss/agent/state/Interface.h"
+#include <folly/MPMCQueue.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventHandler.h>
 
 namespace facebook { namespace fboss {
 
+class InterfaceStats;
 class SwSwitch;
 class RxPacket;
 
@@ -95,8 +97,12 @@ class TunIntf : private folly::EventHandler {
    * Unlike other methods, which are called on thread that serves the evb,
    * this function can be called from any thread.
    *
-   * @return true The packet is sent to host
-   *         false The packet is dropped due to errors
+   * The packet is queued on the tx ring and written to the host by the
+   * thread serving the evb, so this never blocks on the host side.
+   *
+   * @return true The packet is queued towards the host
+   *         false The packet is dropped because it is malformed or the
+   *               tx ring is full
    */
   bool sendPacketToHost(std::unique_ptr<RxPacket> pkt);
 
@@ -130,12 +136,33 @@ class TunIntf : private folly::EventHandler {
   }
 
  private:
+  /**
+   * Handler for the tx wakeup eventfd. Fires on the thread serving the
+   * evb whenever sendPacketToHost() queued packets and drains the tx
+   * ring to the Tun interface's fd.
+   */
+  class TxWriter : public folly::EventHandler {
+   public:
+    TxWriter(TunIntf* intf, folly::EventBase* evb)
+        : folly::EventHandler(evb), intf_(intf) {}
+    void handlerReady(uint16_t events) noexcept override;
+
+   private:
+    TunIntf* intf_{nullptr};
+  };
+
   /**
    * Callback for event on Tun interface's read socket-fd
    * Override's folly::EventHandler handlerReady callback.
    */
   void handlerReady(uint16_t events) noexcept override;
 
+  /**
+   * Write packets queued by sendPacketToHost() out to the Tun interface.
+   * Called on the thread that serves the evb.
+   */
+  void drainTxQueue() noexcept;
+
   /**
    * Open/Close a new socket-fd to read/write data from Tun interface.
    * fd_ is mutated.
@@ -143,6 +170,14 @@ class TunIntf : private folly::EventHandler {
   void openFD();
   void closeFD() noexcept;
 
+  /**
+   * Return this interface's stat block, resolving and caching it on
+   * first use. Only called from handlerReady() and drainTxQueue(),
+   * which both run on the thread serving the evb, so the cached
+   * pointer always belongs to that thread's SwitchStats.
+   */
+  InterfaceStats* intfStats();
+
   SwSwitch *sw_{nullptr};
 
   const std::string name_{""};  // The name in the host
@@ -160,6 +195,20 @@ class TunIntf : private folly::EventHandler {
    */
   int fd_{-1};
   int mtu_{-1};
+
+  /**
+   * Ring of packets waiting to be written to the host. Filled by
+   * sendPacketToHost() from any thread and drained by txWriter_ on the
+   * thread serving the evb. When the ring is full further packets are
+   * dropped, so a slow host reader never blocks the packet handling
+   * threads.
+   */
+  folly::MPMCQueue<std::unique_ptr<RxPacket>> txQueue_;
+  int txEventFd_{-1};  // wakes up txWriter_ when txQueue_ becomes non-empty
+  TxWriter txWriter_;
+
+  // Cached per-interface stat block, see intfStats()
+  InterfaceStats* intfStats_{nullptr};
 };
 
 }}  // nanesoace facebook::fboss
@@ -10,6 +10,7 @@
 #include "TunManager.h"
 
 extern "C" {
+#include <netlink/msg.h>
 #include <netlink/route/link.h>
 #include <netlink/route/addr.h>
 #include <netlink/route/route.h>
@@ -18,6 +19,7 @@ extern "C" {
 #include <sys/ioctl.h>
 }
 
+#include "fboss/agent/BootProfiler.h"
 #include "fboss/agent/NlError.h"
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/SysError.h"
@@ -26,6 +28,7 @@ extern "C" {
 #include "fboss/agent/state/InterfaceMap.h"
 #include "fboss/agent/state/Port.h"
 #include "fboss/agent/state/SwitchState.h"
+#include <folly/Conv.h>
 #include <folly/Demangle.h>
 #include <folly/MapUtil.h>
 #include <folly/io/async/EventBase.h>
@@ -64,10 +67,22 @@ TunManager::~TunManager() {
 }
 
 void TunManager::startObservingUpdates() {
-  sw_->registerStateObserver(this, "TunManager");
+  // Interface status is derived from port and VLAN state, so we need those
+  // updates in addition to the interface map itself.
+  sw_->registerStateObserver(this, "TunManager",
+      INTEREST_INTERFACES | INTEREST_PORTS | INTEREST_VLANS);
   observingState_ = true;
 }
 
+void TunManager::startProbe() {
+  evb_->runInEventBaseThread([this]() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!probeDone_) {
+      doProbe(lock);
+    }
+  });
+}
+
 void TunManager::stateUpdated(const StateDelta& delta) {
   // TODO(aeckert): t15067879 We currently compare the entire
   // interface map instead of using the iterator in this delta because
@@ -265,6 +280,51 @@ int TunManager::getInterfaceMtu(InterfaceID ifID) const {
   return interface ? interface->getMtu() : kDefaultMtu;
 }
 
+void TunManager::beginNlBatch() {
+  CHECK(!nlBatching_);
+  CHECK(pendingNlRequests_.empty());
+  nlBatching_ = true;
+}
+
+void TunManager::endNlBatch() {
+  nlBatching_ = false;
+  int failures = 0;
+  for (const auto& description : pendingNlRequests_) {
+    auto error = nl_wait_for_ack(sock_);
+    if (error < 0) {
+      ++failures;
+      LOG(WARNING) << "Failed to " << description
+                   << ": " << nl_geterror(error);
+    }
+  }
+  if (!pendingNlRequests_.empty()) {
+    VLOG(1) << "Collected acks for " << pendingNlRequests_.size()
+            << " batched netlink requests, " << failures << " failed";
+    pendingNlRequests_.clear();
+  }
+}
+
+void TunManager::sendNlRequest(struct nl_msg* msg, bool throwOnError,
+                               std::string description) {
+  SCOPE_EXIT { nlmsg_free(msg); };
+  auto error = nl_send_auto(sock_, msg);
+  // A send failure means the request never made it onto the socket, so
+  // it is an error even within a batch
+  nlCheckError(error, "Failed to send request to ", description);
+  if (nlBatching_) {
+    pendingNlRequests_.push_back(std::move(description));
+    return;
+  }
+  error = nl_wait_for_ack(sock_);
+  if (error < 0) {
+    if (throwOnError) {
+      nlCheckError(error, "Failed to ", description);
+    }
+    LOG(WARNING) << "Failed to " << description
+                 << ": " << nl_geterror(error);
+  }
+}
+
 void TunManager::addRemoveRouteTable(InterfaceID ifID, int ifIndex, bool add) {
   // We just store default routes (one for IPv4 and one for IPv6) in each route
   // table.
@@ -306,25 +366,23 @@ void TunManager::addRemoveRouteTable(InterfaceID ifID, int ifIndex, bool add) {
     rtnl_route_nh_set_ifindex(nexthop, ifIndex);
     rtnl_route_add_nexthop(route, nexthop);
 
+    struct nl_msg* msg{nullptr};
     if (add) {
-      error = rtnl_route_add(sock_, route, NLM_F_REPLACE);
+      error = rtnl_route_build_add_request(route, NLM_F_REPLACE, &msg);
     } else {
-      error = rtnl_route_delete(sock_, route, 0);
+      error = rtnl_route_build_del_request(route, 0, &msg);
     }
+    nlCheckError(error, "Failed to build request for default route ", addr);
     /**
-     * Disable: Because of some weird reason this CHECK fails while deleting
-     * v4 default route. However route actually gets wiped off from Linux
-     * routing table.
-    nlCheckError(error, "Failed to ", add ? "add" : "remove",
-                  " default route ", addr, " @ index ", ifIndex,
-                  " in table ", getTableId(ifID), " for interface ", ifID,
-                  ". ErrorCode: ", error);
-      */
-    if (error < 0) {
-      LOG(WARNING) << "Failed to " << (add ? "add" : "remove")
-                   << " default route " << addr << " @index " << ifIndex
-                   << ". ErrorCode: " << error;
-    }
+     * Errors are tolerated (logged, not thrown) here: for some weird
+     * reason deleting the v4 default route reports a failure even though
+     * the route actually gets wiped off from the Linux routing table.
+     */
+    sendNlRequest(msg, false /* tolerate errors, see above */,
+        folly::to<std::string>(
+          add ? "add" : "remove", " default route ", addr,
+          " @ index ", ifIndex, " in table ", getTableId(ifID),
+          " for interface ", ifID));
     LOG(INFO) << (add ? "Added" : "Removed") << " default route " << addr
               << " @ index " << ifIndex << " in table " << getTableId(ifID)
               << " for interface " << ifID;
@@ -358,15 +416,17 @@ void TunManager::addRemoveSourceRouteRule(
   auto error = rtnl_rule_set_src(rule, sourceaddr);
   nlCheckError(error, "Failed to set destination route to ", addr);
 
+  struct nl_msg* msg{nullptr};
   if (add) {
-    error = rtnl_rule_add(sock_, rule, NLM_F_REPLACE);
+    error = rtnl_rule_build_add_request(rule, NLM_F_REPLACE, &msg);
   } else {
-    error = rtnl_rule_delete(sock_, rule, 0);
+    error = rtnl_rule_build_delete_request(rule, 0, &msg);
   }
-  nlCheckError(error, "Failed to ", add ? "add" : "remove",
-                " rule for address ", addr,
-                " to lookup table ", getTableId(ifID),
-                " for interface ", ifID);
+  nlCheckError(error, "Failed to build rule request for address ", addr);
+  sendNlRequest(msg, true,
+      folly::to<std::string>(
+        add ? "add" : "remove", " rule for address ", addr,
+        " to lookup table ", getTableId(ifID), " for interface ", ifID));
   LOG(INFO) << (add ? "Added" : "Removed") << " rule for address " << addr
             << " to lookup table " << getTableId(ifID)
             << " for interface " << ifID;
@@ -398,6 +458,7 @@ void TunManager::addRemoveTunAddress(
   rtnl_addr_set_prefixlen(tunaddr, mask);
   rtnl_addr_set_ifindex(tunaddr, ifIndex);
 
+  struct nl_msg* msg{nullptr};
   if (add) {
     /**
      * When you bring down interface some routes are purged but some still stay
@@ -406,13 +467,16 @@ void TunManager::addRemoveTunAddress(
      * addresses and routes for that interface with REPLACE flag overriding
      * existing ones if any.
      */
-    error = rtnl_addr_add(sock_, tunaddr, NLM_F_REPLACE);
+    error = rtnl_addr_build_add_request(tunaddr, NLM_F_REPLACE, &msg);
   } else {
-    error = rtnl_addr_delete(sock_, tunaddr, 0);
-  }
-  nlCheckError(error, "Failed to ", add ? "add" : "remove",
-                " address ", addr, "/", static_cast<int>(mask),
-                " to interface ", ifName, " @ index ", ifIndex);
+    error = rtnl_addr_build_delete_request(tunaddr, 0, &msg);
+  }
+  nlCheckError(error, "Failed to build address request for ", addr);
+  sendNlRequest(msg, true,
+      folly::to<std::string>(
+        add ? "add" : "remove", " address ", addr, "/",
+        static_cast<int>(mask), " to interface ", ifName,
+        " @ index ", ifIndex));
   LOG(INFO) << (add ? "Added" : "Removed") << " address " << addr.str() << "/"
             << static_cast<int>(mask) << " on interface " << ifName
             << " @ index " << ifIndex;
@@ -599,6 +663,7 @@ void TunManager::forceInitialSync() {
 
 void TunManager::sync(std::shared_ptr<SwitchState> state) {
   CHECK(evb_->isInEventBaseThread());
+  BootProfiler::Phase phase("TunManager::sync");
   using Addresses = Interface::Addresses;
   using ConstAddressesIter = Addresses::const_iterator;
   using IntfInfo = std::pair<bool /* status */, Addresses>;
@@ -667,6 +732,13 @@ void TunManager::sync(std::shared_ptr<SwitchState> state) {
         });
   };
 
+  // Pipeline all netlink requests issued while applying the changes and
+  // collect their acks in one go at the end. The SCOPE_EXIT makes sure
+  // pending acks are drained even if applying changes throws; the
+  // explicit endNlBatch() below is then a no-op.
+  beginNlBatch();
+  SCOPE_EXIT { endNlBatch(); };
+
   // Apply changes for all interfaces
   applyChanges(
       oldIntfToInfo, newIntfToInfo,
@@ -716,6 +788,10 @@ void TunManager::sync(std::shared_ptr<SwitchState> state) {
         removeIntf(oldIter->first);
       });
 
+  // Collect the acks for all the pipelined requests before declaring the
+  // interfaces ready
+  endNlBatch();
+
   start();
 
   // track number of times sync is called
@@ -14,6 +14,9 @@
 #include "fboss/agent/state/Interface.h"
 #include <folly/io/async/EventBase.h>
 
+#include <string>
+#include <vector>
+
 #include <boost/container/flat_map.hpp>
 
 extern "C" {
@@ -64,6 +67,19 @@ class TunManager : public StateObserver {
 
   void forceInitialSync();
 
+  /**
+   * Kick off the initial probe of kernel TUN interface state on the
+   * event base thread, without waiting for it to finish.
+   *
+   * The probe is otherwise performed lazily by the first sync(), which
+   * sits on the critical path between applying the initial config and
+   * restoring host connectivity.  Calling this early in initialization
+   * overlaps the netlink dump with the rest of agent startup; sync()
+   * still checks probeDone_ under the lock, so there is no race with a
+   * probe that has not finished by then.
+   */
+  void startProbe();
+
   /**
    * This should be called externally only after initial sync has been
    * performed.
@@ -138,6 +154,29 @@ class TunManager : public StateObserver {
       const folly::IPAddress& addr,
       bool add);
 
+  /**
+   * Netlink request batching.
+   *
+   * The rtnl_*_add/delete convenience APIs send one request and block for
+   * the kernel's ack before sending the next, costing a round-trip per
+   * address, source routing rule, and route during a sync. Between
+   * beginNlBatch() and endNlBatch() requests are instead pipelined over
+   * the socket and all acks are collected at the end, so a full sync
+   * boils down to a handful of syscalls.
+   */
+  void beginNlBatch();
+  void endNlBatch();
+
+  /**
+   * Send a netlink request built with one of the rtnl_*_build_*_request
+   * APIs. Takes ownership of the message. Outside of a batch this waits
+   * for the kernel's ack, throwing on failure if throwOnError and logging
+   * otherwise. In a batch the ack is collected in endNlBatch(); since the
+   * request has long been sent by then, failures are always just logged.
+   */
+  void sendNlRequest(struct nl_msg* msg, bool throwOnError,
+                     std::string description);
+
   /**
    * Add/Remove an address to/from a TUN interface on the host
    */
@@ -223,6 +262,12 @@ class TunManager : public StateObserver {
   // Initial probe done
   bool probeDone_{false};
 
+  // Whether netlink requests are currently being batched, and the
+  // descriptions of the pipelined requests in send order; the kernel acks
+  // them in the same order.
+  bool nlBatching_{false};
+  std::vector<std::string> pendingNlRequests_;
+
   uint64_t numSyncs_{0};
 
   enum : uint8_t {
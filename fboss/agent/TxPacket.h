@@ -20,6 +20,28 @@ namespace facebook { namespace fboss {
  */
 class TxPacket : public Packet {
  public:
+  /*
+   * Checksum computations a hardware TX path may be able to perform on
+   * behalf of the CPU when the packet is transmitted.
+   */
+  enum CsumOffload : uint8_t {
+    CSUM_OFFLOAD_L3 = 0x01, // IPv4 header checksum
+    CSUM_OFFLOAD_L4 = 0x02, // TCP/UDP/ICMP checksum
+  };
+
+  /**
+   * Request that the hardware compute the specified checksums when this
+   * packet is transmitted.
+   *
+   * Returns the subset of the requested CsumOffload flags that the
+   * underlying TX path will actually honor. The caller must compute any
+   * checksums not covered by the return value in software before sending
+   * the packet. The base implementation supports no offloads.
+   */
+  virtual uint8_t enableCsumOffload(uint8_t /* flags */) {
+    return 0;
+  }
+
   /**
    * Write an ethernet header at the specified cursor location.
    *
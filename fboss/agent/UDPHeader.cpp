@@ -90,6 +90,40 @@ void UDPHeader::updateChecksum(const IPv6Hdr& ipv6Hdr, const Cursor& cursor) {
   csum = computeChecksum(ipv6Hdr, cursor);
 }
 
+void UDPHeader::patchChecksum(uint16_t oldWord, uint16_t newWord) {
+  if (csum == 0) {
+    // The sender didn't compute a checksum; nothing to patch.
+    return;
+  }
+  // RFC 1624 eqn. 3: HC' = ~(~HC + ~m + m')
+  uint32_t sum = static_cast<uint16_t>(~csum);
+  sum += static_cast<uint16_t>(~oldWord);
+  sum += newWord;
+  while (sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  uint16_t cs = ~static_cast<uint16_t>(sum);
+  // A 0 checksum should be transmitted as all ones
+  csum = (cs == 0) ? 0xffff : cs;
+}
+
+void UDPHeader::patchChecksum(folly::IPAddressV4 oldAddr,
+                              folly::IPAddressV4 newAddr) {
+  uint32_t oldIp = oldAddr.toLongHBO();
+  uint32_t newIp = newAddr.toLongHBO();
+  patchChecksum(static_cast<uint16_t>(oldIp >> 16),
+                static_cast<uint16_t>(newIp >> 16));
+  patchChecksum(static_cast<uint16_t>(oldIp & 0xffff),
+                static_cast<uint16_t>(newIp & 0xffff));
+}
+
+void UDPHeader::patchChecksumPartial(uint32_t oldSum, uint32_t newSum) {
+  // finalizeChecksum() folds and complements; complement again to get
+  // the folded 16-bit sums of the old and new blocks.
+  patchChecksum(static_cast<uint16_t>(~PktUtil::finalizeChecksum(oldSum)),
+                static_cast<uint16_t>(~PktUtil::finalizeChecksum(newSum)));
+}
+
 string UDPHeader::toString() const {
   stringstream ss;
   ss << " Length: " << length
@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include <folly/IPAddressV4.h>
+
 #include "fboss/agent/types.h"
 #include "fboss/agent/Utils.h"
 #include "fboss/agent/packet/IPv6Hdr.h"
@@ -55,6 +57,32 @@ struct UDPHeader {
                            const folly::io::Cursor& cursor) const;
   void updateChecksum(const IPv6Hdr& ipv6Hdr, const folly::io::Cursor& cursor);
 
+  /*
+   * RFC 1624 incremental checksum update.
+   *
+   * Adjust the existing checksum to reflect a single 16-bit word of the
+   * datagram (or its pseudo-header) changing from oldWord to newWord,
+   * without re-checksumming the rest of the payload. Words are in host
+   * byte order, matching computeChecksum(). A checksum of 0 means the
+   * sender did not compute one, so there is nothing to patch and the
+   * call is a no-op.
+   */
+  void patchChecksum(uint16_t oldWord, uint16_t newWord);
+  /*
+   * Patch for an IPv4 address changing, e.g. in the pseudo-header or in
+   * the payload of a relayed packet. The address must start on an even
+   * offset within the datagram.
+   */
+  void patchChecksum(folly::IPAddressV4 oldAddr, folly::IPAddressV4 newAddr);
+  /*
+   * Patch for a block of the payload being replaced. oldSum and newSum
+   * are unfolded partial sums over the old and new bytes, as returned by
+   * PktUtil::partialChecksum()/checksumFast(). Both blocks must start on
+   * an even offset within the datagram; an odd-length block is only
+   * valid at the end of the payload.
+   */
+  void patchChecksumPartial(uint32_t oldSum, uint32_t newSum);
+
   uint16_t srcPort;
   uint16_t dstPort;
   uint16_t length;
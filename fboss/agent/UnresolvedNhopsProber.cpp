@@ -19,51 +19,112 @@
 #include "fboss/agent/ArpHandler.h"
 #include "fboss/agent/IPv6Handler.h"
 
+#include <algorithm>
+#include <limits>
+
+DEFINE_int32(max_unresolved_nhop_probes, 256,
+    "Maximum number of ARP/NDP probes for unresolved next hops to send "
+    "per probe interval. Remaining next hops are picked up round robin "
+    "in subsequent intervals. 0 means no limit");
+
 namespace facebook { namespace fboss {
 
-void UnresolvedNhopsProber::timeoutExpired() noexcept {
+void UnresolvedNhopsProber::probeUnresolvedNhops() {
   std::lock_guard<std::mutex> g(lock_);
   auto state = sw_->getState();
+  // Snapshot the (router, next hop) keys together with their route
+  // reference counts. The map only covers the directly attached
+  // neighbor set, so this stays small.
+  std::vector<std::pair<std::pair<RouterID, Nexthop>, int64_t>> nhops;
   for (const auto& ridAndNhopsRefCounts : nhops2RouteCount_) {
     for (const auto& nhopAndRefCount : ridAndNhopsRefCounts.second) {
-      const auto& nhop = nhopAndRefCount.first;
-      auto intf = state->getInterfaces()->getInterfaceIf(nhop.intf);
-      if (!intf) {
-        continue; // interface got unconfigured
-      }
-      // Probe all nexthops for which either don't have a L2 entry
-      // or the entry is not resolved (port == 0). Note that we do
-      // not exclude pending entries here since in case of recursive
-      // routes we might get packets with destination set to prefix
-      // that needs to be resolved recursively. In ARP and NDP code
-      // we do not do route lookup when deciding to send ARP/NDP requests.
-      // So we would only try to ARP/NDP for the destination if it
-      // is in one of the interface subnets (which it won't be else
-      // we won't have needed recursive resolution). So ARP/NDP for
-      // all unresolved next hops. We could also consider doing route
-      // lookups in ARP/NDP code, but by probing all unresolved next
-      // hops we effectively do the same thing, since the next hops
-      // probed come from after the route was (recursively) resolved.
-      auto vlan = state->getVlans()->getVlanIf(intf->getVlanID());
-      CHECK(vlan); // must have vlan for configrued inteface
-      if (nhop.nexthop.isV4()) {
-        auto nhop4 = nhop.nexthop.asV4();
-        auto arpEntry = vlan->getArpTable()->getEntryIf(nhop4);
-        if (!arpEntry || arpEntry->getPort() == 0) {
-          VLOG(3) <<" Sending probe for unresolved next hop: " << nhop4;
-          ArpHandler::sendArpRequest(sw_, vlan, nhop4);
-        }
-      } else {
-        auto nhop6 = nhop.nexthop.asV6();
-        auto ndpEntry = vlan->getNdpTable()->getEntryIf(nhop6);
-        if (!ndpEntry || ndpEntry->getPort() == 0) {
-          VLOG(3) <<" Sending probe for unresolved next hop: " << nhop6;
-          IPv6Handler::sendNeighborSolicitation(sw_, nhop6, vlan);
-        }
-      }
+      nhops.emplace_back(
+          std::make_pair(ridAndNhopsRefCounts.first, nhopAndRefCount.first),
+          nhopAndRefCount.second);
+    }
+  }
+  if (nhops.empty()) {
+    return;
+  }
+  // Heaviest first: a next hop referenced by thousands of routes restores
+  // far more dataplane capacity when it resolves than one referenced by a
+  // handful, so after a port event the heavy ones should get the first
+  // slots of the probe budget. Stable sort keeps ties in map order so the
+  // probe order is deterministic.
+  std::stable_sort(nhops.begin(), nhops.end(),
+                   [](const auto& lhs, const auto& rhs) {
+                     return lhs.second > rhs.second;
+                   });
+  size_t start = 0;
+  if (lastRoundExhausted_ && resumeFrom_) {
+    // The previous round ran out of budget. Resume after where it
+    // stopped (positionally, in weight order) so persistently
+    // unresolvable heavy next hops cannot starve the tail of the list.
+    // Rounds that finish under budget probe every unresolved entry
+    // anyway, so they always restart from the heaviest.
+    auto itr = std::find_if(nhops.begin(), nhops.end(),
+                            [&](const auto& entry) {
+                              return entry.first == *resumeFrom_;
+                            });
+    if (itr != nhops.end() && ++itr != nhops.end()) {
+      start = std::distance(nhops.begin(), itr);
+    }
+  }
+  // Pace the solicitations: with a flapping uplink a large portion of the
+  // next hops can become unresolved at once, and probing them all inline
+  // would burst a packet per next hop every interval.
+  const uint32_t maxProbes = FLAGS_max_unresolved_nhop_probes > 0 ?
+      FLAGS_max_unresolved_nhop_probes : std::numeric_limits<uint32_t>::max();
+  uint32_t sent = 0;
+  for (size_t i = 0; i < nhops.size() && sent < maxProbes; ++i) {
+    const auto& ridAndNhop = nhops[(start + i) % nhops.size()].first;
+    if (probeIfUnresolved(state, ridAndNhop.second)) {
+      ++sent;
+      resumeFrom_ = ridAndNhop;
+    }
+  }
+  lastRoundExhausted_ = (sent >= maxProbes);
+}
+
+bool UnresolvedNhopsProber::probeIfUnresolved(
+    const std::shared_ptr<SwitchState>& state, const Nexthop& nhop) {
+  auto intf = state->getInterfaces()->getInterfaceIf(nhop.intf);
+  if (!intf) {
+    return false; // interface got unconfigured
+  }
+  // Probe all nexthops for which either don't have a L2 entry
+  // or the entry is not resolved (port == 0). Note that we do
+  // not exclude pending entries here since in case of recursive
+  // routes we might get packets with destination set to prefix
+  // that needs to be resolved recursively. In ARP and NDP code
+  // we do not do route lookup when deciding to send ARP/NDP requests.
+  // So we would only try to ARP/NDP for the destination if it
+  // is in one of the interface subnets (which it won't be else
+  // we won't have needed recursive resolution). So ARP/NDP for
+  // all unresolved next hops. We could also consider doing route
+  // lookups in ARP/NDP code, but by probing all unresolved next
+  // hops we effectively do the same thing, since the next hops
+  // probed come from after the route was (recursively) resolved.
+  auto vlan = state->getVlans()->getVlanIf(intf->getVlanID());
+  CHECK(vlan); // must have vlan for configrued inteface
+  if (nhop.nexthop.isV4()) {
+    auto nhop4 = nhop.nexthop.asV4();
+    auto arpEntry = vlan->getArpTable()->getEntryIf(nhop4);
+    if (!arpEntry || arpEntry->getPort() == 0) {
+      VLOG(3) <<" Sending probe for unresolved next hop: " << nhop4;
+      ArpHandler::sendArpRequest(sw_, vlan, nhop4);
+      return true;
+    }
+  } else {
+    auto nhop6 = nhop.nexthop.asV6();
+    auto ndpEntry = vlan->getNdpTable()->getEntryIf(nhop6);
+    if (!ndpEntry || ndpEntry->getPort() == 0) {
+      VLOG(3) <<" Sending probe for unresolved next hop: " << nhop6;
+      IPv6Handler::sendNeighborSolicitation(sw_, nhop6, vlan);
+      return true;
     }
   }
-  scheduleTimeout(interval_);
+  return false;
 }
 
 }} // facebook::fboss
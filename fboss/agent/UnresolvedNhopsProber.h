@@ -10,36 +10,37 @@
 #pragma once
 
 #include "fboss/agent/NexthopToRouteCount.h"
+#include "fboss/agent/PeriodicScheduler.h"
 #include "fboss/agent/StateObserver.h"
+#include "fboss/agent/SwSwitch.h"
+
+#include <folly/Optional.h>
 
 namespace facebook { namespace fboss {
 
-class SwSwitch;
 class StateDelta;
+class SwitchState;
 
-class UnresolvedNhopsProber : private folly::AsyncTimeout,
-                              public AutoRegisterStateObserver {
+class UnresolvedNhopsProber : public AutoRegisterStateObserver {
  public:
   explicit UnresolvedNhopsProber(SwSwitch *sw) :
-      AsyncTimeout(sw->getBackgroundEVB()),
-      AutoRegisterStateObserver(sw, "UnresolvedNhopsProber"),
-      sw_(sw),
-      // Probe every 5 secs (make it faster ?)
-      interval_(5) {
-    start();
+      AutoRegisterStateObserver(sw, "UnresolvedNhopsProber",
+                                INTEREST_ROUTE_TABLES),
+      sw_(sw) {
+    // Probing is best-effort maintenance, so the periodic round runs
+    // as a LOW tier task and may be pushed back when a tick overruns
+    // its budget.
+    sw_->getPeriodicScheduler()->addTask(
+        "unresolved_nhops_prober", PeriodicScheduler::Tier::LOW,
+        // Probe every 5 secs (make it faster ?)
+        std::chrono::seconds(5),
+        [this]() {
+          probeUnresolvedNhops();
+        });
   }
 
   ~UnresolvedNhopsProber() {
-    sw_->getBackgroundEVB()->runImmediatelyOrRunInEventBaseThreadAndWait(
-      [this]() {
-        cancelTimeout();
-      });
-  }
-
-  void start() {
-    sw_->getBackgroundEVB()->runInEventBaseThread([this]() {
-      scheduleTimeout(interval_);
-    });
+    sw_->getPeriodicScheduler()->removeTask("unresolved_nhops_prober");
   }
 
   void stateUpdated(const StateDelta& delta) override {
@@ -47,15 +48,29 @@ class UnresolvedNhopsProber : private folly::AsyncTimeout,
     nhops2RouteCount_.stateChanged(delta);
   }
 
-  void timeoutExpired() noexcept override;
-
  private:
+  using Nexthop = NexthopToRouteCount::Nexthop;
+
+  // Run one probe round; called periodically by the PeriodicScheduler.
+  void probeUnresolvedNhops();
+
+  // Send a probe for the next hop if it has no resolved L2 entry.
+  // Returns whether a probe was sent.
+  bool probeIfUnresolved(
+      const std::shared_ptr<SwitchState>& state, const Nexthop& nhop);
+
   // Need lock since we may get called from both the update
-  // thread (stateChanged) and background thread (timeoutExpired)
+  // thread (stateChanged) and background thread (the probe round)
   std::mutex lock_;
   SwSwitch* sw_{nullptr};
   NexthopToRouteCount nhops2RouteCount_;
-  std::chrono::seconds interval_{0};
+  // Where the last paced probe round stopped. Probe rounds walk the
+  // next hops in route-reference-count order (heaviest first); when a
+  // round exhausts its probe budget the next one resumes after this
+  // entry so the tail of the list is not starved.
+  folly::Optional<std::pair<RouterID, Nexthop>> resumeFrom_;
+  // Did the last probe round use up its entire probe budget?
+  bool lastRoundExhausted_{false};
 };
 
 }} // facebook::fboss
@@ -0,0 +1,294 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/UpdateJournal.h"
+
+#include "fboss/agent/SysError.h"
+#include "fboss/agent/state/DeltaFunctions.h"
+#include "fboss/agent/state/NodeMapDelta.h"
+#include "fboss/agent/state/NodeMapDelta-defs.h"
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/StateDelta.h"
+
+#include <folly/Checksum.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+using std::shared_ptr;
+
+DEFINE_int32(update_journal_sync_ms, 100,
+             "How often to msync the update journal mapping to disk.  An "
+             "agent crash loses nothing either way (the dirty pages stay "
+             "in the page cache); this only bounds the loss window for a "
+             "whole-box crash.  0 leaves writeback entirely to the kernel");
+
+namespace {
+
+constexpr uint64_t kFileMagic = 0x4c4e4a53534f4246ULL;  // "FBOSSJNL"
+constexpr uint32_t kFileVersion = 1;
+constexpr uint32_t kRecordMagic = 0x4c4e524aU;          // "JRNL"
+// The file header lives in its own page in front of the ring.
+constexpr uint64_t kHeaderBytes = 4096;
+
+template <typename RouteT>
+void appendRouteEntry(facebook::fboss::state::JournalRecord& record,
+                      facebook::fboss::RouterID rid,
+                      const shared_ptr<RouteT>& oldRoute,
+                      const shared_ptr<RouteT>& newRoute) {
+  auto oldFields = oldRoute ? oldRoute->toThrift()
+                            : facebook::fboss::state::RouteFields();
+  auto newFields = newRoute ? newRoute->toThrift()
+                            : facebook::fboss::state::RouteFields();
+  if (oldRoute && newRoute &&
+      oldFields.nexthopsMulti == newFields.nexthopsMulti) {
+    // Only flags or resolved forwarding changed.  Replay recomputes
+    // resolution from the client next hops, so there is nothing to
+    // journal for this route.
+    return;
+  }
+  facebook::fboss::state::JournalRouteEntry entry;
+  entry.routerId = rid;
+  entry.prefix = newRoute ? newFields.prefix : oldFields.prefix;
+  for (const auto& clientNhs : oldFields.nexthopsMulti) {
+    entry.removedClients.push_back(clientNhs.clientId);
+  }
+  entry.nexthopsMulti = std::move(newFields.nexthopsMulti);
+  record.routes.push_back(std::move(entry));
+}
+
+} // unnamed namespace
+
+namespace facebook { namespace fboss {
+
+UpdateJournal::UpdateJournal(folly::StringPiece path, uint64_t ringBytes)
+    : path_(path.str()),
+      ringBytes_(ringBytes) {
+  CHECK_GT(ringBytes_, 0);
+  fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw SysError(errno, "failed to open update journal ", path_);
+  }
+  mapBytes_ = kHeaderBytes + ringBytes_;
+  struct stat st;
+  if (::fstat(fd_, &st) != 0) {
+    throw SysError(errno, "failed to stat update journal ", path_);
+  }
+  bool fresh = (static_cast<uint64_t>(st.st_size) != mapBytes_);
+  if (fresh && ::ftruncate(fd_, mapBytes_) != 0) {
+    throw SysError(errno, "failed to size update journal ", path_);
+  }
+  auto* addr = ::mmap(nullptr, mapBytes_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd_, 0);
+  if (addr == MAP_FAILED) {
+    throw SysError(errno, "failed to map update journal ", path_);
+  }
+  map_ = static_cast<uint8_t*>(addr);
+  header_ = reinterpret_cast<FileHeader*>(map_);
+  ring_ = map_ + kHeaderBytes;
+  if (fresh || header_->magic != kFileMagic ||
+      header_->version != kFileVersion ||
+      header_->ringBytes != ringBytes_) {
+    // New file, or one whose layout we cannot reuse: start the journal
+    // over.  The ring itself is left as is; recovery validates frames
+    // by checksum, so stale bytes are harmless.
+    std::memset(header_, 0, sizeof(FileHeader));
+    header_->magic = kFileMagic;
+    header_->version = kFileVersion;
+    header_->ringBytes = ringBytes_;
+    header_->writePos = 0;
+    header_->nextSeq = 1;
+    LOG(INFO) << "initialized update journal " << path_ << " ("
+      << ringBytes_ << " byte ring)";
+  } else {
+    LOG(INFO) << "reopened update journal " << path_ << " at sequence "
+      << header_->nextSeq;
+  }
+  lastSync_ = std::chrono::steady_clock::now();
+}
+
+UpdateJournal::~UpdateJournal() {
+  if (map_) {
+    ::msync(map_, mapBytes_, MS_ASYNC);
+    ::munmap(map_, mapBytes_);
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+void UpdateJournal::writeToRing(uint64_t pos, const void* data,
+                                uint64_t len) {
+  pos %= ringBytes_;
+  auto first = std::min(len, ringBytes_ - pos);
+  std::memcpy(ring_ + pos, data, first);
+  if (first < len) {
+    std::memcpy(ring_, static_cast<const uint8_t*>(data) + first,
+                len - first);
+  }
+}
+
+void UpdateJournal::readFromRing(uint64_t pos, void* data,
+                                 uint64_t len) const {
+  pos %= ringBytes_;
+  auto first = std::min(len, ringBytes_ - pos);
+  std::memcpy(data, ring_ + pos, first);
+  if (first < len) {
+    std::memcpy(static_cast<uint8_t*>(data) + first, ring_, len - first);
+  }
+}
+
+uint64_t UpdateJournal::currentSequence() const {
+  // nextSeq is the sequence the next append() will stamp; the last
+  // record actually written is one behind it (0 when the journal is
+  // still empty).
+  return header_->nextSeq - 1;
+}
+
+void UpdateJournal::append(const StateDelta& delta) {
+  state::JournalRecord record;
+  for (const auto& rtDelta : delta.getRouteTablesDelta()) {
+    auto rid = rtDelta.getNew() ? rtDelta.getNew()->getID()
+                                : rtDelta.getOld()->getID();
+    DeltaFunctions::forEachChanged(
+        rtDelta.getRoutesV4Delta(),
+        [&](const shared_ptr<RouteV4>& oldRoute,
+            const shared_ptr<RouteV4>& newRoute) {
+          appendRouteEntry(record, rid, oldRoute, newRoute);
+        },
+        [&](const shared_ptr<RouteV4>& newRoute) {
+          appendRouteEntry(record, rid, shared_ptr<RouteV4>(), newRoute);
+        },
+        [&](const shared_ptr<RouteV4>& oldRoute) {
+          appendRouteEntry(record, rid, oldRoute, shared_ptr<RouteV4>());
+        });
+    DeltaFunctions::forEachChanged(
+        rtDelta.getRoutesV6Delta(),
+        [&](const shared_ptr<RouteV6>& oldRoute,
+            const shared_ptr<RouteV6>& newRoute) {
+          appendRouteEntry(record, rid, oldRoute, newRoute);
+        },
+        [&](const shared_ptr<RouteV6>& newRoute) {
+          appendRouteEntry(record, rid, shared_ptr<RouteV6>(), newRoute);
+        },
+        [&](const shared_ptr<RouteV6>& oldRoute) {
+          appendRouteEntry(record, rid, oldRoute, shared_ptr<RouteV6>());
+        });
+  }
+  if (record.routes.empty()) {
+    return;
+  }
+  record.sequence = header_->nextSeq;
+  record.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  std::string payload;
+  apache::thrift::CompactSerializer::serialize(record, &payload);
+  uint64_t frameBytes = sizeof(RecordHeader) + payload.size();
+  if (frameBytes > ringBytes_) {
+    // The record cannot fit at all; consume the sequence number anyway
+    // so recovery sees the gap and does not replay older records over
+    // a state that is missing these changes.
+    LOG(ERROR) << "update journal record of " << payload.size()
+      << " bytes does not fit the " << ringBytes_ << " byte ring; "
+      "recovery will only reach back to this point";
+    ++header_->nextSeq;
+    return;
+  }
+  RecordHeader rh;
+  rh.magic = kRecordMagic;
+  rh.length = payload.size();
+  rh.sequence = record.sequence;
+  rh.checksum = folly::crc32c(
+      reinterpret_cast<const uint8_t*>(payload.data()), payload.size());
+  // Write the whole frame before bumping the header, so a crash in the
+  // middle leaves the old header and the torn frame is simply never
+  // committed.
+  writeToRing(header_->writePos, &rh, sizeof(rh));
+  writeToRing(header_->writePos + sizeof(rh), payload.data(), payload.size());
+  header_->writePos = (header_->writePos + frameBytes) % ringBytes_;
+  ++header_->nextSeq;
+  maybeSync();
+}
+
+void UpdateJournal::maybeSync() {
+  if (FLAGS_update_journal_sync_ms <= 0) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (now - lastSync_ <
+      std::chrono::milliseconds(FLAGS_update_journal_sync_ms)) {
+    return;
+  }
+  lastSync_ = now;
+  ::msync(map_, mapBytes_, MS_ASYNC);
+}
+
+std::vector<state::JournalRecord> UpdateJournal::recover() const {
+  // Scan the ring for valid frames, oldest region first.  Frames whose
+  // bytes were partially overwritten by newer appends fail the
+  // checksum and are skipped; the scan just resumes at the next byte.
+  std::map<uint64_t, state::JournalRecord> bySeq;
+  uint64_t pos = header_->writePos;
+  uint64_t scanned = 0;
+  while (scanned < ringBytes_) {
+    RecordHeader rh;
+    readFromRing(pos, &rh, sizeof(rh));
+    if (rh.magic != kRecordMagic ||
+        rh.length > ringBytes_ - sizeof(RecordHeader) ||
+        rh.sequence == 0 || rh.sequence >= header_->nextSeq) {
+      ++pos;
+      ++scanned;
+      continue;
+    }
+    std::string payload(rh.length, '\0');
+    readFromRing(pos + sizeof(rh), &payload[0], rh.length);
+    if (folly::crc32c(reinterpret_cast<const uint8_t*>(payload.data()),
+                      payload.size()) != rh.checksum) {
+      ++pos;
+      ++scanned;
+      continue;
+    }
+    state::JournalRecord record;
+    try {
+      apache::thrift::CompactSerializer::deserialize(payload, record);
+    } catch (const std::exception& ex) {
+      ++pos;
+      ++scanned;
+      continue;
+    }
+    bySeq[rh.sequence] = std::move(record);
+    auto frameBytes = sizeof(RecordHeader) + rh.length;
+    pos += frameBytes;
+    scanned += frameBytes;
+  }
+  // Keep only the run of consecutive sequence numbers ending at the
+  // newest record: a hole means an overwritten (or never written)
+  // record, and replaying across it would resurrect stale state.
+  std::vector<state::JournalRecord> records;
+  if (bySeq.empty()) {
+    return records;
+  }
+  auto itr = bySeq.rbegin();
+  uint64_t expected = itr->first;
+  for (; itr != bySeq.rend() && itr->first == expected; ++itr, --expected) {
+    records.push_back(std::move(itr->second));
+  }
+  std::reverse(records.begin(), records.end());
+  return records;
+}
+
+}} // facebook::fboss
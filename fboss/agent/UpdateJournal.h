@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/agent/state/gen-cpp2/switch_state_types.h"
+
+#include <folly/Range.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+class StateDelta;
+
+/*
+ * An always-on journal of applied state updates, for crash-consistent
+ * fast restart.
+ *
+ * Graceful exit saves warm boot state, but a crash loses everything
+ * and forces the slow path: cold boot plus a full resync from the
+ * route server.  The journal closes that gap: every applied
+ * StateDelta's route changes are appended as a compact binary record
+ * to a memory-mapped ring file, and crash recovery replays the
+ * records newer than the last FIB snapshot over that snapshot,
+ * bringing the recovered FIB close to warm boot freshness.
+ *
+ * The ring is memory-mapped and only msync'd lazily
+ * (--update_journal_sync_ms): an agent crash cannot lose appended
+ * records anyway, since the dirty pages stay in the kernel's page
+ * cache; the lazy sync only bounds the loss window for a whole-box
+ * crash.  Appends happen on the update thread only (single writer),
+ * so the write path takes no locks - it is a couple of memcpys into
+ * the mapping plus the header bump.
+ *
+ * Record framing in the ring: a fixed RecordHeader (magic, payload
+ * length, sequence, payload checksum) followed by the
+ * compact-serialized state::JournalRecord.  Records wrap around the
+ * ring and overwrite the oldest ones; recovery scans the ring for
+ * valid frames and keeps the run of consecutive sequence numbers
+ * ending at the newest record, so a torn or overwritten frame simply
+ * bounds how far back replay can reach.
+ */
+class UpdateJournal {
+ public:
+  /*
+   * Open the journal ring file, creating or resizing it as needed.
+   * Throws FbossError if the file cannot be mapped.
+   */
+  UpdateJournal(folly::StringPiece path, uint64_t ringBytes);
+  ~UpdateJournal();
+
+  /*
+   * Return the records that survived from the previous run, in
+   * sequence order.  Call once, right after construction, before the
+   * first append() starts reusing the ring.
+   */
+  std::vector<state::JournalRecord> recover() const;
+
+  /*
+   * Append one applied update's route changes.  No-op when the delta
+   * contains no client next hop changes (most updates).  Must only be
+   * called from the update thread.
+   */
+  void append(const StateDelta& delta);
+
+  /*
+   * The sequence number of the last record written, or 0 if nothing
+   * has been appended yet.  FIB snapshots store this so crash
+   * recovery knows which journal records the snapshot already covers;
+   * replay resumes at the next sequence.  Read it from the update
+   * thread (or otherwise ordered against append()) so the value is
+   * consistent with the state being snapshotted.
+   */
+  uint64_t currentSequence() const;
+
+ private:
+  struct FileHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t unused;
+    uint64_t ringBytes;
+    uint64_t writePos;   // ring offset of the next record
+    uint64_t nextSeq;
+  };
+  struct RecordHeader {
+    uint32_t magic;
+    uint32_t length;     // payload bytes, not counting this header
+    uint64_t sequence;
+    uint32_t checksum;   // crc32c of the payload
+  };
+
+  // Forbidden copy constructor and assignment operator
+  UpdateJournal(UpdateJournal const &) = delete;
+  UpdateJournal& operator=(UpdateJournal const &) = delete;
+
+  // Copy len bytes into the ring at offset pos, wrapping as needed.
+  void writeToRing(uint64_t pos, const void* data, uint64_t len);
+  // Read len bytes from the ring at offset pos, wrapping as needed.
+  void readFromRing(uint64_t pos, void* data, uint64_t len) const;
+  void maybeSync();
+
+  const std::string path_;
+  int fd_{-1};
+  uint8_t* map_{nullptr};
+  uint64_t mapBytes_{0};
+  FileHeader* header_{nullptr};
+  uint8_t* ring_{nullptr};
+  uint64_t ringBytes_{0};
+  std::chrono::steady_clock::time_point lastSync_;
+};
+
+}} // facebook::fboss
@@ -14,6 +14,8 @@
 #include <folly/Exception.h>
 #include <folly/FileUtil.h>
 
+#include <unistd.h>
+
 #include <chrono>
 
 using folly::IOBuf;
@@ -75,25 +77,31 @@ void PcapFile::writeGlobalHeader() {
   folly::checkUnixError(ret, "error writing pcap global header");
 }
 
-void PcapFile::writePackets(const std::vector<PcapPkt>& pkts) {
-  folly::fbvector<PktHeader> hdrs;
-  hdrs.reserve(pkts.size());
-  folly::fbvector<struct iovec> iov;
+uint64_t PcapFile::writePackets(const std::vector<PcapPkt>& pkts) {
+  hdrs_.clear();
+  hdrs_.reserve(pkts.size());
+  iov_.clear();
   // Reserve enough space, assuming each packet is in a single IOBuf.
   // If some packets are split across IOBuf chains then we will end up
   // allocating more space as needed in the loop below.
-  iov.reserve(pkts.size() * 2);
+  iov_.reserve(pkts.size() * 2);
 
   // Build iovecs for all of the packet headers and data
   for (const auto& pkt : pkts) {
-    hdrs.emplace_back(pkt);
-    PktHeader* curHdr = &hdrs.back();
-    iov.push_back({(void*)curHdr, sizeof(PktHeader)});
-    pkt.buf()->appendToIov(&iov);
+    hdrs_.emplace_back(pkt);
+    PktHeader* curHdr = &hdrs_.back();
+    iov_.push_back({(void*)curHdr, sizeof(PktHeader)});
+    pkt.buf()->appendToIov(&iov_);
   }
 
-  int ret = writevFull(file_.fd(), iov.data(), iov.size());
+  ssize_t ret = writevFull(file_.fd(), iov_.data(), iov_.size());
   folly::checkUnixError(ret, "error writing pcap data");
+  return ret;
+}
+
+void PcapFile::sync() {
+  int ret = fdatasync(file_.fd());
+  folly::checkUnixError(ret, "error syncing pcap data");
 }
 
 int PcapFile::openFlags(bool overwriteExisting) {
@@ -9,8 +9,10 @@
  */
 #pragma once
 
+#include <folly/FBVector.h>
 #include <folly/File.h>
 #include <folly/Range.h>
+#include <sys/uio.h>
 #include <vector>
 
 namespace facebook { namespace fboss {
@@ -33,7 +35,18 @@ class PcapFile {
   void close();
 
   void writeGlobalHeader();
-  void writePackets(const std::vector<PcapPkt>& pkt);
+  /*
+   * Write a batch of packets with a single vectored write.
+   *
+   * Returns the number of bytes written, so the caller can implement its
+   * own sync and accounting policy.
+   */
+  uint64_t writePackets(const std::vector<PcapPkt>& pkt);
+
+  /*
+   * Flush written data to disk with fdatasync().
+   */
+  void sync();
 
   // Move constructor and assignment operator
   PcapFile(PcapFile&&) = default;
@@ -56,6 +69,11 @@ class PcapFile {
   static int openFlags(bool overwriteExisting);
 
   folly::File file_;
+  // Scratch buffers for writePackets(), kept across calls so that a
+  // writer draining batches at a high rate doesn't reallocate them on
+  // every drain.  There is only ever one writer thread per file.
+  folly::fbvector<PktHeader> hdrs_;
+  folly::fbvector<struct iovec> iov_;
 };
 
 }} // facebook::fboss
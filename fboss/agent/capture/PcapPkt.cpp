@@ -18,7 +18,11 @@ PcapPkt::PcapPkt() {
 }
 
 PcapPkt::PcapPkt(const RxPacket* pkt)
-  : PcapPkt(pkt, std::chrono::system_clock::now()) {
+  : PcapPkt(pkt,
+            pkt->getArrivalTsc() != 0 ? pkt->getArrivalTime()
+                                      : std::chrono::system_clock::now()) {
+  // Prefer the time the rx callback saw the packet over the time the
+  // capture got around to it; the two can diverge under load.
 }
 
 PcapPkt::PcapPkt(const RxPacket* pkt, TimePoint timestamp)
@@ -45,4 +49,15 @@ PcapPkt::PcapPkt(const TxPacket* pkt, TimePoint timestamp)
   pkt->buf()->cloneInto(buf_);
 }
 
+PcapPkt PcapPkt::clone() const {
+  PcapPkt copy;
+  copy.initialized_ = initialized_;
+  copy.rx_ = rx_;
+  copy.port_ = port_;
+  copy.vlan_ = vlan_;
+  copy.timestamp_ = timestamp_;
+  buf_.cloneInto(copy.buf_);
+  return copy;
+}
+
 }} // facebook::fboss
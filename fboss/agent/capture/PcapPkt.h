@@ -64,6 +64,16 @@ class PcapPkt {
     return &buf_;
   }
 
+  /*
+   * Return a copy of this packet that shares the payload.
+   *
+   * The clone references the same underlying (refcounted) packet
+   * buffer rather than copying it, so handing one snapshot to several
+   * consumers costs a fixed amount of metadata per consumer, not a
+   * payload copy.
+   */
+  PcapPkt clone() const;
+
   // Move assignment
   PcapPkt(PcapPkt&& other) noexcept {
     *this = std::move(other);
@@ -11,7 +11,6 @@
 
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/TxPacket.h"
-#include "fboss/agent/capture/PcapPkt.h"
 
 DEFINE_int32(fboss_pcap_queue_depth, 10240,
              "When taking packet captures, the maximum number of packets "
@@ -23,96 +22,94 @@ namespace facebook { namespace fboss {
 PcapQueue::PcapQueue(uint32_t pktCapacity, uint64_t bytesCapacity)
   : pktCapacity_(pktCapacity == 0 ?
                  FLAGS_fboss_pcap_queue_depth : pktCapacity),
-    bytesCapacity_(bytesCapacity) {
-  queue_.reserve(pktCapacity_);
+    bytesCapacity_(bytesCapacity),
+    queue_(pktCapacity_) {
 }
 
 PcapQueue::~PcapQueue() {
 }
 
-template<typename PktType>
-void PcapQueue::addPktInternal(const PktType* pkt) {
-  // Check to see if this would exceed the queue capacity.
-  if (queue_.size() >= pktCapacity_) {
-    pktsDropped_ += 1;
+void PcapQueue::addPkt(PcapPkt&& pkt) {
+  auto bytes = pkt.buf()->computeChainDataLength();
+  if (bytesCapacity_ > 0 &&
+      bytesInQueue_.load(std::memory_order_relaxed) + bytes >=
+      bytesCapacity_) {
+    pktsDropped_.fetch_add(1, std::memory_order_relaxed);
     return;
   }
-  auto newBytes = bytesInQueue_ + pkt->buf()->computeChainDataLength();
-  if (bytesCapacity_ > 0 && newBytes >= bytesCapacity_) {
-    pktsDropped_ += 1;
+  // write() fails without blocking when the ring is full; that's our
+  // drop point.  It only consumes pkt on success.
+  if (!queue_.write(std::move(pkt))) {
+    pktsDropped_.fetch_add(1, std::memory_order_relaxed);
     return;
   }
-
-  queue_.emplace_back(pkt);
+  bytesInQueue_.fetch_add(bytes, std::memory_order_relaxed);
 }
 
 void PcapQueue::addPkt(const RxPacket* pkt) {
-  {
-    std::lock_guard<std::mutex> guard(mutex_);
-    addPktInternal(pkt);
-  }
-  cv_.notify_one();
-}
-
-void PcapQueue::addPktLocked(const RxPacket* pkt) {
-  addPktInternal(pkt);
-  // It is preferred not to be holding the lock when we signal cv_,
-  // but it is okay to call it with the lock held anyway.  (Having the lock
-  // held will just prevent the reader thread from being able to acquire it
-  // immediately when the reader wakes.)
-  cv_.notify_one();
+  addPkt(PcapPkt(pkt));
 }
 
 void PcapQueue::addPkt(const TxPacket* pkt) {
-  {
-    std::lock_guard<std::mutex> guard(mutex_);
-    addPktInternal(pkt);
-  }
-  cv_.notify_one();
+  addPkt(PcapPkt(pkt));
 }
 
-void PcapQueue::addPktLocked(const TxPacket* pkt) {
-  addPktInternal(pkt);
-  // It is preferred not to be holding the lock when we signal cv_,
-  // but it is okay to call it with the lock held anyway.  (Having the lock
-  // held will just prevent the reader thread from being able to acquire it
-  // immediately when the reader wakes.)
-  cv_.notify_one();
+void PcapQueue::addPkts(std::vector<PcapPkt>* pkts) {
+  for (auto& pkt : *pkts) {
+    addPkt(std::move(pkt));
+  }
+  pkts->clear();
 }
 
 void PcapQueue::finish() {
-  std::lock_guard<std::mutex> guard(mutex_);
-  finished_ = true;
-  cv_.notify_all();
+  if (!finished_.exchange(true, std::memory_order_acq_rel)) {
+    // Wake the reader if it is blocked on an empty ring; the
+    // uninitialized packet is filtered out on the read side.  The
+    // reader only blocks when the ring is empty, so if this write
+    // fails (ring full) there is nothing to wake.
+    queue_.write(PcapPkt());
+  }
 }
 
 bool PcapQueue::isFinished() const {
-  std::lock_guard<std::mutex> guard(mutex_);
-  return finished_;
+  return finished_.load(std::memory_order_acquire);
 }
 
 uint64_t PcapQueue::numDropped() const {
-  std::lock_guard<std::mutex> guard(mutex_);
-  return pktsDropped_;
+  return pktsDropped_.load(std::memory_order_relaxed);
+}
+
+void PcapQueue::popPkt(std::vector<PcapPkt>* swapQueue, PcapPkt&& pkt) {
+  if (!pkt.initialized()) {
+    // finish() sentinel
+    return;
+  }
+  bytesInQueue_.fetch_sub(pkt.buf()->computeChainDataLength(),
+                          std::memory_order_relaxed);
+  swapQueue->push_back(std::move(pkt));
 }
 
 bool PcapQueue::wait(std::vector<PcapPkt>* swapQueue) {
   swapQueue->clear();
   swapQueue->reserve(pktCapacity_);
 
-  std::unique_lock<std::mutex> guard(mutex_);
-  while (queue_.empty() && !finished_) {
-    cv_.wait(guard);
-  }
-  if (queue_.empty()) {
-    DCHECK(finished_);
-    queue_.shrink_to_fit();
-    return false;
+  PcapPkt pkt;
+  while (swapQueue->empty()) {
+    if (isFinished()) {
+      // No more producers; drain whatever is left without blocking
+      while (queue_.read(pkt)) {
+        popPkt(swapQueue, std::move(pkt));
+      }
+      break;
+    }
+    queue_.blockingRead(pkt);
+    popPkt(swapQueue, std::move(pkt));
+    // Batch pop: grab everything else already in the ring
+    while (queue_.read(pkt)) {
+      popPkt(swapQueue, std::move(pkt));
+    }
   }
-
-  swapQueue->swap(queue_);
-  bytesInQueue_ = 0;
-  return true;
+  return !swapQueue->empty();
 }
 
 }} // facebook::fboss
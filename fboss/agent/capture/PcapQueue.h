@@ -9,21 +9,28 @@
  */
 #pragma once
 
-#include <condition_variable>
-#include <mutex>
+#include <atomic>
 #include <vector>
 
+#include <folly/MPMCQueue.h>
+
+#include "fboss/agent/capture/PcapPkt.h"
+
 namespace facebook { namespace fboss {
 
 class RxPacket;
 class TxPacket;
-class PcapPkt;
 
 /*
  * PcapQueue stores a queue of PcapPkt objects, for transferring packets
  * from an asynchronous capture thread to a blocking thread that will process
  * the packets.  (For instance, writing them to disk using blocking I/O.)
  *
+ * The queue is a bounded lock-free ring: any number of packet handling
+ * threads may enqueue concurrently without taking a mutex, and a single
+ * reader drains it in batches via wait().  Packets that don't fit in
+ * the ring are dropped and accounted in numDropped().
+ *
  * There can only be a single reader.
  */
 class PcapQueue {
@@ -36,21 +43,17 @@ class PcapQueue {
     return pktCapacity_;
   }
 
-  /*
-   * Get the mutex protecting this PcapQueue.
-   *
-   * This is exposed to allow callers to also protect their own data
-   * with the same mutex if desired.  Callers should call addPktLocked()
-   * instead of addPkt() when they are already holding the PcapQueue mutex.
-   */
-  std::mutex& mutex() const {
-    return mutex_;
-  }
-
   void addPkt(const RxPacket* pkt);
-  void addPktLocked(const RxPacket* pkt);
   void addPkt(const TxPacket* pkt);
-  void addPktLocked(const TxPacket* pkt);
+  void addPkt(PcapPkt&& pkt);
+
+  /*
+   * Batch enqueue: move every packet in pkts into the queue (dropping
+   * the ones that don't fit) and clear the vector. Callers that batch
+   * packets locally pay the ring's release barrier once per batch
+   * rather than once per packet.
+   */
+  void addPkts(std::vector<PcapPkt>* pkts);
 
   /*
    * finish() signals that no more packets will be added to the queue.
@@ -70,11 +73,22 @@ class PcapQueue {
    */
   uint64_t numDropped() const;
 
+  /*
+   * Return the number of packet payload bytes currently sitting in the
+   * queue waiting for the reader.  Used for memory accounting.
+   */
+  uint64_t bytesBuffered() const {
+    return bytesInQueue_.load(std::memory_order_relaxed);
+  }
+
   /*
    * Wait for new packets from the queue.
    *
-   * Note: for best performance, the writer should re-use the same vector
-   * for multiple wait() calls.  On subsequent calls the queue will already
+   * Blocks until at least one packet is available, then drains
+   * everything currently in the ring into swapQueue in one batch.
+   *
+   * Note: for best performance, the reader should re-use the same vector
+   * for multiple wait() calls.  On subsequent calls the vector will already
    * have the desired capacity, and will not need to reallocate memory.
    */
   bool wait(std::vector<PcapPkt>* swapQueue);
@@ -84,18 +98,15 @@ class PcapQueue {
   PcapQueue(PcapQueue const &) = delete;
   PcapQueue& operator=(PcapQueue const &) = delete;
 
-  template<typename PktType>
-  void addPktInternal(const PktType* pkt);
-
-  mutable std::mutex mutex_;
-  std::condition_variable cv_;
+  // Pop one packet into swapQueue, maintaining the byte accounting.
+  void popPkt(std::vector<PcapPkt>* swapQueue, PcapPkt&& pkt);
 
-  bool finished_{false};
   const uint32_t pktCapacity_{0};
-  uint64_t bytesCapacity_{0};
-  uint64_t bytesInQueue_{0};
-  uint64_t pktsDropped_{0};
-  std::vector<PcapPkt> queue_;
+  const uint64_t bytesCapacity_{0};
+  std::atomic<uint64_t> bytesInQueue_{0};
+  std::atomic<uint64_t> pktsDropped_{0};
+  std::atomic<bool> finished_{false};
+  folly::MPMCQueue<PcapPkt> queue_;
 };
 
 }} // facebook::fboss
@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PcapReplayer.h"
+
+#include "fboss/agent/FbossError.h"
+
+#include <folly/Bits.h>
+
+#include <cstring>
+#include <thread>
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+namespace {
+// Classic pcap magic, as written by PcapFile::writeGlobalHeader().
+// A capture written on a machine with the opposite endianness shows
+// up with the bytes reversed.
+constexpr uint32_t kPcapMagic = 0xa1b2c3d4;
+constexpr uint32_t kPcapMagicSwapped = 0xd4c3b2a1;
+constexpr size_t kGlobalHeaderLen = 24;
+constexpr size_t kPktHeaderLen = 16;
+}
+
+namespace facebook { namespace fboss {
+
+PcapReplayer::PcapReplayer(folly::StringPiece path)
+  : mapping_(path.str().c_str()) {
+  parse();
+}
+
+uint32_t PcapReplayer::readU32(const uint8_t* p) const {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return swapped_ ? folly::Endian::swap(value) : value;
+}
+
+void PcapReplayer::parse() {
+  auto range = mapping_.range();
+  if (range.size() < kGlobalHeaderLen) {
+    throw FbossError("pcap file too short for global header: ",
+                     range.size(), " bytes");
+  }
+
+  uint32_t magic;
+  memcpy(&magic, range.data(), sizeof(magic));
+  if (magic == kPcapMagic) {
+    swapped_ = false;
+  } else if (magic == kPcapMagicSwapped) {
+    swapped_ = true;
+  } else {
+    throw FbossError("not a pcap file: bad magic ", magic);
+  }
+
+  const uint8_t* p = range.data() + kGlobalHeaderLen;
+  const uint8_t* end = range.data() + range.size();
+  while (p < end) {
+    if (end - p < static_cast<ssize_t>(kPktHeaderLen)) {
+      throw FbossError("pcap file truncated mid packet header at offset ",
+                       p - range.data());
+    }
+    uint32_t tsSec = readU32(p);
+    uint32_t tsUsec = readU32(p + 4);
+    uint32_t inclLen = readU32(p + 8);
+    p += kPktHeaderLen;
+    if (end - p < static_cast<ssize_t>(inclLen)) {
+      throw FbossError("pcap file truncated mid packet data at offset ",
+                       p - range.data());
+    }
+
+    Pkt pkt;
+    pkt.data.reset(p, inclLen);
+    pkt.timestamp = duration_cast<microseconds>(seconds(tsSec)) +
+        microseconds(tsUsec);
+    pkts_.push_back(pkt);
+    p += inclLen;
+  }
+}
+
+uint64_t PcapReplayer::replay(const PktCallback& fn, double speedup,
+                              uint64_t loops) {
+  stop_ = false;
+  uint64_t delivered = 0;
+  if (pkts_.empty()) {
+    return delivered;
+  }
+
+  for (uint64_t loop = 0; loops == 0 || loop < loops; ++loop) {
+    auto captureStart = pkts_.front().timestamp;
+    auto replayStart = steady_clock::now();
+    for (const auto& pkt : pkts_) {
+      if (stop_) {
+        return delivered;
+      }
+      if (speedup > 0) {
+        // Scale this packet's offset into the capture and sleep until
+        // its replay time arrives.  Packets that are already late
+        // (callback slower than the scaled capture rate) are sent
+        // immediately, so a slow consumer degrades timing rather than
+        // accumulating sleeps.
+        auto offset = pkt.timestamp - captureStart;
+        auto target = replayStart +
+            microseconds(static_cast<int64_t>(offset.count() / speedup));
+        if (target > steady_clock::now()) {
+          std::this_thread::sleep_until(target);
+        }
+      }
+      fn(pkt);
+      ++delivered;
+    }
+  }
+  return delivered;
+}
+
+}} // facebook::fboss
@@ -0,0 +1,93 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/MemoryMapping.h>
+#include <folly/Range.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+/*
+ * PcapReplayer reads a capture written by PcapFile/PcapWriter and
+ * replays its packets through a caller-supplied callback.
+ *
+ * The file is mapped read-only with mmap and indexed once up front, so
+ * packet data is handed to the callback as ranges into the mapping
+ * with no per-packet copies or allocations.  Replay can run at the
+ * capture's original timing, at an accelerated (or slowed) rate, or as
+ * fast as the callback can consume packets, and can loop over the
+ * capture for sustained load.
+ *
+ * PcapReplayer does not depend on libpcap; it parses the same classic
+ * pcap format that PcapFile writes, in either byte order.
+ */
+class PcapReplayer {
+ public:
+  struct Pkt {
+    // Points into the mapped file; valid for the replayer's lifetime.
+    folly::ByteRange data;
+    // Capture timestamp, relative to the unix epoch.
+    std::chrono::microseconds timestamp{0};
+  };
+  typedef std::function<void(const Pkt& pkt)> PktCallback;
+
+  /*
+   * Map and index the capture at path.
+   *
+   * Throws an FbossError if the file is not a pcap file or is
+   * truncated mid-record.
+   */
+  explicit PcapReplayer(folly::StringPiece path);
+
+  const std::vector<Pkt>& pkts() const {
+    return pkts_;
+  }
+
+  /*
+   * Invoke fn for every packet in the capture, loops times over.
+   *
+   * speedup scales the capture's inter-packet gaps: 1.0 replays at the
+   * original timing, 10.0 replays 10x faster, and 0 (or any
+   * non-positive value) replays as fast as fn returns.  A loops value
+   * of 0 means loop until stop() is called from another thread.
+   *
+   * Returns the number of packets delivered to fn.
+   */
+  uint64_t replay(const PktCallback& fn, double speedup = 1.0,
+                  uint64_t loops = 1);
+
+  /*
+   * Ask a replay() running in another thread to return after the
+   * packet it is currently delivering.
+   */
+  void stop() {
+    stop_ = true;
+  }
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  PcapReplayer(PcapReplayer const &) = delete;
+  PcapReplayer& operator=(PcapReplayer const &) = delete;
+
+  void parse();
+  uint32_t readU32(const uint8_t* p) const;
+
+  folly::MemoryMapping mapping_;
+  bool swapped_{false};
+  std::vector<Pkt> pkts_;
+  std::atomic<bool> stop_{false};
+};
+
+}} // facebook::fboss
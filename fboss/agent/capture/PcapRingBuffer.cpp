@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PcapRingBuffer.h"
+
+namespace facebook { namespace fboss {
+
+PcapRingBuffer::PcapRingBuffer(uint32_t capacity)
+  : capacity_(capacity) {
+  pkts_.reserve(capacity_);
+}
+
+void PcapRingBuffer::addPkt(const RxPacket* pkt) {
+  addPktInternal(pkt);
+}
+
+void PcapRingBuffer::addPkt(const TxPacket* pkt) {
+  addPktInternal(pkt);
+}
+
+template<typename PktType>
+void PcapRingBuffer::addPktInternal(const PktType* pkt) {
+  PcapPkt pcapPkt(pkt);
+  std::lock_guard<std::mutex> g(mutex_);
+  if (pkts_.size() < capacity_) {
+    pkts_.push_back(std::move(pcapPkt));
+  } else {
+    pkts_[next_] = std::move(pcapPkt);
+    next_ = (next_ + 1) % capacity_;
+  }
+}
+
+std::vector<PcapPkt> PcapRingBuffer::extract() {
+  std::vector<PcapPkt> alreadySorted;
+  std::vector<PcapPkt> wrapped;
+  {
+    std::lock_guard<std::mutex> g(mutex_);
+    alreadySorted.swap(pkts_);
+    pkts_.reserve(capacity_);
+    // Entries at [next_, end) are older than entries at [0, next_),
+    // so rotate the ring contents into arrival order.
+    if (next_ != 0) {
+      wrapped.reserve(alreadySorted.size());
+      for (uint32_t idx = next_; idx < alreadySorted.size(); ++idx) {
+        wrapped.push_back(std::move(alreadySorted[idx]));
+      }
+      for (uint32_t idx = 0; idx < next_; ++idx) {
+        wrapped.push_back(std::move(alreadySorted[idx]));
+      }
+      next_ = 0;
+    }
+  }
+  return wrapped.empty() ? std::move(alreadySorted) : std::move(wrapped);
+}
+
+uint64_t PcapRingBuffer::bytesBuffered() const {
+  uint64_t bytes = 0;
+  std::lock_guard<std::mutex> g(mutex_);
+  for (const auto& pkt : pkts_) {
+    bytes += pkt.buf()->computeChainDataLength();
+  }
+  return bytes;
+}
+
+}} // facebook::fboss
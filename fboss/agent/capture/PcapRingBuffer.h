@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/agent/capture/PcapPkt.h"
+
+#include <mutex>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+class RxPacket;
+class TxPacket;
+
+/*
+ * PcapRingBuffer keeps the most recent packets in a fixed-size in-memory
+ * ring, overwriting the oldest entry once the ring is full.
+ *
+ * It is the storage behind the "flight recorder" capture mode: the ring
+ * is fed continuously from the packet path, and its contents are only
+ * ever examined when someone asks for a dump after the fact.
+ *
+ * All methods are safe to call from any thread.
+ */
+class PcapRingBuffer {
+ public:
+  explicit PcapRingBuffer(uint32_t capacity);
+
+  void addPkt(const RxPacket* pkt);
+  void addPkt(const TxPacket* pkt);
+
+  /*
+   * Move the buffered packets out of the ring, oldest first, and reset
+   * the ring to empty.
+   */
+  std::vector<PcapPkt> extract();
+
+  /*
+   * Return the packet payload bytes currently held by the ring.
+   * Used for memory accounting; the ring is small, so walking it
+   * under the mutex is cheap.
+   */
+  uint64_t bytesBuffered() const;
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  PcapRingBuffer(PcapRingBuffer const &) = delete;
+  PcapRingBuffer& operator=(PcapRingBuffer const &) = delete;
+
+  template<typename PktType>
+  void addPktInternal(const PktType* pkt);
+
+  const uint32_t capacity_{0};
+  mutable std::mutex mutex_;
+  // pkts_ grows up to capacity_ entries; once full, next_ wraps around
+  // and new packets overwrite the oldest ones in place.
+  std::vector<PcapPkt> pkts_;
+  uint32_t next_{0};
+};
+
+}} // facebook::fboss
@@ -15,6 +15,10 @@
 
 using folly::StringPiece;
 
+DEFINE_int64(pcap_fsync_bytes, 0,
+             "Sync pcap capture files to disk after writing this many bytes "
+             "(0 to sync only when the capture finishes)");
+
 namespace facebook { namespace fboss {
 
 PcapWriter::PcapWriter(uint32_t maxBufferedPkts)
@@ -72,6 +76,7 @@ void PcapWriter::threadMain() {
 
 void PcapWriter::writeLoop() {
   std::vector<PcapPkt> pkts;
+  uint64_t unsyncedBytes = 0;
   while (true) {
     pkts.clear();
     if (!queue_.wait(&pkts)) {
@@ -80,7 +85,22 @@ void PcapWriter::writeLoop() {
     }
 
     DCHECK(!pkts.empty());
-    file_.writePackets(pkts);
+    // Each wait() call drains the whole queue, and writePackets() turns
+    // the drained batch into a single vectored write, so the number of
+    // syscalls per captured packet drops as the capture rate goes up.
+    auto bytes = file_.writePackets(pkts);
+    bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+
+    // Optionally sync to disk once enough unsynced data has built up.
+    // By default we leave flushing to the kernel so that syncs never
+    // stall the writer (and therefore never cause queue drops).
+    if (FLAGS_pcap_fsync_bytes > 0) {
+      unsyncedBytes += bytes;
+      if (unsyncedBytes >= FLAGS_pcap_fsync_bytes) {
+        file_.sync();
+        unsyncedBytes = 0;
+      }
+    }
   }
 }
 
@@ -12,6 +12,7 @@
 #include "fboss/agent/capture/PcapFile.h"
 #include "fboss/agent/capture/PcapQueue.h"
 
+#include <atomic>
 #include <thread>
 
 namespace facebook { namespace fboss {
@@ -33,27 +34,22 @@ class PcapWriter {
   void start(folly::StringPiece path, bool overwriteExisting = false);
 
   /*
-   * Get the mutex protecting this PcapWriter.
+   * Add packets to be written out.
    *
-   * This is exposed to allow callers to also protect their own data
-   * with the same mutex if desired.  Callers should call addPktLocked()
-   * instead of addPkt() when they are already holding the PcapWriter mutex.
+   * The underlying queue is a lock-free ring, so these may be called
+   * concurrently from any number of packet handling threads.
    */
-  std::mutex& mutex() const {
-    return queue_.mutex();
-  }
-
   void addPkt(const RxPacket* pkt) {
     queue_.addPkt(pkt);
   }
-  void addPktLocked(const RxPacket* pkt) {
-    queue_.addPktLocked(pkt);
-  }
   void addPkt(const TxPacket* pkt) {
     queue_.addPkt(pkt);
   }
-  void addPktLocked(const TxPacket* pkt) {
-    queue_.addPktLocked(pkt);
+  void addPkt(PcapPkt&& pkt) {
+    queue_.addPkt(std::move(pkt));
+  }
+  void addPkts(std::vector<PcapPkt>* pkts) {
+    queue_.addPkts(pkts);
   }
   void finish();
 
@@ -67,6 +63,22 @@ class PcapWriter {
     return queue_.numDropped();
   }
 
+  /*
+   * Return the number of pcap file bytes written so far (packet headers
+   * plus packet data).
+   */
+  uint64_t bytesWritten() const {
+    return bytesWritten_.load(std::memory_order_relaxed);
+  }
+
+  /*
+   * Return the number of packet payload bytes buffered in the queue,
+   * waiting for the writer thread to flush them to disk.
+   */
+  uint64_t bytesBuffered() const {
+    return queue_.bytesBuffered();
+  }
+
  private:
   // Forbidden copy constructor and assignment operator
   PcapWriter(PcapWriter const &) = delete;
@@ -79,6 +91,7 @@ class PcapWriter {
   PcapFile file_;
   PcapQueue queue_;
   std::exception_ptr ex_;
+  std::atomic<uint64_t> bytesWritten_{0};
   std::thread thread_;
 };
 
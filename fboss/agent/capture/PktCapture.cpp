@@ -20,6 +20,16 @@ PktCapture::PktCapture(folly::StringPiece name, uint64_t maxPackets)
     maxPackets_(maxPackets) {
 }
 
+PktCapture::PktCapture(folly::StringPiece name,
+                       uint64_t maxPackets,
+                       uint64_t maxBytes,
+                       PktFilter filter)
+  : name_(name.str()),
+    filter_(std::move(filter)),
+    maxPackets_(maxPackets),
+    maxBytes_(maxBytes) {
+}
+
 void PktCapture::start(StringPiece path) {
   writer_.start(path, true);
 }
@@ -28,18 +38,40 @@ void PktCapture::stop() {
   writer_.finish();
 }
 
-bool PktCapture::packetReceived(const RxPacket* pkt) {
-  std::lock_guard<std::mutex> guard(writer_.mutex());
-  ++numPacketsReceived_;
-  writer_.addPktLocked(pkt);
-  return numPacketsReceived_ < maxPackets_;
+bool PktCapture::underQuota() const {
+  if (numPacketsReceived_.load(std::memory_order_relaxed) >= maxPackets_) {
+    return false;
+  }
+  return maxBytes_ == 0 ||
+    numBytesReceived_.load(std::memory_order_relaxed) < maxBytes_;
+}
+
+bool PktCapture::record(const PcapPkt& snapshot) {
+  auto len = snapshot.buf()->computeChainDataLength();
+  auto numReceived =
+    numPacketsReceived_.fetch_add(1, std::memory_order_relaxed) + 1;
+  auto numBytes =
+    numBytesReceived_.fetch_add(len, std::memory_order_relaxed) + len;
+  // The clone shares the payload with the snapshot (and with every
+  // other capture recording this packet); only the per-packet metadata
+  // is per-capture.
+  writer_.addPkt(snapshot.clone());
+  return numReceived < maxPackets_ && (maxBytes_ == 0 || numBytes < maxBytes_);
+}
+
+bool PktCapture::packetReceived(const RxPacket* pkt, const PcapPkt& snapshot) {
+  if (!filter_.matches(pkt)) {
+    // Filtered-out packets don't count against the quotas.
+    return underQuota();
+  }
+  return record(snapshot);
 }
 
-bool PktCapture::packetSent(const TxPacket* pkt) {
-  std::lock_guard<std::mutex> guard(writer_.mutex());
-  ++numPacketsReceived_;
-  writer_.addPktLocked(pkt);
-  return numPacketsReceived_ < maxPackets_;
+bool PktCapture::packetSent(const TxPacket* pkt, const PcapPkt& snapshot) {
+  if (!filter_.matches(pkt)) {
+    return underQuota();
+  }
+  return record(snapshot);
 }
 
 }} // facebook::fboss
@@ -10,8 +10,10 @@
 #pragma once
 
 #include "fboss/agent/capture/PcapWriter.h"
+#include "fboss/agent/capture/PktFilter.h"
 
 #include <folly/Range.h>
+#include <atomic>
 #include <string>
 
 namespace facebook { namespace fboss {
@@ -25,6 +27,14 @@ class TxPacket;
 class PktCapture {
  public:
   PktCapture(folly::StringPiece name, uint64_t maxPackets);
+  // A capture that only records packets matching the filter. Packets
+  // rejected by the filter do not count against maxPackets. maxBytes
+  // bounds the total packet bytes recorded (0 means no byte quota);
+  // it is enforced on the packet lengths as they are enqueued.
+  PktCapture(folly::StringPiece name,
+             uint64_t maxPackets,
+             uint64_t maxBytes,
+             PktFilter filter);
 
   const std::string& name() const {
     return name_;
@@ -33,21 +43,48 @@ class PktCapture {
   void start(folly::StringPiece path);
   void stop();
 
-  bool packetReceived(const RxPacket* pkt);
-  bool packetSent(const TxPacket* pkt);
+  /*
+   * Offer a packet to this capture.
+   *
+   * snapshot is the shared PcapPkt built once per packet by the
+   * capture manager; a capture that records the packet enqueues a
+   * refcounted clone of it rather than re-copying the payload. The
+   * raw packet is still passed for the filter, which needs the rx
+   * metadata and header offset annotations.
+   *
+   * Returns false once the capture has hit its packet or byte quota
+   * and should be deactivated.
+   */
+  bool packetReceived(const RxPacket* pkt, const PcapPkt& snapshot);
+  bool packetSent(const TxPacket* pkt, const PcapPkt& snapshot);
+
+  /*
+   * Return the packet payload bytes this capture currently has queued
+   * in memory waiting to be written out.
+   */
+  uint64_t bytesBuffered() const {
+    return writer_.bytesBuffered();
+  }
 
  private:
   // Forbidden copy constructor and assignment operator
   PktCapture(PktCapture const &) = delete;
   PktCapture& operator=(PktCapture const &) = delete;
 
+  bool underQuota() const;
+  bool record(const PcapPkt& snapshot);
+
   const std::string name_;
+  const PktFilter filter_;
 
-  // Note: the rest of the state in this class is protcted by
-  // the PcapWriter's mutex.
+  // The writer's queue is lock free, so packets may be added from any
+  // number of threads; the received count is kept consistent with an
+  // atomic rather than a mutex.
   PcapWriter writer_;
-  uint64_t maxPackets_{0};
-  uint64_t numPacketsReceived_{0};
+  const uint64_t maxPackets_{0};
+  const uint64_t maxBytes_{0};
+  std::atomic<uint64_t> numPacketsReceived_{0};
+  std::atomic<uint64_t> numBytesReceived_{0};
 };
 
 }} // facebook::fboss
@@ -13,20 +13,35 @@
 #include "fboss/agent/Platform.h"
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/Utils.h"
+#include "fboss/agent/capture/PcapFile.h"
+#include "fboss/agent/capture/PcapPkt.h"
+#include "fboss/agent/capture/PcapRingBuffer.h"
 #include "fboss/agent/capture/PktCapture.h"
 
 #include <folly/String.h>
 
+#include <algorithm>
+#include <iterator>
+
 using folly::StringPiece;
 using std::string;
 using std::unique_ptr;
 
+DEFINE_int32(pcap_ring_pkts, 1024,
+             "Number of rx and tx packets to keep in the always-on "
+             "flight recorder capture rings (0 to disable)");
+
 namespace facebook { namespace fboss {
 
 PktCaptureManager::PktCaptureManager(SwSwitch* sw) {
   auto persistDir = sw->getPlatform()->getPersistentStateDir();
   captureDir_ = folly::to<string>(persistDir, "/captures");
   utilCreateDir(captureDir_);
+
+  if (FLAGS_pcap_ring_pkts > 0) {
+    rxRing_ = std::make_unique<PcapRingBuffer>(FLAGS_pcap_ring_pkts);
+    txRing_ = std::make_unique<PcapRingBuffer>(FLAGS_pcap_ring_pkts);
+  }
 }
 
 PktCaptureManager::~PktCaptureManager() {
@@ -47,8 +62,8 @@ void PktCaptureManager::startCapture(unique_ptr<PktCapture> capture) {
   }
 
   capture->start(path);
-  capturesRunning_.store(true, std::memory_order_release);
-  activeCaptures_[name] = std::move(capture);
+  activeCaptures_[name] = std::shared_ptr<PktCapture>(std::move(capture));
+  publishActiveCaptures();
 }
 
 void PktCaptureManager::stopCapture(StringPiece name) {
@@ -63,26 +78,28 @@ void PktCaptureManager::stopCapture(StringPiece name) {
   it->second->stop();
   inactiveCaptures_[nameStr] = std::move(it->second);
   activeCaptures_.erase(it);
-  capturesRunning_.store(!activeCaptures_.empty(), std::memory_order_release);
+  publishActiveCaptures();
 }
 
-unique_ptr<PktCapture> PktCaptureManager::forgetCapture(StringPiece name) {
+std::shared_ptr<PktCapture> PktCaptureManager::forgetCapture(
+    StringPiece name) {
   std::lock_guard<std::mutex> g(mutex_);
   auto nameStr = name.str();
   auto activeIt = activeCaptures_.find(nameStr);
   if (activeIt != activeCaptures_.end()) {
     LOG(INFO) << "stopping packet capture \"" << name << "\"";
-    std::unique_ptr<PktCapture> capture = std::move(activeIt->second);
+    std::shared_ptr<PktCapture> capture = std::move(activeIt->second);
     activeCaptures_.erase(activeIt);
-    capturesRunning_.store(!activeCaptures_.empty(),
-                           std::memory_order_release);
+    publishActiveCaptures();
+    // Packet-path threads iterating an older snapshot may still hold a
+    // reference; the capture object stays alive until they are done.
     capture->stop();
     return capture;
   }
 
   auto inactiveIt = inactiveCaptures_.find(nameStr);
   if (inactiveIt != inactiveCaptures_.end()) {
-    std::unique_ptr<PktCapture> capture = std::move(inactiveIt->second);
+    std::shared_ptr<PktCapture> capture = std::move(inactiveIt->second);
     inactiveCaptures_.erase(inactiveIt);
     return capture;
   }
@@ -102,57 +119,144 @@ void PktCaptureManager::forgetAllCaptures() {
   // FIXME
 }
 
+void PktCaptureManager::publishActiveCaptures() {
+  auto list = std::make_shared<CaptureList>();
+  list->reserve(activeCaptures_.size());
+  for (const auto& entry : activeCaptures_) {
+    list->push_back(entry.second);
+  }
+  {
+    folly::SpinLockGuard guard(activeListLock_);
+    if (list->empty()) {
+      activeList_.reset();
+    } else {
+      activeList_ = std::move(list);
+    }
+  }
+  capturesRunning_.store(!activeCaptures_.empty(), std::memory_order_release);
+}
+
 template<typename Fn>
 void PktCaptureManager::invokeCaptures(const Fn& fn) {
-  std::lock_guard<std::mutex> g(mutex_);
+  // Grab the published snapshot; the captures in it are guaranteed to
+  // stay alive for the duration of the loop, and mutex_ is not held,
+  // so start/stop from other threads never waits on packet processing.
+  std::shared_ptr<const CaptureList> captures;
+  {
+    folly::SpinLockGuard guard(activeListLock_);
+    captures = activeList_;
+  }
+  if (!captures) {
+    return;
+  }
 
-  for (auto it = activeCaptures_.begin();
-       it != activeCaptures_.end();
-       /* increment in loop */) {
-    // Increment the iterator now, in case this capture deactivates itself and
-    // we need to remove it from the active captures.
-    auto thisIt = it;
-    ++it;
-    PktCapture* capture = thisIt->second.get();
+  std::vector<PktCapture*> stopped;
+  for (const auto& capture : *captures) {
     bool stillActive = false;
     try {
-      stillActive = fn(capture);
+      stillActive = fn(capture.get());
     } catch (const std::exception& ex) {
       LOG(ERROR) << "error when processing packet for capture " <<
         capture->name() << " : " << folly::exceptionStr(ex);
       stillActive = false;
     }
-
     if (!stillActive) {
-      LOG(INFO) << "auto-stopping packet capture \"" <<
-        capture->name() << "\"";
-      try {
-        inactiveCaptures_[capture->name()] = std::move(thisIt->second);
-      } catch (const std::exception& ex) {
-        LOG(ERROR) << "error adding capture " << capture->name() <<
-          " to the inactive list";
-        // Can't do much else here.  Just continue and forget the capture.
-      }
-      activeCaptures_.erase(thisIt);
+      stopped.push_back(capture.get());
     }
   }
+  if (stopped.empty()) {
+    return;
+  }
 
-  bool running = !activeCaptures_.empty();
-  capturesRunning_.store(running, std::memory_order_release);
+  // One or more captures hit their quota: retire them from the active
+  // set. Another thread may have stopped or forgotten them in the
+  // meantime, so only retire entries that still match our snapshot.
+  std::lock_guard<std::mutex> g(mutex_);
+  bool changed = false;
+  for (auto* capture : stopped) {
+    auto it = activeCaptures_.find(capture->name());
+    if (it == activeCaptures_.end() || it->second.get() != capture) {
+      continue;
+    }
+    LOG(INFO) << "auto-stopping packet capture \"" <<
+      capture->name() << "\"";
+    inactiveCaptures_[capture->name()] = std::move(it->second);
+    activeCaptures_.erase(it);
+    changed = true;
+  }
+  if (changed) {
+    publishActiveCaptures();
+  }
 }
 
 void PktCaptureManager::packetReceivedImpl(const RxPacket* pkt) {
+  // Build a single snapshot of the packet; each capture that records
+  // it enqueues a refcounted clone, so the payload is shared across
+  // all subscribers rather than copied per capture.
+  PcapPkt snapshot(pkt);
   invokeCaptures([&] (PktCapture* capture) {
-    return capture->packetReceived(pkt);
+    return capture->packetReceived(pkt, snapshot);
   });
 }
 
 void PktCaptureManager::packetSentImpl(const TxPacket* pkt) {
+  PcapPkt snapshot(pkt);
   invokeCaptures([&] (PktCapture* capture) {
-    return capture->packetSent(pkt);
+    return capture->packetSent(pkt, snapshot);
   });
 }
 
+void PktCaptureManager::ringPacketReceived(const RxPacket* pkt) {
+  rxRing_->addPkt(pkt);
+}
+
+void PktCaptureManager::ringPacketSent(const TxPacket* pkt) {
+  txRing_->addPkt(pkt);
+}
+
+void PktCaptureManager::dumpPcapRing(StringPiece name) {
+  if (!rxRing_) {
+    throw FbossError("the flight recorder capture ring is disabled "
+                     "(--pcap_ring_pkts=0)");
+  }
+  checkCaptureName(name);
+  auto path = folly::to<string>(captureDir_, "/", name, ".pcap");
+  LOG(INFO) << "dumping flight recorder capture ring to \"" << path << "\"";
+
+  // Freeze both rings, then merge the rx and tx packets into timestamp
+  // order so the resulting file reads like an ordinary capture.
+  auto pkts = rxRing_->extract();
+  auto txPkts = txRing_->extract();
+  pkts.reserve(pkts.size() + txPkts.size());
+  std::move(txPkts.begin(), txPkts.end(), std::back_inserter(pkts));
+  std::stable_sort(pkts.begin(), pkts.end(),
+                   [] (const PcapPkt& a, const PcapPkt& b) {
+                     return a.timestamp() < b.timestamp();
+                   });
+
+  PcapFile file(path, true);
+  file.writeGlobalHeader();
+  if (!pkts.empty()) {
+    file.writePackets(pkts);
+  }
+  file.close();
+}
+
+uint64_t PktCaptureManager::bytesBuffered() const {
+  uint64_t bytes = 0;
+  if (rxRing_) {
+    bytes += rxRing_->bytesBuffered();
+  }
+  if (txRing_) {
+    bytes += txRing_->bytesBuffered();
+  }
+  std::lock_guard<std::mutex> g(mutex_);
+  for (const auto& entry : activeCaptures_) {
+    bytes += entry.second->bytesBuffered();
+  }
+  return bytes;
+}
+
 void PktCaptureManager::checkCaptureName(folly::StringPiece name) {
   // We use the capture name for the on-disk filename, so don't allow
   // directory separator characters or nul bytes.
@@ -10,15 +10,18 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/SpinLock.h>
 
 #include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace facebook { namespace fboss {
 
+class PcapRingBuffer;
 class PktCapture;
 class RxPacket;
 class SwSwitch;
@@ -37,7 +40,7 @@ class PktCaptureManager {
   void startCapture(std::unique_ptr<PktCapture> capture);
 
   void stopCapture(folly::StringPiece name);
-  std::unique_ptr<PktCapture> forgetCapture(folly::StringPiece name);
+  std::shared_ptr<PktCapture> forgetCapture(folly::StringPiece name);
 
   void stopAllCaptures();
   void forgetAllCaptures();
@@ -48,6 +51,11 @@ class PktCaptureManager {
    * This method is safe to call from any thread.
    */
   void packetReceived(const RxPacket* pkt) {
+    // Feed the always-on flight recorder ring, if enabled.
+    if (rxRing_) {
+      ringPacketReceived(pkt);
+    }
+
     // We expect that in the common case there will be no active captures
     // running.  Just do a fast check to handle that case.
     if (!capturesRunning_.load(std::memory_order_acquire)) {
@@ -62,6 +70,11 @@ class PktCaptureManager {
    * This method is safe to call from any thread.
    */
   void packetSent(const TxPacket* pkt) {
+    // Feed the always-on flight recorder ring, if enabled.
+    if (txRing_) {
+      ringPacketSent(pkt);
+    }
+
     // We expect that in the common case there will be no active captures
     // running.  Just do a fast check to handle that case.
     if (!capturesRunning_.load(std::memory_order_acquire)) {
@@ -71,6 +84,23 @@ class PktCaptureManager {
     packetSentImpl(pkt);
   }
 
+  /*
+   * Write the current contents of the flight recorder rings to a pcap
+   * file named like an ordinary capture, oldest packet first.
+   *
+   * This method is safe to call from any thread.
+   */
+  void dumpPcapRing(folly::StringPiece name);
+
+  /*
+   * Return the total packet payload bytes currently buffered in memory
+   * by the capture subsystem: the flight recorder rings plus the write
+   * queues of all active captures.  Used for memory accounting.
+   *
+   * This method is safe to call from any thread.
+   */
+  uint64_t bytesBuffered() const;
+
   const std::string& getCaptureDir() const {
     return captureDir_;
   }
@@ -78,21 +108,53 @@ class PktCaptureManager {
   static void checkCaptureName(folly::StringPiece name);
 
  private:
+  typedef std::vector<std::shared_ptr<PktCapture>> CaptureList;
+
   // Forbidden copy constructor and assignment operator
   PktCaptureManager(PktCaptureManager const &) = delete;
   PktCaptureManager& operator=(PktCaptureManager const &) = delete;
 
+  /*
+   * Rebuild and publish the active capture snapshot from
+   * activeCaptures_. Must be called with mutex_ held, after any
+   * change to the active set.
+   */
+  void publishActiveCaptures();
+
   template<typename Fn>
   void invokeCaptures(const Fn& fn);
   void packetReceivedImpl(const RxPacket* pkt);
   void packetSentImpl(const TxPacket* pkt);
+  void ringPacketReceived(const RxPacket* pkt);
+  void ringPacketSent(const TxPacket* pkt);
 
   std::atomic<bool> capturesRunning_{false};
 
-  std::mutex mutex_;
+  // The always-on flight recorder rings, one per packet class.  These
+  // are created once at construction time (or left null when disabled),
+  // so the packet-path hooks can check them without any locking.
+  std::unique_ptr<PcapRingBuffer> rxRing_;
+  std::unique_ptr<PcapRingBuffer> txRing_;
+
+  /*
+   * An immutable snapshot of the active captures, republished (copy
+   * and swap) under mutex_ whenever the set changes. The packet path
+   * reads it the way SwSwitch publishes SwitchState: copy the
+   * shared_ptr under a spin lock and iterate with no further locking,
+   * so start/stop never stalls packet processing and a capture being
+   * forgotten stays alive until the last in-flight packet is done
+   * with it. PktCapture itself is safe to offer packets from several
+   * threads at once.
+   */
+  std::shared_ptr<const CaptureList> activeList_;
+  mutable folly::SpinLock activeListLock_;
+
+  // Serializes changes to the capture sets; never taken on the packet
+  // path.
+  mutable std::mutex mutex_;
   std::string captureDir_;
-  std::map<std::string, std::unique_ptr<PktCapture>> activeCaptures_;
-  std::map<std::string, std::unique_ptr<PktCapture>> inactiveCaptures_;
+  std::map<std::string, std::shared_ptr<PktCapture>> activeCaptures_;
+  std::map<std::string, std::shared_ptr<PktCapture>> inactiveCaptures_;
 };
 
 }} // facebook::fboss
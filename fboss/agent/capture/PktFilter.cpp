@@ -0,0 +1,222 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PktFilter.h"
+
+#include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/RxPacket.h"
+#include "fboss/agent/TxPacket.h"
+#include "fboss/agent/if/gen-cpp2/ctrl_types.h"
+
+#include <folly/io/Cursor.h>
+#include <algorithm>
+#include <cstring>
+
+using folly::io::Cursor;
+
+namespace {
+
+enum : uint16_t {
+  ETHERTYPE_VLAN = 0x8100,
+  ETHERTYPE_IPV4 = 0x0800,
+  ETHERTYPE_IPV6 = 0x86dd,
+};
+
+}
+
+namespace facebook { namespace fboss {
+
+PktFilter::PktFilter(const CaptureFilter& spec) {
+  addValueInsn(Op::PORT, spec.ports);
+  addValueInsn(Op::VLAN, spec.vlans);
+  addValueInsn(Op::ETHERTYPE, spec.ethertypes);
+  addValueInsn(Op::PROTO, spec.ipProtocols);
+  addPrefixInsn(Op::SRC_PREFIX, spec.srcPrefixes);
+  addPrefixInsn(Op::DST_PREFIX, spec.dstPrefixes);
+}
+
+void PktFilter::addValueInsn(Op op, const std::vector<int32_t>& values) {
+  if (values.empty()) {
+    return;
+  }
+  Insn insn;
+  insn.op = op;
+  insn.begin = values_.size();
+  for (auto value : values) {
+    values_.push_back(value);
+  }
+  insn.end = values_.size();
+  // Sorted operands let the evaluator binary search the alternatives.
+  std::sort(values_.begin() + insn.begin, values_.begin() + insn.end);
+  program_.push_back(insn);
+}
+
+void PktFilter::addPrefixInsn(Op op, const std::vector<IpPrefix>& prefixes) {
+  if (prefixes.empty()) {
+    return;
+  }
+  Insn insn;
+  insn.op = op;
+  insn.begin = prefixes_.size();
+  for (const auto& spec : prefixes) {
+    auto addr = network::toIPAddress(spec.ip);
+    if (spec.prefixLength < 0 ||
+        spec.prefixLength > static_cast<int32_t>(addr.bitCount())) {
+      throw FbossError("invalid capture filter mask length ",
+                       spec.prefixLength, " for prefix ", addr.str());
+    }
+    Prefix prefix;
+    memcpy(prefix.bytes, addr.bytes(), addr.byteCount());
+    prefix.maskLen = spec.prefixLength;
+    prefix.v6 = addr.isV6();
+    prefixes_.push_back(prefix);
+  }
+  insn.end = prefixes_.size();
+  program_.push_back(insn);
+}
+
+bool PktFilter::matches(const RxPacket* pkt) const {
+  if (matchesAll()) {
+    return true;
+  }
+  ParsedPkt parsed;
+  parsed.port = pkt->getSrcPort();
+  parsed.vlan = pkt->getSrcVlan();
+  Cursor cursor(pkt->buf());
+  try {
+    auto l3Offset = pkt->getL3HdrOffset();
+    if (l3Offset >= sizeof(uint16_t)) {
+      // The rx handlers annotate where L3 starts, so we can skip the L2
+      // parse; the ethertype is the last two bytes of the L2 header.
+      cursor.skip(l3Offset - sizeof(uint16_t));
+      parsed.etherType = cursor.readBE<uint16_t>();
+    } else {
+      parseL2(cursor, &parsed);
+    }
+    parseL3(cursor, &parsed);
+  } catch (const std::out_of_range&) {
+    // Truncated packet: whatever we parsed before running out of data
+    // is still matched against the program below.
+  }
+  return evaluate(parsed);
+}
+
+bool PktFilter::matches(const TxPacket* pkt) const {
+  if (matchesAll()) {
+    return true;
+  }
+  ParsedPkt parsed;
+  Cursor cursor(pkt->buf());
+  try {
+    parseL2(cursor, &parsed);
+    parseL3(cursor, &parsed);
+  } catch (const std::out_of_range&) {
+    // see above
+  }
+  return evaluate(parsed);
+}
+
+void PktFilter::parseL2(Cursor& cursor, ParsedPkt* parsed) {
+  cursor.skip(12); // dst + src MAC
+  auto etherType = cursor.readBE<uint16_t>();
+  while (etherType == ETHERTYPE_VLAN) {
+    auto tag = cursor.readBE<uint16_t>();
+    if (parsed->vlan < 0) {
+      parsed->vlan = tag & 0x0fff;
+    }
+    etherType = cursor.readBE<uint16_t>();
+  }
+  parsed->etherType = etherType;
+}
+
+void PktFilter::parseL3(Cursor& cursor, ParsedPkt* parsed) {
+  if (parsed->etherType == ETHERTYPE_IPV4) {
+    cursor.skip(9); // version/IHL through fragment offset, TTL
+    parsed->proto = cursor.read<uint8_t>();
+    cursor.skip(2); // checksum
+    cursor.pull(parsed->addrStorage, 8);
+    parsed->srcAddr = parsed->addrStorage;
+    parsed->dstAddr = parsed->addrStorage + 4;
+    parsed->addrLen = 4;
+  } else if (parsed->etherType == ETHERTYPE_IPV6) {
+    cursor.skip(6); // version/class/flow label, payload length
+    parsed->proto = cursor.read<uint8_t>();
+    cursor.skip(1); // hop limit
+    cursor.pull(parsed->addrStorage, 32);
+    parsed->srcAddr = parsed->addrStorage;
+    parsed->dstAddr = parsed->addrStorage + 16;
+    parsed->addrLen = 16;
+  }
+}
+
+bool PktFilter::evaluate(const ParsedPkt& parsed) const {
+  auto valueListed = [&] (const Insn& insn, int32_t value) {
+    if (value < 0) {
+      return false;
+    }
+    return std::binary_search(values_.begin() + insn.begin,
+                              values_.begin() + insn.end,
+                              static_cast<uint32_t>(value));
+  };
+  auto prefixListed = [&] (const Insn& insn, const uint8_t* addr) {
+    if (addr == nullptr) {
+      return false;
+    }
+    for (uint32_t idx = insn.begin; idx < insn.end; ++idx) {
+      const auto& prefix = prefixes_[idx];
+      if (prefix.v6 != (parsed.addrLen == 16)) {
+        continue;
+      }
+      unsigned int fullBytes = prefix.maskLen / 8;
+      if (memcmp(addr, prefix.bytes, fullBytes) != 0) {
+        continue;
+      }
+      unsigned int tailBits = prefix.maskLen % 8;
+      if (tailBits != 0) {
+        uint8_t mask = 0xff << (8 - tailBits);
+        if ((addr[fullBytes] & mask) != (prefix.bytes[fullBytes] & mask)) {
+          continue;
+        }
+      }
+      return true;
+    }
+    return false;
+  };
+
+  for (const auto& insn : program_) {
+    bool hit = false;
+    switch (insn.op) {
+      case Op::PORT:
+        hit = valueListed(insn, parsed.port);
+        break;
+      case Op::VLAN:
+        hit = valueListed(insn, parsed.vlan);
+        break;
+      case Op::ETHERTYPE:
+        hit = valueListed(insn, parsed.etherType);
+        break;
+      case Op::PROTO:
+        hit = valueListed(insn, parsed.proto);
+        break;
+      case Op::SRC_PREFIX:
+        hit = prefixListed(insn, parsed.srcAddr);
+        break;
+      case Op::DST_PREFIX:
+        hit = prefixListed(insn, parsed.dstAddr);
+        break;
+    }
+    if (!hit) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}} // facebook::fboss
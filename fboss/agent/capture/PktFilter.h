@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace folly { namespace io {
+class Cursor;
+}}
+
+namespace facebook { namespace fboss {
+
+class CaptureFilter;
+class IpPrefix;
+class RxPacket;
+class TxPacket;
+
+/*
+ * A packet filter for capture jobs.
+ *
+ * The filter is built once, at capture start, from the CaptureFilter
+ * thrift spec: each predicate (ingress port, vlan, ethertype, IP
+ * protocol, source/destination prefix) is compiled into one instruction
+ * of a flat match program, with the allowed alternatives stored in a
+ * contiguous operand pool. Evaluating a packet parses its headers once
+ * and then runs the program straight through; the packet matches if
+ * every instruction accepts it (alternatives within one instruction are
+ * OR'ed, instructions are AND'ed). An empty spec compiles to an empty
+ * program, which matches every packet.
+ */
+class PktFilter {
+ public:
+  // A filter that matches every packet.
+  PktFilter() {}
+
+  // Compile a filter from the thrift spec. Throws FbossError if the
+  // spec is malformed (e.g. a prefix whose mask is longer than the
+  // address).
+  explicit PktFilter(const CaptureFilter& spec);
+
+  // Default copy and move are fine: the compiled program is plain data.
+  PktFilter(const PktFilter&) = default;
+  PktFilter& operator=(const PktFilter&) = default;
+  PktFilter(PktFilter&&) = default;
+  PktFilter& operator=(PktFilter&&) = default;
+
+  bool matchesAll() const {
+    return program_.empty();
+  }
+
+  /*
+   * Evaluate the filter against a packet.
+   *
+   * For received packets the port and vlan come from the rx metadata;
+   * for transmitted packets the vlan is taken from the 802.1Q tag and
+   * there is no port, so a filter with a port predicate never matches
+   * tx packets.
+   */
+  bool matches(const RxPacket* pkt) const;
+  bool matches(const TxPacket* pkt) const;
+
+ private:
+  enum class Op : uint8_t {
+    PORT,        // ingress port is one of the listed values
+    VLAN,        // vlan is one of the listed values
+    ETHERTYPE,   // ethertype is one of the listed values
+    PROTO,       // IPv4 protocol / IPv6 next header is listed
+    SRC_PREFIX,  // L3 source address is inside one of the prefixes
+    DST_PREFIX,  // L3 destination address is inside one of the prefixes
+  };
+
+  /*
+   * One instruction of the compiled program. Value instructions
+   * reference a range in values_, prefix instructions a range in
+   * prefixes_.
+   */
+  struct Insn {
+    Op op;
+    uint32_t begin{0};
+    uint32_t end{0};
+  };
+
+  // A prefix compiled down to a masked byte compare.
+  struct Prefix {
+    uint8_t bytes[16];
+    uint8_t maskLen{0};
+    bool v6{false};
+  };
+
+  // Header fields extracted by the single parse pass.
+  struct ParsedPkt {
+    int32_t port{-1};       // -1: no port (tx packets)
+    int32_t vlan{-1};       // -1: untagged and no rx metadata
+    uint16_t etherType{0};
+    int32_t proto{-1};      // -1: not an IP packet
+    const uint8_t* srcAddr{nullptr};
+    const uint8_t* dstAddr{nullptr};
+    uint8_t addrLen{0};     // 4, 16, or 0 if not an IP packet
+    // Backing storage for srcAddr/dstAddr when the addresses straddle
+    // IOBuf chain boundaries.
+    uint8_t addrStorage[32];
+  };
+
+  void addValueInsn(Op op, const std::vector<int32_t>& values);
+  void addPrefixInsn(Op op, const std::vector<IpPrefix>& prefixes);
+
+  static void parseL2(folly::io::Cursor& cursor, ParsedPkt* parsed);
+  static void parseL3(folly::io::Cursor& cursor, ParsedPkt* parsed);
+
+  bool evaluate(const ParsedPkt& parsed) const;
+
+  std::vector<Insn> program_;
+  std::vector<uint32_t> values_;
+  std::vector<Prefix> prefixes_;
+};
+
+}} // facebook::fboss
@@ -72,3 +72,28 @@ TEST(PcapQueueTest, SimpleAdd) {
   ByteRange waitedPktData = waitedPktBufClone->coalesce();
   EXPECT_EQ(expectedPktData, waitedPktData);
 }
+
+TEST(PcapQueueTest, BatchAddAndDrop) {
+  PcapQueue queue(4);
+
+  auto pkt = MockRxPacket::fromHex("02 00 01 00 00 01  02 00 02 01 02 03");
+  pkt->padToLength(68);
+  pkt->setSrcPort(PortID(1));
+  pkt->setSrcVlan(VlanID(1));
+
+  // Batch enqueue more packets than the ring holds; the overflow is
+  // dropped and accounted, not silently lost.
+  std::vector<PcapPkt> batch;
+  for (int i = 0; i < 6; ++i) {
+    batch.emplace_back(pkt.get());
+  }
+  queue.addPkts(&batch);
+  EXPECT_TRUE(batch.empty());
+  EXPECT_EQ(2, queue.numDropped());
+
+  queue.finish();
+  std::vector<PcapPkt> pkts;
+  EXPECT_TRUE(queue.wait(&pkts));
+  EXPECT_EQ(4, pkts.size());
+  EXPECT_FALSE(queue.wait(&pkts));
+}
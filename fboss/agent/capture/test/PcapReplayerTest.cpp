@@ -0,0 +1,137 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PcapReplayer.h"
+#include "fboss/agent/capture/PcapWriter.h"
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/ScopeGuard.h>
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+
+namespace {
+
+std::unique_ptr<MockRxPacket> makePacket() {
+  auto pkt = MockRxPacket::fromHex(
+    // dst mac, src mac
+    "02 00 01 00 00 01  02 00 02 01 02 03"
+    // 802.1q, VLAN 1
+    "81 00 00 01"
+    // IPv4
+    "08 00"
+    // Version(4), IHL(5), DSCP(0), ECN(0), Total Length(20)
+    "45  00  00 14"
+    // Identification(0), Flags(0), Fragment offset(0)
+    "00 00  00 00"
+    // TTL(31), Protocol(6), Checksum (0, fake)
+    "1F  06  00 00"
+    // Source IP (1.2.3.4)
+    "01 02 03 04"
+    // Destination IP (10.0.0.10)
+    "0a 00 00 0a"
+  );
+  pkt->padToLength(68);
+  pkt->setSrcPort(PortID(1));
+  pkt->setSrcVlan(VlanID(1));
+  return pkt;
+}
+
+void writeCapture(const char* path, uint32_t numPkts) {
+  PcapWriter writer(path, true);
+  auto pkt = makePacket();
+  for (uint32_t n = 0; n < numPkts; ++n) {
+    writer.addPkt(pkt.get());
+  }
+  writer.finish();
+  ASSERT_EQ(0, writer.numDropped());
+}
+
+} // unnamed namespace
+
+TEST(PcapReplayerTest, Replay) {
+  char tmpPath[] = "fbossPcapReplayTest.XXXXXX";
+  int tmpFD = mkstemp(tmpPath);
+  folly::checkUnixError(tmpFD, "failed to create temporary file");
+  SCOPE_EXIT {
+    close(tmpFD);
+    unlink(tmpPath);
+  };
+
+  uint32_t numPkts = 1000;
+  writeCapture(tmpPath, numPkts);
+
+  PcapReplayer replayer(tmpPath);
+  EXPECT_EQ(numPkts, replayer.pkts().size());
+  for (const auto& pkt : replayer.pkts()) {
+    EXPECT_EQ(68, pkt.data.size());
+  }
+
+  // Replay as fast as possible and make sure every packet is delivered
+  // with the original contents.
+  auto original = makePacket();
+  uint64_t seen = 0;
+  auto delivered = replayer.replay(
+      [&](const PcapReplayer::Pkt& pkt) {
+        ++seen;
+        EXPECT_EQ(68, pkt.data.size());
+        EXPECT_EQ(0, memcmp(pkt.data.data(),
+                            original->buf()->data(),
+                            pkt.data.size()));
+      },
+      0 /* no timing */);
+  EXPECT_EQ(numPkts, delivered);
+  EXPECT_EQ(numPkts, seen);
+}
+
+TEST(PcapReplayerTest, Loop) {
+  char tmpPath[] = "fbossPcapReplayTest.XXXXXX";
+  int tmpFD = mkstemp(tmpPath);
+  folly::checkUnixError(tmpFD, "failed to create temporary file");
+  SCOPE_EXIT {
+    close(tmpFD);
+    unlink(tmpPath);
+  };
+
+  uint32_t numPkts = 10;
+  writeCapture(tmpPath, numPkts);
+
+  PcapReplayer replayer(tmpPath);
+  uint64_t seen = 0;
+  auto delivered = replayer.replay(
+      [&](const PcapReplayer::Pkt&) { ++seen; },
+      0 /* no timing */, 5 /* loops */);
+  EXPECT_EQ(numPkts * 5, delivered);
+  EXPECT_EQ(numPkts * 5, seen);
+}
+
+TEST(PcapReplayerTest, BadFile) {
+  char tmpPath[] = "fbossPcapReplayTest.XXXXXX";
+  int tmpFD = mkstemp(tmpPath);
+  folly::checkUnixError(tmpFD, "failed to create temporary file");
+  SCOPE_EXIT {
+    close(tmpFD);
+    unlink(tmpPath);
+  };
+
+  // Not a pcap file at all
+  folly::writeFile(std::string("this is not a capture"), tmpPath);
+  EXPECT_THROW(PcapReplayer{tmpPath}, FbossError);
+
+  // Valid capture, truncated mid-record
+  writeCapture(tmpPath, 10);
+  std::string contents;
+  ASSERT_TRUE(folly::readFile(tmpPath, contents));
+  contents.resize(contents.size() - 30);
+  ASSERT_TRUE(folly::writeFile(contents, tmpPath));
+  EXPECT_THROW(PcapReplayer{tmpPath}, FbossError);
+}
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PcapRingBuffer.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+
+namespace {
+
+std::unique_ptr<MockRxPacket> makePkt(uint8_t srcPort) {
+  auto pkt = MockRxPacket::fromHex(
+    // dst mac, src mac
+    "02 00 01 00 00 01  02 00 02 01 02 03"
+    // 802.1q, VLAN 1
+    "81 00 00 01"
+    // IPv4
+    "08 00"
+    // Version(4), IHL(5), DSCP(0), ECN(0), Total Length(20)
+    "45  00  00 14"
+    // Identification(0), Flags(0), Fragment offset(0)
+    "00 00  00 00"
+    // TTL(31), Protocol(6), Checksum (0, fake)
+    "1F  06  00 00"
+    // Source IP (1.2.3.4)
+    "01 02 03 04"
+    // Destination IP (10.0.0.10)
+    "0a 00 00 0a"
+  );
+  pkt->padToLength(68);
+  // Use the source port to tell the packets apart
+  pkt->setSrcPort(PortID(srcPort));
+  pkt->setSrcVlan(VlanID(1));
+  return pkt;
+}
+
+}
+
+TEST(PcapRingBufferTest, NotFull) {
+  PcapRingBuffer ring(10);
+  for (uint8_t n = 0; n < 5; ++n) {
+    ring.addPkt(makePkt(n).get());
+  }
+
+  auto pkts = ring.extract();
+  ASSERT_EQ(5, pkts.size());
+  for (uint8_t n = 0; n < 5; ++n) {
+    EXPECT_EQ(PortID(n), pkts[n].port());
+  }
+
+  // The ring should be empty after an extract
+  EXPECT_EQ(0, ring.extract().size());
+}
+
+TEST(PcapRingBufferTest, Wrap) {
+  PcapRingBuffer ring(10);
+  // Add 25 packets to a 10 entry ring; only the last 10 should survive,
+  // in arrival order.
+  for (uint8_t n = 0; n < 25; ++n) {
+    ring.addPkt(makePkt(n).get());
+  }
+
+  auto pkts = ring.extract();
+  ASSERT_EQ(10, pkts.size());
+  for (uint8_t n = 0; n < 10; ++n) {
+    EXPECT_EQ(PortID(15 + n), pkts[n].port());
+  }
+
+  // The ring should keep working after an extract
+  ring.addPkt(makePkt(42).get());
+  pkts = ring.extract();
+  ASSERT_EQ(1, pkts.size());
+  EXPECT_EQ(PortID(42), pkts[0].port());
+}
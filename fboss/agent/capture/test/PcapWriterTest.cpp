@@ -63,6 +63,9 @@ TEST(PcapWriterTest, Write) {
   // We add 1000 packets, and the default capacity is larger than that,
   // so there shouldn't be any dropped packets
   EXPECT_EQ(0, writer.numDropped());
+  // Each record is a 16 byte pcap packet header plus the 68 byte packet.
+  // The global file header is not counted.
+  EXPECT_EQ(numPkts * (16 + 68), writer.bytesWritten());
 
   auto pcapPkts = readPcapFile(tmpPath);
   EXPECT_EQ(numPkts, pcapPkts.size());
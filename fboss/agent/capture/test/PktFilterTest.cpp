@@ -0,0 +1,193 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/capture/PktFilter.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+#include "fboss/agent/if/gen-cpp2/ctrl_types.h"
+
+#include <folly/IPAddress.h>
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using facebook::network::toBinaryAddress;
+using folly::IPAddress;
+
+namespace {
+
+// A TCP-in-IPv4 packet from 1.2.3.4 to 10.0.0.10, tagged with VLAN 1
+std::unique_ptr<MockRxPacket> makeV4Pkt() {
+  auto pkt = MockRxPacket::fromHex(
+    // dst mac, src mac
+    "02 00 01 00 00 01  02 00 02 01 02 03"
+    // 802.1q, VLAN 1
+    "81 00 00 01"
+    // IPv4
+    "08 00"
+    // Version(4), IHL(5), DSCP(0), ECN(0), Total Length(20)
+    "45  00  00 14"
+    // Identification(0), Flags(0), Fragment offset(0)
+    "00 00  00 00"
+    // TTL(31), Protocol(6), Checksum (0, fake)
+    "1F  06  00 00"
+    // Source IP (1.2.3.4)
+    "01 02 03 04"
+    // Destination IP (10.0.0.10)
+    "0a 00 00 0a"
+  );
+  pkt->padToLength(68);
+  pkt->setSrcPort(PortID(5));
+  pkt->setSrcVlan(VlanID(1));
+  return pkt;
+}
+
+// A UDP-in-IPv6 packet from 2401:db00::23 to 2401:db00:e32f::87, VLAN 2
+std::unique_ptr<MockRxPacket> makeV6Pkt() {
+  auto pkt = MockRxPacket::fromHex(
+    // dst mac, src mac
+    "02 00 01 00 00 01  02 00 02 01 02 03"
+    // 802.1q, VLAN 2
+    "81 00 00 02"
+    // IPv6
+    "86 dd"
+    // Version(6), Traffic class(0), Flow label(0)
+    "60 00 00 00"
+    // Payload length(8), Next header(17, UDP), Hop limit(255)
+    "00 08  11  ff"
+    // Source IP (2401:db00::23)
+    "24 01 db 00 00 00 00 00 00 00 00 00 00 00 00 23"
+    // Destination IP (2401:db00:e32f::87)
+    "24 01 db 00 e3 2f 00 00 00 00 00 00 00 00 00 87"
+  );
+  pkt->padToLength(82);
+  pkt->setSrcPort(PortID(7));
+  pkt->setSrcVlan(VlanID(2));
+  return pkt;
+}
+
+IpPrefix makePrefix(folly::StringPiece addr, int16_t len) {
+  IpPrefix prefix;
+  prefix.ip = toBinaryAddress(IPAddress(addr));
+  prefix.prefixLength = len;
+  return prefix;
+}
+
+} // unnamed namespace
+
+TEST(PktFilterTest, EmptyFilterMatchesAll) {
+  PktFilter filter;
+  EXPECT_TRUE(filter.matchesAll());
+  EXPECT_TRUE(filter.matches(makeV4Pkt().get()));
+  EXPECT_TRUE(filter.matches(makeV6Pkt().get()));
+
+  // An all-empty spec compiles to the same thing
+  CaptureFilter spec;
+  PktFilter compiled(spec);
+  EXPECT_TRUE(compiled.matchesAll());
+}
+
+TEST(PktFilterTest, PortAndVlan) {
+  CaptureFilter spec;
+  spec.ports = {3, 5, 9};
+  PktFilter portFilter(spec);
+  EXPECT_FALSE(portFilter.matchesAll());
+  EXPECT_TRUE(portFilter.matches(makeV4Pkt().get()));  // port 5
+  EXPECT_FALSE(portFilter.matches(makeV6Pkt().get())); // port 7
+
+  CaptureFilter vlanSpec;
+  vlanSpec.vlans = {2};
+  PktFilter vlanFilter(vlanSpec);
+  EXPECT_FALSE(vlanFilter.matches(makeV4Pkt().get()));
+  EXPECT_TRUE(vlanFilter.matches(makeV6Pkt().get()));
+}
+
+TEST(PktFilterTest, EthertypeAndProtocol) {
+  CaptureFilter spec;
+  spec.ethertypes = {0x86dd};
+  PktFilter v6Only(spec);
+  EXPECT_FALSE(v6Only.matches(makeV4Pkt().get()));
+  EXPECT_TRUE(v6Only.matches(makeV6Pkt().get()));
+
+  CaptureFilter protoSpec;
+  protoSpec.ipProtocols = {6}; // TCP
+  PktFilter tcpOnly(protoSpec);
+  EXPECT_TRUE(tcpOnly.matches(makeV4Pkt().get()));
+  EXPECT_FALSE(tcpOnly.matches(makeV6Pkt().get()));
+}
+
+TEST(PktFilterTest, Prefixes) {
+  CaptureFilter spec;
+  spec.srcPrefixes = {
+    makePrefix("192.168.0.0", 16),
+    makePrefix("1.2.3.0", 24),
+  };
+  PktFilter srcFilter(spec);
+  EXPECT_TRUE(srcFilter.matches(makeV4Pkt().get()));  // 1.2.3.4
+  EXPECT_FALSE(srcFilter.matches(makeV6Pkt().get())); // wrong family
+
+  CaptureFilter dstSpec;
+  dstSpec.dstPrefixes = {makePrefix("2401:db00:e32f::", 48)};
+  PktFilter dstFilter(dstSpec);
+  EXPECT_FALSE(dstFilter.matches(makeV4Pkt().get()));
+  EXPECT_TRUE(dstFilter.matches(makeV6Pkt().get()));
+
+  // A non-byte-aligned mask: 10.0.0.10 is inside 10.0.0.8/29 but
+  // outside 10.0.0.0/29
+  CaptureFilter oddSpec;
+  oddSpec.dstPrefixes = {makePrefix("10.0.0.8", 29)};
+  EXPECT_TRUE(PktFilter(oddSpec).matches(makeV4Pkt().get()));
+  oddSpec.dstPrefixes = {makePrefix("10.0.0.0", 29)};
+  EXPECT_FALSE(PktFilter(oddSpec).matches(makeV4Pkt().get()));
+}
+
+TEST(PktFilterTest, PredicatesAreAnded) {
+  CaptureFilter spec;
+  spec.vlans = {1, 2};
+  spec.ipProtocols = {17}; // UDP
+  PktFilter filter(spec);
+  EXPECT_FALSE(filter.matches(makeV4Pkt().get())); // vlan ok, TCP
+  EXPECT_TRUE(filter.matches(makeV6Pkt().get()));  // vlan ok, UDP
+}
+
+TEST(PktFilterTest, AnnotatedL3Offset) {
+  // The filter should honor the rx handlers' L3 offset annotation and
+  // still find the ethertype and L3 fields behind the vlan tag.
+  auto pkt = makeV4Pkt();
+  pkt->setL3HdrOffset(18);
+  CaptureFilter spec;
+  spec.ethertypes = {0x0800};
+  spec.srcPrefixes = {makePrefix("1.2.3.0", 24)};
+  EXPECT_TRUE(PktFilter(spec).matches(pkt.get()));
+}
+
+TEST(PktFilterTest, TruncatedPacket) {
+  // A runt that ends before the IP header: L2 predicates still work,
+  // L3 predicates never match.
+  auto pkt = MockRxPacket::fromHex(
+    "02 00 01 00 00 01  02 00 02 01 02 03"
+    "81 00 00 01"
+    "08 00");
+  pkt->setSrcPort(PortID(5));
+  pkt->setSrcVlan(VlanID(1));
+
+  CaptureFilter l2Spec;
+  l2Spec.ethertypes = {0x0800};
+  EXPECT_TRUE(PktFilter(l2Spec).matches(pkt.get()));
+
+  CaptureFilter l3Spec;
+  l3Spec.ipProtocols = {6};
+  EXPECT_FALSE(PktFilter(l3Spec).matches(pkt.get()));
+}
+
+TEST(PktFilterTest, BadPrefix) {
+  CaptureFilter spec;
+  spec.srcPrefixes = {makePrefix("10.0.0.0", 33)};
+  EXPECT_THROW(PktFilter filter(spec), FbossError);
+}
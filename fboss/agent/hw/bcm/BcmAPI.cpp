@@ -12,6 +12,7 @@
 #include "fboss/agent/hw/bcm/BcmError.h"
 #include "fboss/agent/hw/bcm/BcmUnit.h"
 
+#include <folly/Conv.h>
 #include <folly/Memory.h>
 #include <folly/String.h>
 #include <folly/io/Cursor.h>
@@ -73,6 +74,23 @@ void BcmAPI::unitDestroyed(BcmUnit* unit) {
   }
 }
 
+std::string BcmAPI::getConfigValue(StringPiece name,
+                                   StringPiece defaultValue) {
+  auto config = getHwConfig();
+  auto it = config.find(name);
+  return it == config.end() ? defaultValue.str() : it->second;
+}
+
+bool BcmAPI::isAlpmEnabled() {
+  // l3_alpm_enable: 0 - disabled, 1 - enabled, 2 - enabled with
+  // combined mode for parallel IPv4/IPv6 lookup
+  return getConfigValue("l3_alpm_enable", "0") != "0";
+}
+
+int BcmAPI::getNumRxChannels() {
+  return folly::to<int>(getConfigValue("rx_channels", "1"));
+}
+
 BcmUnit* BcmAPI::getUnit(int unit) {
   if (unit < 0 || unit > getMaxSwitches()) {
     throw FbossError("invalid BCM unit number ", unit);
@@ -101,6 +101,31 @@ class BcmAPI {
   typedef folly::StringKeyedUnorderedMap<std::string> HwConfigMap;
   static HwConfigMap getHwConfig();
 
+  /*
+   * Get the value of a single hw config property, or the given default
+   * if the property is not set.
+   */
+  static std::string getConfigValue(folly::StringPiece name,
+                                    folly::StringPiece defaultValue);
+
+  /*
+   * Whether the SDK was configured to run the L3 route tables in ALPM
+   * (algorithmic LPM) mode rather than pure TCAM. ALPM trades TCAM
+   * entries for bucketed SRAM storage and is required for large FIBs.
+   * The mode is fixed at SDK init time via the l3_alpm_enable config
+   * property and cannot change across a warm boot.
+   */
+  static bool isAlpmEnabled();
+
+  /*
+   * Number of rx DMA channels used to receive packets on the CPU, from
+   * the rx_channels hw config property. The SDK services each channel
+   * independently, so spreading the CPU CoS queues across multiple
+   * channels keeps one flooded queue from stalling rx DMA for the rest.
+   * Defaults to 1, the stock single channel SDK setup.
+   */
+  static int getNumRxChannels();
+
  private:
   // Forbidden copy constructor and assignment operator
   BcmAPI(BcmAPI const &) = delete;
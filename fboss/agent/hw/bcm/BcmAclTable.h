@@ -33,6 +33,9 @@ class BcmAclTable {
   // return 0 if range does not exist
   uint32_t getAclRangeRefCount(const AclRange& range) const;
   uint32_t getAclRangeCount() const;
+  uint32_t getAclEntryCount() const {
+    return aclEntryMap_.size();
+  }
 
  private:
   BcmAclRange* incRefOrCreateBcmAclRange(const AclRange& range);
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/hw/bcm/BcmCosManager.h"
+
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/hw/bcm/BcmSwitch.h"
+
+#include <folly/Conv.h>
+#include <glog/logging.h>
+
+using std::chrono::duration_cast;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+
+namespace {
+// Number of CoS queues on the CPU port of the chips we run on.
+constexpr int kNumCpuQueues = 8;
+}
+
+namespace facebook { namespace fboss {
+
+BcmCosManager::BcmCosManager(const BcmSwitch* hw) : hw_(hw) {}
+
+void BcmCosManager::programCpuQueues(
+    const std::vector<cfg::CPUQueueConfig>& queues) {
+  // Queues the config does not mention keep their current weight.
+  std::vector<int> weights(kNumCpuQueues, 1);
+
+  for (const auto& queue : queues) {
+    if (queue.id < 0 || queue.id >= kNumCpuQueues) {
+      throw FbossError("CPU queue id ", queue.id, " out of range [0, ",
+                       kNumCpuQueues, ")");
+    }
+    if (queue.weight <= 0) {
+      throw FbossError("CPU queue ", queue.id,
+                       " has non-positive weight ", queue.weight);
+    }
+    weights[queue.id] = queue.weight;
+    for (auto reason : queue.rxReasons) {
+      setReasonMapping(queue.id, reason);
+    }
+    if (queue.__isset.maxPps) {
+      setQueueRate(queue.id, queue.maxPps);
+    }
+    // Start tracking drops on every queue the config cares about.
+    queueDropCounters_.emplace(
+        std::piecewise_construct,
+        std::forward_as_tuple(queue.id),
+        std::forward_as_tuple(
+            folly::to<std::string>("cpu.queue", queue.id, ".drops"),
+            stats::SUM, stats::RATE));
+    VLOG(1) << "programmed CPU queue " << queue.id << ": weight "
+            << queue.weight << ", "
+            << (queue.__isset.maxPps
+                    ? folly::to<std::string>(queue.maxPps, " pps")
+                    : "unpoliced")
+            << ", " << queue.rxReasons.size() << " rx reason(s)";
+  }
+  setSchedulerWeights(weights);
+}
+
+void BcmCosManager::updateCounters() {
+  auto now = duration_cast<seconds>(system_clock::now().time_since_epoch());
+  for (auto& entry : queueDropCounters_) {
+    entry.second.updateValue(now, getQueueDroppedPackets(entry.first));
+  }
+}
+
+}} // facebook::fboss
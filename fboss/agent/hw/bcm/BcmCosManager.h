@@ -9,13 +9,65 @@
  */
 #pragma once
 
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/stats/MonotonicCounter.h"
+#include "fboss/agent/gen-cpp2/switch_config_types.h"
+
 namespace facebook { namespace fboss {
 
+class BcmSwitch;
+
+/*
+ * BcmCosManager programs the CPU CoS queues: which rx reasons are
+ * steered to which queue, the per-queue packet rate limits and the
+ * scheduler weights between the queues.
+ *
+ * With every trap reason landing on the same queue, an ARP or LLDP
+ * flood can crowd BGP and slow-path forwarded packets out of the CPU
+ * path entirely. Steering protocol traffic to its own policed queues
+ * bounds how much of the CPU pipeline any one reason can consume, so
+ * protocol latency is protected by construction rather than by luck.
+ */
 class BcmCosManager {
-public:
-  BcmCosManager() {}
-  // This is to enable RTTI so that we can downcast.
+ public:
+  explicit BcmCosManager(const BcmSwitch* hw);
+  // This is virtual to enable RTTI so that we can downcast.
   virtual ~BcmCosManager() {}
+
+  /*
+   * Program the CPU queue settings from the applied config. Called from
+   * BcmSwitch whenever a state delta changes the switch settings;
+   * programming is idempotent, so reapplying an unchanged config is
+   * harmless.
+   */
+  void programCpuQueues(const std::vector<cfg::CPUQueueConfig>& queues);
+
+  /*
+   * Refresh the cumulative per-queue drop counters from hardware.
+   * Called from BcmSwitch::updateStats(), alongside the port counters.
+   */
+  void updateCounters();
+
+ private:
+  // Hardware primitives. These live in a separate translation unit
+  // because not all of their SDK entry points are available through
+  // opennsl; see oss/BcmCosManager.cpp.
+  void setReasonMapping(int queue, cfg::PacketRxReason reason);
+  void setQueueRate(int queue, int pps);
+  void setSchedulerWeights(const std::vector<int>& weights);
+  uint64_t getQueueDroppedPackets(int queue);
+
+  // Forbidden copy constructor and assignment operator
+  BcmCosManager(const BcmCosManager&) = delete;
+  BcmCosManager& operator=(const BcmCosManager&) = delete;
+
+  const BcmSwitch* hw_;
+  // Drop counters for the queues named in the config, exported as
+  // cpu.queueN.drops
+  std::map<int, stats::MonotonicCounter> queueDropCounters_;
 };
 
-}}
+}} // facebook::fboss
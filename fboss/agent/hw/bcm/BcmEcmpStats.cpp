@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/hw/bcm/BcmEcmpStats.h"
+
+#include "common/stats/ServiceData.h"
+#include "fboss/agent/hw/bcm/BcmEgress.h"
+#include "fboss/agent/hw/bcm/BcmHost.h"
+#include "fboss/agent/hw/bcm/BcmPort.h"
+#include "fboss/agent/hw/bcm/BcmPortTable.h"
+#include "fboss/agent/hw/bcm/BcmSwitch.h"
+
+#include <folly/Conv.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+
+DEFINE_int32(ecmp_imbalance_ratio, 3,
+             "Flag an ECMP group as imbalanced when its busiest member "
+             "carried more than this many times the bytes of its idlest "
+             "member over the stats interval");
+
+namespace facebook { namespace fboss {
+
+void BcmEcmpStats::refresh() {
+  std::vector<GroupStats> groupStats;
+  decltype(prevMemberBytes_) memberBytes;
+  auto hostTable = hw_->getHostTable();
+  auto portTable = hw_->getPortTable();
+  hostTable->forEachEcmpEgress([&](const BcmEcmpEgress& ecmp) {
+    GroupStats stats;
+    stats.group = ecmp.getID();
+    for (auto memberId : ecmp.paths()) {
+      auto port = hostTable->egressIdPort(memberId);
+      if (port == 0) {
+        continue;
+      }
+      auto bcmPort = portTable->getBcmPortIf(port);
+      if (!bcmPort) {
+        continue;
+      }
+      auto outBytes = bcmPort->getPortStats().outBytes_;
+      if (outBytes < 0) {
+        // Port stats not collected yet.
+        continue;
+      }
+      auto key = std::make_pair(stats.group, memberId);
+      memberBytes[key] = static_cast<uint64_t>(outBytes);
+      auto prev = prevMemberBytes_.find(key);
+      if (prev == prevMemberBytes_.end() ||
+          static_cast<uint64_t>(outBytes) < prev->second) {
+        // First sample for this member, or the counter went backwards
+        // (port stats re-initialized); no delta to report yet.
+        continue;
+      }
+      uint64_t delta = static_cast<uint64_t>(outBytes) - prev->second;
+      if (stats.membersSampled == 0 || delta > stats.maxMemberBytes) {
+        stats.maxMemberBytes = delta;
+        stats.maxMember = memberId;
+      }
+      if (stats.membersSampled == 0 || delta < stats.minMemberBytes) {
+        stats.minMemberBytes = delta;
+        stats.minMember = memberId;
+      }
+      ++stats.membersSampled;
+    }
+    if (stats.membersSampled > 1) {
+      groupStats.push_back(stats);
+    }
+  });
+  prevMemberBytes_.swap(memberBytes);
+
+  std::lock_guard<std::mutex> g(lock_);
+  groupStats_.swap(groupStats);
+}
+
+void BcmEcmpStats::publish() const {
+  std::vector<GroupStats> groupStats;
+  {
+    std::lock_guard<std::mutex> g(lock_);
+    groupStats = groupStats_;
+  }
+  int64_t imbalanced = 0;
+  int64_t worstRatioX100 = 0;
+  for (const auto& group : groupStats) {
+    // Floor the idlest member at one byte so the ratio stays finite; a
+    // truly cold member simply shows up as a huge ratio.
+    auto ratioX100 = static_cast<int64_t>(
+        group.maxMemberBytes * 100 /
+        std::max<uint64_t>(group.minMemberBytes, 1));
+    fbData->setCounter(
+        folly::to<std::string>("bcm.ecmp.", group.group, ".imbalance_x100"),
+        ratioX100);
+    worstRatioX100 = std::max(worstRatioX100, ratioX100);
+    if (ratioX100 > static_cast<int64_t>(FLAGS_ecmp_imbalance_ratio) * 100) {
+      ++imbalanced;
+      VLOG(1) << "ECMP group " << group.group << " looks imbalanced: member "
+              << group.maxMember << " carried " << group.maxMemberBytes
+              << " bytes vs member " << group.minMember << " with "
+              << group.minMemberBytes << " bytes over the last interval ("
+              << group.membersSampled << " members sampled)";
+    }
+  }
+  fbData->setCounter("bcm.ecmp.imbalanced_groups", imbalanced);
+  fbData->setCounter("bcm.ecmp.worst_imbalance_x100", worstRatioX100);
+}
+}}
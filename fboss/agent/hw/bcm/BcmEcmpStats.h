@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+extern "C" {
+#include <opennsl/types.h>
+}
+
+#include <boost/container/flat_map.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+class BcmSwitch;
+
+/*
+ * Per-ECMP-group load distribution statistics.
+ *
+ * OpenNSL exposes no per-egress (flex) counters, so true per-member
+ * packet counts aren't available through this SDK surface. Instead
+ * refresh() samples each member's egress port byte counter and turns
+ * the samples into per-interval deltas. That is a proxy: an ECMP
+ * member typically dominates its port's tx traffic, and two members
+ * egressing over the same port read the same counter, so what this
+ * really measures is the distribution across member ports. That is
+ * exactly the grain at which polarization hurts, and it needs no
+ * extra SDK round-trips beyond the per-port stats we already collect.
+ *
+ * refresh() walks the software host table and so must be called with
+ * the hw update lock held; publish() exports the last refreshed
+ * distribution and may be called from the stats thread without the
+ * lock, like BcmTableStats.
+ */
+class BcmEcmpStats {
+ public:
+  explicit BcmEcmpStats(const BcmSwitch* hw) : hw_(hw) {}
+  void refresh();
+  void publish() const;
+
+ private:
+  struct GroupStats {
+    opennsl_if_t group{0};
+    // Byte deltas of the busiest and idlest member over the interval.
+    uint64_t maxMemberBytes{0};
+    uint64_t minMemberBytes{0};
+    opennsl_if_t maxMember{0};
+    opennsl_if_t minMember{0};
+    uint32_t membersSampled{0};
+  };
+
+  // Forbidden copy constructor and assignment operator
+  BcmEcmpStats(BcmEcmpStats const&) = delete;
+  BcmEcmpStats& operator=(BcmEcmpStats const&) = delete;
+
+  const BcmSwitch* hw_{nullptr};
+
+  /*
+   * Previous cumulative out-byte sample per (group, member), used to
+   * turn the cumulative port counters into per-interval deltas.
+   * Rebuilt on every refresh, so state for removed groups and members
+   * ages out on its own. Only touched from refresh(), i.e. under the
+   * hw lock.
+   */
+  boost::container::flat_map<std::pair<opennsl_if_t, opennsl_if_t>, uint64_t>
+      prevMemberBytes_;
+
+  /*
+   * The last refreshed distribution, read by publish() from the stats
+   * thread, so all access goes through lock_.
+   */
+  mutable std::mutex lock_;
+  std::vector<GroupStats> groupStats_;
+};
+}}
@@ -137,10 +137,6 @@ void BcmEgress::program(opennsl_if_t intfId, opennsl_vrf_t vrf,
               << ((mac) ? mac->toString() : "to CPU") << " on unit "
               << hw_->getUnit() << " for ip: " << ip << " flags " << eObj.flags
               << " towards port " << eObj.port;
-      if (mac != nullptr) {
-        mac_ = *mac;
-      }
-      intfId_ = intfId;
     } else {
       // TODO(t10268453): How can we get here? The entries were not equivalent
       // when we entered this ' if (addOrUpdateEgress) ' condition. Is the
@@ -155,10 +151,19 @@ void BcmEgress::program(opennsl_if_t intfId, opennsl_vrf_t vrf,
       warmBootCache->egressId2EgressAndBool_end()) {
     warmBootCache->programmed(egressId2EgressAndBoolCitr);
   }
+  // Remember what this egress resolves to, whether or not the HW entry
+  // needed (re)programming above.
+  if (mac != nullptr) {
+    mac_ = *mac;
+  }
+  intfId_ = intfId;
+  port_ = mac ? port : 0;
+  action_ = action;
   CHECK_NE(id_, INVALID);
 }
 
 void BcmEgress::programToCPU() {
+  action_ = TO_CPU;
   auto egressFromCache = hw_->getWarmBootCache()->getToCPUEgressId();
   if (id_ == INVALID && egressFromCache != INVALID) {
     id_ = egressFromCache;
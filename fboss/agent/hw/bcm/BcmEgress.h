@@ -103,6 +103,24 @@ class BcmEgress : public BcmEgressBase {
     return egr.flags & OPENNSL_L3_DST_DISCARD;
   }
 
+  /*
+   * What this egress object is currently programmed with. Used to spot
+   * egress entries that duplicate the same resolved
+   * (action, intf, mac, port) tuple across hosts.
+   */
+  RouteForwardAction getAction() const {
+    return action_;
+  }
+  folly::MacAddress getMac() const {
+    return mac_;
+  }
+  opennsl_if_t getIntfId() const {
+    return intfId_;
+  }
+  opennsl_port_t getPort() const {
+    return port_;
+  }
+
  private:
   bool alreadyExists(const  opennsl_l3_egress_t& newEgress) const;
   void program(opennsl_if_t intfId, opennsl_vrf_t vrf,
@@ -110,6 +128,8 @@ class BcmEgress : public BcmEgressBase {
       opennsl_port_t port, RouteForwardAction action);
   folly::MacAddress mac_;
   opennsl_if_t intfId_{INVALID};
+  opennsl_port_t port_{0};
+  RouteForwardAction action_{DROP};
 };
 
 class BcmEcmpEgress : public BcmEgressBase {
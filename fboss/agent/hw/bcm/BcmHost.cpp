@@ -10,10 +10,12 @@
 #include "BcmHost.h"
 #include <string>
 #include <iostream>
+#include <tuple>
 
 #include "fboss/agent/Constants.h"
 #include "fboss/agent/state/Interface.h"
 #include "fboss/agent/hw/bcm/BcmError.h"
+#include "fboss/agent/hw/bcm/BcmStats.h"
 #include "fboss/agent/hw/bcm/BcmSwitch.h"
 #include "fboss/agent/hw/bcm/BcmEgress.h"
 #include "fboss/agent/hw/bcm/BcmIntf.h"
@@ -228,14 +230,15 @@ BcmHostTable::BcmHostTable(const BcmSwitch *hw) : hw_(hw) {
   auto port2EgressIds = std::make_shared<PortAndEgressIdsMap>();
   port2EgressIds->publish();
   setPort2EgressIdsInternal(port2EgressIds);
+  setEgressId2EcmpIdsInternal(std::make_shared<const EgressId2EcmpIds>());
 }
 
 BcmHostTable::~BcmHostTable() {
 }
 
-template<typename KeyT, typename HostT, typename... Args>
-HostT* BcmHostTable::incRefOrCreateBcmHost(
-    HostMap<KeyT, HostT>* map, const KeyT& key, Args... args) {
+template<typename MapT, typename... Args>
+BcmHostTable::HostTypeT<MapT>* BcmHostTable::incRefOrCreateBcmHost(
+    MapT* map, const typename MapT::key_type& key, Args... args) {
   auto ret = map->emplace(key, std::make_pair(nullptr, 1));
   auto& iter = ret.first;
   if (!ret.second) {
@@ -246,7 +249,8 @@ HostT* BcmHostTable::incRefOrCreateBcmHost(
   SCOPE_FAIL {
     map->erase(iter);
   };
-  auto newHost = std::make_unique<HostT>(hw_, key.first, key.second, args...);
+  auto newHost = std::make_unique<HostTypeT<MapT>>(
+      hw_, key.first, key.second, args...);
   auto hostPtr = newHost.get();
   iter->second.first = std::move(newHost);
   return hostPtr;
@@ -267,10 +271,10 @@ BcmEcmpHost* BcmHostTable::incRefOrCreateBcmEcmpHost(
   return incRefOrCreateBcmHost(&ecmpHosts_, std::make_pair(vrf, fwd));
 }
 
-template<typename KeyT, typename HostT, typename... Args>
-HostT* BcmHostTable::getBcmHostIf(const HostMap<KeyT, HostT>* map,
-                                  Args... args) const {
-  KeyT key{args...};
+template<typename MapT, typename... Args>
+BcmHostTable::HostTypeT<MapT>* BcmHostTable::getBcmHostIf(
+    const MapT* map, Args... args) const {
+  typename MapT::key_type key{args...};
   auto iter = map->find(key);
   if (iter == map->end()) {
     return nullptr;
@@ -306,10 +310,10 @@ BcmEcmpHost* BcmHostTable::getBcmEcmpHost(
   return host;
 }
 
-template<typename KeyT, typename HostT, typename... Args>
-HostT* BcmHostTable::derefBcmHost(HostMap<KeyT, HostT>* map,
-                                  Args... args) noexcept {
-  KeyT key{args...};
+template<typename MapT, typename... Args>
+BcmHostTable::HostTypeT<MapT>* BcmHostTable::derefBcmHost(
+    MapT* map, Args... args) noexcept {
+  typename MapT::key_type key{args...};
   auto iter = map->find(key);
   if (iter == map->end()) {
     return nullptr;
@@ -356,6 +360,9 @@ BcmEgressBase* BcmHostTable::derefEgress(opennsl_if_t egressId) {
     if (it->second.first->isEcmp()) {
       CHECK(numEcmpEgressProgrammed_ > 0);
       numEcmpEgressProgrammed_--;
+      updateEcmpMembership(
+          static_cast<const BcmEcmpEgress*>(it->second.first.get()),
+          false /*remove*/);
     }
     egressMap_.erase(egressId);
     return nullptr;
@@ -363,14 +370,75 @@ BcmEgressBase* BcmHostTable::derefEgress(opennsl_if_t egressId) {
   return it->second.first.get();
 }
 
+uint32_t BcmHostTable::numEgressDuplicates() const {
+  boost::container::flat_set<
+      std::tuple<int, opennsl_if_t, folly::MacAddress, opennsl_port_t>>
+      tuples;
+  tuples.reserve(egressMap_.size());
+  uint32_t numEgress = 0;
+  for (const auto& idAndEgress : egressMap_) {
+    const auto* egress = idAndEgress.second.first.get();
+    if (egress->isEcmp()) {
+      continue;
+    }
+    numEgress++;
+    const auto* bcmEgress = static_cast<const BcmEgress*>(egress);
+    tuples.emplace(
+        static_cast<int>(bcmEgress->getAction()),
+        bcmEgress->getIntfId(),
+        bcmEgress->getMac(),
+        bcmEgress->getPort());
+  }
+  return numEgress - tuples.size();
+}
+
+void BcmHostTable::forEachEcmpEgress(
+    const std::function<void(const BcmEcmpEgress&)>& fn) const {
+  for (const auto& idAndEgress : egressMap_) {
+    const auto* egress = idAndEgress.second.first.get();
+    if (!egress->isEcmp()) {
+      continue;
+    }
+    fn(*static_cast<const BcmEcmpEgress*>(egress));
+  }
+}
+
 opennsl_port_t BcmHostTable::egressIdPort(opennsl_if_t egressId) const {
   auto itr = egressId2Port_.find(egressId);
   return itr == egressId2Port_.end() ? 0 : itr->second;
 }
 
+void BcmHostTable::startProgrammingBatch() {
+  CHECK(!batchInProgress_);
+  batchInProgress_ = true;
+  pendingPort2EgressIds_ = getPortAndEgressIdsMap()->clone();
+}
+
+void BcmHostTable::commitProgrammingBatch() {
+  CHECK(batchInProgress_);
+  batchInProgress_ = false;
+  // One publish for the whole batch
+  pendingPort2EgressIds_->publish();
+  setPort2EgressIdsInternal(std::move(pendingPort2EgressIds_));
+  // One resolution-changed notification per direction, covering all
+  // egress IDs touched by the batch. See updatePortEgressMapping for
+  // why resolution changes must be signalled to the ECMP groups.
+  if (!pendingResolvedPaths_.empty()) {
+    egressResolutionChangedHwLocked(pendingResolvedPaths_, true /*up*/);
+    pendingResolvedPaths_.clear();
+  }
+  if (!pendingUnresolvedPaths_.empty()) {
+    egressResolutionChangedHwLocked(
+        pendingUnresolvedPaths_, false /*went away*/);
+    pendingUnresolvedPaths_.clear();
+  }
+}
+
 void BcmHostTable::updatePortEgressMapping(opennsl_if_t egressId,
     opennsl_port_t oldPort, opennsl_port_t newPort) {
-  auto newMapping = getPortAndEgressIdsMap()->clone();
+  auto newMapping = batchInProgress_
+      ? pendingPort2EgressIds_
+      : getPortAndEgressIdsMap()->clone();
 
   if (oldPort) {
     egressId2Port_.erase(egressId);
@@ -393,11 +461,27 @@ void BcmHostTable::updatePortEgressMapping(opennsl_if_t egressId,
       newMapping->updatePortAndEgressIds(existingCloned);
     } else {
       PortAndEgressIdsFields::EgressIds egressIds;
-      egressIds.insert(egressId);
+      egressIds.push_back(egressId);
       auto toAdd = std::make_shared<PortAndEgressIds>(newPort, egressIds);
       newMapping->addPortAndEgressIds(toAdd);
     }
   }
+  BcmStats::get()->hostProgrammed();
+  if (batchInProgress_) {
+    // The batch commit publishes the pending map and raises the
+    // resolution-changed notifications in one go; just record which
+    // way this egress ID went. Within one batch the last state wins.
+    bool isUp = newPort;
+    bool wentDown = oldPort && !newPort;
+    if (isUp) {
+      pendingResolvedPaths_.insert(egressId);
+      pendingUnresolvedPaths_.erase(egressId);
+    } else if (wentDown) {
+      pendingUnresolvedPaths_.insert(egressId);
+      pendingResolvedPaths_.erase(egressId);
+    }
+    return;
+  }
   // Publish and replace with the updated mapping
   newMapping->publish();
   setPort2EgressIdsInternal(newMapping);
@@ -460,11 +544,40 @@ void BcmHostTable::insertBcmEgress(
   auto id = egress->getID();
   if (egress->isEcmp()) {
     numEcmpEgressProgrammed_++;
+    updateEcmpMembership(
+        static_cast<const BcmEcmpEgress*>(egress.get()), true /*add*/);
   }
   auto ret = egressMap_.emplace(id, std::make_pair(std::move(egress), 1));
   CHECK(ret.second);
 }
 
+void BcmHostTable::updateEcmpMembership(
+    const BcmEcmpEgress* ecmp, bool add) {
+  // Clone, modify and republish, the same way updatePortEgressMapping
+  // maintains the port -> egressIds map.
+  auto newIndex = std::make_shared<EgressId2EcmpIds>(*getEgressId2EcmpIds());
+  auto ecmpId = ecmp->getID();
+  for (const auto& path : ecmp->paths()) {
+    if (add) {
+      (*newIndex)[path].insert(ecmpId);
+    } else {
+      auto itr = newIndex->find(path);
+      CHECK(itr != newIndex->end());
+      itr->second.erase(ecmpId);
+      if (itr->second.empty()) {
+        newIndex->erase(itr);
+      }
+    }
+  }
+  setEgressId2EcmpIdsInternal(std::move(newIndex));
+}
+
+void BcmHostTable::setEgressId2EcmpIdsInternal(
+    std::shared_ptr<const EgressId2EcmpIds> newMap) {
+  folly::SpinLockGuard guard(egressId2EcmpIdsLock_);
+  egressId2EcmpIdsDontUseDirectly_.swap(newMap);
+}
+
 void BcmHostTable::warmBootHostEntriesSynced() {
   opennsl_port_config_t pcfg;
   auto rv = opennsl_port_config_get(hw_->getUnit(), &pcfg);
@@ -566,31 +679,53 @@ int BcmHostTable::removeAllEgressesFromEcmpCallback(
   return 0;
 }
 
+template <typename PathsT>
 void BcmHostTable::egressResolutionChangedHwNotLocked(
     int unit,
-    const Paths& affectedPaths,
-    bool up) {
+    const PathsT& affectedPaths,
+    bool up) const {
   CHECK(!up);
-  Paths tmpPaths(affectedPaths);
-  opennsl_l3_egress_ecmp_traverse(
-      unit, removeAllEgressesFromEcmpCallback, &tmpPaths);
+  if (!ecmpShrinkFastPath_.load(std::memory_order_acquire)) {
+    // The warm boot cache still holds ECMP groups with no corresponding
+    // BcmEcmpEgress object, which the index below would miss. Fall back
+    // to walking all ECMP groups in hardware.
+    Paths tmpPaths(affectedPaths.begin(), affectedPaths.end());
+    opennsl_l3_egress_ecmp_traverse(
+        unit, removeAllEgressesFromEcmpCallback, &tmpPaths);
+    return;
+  }
+  // Shrink exactly the ECMP groups containing the affected egresses,
+  // looked up via the precomputed index. The snapshot is immutable, so
+  // this is safe from the link scan thread without BcmSwitch::lock_.
+  auto index = getEgressId2EcmpIds();
+  for (const auto& egrId : affectedPaths) {
+    auto itr = index->find(egrId);
+    if (itr == index->end()) {
+      continue;
+    }
+    for (const auto& ecmpId : itr->second) {
+      BcmEcmpEgress::removeEgressIdHwNotLocked(unit, ecmpId, egrId);
+    }
+  }
 }
 
+template <typename PathsT>
 void BcmHostTable::egressResolutionChangedHwLocked(
-    const Paths& affectedPaths,
+    const PathsT& affectedPaths,
     bool up) {
-  for (const auto& nextHopsAndEcmpHostInfo : ecmpHosts_) {
-    auto ecmpId = nextHopsAndEcmpHostInfo.second.first->getEcmpEgressId();
-    if (ecmpId == BcmEgressBase::INVALID) {
+  auto index = getEgressId2EcmpIds();
+  for (auto path : affectedPaths) {
+    auto itr = index->find(path);
+    if (itr == index->end()) {
       continue;
     }
-    auto ecmpEgress = static_cast<BcmEcmpEgress*>(getEgressObjectIf(ecmpId));
-    // Must find the egress object, we could have done a slower
-    // dynamic cast check to ensure that this is the right type
-    // our map should be pointing to valid Ecmp egress object for
-    // a ecmp egress Id anyways
-    CHECK(ecmpEgress);
-    for (auto path : affectedPaths) {
+    for (auto ecmpId : itr->second) {
+      auto ecmpEgress = static_cast<BcmEcmpEgress*>(getEgressObjectIf(ecmpId));
+      // Must find the egress object, we could have done a slower
+      // dynamic cast check to ensure that this is the right type
+      // our map should be pointing to valid Ecmp egress object for
+      // a ecmp egress Id anyways
+      CHECK(ecmpEgress);
       if (up) {
         ecmpEgress->pathReachableHwLocked(path);
       } else {
@@ -15,6 +15,7 @@ extern "C" {
 }
 
 #include <folly/dynamic.h>
+#include <folly/Hash.h>
 #include <folly/IPAddress.h>
 #include <folly/MacAddress.h>
 #include <folly/SpinLock.h>
@@ -27,6 +28,10 @@ extern "C" {
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
 
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+
 namespace facebook { namespace fboss {
 
 class BcmEcmpEgress;
@@ -186,12 +191,29 @@ class BcmHostTable {
    * managed via a reference count of hosts pointing to these
    * egress objects. Once the last host pointing to a egress object
    * goes away, the egress object is deleted.
+   *
+   * Note that we deliberately do NOT deduplicate egress objects that
+   * resolve to the same (intf, mac, port) tuple across hosts. An egress
+   * ID is a stable identity here: ECMP egress objects capture member
+   * egress IDs for their lifetime, and neighbor changes are applied by
+   * reprogramming a host's egress in place under the same ID. Sharing
+   * an egress between hosts would corrupt the co-owners (or strand ECMP
+   * members) the moment one host's resolution diverges from the
+   * other's. numEgressDuplicates() tracks how many entries this costs
+   * us.
    */
   void insertBcmEgress(std::unique_ptr<BcmEgressBase> egress);
   BcmEgressBase* incEgressReference(opennsl_if_t egressId);
   BcmEgressBase* derefEgress(opennsl_if_t egressId);
   const BcmEgressBase*  getEgressObjectIf(opennsl_if_t egress) const;
   BcmEgressBase* getEgressObjectIf(opennsl_if_t egress);
+  /*
+   * Visit every programmed ECMP egress object. Walks the egress map,
+   * so the hw update lock must be held, like the other readers of the
+   * software tables.
+   */
+  void forEachEcmpEgress(
+      const std::function<void(const BcmEcmpEgress&)>& fn) const;
 
   /*
    * Port down handling
@@ -223,6 +245,21 @@ class BcmHostTable {
    */
   void updatePortEgressMapping(opennsl_if_t egressId, opennsl_port_t oldPort,
       opennsl_port_t newPort);
+  /*
+   * Batch host/egress programming between these two calls. While a
+   * batch is open, updatePortEgressMapping accumulates its changes
+   * into one pending port -> egressIds map and collects the affected
+   * egress IDs, instead of cloning, publishing and notifying the ECMP
+   * groups once per host. commitProgrammingBatch publishes the map
+   * once and raises one resolution-changed notification per
+   * direction. Used when a delta reprograms many hosts at once, e.g.
+   * all hosts behind an uplink whose neighbor just resolved.
+   *
+   * Must be called with the hw update lock held, like the programming
+   * calls being batched.
+   */
+  void startProgrammingBatch();
+  void commitProgrammingBatch();
   /*
    * Get port -> egressIds map
    */
@@ -230,6 +267,17 @@ class BcmHostTable {
     folly::SpinLockGuard guard(portAndEgressIdsLock_);
     return portAndEgressIdsDontUseDirectly_;
   }
+  /*
+   * Enable/disable the fast link down handling path, which shrinks only
+   * the ECMP groups found via the egress -> ECMP group index. Disabled
+   * while the warm boot cache still holds ECMP groups that have no
+   * corresponding BcmEcmpEgress object yet (between init and FIB sync on
+   * a warm boot); link down handling falls back to a SDK walk over all
+   * ECMP groups in hardware then.
+   */
+  void setEcmpShrinkFastPath(bool enable) {
+    ecmpShrinkFastPath_.store(enable, std::memory_order_release);
+  }
   /*
    * Serialize toFollyDynamic
    */
@@ -254,17 +302,39 @@ class BcmHostTable {
   uint32_t numEcmpEgress() const {
     return numEcmpEgressProgrammed_;
   }
+  /*
+   * Number of non ECMP egress entries over and above one per distinct
+   * resolved (action, intf, mac, port) tuple, i.e. the egress table
+   * space we could recover if egress objects were shared across hosts.
+   */
+  uint32_t numEgressDuplicates() const;
  private:
+  /*
+   * Inverted index of egress ID -> IDs of the ECMP groups that contain
+   * it. BcmEcmpEgress membership (paths) is fixed for the lifetime of the
+   * object, so the index only changes when ECMP egress objects are
+   * created or destroyed.
+   */
+  using EgressId2EcmpIds = boost::container::flat_map<
+      opennsl_if_t, boost::container::flat_set<opennsl_if_t>>;
+
   /*
    * Called both while holding and not holding the hw lock.
    */
   void linkStateChangedMaybeLocked(opennsl_port_t port, bool up,
       bool locked);
-  void egressResolutionChangedHwLocked(const Paths& affectedPaths, bool up);
-  static void egressResolutionChangedHwNotLocked(
+  /*
+   * Templated on the container of affected egress IDs so the link
+   * down path can pass PortAndEgressIds::EgressIds straight from the
+   * port -> egressIds map without copying it into a Paths set.
+   */
+  template <typename PathsT>
+  void egressResolutionChangedHwLocked(const PathsT& affectedPaths, bool up);
+  template <typename PathsT>
+  void egressResolutionChangedHwNotLocked(
       int unit,
-      const Paths& affectedPaths,
-      bool up);
+      const PathsT& affectedPaths,
+      bool up) const;
   // Callback for traversal in egressResolutionChangedHwNotLocked
   static int removeAllEgressesFromEcmpCallback(
       int unit,
@@ -273,20 +343,32 @@ class BcmHostTable {
       opennsl_if_t* intfArray,
       void* userData);
   void setPort2EgressIdsInternal(std::shared_ptr<PortAndEgressIdsMap> newMap);
+  std::shared_ptr<const EgressId2EcmpIds> getEgressId2EcmpIds() const {
+    folly::SpinLockGuard guard(egressId2EcmpIdsLock_);
+    return egressId2EcmpIdsDontUseDirectly_;
+  }
+  void setEgressId2EcmpIdsInternal(
+      std::shared_ptr<const EgressId2EcmpIds> newMap);
+  // Add or remove a ECMP egress object's paths in the inverted index.
+  // Must be called while holding the hw lock.
+  void updateEcmpMembership(const BcmEcmpEgress* ecmp, bool add);
 
   template <typename KeyT, typename HostT>
   using HostMap = boost::container::
       flat_map<KeyT, std::pair<std::unique_ptr<HostT>, uint32_t>>;
+  // The host type a refcounted host map stores
+  template <typename MapT>
+  using HostTypeT = typename MapT::mapped_type::first_type::element_type;
 
-  template <typename KeyT, typename HostT, typename... Args>
-  HostT* incRefOrCreateBcmHost(
-      HostMap<KeyT, HostT>* map,
-      const KeyT& key,
+  template <typename MapT, typename... Args>
+  HostTypeT<MapT>* incRefOrCreateBcmHost(
+      MapT* map,
+      const typename MapT::key_type& key,
       Args... args);
-  template <typename KeyT, typename HostT, typename... Args>
-  HostT* getBcmHostIf(const HostMap<KeyT, HostT>* map, Args... args) const;
-  template <typename KeyT, typename HostT, typename... Args>
-  HostT* derefBcmHost(HostMap<KeyT, HostT>* map, Args... args) noexcept;
+  template <typename MapT, typename... Args>
+  HostTypeT<MapT>* getBcmHostIf(const MapT* map, Args... args) const;
+  template <typename MapT, typename... Args>
+  HostTypeT<MapT>* derefBcmHost(MapT* map, Args... args) noexcept;
 
   const BcmSwitch* hw_{nullptr};
 
@@ -304,6 +386,26 @@ class BcmHostTable {
    */
   std::shared_ptr<PortAndEgressIdsMap> portAndEgressIdsDontUseDirectly_;
   mutable folly::SpinLock portAndEgressIdsLock_;
+  /*
+   * The current egress ID -> ECMP group IDs index. Only ever mutated
+   * while holding the hw lock, and published copy-on-write like the
+   * port -> egressIds map above so the link scan thread can consult a
+   * consistent snapshot without acquiring BcmSwitch::lock_. Same access
+   * rules as portAndEgressIdsDontUseDirectly_ apply.
+   */
+  std::shared_ptr<const EgressId2EcmpIds> egressId2EcmpIdsDontUseDirectly_;
+  mutable folly::SpinLock egressId2EcmpIdsLock_;
+  std::atomic<bool> ecmpShrinkFastPath_{true};
+  /*
+   * Programming batch state. Only touched while holding the hw lock.
+   * While a batch is open, pendingPort2EgressIds_ holds the one
+   * unpublished map all mappings in the batch mutate, and the path
+   * sets collect the egress IDs whose resolution changed.
+   */
+  bool batchInProgress_{false};
+  std::shared_ptr<PortAndEgressIdsMap> pendingPort2EgressIds_;
+  Paths pendingResolvedPaths_;
+  Paths pendingUnresolvedPaths_;
   // egressId -> port
   boost::container::flat_map<opennsl_if_t, opennsl_port_t> egressId2Port_;
   uint32_t numEcmpEgressProgrammed_{0};
@@ -316,7 +418,27 @@ class BcmHostTable {
   typedef std::pair<opennsl_vrf_t, folly::IPAddress> Key;
   HostMap<Key, BcmHost> hosts_;
   typedef std::pair<opennsl_vrf_t, RouteForwardNexthops> EcmpKey;
-  HostMap<EcmpKey, BcmEcmpHost> ecmpHosts_;
+  struct EcmpKeyHash {
+    size_t operator()(const EcmpKey& key) const {
+      // RouteForwardNexthops maintains its hash incrementally on insert,
+      // so hashing a key never walks the nexthop set.
+      return folly::hash::hash_combine(key.first, key.second.hash());
+    }
+  };
+  /*
+   * The canonical interning table for ECMP nexthop sets. In a typical
+   * deployment hundreds of thousands of routes share a handful of
+   * distinct nexthop sets, so this is keyed by hash rather than by
+   * ordered comparison: programming a route whose set is already
+   * interned is one hash lookup and a refcount bump, never a
+   * lexicographic walk over the nexthops.
+   */
+  typedef std::unordered_map<
+      EcmpKey,
+      std::pair<std::unique_ptr<BcmEcmpHost>, uint32_t>,
+      EcmpKeyHash>
+      EcmpHostMap;
+  EcmpHostMap ecmpHosts_;
 };
 
 }}
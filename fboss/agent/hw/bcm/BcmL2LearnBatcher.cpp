@@ -0,0 +1,141 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/hw/bcm/BcmL2LearnBatcher.h"
+
+#include "fboss/agent/hw/bcm/BcmStats.h"
+#include "fboss/agent/hw/bcm/BcmSwitch.h"
+
+#include <boost/container/flat_map.hpp>
+#include <folly/ThreadName.h>
+
+#include <algorithm>
+#include <chrono>
+
+DEFINE_int32(l2_learn_event_buffer, 8192,
+             "Depth of the L2 learn/age event queue between the SDK "
+             "callback and the batching thread. When the queue is full "
+             "further events are counted and dropped.");
+DEFINE_int32(l2_learn_batch_interval_ms, 20,
+             "Coalescing window for L2 learn/age events; repeated "
+             "transitions of the same MAC within a window collapse to "
+             "the last one.");
+DEFINE_string(l2_learn_shed_policy, "newest",
+              "Which event to shed when the L2 learn queue overflows: "
+              "'newest' drops the incoming event, 'oldest' evicts the "
+              "oldest queued event so the freshest transitions survive. "
+              "Either way the drop shows up in bcm.l2.learn.drops.");
+
+namespace facebook { namespace fboss {
+
+BcmL2LearnBatcher::BcmL2LearnBatcher(BcmSwitch* hw)
+    : hw_(hw),
+      queue_(FLAGS_l2_learn_event_buffer) {
+  thread_ = std::thread([this] { drainThread(); });
+}
+
+BcmL2LearnBatcher::~BcmL2LearnBatcher() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+void BcmL2LearnBatcher::l2LearnCallback(int /*unit*/,
+                                        opennsl_l2_addr_t* l2addr,
+                                        int operation,
+                                        void* userdata) {
+  auto batcher = static_cast<BcmL2LearnBatcher*>(userdata);
+  if (!l2addr || !batcher) {
+    return;
+  }
+  switch (operation) {
+  case OPENNSL_L2_CALLBACK_ADD:
+    batcher->enqueue(*l2addr, true);
+    break;
+  case OPENNSL_L2_CALLBACK_DELETE:
+    batcher->enqueue(*l2addr, false);
+    break;
+  default:
+    break;
+  }
+}
+
+void BcmL2LearnBatcher::enqueue(const opennsl_l2_addr_t& l2addr, bool add) {
+  L2LearnEvent event;
+  event.mac = folly::MacAddress::fromBinary(
+      folly::ByteRange(l2addr.mac, folly::MacAddress::SIZE));
+  event.vlan = l2addr.vid;
+  event.port = l2addr.port;
+  event.add = add;
+  if (queue_.write(event)) {
+    return;
+  }
+  // Never backpressure the SDK: during a storm that exceeds the drain
+  // rate something must be shed, and the periodic drain converges on
+  // the hardware table contents either way.
+  if (FLAGS_l2_learn_shed_policy == "oldest") {
+    L2LearnEvent evicted;
+    if (queue_.read(evicted)) {
+      BcmStats::get()->l2LearnEventDropped();
+      if (queue_.write(event)) {
+        return;
+      }
+      // Raced with other producers refilling the slot; fall through
+      // and drop the incoming event as well.
+    }
+  }
+  BcmStats::get()->l2LearnEventDropped();
+}
+
+void BcmL2LearnBatcher::drainThread() {
+  folly::setThreadName(pthread_self(), "fbossL2Batcher");
+  std::unique_lock<std::mutex> guard(mutex_);
+  while (!stop_) {
+    cv_.wait_for(guard,
+                 std::chrono::milliseconds(FLAGS_l2_learn_batch_interval_ms));
+    if (stop_) {
+      break;
+    }
+    drainEvents();
+  }
+}
+
+void BcmL2LearnBatcher::drainEvents() {
+  // Depth at the start of the window is the backlog the SDK built up
+  // while we slept; sampled every window, busy or not, so the
+  // histogram's shape is meaningful.
+  BcmStats::get()->l2LearnQueueDepth(
+      std::max<ssize_t>(0, queue_.size()));
+  L2LearnEvent event;
+  boost::container::flat_map<EntryKey, L2LearnEvent> batch;
+  uint64_t drained = 0;
+  while (queue_.read(event)) {
+    ++drained;
+    // Last transition for a (VLAN, MAC) wins: a MAC that flaps between
+    // ports several times within the window collapses to its final
+    // location, or to a single delete if it aged out.
+    batch[EntryKey(event.vlan, event.mac.u64HBO())] = event;
+  }
+  if (drained == 0) {
+    return;
+  }
+  BcmStats::get()->l2LearnEvents(drained);
+  BcmStats::get()->l2LearnEventsCoalesced(drained - batch.size());
+  // Apply the surviving transitions in one pass. The agent keeps no
+  // software MAC table today, so there is nothing to update yet; this
+  // batch is the interface a future consumer should hook into, and the
+  // summary below is what we have to correlate storms against.
+  VLOG(4) << "L2 learn batch: " << drained << " events, " << batch.size()
+          << " distinct entries after coalescing";
+}
+
+}} // facebook::fboss
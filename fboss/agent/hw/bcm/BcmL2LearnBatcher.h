@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <folly/MPMCQueue.h>
+#include <folly/MacAddress.h>
+
+extern "C" {
+#include <opennsl/l2.h>
+#include <opennsl/types.h>
+}
+
+namespace facebook { namespace fboss {
+
+class BcmSwitch;
+
+/*
+ * BcmL2LearnBatcher absorbs the L2 learn/age callbacks from the SDK.
+ *
+ * The SDK delivers one callback per MAC table transition from its own
+ * notification thread, and during a MAC move storm (e.g. VM migration
+ * waves) processing them synchronously saturates that thread and
+ * backpressures the SDK. The callback here only pushes the event into
+ * a fixed-depth lock-free queue and returns; when the queue is full
+ * the event is counted and dropped rather than ever blocking. A
+ * private thread drains the queue once per coalescing window,
+ * collapsing repeated transitions of the same (VLAN, MAC) to the last
+ * one, and applies the surviving batch in one pass.
+ */
+class BcmL2LearnBatcher {
+ public:
+  explicit BcmL2LearnBatcher(BcmSwitch* hw);
+  ~BcmL2LearnBatcher();
+
+  /*
+   * The callback registered with opennsl_l2_addr_register(), with the
+   * batcher as the cookie. Runs on the SDK's L2 notification thread
+   * and never blocks.
+   */
+  static void l2LearnCallback(int unit, opennsl_l2_addr_t* l2addr,
+                              int operation, void* userdata);
+
+ private:
+  struct L2LearnEvent {
+    folly::MacAddress mac;
+    opennsl_vlan_t vlan{0};
+    opennsl_port_t port{0};
+    bool add{false};
+  };
+  // (VLAN, MAC) identifies the table entry a transition applies to
+  typedef std::pair<opennsl_vlan_t, uint64_t> EntryKey;
+
+  // Forbidden copy constructor and assignment operator
+  BcmL2LearnBatcher(const BcmL2LearnBatcher&) = delete;
+  BcmL2LearnBatcher& operator=(const BcmL2LearnBatcher&) = delete;
+
+  void enqueue(const opennsl_l2_addr_t& l2addr, bool add);
+  void drainThread();
+  void drainEvents();
+
+  BcmSwitch* hw_;
+  folly::MPMCQueue<L2LearnEvent> queue_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_{false};
+  std::thread thread_;
+};
+
+}} // facebook::fboss
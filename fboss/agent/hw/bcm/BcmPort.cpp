@@ -31,11 +31,17 @@ extern "C" {
 }
 
 using std::chrono::duration_cast;
+using std::chrono::milliseconds;
 using std::chrono::seconds;
 using std::chrono::system_clock;
 using std::string;
 using std::shared_ptr;
 
+DEFINE_int32(sflow_sample_rate, 0,
+             "If non-zero, sample one in this many forwarded packets on "
+             "every enabled port and feed the samples to the flow sampler "
+             "(0 disables sampling)");
+
 namespace {
 
 const string kInBytes = "in_bytes";
@@ -84,6 +90,43 @@ static const std::vector<opennsl_stat_val_t> kOutPktLengthStats = {
   snmpOpenNSLTransmittedPkts9217to16383Octets,
 };
 
+// All of the per-port counters that updateStats() collects in a single
+// opennsl_stat_multi_get() sweep, in the order they land in the flat
+// value buffer.  Each entry pairs the SDK stat type with the exported
+// counter key and the HwPortStats field that caches the value.
+struct PortStatEntry {
+  opennsl_stat_val_t type;
+  const string& key;
+  int64_t HwPortStats::*field;
+};
+
+static const std::vector<PortStatEntry> kPortStats = {
+  {opennsl_spl_snmpIfHCInOctets, kInBytes, &HwPortStats::inBytes_},
+  {opennsl_spl_snmpIfHCInUcastPkts, kInUnicastPkts,
+   &HwPortStats::inUnicastPkts_},
+  {opennsl_spl_snmpIfHCInMulticastPkts, kInMulticastPkts,
+   &HwPortStats::inMulticastPkts_},
+  {opennsl_spl_snmpIfHCInBroadcastPkts, kInBroadcastPkts,
+   &HwPortStats::inBroadcastPkts_},
+  {opennsl_spl_snmpIfInDiscards, kInDiscards, &HwPortStats::inDiscards_},
+  {opennsl_spl_snmpIfInErrors, kInErrors, &HwPortStats::inErrors_},
+  {opennsl_spl_snmpIpInHdrErrors, kInIpv4HdrErrors,
+   &HwPortStats::inIpv4HdrErrors_},
+  {opennsl_spl_snmpIpv6IfStatsInHdrErrors, kInIpv6HdrErrors,
+   &HwPortStats::inIpv6HdrErrors_},
+  {opennsl_spl_snmpDot3InPauseFrames, kInPause, &HwPortStats::inPause_},
+  {opennsl_spl_snmpIfHCOutOctets, kOutBytes, &HwPortStats::outBytes_},
+  {opennsl_spl_snmpIfHCOutUcastPkts, kOutUnicastPkts,
+   &HwPortStats::outUnicastPkts_},
+  {opennsl_spl_snmpIfHCOutMulticastPkts, kOutMulticastPkts,
+   &HwPortStats::outMulticastPkts_},
+  {opennsl_spl_snmpIfHCOutBroadcastPckts, kOutBroadcastPkts,
+   &HwPortStats::outBroadcastPkts_},
+  {opennsl_spl_snmpIfOutDiscards, kOutDiscards, &HwPortStats::outDiscards_},
+  {opennsl_spl_snmpIfOutErrors, kOutErrors, &HwPortStats::outErrors_},
+  {opennsl_spl_snmpDot3OutPauseFrames, kOutPause, &HwPortStats::outPause_},
+};
+
 // This allows mapping from a speed and port transmission technology
 // to a broadcom supported interface
 static const std::map<cfg::PortSpeed,
@@ -285,13 +328,67 @@ void BcmPort::disable(const std::shared_ptr<Port>& swPort) {
 
   rv = opennsl_port_enable_set(unit_, port_, false);
   bcmCheckError(rv, "failed to disable port ", swPort->getID());
+
+  cachedEnabled_.store(false, std::memory_order_release);
+}
+
+bool BcmPort::isEnabled() const {
+  return cachedEnabled_.load(std::memory_order_acquire);
+}
+
+bool BcmPort::isUp() const {
+  return cachedUp_.load(std::memory_order_acquire);
+}
+
+int64_t BcmPort::getLastLinkUpMsec() const {
+  return lastUpMsec_.load(std::memory_order_acquire);
+}
+
+int64_t BcmPort::getLastLinkDownMsec() const {
+  return lastDownMsec_.load(std::memory_order_acquire);
 }
 
-bool BcmPort::isEnabled() {
+uint64_t BcmPort::getLinkTransitions() const {
+  return linkTransitions_.load(std::memory_order_acquire);
+}
+
+void BcmPort::updateStatusCache(bool enabled, bool up) {
+  cachedEnabled_.store(enabled, std::memory_order_release);
+  if (up != cachedUp_.load(std::memory_order_relaxed)) {
+    auto nowMsec = duration_cast<milliseconds>(
+        system_clock::now().time_since_epoch()).count();
+    if (up) {
+      lastUpMsec_.store(nowMsec, std::memory_order_release);
+    } else {
+      lastDownMsec_.store(nowMsec, std::memory_order_release);
+    }
+    linkTransitions_.fetch_add(1, std::memory_order_relaxed);
+    cachedUp_.store(up, std::memory_order_release);
+  }
+}
+
+void BcmPort::reconcileStatusCache() {
+  // The cache is written behind by the linkscan callback; this sweep
+  // catches anything that changed without an event (e.g. an SDK shell
+  // poke or a missed callback).
   int enabled;
   auto rv = opennsl_port_enable_get(unit_, port_, &enabled);
-  bcmCheckError(rv, "Failed to determine if port is already disabled");
-  return static_cast<bool>(enabled);
+  if (OPENNSL_FAILURE(rv)) {
+    return;
+  }
+  int linkStatus;
+  rv = opennsl_port_link_status_get(unit_, port_, &linkStatus);
+  if (OPENNSL_FAILURE(rv)) {
+    return;
+  }
+  bool up = (linkStatus == OPENNSL_PORT_LINK_STATUS_UP);
+  if (static_cast<bool>(enabled) != isEnabled() || up != isUp()) {
+    LOG(WARNING) << "port " << port_ << " status cache out of sync with SDK"
+                 << " (cached enabled=" << isEnabled() << " up=" << isUp()
+                 << ", SDK enabled=" << enabled << " up=" << up
+                 << "); reconciling";
+    updateStatusCache(static_cast<bool>(enabled), up);
+  }
 }
 
 void BcmPort::enable(const std::shared_ptr<Port>& swPort) {
@@ -333,12 +430,24 @@ void BcmPort::enable(const std::shared_ptr<Port>& swPort) {
                   swPort->getID());
   }
 
+  // Enable ingress flow sampling if requested: one in every N forwarded
+  // packets is copied to the CPU with the sample rx reason set and fed
+  // to the flow sampler.
+  if (FLAGS_sflow_sample_rate > 0) {
+    rv = opennsl_port_sample_rate_set(unit_, port_,
+                                      FLAGS_sflow_sample_rate, 0);
+    bcmCheckError(rv, "failed to enable flow sampling on port ",
+                  swPort->getID());
+  }
+
   // Enable linkscan
   rv = opennsl_linkscan_mode_set(unit_, port_, OPENNSL_LINKSCAN_MODE_SW);
   bcmCheckError(rv, "Failed to enable linkscan on port ", swPort->getID());
 
   rv = opennsl_port_enable_set(unit_, port_, true);
   bcmCheckError(rv, "failed to enable port ", swPort->getID());
+
+  cachedEnabled_.store(true, std::memory_order_release);
 }
 
 
@@ -498,6 +607,7 @@ void BcmPort::setPortStatus(bool up) {
   // We ignore the return value.  If we fail to get the port status
   // we just tell the platformPort_ that it is enabled.
 
+  updateStatusCache(static_cast<bool>(enabled), up);
   platformPort_->linkStatusChanged(up, enabled);
 }
 
@@ -518,79 +628,44 @@ void BcmPort::updateStats() {
   // TODO: It would be nicer to use a monotonic clock, but unfortunately
   // the ServiceData code currently expects everyone to use system time.
   auto now = duration_cast<seconds>(system_clock::now().time_since_epoch());
-  HwPortStats portStats;
-  updateStat(now, kInBytes, opennsl_spl_snmpIfHCInOctets, &portStats.inBytes_);
-  updateStat(
-      now,
-      kInUnicastPkts,
-      opennsl_spl_snmpIfHCInUcastPkts,
-      &portStats.inUnicastPkts_);
-  updateStat(
-      now,
-      kInMulticastPkts,
-      opennsl_spl_snmpIfHCInMulticastPkts,
-      &portStats.inMulticastPkts_);
-  updateStat(
-      now,
-      kInBroadcastPkts,
-      opennsl_spl_snmpIfHCInBroadcastPkts,
-      &portStats.inBroadcastPkts_);
-  updateStat(
-      now, kInDiscards, opennsl_spl_snmpIfInDiscards, &portStats.inDiscards_);
-  updateStat(
-      now, kInErrors, opennsl_spl_snmpIfInErrors, &portStats.inErrors_);
-
-  updateStat(
-      now,
-      kInIpv4HdrErrors,
-      opennsl_spl_snmpIpInHdrErrors,
-      &portStats.inIpv4HdrErrors_);
-  updateStat(
-      now,
-      kInIpv6HdrErrors,
-      opennsl_spl_snmpIpv6IfStatsInHdrErrors,
-      &portStats.inIpv6HdrErrors_);
-  updateStat(
-      now,
-      kInPause,
-      opennsl_spl_snmpDot3InPauseFrames,
-      &portStats.inPause_);
-  // Egress Stats
-  updateStat(
-      now, kOutBytes, opennsl_spl_snmpIfHCOutOctets, &portStats.outBytes_);
-  updateStat(
-      now,
-      kOutUnicastPkts,
-      opennsl_spl_snmpIfHCOutUcastPkts,
-      &portStats.outUnicastPkts_);
-  updateStat(
-      now,
-      kOutMulticastPkts,
-      opennsl_spl_snmpIfHCOutMulticastPkts,
-      &portStats.outMulticastPkts_);
-  updateStat(
-      now,
-      kOutBroadcastPkts,
-      opennsl_spl_snmpIfHCOutBroadcastPckts,
-      &portStats.outBroadcastPkts_);
-  updateStat(
-      now,
-      kOutDiscards,
-      opennsl_spl_snmpIfOutDiscards,
-      &portStats.outDiscards_);
-  updateStat(
-      now, kOutErrors, opennsl_spl_snmpIfOutErrors, &portStats.outErrors_);
-  updateStat(
-      now,
-      kOutPause,
-      opennsl_spl_snmpDot3OutPauseFrames,
-      &portStats.outPause_);
-
-  portStats_ = portStats;
+
+  // Piggyback the status cache reconcile sweep on the stats interval
+  reconcileStatusCache();
+
+  // Fetch all of the counters in kPortStats with a single multi-stat
+  // call rather than one SDK call per counter.  The values still come
+  // from the accumulated software copies; the Broadcom SDK's counter
+  // thread DMAs the HW counters to software every 500000us (defined in
+  // config.bcm).
+  std::vector<opennsl_stat_val_t> types;
+  types.reserve(kPortStats.size());
+  for (const auto& entry : kPortStats) {
+    types.push_back(entry.type);
+  }
+  std::vector<uint64_t> values(kPortStats.size());
+  auto ret = opennsl_stat_multi_get(unit_, port_, types.size(),
+                                    &types.front(), &values.front());
+  if (OPENNSL_FAILURE(ret)) {
+    LOG(ERROR) << "Failed to get stats for port " << port_ << " :"
+               << opennsl_errmsg(ret);
+    return;
+  }
+
+  // Fill the inactive snapshot buffer, then publish it with an index
+  // swap once it is complete.
+  auto inactiveIdx = curPortStatsIdx_.load(std::memory_order_relaxed) ^ 1;
+  HwPortStats& portStats = portStatsBufs_[inactiveIdx];
+  for (int idx = 0; idx < kPortStats.size(); ++idx) {
+    const auto& entry = kPortStats[idx];
+    auto* stat = getPortCounterIf(entry.key);
+    stat->updateValue(now, values[idx]);
+    portStats.*(entry.field) = values[idx];
+  }
+  curPortStatsIdx_.store(inactiveIdx, std::memory_order_release);
 
   // Update the queue length stat
   uint32_t qlength;
-  auto ret = opennsl_port_queued_count_get(unit_, port_, &qlength);
+  ret = opennsl_port_queued_count_get(unit_, port_, &qlength);
   if (OPENNSL_FAILURE(ret)) {
     LOG(ERROR) << "Failed to get queue length for port " << port_
                << " :" << opennsl_errmsg(ret);
@@ -607,26 +682,6 @@ void BcmPort::updateStats() {
   updatePktLenHist(now, &outPktLengths_, kOutPktLengthStats);
 };
 
-void BcmPort::updateStat(
-    std::chrono::seconds now,
-    const string& statKey,
-    opennsl_stat_val_t type,
-    int64_t* statVal) {
-  auto stat = getPortCounterIf(statKey);
-  // Use the non-sync API to just get the values accumulated in software.
-  // The Broadom SDK's counter thread syncs the HW counters to software every
-  // 500000us (defined in config.bcm).
-  uint64_t value;
-  auto ret = opennsl_stat_get(unit_, port_, type, &value);
-  if (OPENNSL_FAILURE(ret)) {
-    LOG(ERROR) << "Failed to get stat " << type << " for port " << port_ << " :"
-               << opennsl_errmsg(ret);
-    return;
-  }
-  stat->updateValue(now, value);
-  *statVal = value;
-}
-
 void BcmPort::updatePktLenHist(
     std::chrono::seconds now,
     stats::ExportedHistogramMapImpl::LockableHistogram* hist,
@@ -652,22 +707,11 @@ void BcmPort::updatePktLenHist(
   }
 }
 
-cfg::PortState BcmPort::getState() {
-  int rv;
-  int enabled;
-  int linkStatus;
-  rv = opennsl_port_enable_get(hw_->getUnit(), port_, &enabled);
-  bcmCheckError(rv, "could not find if port ", port_, " is enabled or not...");
-  if (!enabled) {
+cfg::PortState BcmPort::getState() const {
+  if (!isEnabled()) {
     return cfg::PortState::POWER_DOWN;
   }
-  rv = opennsl_port_link_status_get(hw_->getUnit(), port_, &linkStatus);
-  bcmCheckError(rv, "could not find if the port ", port_, " is up or down...");
-  if (linkStatus == OPENNSL_PORT_LINK_STATUS_UP) {
-    return cfg::PortState::UP;
-  } else {
-    return cfg::PortState::DOWN;
-  }
+  return isUp() ? cfg::PortState::UP : cfg::PortState::DOWN;
 }
 
 /**
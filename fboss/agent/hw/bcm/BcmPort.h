@@ -23,6 +23,7 @@ extern "C" {
 #include "fboss/agent/gen-cpp2/switch_config_types.h"
 #include "fboss/agent/hw/bcm/gen-cpp2/hardware_stats_types.h"
 
+#include <atomic>
 #include <mutex>
 
 namespace facebook { namespace fboss {
@@ -51,7 +52,29 @@ class BcmPort {
   void enable(const std::shared_ptr<Port>& swPort);
   void disable(const std::shared_ptr<Port>& swPort);
   void program(const std::shared_ptr<Port>& swPort);
-  bool isEnabled();
+
+  /*
+   * Whether the port is enabled and whether its link is up.
+   *
+   * Both are served from a write-behind cache maintained by the
+   * linkscan callback and the enable/disable paths, with a periodic
+   * reconcile against the SDK from updateStats().  Reads are plain
+   * memory loads, so SwSwitch and PortRemediator can poll every port
+   * per interval without SDK round-trips.
+   */
+  bool isEnabled() const;
+  bool isUp() const;
+
+  /*
+   * Timestamps (msec since epoch) of the last observed link up and
+   * down transitions, and the total number of transitions, maintained
+   * from the linkscan callback.  Flap analysis can read these without
+   * touching the SDK.  A zero timestamp means no such transition has
+   * been observed since the agent started.
+   */
+  int64_t getLastLinkUpMsec() const;
+  int64_t getLastLinkDownMsec() const;
+  uint64_t getLinkTransitions() const;
 
   /*
    * Getters.
@@ -100,11 +123,22 @@ class BcmPort {
    */
   void updateStats();
 
+  /*
+   * Return the last published counter snapshot for this port.
+   *
+   * Safe to call from any thread; snapshots are double buffered and
+   * published with an atomic index swap, so readers never observe a
+   * torn snapshot and never contend with collection.
+   */
+  HwPortStats getPortStats() const {
+    return portStatsBufs_[curPortStatsIdx_.load(std::memory_order_acquire)];
+  }
+
   /**
-   * Get the state of the port. If there is an error in finding the port state,
-   * then an BcmError() exception is thrown.
+   * Get the state of the port, composed from the cached enabled and
+   * link status bits; no SDK call.
    */
-  cfg::PortState getState();
+  cfg::PortState getState() const;
 
   /**
    * Try to remedy this port if this is down.
@@ -143,10 +177,6 @@ class BcmPort {
   MonotonicCounter* getPortCounterIf(const std::string& statName);
   void reinitPortStats();
   void reinitPortStat(const std::string& newName);
-  void updateStat(std::chrono::seconds now,
-                  const std::string& statName,
-                  opennsl_stat_val_t type,
-                  int64_t* portStatVal);
   void updatePktLenHist(std::chrono::seconds now,
                         stats::ExportedHistogramMapImpl::LockableHistogram* hist,
                         const std::vector<opennsl_stat_val_t>& stats);
@@ -163,6 +193,9 @@ class BcmPort {
   void setKR4Ability();
   void setFEC(const std::shared_ptr<Port>& swPort);
 
+  void updateStatusCache(bool enabled, bool up);
+  void reconcileStatusCache();
+
   BcmSwitch* const hw_{nullptr};
   const opennsl_port_t port_;    // Broadcom physical port number
   // The gport_ is logically a const, but needs to be initialized as a parameter
@@ -180,7 +213,19 @@ class BcmPort {
   stats::ExportedStatMapImpl::LockableStat outQueueLen_;
   stats::ExportedHistogramMapImpl::LockableHistogram inPktLengths_;
   stats::ExportedHistogramMapImpl::LockableHistogram outPktLengths_;
-  HwPortStats portStats_;
+  // Double-buffered counter snapshots; updateStats() fills the
+  // inactive buffer and publishes it by swapping curPortStatsIdx_.
+  HwPortStats portStatsBufs_[2];
+  std::atomic<int> curPortStatsIdx_{0};
+
+  // Write-behind port status cache.  Written from the linkscan
+  // callback and the enable/disable paths, reconciled against the SDK
+  // by updateStats(), and read everywhere else as plain memory loads.
+  std::atomic<bool> cachedEnabled_{false};
+  std::atomic<bool> cachedUp_{false};
+  std::atomic<int64_t> lastUpMsec_{0};
+  std::atomic<int64_t> lastDownMsec_{0};
+  std::atomic<uint64_t> linkTransitions_{0};
 };
 
 }} // namespace facebook::fboss
@@ -66,6 +66,18 @@ void BcmPortTable::initPorts(const opennsl_port_config_t* portConfig,
     platPort->setBcmPort(bcmPort.get());
     bcmPort->init(warmBoot);
 
+    auto addToLookup = [](std::vector<BcmPort*>* table, size_t idx,
+                          BcmPort* port) {
+      if (idx >= table->size()) {
+        table->resize(idx + 1, nullptr);
+      }
+      (*table)[idx] = port;
+    };
+    addToLookup(&fbossPortLookup_, static_cast<uint16_t>(fbossPortID),
+                bcmPort.get());
+    addToLookup(&bcmPortLookup_, static_cast<size_t>(bcmPortNum),
+                bcmPort.get());
+
     fbossPhysicalPorts_.emplace(fbossPortID, bcmPort.get());
     bcmPhysicalPorts_.emplace(bcmPortNum, std::move(bcmPort));
   }
@@ -74,35 +86,19 @@ void BcmPortTable::initPorts(const opennsl_port_config_t* portConfig,
 }
 
 BcmPort* BcmPortTable::getBcmPort(opennsl_port_t id) const {
-  auto iter = bcmPhysicalPorts_.find(id);
-  if (iter == bcmPhysicalPorts_.end()) {
+  auto* port = getBcmPortIf(id);
+  if (!port) {
     throw FbossError("Cannot find the BCM port object for BCM port ", id);
   }
-  return iter->second.get();
-}
-
-BcmPort* BcmPortTable::getBcmPortIf(opennsl_port_t id) const {
-  auto iter = bcmPhysicalPorts_.find(id);
-  if (iter == bcmPhysicalPorts_.end()) {
-    return nullptr;
-  }
-  return iter->second.get();
+  return port;
 }
 
 BcmPort* BcmPortTable::getBcmPort(PortID id) const {
-  auto iter = fbossPhysicalPorts_.find(id);
-  if (iter == fbossPhysicalPorts_.end()) {
+  auto* port = getBcmPortIf(id);
+  if (!port) {
     throw FbossError("Cannot find the BCM port object for FBOSS port ID ", id);
   }
-  return iter->second;
-}
-
-BcmPort* BcmPortTable::getBcmPortIf(PortID id) const {
-  auto iter = fbossPhysicalPorts_.find(id);
-  if (iter == fbossPhysicalPorts_.end()) {
-    return nullptr;
-  }
-  return iter->second;
+  return port;
 }
 
 void BcmPortTable::setPortStatus(opennsl_port_t id, int status) {
@@ -18,6 +18,7 @@ extern "C" {
 #include "fboss/agent/hw/bcm/BcmPort.h"
 
 #include <mutex>
+#include <vector>
 #include <boost/container/flat_map.hpp>
 
 namespace facebook { namespace fboss {
@@ -53,8 +54,17 @@ class BcmPortTable {
   BcmPort* getBcmPort(opennsl_port_t id) const;
 
   // return nullptr if not found
-  BcmPort* getBcmPortIf(PortID id) const;
-  BcmPort* getBcmPortIf(opennsl_port_t id) const;
+  //
+  // These are called on the rx hot path (once per packet to resolve the
+  // ingress port) and by every stats sweep, so both are a bounds-checked
+  // array load rather than a map lookup.
+  BcmPort* getBcmPortIf(PortID id) const {
+    return lookupPort(fbossPortLookup_, static_cast<uint16_t>(id));
+  }
+  BcmPort* getBcmPortIf(opennsl_port_t id) const {
+    return id < 0 ? nullptr
+                  : lookupPort(bcmPortLookup_, static_cast<size_t>(id));
+  }
 
   /*
    * Indicate that a port's link status has changed.
@@ -84,6 +94,10 @@ class BcmPortTable {
    */
   void initPortGroups();
 
+  static BcmPort* lookupPort(const std::vector<BcmPort*>& table, size_t idx) {
+    return idx < table.size() ? table[idx] : nullptr;
+  }
+
   typedef boost::container::flat_map<opennsl_port_t, std::unique_ptr<BcmPort>>
     BcmPortMap;
   typedef boost::container::flat_map<PortID, BcmPort*> FbossPortMap;
@@ -104,6 +118,14 @@ class BcmPortTable {
   // A mapping from FBOSS PortID to BcmPort.
   FbossPortMap fbossPhysicalPorts_;
 
+  // Lookup arrays indexed directly by port number. Port numbers are
+  // small dense integers, so these turn the per-packet ingress port
+  // resolution into a single bounds-checked load. The maps above are
+  // retained for iteration; entries for port numbers that don't exist
+  // are null.
+  std::vector<BcmPort*> bcmPortLookup_;
+  std::vector<BcmPort*> fbossPortLookup_;
+
   // A list of all the port groups. We can change this data structure to be
   // two maps (like the portmaps) if we ever have the need to access these
   // outside of the BcmPort objects. This is mainly here to keep a simple
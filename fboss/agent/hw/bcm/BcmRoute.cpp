@@ -19,6 +19,7 @@ extern "C" {
 #include "fboss/agent/Constants.h"
 #include "fboss/agent/state/Route.h"
 #include "fboss/agent/state/RouteTypes.h"
+#include "fboss/agent/hw/bcm/BcmAPI.h"
 #include "fboss/agent/hw/bcm/BcmError.h"
 #include "fboss/agent/hw/bcm/BcmSwitch.h"
 #include "fboss/agent/hw/bcm/BcmHost.h"
@@ -26,15 +27,41 @@ extern "C" {
 #include "fboss/agent/hw/bcm/BcmPlatform.h"
 #include "fboss/agent/hw/bcm/BcmWarmBootCache.h"
 
+#include "common/stats/ServiceData.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+DEFINE_int32(l3_route_program_threads, 4,
+             "Number of threads used to issue route adds to the SDK during "
+             "a batched route table update (1 disables concurrency)");
+
 namespace facebook { namespace fboss {
 
 namespace {
+// Below this many queued writes a batched update stays on the calling
+// thread; spawning workers costs more than it saves.
+constexpr size_t kParallelRouteProgramThreshold = 256;
+
 auto constexpr kAction = "action";
 auto constexpr kEcmp = "ecmp";
 auto constexpr kForwardInfo = "forwardInfo";
 auto constexpr kMaskLen = "maskLen";
 auto constexpr kNetwork = "network";
 auto constexpr kRoutes = "routes";
+
+// ALPM stores routes in per-prefix-group SRAM buckets, so E_FULL from a
+// route add can mean a single bucket overflowed long before the
+// table-wide capacity is reached. Call that out so the failure is not
+// misread as total exhaustion.
+void explainRouteAddFailure(int rc) {
+  if (rc == OPENNSL_E_FULL && facebook::fboss::BcmAPI::isAlpmEnabled()) {
+    LOG(ERROR) << "Route table reported full while running in ALPM mode; "
+        "this may be exhaustion of a single ALPM bucket rather than "
+        "overall table capacity";
+  }
+}
 }
 
 BcmRoute::BcmRoute(const BcmSwitch* hw, opennsl_vrf_t vrf,
@@ -77,18 +104,34 @@ bool BcmRoute::canUseHostTable() const {
 }
 
 void BcmRoute::program(const RouteForwardInfo& fwd) {
+  auto prepared = prepareProgram(fwd);
+  if (!prepared.fwdChanged) {
+    return;
+  }
+  if (prepared.needLpmWrite) {
+    auto rc = opennsl_l3_route_add(hw_->getUnit(), &prepared.rt);
+    if (OPENNSL_FAILURE(rc)) {
+      explainRouteAddFailure(rc);
+      abortProgram(fwd);
+    }
+    bcmCheckError(rc, "failed to create a route entry for ", prefix_, "/",
+        static_cast<int>(len_), " @ ", fwd, " @egress ", prepared.egressId);
+    VLOG(3) << "created a route entry for " << prefix_.str() << "/"
+      << static_cast<int>(len_) << " @egress " << prepared.egressId
+      << " with " << fwd;
+  }
+  commitProgram(prepared.egressId, fwd);
+}
+
+BcmRoute::PreparedProgram BcmRoute::prepareProgram(
+    const RouteForwardInfo& fwd) {
+  PreparedProgram prepared;
   // if the route has been programmed to the HW, check if the forward info is
   // changed or not. If not, nothing to do.
   if (added_ && fwd == fwd_) {
-    return;
+    return prepared;
   }
-
-  // function to clean up the host reference
-  auto cleanupHost = [&] (const RouteForwardNexthops& nhopsClean) noexcept {
-    if (nhopsClean.size()) {
-      hw_->writableHostTable()->derefBcmEcmpHost(vrf_, nhopsClean);
-    }
-  };
+  prepared.fwdChanged = true;
 
   auto action = fwd.getAction();
   // find out the egress object ID
@@ -106,16 +149,21 @@ void BcmRoute::program(const RouteForwardInfo& fwd) {
         vrf_, nhops);
     egressId = host->getEgressId();
   }
+  prepared.egressId = egressId;
 
   // At this point host and egress objects for next hops have been
   // created, what remains to be done is to program route into the
   // route table or host table (if this is a host route and use of
   // host table for host routes is allowed by the chip).
   SCOPE_FAIL {
-    cleanupHost(fwd.getNexthops());
+    abortProgram(fwd);
   };
   if (canUseHostTable()) {
-    if (added_) {
+    // Host table routes are programmed right here, there is no SDK write
+    // left for the caller to issue. If the host table turns out to be
+    // full we fall back to the LPM table below.
+    bool wasInHostTable = inHostTable_;
+    if (added_ && inHostTable_) {
       // Delete the already existing host table entry, because we cannot change
       // host entries.
       auto host = hw_->getHostTable()->getBcmHostIf(vrf_, prefix_);
@@ -123,25 +171,66 @@ void BcmRoute::program(const RouteForwardInfo& fwd) {
       VLOG(3) << "Derefrencing host prefix for " << prefix_ << "/" << len_
               << " host egress Id : " << host->getEgressId();
       hw_->writableHostTable()->derefBcmHost(vrf_, prefix_);
+      inHostTable_ = false;
     }
     auto warmBootCache = hw_->getWarmBootCache();
     auto vrfAndIP2RouteCitr =
         warmBootCache->findHostRouteFromRouteTable(vrf_, prefix_);
     bool entryExistsInRouteTable =
         vrfAndIP2RouteCitr != warmBootCache->vrfAndIP2Route_end();
-    programHostRoute(egressId, fwd, entryExistsInRouteTable);
+    try {
+      programHostRoute(egressId, fwd, entryExistsInRouteTable);
+      inHostTable_ = true;
+    } catch (const BcmError& error) {
+      if (error.getBcmError() != OPENNSL_E_FULL) {
+        throw;
+      }
+      LOG(WARNING) << "Host table full, programming " << prefix_ << "/"
+                   << static_cast<int>(len_) << " into the LPM table instead";
+    }
+    if (inHostTable_) {
+      if (entryExistsInRouteTable) {
+        // If the entry already exists in the route table, programHostRoute()
+        // removes it as well.
+        DCHECK(!BcmRoute::deleteLpmRoute(hw_->getUnit(), vrf_, prefix_, len_));
+        warmBootCache->programmed(vrfAndIP2RouteCitr);
+      } else if (added_ && !wasInHostTable) {
+        // The route migrated back from the LPM table into the host table,
+        // drop the now stale LPM entry.
+        deleteLpmRoute(hw_->getUnit(), vrf_, prefix_, len_);
+      }
+      return prepared;
+    }
+    // Host table full, fall back to the LPM table. Full mask routes live
+    // in a separate warm boot cache map than the LPM prefixes consulted
+    // by prepareLpmRoute(), so fix up the entry state here.
+    prepared.needLpmWrite = prepareLpmRoute(&prepared.rt, egressId, fwd);
     if (entryExistsInRouteTable) {
-      // If the entry already exists in the route table, programHostRoute()
-      // removes it as well.
-      DCHECK(!BcmRoute::deleteLpmRoute(hw_->getUnit(), vrf_, prefix_, len_));
+      // A warm boot left this full mask route in the route table, replace
+      // the HW entry in place.
+      prepared.rt.l3a_flags |= OPENNSL_L3_REPLACE;
+      prepared.needLpmWrite = true;
       warmBootCache->programmed(vrfAndIP2RouteCitr);
+    } else if (added_ && wasInHostTable) {
+      // The previous incarnation lived in the host table (dereferenced
+      // above), so there is no LPM entry to replace.
+      prepared.rt.l3a_flags &= ~OPENNSL_L3_REPLACE;
+      prepared.needLpmWrite = true;
     }
   } else {
-    programLpmRoute(egressId, fwd);
+    prepared.needLpmWrite = prepareLpmRoute(&prepared.rt, egressId, fwd);
   }
+  return prepared;
+}
+
+void BcmRoute::commitProgram(opennsl_if_t egressId,
+    const RouteForwardInfo& fwd) {
   if (added_) {
     // the route was added before, need to free the old nexthop(s)
-    cleanupHost(fwd_.getNexthops());
+    const auto& nhops = fwd_.getNexthops();
+    if (nhops.size()) {
+      hw_->writableHostTable()->derefBcmEcmpHost(vrf_, nhops);
+    }
   }
   egressId_ = egressId;
   fwd_ = fwd;
@@ -150,6 +239,14 @@ void BcmRoute::program(const RouteForwardInfo& fwd) {
   added_ = true;
 }
 
+void BcmRoute::abortProgram(const RouteForwardInfo& fwd) noexcept {
+  // free the host table references taken by prepareProgram()
+  const auto& nhops = fwd.getNexthops();
+  if (nhops.size()) {
+    hw_->writableHostTable()->derefBcmEcmpHost(vrf_, nhops);
+  }
+}
+
 void BcmRoute::programHostRoute(opennsl_if_t egressId,
     const RouteForwardInfo& fwd, bool replace) {
   auto hostRouteHost = hw_->writableHostTable()->incRefOrCreateBcmHost(
@@ -163,9 +260,9 @@ void BcmRoute::programHostRoute(opennsl_if_t egressId,
   hostRouteHost->addBcmHost(fwd.getNexthops().size() > 1, replace);
 }
 
-void BcmRoute::programLpmRoute(opennsl_if_t egressId,
-    const RouteForwardInfo& fwd) {
-  opennsl_l3_route_t rt;
+bool BcmRoute::prepareLpmRoute(opennsl_l3_route_t* rtPtr,
+    opennsl_if_t egressId, const RouteForwardInfo& fwd) {
+  auto& rt = *rtPtr;
   initL3RouteT(&rt);
   rt.l3a_intf = egressId;
   if (fwd.getNexthops().size() > 1) {         // multipath
@@ -207,16 +304,11 @@ void BcmRoute::programLpmRoute(opennsl_if_t egressId,
     if (added_) {
       rt.l3a_flags |= OPENNSL_L3_REPLACE;
     }
-    auto rc = opennsl_l3_route_add(hw_->getUnit(), &rt);
-    bcmCheckError(rc, "failed to create a route entry for ", prefix_, "/",
-        static_cast<int>(len_), " @ ", fwd, " @egress ", egressId);
-    VLOG(3) << "created a route entry for " << prefix_.str() << "/"
-      << static_cast<int>(len_) << " @egress " << egressId
-      << " with " << fwd;
   }
   if (vrfAndPfx2RouteCitr != warmBootCache->vrfAndPrefix2Route_end()) {
     warmBootCache->programmed(vrfAndPfx2RouteCitr);
   }
+  return addRoute;
 }
 
 bool BcmRoute::deleteLpmRoute(int unitNumber,
@@ -259,7 +351,7 @@ BcmRoute::~BcmRoute() {
   if (!added_) {
     return;
   }
-  if (canUseHostTable()) {
+  if (inHostTable_) {
     auto host = hw_->getHostTable()->getBcmHostIf(vrf_, prefix_);
     CHECK(host);
     VLOG(3) << "Derefrencing host prefix for : " << prefix_ << "/" << len_
@@ -329,7 +421,182 @@ void BcmRouteTable::addRoute(opennsl_vrf_t vrf, const RouteT *route) {
                                         prefix.mask));
   }
   CHECK(route->isResolved());
-  ret.first->second->program(route->getForwardInfo());
+  auto* bcmRoute = ret.first->second.get();
+  if (!batching_) {
+    bcmRoute->program(route->getForwardInfo());
+    return;
+  }
+  // In a batch, run the bookkeeping now but queue the SDK write so
+  // endProgramBatch() can issue it concurrently with the others.
+  const auto& fwd = route->getForwardInfo();
+  auto prepared = bcmRoute->prepareProgram(fwd);
+  if (!prepared.fwdChanged) {
+    return;
+  }
+  if (prepared.needLpmWrite) {
+    pendingWrites_.push_back(
+        PendingLpmWrite{bcmRoute, vrf, prepared.egressId, fwd, prepared.rt});
+  } else {
+    bcmRoute->commitProgram(prepared.egressId, fwd);
+  }
+}
+
+void BcmRouteTable::beginProgramBatch() {
+  CHECK(!batching_);
+  CHECK(pendingWrites_.empty());
+  batching_ = true;
+}
+
+void BcmRouteTable::abortProgramBatch() noexcept {
+  for (auto& write : pendingWrites_) {
+    write.route->abortProgram(write.fwd);
+  }
+  pendingWrites_.clear();
+  batching_ = false;
+}
+
+void BcmRouteTable::endProgramBatch() {
+  CHECK(batching_);
+  batching_ = false;
+  auto pending = std::move(pendingWrites_);
+  pendingWrites_.clear();
+  if (pending.empty()) {
+    return;
+  }
+  std::vector<int> rcs(pending.size(), OPENNSL_E_NONE);
+
+  // Partition the queued writes into per-VRF lanes, preserving delta
+  // order within each lane.  Lanes run concurrently, so one VRF's full
+  // sync cannot delay another VRF's single-route update.
+  struct Lane {
+    opennsl_vrf_t vrf;
+    std::vector<size_t> writes;
+  };
+  std::vector<Lane> lanes;
+  for (size_t i = 0; i < pending.size(); ++i) {
+    auto vrf = pending[i].vrf;
+    auto it = std::find_if(lanes.begin(), lanes.end(),
+                           [&] (const Lane& lane) { return lane.vrf == vrf; });
+    if (it == lanes.end()) {
+      lanes.push_back(Lane{vrf, {}});
+      it = lanes.end() - 1;
+    }
+    it->writes.push_back(i);
+  }
+
+  size_t numThreads = std::max(FLAGS_l3_route_program_threads, 1);
+  numThreads = std::min(numThreads, pending.size());
+  if (pending.size() < kParallelRouteProgramThreshold) {
+    numThreads = 1;
+  }
+
+  // The unit of scheduling is a chunk: a whole lane, or a slice of one
+  // when there are more workers than VRFs.  Slicing a lane is safe
+  // because each prefix has at most one queued write per delta, so
+  // concurrent chunks of the same VRF can never reorder updates to a
+  // prefix.
+  struct Chunk {
+    size_t lane;
+    size_t begin;  // Indices into lanes[lane].writes
+    size_t end;
+    std::chrono::steady_clock::time_point done;
+  };
+  std::vector<Chunk> chunks;
+  const size_t targetChunk = (pending.size() + numThreads - 1) / numThreads;
+  for (size_t l = 0; l < lanes.size(); ++l) {
+    const auto laneSize = lanes[l].writes.size();
+    if (lanes.size() >= numThreads || laneSize <= targetChunk) {
+      chunks.push_back(Chunk{l, 0, laneSize, {}});
+    } else {
+      for (size_t b = 0; b < laneSize; b += targetChunk) {
+        chunks.push_back(Chunk{l, b, std::min(b + targetChunk, laneSize), {}});
+      }
+    }
+  }
+
+  auto runChunk = [&] (Chunk& chunk) {
+    const auto& lane = lanes[chunk.lane];
+    for (auto j = chunk.begin; j < chunk.end; ++j) {
+      const auto i = lane.writes[j];
+      rcs[i] = opennsl_l3_route_add(hw_->getUnit(), &pending[i].rt);
+    }
+    chunk.done = std::chrono::steady_clock::now();
+  };
+
+  const auto batchStart = std::chrono::steady_clock::now();
+  if (numThreads == 1) {
+    for (auto& chunk : chunks) {
+      runChunk(chunk);
+    }
+  } else {
+    // Spread the chunks across the workers, biggest first, so the
+    // per-worker write counts balance out.
+    std::vector<size_t> order(chunks.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&] (size_t a, size_t b) {
+      return chunks[a].end - chunks[a].begin > chunks[b].end - chunks[b].begin;
+    });
+    std::vector<std::vector<size_t>> perWorker(numThreads);
+    std::vector<size_t> load(numThreads, 0);
+    for (auto idx : order) {
+      const size_t w = std::min_element(load.begin(), load.end()) -
+          load.begin();
+      perWorker[w].push_back(idx);
+      load[w] += chunks[idx].end - chunks[idx].begin;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(numThreads);
+    for (const auto& list : perWorker) {
+      workers.emplace_back([&, list] {
+        for (auto idx : list) {
+          runChunk(chunks[idx]);
+        }
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  // Export per-VRF convergence latency: batch start to the VRF's last
+  // completed write.
+  for (size_t l = 0; l < lanes.size(); ++l) {
+    std::chrono::steady_clock::time_point last{};
+    for (const auto& chunk : chunks) {
+      if (chunk.lane == l) {
+        last = std::max(last, chunk.done);
+      }
+    }
+    fbData->setCounter(
+        folly::to<std::string>("bcm.route_program.vrf.", lanes[l].vrf,
+                               ".convergence_us"),
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            last - batchStart).count());
+  }
+  // Back on the caller's thread, commit the successful writes and roll
+  // back any failed ones before reporting the first failure.
+  ssize_t firstFailure = -1;
+  for (size_t i = 0; i < pending.size(); ++i) {
+    auto& write = pending[i];
+    if (OPENNSL_FAILURE(rcs[i])) {
+      write.route->abortProgram(write.fwd);
+      if (firstFailure < 0) {
+        firstFailure = i;
+      }
+      continue;
+    }
+    write.route->commitProgram(write.egressId, write.fwd);
+  }
+  if (firstFailure >= 0) {
+    const auto& failed = pending[firstFailure];
+    explainRouteAddFailure(rcs[firstFailure]);
+    bcmCheckError(rcs[firstFailure], "failed to create a route entry for ",
+        failed.route->prefix(), "/",
+        static_cast<int>(failed.route->masklen()), " @ ", failed.fwd,
+        " @egress ", failed.egressId);
+  }
 }
 
 template<typename RouteT>
@@ -21,6 +21,8 @@ extern "C" {
 
 #include <boost/container/flat_map.hpp>
 
+#include <vector>
+
 namespace facebook { namespace fboss {
 
 class BcmSwitch;
@@ -35,6 +37,34 @@ class BcmRoute {
            const folly::IPAddress& addr, uint8_t len);
   ~BcmRoute();
   void program(const RouteForwardInfo& fwd);
+
+  /*
+   * Split-phase programming, used by BcmRouteTable's batched update path.
+   *
+   * prepareProgram() performs all the bookkeeping that has to stay on the
+   * update thread (host table references, warm boot cache handling, host
+   * table routes) and fills in the LPM entry to write, if one is needed.
+   * commitProgram() or abortProgram() then finish or roll back the update
+   * once the (possibly concurrent) SDK write has completed.
+   */
+  struct PreparedProgram {
+    // Does the route need (re)programming at all?
+    bool fwdChanged{false};
+    // Is an opennsl_l3_route_add() call still required?
+    bool needLpmWrite{false};
+    opennsl_if_t egressId{-1};
+    opennsl_l3_route_t rt;
+  };
+  PreparedProgram prepareProgram(const RouteForwardInfo& fwd);
+  void commitProgram(opennsl_if_t egressId, const RouteForwardInfo& fwd);
+  void abortProgram(const RouteForwardInfo& fwd) noexcept;
+
+  const folly::IPAddress& prefix() const {
+    return prefix_;
+  }
+  uint8_t masklen() const {
+    return len_;
+  }
   static bool deleteLpmRoute(int unit,
                              opennsl_vrf_t vrf,
                              const folly::IPAddress& prefix,
@@ -49,7 +79,12 @@ class BcmRoute {
   void programHostRoute(opennsl_if_t egressId,
                         const RouteForwardInfo& fwd,
                         bool replace);
-  void programLpmRoute(opennsl_if_t egressId, const RouteForwardInfo& fwd);
+  // Fill in the LPM entry to program and return whether an
+  // opennsl_l3_route_add() call is actually needed (the warm boot cache
+  // may tell us the HW entry is already in the desired state).
+  bool prepareLpmRoute(opennsl_l3_route_t* rt,
+                       opennsl_if_t egressId,
+                       const RouteForwardInfo& fwd);
   /*
    * Check whether we can use the host route table. BCM platforms
    * support this from TD2 onwards
@@ -65,6 +100,11 @@ class BcmRoute {
   uint8_t len_;
   RouteForwardInfo fwd_;
   bool added_{false};           // if the route added to HW or not
+  // Whether the route currently lives in the L3 host table. Full-mask
+  // routes prefer the host table when the platform supports it, but fall
+  // back to the LPM table when the host table (shared with ARP/NDP
+  // entries) is full.
+  bool inHostTable_{false};
   opennsl_if_t egressId_{-1};
   void initL3RouteT(opennsl_l3_route_t* rt) const;
 };
@@ -88,8 +128,34 @@ class BcmRouteTable {
   void addRoute(opennsl_vrf_t vrf, const RouteT *route);
   template<typename RouteT>
   void deleteRoute(opennsl_vrf_t vrf, const RouteT *route);
+
+  /*
+   * Batched route programming. Between beginProgramBatch() and
+   * endProgramBatch(), addRoute() only performs the host table and fib
+   * bookkeeping; the actual LPM writes are queued up and issued from
+   * multiple threads by endProgramBatch(), which joins all workers before
+   * returning. The SDK supports concurrent opennsl_l3_route_add() calls
+   * against the same unit. Deletes are not batched.
+   *
+   * The queued writes are partitioned into per-VRF lanes: each VRF's
+   * writes are issued in delta order on one worker, so one VRF's full
+   * sync cannot delay another VRF's single-route update, and
+   * per-VRF programming latency is exported per batch.
+   */
+  void beginProgramBatch();
+  void endProgramBatch();
+  // Undo the prepared state of any queued writes. Used to keep the host
+  // table reference counts sane if the delta processing throws mid-batch.
+  void abortProgramBatch() noexcept;
   folly::dynamic toFollyDynamic() const;
  private:
+  struct PendingLpmWrite {
+    BcmRoute* route;
+    opennsl_vrf_t vrf;
+    opennsl_if_t egressId;
+    RouteForwardInfo fwd;
+    opennsl_l3_route_t rt;
+  };
   struct Key {
     folly::IPAddress network;
     uint8_t mask;
@@ -98,6 +164,8 @@ class BcmRouteTable {
   };
   const BcmSwitch *hw_;
   boost::container::flat_map<Key, std::unique_ptr<BcmRoute>> fib_;
+  bool batching_{false};
+  std::vector<PendingLpmWrite> pendingWrites_;
 };
 
 }}
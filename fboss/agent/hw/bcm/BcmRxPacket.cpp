@@ -28,6 +28,11 @@ namespace facebook { namespace fboss {
 
 BcmRxPacket::BcmRxPacket(const opennsl_pkt_t* pkt)
   : unit_(pkt->unit) {
+  // We run in the SDK rx callback here, so this is the earliest point
+  // software sees the packet. OpenNSL does not expose the ASIC's own
+  // rx timestamp, so stamp arrival now, before any queueing.
+  stampArrival();
+
   // The BCM RX code always uses a single buffer.
   // As long as there is just a single buffer, we don't need to allocate
   // a separate array of opennsl_pkt_blk_t objects.
@@ -54,6 +59,14 @@ BcmRxPacket::BcmRxPacket(const opennsl_pkt_t* pkt)
   srcPort_ = PortID(static_cast<uint8_t>(pkt->src_port));
   srcVlan_ = VlanID(pkt->vlan);
   len_ = length;
+
+  // Packets trapped by the ingress/egress sampler are copies of
+  // forwarded traffic for the flow sampler, not packets addressed
+  // to the switch.
+  if (OPENNSL_RX_REASON_GET(pkt->rx_reasons, opennslRxReasonSampleSource) ||
+      OPENNSL_RX_REASON_GET(pkt->rx_reasons, opennslRxReasonSampleDest)) {
+    sampled_ = true;
+  }
 }
 
 BcmRxPacket::~BcmRxPacket() {
@@ -12,6 +12,9 @@
 #include "fboss/agent/SwitchStats.h"
 #include "common/stats/ExportedStatMapImpl.h"
 
+#include <folly/Conv.h>
+#include <folly/Memory.h>
+
 using facebook::stats::SUM;
 using facebook::stats::RATE;
 
@@ -36,8 +39,35 @@ BcmStats::BcmStats(ThreadLocalStatsMap *map)
                   SUM, RATE),
       txPktAllocErrors_(map, SwitchStats::kCounterPrefix +
           "bcm.tx.pkt.allocation.errors", SUM, RATE),
+      txPktPoolHits_(map, SwitchStats::kCounterPrefix + "bcm.tx.pkt.pool.hit",
+          SUM, RATE),
+      txPktPoolMisses_(map, SwitchStats::kCounterPrefix +
+          "bcm.tx.pkt.pool.miss", SUM, RATE),
+      hostsProgrammed_(map, SwitchStats::kCounterPrefix +
+          "bcm.host.programmed", SUM, RATE),
+      l2LearnEvents_(map, SwitchStats::kCounterPrefix +
+          "bcm.l2.learn.events", SUM, RATE),
+      l2LearnEventsCoalesced_(map, SwitchStats::kCounterPrefix +
+          "bcm.l2.learn.coalesced", SUM, RATE),
+      l2LearnEventDrops_(map, SwitchStats::kCounterPrefix +
+          "bcm.l2.learn.drops", SUM, RATE),
+      linkscanEvents_(map, SwitchStats::kCounterPrefix +
+          "bcm.linkscan.events", SUM, RATE),
+      switchEvents_(map, SwitchStats::kCounterPrefix +
+          "bcm.switch.events", SUM, RATE),
+      rxPkts_(map, SwitchStats::kCounterPrefix + "bcm.rx.pkts",
+              SUM, RATE),
       txQueued_(map, SwitchStats::kCounterPrefix + "bcm.tx.pkt.queued_us",
-                100, 0, 1000) {
+                100, 0, 1000),
+      l2LearnQueueDepth_(map, SwitchStats::kCounterPrefix +
+          "bcm.l2.learn.queue_depth", 128, 0, 8192) {
+  for (int chan = 0; chan < kRxChannels; ++chan) {
+    rxPktsChannel_[chan] = std::make_unique<TLTimeseries>(
+        map,
+        folly::to<std::string>(
+            SwitchStats::kCounterPrefix, "bcm.rx.pkts.chan", chan),
+        SUM, RATE);
+  }
 }
 
 BcmStats* BcmStats::createThreadStats() {
@@ -12,6 +12,8 @@
 #include "common/stats/ThreadCachedServiceData.h"
 #include <folly/ThreadLocal.h>
 
+#include <memory>
+
 namespace facebook { namespace fboss {
 
 class BcmStats {
@@ -52,6 +54,50 @@ class BcmStats {
     txErrors_.addValue(1);
     txPktAllocErrors_.addValue(1);
   }
+  void txPktPoolHit() {
+    txPktPoolHits_.addValue(1);
+  }
+  void txPktPoolMiss() {
+    txPktPoolMisses_.addValue(1);
+  }
+  void hostProgrammed() {
+    hostsProgrammed_.addValue(1);
+  }
+  void l2LearnEvents(uint64_t events) {
+    l2LearnEvents_.addValue(events);
+  }
+  void l2LearnEventsCoalesced(uint64_t events) {
+    l2LearnEventsCoalesced_.addValue(events);
+  }
+  void l2LearnEventDropped() {
+    l2LearnEventDrops_.addValue(1);
+  }
+  /*
+   * Sample the L2 learn queue depth at the start of a drain window. A
+   * rising histogram means the drain thread is falling behind the
+   * SDK's notification rate, well before the queue overflows.
+   */
+  void l2LearnQueueDepth(int64_t depth) {
+    l2LearnQueueDepth_.addValue(depth);
+  }
+  void linkscanEvent() {
+    linkscanEvents_.addValue(1);
+  }
+  void switchEvent() {
+    switchEvents_.addValue(1);
+  }
+  /*
+   * Record a packet received from the SDK rx callback, attributed to
+   * the rx DMA channel that serviced it. The per-channel RATE export
+   * shows whether the channel spreading configured via rx_channels is
+   * actually balancing the rx load.
+   */
+  void rxPkt(int channel) {
+    rxPkts_.addValue(1);
+    if (channel >= 0 && channel < kRxChannels) {
+      rxPktsChannel_[channel]->addValue(1);
+    }
+  }
 
  private:
   // Forbidden copy constructor and assignment operator
@@ -76,9 +122,36 @@ class BcmStats {
   // Errors in sending packets
   TLTimeseries txErrors_;
   TLTimeseries txPktAllocErrors_;
+  // Tx packet allocations served from the packet pool
+  TLTimeseries txPktPoolHits_;
+  // Tx packet allocations that had to go to the SDK allocator
+  TLTimeseries txPktPoolMisses_;
+  // Host/egress programming operations; the RATE export gives
+  // hosts programmed per second
+  TLTimeseries hostsProgrammed_;
+  // L2 learn/age events received from the SDK; the RATE export shows
+  // MAC move storms
+  TLTimeseries l2LearnEvents_;
+  // L2 learn/age events coalesced away within a batching window
+  TLTimeseries l2LearnEventsCoalesced_;
+  // L2 learn/age events dropped because the event queue was full
+  TLTimeseries l2LearnEventDrops_;
+  // Linkscan callbacks received from the SDK; the RATE export shows
+  // link flap storms
+  TLTimeseries linkscanEvents_;
+  // Critical switch events dispatched through BcmSwitchEventUtils
+  TLTimeseries switchEvents_;
+  // Rx DMA channel count; matches OPENNSL_RX_CHANNELS without pulling
+  // the SDK headers into this header
+  static constexpr int kRxChannels = 4;
+  // Packets received from the SDK, in total and per rx DMA channel
+  TLTimeseries rxPkts_;
+  std::unique_ptr<TLTimeseries> rxPktsChannel_[kRxChannels];
 
   // Time spent for each Tx packet queued in HW
   TLHistogram txQueued_;
+  // L2 learn queue depth sampled once per drain window
+  TLHistogram l2LearnQueueDepth_;
 
   static folly::ThreadLocalPtr<BcmStats> stats_;
 };
@@ -11,19 +11,26 @@
 
 #include <boost/cast.hpp>
 
+#include <cstring>
+
 #include <folly/Hash.h>
 #include <folly/Memory.h>
 #include <folly/ScopeGuard.h>
 #include <folly/Conv.h>
 #include <folly/FileUtil.h>
+#include <folly/json.h>
+#include "common/stats/ServiceData.h"
+#include "fboss/agent/BootProfiler.h"
 #include "fboss/agent/Constants.h"
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/SwitchStats.h"
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/Utils.h"
 #include "fboss/agent/hw/bcm/BcmAPI.h"
+#include "fboss/agent/hw/bcm/BcmEcmpStats.h"
 #include "fboss/agent/hw/bcm/BcmError.h"
 #include "fboss/agent/hw/bcm/BcmIntf.h"
+#include "fboss/agent/hw/bcm/BcmL2LearnBatcher.h"
 #include "fboss/agent/hw/bcm/BcmPlatform.h"
 #include "fboss/agent/hw/bcm/BcmPort.h"
 #include "fboss/agent/hw/bcm/BcmPortGroup.h"
@@ -31,9 +38,11 @@
 #include "fboss/agent/hw/bcm/BcmHost.h"
 #include "fboss/agent/hw/bcm/BcmRoute.h"
 #include "fboss/agent/hw/bcm/BcmRxPacket.h"
+#include "fboss/agent/hw/bcm/BcmStats.h"
 #include "fboss/agent/hw/bcm/BcmSwitchEventUtils.h"
 #include "fboss/agent/hw/bcm/BcmTableStats.h"
 #include "fboss/agent/hw/bcm/BcmTxPacket.h"
+#include "fboss/agent/hw/bcm/BcmTxPacketPool.h"
 #include "fboss/agent/hw/bcm/BcmUnit.h"
 #include "fboss/agent/hw/bcm/BcmWarmBootCache.h"
 #include "fboss/agent/hw/bcm/BcmCosManager.h"
@@ -58,6 +67,8 @@
 #include "fboss/agent/state/RouteDelta.h"
 
 extern "C" {
+#include <opennsl/l2.h>
+#include <opennsl/l3.h>
 #include <opennsl/link.h>
 #include <opennsl/port.h>
 #include <opennsl/stg.h>
@@ -86,6 +97,9 @@ DEFINE_int32(linkscan_interval_us, 250000,
              "The Broadcom linkscan interval");
 DEFINE_bool(flexports, false,
             "Load the agent with flexport support enabled");
+DEFINE_bool(l2_learn_event_batching, false,
+            "Collect L2 learn/age events from the SDK through the "
+            "batching layer");
 
 enum : uint8_t {
   kRxCallbackPriority = 1,
@@ -107,6 +121,32 @@ void dumpConfigMap(const facebook::fboss::BcmAPI::HwConfigMap& config,
   }
   folly::writeFile(toPrettyJson(json), filename.c_str());
 }
+
+/*
+ * Read back the h/w config dumped by the previous run. Returns an empty
+ * map if no dump exists (e.g. the very first boot on a platform) or it
+ * cannot be parsed.
+ */
+facebook::fboss::BcmAPI::HwConfigMap loadDumpedConfigMap(
+    const std::string& filename) {
+  facebook::fboss::BcmAPI::HwConfigMap config;
+  std::string contents;
+  if (!folly::readFile(filename.c_str(), contents)) {
+    return config;
+  }
+  try {
+    auto json = folly::parseJson(contents);
+    for (const auto& kv : json.items()) {
+      config.emplace(kv.first.asString(), kv.second.asString());
+    }
+  } catch (const std::exception& ex) {
+    LOG(WARNING) << "unable to parse h/w config dump " << filename
+                 << ": " << folly::exceptionStr(ex);
+  }
+  return config;
+}
+
+constexpr auto kAlpmSetting = "l3_alpm_enable";
 }
 
 namespace facebook { namespace fboss {
@@ -142,7 +182,17 @@ BcmSwitch::BcmSwitch(BcmPlatform *platform, HashMode hashMode)
     hostTable_(new BcmHostTable(this)),
     routeTable_(new BcmRouteTable(this)),
     aclTable_(new BcmAclTable(this)),
-    bcmTableStats_(new BcmTableStats(this)) {
+    cosManager_(new BcmCosManager(this)),
+    bcmTableStats_(new BcmTableStats(this)),
+    bcmEcmpStats_(new BcmEcmpStats(this)) {
+  // Capture the ALPM setting the previous run was configured with before
+  // we overwrite the dump below. init() uses it to reject warm booting
+  // across an ALPM mode change, which the SDK cannot do.
+  auto lastRunConfig = loadDumpedConfigMap(platform->getHwConfigDumpFile());
+  if (!lastRunConfig.empty()) {
+    auto it = lastRunConfig.find(kAlpmSetting);
+    alpmSettingFromLastRun_ = it == lastRunConfig.end() ? "0" : it->second;
+  }
   dumpConfigMap(BcmAPI::getHwConfig(), platform->getHwConfigDumpFile());
 
   exportSdkVersion();
@@ -164,6 +214,9 @@ unique_ptr<BcmUnit> BcmSwitch::releaseUnit() {
   // Destroy all of our member variables that track state,
   // to make sure they clean up their state now before we reset unit_.
   BcmSwitchEventUtils::resetUnit(unit_);
+  // The batcher's drain thread must be joined after the callback has
+  // been unregistered above, but before the unit goes away.
+  l2LearnBatcher_.reset();
   warmBootCache_.reset();
   routeTable_.reset();
   // Release host entries before reseting switch's host table
@@ -177,6 +230,10 @@ unique_ptr<BcmUnit> BcmSwitch::releaseUnit() {
   portTable_.reset();
   aclTable_.reset();
   bcmTableStats_.reset();
+  bcmEcmpStats_.reset();
+  // The pooled tx packets free their DMA buffers back to the SDK, which
+  // must happen while the unit is still attached.
+  txPacketPool_.reset();
 
   unit_ = -1;
   unitObject_->setCookie(nullptr);
@@ -204,6 +261,13 @@ void BcmSwitch::unregisterCallbacks() {
     disableLinkscan();
     flags_ &= ~LINKSCAN_REGISTERED;
   }
+  if (flags_ & L2_LEARN_REGISTERED) {
+    auto rv = opennsl_l2_addr_unregister(unit_,
+        BcmL2LearnBatcher::l2LearnCallback, l2LearnBatcher_.get());
+    CHECK(OPENNSL_SUCCESS(rv)) << "failed to unregister BcmSwitch L2 learn "
+      "callback: " << opennsl_errmsg(rv);
+    flags_ &= ~L2_LEARN_REGISTERED;
+  }
 }
 
 void BcmSwitch::remedyPorts() {
@@ -351,6 +415,9 @@ folly::dynamic BcmSwitch::toFollyDynamic() const {
 void BcmSwitch::clearWarmBootCache() {
   std::lock_guard<std::mutex> g(lock_);
   warmBootCache_->clear();
+  // All remaining ECMP groups now have BcmEcmpEgress objects, so link
+  // down handling can use the egress -> ECMP group index alone.
+  hostTable_->setEcmpShrinkFastPath(true);
 }
 
 bool BcmSwitch::isPortUp(PortID port) const {
@@ -406,6 +473,7 @@ std::shared_ptr<SwitchState> BcmSwitch::getWarmBootSwitchState() const {
 }
 
 HwInitResult BcmSwitch::init(Callback* callback) {
+  BootProfiler::Phase initPhase("BcmSwitch::init");
   HwInitResult ret;
 
   std::lock_guard<std::mutex> g(lock_);
@@ -422,6 +490,7 @@ HwInitResult BcmSwitch::init(Callback* callback) {
 
   // Initialize the switch.
   if (!unitObject_->isAttached()) {
+    BootProfiler::Phase phase("BcmUnit::attach");
     unitObject_->attach(platform_->getWarmBootDir());
   }
 
@@ -455,6 +524,18 @@ HwInitResult BcmSwitch::init(Callback* callback) {
   CHECK(bootType != BootType::UNINITIALIZED);
   auto warmBoot = bootType == BootType::WARM_BOOT;
 
+  if (BcmAPI::isAlpmEnabled()) {
+    LOG(INFO) << "L3 route tables running in ALPM mode";
+  }
+  if (warmBoot && alpmSettingFromLastRun_ &&
+      (*alpmSettingFromLastRun_ != "0") != BcmAPI::isAlpmEnabled()) {
+    // The route tables would be reinterpreted under the new mode and
+    // all LPM state lost; require a cold boot instead.
+    throw FbossError("Cannot warm boot across a change of ", kAlpmSetting,
+        " (previously ", *alpmSettingFromLastRun_, ", now ",
+        BcmAPI::getConfigValue(kAlpmSetting, "0"), ")");
+  }
+
   if (!warmBoot) {
     LOG (INFO) << " Performing cold boot ";
     // Cold boot - put all ports in Vlan 1
@@ -522,13 +603,23 @@ HwInitResult BcmSwitch::init(Callback* callback) {
     // This needs to be done after we have set
     // opennslSwitchL3EgressMode else the egress ids
     // in the host table don't show up correctly.
+    BootProfiler::Phase phase("BcmWarmBootCache::populate");
     warmBootCache_->populate();
+    // Until the FIB is synced and the warm boot cache cleared, ECMP
+    // groups may exist in hardware without BcmEcmpEgress objects, so
+    // link down handling can't rely on the egress -> ECMP group index.
+    // This must be decided before linkscan is registered below.
+    hostTable_->setEcmpShrinkFastPath(
+        warmBootCache_->ecmp2EgressIds().empty());
   }
   // create an egress object for ToCPU
   toCPUEgress_ = make_unique<BcmEgress>(this);
   toCPUEgress_->programToCPU();
 
-  portTable_->initPorts(&pcfg, warmBoot);
+  {
+    BootProfiler::Phase phase("BcmPortTable::initPorts");
+    portTable_->initPorts(&pcfg, warmBoot);
+  }
 
   bcmCheckError(rv, "failed to set linkscan ports");
   rv = opennsl_linkscan_register(unit_, linkscanCallback);
@@ -537,21 +628,36 @@ HwInitResult BcmSwitch::init(Callback* callback) {
   rv = opennsl_linkscan_enable_set(unit_, FLAGS_linkscan_interval_us);
   bcmCheckError(rv, "failed to enable linkscan");
 
-  // Set the spanning tree state of all ports to forwarding.
+  if (FLAGS_l2_learn_event_batching) {
+    l2LearnBatcher_ = make_unique<BcmL2LearnBatcher>(this);
+    rv = opennsl_l2_addr_register(unit_, BcmL2LearnBatcher::l2LearnCallback,
+        l2LearnBatcher_.get());
+    bcmCheckError(rv, "failed to register for L2 learn/age events");
+    flags_ |= L2_LEARN_REGISTERED;
+  }
+
+  // Set the spanning tree state of all ports to forwarding.  This is
+  // the one consolidated STP pass: every VLAN maps to the single
+  // default spanning tree group, so VLAN membership changes never need
+  // any per-vlan STP reprogramming, and the SDK only exposes a
+  // per-(group, port) setter anyway.
   // TODO: Eventually the spanning tree state should be part of the Port
   // state, and this should be handled in applyConfig().
-  //
-  // Spanning tree group settings
-  // TODO: This should eventually be done as part of applyConfig()
   opennsl_stg_t stg = 1;
   OPENNSL_PBMP_ITER(pcfg.port, idx) {
     rv = opennsl_stg_stp_set(unit_, stg, idx, OPENNSL_STG_STP_FORWARD);
     bcmCheckError(rv, "failed to set spanning tree state on port ", idx);
   }
 
+  // Pre-fill the tx packet pool so the first control plane replies don't
+  // have to go through the SDK allocator.
+  txPacketPool_ = make_unique<BcmTxPacketPool>(unit_);
+  txPacketPool_->warmFill();
+
   ret.bootType = bootType;
 
   if (warmBoot) {
+    BootProfiler::Phase phase("BcmSwitch warm boot state apply");
     auto warmBootState = getWarmBootSwitchState();
     stateChangedImpl(StateDelta(make_shared<SwitchState>(), warmBootState));
     hostTable_->warmBootHostEntriesSynced();
@@ -583,11 +689,44 @@ void BcmSwitch::initialConfigApplied() {
   //
   // Start the Broadcom packet RX API.
   if (!isRxThreadRunning()) {
-    rv = opennsl_rx_start(unit_, nullptr);
+    rv = startRx();
   }
   bcmCheckError(rv, "failed to start broadcom packet rx API");
 }
 
+int BcmSwitch::startRx() {
+  // Channel 0 is reserved by the SDK, so at most OPENNSL_RX_CHANNELS - 1
+  // channels can service packets to the CPU.
+  auto numChannels = std::min(BcmAPI::getNumRxChannels(),
+                              OPENNSL_RX_CHANNELS - 1);
+  numChannels = std::max(numChannels, 1);
+  constexpr int kNumCos = sizeof(rxCosToChannel_) / sizeof(rxCosToChannel_[0]);
+  for (int cos = 0; cos < kNumCos; ++cos) {
+    rxCosToChannel_[cos] = 1 + (cos % numChannels);
+  }
+  if (numChannels == 1) {
+    // Single channel rx is the stock SDK configuration.
+    return opennsl_rx_start(unit_, nullptr);
+  }
+  opennsl_rx_cfg_t cfg;
+  auto rv = opennsl_rx_cfg_get(unit_, &cfg);
+  bcmCheckError(rv, "failed to get default rx configuration");
+  // The default configuration services every CoS queue on channel 1.
+  // Spread the queues round robin across the configured channels so a
+  // flood on the low priority queues cannot monopolize the DMA channel
+  // that also carries the protocol queues.
+  int chains = cfg.chan_cfg[1].chains > 0 ? cfg.chan_cfg[1].chains : 4;
+  for (int chan = 1; chan <= numChannels; ++chan) {
+    cfg.chan_cfg[chan].chains = chains;
+    cfg.chan_cfg[chan].cos_bmp = 0;
+  }
+  for (int cos = 0; cos < kNumCos; ++cos) {
+    cfg.chan_cfg[rxCosToChannel_[cos]].cos_bmp |= (1u << cos);
+  }
+  LOG(INFO) << "starting rx with " << numChannels << " DMA channels";
+  return opennsl_rx_start(unit_, &cfg);
+}
+
 void BcmSwitch::stateChanged(const StateDelta& delta) {
   // Take the lock before modifying any objects
   std::lock_guard<std::mutex> g(lock_);
@@ -601,12 +740,18 @@ void BcmSwitch::stateChangedImpl(const StateDelta& delta) {
   // it, and move it out into a common helper class that can be shared by
   // many different HwSwitch implementations.
 
+  // Cheap per-section classification, so e.g. a neighbor-only update
+  // doesn't have to go through the route programming machinery at all.
+  const auto changedSections = delta.changedSections();
+
   // As the first step, disable ports that are now disabled.
   // This ensures that we immediately stop forwarding traffic on these ports.
   processDisabledPorts(delta);
 
   // remove all routes to be deleted
-  processRemovedRoutes(delta);
+  if (changedSections & StateDelta::SECTION_ROUTE_TABLES) {
+    processRemovedRoutes(delta);
+  }
 
   // delete all interface not existing anymore. that should stop
   // all traffic on that interface now
@@ -645,14 +790,27 @@ void BcmSwitch::stateChangedImpl(const StateDelta& delta) {
 
   configureCosQMappingForLocalInterfaces(delta);
 
+  // Reprogram the CPU CoS queues if the applied config changed them.
+  if ((changedSections & StateDelta::SECTION_SWITCH_SETTINGS) &&
+      delta.oldState()->getCpuQueues() != delta.newState()->getCpuQueues()) {
+    cosManager_->programCpuQueues(delta.newState()->getCpuQueues());
+  }
+
   // Any ARP changes
   processArpChanges(delta);
 
-  // Any ACL changes
-  processAclChanges(delta);
+  // Any ACL changes. Skip the per-entry delta walk entirely for the
+  // common deltas that leave the ACL table untouched.
+  if (changedSections & StateDelta::SECTION_ACLS) {
+    processAclChanges(delta);
+  }
 
-  // Process any new routes or route changes
-  processAddedChangedRoutes(delta);
+  // Process any new routes or route changes. Skipping this when the
+  // route tables are untouched also skips setting up (and joining) the
+  // batched route programming machinery.
+  if (changedSections & StateDelta::SECTION_ROUTE_TABLES) {
+    processAddedChangedRoutes(delta);
+  }
 
   // Reconfigure port groups in case we are changing between using a port as
   // 1, 2 or 4 ports. Only do this if flexports are enabled
@@ -680,6 +838,9 @@ unique_ptr<TxPacket> BcmSwitch::allocatePacket(uint32_t size) {
   // that supports multiple units.  Fortunately, the linux userspace
   // implemetation uses the same DMA pool for all local units, so it wouldn't
   // really matter which unit we specified when allocating the buffer.
+  if (txPacketPool_) {
+    return txPacketPool_->allocate(size);
+  }
   return make_unique<BcmTxPacket>(unit_, size);
 }
 
@@ -800,54 +961,52 @@ void BcmSwitch::changeDefaultVlan(VlanID id) {
 
 void BcmSwitch::processChangedVlan(const shared_ptr<Vlan>& oldVlan,
                                    const shared_ptr<Vlan>& newVlan) {
-  // Update port membership
-  opennsl_pbmp_t addedPorts;
-  OPENNSL_PBMP_CLEAR(addedPorts);
-  opennsl_pbmp_t addedUntaggedPorts;
-  OPENNSL_PBMP_CLEAR(addedUntaggedPorts);
+  // Compute the final membership bitmaps for this VLAN from the new
+  // state, and the set of ports that left it from the old state, then
+  // program the whole VLAN with at most one remove and one add call.
+  // Re-adding an existing member is a no-op for the SDK, and adding
+  // with the full untagged bitmap also picks up ports whose tagged
+  // flag flipped without changing membership, which the old
+  // added/removed diff silently skipped.
+  opennsl_pbmp_t allPorts;
+  OPENNSL_PBMP_CLEAR(allPorts);
+  opennsl_pbmp_t untaggedPorts;
+  OPENNSL_PBMP_CLEAR(untaggedPorts);
   opennsl_pbmp_t removedPorts;
   OPENNSL_PBMP_CLEAR(removedPorts);
   const auto& oldPorts = oldVlan->getPorts();
   const auto& newPorts = newVlan->getPorts();
 
-  auto oldIter = oldPorts.begin();
-  auto newIter = newPorts.begin();
-  uint32_t numAdded{0};
+  bool membersChanged = false;
+  for (const auto& entry : newPorts) {
+    opennsl_port_t bcmPort = portTable_->getBcmPortId(entry.first);
+    OPENNSL_PBMP_PORT_ADD(allPorts, bcmPort);
+    if (!entry.second.tagged) {
+      OPENNSL_PBMP_PORT_ADD(untaggedPorts, bcmPort);
+    }
+    auto oldIter = oldPorts.find(entry.first);
+    if (oldIter == oldPorts.end() || oldIter->second != entry.second) {
+      membersChanged = true;
+    }
+  }
   uint32_t numRemoved{0};
-  while (oldIter != oldPorts.end() || newIter != newPorts.end()) {
-    LoopAction action = LoopAction::CONTINUE;
-    if (oldIter == oldPorts.end() ||
-        (newIter != newPorts.end() && newIter->first < oldIter->first)) {
-      // This port was added
-      ++numAdded;
-      opennsl_port_t bcmPort = portTable_->getBcmPortId(newIter->first);
-      OPENNSL_PBMP_PORT_ADD(addedPorts, bcmPort);
-      if (!newIter->second.tagged) {
-        OPENNSL_PBMP_PORT_ADD(addedUntaggedPorts, bcmPort);
-      }
-      ++newIter;
-    } else if (newIter == newPorts.end() ||
-        (oldIter != oldPorts.end() && oldIter->first < newIter->first)) {
-      // This port was removed
+  for (const auto& entry : oldPorts) {
+    if (newPorts.find(entry.first) == newPorts.end()) {
+      OPENNSL_PBMP_PORT_ADD(removedPorts,
+                            portTable_->getBcmPortId(entry.first));
       ++numRemoved;
-      opennsl_port_t bcmPort = portTable_->getBcmPortId(oldIter->first);
-      OPENNSL_PBMP_PORT_ADD(removedPorts, bcmPort);
-      ++oldIter;
-    } else {
-      ++oldIter;
-      ++newIter;
     }
   }
 
   VLOG(2) << "updating VLAN " << newVlan->getID() << ": " <<
-    numAdded << " ports added, " << numRemoved << " ports removed";
+    newPorts.size() << " members, " << numRemoved << " ports removed";
   if (numRemoved) {
     auto rv = opennsl_vlan_port_remove(unit_, newVlan->getID(), removedPorts);
     bcmCheckError(rv, "failed to remove ports from VLAN ", newVlan->getID());
   }
-  if (numAdded) {
+  if (membersChanged) {
     auto rv = opennsl_vlan_port_add(unit_, newVlan->getID(),
-                                addedPorts, addedUntaggedPorts);
+                                    allPorts, untaggedPorts);
     bcmCheckError(rv, "failed to add ports to VLAN ", newVlan->getID());
   }
 }
@@ -989,6 +1148,12 @@ void BcmSwitch::processNeighborEntryDelta(const DELTA& delta) {
 }
 
 void BcmSwitch::processArpChanges(const StateDelta& delta) {
+  // Batch the port->egress mapping updates from the whole delta so we
+  // publish the map and notify ECMP groups once instead of per host.
+  hostTable_->startProgrammingBatch();
+  SCOPE_EXIT {
+    hostTable_->commitProgrammingBatch();
+  };
   for (const auto& vlanDelta : delta.getVlansDelta()) {
     for (const auto& arpDelta : vlanDelta.getArpDelta()) {
       processNeighborEntryDelta(arpDelta);
@@ -1058,6 +1223,14 @@ void BcmSwitch::processRemovedRoutes(const StateDelta& delta) {
 }
 
 void BcmSwitch::processAddedChangedRoutes(const StateDelta& delta) {
+  // Batch up the route programming so BcmRouteTable can issue the SDK
+  // writes from multiple threads. endProgramBatch() joins its workers
+  // before returning, so the HW is fully programmed by the time the
+  // delta is considered applied.
+  routeTable_->beginProgramBatch();
+  SCOPE_FAIL {
+    routeTable_->abortProgramBatch();
+  };
   for (auto const& rtDelta : delta.getRouteTablesDelta()) {
     if (!rtDelta.getNew()) {
       // no new route table, must not added or changed route, skip
@@ -1079,11 +1252,13 @@ void BcmSwitch::processAddedChangedRoutes(const StateDelta& delta) {
         this,
         id);
   }
+  routeTable_->endProgramBatch();
 }
 
 void BcmSwitch::linkscanCallback(int unit,
                                  opennsl_port_t bcmPort,
                                  opennsl_port_info_t* info) {
+  BcmStats::get()->linkscanEvent();
   try {
     BcmUnit* unitObj = BcmAPI::getUnit(unit);
     BcmSwitch* sw = static_cast<BcmSwitch*>(unitObj->getCookie());
@@ -1128,6 +1303,7 @@ opennsl_rx_t BcmSwitch::packetReceived(opennsl_pkt_t* pkt) noexcept {
       folly::exceptionStr(ex);
     return OPENNSL_RX_NOT_HANDLED;
   }
+  BcmStats::get()->rxPkt(rxCosToChannel_[pkt->cos & 0x1f]);
   callback_->packetReceived(std::move(bcmPkt));
   return OPENNSL_RX_HANDLED_OWNED;
 }
@@ -1163,6 +1339,8 @@ void BcmSwitch::updateStats(SwitchStats *switchStats) {
   }
   // Update global statistics.
   updateGlobalStats();
+  // Update per-CPU-queue drop counters.
+  cosManager_->updateCounters();
 }
 
 shared_ptr<BcmSwitchEventCallback> BcmSwitch::registerSwitchEventCallback(
@@ -1186,7 +1364,23 @@ void BcmSwitch::updateThreadLocalPortStats(PortID portID,
 
 void BcmSwitch::updateGlobalStats() {
   portTable_->updatePortStats();
+  // Refresh on the stats collection interval as well as after every
+  // state delta, so occupancy moved by linkscan or SDK-internal churn
+  // (and the high-water marks) can't go stale between deltas.  Hold the
+  // hw lock while reading the software tables, like any other reader.
+  {
+    std::lock_guard<std::mutex> g(lock_);
+    bcmTableStats_->refresh();
+    // Sample after updatePortStats() above, so the per-member deltas
+    // cover exactly one collection interval.
+    bcmEcmpStats_->refresh();
+  }
   bcmTableStats_->publish();
+  bcmEcmpStats_->publish();
+  // Egress entries wasted on duplicate resolved tuples; see the note on
+  // egress object management in BcmHostTable.
+  fbData->setCounter("bcm.egress.duplicate_entries",
+                     hostTable_->numEgressDuplicates());
 }
 
 opennsl_if_t BcmSwitch::getDropEgressId() const {
@@ -1211,6 +1405,73 @@ bool BcmSwitch::getAndClearNeighborHit(RouterID vrf,
   return host->getAndClearHitBit();
 }
 
+void BcmSwitch::getPacketTrace(PortID port,
+                               folly::StringPiece data,
+                               PacketTraceInfo* info) {
+  // The hardware requires a full (minimum sized) frame for the probe
+  if (data.size() < 64) {
+    throw FbossError("packet trace probe must be at least 64 bytes, got ",
+                     data.size());
+  }
+  std::lock_guard<std::mutex> g(lock_);
+
+  opennsl_switch_pkt_trace_info_t traceInfo;
+  memset(&traceInfo, 0, sizeof(traceInfo));
+  // The SDK wants a mutable buffer even though it only reads the frame
+  std::vector<uint8_t> frame(data.begin(), data.end());
+  auto rv = opennsl_switch_pkt_trace_info_get(
+      unit_, 0, portTable_->getBcmPortId(port), frame.size(), frame.data(),
+      &traceInfo);
+  bcmCheckError(rv, "failed to collect packet trace for port ", port);
+
+  // Raw per-stage lookup hits, in SDK enum space; consumers interpret
+  // them against opennsl_switch_pkt_trace_lookup_t
+  for (int lookup = 0; lookup < opennslswitchPktTraceLookupCount; ++lookup) {
+    if (OPENNSL_SWITCH_PKT_TRACE_LOOKUP_GET(
+            traceInfo.pkt_trace_lookup_status,
+            static_cast<opennsl_switch_pkt_trace_lookup_t>(lookup))) {
+      info->lookupResult.push_back(lookup);
+    }
+  }
+  info->resolution = traceInfo.pkt_trace_resolution;
+  info->stpState = traceInfo.pkt_trace_stp_state;
+  info->destPipeNum = traceInfo.dest_pipe_num;
+
+  // Resolve the ECMP group the probe hashed through into front panel
+  // ports, which is what the path symmetry probers actually compare
+  const auto& hashInfo = traceInfo.pkt_trace_hash_info;
+  if (hashInfo.flags & OPENNSL_SWITCH_PKT_TRACE_ECMP_1) {
+    int memberCount = 0;
+    rv = opennsl_l3_egress_multipath_get(unit_, hashInfo.ecmp_1_group, 0,
+                                         nullptr, &memberCount);
+    bcmCheckError(rv, "failed to get ECMP group size for group ",
+                  hashInfo.ecmp_1_group);
+    std::vector<opennsl_if_t> members(memberCount);
+    rv = opennsl_l3_egress_multipath_get(unit_, hashInfo.ecmp_1_group,
+                                         memberCount, members.data(),
+                                         &memberCount);
+    bcmCheckError(rv, "failed to get ECMP members for group ",
+                  hashInfo.ecmp_1_group);
+    for (auto memberEgressId : members) {
+      auto bcmPort = hostTable_->egressIdPort(memberEgressId);
+      if (bcmPort) {
+        info->hashInfo.potentialEgressPorts.push_back(
+            portTable_->getPortId(bcmPort));
+      }
+    }
+    auto actualPort = hostTable_->egressIdPort(hashInfo.ecmp_1_egress);
+    if (actualPort) {
+      info->hashInfo.actualEgressPort = portTable_->getPortId(actualPort);
+    }
+  }
+}
+
+void BcmSwitch::getHwTableUsage(std::vector<HwTableUsage>& usage) const {
+  // Reads the last refreshed snapshot, so this doesn't need the hw lock
+  // and can't stall behind route programming.
+  bcmTableStats_->fillTableUsage(&usage);
+}
+
 void BcmSwitch::exitFatal() const {
   dumpState();
   callback_->exitFatal();
@@ -16,6 +16,7 @@
 #include "fboss/agent/hw/bcm/BcmSwitchEventCallback.h"
 #include "fboss/agent/hw/bcm/gen-cpp2/packettrace_types.h"
 #include <folly/dynamic.h>
+#include <folly/Optional.h>
 
 #include <memory>
 #include <mutex>
@@ -34,14 +35,17 @@ struct AclEntryID;
 class AclEntry;
 class ArpEntry;
 class BcmCosManager;
+class BcmEcmpStats;
 class BcmEgress;
 class BcmHostTable;
 class BcmIntfTable;
+class BcmL2LearnBatcher;
 class BcmPlatform;
 class BcmPortTable;
 class BcmRouteTable;
 class BcmRxPacket;
 class BcmTableStats;
+class BcmTxPacketPool;
 class BcmUnit;
 class BcmWarmBootCache;
 class MockRxPacket;
@@ -278,6 +282,16 @@ class BcmSwitch : public BcmSwitchIf {
   bool getAndClearNeighborHit(RouterID vrf,
                               folly::IPAddress& ip) override;
 
+  /*
+   * Trace a probe frame through the pipeline via the Broadcom packet
+   * trace facility and report the per-stage resolution.
+   */
+  void getPacketTrace(PortID port,
+                      folly::StringPiece data,
+                      PacketTraceInfo* info) override;
+
+  void getHwTableUsage(std::vector<HwTableUsage>& usage) const override;
+
   cfg::PortSpeed getPortSpeed(PortID port) const override;
   cfg::PortSpeed getMaxPortSpeed(PortID port) const override;
   bool getPortFECConfig(PortID port) const override;
@@ -287,7 +301,8 @@ class BcmSwitch : public BcmSwitchIf {
  private:
   enum Flags : uint32_t {
     RX_REGISTERED = 0x01,
-    LINKSCAN_REGISTERED = 0x02
+    LINKSCAN_REGISTERED = 0x02,
+    L2_LEARN_REGISTERED = 0x04
   };
   // Forbidden copy constructor and assignment operator
   BcmSwitch(BcmSwitch const &) = delete;
@@ -305,6 +320,16 @@ class BcmSwitch : public BcmSwitchIf {
   std::shared_ptr<SwitchState> getWarmBootSwitchState() const;
 
   std::unique_ptr<BcmRxPacket> createRxPacket(opennsl_pkt_t* pkt);
+
+  /*
+   * Configure the rx DMA channels and start the SDK rx API.
+   *
+   * With rx_channels > 1 in the hw config, the CPU CoS queues are spread
+   * round robin across the channels so one flooded queue cannot starve
+   * DMA servicing for the others. Returns an OPENNSL_E_* code.
+   */
+  int startRx();
+
   void changeDefaultVlan(VlanID id);
 
   void processChangedVlan(const std::shared_ptr<Vlan>& oldVlan,
@@ -509,6 +534,18 @@ class BcmSwitch : public BcmSwitchIf {
   std::unique_ptr<BcmAclTable> aclTable_;
   std::unique_ptr<BcmCosManager> cosManager_;
   std::unique_ptr<BcmTableStats> bcmTableStats_;
+  std::unique_ptr<BcmEcmpStats> bcmEcmpStats_;
+  std::unique_ptr<BcmTxPacketPool> txPacketPool_;
+  std::unique_ptr<BcmL2LearnBatcher> l2LearnBatcher_;
+  // Which rx DMA channel services each CPU CoS queue. Filled in by
+  // startRx() and used to attribute received packets to channels in
+  // BcmStats. Sized to match the 32 bit cos_bmp in the rx channel
+  // configuration.
+  uint8_t rxCosToChannel_[32] = {};
+  // l3_alpm_enable value from the h/w config dump of the previous run,
+  // if a dump existed. Used to refuse warm booting across an ALPM mode
+  // change.
+  folly::Optional<std::string> alpmSettingFromLastRun_;
   /*
    * Lock to synchronize access to all BCM* data structures
    */
@@ -10,6 +10,7 @@
 #include "fboss/agent/hw/bcm/BcmSwitchEventUtils.h"
 
 #include "fboss/agent/hw/bcm/BcmError.h"
+#include "fboss/agent/hw/bcm/BcmStats.h"
 #include "fboss/agent/hw/bcm/BcmSwitch.h"
 #include "fboss/agent/hw/bcm/BcmSwitchEventCallback.h"
 
@@ -100,6 +101,7 @@ void unregisterSwitchEventCallback(const int unit,
 void callbackDispatch(int unit,
     opennsl_switch_event_t eventID, uint32_t arg1, uint32_t arg2,
     uint32_t arg3, void* userdata) {
+  BcmStats::get()->switchEvent();
   std::shared_ptr<BcmSwitchEventCallback> callbackObj;
   SYNCHRONIZED_CONST(callbacks) {
     auto unitCallbacks = callbacks.find(unit);
@@ -10,6 +10,12 @@
 #pragma once
 
 #include "fboss/agent/hw/bcm/gen-cpp2/bcmswitch_types.h"
+#include "fboss/agent/if/gen-cpp2/ctrl_types.h"
+
+#include <folly/Range.h>
+
+#include <mutex>
+#include <vector>
 
 namespace facebook { namespace fboss {
 
@@ -18,17 +24,38 @@ class BcmSwitch;
 class BcmTableStats {
  public:
   explicit BcmTableStats(const BcmSwitch* hw) : hw_(hw) {}
-  void refresh() {
-    stats_.hw_table_stats_stale =
-        !(refreshHwStatusStats() && refreshLPMStats());
-  }
+  void refresh();
   void publish() const;
+  /*
+   * Fill per-table occupancy, headroom and high-water marks for the
+   * getHwTableUsage() Thrift call.  May be called from any thread.
+   */
+  void fillTableUsage(std::vector<HwTableUsage>* usage) const;
 
  private:
-  bool refreshHwStatusStats();
-  bool refreshLPMStats();
+  bool refreshHwStatusStats(BcmHwTableStats* stats);
+  bool refreshLPMStats(BcmHwTableStats* stats);
+  void refreshAclStats(BcmHwTableStats* stats);
+
+  static void appendUsage(std::vector<HwTableUsage>* usage,
+                          folly::StringPiece table,
+                          int32_t used,
+                          int32_t max,
+                          int32_t highWater);
+
   const BcmSwitch* hw_{nullptr};
 
+  /*
+   * stats_ is refreshed from the update thread after every state delta
+   * and read by the stats publisher and Thrift threads, so all access
+   * goes through lock_.
+   */
+  mutable std::mutex lock_;
   BcmHwTableStats stats_;
+  /*
+   * Highest value seen for each used counter since the agent started,
+   * field-for-field parallel to stats_.
+   */
+  BcmHwTableStats highWater_;
 };
 }}
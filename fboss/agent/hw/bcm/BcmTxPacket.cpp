@@ -11,6 +11,7 @@
 
 #include "fboss/agent/hw/bcm/BcmError.h"
 #include "fboss/agent/hw/bcm/BcmStats.h"
+#include "fboss/agent/hw/bcm/BcmTxPacketPool.h"
 
 extern "C" {
 #include <opennsl/tx.h>
@@ -32,7 +33,6 @@ void freeTxBuf(void *ptr, void* arg) {
 
 void txCallback(int unit, opennsl_pkt_t* pkt, void* cookie) {
   // Put the BcmTxPacket back into a unique_ptr.
-  // This will delete it when we return.
   unique_ptr<facebook::fboss::BcmTxPacket> bcmTxPkt(
       static_cast<facebook::fboss::BcmTxPacket*>(cookie));
   DCHECK_EQ(pkt, bcmTxPkt->getPkt());
@@ -44,6 +44,10 @@ void txCallback(int unit, opennsl_pkt_t* pkt, void* cookie) {
   auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
       end - bcmTxPkt->getQueueTime());
   BcmStats::get()->txSentDone(duration.count());
+
+  // Packets allocated from the tx packet pool go back into it for reuse;
+  // everything else is deleted when the unique_ptr goes out of scope.
+  BcmTxPacketPool::recycle(std::move(bcmTxPkt));
 }
 
 }
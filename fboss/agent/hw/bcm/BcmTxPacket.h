@@ -20,6 +20,8 @@ extern "C" {
 
 namespace facebook { namespace fboss {
 
+class BcmTxPacketPool;
+
 class BcmTxPacket : public TxPacket {
  public:
   BcmTxPacket(int unit, uint32_t size);
@@ -46,6 +48,16 @@ class BcmTxPacket : public TxPacket {
     OPENNSL_PBMP_PORT_SET(pkt_->tx_upbmp, port);
   }
 
+  /*
+   * OpenNSL only exposes OPENNSL_TX_CRC_APPEND and OPENNSL_TX_ETHER on
+   * opennsl_pkt_t; there is no flag to request L3/L4 checksum insertion
+   * on transmit. Until the SDK grows one, all checksums for CPU-originated
+   * packets have to be computed in software.
+   */
+  uint8_t enableCsumOffload(uint8_t /* flags */) override {
+    return 0;
+  }
+
   /*
    * Send a BcmTxPacket asynchronously.
    *
@@ -58,6 +70,16 @@ class BcmTxPacket : public TxPacket {
    */
   static int sendAsync(std::unique_ptr<BcmTxPacket> pkt) noexcept;
 
+  /*
+   * The pool this packet should be returned to when its send completes,
+   * or nullptr if it was allocated directly from the SDK.
+   */
+  BcmTxPacketPool* getPool() const {
+    return pool_;
+  }
+  void setPool(BcmTxPacketPool* pool) {
+    pool_ = pool;
+  }
 
  private:
   // Forbidden copy constructor and assignment operator
@@ -69,6 +91,9 @@ class BcmTxPacket : public TxPacket {
 
   // time point when the packet is queued to HW
   TimePoint queued_;
+
+  // the pool to recycle this packet into when the send completes
+  BcmTxPacketPool* pool_{nullptr};
 };
 
 }} // facebook::fboss
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/hw/bcm/BcmTxPacketPool.h"
+
+#include "fboss/agent/hw/bcm/BcmStats.h"
+
+DEFINE_int32(tx_pkt_pool_max_per_class, 1024,
+             "Maximum number of tx packets pooled per size class; "
+             "recycled packets beyond this are freed to the SDK");
+DEFINE_int32(tx_pkt_pool_warm_count, 256,
+             "Number of tx packets to pre-allocate into the pool at init");
+
+using std::unique_ptr;
+
+namespace facebook { namespace fboss {
+
+BcmTxPacketPool::BcmTxPacketPool(int unit) : unit_(unit) {
+}
+
+BcmTxPacketPool::~BcmTxPacketPool() {
+  // The pooled packets return their DMA buffers to the SDK as they are
+  // destroyed, so the pool must be torn down while the unit is still
+  // attached.
+}
+
+unique_ptr<BcmTxPacket> BcmTxPacketPool::allocate(uint32_t size) {
+  if (size > kMaxPooledSize) {
+    return std::make_unique<BcmTxPacket>(unit_, size);
+  }
+  const uint32_t cls = (size + kSizeClass - 1) / kSizeClass * kSizeClass;
+  unique_ptr<BcmTxPacket> pkt;
+  {
+    folly::SpinLockGuard guard(lock_);
+    auto it = pool_.find(cls);
+    if (it != pool_.end() && !it->second.empty()) {
+      pkt = std::move(it->second.back());
+      it->second.pop_back();
+    }
+  }
+  if (pkt) {
+    BcmStats::get()->txPktPoolHit();
+  } else {
+    BcmStats::get()->txPktPoolMiss();
+    pkt = std::make_unique<BcmTxPacket>(unit_, cls);
+    pkt->setPool(this);
+  }
+  // Hand out exactly the requested size; the buffer is restored to the
+  // full size class extent when the packet is recycled.
+  auto buf = pkt->buf();
+  buf->trimEnd(buf->length() - size);
+  return pkt;
+}
+
+void BcmTxPacketPool::warmFill() {
+  std::vector<unique_ptr<BcmTxPacket>> pkts;
+  pkts.reserve(FLAGS_tx_pkt_pool_warm_count);
+  for (int i = 0; i < FLAGS_tx_pkt_pool_warm_count; ++i) {
+    pkts.push_back(allocate(kSizeClass));
+  }
+  for (auto& pkt : pkts) {
+    recycle(std::move(pkt));
+  }
+}
+
+void BcmTxPacketPool::recycle(unique_ptr<BcmTxPacket> pkt) {
+  auto pool = pkt->getPool();
+  if (!pool) {
+    // not a pooled packet, the unique_ptr frees it back to the SDK
+    return;
+  }
+  pool->recycleImpl(std::move(pkt));
+}
+
+void BcmTxPacketPool::recycleImpl(unique_ptr<BcmTxPacket> pkt) {
+  auto buf = pkt->buf();
+  if (buf->isShared()) {
+    // Someone (e.g. packet capture) still holds a clone of the buffer.
+    // Free the packet rather than reusing the bytes under them.
+    return;
+  }
+  // Restore the buffer to its full allocated extent and clear the
+  // completed send's callback so the packet can be sent again.
+  buf->clear();
+  buf->append(buf->capacity());
+  pkt->getPkt()->call_back = nullptr;
+  folly::SpinLockGuard guard(lock_);
+  auto& freeList = pool_[buf->length()];
+  if (freeList.size() <
+      static_cast<size_t>(FLAGS_tx_pkt_pool_max_per_class)) {
+    freeList.push_back(std::move(pkt));
+  }
+}
+
+}} // facebook::fboss
@@ -0,0 +1,78 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/agent/hw/bcm/BcmTxPacket.h"
+
+#include <folly/SpinLock.h>
+
+#include <boost/container/flat_map.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+/*
+ * BcmTxPacketPool recycles DMA-able tx buffers so that control plane
+ * replies (ARP, NDP, ICMP) don't go through the SDK allocator on every
+ * send.
+ *
+ * Buffers are pooled in size classes. allocate() hands out a pooled
+ * buffer trimmed to the requested size when one is available; completed
+ * sends return their buffer via recycle() from the SDK tx completion
+ * callback. Requests larger than the biggest size class bypass the pool
+ * and behave exactly like a direct BcmTxPacket allocation.
+ */
+class BcmTxPacketPool {
+ public:
+  explicit BcmTxPacketPool(int unit);
+  ~BcmTxPacketPool();
+
+  /*
+   * Allocate a packet with a buffer of exactly size bytes, reusing a
+   * pooled buffer when one is available.
+   */
+  std::unique_ptr<BcmTxPacket> allocate(uint32_t size);
+
+  /*
+   * Pre-fill the smallest size class, which covers all of the control
+   * plane replies, so the first sends after init don't hit the SDK
+   * allocator either.
+   */
+  void warmFill();
+
+  /*
+   * Return a packet whose async send has completed to the pool it came
+   * from, or free it if it didn't come from a pool. Called from the SDK
+   * tx completion callback.
+   */
+  static void recycle(std::unique_ptr<BcmTxPacket> pkt);
+
+ private:
+  // Pooled buffer sizes are rounded up to a multiple of kSizeClass;
+  // requests larger than kMaxPooledSize bypass the pool.
+  enum : uint32_t { kSizeClass = 512 };
+  enum : uint32_t { kMaxPooledSize = 4096 };
+
+  // Forbidden copy constructor and assignment operator
+  BcmTxPacketPool(BcmTxPacketPool const &) = delete;
+  BcmTxPacketPool& operator=(BcmTxPacketPool const &) = delete;
+
+  void recycleImpl(std::unique_ptr<BcmTxPacket> pkt);
+
+  int unit_{-1};
+  folly::SpinLock lock_;
+  // free lists keyed by buffer size, one entry per size class
+  boost::container::flat_map<uint32_t,
+    std::vector<std::unique_ptr<BcmTxPacket>>> pool_;
+};
+
+}} // facebook::fboss
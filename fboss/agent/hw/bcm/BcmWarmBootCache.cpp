@@ -16,6 +16,7 @@
 #include <folly/dynamic.h>
 #include <folly/json.h>
 
+#include "common/stats/ServiceData.h"
 #include "fboss/agent/Constants.h"
 #include "fboss/agent/hw/bcm/BcmEgress.h"
 #include "fboss/agent/hw/bcm/BcmPlatform.h"
@@ -542,11 +543,29 @@ std::string BcmWarmBootCache::toEgressIdsStr(const EgressIds& egressIds) {
   return egressStr;
 }
 
+void BcmWarmBootCache::publishCacheCounters() const {
+  fbData->setCounter("warm_boot.route_cache.hits", routeCacheHits_);
+  fbData->setCounter("warm_boot.route_cache.misses", routeCacheMisses_);
+  fbData->setCounter("warm_boot.host_cache.hits", hostCacheHits_);
+  fbData->setCounter("warm_boot.host_cache.misses", hostCacheMisses_);
+  fbData->setCounter("warm_boot.egress_cache.hits", egressCacheHits_);
+  fbData->setCounter("warm_boot.egress_cache.misses", egressCacheMisses_);
+  VLOG(1) << "Warm boot cache lookups, route hits: " << routeCacheHits_
+          << " misses: " << routeCacheMisses_
+          << " host hits: " << hostCacheHits_
+          << " misses: " << hostCacheMisses_
+          << " egress hits: " << egressCacheHits_
+          << " misses: " << egressCacheMisses_;
+}
+
 void BcmWarmBootCache::clear() {
   // Get rid of all unclaimed entries. The order is important here
   // since we want to delete entries only after there are no more
   // references to them.
   VLOG(1) << "Warm boot: removing unreferenced entries";
+  // All reprogramming is done by the time we are asked to clear, so
+  // lookup counts are final.
+  publishCacheCounters();
   dumpedSwSwitchState_.reset();
   hwSwitchEcmp2EgressIds_.clear();
   // First delete routes (fully qualified and others).
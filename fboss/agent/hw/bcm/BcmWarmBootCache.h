@@ -18,10 +18,12 @@ extern "C" {
 #include <string>
 #include <list>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
 #include <folly/dynamic.h>
+#include <folly/Hash.h>
 #include <folly/IPAddress.h>
 #include <folly/MacAddress.h>
 #include "fboss/agent/types.h"
@@ -105,24 +107,40 @@ class BcmWarmBootCache {
           folly::IPAddress> VrfAndPrefix;
   typedef std::pair<opennsl_vrf_t, folly::IPAddress> VrfAndIP;
   /*
-   * Cache containers
+   * Hash functors for the route, host and egress indexes below.
+   */
+  struct VrfAndIPHash {
+    size_t operator()(const VrfAndIP& key) const {
+      return folly::hash::hash_combine(key.first, key.second.hash());
+    }
+  };
+  struct VrfAndPrefixHash {
+    size_t operator()(const VrfAndPrefix& key) const {
+      return folly::hash::hash_combine(std::get<0>(key),
+          std::get<1>(key).hash(), std::get<2>(key).hash());
+    }
+  };
+  /*
+   * Cache containers. The small tables (vlans, interfaces, stations) stay
+   * flat_maps, while the route, host and egress tables are hash indexes.
+   * The latter see a find per entry reprogrammed during warm boot init,
+   * and on boxes with big FIBs the cumulative cost of sorted-vector
+   * inserts and O(log n) finds shows up in warm boot downtime.
    */
   typedef boost::container::flat_map<VlanID, VlanInfo> Vlan2VlanInfo;
   typedef boost::container::flat_map<VlanID, opennsl_l2_station_t> Vlan2Station;
   typedef boost::container::flat_map<VlanAndMac, opennsl_l3_intf_t>
     VlanAndMac2Intf;
-  typedef boost::container::flat_map<VrfAndIP,
-          opennsl_l3_host_t> VrfAndIP2Host;
-  typedef boost::container::flat_map<VrfAndIP, EgressId> VrfAndIP2EgressId;
-  typedef boost::container::flat_map<EgressId, VrfAndIP> EgressId2VrfAndIP;
-  typedef boost::container::flat_map<VrfAndPrefix, opennsl_l3_route_t>
-    VrfAndPrefix2Route;
+  typedef std::unordered_map<VrfAndIP,
+          opennsl_l3_host_t, VrfAndIPHash> VrfAndIP2Host;
+  typedef std::unordered_map<VrfAndPrefix, opennsl_l3_route_t,
+          VrfAndPrefixHash> VrfAndPrefix2Route;
   typedef boost::container::flat_map<EgressIds, EcmpEgress> EgressIds2Ecmp;
   using VrfAndIP2Route =
-      boost::container::flat_map<VrfAndIP, opennsl_l3_route_t>;
+      std::unordered_map<VrfAndIP, opennsl_l3_route_t, VrfAndIPHash>;
   using EgressAndBool = std::pair<Egress, bool>;
   using EgressId2EgressAndBool =
-      boost::container::flat_map<EgressId, EgressAndBool>;
+      std::unordered_map<EgressId, EgressAndBool>;
 
   /*
    * Callbacks for traversing entries in BCM h/w tables
@@ -206,7 +224,10 @@ class BcmWarmBootCache {
     return egressId2EgressAndBool_.end();
   }
   EgressId2EgressAndBoolCitr findEgress(EgressId id) const {
-    return egressId2EgressAndBool_.find(id);
+    auto citr = egressId2EgressAndBool_.find(id);
+    countLookup(citr != egressId2EgressAndBool_.end(),
+        &egressCacheHits_, &egressCacheMisses_);
+    return citr;
   }
   EgressId2EgressAndBoolCitr findEgress(opennsl_vrf_t vrf,
                                         const folly::IPAddress& nhopIp) const {
@@ -230,7 +251,10 @@ class BcmWarmBootCache {
   VrfAndIP2HostCitr vrfAndIP2Host_end() const { return vrfIp2Host_.end(); }
   VrfAndIP2HostCitr findHost(opennsl_vrf_t vrf,
       const folly::IPAddress& ip) const {
-    return vrfIp2Host_.find(VrfAndIP(vrf, ip));
+    auto citr = vrfIp2Host_.find(VrfAndIP(vrf, ip));
+    countLookup(citr != vrfIp2Host_.end(),
+        &hostCacheHits_, &hostCacheMisses_);
+    return citr;
   }
   void programmed(VrfAndIP2HostCitr vrhitr) {
     VLOG(1) << "Programmed host for vrf : " << vrhitr->first.first << " ip : "
@@ -252,12 +276,13 @@ class BcmWarmBootCache {
     using folly::IPAddress;
     using folly::IPAddressV4;
     using folly::IPAddressV6;
-    if (ip.isV6()) {
-      return vrfPrefix2Route_.find(VrfAndPrefix(vrf, ip,
-            IPAddress(IPAddressV6(IPAddressV6::fetchMask(mask)))));
-    }
-    return vrfPrefix2Route_.find(VrfAndPrefix(vrf, ip,
-       IPAddress(IPAddressV4(IPAddressV4::fetchMask(mask)))));
+    auto maskAddr = ip.isV6() ?
+      IPAddress(IPAddressV6(IPAddressV6::fetchMask(mask))) :
+      IPAddress(IPAddressV4(IPAddressV4::fetchMask(mask)));
+    auto citr = vrfPrefix2Route_.find(VrfAndPrefix(vrf, ip, maskAddr));
+    countLookup(citr != vrfPrefix2Route_.end(),
+        &routeCacheHits_, &routeCacheMisses_);
+    return citr;
   }
   void programmed(VrfAndPfx2RouteCitr vrpitr) {
     VLOG(1) << "Programmed route in vrf : " << std::get<0>(vrpitr->first)
@@ -278,7 +303,10 @@ class BcmWarmBootCache {
   }
   VrfAndIP2RouteCitr findHostRouteFromRouteTable(
       opennsl_vrf_t vrf, const folly::IPAddress& ip) const {
-    return vrfAndIP2Route_.find(VrfAndIP(vrf, ip));
+    auto citr = vrfAndIP2Route_.find(VrfAndIP(vrf, ip));
+    countLookup(citr != vrfAndIP2Route_.end(),
+        &routeCacheHits_, &routeCacheMisses_);
+    return citr;
   }
   void programmed(VrfAndIP2RouteCitr citr) {
     VLOG(1) << "Programmed host route, removing from warm boot cache. "
@@ -333,6 +361,13 @@ class BcmWarmBootCache {
    */
   const EgressIds& getPathsForEcmp(EgressId ecmp) const;
   void populateStateFromWarmbootFile();
+  static void countLookup(bool hit, uint64_t* hits, uint64_t* misses) {
+    ++(hit ? *hits : *misses);
+  }
+  // Publish the hit/miss counters below to fb303 so we can verify from
+  // monitoring that a warm boot reused HW entries rather than
+  // reprogramming them.
+  void publishCacheCounters() const;
   // No copy or assignment.
   BcmWarmBootCache(const BcmWarmBootCache&) = delete;
   BcmWarmBootCache& operator=(const BcmWarmBootCache&) = delete;
@@ -387,5 +422,13 @@ class BcmWarmBootCache {
   // So don't look for egressIds in this table.
   bool hwSwitchEcmp2EgressIdsPopulated_{false};
   std::unique_ptr<SwitchState> dumpedSwSwitchState_;
+  // Hit/miss counts for the route, host and egress indexes. Mutable since
+  // lookups through the const find functions update them.
+  mutable uint64_t routeCacheHits_{0};
+  mutable uint64_t routeCacheMisses_{0};
+  mutable uint64_t hostCacheHits_{0};
+  mutable uint64_t hostCacheMisses_{0};
+  mutable uint64_t egressCacheHits_{0};
+  mutable uint64_t egressCacheMisses_{0};
 };
 }} // facebook::fboss
@@ -6,6 +6,7 @@
 
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
 
 #include <glog/logging.h>
 
@@ -13,12 +14,27 @@ using std::string;
 
 DEFINE_bool(can_warm_boot, true,
             "Enable/disable warm boot functionality");
+DECLARE_string(switch_state_file);
 
 namespace {
 constexpr auto wbFlagPrefix = "can_warm_boot_";
 constexpr auto wbDataPrefix = "bcm_sdk_state_";
 constexpr auto forceColdBootPrefix = "cold_boot_once_";
 
+/*
+ * Ask the kernel to start reading the given file into the page cache.
+ * Returns immediately; errors are ignored since this is purely an
+ * optimization and the real read will report any problem.
+ */
+void prefetchFile(const string& filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+  close(fd);
+}
+
 /*
  * Remove the given file. Return true if file exists and
  * we were able to remove it, false otherwise
@@ -61,6 +77,17 @@ BcmWarmBootHelper::BcmWarmBootHelper(int unit, std::string warmBootDir)
     auto bootType = canWarmBoot_ ? "WARM" : "COLD";
     VLOG(1) << "Will attempt " << bootType << " boot";
 
+    if (canWarmBoot_) {
+      // Kick off readahead of both warm boot files now, so the SDK
+      // state and the switch state snapshot are largely in the page
+      // cache by the time they get parsed during init. The win shows
+      // up in the existing fboss.ctrl.hw_initialized publish, which
+      // brackets the whole warm boot read path.
+      prefetchFile(warmBootDataPath());
+      prefetchFile(
+          folly::to<string>(warmBootDir_, "/", FLAGS_switch_state_file));
+    }
+
     setupWarmBootFile();
   }
 }
@@ -0,0 +1,338 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/hw/bcm/MultiBcmSwitch.h"
+
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/hw/bcm/BcmAPI.h"
+#include "fboss/agent/hw/bcm/BcmPortTable.h"
+#include "fboss/agent/hw/bcm/BcmSwitch.h"
+#include "fboss/agent/hw/bcm/BcmUnit.h"
+#include "fboss/agent/state/Port.h"
+#include "fboss/agent/state/PortMap.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+
+#include <folly/Conv.h>
+#include <folly/dynamic.h>
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+using std::shared_ptr;
+using std::unique_ptr;
+
+namespace facebook { namespace fboss {
+
+MultiBcmSwitch::MultiBcmSwitch(BcmPlatform* platform)
+    : platform_(platform) {
+  // Allocate the units up front, from this (the main) thread: the SDK
+  // does not lock around device ID allocation.
+  auto numSwitches = BcmAPI::getNumSwitches();
+  CHECK_GT(numSwitches, 0);
+  members_.reserve(numSwitches);
+  for (size_t idx = 0; idx < numSwitches; ++idx) {
+    members_.push_back(std::make_unique<BcmSwitch>(
+        platform, BcmAPI::initUnit(idx)));
+  }
+  LOG(INFO) << "MultiBcmSwitch managing " << members_.size() << " units";
+}
+
+MultiBcmSwitch::~MultiBcmSwitch() {
+}
+
+template <typename Fn>
+void MultiBcmSwitch::runOnAllMembers(const Fn& fn) const {
+  std::vector<std::thread> threads;
+  std::vector<std::exception_ptr> errors(members_.size());
+  threads.reserve(members_.size());
+  for (size_t idx = 0; idx < members_.size(); ++idx) {
+    threads.emplace_back([&, idx] {
+      try {
+        fn(members_[idx].get(), idx);
+      } catch (...) {
+        errors[idx] = std::current_exception();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+HwInitResult MultiBcmSwitch::init(Callback* callback) {
+  std::vector<HwInitResult> results(members_.size());
+  // Attach every unit on its own thread: warm boot cost becomes the
+  // slowest unit instead of the sum over units.
+  runOnAllMembers([&](BcmSwitch* member, size_t idx) {
+    results[idx] = member->init(callback);
+  });
+
+  HwInitResult ret;
+  ret.bootType = BootType::WARM_BOOT;
+  for (const auto& result : results) {
+    // A mixed boot (one unit lost its warm boot state) must be treated
+    // as a cold boot: SwSwitch would otherwise skip the initial config
+    // programming the cold-booted unit needs.
+    if (result.bootType != BootType::WARM_BOOT) {
+      ret.bootType = BootType::COLD_BOOT;
+    }
+    ret.initializedTime = std::max(ret.initializedTime,
+                                   result.initializedTime);
+    ret.bootTime = std::max(ret.bootTime, result.bootTime);
+  }
+
+  // Merge the per-unit states: the union of the port maps, and VLANs
+  // merged by ID with their member port sets combined. Interfaces and
+  // routes are mirrored on every unit, so the first member's copy
+  // already describes them all.
+  auto merged = results[0].switchState->clone();
+  auto mergedPorts = merged->getPorts()->clone();
+  auto mergedVlans = merged->getVlans()->clone();
+  for (size_t idx = 1; idx < results.size(); ++idx) {
+    const auto& state = results[idx].switchState;
+    for (const auto& port : *state->getPorts()) {
+      if (mergedPorts->getPortIf(port->getID())) {
+        throw FbossError("port ", port->getID(), " is claimed by more "
+                         "than one unit; the platform must assign "
+                         "globally unique port IDs");
+      }
+      mergedPorts->addPort(port);
+    }
+    for (const auto& vlan : *state->getVlans()) {
+      auto existing = mergedVlans->getVlanIf(vlan->getID());
+      if (!existing) {
+        mergedVlans->addVlan(vlan);
+        continue;
+      }
+      auto combined = existing->clone();
+      auto memberPorts = combined->getPorts();
+      for (const auto& portInfo : vlan->getPorts()) {
+        memberPorts.insert(portInfo);
+      }
+      combined->setPorts(std::move(memberPorts));
+      mergedVlans->updateVlan(std::move(combined));
+    }
+  }
+  merged->resetPorts(std::move(mergedPorts));
+  merged->resetVlans(std::move(mergedVlans));
+  ret.switchState = std::move(merged);
+  return ret;
+}
+
+BcmSwitch* MultiBcmSwitch::memberForPort(PortID port) const {
+  for (const auto& member : members_) {
+    if (member->getPortTable()->getBcmPortIf(port)) {
+      return member.get();
+    }
+  }
+  return nullptr;
+}
+
+shared_ptr<SwitchState> MultiBcmSwitch::filterStateForMember(
+    const shared_ptr<SwitchState>& state, const BcmSwitch* member) const {
+  auto ports = std::make_shared<PortMap>();
+  for (const auto& port : *state->getPorts()) {
+    if (member->getPortTable()->getBcmPortIf(port->getID())) {
+      ports->addPort(port);
+    }
+  }
+  auto filtered = state->clone();
+  filtered->resetPorts(std::move(ports));
+  return filtered;
+}
+
+void MultiBcmSwitch::stateChanged(const StateDelta& delta) {
+  // Each unit programs its filtered delta on its own thread: the port
+  // changes it owns, plus the mirrored VLAN/interface/route/neighbor
+  // changes. Unchanged nodes are shared between the filtered states,
+  // so the member deltas only walk what actually changed.
+  runOnAllMembers([&](BcmSwitch* member, size_t /*idx*/) {
+    StateDelta memberDelta(filterStateForMember(delta.oldState(), member),
+                           filterStateForMember(delta.newState(), member));
+    member->stateChanged(memberDelta);
+  });
+}
+
+bool MultiBcmSwitch::isValidStateUpdate(const StateDelta& delta) const {
+  for (const auto& member : members_) {
+    StateDelta memberDelta(
+        filterStateForMember(delta.oldState(), member.get()),
+        filterStateForMember(delta.newState(), member.get()));
+    if (!member->isValidStateUpdate(memberDelta)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+unique_ptr<TxPacket> MultiBcmSwitch::allocatePacket(uint32_t size) {
+  // The first member's unit carries the CPU path; its packets can be
+  // sent out of any member's ports because tx by port is routed below.
+  return members_.front()->allocatePacket(size);
+}
+
+bool MultiBcmSwitch::sendPacketSwitched(unique_ptr<TxPacket> pkt) noexcept {
+  return members_.front()->sendPacketSwitched(std::move(pkt));
+}
+
+bool MultiBcmSwitch::sendPacketOutOfPort(unique_ptr<TxPacket> pkt,
+                                         PortID portID) noexcept {
+  auto* member = memberForPort(portID);
+  if (!member) {
+    LOG(ERROR) << "dropping packet tx on port " << portID
+      << ": no unit owns the port";
+    return false;
+  }
+  return member->sendPacketOutOfPort(std::move(pkt), portID);
+}
+
+void MultiBcmSwitch::updateStats(SwitchStats* switchStats) {
+  for (const auto& member : members_) {
+    member->updateStats(switchStats);
+  }
+}
+
+int MultiBcmSwitch::getHighresSamplers(
+    HighresSamplerList* samplers,
+    const std::string& namespaceString,
+    const std::set<CounterRequest>& counterSet) {
+  int numCounters = 0;
+  for (const auto& member : members_) {
+    numCounters += member->getHighresSamplers(samplers, namespaceString,
+                                              counterSet);
+  }
+  return numCounters;
+}
+
+void MultiBcmSwitch::fetchL2Table(std::vector<L2EntryThrift>* l2Table) {
+  for (const auto& member : members_) {
+    std::vector<L2EntryThrift> unitTable;
+    member->fetchL2Table(&unitTable);
+    l2Table->insert(l2Table->end(),
+                    std::make_move_iterator(unitTable.begin()),
+                    std::make_move_iterator(unitTable.end()));
+  }
+}
+
+void MultiBcmSwitch::gracefulExit(folly::dynamic& switchState) {
+  // Detach every unit on its own thread, mirroring init(). Each
+  // unit's hw state lands under its own key; the platform must point
+  // each unit at its own SDK warm boot state file (onUnitAttach() is
+  // where the per-unit paths get set up).
+  std::vector<folly::dynamic> unitStates(members_.size(),
+                                         folly::dynamic::object);
+  runOnAllMembers([&](BcmSwitch* member, size_t idx) {
+    member->gracefulExit(unitStates[idx]);
+  });
+  for (size_t idx = 0; idx < unitStates.size(); ++idx) {
+    switchState[folly::to<std::string>("unit", idx)] =
+      std::move(unitStates[idx]);
+  }
+}
+
+folly::dynamic MultiBcmSwitch::toFollyDynamic() const {
+  folly::dynamic units = folly::dynamic::object;
+  for (size_t idx = 0; idx < members_.size(); ++idx) {
+    units[folly::to<std::string>("unit", idx)] =
+      members_[idx]->toFollyDynamic();
+  }
+  return units;
+}
+
+void MultiBcmSwitch::unregisterCallbacks() {
+  for (const auto& member : members_) {
+    member->unregisterCallbacks();
+  }
+}
+
+void MultiBcmSwitch::remedyPorts() {
+  for (const auto& member : members_) {
+    member->remedyPorts();
+  }
+}
+
+void MultiBcmSwitch::initialConfigApplied() {
+  for (const auto& member : members_) {
+    member->initialConfigApplied();
+  }
+}
+
+void MultiBcmSwitch::clearWarmBootCache() {
+  for (const auto& member : members_) {
+    member->clearWarmBootCache();
+  }
+}
+
+void MultiBcmSwitch::exitFatal() const {
+  for (const auto& member : members_) {
+    member->exitFatal();
+  }
+}
+
+bool MultiBcmSwitch::isPortUp(PortID port) const {
+  auto* member = memberForPort(port);
+  if (!member) {
+    throw FbossError("no unit owns port ", port);
+  }
+  return member->isPortUp(port);
+}
+
+cfg::PortSpeed MultiBcmSwitch::getPortSpeed(PortID port) const {
+  auto* member = memberForPort(port);
+  if (!member) {
+    throw FbossError("no unit owns port ", port);
+  }
+  return member->getPortSpeed(port);
+}
+
+cfg::PortSpeed MultiBcmSwitch::getMaxPortSpeed(PortID port) const {
+  auto* member = memberForPort(port);
+  if (!member) {
+    throw FbossError("no unit owns port ", port);
+  }
+  return member->getMaxPortSpeed(port);
+}
+
+bool MultiBcmSwitch::getAndClearNeighborHit(RouterID vrf,
+                                            folly::IPAddress& ip) {
+  // Ask (and clear) every unit; the entry is hit if any unit saw
+  // traffic use it.
+  bool hit = false;
+  for (const auto& member : members_) {
+    hit |= member->getAndClearNeighborHit(vrf, ip);
+  }
+  return hit;
+}
+
+void MultiBcmSwitch::getPacketTrace(PortID port, folly::StringPiece data,
+                                    PacketTraceInfo* info) {
+  auto* member = memberForPort(port);
+  if (!member) {
+    throw FbossError("no unit owns port ", port);
+  }
+  member->getPacketTrace(port, data, info);
+}
+
+void MultiBcmSwitch::getHwTableUsage(
+    std::vector<HwTableUsage>& usage) const {
+  for (const auto& member : members_) {
+    member->getHwTableUsage(usage);
+  }
+}
+
+}} // facebook::fboss
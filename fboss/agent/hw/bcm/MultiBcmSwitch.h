@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/agent/HwSwitch.h"
+#include "fboss/agent/types.h"
+
+#include <memory>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+class BcmPlatform;
+class BcmSwitch;
+class StateDelta;
+
+/*
+ * A HwSwitch facade for platforms with more than one Broadcom ASIC.
+ *
+ * SwSwitch keeps talking to a single HwSwitch; this class owns one
+ * BcmSwitch member per ASIC and coordinates them:
+ *
+ *  - init() attaches every unit on its own thread, so warm boot cost
+ *    is the slowest unit rather than the sum of all of them. The
+ *    per-member init results are merged into one SwitchState; the
+ *    boot is only reported as a warm boot if every unit warm booted.
+ *  - stateChanged() builds a per-member delta whose port map is
+ *    filtered to the ports that member's unit owns, and applies the
+ *    member deltas on parallel programming threads, so programming
+ *    throughput scales with ASIC count. VLANs, interfaces, routes and
+ *    neighbors are mirrored to every unit: each ASIC carries the full
+ *    FIB and forwards for the ports attached to it.
+ *  - Packet tx by port is routed to the owning member; switched tx
+ *    and packet allocation go through the first member, whose unit is
+ *    assumed to carry the CPU path.
+ *
+ * Port ownership comes from which member's port table claims the
+ * PortID, so the platform must assign globally unique port IDs across
+ * units (BcmPlatform::initPorts() decides the numbering).
+ *
+ * Known gap: an ECMP group whose next hops resolve over ports on
+ * different units is programmed on every unit with its full next hop
+ * set, but egress over another unit's ports depends on how the
+ * platform cross-connects the units; making that spill traffic flow
+ * through inter-unit links is the coordination work this facade still
+ * leaves to the platform.
+ */
+class MultiBcmSwitch : public HwSwitch {
+ public:
+  /*
+   * BcmAPI::init() must have been called; one member BcmSwitch is
+   * created per device the SDK probed.
+   */
+  explicit MultiBcmSwitch(BcmPlatform* platform);
+  ~MultiBcmSwitch() override;
+
+  HwInitResult init(Callback* callback) override;
+  void unregisterCallbacks() override;
+  void remedyPorts() override;
+  void stateChanged(const StateDelta& delta) override;
+  bool isValidStateUpdate(const StateDelta& delta) const override;
+  std::unique_ptr<TxPacket> allocatePacket(uint32_t size) override;
+  bool sendPacketSwitched(std::unique_ptr<TxPacket> pkt) noexcept override;
+  bool sendPacketOutOfPort(std::unique_ptr<TxPacket> pkt,
+                           PortID portID) noexcept override;
+  void updateStats(SwitchStats* switchStats) override;
+  int getHighresSamplers(HighresSamplerList* samplers,
+                         const std::string& namespaceString,
+                         const std::set<CounterRequest>& counterSet) override;
+  void fetchL2Table(std::vector<L2EntryThrift>* l2Table) override;
+  void gracefulExit(folly::dynamic& switchState) override;
+  folly::dynamic toFollyDynamic() const override;
+  void initialConfigApplied() override;
+  void clearWarmBootCache() override;
+  void exitFatal() const override;
+  bool isPortUp(PortID port) const override;
+  cfg::PortSpeed getPortSpeed(PortID port) const override;
+  cfg::PortSpeed getMaxPortSpeed(PortID port) const override;
+  bool getAndClearNeighborHit(RouterID vrf, folly::IPAddress& ip) override;
+  void getPacketTrace(PortID port, folly::StringPiece data,
+                      PacketTraceInfo* info) override;
+  void getHwTableUsage(std::vector<HwTableUsage>& usage) const override;
+
+  size_t numUnits() const {
+    return members_.size();
+  }
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  MultiBcmSwitch(MultiBcmSwitch const &) = delete;
+  MultiBcmSwitch& operator=(MultiBcmSwitch const &) = delete;
+
+  /*
+   * The member whose unit owns this port, or null if no member's port
+   * table claims it (e.g. before init).
+   */
+  BcmSwitch* memberForPort(PortID port) const;
+
+  /*
+   * Build the state the given member should see: the full state with
+   * the port map filtered down to the member's own ports. Applied to
+   * both ends of a delta this partitions port changes by ownership
+   * while mirroring everything else.
+   */
+  std::shared_ptr<SwitchState> filterStateForMember(
+      const std::shared_ptr<SwitchState>& state,
+      const BcmSwitch* member) const;
+
+  /*
+   * Run fn(member) for every member on its own thread and rethrow the
+   * first exception once all threads have joined.
+   */
+  template <typename Fn>
+  void runOnAllMembers(const Fn& fn) const;
+
+  BcmPlatform* platform_{nullptr};
+  std::vector<std::unique_ptr<BcmSwitch>> members_;
+};
+
+}} // facebook::fboss
@@ -15,15 +15,22 @@ extern "C" {
 }
 
 #include <folly/dynamic.h>
+#include <folly/small_vector.h>
 #include "fboss/agent/state/NodeBase.h"
 #include "fboss/agent/state/NodeMap.h"
 
-#include <boost/container/flat_set.hpp>
+#include <algorithm>
 
 namespace facebook { namespace fboss {
 
 struct PortAndEgressIdsFields {
-  typedef boost::container::flat_set<opennsl_if_t> EgressIds;
+  /*
+   * Sorted vector of egress IDs with inline storage. Most ports carry
+   * only a handful of egresses, so the common case needs no heap
+   * allocation; larger sets spill to the heap. Kept sorted and unique
+   * by PortAndEgressIds::addEgressId()/removeEgressId().
+   */
+  typedef folly::small_vector<opennsl_if_t, 8> EgressIds;
   PortAndEgressIdsFields(opennsl_if_t port, EgressIds egressIds) :
     id(port), egressIds(std::move(egressIds)) {}
 
@@ -59,11 +66,19 @@ class PortAndEgressIds: public NodeBaseT<PortAndEgressIds,
   }
 
   void addEgressId(opennsl_if_t egressId) {
-    writableFields()->egressIds.insert(egressId);
+    auto& egressIds = writableFields()->egressIds;
+    auto itr = std::lower_bound(egressIds.begin(), egressIds.end(), egressId);
+    if (itr == egressIds.end() || *itr != egressId) {
+      egressIds.insert(itr, egressId);
+    }
   }
 
   void removeEgressId(opennsl_if_t egressId) {
-    writableFields()->egressIds.erase(egressId);
+    auto& egressIds = writableFields()->egressIds;
+    auto itr = std::lower_bound(egressIds.begin(), egressIds.end(), egressId);
+    if (itr != egressIds.end() && *itr == egressId) {
+      egressIds.erase(itr);
+    }
   }
 
   folly::dynamic toFollyDynamic() const override {
@@ -87,7 +102,12 @@ typedef NodeMapTraits<opennsl_if_t, PortAndEgressIds>
 PortAndEgressIdsMapTraits;
 /*
  * Container for maintaining mapping from port to
- * egressIds
+ * egressIds.
+ *
+ * clone() shares the immutable per-port entries with the original;
+ * callers clone and replace only the entries for the ports they
+ * actually change, so updating one port never copies the egress ID
+ * storage of the others.
  */
 class PortAndEgressIdsMap: public NodeMapT<PortAndEgressIdsMap,
   PortAndEgressIdsMapTraits> {
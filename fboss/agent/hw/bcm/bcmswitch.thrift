@@ -39,4 +39,8 @@ struct BcmHwTableStats {
   22: i32 lpm_slots_max = STAT_UNINITIALIZED
   23: i32 lpm_slots_used = STAT_UNINITIALIZED
   24: i32 lpm_slots_free = STAT_UNINITIALIZED
+
+  // ACL
+  25: i32 acl_entries_used = STAT_UNINITIALIZED
+  26: i32 acl_ranges_used = STAT_UNINITIALIZED
 }
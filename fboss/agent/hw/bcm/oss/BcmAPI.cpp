@@ -20,12 +20,21 @@ namespace facebook { namespace fboss {
 
 std::atomic<BcmUnit*> bcmUnits[NUM_UNITS];
 
+namespace {
+// Keep the config we were initialized with around so that it can be
+// queried (and dumped for warm boot compatibility checks) later on.
+BcmAPI::HwConfigMap hwConfig;
+}
+
 /*
  * Initialize the Broadcom SDK and create the BcmAPI singleton.
  *
  * This must be called before using any other Broadcom SDK functions.
  */
 void BcmAPI::initImpl(const std::map<std::string, std::string>& config){
+  for (const auto& kv : config) {
+    hwConfig.emplace(kv.first, kv.second);
+  }
 }
 
 /*
@@ -53,6 +62,6 @@ std::string BcmAPI::getThreadName() {
  * Get hw config
  */
 BcmAPI::HwConfigMap BcmAPI::getHwConfig() {
-  return HwConfigMap();
+  return hwConfig;
 }
 }}
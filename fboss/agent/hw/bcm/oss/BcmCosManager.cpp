@@ -0,0 +1,39 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/hw/bcm/BcmCosManager.h"
+
+#include <glog/logging.h>
+
+namespace facebook { namespace fboss {
+
+void BcmCosManager::setReasonMapping(int queue, cfg::PacketRxReason reason) {
+  // API not available in opennsl
+  VLOG(2) << "cannot map rx reason " << static_cast<int>(reason)
+          << " to CPU queue " << queue << ": API not available in opennsl";
+}
+
+void BcmCosManager::setQueueRate(int queue, int pps) {
+  // API not available in opennsl
+  VLOG(2) << "cannot rate limit CPU queue " << queue << " to " << pps
+          << " pps: API not available in opennsl";
+}
+
+void BcmCosManager::setSchedulerWeights(const std::vector<int>& weights) {
+  // API not available in opennsl
+  VLOG(2) << "cannot program CPU queue scheduler weights: "
+          << "API not available in opennsl";
+}
+
+uint64_t BcmCosManager::getQueueDroppedPackets(int queue) {
+  // API not available in opennsl
+  return 0;
+}
+
+}} // facebook::fboss
@@ -9,15 +9,135 @@
  */
 #include "fboss/agent/hw/bcm/BcmTableStats.h"
 
+#include "common/stats/ServiceData.h"
+#include "fboss/agent/hw/bcm/BcmAclTable.h"
+#include "fboss/agent/hw/bcm/BcmError.h"
+#include "fboss/agent/hw/bcm/BcmHost.h"
+#include "fboss/agent/hw/bcm/BcmSwitch.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+extern "C" {
+#include <opennsl/l3.h>
+}
+
 namespace facebook { namespace fboss {
 
-bool BcmTableStats::refreshHwStatusStats() {
-  return false;
+bool BcmTableStats::refreshHwStatusStats(BcmHwTableStats* stats) {
+  opennsl_l3_info_t l3Info;
+  opennsl_l3_info_t_init(&l3Info);
+  auto rv = opennsl_l3_info(hw_->getUnit(), &l3Info);
+  if (OPENNSL_FAILURE(rv)) {
+    LOG(ERROR) << "Unable to get L3 hw info, host table stats will be stale";
+    return false;
+  }
+  stats->l3_host_max = std::max(0, l3Info.l3info_max_host);
+  stats->l3_host_used = std::max(0, l3Info.l3info_used_host);
+  stats->l3_host_free = std::max(0, stats->l3_host_max - stats->l3_host_used);
+  // OpenNSL does not expose the ECMP group capacity, so report the
+  // number of groups we have programmed and leave max/free unknown.
+  stats->l3_ecmp_groups_used = hw_->getHostTable()->numEcmpEgress();
+  return true;
+}
+
+bool BcmTableStats::refreshLPMStats(BcmHwTableStats* stats) {
+  // The per-family partition sizes of the LPM table aren't visible
+  // through OpenNSL, but the aggregate route table occupancy is.
+  opennsl_l3_info_t l3Info;
+  opennsl_l3_info_t_init(&l3Info);
+  auto rv = opennsl_l3_info(hw_->getUnit(), &l3Info);
+  if (OPENNSL_FAILURE(rv)) {
+    LOG(ERROR) << "Unable to get L3 hw info, LPM table stats will be stale";
+    return false;
+  }
+  stats->lpm_slots_max = std::max(0, l3Info.l3info_max_route);
+  stats->lpm_slots_used = std::max(0, l3Info.l3info_used_route);
+  stats->lpm_slots_free =
+      std::max(0, stats->lpm_slots_max - stats->lpm_slots_used);
+  return true;
 }
 
-bool BcmTableStats::refreshLPMStats() {
-  return false;
+void BcmTableStats::refreshAclStats(BcmHwTableStats* stats) {
+  auto aclTable = hw_->getAclTable();
+  stats->acl_entries_used = aclTable->getAclEntryCount();
+  stats->acl_ranges_used = aclTable->getAclRangeCount();
 }
 
-void BcmTableStats::publish() const {}
+void BcmTableStats::refresh() {
+  BcmHwTableStats stats;
+  stats.hw_table_stats_stale =
+      !(refreshHwStatusStats(&stats) && refreshLPMStats(&stats));
+  refreshAclStats(&stats);
+
+  std::lock_guard<std::mutex> g(lock_);
+  stats_ = stats;
+  // Uninitialized counters are -1, so max() leaves a high-water mark
+  // untouched until its table reports real numbers.
+  auto noteHighWater = [](int32_t& highWater, int32_t used) {
+    highWater = std::max(highWater, used);
+  };
+  noteHighWater(highWater_.l3_host_used, stats.l3_host_used);
+  noteHighWater(highWater_.l3_ecmp_groups_used, stats.l3_ecmp_groups_used);
+  noteHighWater(highWater_.lpm_slots_used, stats.lpm_slots_used);
+  noteHighWater(highWater_.acl_entries_used, stats.acl_entries_used);
+  noteHighWater(highWater_.acl_ranges_used, stats.acl_ranges_used);
+}
+
+void BcmTableStats::publish() const {
+  BcmHwTableStats stats;
+  BcmHwTableStats highWater;
+  {
+    std::lock_guard<std::mutex> g(lock_);
+    stats = stats_;
+    highWater = highWater_;
+  }
+  fbData->setCounter("hw_table_stats_stale",
+                     stats.hw_table_stats_stale ? 1 : 0);
+  fbData->setCounter("l3_host_max", stats.l3_host_max);
+  fbData->setCounter("l3_host_used", stats.l3_host_used);
+  fbData->setCounter("l3_host_free", stats.l3_host_free);
+  fbData->setCounter("l3_ecmp_groups_used", stats.l3_ecmp_groups_used);
+  fbData->setCounter("lpm_slots_max", stats.lpm_slots_max);
+  fbData->setCounter("lpm_slots_used", stats.lpm_slots_used);
+  fbData->setCounter("lpm_slots_free", stats.lpm_slots_free);
+  fbData->setCounter("acl_entries_used", stats.acl_entries_used);
+  fbData->setCounter("acl_ranges_used", stats.acl_ranges_used);
+  fbData->setCounter("l3_host_used.high_water", highWater.l3_host_used);
+  fbData->setCounter("l3_ecmp_groups_used.high_water",
+                     highWater.l3_ecmp_groups_used);
+  fbData->setCounter("lpm_slots_used.high_water", highWater.lpm_slots_used);
+  fbData->setCounter("acl_entries_used.high_water",
+                     highWater.acl_entries_used);
+}
+
+void BcmTableStats::appendUsage(std::vector<HwTableUsage>* usage,
+                                folly::StringPiece table,
+                                int32_t used,
+                                int32_t max,
+                                int32_t highWater) {
+  HwTableUsage entry;
+  entry.table = table.str();
+  entry.used = used;
+  entry.maxEntries = max;
+  // Headroom is unknown (-1) unless both occupancy and capacity are known.
+  entry.free = (max < 0 || used < 0) ? -1 : std::max(0, max - used);
+  entry.highWater = highWater;
+  usage->push_back(std::move(entry));
+}
+
+void BcmTableStats::fillTableUsage(std::vector<HwTableUsage>* usage) const {
+  std::lock_guard<std::mutex> g(lock_);
+  appendUsage(usage, "l3_host", stats_.l3_host_used, stats_.l3_host_max,
+              highWater_.l3_host_used);
+  appendUsage(usage, "l3_ecmp_groups", stats_.l3_ecmp_groups_used,
+              stats_.l3_ecmp_groups_max, highWater_.l3_ecmp_groups_used);
+  appendUsage(usage, "lpm", stats_.lpm_slots_used, stats_.lpm_slots_max,
+              highWater_.lpm_slots_used);
+  appendUsage(usage, "acl_entries", stats_.acl_entries_used, -1,
+              highWater_.acl_entries_used);
+  appendUsage(usage, "acl_ranges", stats_.acl_ranges_used, -1,
+              highWater_.acl_ranges_used);
+}
 }}
@@ -9,10 +9,22 @@
  */
 #include "fboss/agent/hw/bcm/BcmUnit.h"
 
+#include "fboss/agent/SysError.h"
 #include "fboss/agent/hw/bcm/BcmAPI.h"
 #include "fboss/agent/hw/bcm/BcmError.h"
 #include "fboss/agent/hw/bcm/BcmWarmBootHelper.h"
 
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/json.h>
+
+#include <chrono>
+#include <exception>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
 extern "C" {
 #include <opennsl/init.h>
 #include <opennsl/switch.h>
@@ -27,6 +39,34 @@ namespace facebook { namespace fboss {
 namespace {
 constexpr auto wbEnvVar = "SOC_BOOT_FLAGS";
 constexpr auto wbFlag = "0x200000";
+
+/*
+ * Write the agent switch state snapshot.  Serialize to unformatted
+ * JSON: with a full FIB the pretty printer dominates the serialization
+ * time and inflates the file, and the snapshot is only ever read back
+ * by the agent.  Flush with a single fdatasync() at the end, instead of
+ * paying a synchronous flush per write.
+ */
+void writeSwitchState(const std::string& switchStateFile,
+                      const folly::dynamic& switchState) {
+  auto start = std::chrono::steady_clock::now();
+  folly::File file(switchStateFile.c_str(),
+                   O_WRONLY | O_CREAT | O_TRUNC,
+                   S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  auto json = folly::toJson(switchState);
+  auto written = folly::writeFull(file.fd(), json.data(), json.size());
+  if (written < 0 || static_cast<size_t>(written) != json.size()) {
+    throw SysError(errno, "error writing switch state to ", switchStateFile);
+  }
+  if (fdatasync(file.fd()) != 0) {
+    throw SysError(errno, "error syncing switch state file ", switchStateFile);
+  }
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start).count();
+  VLOG(1) << "wrote warm boot switch state to " << switchStateFile
+          << " in " << ms << " ms";
+}
+
 }
 
 
@@ -50,9 +90,29 @@ void BcmUnit::detach(const std::string& switchStateFile,
     folly::dynamic& switchState) {
   attached_.store(false, std::memory_order_release);
 
+  // The SDK state dump done by _opennsl_shutdown() and the agent state
+  // snapshot are independent, and together they bound the restart
+  // traffic loss window.  Write the snapshot on a separate thread so
+  // the two overlap instead of running back to back.
+  std::exception_ptr writeError;
+  std::thread stateWriter([&] {
+    try {
+      writeSwitchState(switchStateFile, switchState);
+    } catch (...) {
+      writeError = std::current_exception();
+    }
+  });
+
   // Clean up SDK state, without touching the hardware
   auto rv = _opennsl_shutdown(unit_);
+  stateWriter.join();
   bcmCheckError(rv, "failed to clean up BCM state during warm boot shutdown");
+  if (writeError) {
+    // Persisting the agent state failed; rethrow before declaring the
+    // unit warm bootable, so we never leave a warm boot flag pointing
+    // at a stale or missing snapshot.
+    std::rethrow_exception(writeError);
+  }
 
   wbHelper_->setCanWarmBoot();
 }
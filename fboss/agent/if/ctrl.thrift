@@ -10,9 +10,13 @@ include "common/network/if/Address.thrift"
 include "fboss/agent/if/optic.thrift"
 include "fboss/agent/if/highres.thrift"
 include "fboss/qsfp_service/if/transceiver.thrift"
+include "fboss/agent/hw/bcm/packettrace.thrift"
 
 typedef binary (cpp2.type = "::folly::fbstring") fbbinary
 typedef string (cpp2.type = "::folly::fbstring") fbstring
+// IOBuf-backed binary: the handler receives the deserialized payload as
+// an IOBuf chain sharing the request's receive buffers, with no copy.
+typedef binary (cpp2.type = "std::unique_ptr<folly::IOBuf>") fbiobuf
 
 const i32 DEFAULT_CTRL_PORT = 5909
 
@@ -44,6 +48,54 @@ struct RouteDetails {
   5: required bool isConnected,
 }
 
+/*
+ * One chunk of a paged route table dump, see getRouteTableChunk().
+ */
+struct RouteTableChunk {
+  1: required list<UnicastRoute> routes,
+  /*
+   * Opaque cursor to pass to the next getRouteTableChunk() call to
+   * fetch the following chunk. 0 when isLast is set.
+   */
+  2: required i64 cursor,
+  3: required bool isLast,
+}
+
+/*
+ * One page of a prefix-range route details query, see
+ * getRouteTableDetailsRange().
+ */
+struct RouteTableDetailsPage {
+  1: required list<RouteDetails> routes,
+  /*
+   * First prefix in order after this page; pass it as startPrefix to
+   * fetch the next page. Only meaningful when isLast is false.
+   */
+  2: required IpPrefix nextPrefix,
+  3: required bool isLast,
+}
+
+enum NeighborEntryOp {
+  ADD = 1,
+  CHANGE = 2,
+  REMOVE = 3,
+}
+
+/*
+ * One resolved neighbor table transition, see registerForNeighborDeltas().
+ */
+struct NeighborEntryDelta {
+  1: required NeighborEntryOp op,
+  2: required Address.BinaryAddress ip,
+  3: required i32 vlanID,
+  /*
+   * Resolved MAC and port of the entry; for REMOVE these are taken from
+   * the entry that went away.
+   */
+  4: required string mac,
+  5: required i32 port,
+}
+
 struct ArpEntryThrift {
   1: string mac,
   2: i32 port,
@@ -60,6 +112,45 @@ struct L2EntryThrift {
   3: i32 vlanID,
 }
 
+/*
+ * One chunk of a paged L2 table dump, see getL2TableChunk().
+ */
+struct L2TableChunk {
+  1: required list<L2EntryThrift> entries,
+  /*
+   * Opaque cursor to pass to the next getL2TableChunk() call to fetch
+   * the following chunk. 0 when isLast is set.
+   */
+  2: required i64 cursor,
+  3: required bool isLast,
+}
+
+/*
+ * Occupancy of one hardware forwarding table, see getHwTableUsage().
+ */
+struct HwTableUsage {
+  /*
+   * Stable table identifier, e.g. "l3_host", "l3_nexthops",
+   * "l3_ecmp_groups", "acl_entries".
+   */
+  1: required string table,
+  2: required i32 used,
+  /*
+   * Capacity of the table; -1 when the hardware does not report one
+   * (headroom is then unknown).
+   */
+  3: required i32 maxEntries,
+  /*
+   * Headroom estimate: maxEntries - used, or -1 when the capacity is
+   * unknown.
+   */
+  4: required i32 free,
+  /*
+   * Highest occupancy observed since the agent started.
+   */
+  5: required i32 highWater,
+}
+
 struct InterfaceDetail {
   1: string interfaceName,
   2: i32 interfaceId,
@@ -171,6 +262,57 @@ struct PortStatus {
   5: i64 speedMbps,
 }
 
+/*
+ * Sections of switch state that can be requested together in one
+ * snapshot-consistent query, see getStateSnapshot().
+ */
+enum StateSnapshotSection {
+  PORTS = 1,
+  INTERFACES = 2,
+  ARP = 3,
+  NDP = 4,
+  ROUTES = 5,
+}
+
+/*
+ * One chunk of a snapshot-consistent multi-table query, see
+ * getStateSnapshot().
+ */
+struct StateSnapshotChunk {
+  /*
+   * The requested scalar sections; set on the first chunk only.
+   */
+  1: optional map<i32, PortStatus> ports
+  2: optional map<i32, InterfaceDetail> interfaces
+  3: optional list<ArpEntryThrift> arpTable
+  4: optional list<NdpEntryThrift> ndpTable
+  /*
+   * The ROUTES section streams across chunks with the same cursor
+   * rules as getRouteTableChunk(). Empty if ROUTES was not requested.
+   */
+  5: required list<UnicastRoute> routes,
+  6: required i64 cursor,
+  7: required bool isLast,
+}
+
+/*
+ * A filter restricting which packets a capture records.
+ *
+ * Each list is one predicate: a packet matches the predicate if it
+ * matches any entry in the list, and matches the filter if it matches
+ * every non-empty predicate. An empty filter matches all packets.
+ */
+struct CaptureFilter {
+  // Ingress ports (rx packets only; tx packets have no port)
+  1: list<i32> ports
+  2: list<i32> vlans
+  3: list<i32> ethertypes
+  // IPv4 protocol / IPv6 next header values
+  4: list<i32> ipProtocols
+  5: list<IpPrefix> srcPrefixes
+  6: list<IpPrefix> dstPrefixes
+}
+
 struct CaptureInfo {
   // A name identifying the packet capture
   1: string name
@@ -183,6 +325,57 @@ struct CaptureInfo {
    * large number of packets.
    */
   2: i32 maxPackets
+  /*
+   * Only record packets matching this filter. The filter is compiled
+   * once when the capture starts; an empty filter records everything.
+   */
+  3: CaptureFilter filter
+  /*
+   * Stop capturing after recording this many packet bytes (0 for no
+   * byte quota). Like maxPackets, this bounds the resources a capture
+   * can consume; it is enforced on the packet lengths as they are
+   * recorded.
+   */
+  4: i64 maxBytes
+}
+
+/*
+ * One flow aggregated from hardware-sampled packets.
+ *
+ * packets/bytes count the samples seen for the flow, not the flow's
+ * full traffic; multiply by the configured sampling rate to estimate
+ * the actual volume.
+ */
+struct SampledFlow {
+  1: Address.BinaryAddress srcIp
+  2: Address.BinaryAddress dstIp
+  3: i32 ipProtocol
+  // TCP/UDP ports; 0 for other protocols
+  4: i32 srcL4Port
+  5: i32 dstL4Port
+  6: i32 ingressPort
+  7: i32 vlan
+  8: i64 packets
+  9: i64 bytes
+  10: i64 firstSeenMsec
+  11: i64 lastSeenMsec
+}
+
+/*
+ * One state update's trip through the update pipeline: time spent
+ * queued before the update thread ran it, time preparing the new
+ * switch state (the update function plus the rest of its batch), and
+ * time programming the hardware. totalUsec is the end-to-end latency
+ * from updateState() to hardware programming completion.
+ */
+struct ConvergenceTrace {
+  1: string updateName
+  // Wall clock time the update was enqueued, msec since epoch
+  2: i64 enqueuedMsec
+  3: i64 queueUsec
+  4: i64 applyUsec
+  5: i64 hwUsec
+  6: i64 totalUsec
 }
 
 struct RouteUpdateLoggingInfo {
@@ -198,6 +391,21 @@ struct RouteUpdateLoggingInfo {
   3: bool exact
 }
 
+/*
+ * Copy-on-write accounting for one SwitchState node type, from the
+ * NodeCloneProfiler.  Only populated on agents built with
+ * FBOSS_PROFILE_NODE_CLONES.
+ */
+struct NodeCloneStats {
+  1: string nodeType
+  2: i64 clones
+  3: i64 publishes
+  // Node destructions; clones minus destroys is the number of live nodes
+  4: i64 destroys
+  // Bytes allocated by the cloned node objects themselves
+  5: i64 allocatedBytes
+}
+
 /*
  * Information about an LLDP neighbor
  */
@@ -218,6 +426,19 @@ struct LinkNeighborThrift {
   14: optional string portDescription
 }
 
+struct CounterDeltaBatch {
+  // Version of the counter snapshot this batch moves the caller to;
+  // pass it as sinceVersion on the next getCounterDeltas() call.
+  1: required i64 version
+  // When true the packed values are absolute counter values rather
+  // than deltas (first read of a manifest, or the caller's
+  // sinceVersion no longer matched the served base snapshot).
+  2: required bool absolute
+  // One zigzag/varint encoded value per manifest entry, in the order
+  // the manifest was registered.
+  3: required binary values
+}
+
 enum StdClientIds {
   BGPD = 0,
   STATIC_ROUTE = 1,
@@ -253,13 +474,28 @@ service FbossCtrl extends fb303.FacebookService {
   void syncFib(1: i16 clientId, 2: list<UnicastRoute> routes)
     throws (1: fboss.FbossBaseError error)
 
+  /*
+   * Chunked variants of addUnicastRoutes/syncFib for very large route
+   * sets. Callers stream the routes in chunks of whatever size suits
+   * their transport; the agent accumulates them and applies everything
+   * in a single SwitchState update once the chunk with isLast set
+   * arrives. This turns a full-FIB sync into one state transition
+   * instead of one per chunk.
+   */
+  void addUnicastRoutesChunked(1: i16 clientId, 2: list<UnicastRoute> routes,
+      3: bool isLast)
+    throws (1: fboss.FbossBaseError error)
+  void syncFibChunked(1: i16 clientId, 2: list<UnicastRoute> routes,
+      3: bool isLast)
+    throws (1: fboss.FbossBaseError error)
+
   /*
    * Send packets in binary or hex format to controller.
    *
    * This injects the packet into the controller, as if it had been received
    * from a front-panel port.
    */
-  void sendPkt(1: i32 port, 2: i32 vlan, 3: fbbinary data)
+  void sendPkt(1: i32 port, 2: i32 vlan, 3: fbiobuf data)
     throws (1: fboss.FbossBaseError error)
   void sendPktHex(1: i32 port, 2: i32 vlan, 3: fbstring hex)
     throws (1: fboss.FbossBaseError error)
@@ -273,7 +509,17 @@ service FbossCtrl extends fb303.FacebookService {
    * packet actually sent by the hardware, based on the hardware VLAN tagging
    * configuration for this VLAN+port.)
    */
-  void txPkt(1: i32 port, 2: fbbinary data)
+  void txPkt(1: i32 port, 2: fbiobuf data)
+    throws (1: fboss.FbossBaseError error)
+
+  /*
+   * Transmit a batch of packets out a specific front panel port.
+   *
+   * Same semantics as txPkt for each entry, but a single call amortizes
+   * the Thrift round trip and dispatch overhead over the whole batch,
+   * which matters when this API is used for traffic generation.
+   */
+  void txPkts(1: i32 port, 2: list<fbiobuf> packets)
     throws (1: fboss.FbossBaseError error)
 
   /*
@@ -288,7 +534,7 @@ service FbossCtrl extends fb303.FacebookService {
    * packet actually sent by the hardware, based on the hardware VLAN tagging
    * configuration for this VLAN.)
    */
-  void txPktL2(1: fbbinary data) throws (1: fboss.FbossBaseError error)
+  void txPktL2(1: fbiobuf data) throws (1: fboss.FbossBaseError error)
 
   /*
    * Transmit an L3 packet.
@@ -297,7 +543,22 @@ service FbossCtrl extends fb303.FacebookService {
    * The controller will add an appropriate ethernet frame header.  It will
    * contain the correct next hop information based on the layer 3 header.
    */
-  void txPktL3(1: fbbinary payload) throws (1: fboss.FbossBaseError error)
+  void txPktL3(1: fbiobuf payload) throws (1: fboss.FbossBaseError error)
+
+  /*
+   * Trace a probe frame through the switching pipeline.
+   *
+   * The frame is injected through the hardware's visibility/trace
+   * facility as if it had been received on the given port, without
+   * actually being forwarded. Returns the per-stage resolution the
+   * pipeline computed for it: which lookups hit, the forwarding
+   * resolution, the ECMP members considered and the one selected, and
+   * the egress pipe. This lets an automated prober validate hardware
+   * path symmetry (e.g. hunt ECMP polarization) without mirroring or
+   * bisection.
+   */
+  packettrace.PacketTraceInfo getPacketTrace(1: i32 port, 2: fbbinary data)
+    throws (1: fboss.FbossBaseError error)
 
   /*
    * Flush the ARP/NDP entry with the specified IP address.
@@ -335,6 +596,18 @@ service FbossCtrl extends fb303.FacebookService {
     throws (1: fboss.FbossBaseError error)
   void registerForNeighborChanged()
     throws (1: fboss.FbossBaseError error) (thread='eb')
+  /*
+   * Subscribe this duplex connection to neighbor entry deltas.
+   *
+   * Instead of polling getArpTable/getNdpTable and diffing full
+   * snapshots, subscribers receive only the entries that were added,
+   * changed (MAC or port move) or removed, batched per interval and
+   * delivered through NeighborListenerClient.neighborEntryDeltas() on
+   * the duplex channel, making telemetry cost proportional to churn
+   * rather than table size.
+   */
+  void registerForNeighborDeltas()
+    throws (1: fboss.FbossBaseError error) (thread='eb')
   list<string> getInterfaceList()
     throws (1: fboss.FbossBaseError error)
   /*
@@ -345,6 +618,46 @@ service FbossCtrl extends fb303.FacebookService {
     throws (1: fboss.FbossBaseError error)
   list<RouteDetails> getRouteTableDetails()
     throws (1: fboss.FbossBaseError error)
+  /*
+   * Paged variant of getRouteTable for very large FIBs, avoiding the
+   * transient allocation spike of materializing the whole table in one
+   * response. Pass cursor 0 to start a new dump; each call returns up
+   * to maxRoutes routes plus the cursor for the next call. The dump
+   * iterates over the SwitchState snapshot taken on the first call, so
+   * it stays consistent while routes change between pages. Only a few
+   * dumps may be in progress at a time; beyond that the least recently
+   * advanced one is dropped and its cursor errors out.
+   */
+  RouteTableChunk getRouteTableChunk(1: i64 cursor, 2: i32 maxRoutes)
+    throws (1: fboss.FbossBaseError error)
+  /*
+   * Snapshot-consistent multi-table query. All requested sections are
+   * answered from the single SwitchState snapshot pinned when the
+   * query starts, so a poller gets ports, neighbors and routes from
+   * the same state version without re-querying to detect torn reads.
+   * The scalar sections are returned on the first chunk (cursor 0);
+   * the ROUTES section pages across chunks out of the pinned snapshot
+   * with the same cursor rules as getRouteTableChunk(). Neighbor
+   * entries are read from the switch state, so unresolved entries
+   * report a PENDING state and no TTL.
+   */
+  StateSnapshotChunk getStateSnapshot(
+      1: list<StateSnapshotSection> sections,
+      2: i64 cursor,
+      3: i32 maxRoutes)
+    throws (1: fboss.FbossBaseError error)
+  /*
+   * Prefix-range query over one VRF's routes in startPrefix's address
+   * family. Returns up to maxRoutes RouteDetails in prefix order,
+   * starting at the first prefix >= startPrefix (pass the all-zeros /0
+   * prefix to start from the beginning). The cursor is a prefix rather
+   * than server-side state, so every call has bounded cost, pages stay
+   * valid while the route table changes underneath, and an auditing
+   * pipeline can spread a full FIB diff over many cheap calls.
+   */
+  RouteTableDetailsPage getRouteTableDetailsRange(1: i32 vrfId,
+      2: IpPrefix startPrefix, 3: i32 maxRoutes)
+    throws (1: fboss.FbossBaseError error)
   InterfaceDetail getInterfaceDetail(1: i32 interfaceId)
     throws (1: fboss.FbossBaseError error)
 
@@ -390,6 +703,25 @@ service FbossCtrl extends fb303.FacebookService {
   list<L2EntryThrift> getL2Table()
     throws (1: fboss.FbossBaseError error)
 
+  /*
+   * Paged version of getL2Table(). Pass cursor = 0 to start a dump; the
+   * hardware table walk runs on a background thread and each response
+   * carries up to maxEntries entries plus the cursor for the next call.
+   * The dump iterates over a snapshot of the table captured when the
+   * walk started, so entries learned or aged out while paging may be
+   * missed or duplicated, just as with the unpaged call.
+   */
+  L2TableChunk getL2TableChunk(1: i64 cursor, 2: i32 maxEntries)
+    throws (1: fboss.FbossBaseError error)
+
+  /*
+   * Occupancy, capacity and high-water marks of the hardware forwarding
+   * tables (host, LPM, nexthop, ECMP, ACL), so capacity exhaustion can
+   * be predicted rather than discovered when route programming fails.
+   */
+  list<HwTableUsage> getHwTableUsage()
+    throws (1: fboss.FbossBaseError error)
+
   // Deprecated - use the qsfp_service instead
   map<i32, optic.SfpDom> getSfpDomInfo(1: list<i32> port)
     throws (1: fboss.FbossBaseError error)
@@ -417,6 +749,43 @@ service FbossCtrl extends fb303.FacebookService {
   void stopAllPktCaptures()
     throws (1: fboss.FbossBaseError error)
 
+  /*
+   * Freeze the always-on flight recorder capture rings and write their
+   * contents (the most recently seen rx and tx packets) to a pcap file
+   * named like an ordinary capture.  The rings are reset afterwards.
+   */
+  void dumpPcapRing(1: string name)
+    throws (1: fboss.FbossBaseError error)
+
+  /*
+   * Retrieve the flows aggregated from hardware-sampled packets (see
+   * --sflow_sample_rate). A periodic collector should pass
+   * clearFlows=true so each call returns only the activity since the
+   * previous one.
+   */
+  list<SampledFlow> getSampledFlows(1: bool clearFlows)
+    throws (1: fboss.FbossBaseError error)
+
+  /*
+   * Return the slowest of the recently completed state updates, for
+   * debugging convergence latency. numTraces <= 0 returns the whole
+   * retained history.
+   */
+  list<ConvergenceTrace> getConvergenceTraces(1: i32 numTraces)
+    throws (1: fboss.FbossBaseError error)
+
+  /*
+   * Return an approximate per-subsystem memory breakdown in bytes,
+   * keyed by subsystem name ("routes", "neighbors", "capture", ...),
+   * so RSS growth can be attributed rather than guessed at. The same
+   * numbers are exported periodically as memory.<subsystem>_bytes
+   * gauges; this call recomputes them on demand and also accounts the
+   * Thrift-side buffers (pending chunked route updates and pinned
+   * dump snapshots).
+   */
+  map<string, i64> getMemoryBreakdown()
+    throws (1: fboss.FbossBaseError error)
+
   /*
    * Subscribe to a set of high-resolution counters
    */
@@ -428,10 +797,23 @@ service FbossCtrl extends fb303.FacebookService {
    * specific.
    */
   void startLoggingRouteUpdates(1: RouteUpdateLoggingInfo info)
+  /*
+   * Same as startLoggingRouteUpdates, for a batch of prefixes. Tracking
+   * for the whole batch is enabled atomically.
+   */
+  void startLoggingRouteUpdatesForPrefixes(1: list<RouteUpdateLoggingInfo> infos)
   void stopLoggingRouteUpdates(1: IpPrefix prefix, 2: string identifier)
   void stopLoggingAnyRouteUpdates(1: string identifier)
   list<RouteUpdateLoggingInfo> getRouteUpdateLoggingTrackedPrefixes()
 
+  /*
+   * Per-node-type clone/publish accounting for the copy-on-write state
+   * tree.  Throws unless the agent was built with
+   * FBOSS_PROFILE_NODE_CLONES.
+   */
+  list<NodeCloneStats> getNodeCloneStats(1: bool clearAfterRead)
+    throws (1: fboss.FbossBaseError error)
+
   void keepalive()
 
   i32 getIdleTimeout()
@@ -448,6 +830,53 @@ service FbossCtrl extends fb303.FacebookService {
    * has changed since the agent started.
    */
   void reloadConfig()
+
+  /*
+   * Apply a partial config update to the running config.
+   *
+   * patchJson is a SimpleJSON serialized SwitchConfig containing just the
+   * named section ("ports", "vlans", "vlanPorts", "interfaces", "acls" or
+   * "staticRoutes"); that section replaces its counterpart in the running
+   * config wholesale and everything else is carried forward unchanged.
+   * Only the switch state subtrees derived from the patched section are
+   * rebuilt, so small incremental updates (e.g. one port's speed) avoid
+   * the cost of a full config apply.
+   */
+  void applyConfigPatch(1: string section, 2: string patchJson)
+    throws (1: fboss.FbossBaseError error)
+
+  /*
+   * Write a compact binary dump of selected operational state subtrees
+   * to a local file.
+   *
+   * subtrees is a comma-separated list of "ports", "neighbors",
+   * "routes" or "routes:<vrf>". The dump is an OperStateSnapshot
+   * (switch_state.thrift) serialized with the compact protocol; it
+   * skips the per-node folly::dynamic/JSON conversion entirely, so it
+   * stays sub-second at full scale. Pretty print it off box with
+   * fboss/agent/tools/dump_state.py.
+   */
+  void dumpOperState(1: string subtrees, 2: string outFile)
+    throws (1: fboss.FbossBaseError error)
+
+  /*
+   * Batched counter export.
+   *
+   * getCounters() materializes the full counter map on every scrape,
+   * which is measurable server-side work once hundreds of counters are
+   * scraped every few seconds. A scraper instead registers the set of
+   * counters it wants once, then polls getCounterDeltas() with the
+   * version from the previous batch. The reply packs one
+   * zigzag/varint encoded value per manifest entry into a single
+   * buffer: deltas against the previous batch when the versions line
+   * up, absolute values when the caller needs to resync. Replies are
+   * cached briefly on the server, so several scrapers sharing a
+   * manifest cost one counter read per interval.
+   */
+  i64 registerCounterManifest(1: list<string> names)
+    throws (1: fboss.FbossBaseError error)
+  CounterDeltaBatch getCounterDeltas(1: i64 manifestId, 2: i64 sinceVersion)
+    throws (1: fboss.FbossBaseError error)
 }
 
 service NeighborListenerClient extends fb303.FacebookService {
@@ -460,4 +889,13 @@ service NeighborListenerClient extends fb303.FacebookService {
    */
   void neighborsChanged(1: list<string> added, 2: list<string> removed)
     throws (1: fboss.FbossBaseError error)
+
+  /*
+   * Sends the neighbor entry transitions accumulated over the last
+   * batching interval to subscribers registered through
+   * registerForNeighborDeltas(). Deltas are not queued between
+   * subscriptions.
+   */
+  void neighborEntryDeltas(1: list<NeighborEntryDelta> deltas)
+    throws (1: fboss.FbossBaseError error)
 }
@@ -37,7 +37,14 @@ struct CounterSubscribeRequest {
   // Whether to lower the priority of the sampling thread
   7 : bool veryNice,
 
-  8 : set<CounterRequest> counterSet
+  8 : set<CounterRequest> counterSet,
+
+  // Publish batches as a single pre-serialized binary blob via
+  // publishCountersBinary instead of a structured publishCounters call.
+  // This moves serialization off the event base thread and turns each
+  // batch into one contiguous write, which matters at kilohertz
+  // sampling rates.
+  9 : bool binaryFraming
 }
 
 struct HighresTime {
@@ -59,4 +66,8 @@ struct CounterPublication {
 
 service FbossHighresClient {
   oneway void publishCounters(1: CounterPublication pub) (thread='eb')
+  // One CounterPublication, serialized with the Thrift binary protocol.
+  // Sent instead of publishCounters when the subscription requested
+  // binaryFraming.
+  oneway void publishCountersBinary(1: fbstring pubData) (thread='eb')
 }
@@ -8,6 +8,8 @@
 #include <folly/io/Cursor.h>
 #include <glog/logging.h>
 
+#include <cstring>
+
 using folly::ByteRange;
 using folly::IPAddressV4;
 using folly::IPAddressV6;
@@ -127,16 +129,26 @@ bool LinkNeighbor::parseLldpPdu(PortID srcPort,
   bool portIdPresent{false};
   bool ttlPresent{false};
   try {
-    while (true) {
-      auto type = parseLldpTlv(cursor);
-      if (type == LldpTlvType::END) {
-        break;
-      } else if (type == LldpTlvType::CHASSIS) {
-        chassisIdPresent = true;
-      } else if (type == LldpTlvType::PORT) {
-        portIdPresent = true;
-      } else if (type == LldpTlvType::TTL) {
-        ttlPresent = true;
+    if (cursor->length() == cursor->totalLength()) {
+      // The whole PDU is contiguous, which is the common case for
+      // received frames.  Scan it with raw pointers rather than paying
+      // for a Cursor bounds check on every read.
+      ByteRange buf(cursor->data(), cursor->length());
+      auto consumed = parseLldpTlvs(buf, &chassisIdPresent,
+                                    &portIdPresent, &ttlPresent);
+      cursor->skip(consumed);
+    } else {
+      while (true) {
+        auto type = parseLldpTlv(cursor);
+        if (type == LldpTlvType::END) {
+          break;
+        } else if (type == LldpTlvType::CHASSIS) {
+          chassisIdPresent = true;
+        } else if (type == LldpTlvType::PORT) {
+          portIdPresent = true;
+        } else if (type == LldpTlvType::TTL) {
+          ttlPresent = true;
+        }
       }
     }
   } catch (const std::exception& ex) {
@@ -166,6 +178,91 @@ bool LinkNeighbor::parseLldpPdu(PortID srcPort,
   return true;
 }
 
+size_t LinkNeighbor::parseLldpTlvs(ByteRange buf,
+                                   bool* chassisIdPresent,
+                                   bool* portIdPresent,
+                                   bool* ttlPresent) {
+  const uint8_t* p = buf.begin();
+  const uint8_t* end = buf.end();
+  while (true) {
+    if (end - p < 2) {
+      throw std::out_of_range("LLDP PDU truncated in TLV header");
+    }
+    // Parse the type (7 bits) and length (9 bits)
+    uint16_t word = (uint16_t(p[0]) << 8) | p[1];
+    auto type = LldpTlvType(word >> 9);
+    uint16_t length = word & 0x01ff;
+    p += 2;
+    if (type == LldpTlvType::END) {
+      return p - buf.begin();
+    }
+    if (length > static_cast<size_t>(end - p)) {
+      throw std::out_of_range("LLDP TLV length runs past the end of the PDU");
+    }
+
+    // Everything below may assume [p, p + length) is in bounds.
+    switch (type) {
+      case LldpTlvType::CHASSIS:
+        if (length < 1) {
+          throw std::out_of_range("LLDP chassis length must be at least 1");
+        }
+        chassisIdType_ = static_cast<LldpChassisIdType>(p[0]);
+        chassisId_.assign(reinterpret_cast<const char*>(p + 1), length - 1);
+        *chassisIdPresent = true;
+        break;
+      case LldpTlvType::PORT:
+        if (length < 1) {
+          throw std::out_of_range("LLDP port length must be at least 1");
+        }
+        portIdType_ = static_cast<LldpPortIdType>(p[0]);
+        portId_.assign(reinterpret_cast<const char*>(p + 1), length - 1);
+        *portIdPresent = true;
+        break;
+      case LldpTlvType::TTL:
+        if (length != 2) {
+          throw std::out_of_range("LLDP TTL length must be 2");
+        }
+        setTTL(std::chrono::seconds((uint16_t(p[0]) << 8) | p[1]));
+        *ttlPresent = true;
+        break;
+      case LldpTlvType::PORT_DESC:
+        assignIfChanged(ByteRange(p, length), &portDescription_);
+        break;
+      case LldpTlvType::SYSTEM_NAME:
+        assignIfChanged(ByteRange(p, length), &systemName_);
+        break;
+      case LldpTlvType::SYSTEM_DESC:
+        assignIfChanged(ByteRange(p, length), &systemDescription_);
+        break;
+      case LldpTlvType::SYSTEM_CAPS:
+        if (length != 4) {
+          throw std::out_of_range("LLDP capabilities length must be 4");
+        }
+        capabilities_ = (uint16_t(p[0]) << 8) | p[1];
+        enabledCapabilities_ = (uint16_t(p[2]) << 8) | p[3];
+        break;
+      case LldpTlvType::END:
+        // Handled above; keeps the switch exhaustive.
+        break;
+      default:
+        // We ignore any other TLV types for now, including
+        // LldpTlvType::MGMT_ADDR.
+        break;
+    }
+    p += length;
+  }
+}
+
+void LinkNeighbor::assignIfChanged(ByteRange value, std::string* field) {
+  // Skip the copy when the value is unchanged, which is the common
+  // case for a neighbor's periodic re-advertisements parsed into a
+  // reused LinkNeighbor object.
+  if (field->size() != value.size() ||
+      memcmp(field->data(), value.data(), value.size()) != 0) {
+    field->assign(reinterpret_cast<const char*>(value.data()), value.size());
+  }
+}
+
 LinkNeighbor::LldpTlvType LinkNeighbor::parseLldpTlv(Cursor* cursor) {
   // Parse the type (7 bits) and length (9 bits)
   uint16_t length = cursor->readBE<uint16_t>();
@@ -299,6 +299,19 @@ struct LinkNeighbor {
   static std::string humanReadableMac(const std::string& data);
   static std::string humanReadableNetAddr(const std::string& data);
 
+  /*
+   * Parse all TLVs from a contiguous buffer, and return the number of
+   * bytes consumed.  This is the fast path for received frames: it
+   * performs one bounds check per TLV on raw pointers instead of one
+   * per Cursor read.
+   */
+  size_t parseLldpTlvs(folly::ByteRange buf,
+                       bool* chassisIdPresent,
+                       bool* portIdPresent,
+                       bool* ttlPresent);
+  // Assign value to *field, skipping the copy if it is unchanged.
+  static void assignIfChanged(folly::ByteRange value, std::string* field);
+
   LldpTlvType parseLldpTlv(folly::io::Cursor* cursor);
   void parseLldpChassis(folly::io::Cursor* cursor, uint16_t length);
   void parseLldpPortId(folly::io::Cursor* cursor, uint16_t length);
@@ -53,81 +53,115 @@ bool LinkNeighborDB::NeighborKey::operator==(const NeighborKey& other) const {
 LinkNeighborDB::LinkNeighborDB() {
 }
 
-void LinkNeighborDB::update(const LinkNeighbor& neighbor) {
-  lock_guard<mutex> guard(mutex_);
+LinkNeighborDB::PortBucket* LinkNeighborDB::getBucket(PortID port) {
+  lock_guard<mutex> guard(bucketsLock_);
+  auto it = buckets_.find(port);
+  if (it == buckets_.end()) {
+    it = buckets_.emplace(port, std::make_unique<PortBucket>()).first;
+  }
+  return it->second.get();
+}
 
-  // Go ahead and prune expired neighbors each time we get updated.
-  pruneLocked(steady_clock::now());
+void LinkNeighborDB::update(const LinkNeighbor& neighbor) {
+  auto* bucket = getBucket(neighbor.getLocalPort());
+  NeighborKey key(neighbor);
 
-  auto it = byLocalPort_.find(neighbor.getLocalPort());
-  if (it == byLocalPort_.end()) {
-    // This is the first time we have seen data for this port.
-    auto ret = byLocalPort_.emplace(neighbor.getLocalPort(),
-                                    NeighborMap());
-    it = ret.first;
+  bool isNew;
+  {
+    lock_guard<mutex> guard(bucket->lock);
+    auto ret = bucket->neighbors.emplace(key, neighbor);
+    isNew = ret.second;
+    if (!isNew) {
+      // It would be nicer to use insert_or_assign() once we move to C++17
+      ret.first->second = neighbor;
+    }
   }
 
-  NeighborKey key(neighbor);
-  // It would be nicer to use insert_or_assign() once we move to C++17
-  it->second[key] = neighbor;
+  // A refreshed neighbor already has a wheel entry; when it comes up
+  // for pruning we'll notice the newer expiration time and re-arm it.
+  if (isNew) {
+    lock_guard<mutex> guard(wheelLock_);
+    wheel_.emplace(neighbor.getExpirationTime(),
+                   WheelEntry(neighbor.getLocalPort(), std::move(key)));
+  }
 }
 
 vector<LinkNeighbor> LinkNeighborDB::getNeighbors() {
-  vector<LinkNeighbor> results;
-  lock_guard<mutex> guard(mutex_);
+  // Snapshot the bucket list first so we never hold bucketsLock_ and a
+  // bucket lock at the same time; buckets are never removed, so the
+  // pointers stay valid.
+  vector<PortBucket*> buckets;
+  {
+    lock_guard<mutex> guard(bucketsLock_);
+    buckets.reserve(buckets_.size());
+    for (const auto& entry : buckets_) {
+      buckets.push_back(entry.second.get());
+    }
+  }
 
-  for (const auto& portEntry : byLocalPort_) {
-    for (const auto& entry : portEntry.second) {
+  vector<LinkNeighbor> results;
+  for (auto* bucket : buckets) {
+    lock_guard<mutex> guard(bucket->lock);
+    for (const auto& entry : bucket->neighbors) {
       results.push_back(entry.second);
     }
   }
-
   return results;
 }
 
 vector<LinkNeighbor> LinkNeighborDB::getNeighbors(PortID port) {
-  vector<LinkNeighbor> results;
-  lock_guard<mutex> guard(mutex_);
+  auto* bucket = getBucket(port);
 
-  auto it = byLocalPort_.find(port);
-  if (it != byLocalPort_.end()) {
-    for (const auto& entry : it->second) {
-      results.push_back(entry.second);
-    }
+  vector<LinkNeighbor> results;
+  lock_guard<mutex> guard(bucket->lock);
+  for (const auto& entry : bucket->neighbors) {
+    results.push_back(entry.second);
   }
-
   return results;
 }
 
 void LinkNeighborDB::pruneExpiredNeighbors() {
-  lock_guard<mutex> guard(mutex_);
-  pruneLocked(steady_clock::now());
+  pruneExpiredNeighbors(steady_clock::now());
 }
 
 void LinkNeighborDB::pruneExpiredNeighbors(steady_clock::time_point now) {
-  lock_guard<mutex> guard(mutex_);
-  pruneLocked(now);
-}
+  // Pop everything that has nominally expired off the front of the
+  // wheel.  Entries further back cannot have expired yet, so this only
+  // ever touches expired (or refreshed-since-armed) entries no matter
+  // how large the database is.
+  vector<WheelEntry> candidates;
+  {
+    lock_guard<mutex> guard(wheelLock_);
+    auto end = wheel_.upper_bound(now);
+    for (auto it = wheel_.begin(); it != end; ++it) {
+      candidates.push_back(std::move(it->second));
+    }
+    wheel_.erase(wheel_.begin(), end);
+  }
+
+  // Check each candidate against its current expiration time: the
+  // neighbor may have been refreshed since its wheel entry was armed,
+  // in which case it gets a new entry instead of being removed.
+  vector<std::pair<steady_clock::time_point, WheelEntry>> rearm;
+  for (auto& candidate : candidates) {
+    auto* bucket = getBucket(candidate.port);
+    lock_guard<mutex> guard(bucket->lock);
+    auto it = bucket->neighbors.find(candidate.key);
+    if (it == bucket->neighbors.end()) {
+      continue;
+    }
+    if (it->second.isExpired(now)) {
+      bucket->neighbors.erase(it);
+    } else {
+      rearm.emplace_back(it->second.getExpirationTime(),
+                         std::move(candidate));
+    }
+  }
 
-void LinkNeighborDB::pruneLocked(steady_clock::time_point now) {
-  // We just do a linear scan for now.
-  //
-  // We could maintain a priority queue of entries by expiration time,
-  // to make this scanning faster.  However, we don't expect the number of
-  // neighbors to be very large, so the extra complexity isn't worth
-  // implementing right now.
-
-  for (auto& portEntry : byLocalPort_) {
-    // Advance the iterator manually to avoid make sure we don't
-    // have invalid iterators to erased elements.
-    auto& map = portEntry.second;
-    auto it = map.begin();
-    while (it != map.end()) {
-      auto current = it;
-      ++it;
-      if (current->second.isExpired(now)) {
-        map.erase(current);
-      }
+  if (!rearm.empty()) {
+    lock_guard<mutex> guard(wheelLock_);
+    for (auto& entry : rearm) {
+      wheel_.emplace(entry.first, std::move(entry.second));
     }
   }
 }
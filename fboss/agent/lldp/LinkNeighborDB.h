@@ -6,6 +6,7 @@
 
 #include <chrono>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -17,6 +18,12 @@ class LinkNeighbor;
  * LinkNeighborDB maintains information about known neighbors.
  *
  * This class is thread-safe, and performs synchronization internally.
+ * Neighbors are stored in per-port buckets, each guarded by its own
+ * lock, so updates for different ports never contend and readers only
+ * ever block the ports they are copying.  A shared expiration wheel
+ * keeps the entries ordered by expiry time so pruning only touches
+ * entries that have actually expired instead of scanning the whole
+ * database.
  */
 class LinkNeighborDB {
  public:
@@ -62,14 +69,43 @@ class LinkNeighborDB {
   };
   typedef std::map<NeighborKey, LinkNeighbor> NeighborMap;
 
+  // All of the neighbors learned on one local port, guarded by the
+  // bucket's own lock.
+  struct PortBucket {
+    std::mutex lock;
+    NeighborMap neighbors;
+  };
+
+  // An expiration wheel entry pointing back at a neighbor.  Wheel
+  // entries are armed with the expiration time the neighbor had when it
+  // was first learned; if the neighbor has been refreshed by the time
+  // its entry comes up for pruning, the entry is simply re-armed with
+  // the new expiration time.
+  struct WheelEntry {
+    WheelEntry(PortID p, NeighborKey k)
+      : port(p), key(std::move(k)) {}
+    PortID port;
+    NeighborKey key;
+  };
+
   // Forbidden copy constructor and assignment operator
   LinkNeighborDB(LinkNeighborDB const &) = delete;
   LinkNeighborDB& operator=(LinkNeighborDB const &) = delete;
 
-  void pruneLocked(std::chrono::steady_clock::time_point now);
+  // Returns the bucket for port, creating it if necessary.  Buckets
+  // are never removed, so the returned pointer stays valid after
+  // bucketsLock_ has been dropped.
+  PortBucket* getBucket(PortID port);
+
+  std::mutex bucketsLock_;
+  std::map<PortID, std::unique_ptr<PortBucket>> buckets_;
 
-  std::mutex mutex_;
-  std::map<PortID, NeighborMap> byLocalPort_;
+  // Entries ordered by expiry time.  There is exactly one wheel entry
+  // per live neighbor: update() only arms a new one when the neighbor
+  // is first learned, and pruneExpiredNeighbors() re-arms entries for
+  // neighbors that were refreshed in the meantime.
+  std::mutex wheelLock_;
+  std::multimap<std::chrono::steady_clock::time_point, WheelEntry> wheel_;
 };
 
 }} // facebook::fboss
@@ -104,3 +104,30 @@ TEST(LinkNeighborDB, test) {
   ASSERT_EQ(1, neighbors.size());
   EXPECT_EQ("neighbor3 name", neighbors[0].getSystemName());
 }
+
+TEST(LinkNeighborDB, refreshRearmsExpiration) {
+  LinkNeighborDB db;
+
+  LinkNeighbor n1;
+  n1.setProtocol(LinkProtocol::LLDP);
+  n1.setLocalPort(PortID(1));
+  n1.setLocalVlan(VlanID(1));
+  n1.setMac(MacAddress("00:11:22:33:44:55"));
+  n1.setChassisId("neighbor1", LldpChassisIdType::LOCALLY_ASSIGNED);
+  n1.setPortId("1/1", LldpPortIdType::LOCALLY_ASSIGNED);
+  n1.setTTL(seconds(5));
+  db.update(n1);
+
+  // Refresh the neighbor with a longer TTL.  Pruning past the original
+  // expiration must notice the newer expiration time and keep the
+  // entry.
+  n1.setTTL(seconds(30));
+  db.update(n1);
+
+  db.pruneExpiredNeighbors(steady_clock::now() + seconds(6));
+  EXPECT_EQ(1, db.getNeighbors().size());
+
+  // Once the refreshed TTL has also passed the entry goes away.
+  db.pruneExpiredNeighbors(steady_clock::now() + seconds(31));
+  EXPECT_EQ(0, db.getNeighbors().size());
+}
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/lldp/LinkNeighbor.h"
+#include "fboss/agent/packet/PktUtil.h"
+
+#include <folly/Benchmark.h>
+#include <folly/MacAddress.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+
+using namespace facebook::fboss;
+using folly::IOBuf;
+using folly::MacAddress;
+using folly::io::Cursor;
+
+namespace {
+
+constexpr uint16_t kEtherTypeLldp = 0x88cc;
+
+const MacAddress kSrcMac("74:83:ef:12:34:56");
+
+// A typical production LLDP PDU (everything after the ethertype):
+// MAC chassis ID, interface-name port ID, TTL, port description,
+// system name, system description, and capabilities.
+IOBuf fullPdu = PktUtil::parseHexData(
+    "02 07 04 74 83 ef 12 34 56 04 09 05 65 74 68 34"
+    "2f 31 2f 31 06 02 00 78 08 1d 66 73 77 30 30 31"
+    "2e 70 30 36 32 2e 66 30 31 2e 61 74 6e 31 3a 65"
+    "74 68 34 2f 31 2f 31 0a 0e 72 73 77 31 61 62 2e"
+    "32 31 2e 61 74 6e 31 0c 1c 46 61 63 65 62 6f 6f"
+    "6b 20 57 65 64 67 65 20 33 32 78 34 30 47 20 73"
+    "77 69 74 63 68 0e 04 00 14 00 14 00 00");
+
+// A minimal PDU carrying only the mandatory TLVs, as lldp_tool
+// generates at high rate
+IOBuf minimalPdu = PktUtil::parseHexData(
+    "02 07 04 74 83 ef 12 34 56 04 05 05 65 74 68 30"
+    "06 02 00 78 00 00");
+
+}
+
+BENCHMARK(parseFullPdu, numIters) {
+  for (size_t n = 0; n < numIters; ++n) {
+    Cursor cursor(&fullPdu);
+    LinkNeighbor neighbor;
+    neighbor.parseLldpPdu(PortID(1), VlanID(1), kSrcMac,
+                          kEtherTypeLldp, &cursor);
+    folly::doNotOptimizeAway(neighbor.getSystemName().size());
+  }
+}
+
+BENCHMARK(parseMinimalPdu, numIters) {
+  for (size_t n = 0; n < numIters; ++n) {
+    Cursor cursor(&minimalPdu);
+    LinkNeighbor neighbor;
+    neighbor.parseLldpPdu(PortID(1), VlanID(1), kSrcMac,
+                          kEtherTypeLldp, &cursor);
+    folly::doNotOptimizeAway(neighbor.getPortId().size());
+  }
+}
+
+// Re-parse the same PDU into one neighbor object, the steady-state
+// pattern for a neighbor's periodic re-advertisements: the string
+// fields are unchanged, so no allocations happen per parse.
+BENCHMARK(reparseFullPduUnchanged, numIters) {
+  LinkNeighbor neighbor;
+  for (size_t n = 0; n < numIters; ++n) {
+    Cursor cursor(&fullPdu);
+    neighbor.parseLldpPdu(PortID(1), VlanID(1), kSrcMac,
+                          kEtherTypeLldp, &cursor);
+    folly::doNotOptimizeAway(neighbor.getSystemName().size());
+  }
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -12,6 +12,7 @@
 #include <netinet/icmp6.h>
 #include <folly/IPAddressV6.h>
 #include <folly/MacAddress.h>
+#include <folly/Random.h>
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/TxPacket.h"
@@ -113,7 +114,14 @@ IPv6RAImpl::IPv6RAImpl(SwSwitch* sw,
 }
 
 void IPv6RAImpl::start(IPv6RAImpl* ra) {
-  ra->scheduleTimeout(ra->interval_);
+  // All of the advertisers for a config are created in the same state
+  // update, so if they all waited exactly interval_ for their first
+  // advertisement they would burst together every interval forever.
+  // Stagger the first timeout randomly within the interval; after that
+  // each advertiser keeps its own phase.
+  std::chrono::milliseconds initialDelay(
+      folly::Random::rand32(ra->interval_.count()) + 1);
+  ra->scheduleTimeout(initialDelay);
 }
 
 void IPv6RAImpl::stop(IPv6RAImpl* ra) {
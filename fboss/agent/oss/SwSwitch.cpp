@@ -26,7 +26,16 @@ void SwSwitch::initThread(folly::StringPiece name) {
 
 void SwSwitch::publishInitTimes(std::string name, const float& time) {}
 
-void SwSwitch::publishStats() {}
+void SwSwitch::publishStats() {
+  // fb303 aggregation is a no-op in the open source build, but we still
+  // kick off hardware counter collection so per-port snapshots stay
+  // fresh.  The collection runs on the background thread; see
+  // updateHwStatsAsync().
+  updateHwStatsAsync();
+  publishRouteStats();
+  publishSwitchStateStats();
+  publishMemoryStats();
+}
 
 void SwSwitch::publishSwitchInfo(struct HwInitResult hwInitRet) {}
 
@@ -58,17 +58,97 @@ void DHCPv4Packet::parse(Cursor* cursor) {
     }
     if (cursor->totalLength()) {
       auto optionsLen = cursor->totalLength();
-      uint8_t optionsRaw[optionsLen];
-      options.reserve(options.size() + optionsLen);
-      cursor->pullAtMost(optionsRaw, optionsLen);
-      copy(optionsRaw, optionsRaw + optionsLen, back_inserter(options));
+      auto origSize = options.size();
+      // Pull straight into the options vector, no staging copy
+      options.resize(origSize + optionsLen);
+      cursor->pullAtMost(&options[origSize], optionsLen);
     }
+    indexOptions();
   } catch (std::out_of_range& e) {
     throw FbossError("Too small packet, "
         "expected minimum ", minSize(), " bytes");
   }
 }
 
+void DHCPv4Packet::indexOptions() {
+  numIndexedOptions_ = 0;
+  optionIndexComplete_ = true;
+  size_t optIndex = 0;
+  while (optIndex < options.size()) {
+    uint8_t curOp = options[optIndex];
+    if (curOp == DHCPv4Handler::END) {
+      break;
+    }
+    if (curOp == DHCPv4Handler::PAD) {
+      ++optIndex;
+      continue;
+    }
+    if (optIndex + 1 >= options.size()) {
+      // Truncated option; leave it unindexed
+      break;
+    }
+    uint8_t opDataLen = options[optIndex + 1];
+    if (optIndex + 2 + opDataLen > options.size()) {
+      // Option data runs past the end of the buffer; don't index it
+      break;
+    }
+    if (numIndexedOptions_ == kMaxIndexedOptions) {
+      optionIndexComplete_ = false;
+      break;
+    }
+    auto& entry = optionIndex_[numIndexedOptions_++];
+    entry.op = curOp;
+    entry.len = opDataLen;
+    entry.offset = optIndex + 2;
+    optIndex += 2 + opDataLen;
+  }
+}
+
+bool DHCPv4Packet::getOption(uint8_t op, folly::ByteRange& data) const {
+  for (uint8_t i = 0; i < numIndexedOptions_; ++i) {
+    const auto& entry = optionIndex_[i];
+    if (entry.op == op) {
+      data.reset(options.data() + entry.offset, entry.len);
+      return true;
+    }
+  }
+  if (!optionIndexComplete_) {
+    // Packets with more options than the index holds are rare; rescan
+    // the raw bytes for the tail the index didn't cover.
+    size_t optIndex = 0;
+    while (optIndex < options.size()) {
+      uint8_t curOp = options[optIndex];
+      uint8_t opDataLen = isOptionWithoutLength(curOp) ? 0 :
+        options[optIndex + 1];
+      if (curOp == op) {
+        data.reset(opDataLen == 0 ? nullptr : options.data() + optIndex + 2,
+            opDataLen);
+        return true;
+      }
+      optIndex += opDataLen == 0 ? 1 : 2 + opDataLen;
+    }
+  }
+  return false;
+}
+
+bool DHCPv4Packet::getOptionByte(uint8_t op, uint8_t& value) const {
+  folly::ByteRange data;
+  if (!getOption(op, data) || data.size() < sizeof(uint8_t)) {
+    return false;
+  }
+  value = data[0];
+  return true;
+}
+
+bool DHCPv4Packet::getOptionUint16(uint8_t op, uint16_t& value) const {
+  folly::ByteRange data;
+  if (!getOption(op, data) || data.size() < sizeof(uint16_t)) {
+    return false;
+  }
+  value = (static_cast<uint16_t>(data[0]) << 8) | data[1];
+  return true;
+}
+
 bool DHCPv4Packet::operator==(const DHCPv4Packet& r) const {
   return op == r.op && htype == r.htype &&
     hlen == r.hlen && hops == r.hops &&
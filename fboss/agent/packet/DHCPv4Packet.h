@@ -12,6 +12,7 @@
 #include <memory>
 #include <vector>
 #include <folly/IPAddressV4.h>
+#include <folly/Range.h>
 
 namespace folly { namespace io {
 class Cursor;
@@ -76,6 +77,31 @@ struct DHCPv4Packet {
    */
   static bool getOptionSlow(uint8_t op, const Options& options,
       std::vector<uint8_t>& optionData);
+
+  /*
+   * (Re)build the option index from the options vector. parse() calls
+   * this; code that mutates options directly and then wants indexed
+   * lookups should call it again. PAD is not indexed and indexing stops
+   * at END, so the index holds only data bearing options.
+   */
+  void indexOptions();
+
+  /*
+   * Zero-copy option lookup via the index built by indexOptions().
+   * On success points data at the option bytes inside this packet's own
+   * storage (valid until options is next mutated) and returns true;
+   * returns false if the option is absent. Packets with more options
+   * than the index holds fall back to rescanning the raw bytes.
+   */
+  bool getOption(uint8_t op, folly::ByteRange& data) const;
+
+  /*
+   * Typed accessors over getOption(). Return false if the option is
+   * absent or its data is too short for the requested type. Multi-byte
+   * values are read in network byte order.
+   */
+  bool getOptionByte(uint8_t op, uint8_t& value) const;
+  bool getOptionUint16(uint8_t op, uint16_t& value) const;
   template<typename CursorType>
   void write(CursorType* cursor) const;
  /* From rfc 2131
@@ -129,6 +155,23 @@ struct DHCPv4Packet {
   // for BOOTP packets
   std::vector<uint8_t> dhcpCookie;
   std::vector<uint8_t> options;
+
+ private:
+  // Option index entry: option code plus offset and length of the
+  // option data within the options vector.
+  struct OptionIndexEntry {
+    uint8_t op{0};
+    uint8_t len{0};
+    uint16_t offset{0};
+  };
+  enum : size_t { kMaxIndexedOptions = 32 };
+
+  // Derived from options by indexOptions(); deliberately not part of
+  // operator==.
+  std::array<OptionIndexEntry, kMaxIndexedOptions> optionIndex_;
+  uint8_t numIndexedOptions_{0};
+  // False if options held more entries than the index has room for
+  bool optionIndexComplete_{true};
 };
 
 template<typename CursorType>
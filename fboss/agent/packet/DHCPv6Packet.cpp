@@ -49,15 +49,16 @@ bool DHCPv6Packet::isDHCPv6Relay() const {
 }
 
 void DHCPv6Packet::addRelayMessageOption(const DHCPv6Packet& dhcpPktIn) {
-  // serialize the dhcpPktIn
+  // serialize the dhcpPktIn into a stack buffer, wrapped without
+  // allocating an IOBuf on the heap
   auto totalLength = dhcpPktIn.computePacketLength();
   uint8_t pktBuf[totalLength];
-  auto buf = IOBuf::wrapBuffer(pktBuf, totalLength);
-  RWPrivateCursor cursor(buf.get());
+  IOBuf buf(IOBuf::WRAP_BUFFER, pktBuf, totalLength);
+  RWPrivateCursor cursor(&buf);
   dhcpPktIn.write(&cursor);
 
   // append the option
-  appendOption(DHCPv6_OPTION_RELAY_MSG, totalLength, buf->data());
+  appendOption(DHCPv6_OPTION_RELAY_MSG, totalLength, buf.data());
 }
 
 void DHCPv6Packet::addInterfaceIDOption(MacAddress macAddr) {
@@ -76,16 +77,13 @@ void DHCPv6Packet::addInterfaceIDOption(MacAddress macAddr) {
 */
 size_t DHCPv6Packet::appendOption(uint16_t op, uint16_t len,
     const uint8_t* bytes) {
-  IOBuf buf(IOBuf::CREATE, 4);
-  buf.append(4);
-  RWPrivateCursor cursor(&buf);
-  // values in network byte order
-  cursor.writeBE<uint16_t>(op);
-  cursor.writeBE<uint16_t>(len);
-
   auto origSize = options.size();
   options.reserve(origSize + 4 + len);
-  copy(buf.data(), buf.data() + 4, std::back_inserter(options));
+  // option header, in network byte order
+  options.push_back(static_cast<uint8_t>(op >> 8));
+  options.push_back(static_cast<uint8_t>(op & 0xff));
+  options.push_back(static_cast<uint8_t>(len >> 8));
+  options.push_back(static_cast<uint8_t>(len & 0xff));
   copy(bytes, bytes + len, std::back_inserter(options));
 
   CHECK(options.size() == origSize + 4 + len);
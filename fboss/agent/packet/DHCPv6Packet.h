@@ -89,6 +89,13 @@ struct DHCPv6Packet {
   std::vector<DHCPv6Option> extractOptions(
       std::unordered_set<uint16_t> optionSelector);
   size_t appendOption(uint16_t op, uint16_t len, const uint8_t* bytes);
+  /*
+   * Pre-allocate the options buffer, so that subsequent appendOption
+   * calls fill it without reallocating per option.
+   */
+  void reserveOptions(size_t bytes) {
+    options.reserve(options.size() + bytes);
+  }
   size_t computePacketLength() const;
   bool isDHCPv6Relay() const;
   bool operator==(const DHCPv6Packet& r) const;
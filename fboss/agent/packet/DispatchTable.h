@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <glog/logging.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace facebook { namespace fboss {
+
+/*
+ * DispatchTable demuxes packets on sparse protocol identifiers --
+ * ethertypes, IP protocol numbers, ICMP types -- with a fixed-size
+ * handler table instead of a sequential if/else or switch chain.
+ *
+ * A lookup is one fold of the key, one table load and one key compare,
+ * independent of how many handlers are registered, so adding a protocol
+ * handler does not lengthen the demux path for existing protocols.
+ *
+ * The table holds 2^SizeBits slots and keys are folded into a slot by
+ * xoring the bits above SizeBits down. The registry passed to make()
+ * must fold collision-free at the chosen size; make() is constexpr, so
+ * when it initializes a constant a collision escapes constant evaluation
+ * into keyCollision() and aborts during static initialization instead of
+ * silently degrading dispatch.
+ */
+template<typename KeyT, typename HandlerT, size_t SizeBits>
+class DispatchTable {
+ public:
+  struct Entry {
+    KeyT key{0};
+    HandlerT handler{};
+  };
+  static constexpr size_t kSize = size_t(1) << SizeBits;
+
+  constexpr DispatchTable() : slots_() {}
+
+  /*
+   * Build a table from a registry of (key, handler) pairs.
+   */
+  static constexpr DispatchTable make(std::initializer_list<Entry> registry) {
+    DispatchTable table;
+    for (const auto& entry : registry) {
+      Entry& slot = table.slots_[fold(entry.key)];
+      if (slot.handler) {
+        keyCollision();
+      }
+      slot = entry;
+    }
+    return table;
+  }
+
+  /*
+   * Return the handler registered for key, or a null handler if there
+   * is none.
+   */
+  HandlerT lookup(KeyT key) const {
+    const Entry& entry = slots_[fold(key)];
+    return entry.key == key ? entry.handler : HandlerT{};
+  }
+
+ private:
+  static constexpr size_t fold(KeyT key) {
+    return (static_cast<size_t>(key) ^ (static_cast<size_t>(key) >> SizeBits))
+        & (kSize - 1);
+  }
+
+  static void keyCollision() {
+    LOG(FATAL) << "DispatchTable registry keys collide; "
+      "pick a larger SizeBits";
+  }
+
+  Entry slots_[kSize];
+};
+
+}} // facebook::fboss
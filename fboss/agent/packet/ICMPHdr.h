@@ -261,7 +261,8 @@ class ICMPHdr {
                            VlanID vlan,
                            const IPv6Hdr& ipv6,
                            uint32_t payloadLength,
-                           BodyFn bodyFn) {
+                           BodyFn bodyFn,
+                           bool computeCsum = true) {
     // Write the ethernet and IPv6 header
     serializePktHdr(cursor, dstMac, srcMac, vlan, ipv6, payloadLength);
 
@@ -276,8 +277,9 @@ class ICMPHdr {
     bodyFn(cursor);
     DCHECK((csumCursor + 2 + payloadLength) == *cursor);
 
-    // Now compute and write the checksum
-    csum = computeChecksum(ipv6, payloadStart);
+    // Now compute and write the checksum, unless the caller arranged for
+    // the hardware to fill it in on transmit.
+    csum = computeCsum ? computeChecksum(ipv6, payloadStart) : 0;
     csumCursor.writeBE<uint16_t>(csum);
   }
 
@@ -288,7 +290,8 @@ class ICMPHdr {
                            VlanID vlan,
                            const IPv4Hdr& ipv4,
                            uint32_t payloadLength,
-                           BodyFn bodyFn) {
+                           BodyFn bodyFn,
+                           bool computeCsum = true) {
     // Write the ethernet and IPv4 header
     serializePktHdr(cursor, dstMac, srcMac, vlan, ipv4);
 
@@ -303,8 +306,9 @@ class ICMPHdr {
     bodyFn(cursor);
     DCHECK((csumCursor + 2 + payloadLength) == *cursor);
 
-    // Now compute and write the checksum
-    csum = computeChecksum(payloadStart, payloadLength);
+    // Now compute and write the checksum, unless the caller arranged for
+    // the hardware to fill it in on transmit.
+    csum = computeCsum ? computeChecksum(payloadStart, payloadLength) : 0;
     csumCursor.writeBE<uint16_t>(csum);
   }
 
@@ -9,6 +9,10 @@
  */
 #include "fboss/agent/packet/PktUtil.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include <folly/Bits.h>
 #include <folly/Format.h>
 #include <folly/IPAddressV4.h>
 #include <folly/IPAddressV6.h>
@@ -16,6 +20,10 @@
 #include <folly/io/Cursor.h>
 #include "fboss/agent/FbossError.h"
 
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 using folly::IPAddressV4;
 using folly::IPAddressV6;
 using folly::MacAddress;
@@ -26,6 +34,83 @@ using folly::IOBuf;
 using folly::StringPiece;
 using std::string;
 
+namespace {
+
+/*
+ * Sum a contiguous buffer as native-endian 16 bit words.
+ * length must be even.
+ *
+ * RFC 1071 notes that the one's complement sum is independent of the
+ * byte order the words are summed in, so we can consume whole registers
+ * per step here and let the caller fold the result and swap it back to
+ * network word order.
+ */
+uint64_t sumNativeWords(const uint8_t* buffer, uint64_t length) {
+  uint64_t sum = 0;
+
+#ifdef __AVX2__
+  if (length >= 32) {
+    // Widen each 16 bit word to a 32 bit lane before accumulating; a
+    // lane can then absorb 2^15 iterations without overflowing, far
+    // more than any packet needs.
+    __m256i acc = _mm256_setzero_si256();
+    const __m256i zero = _mm256_setzero_si256();
+    do {
+      __m256i v =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer));
+      acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+      acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+      buffer += 32;
+      length -= 32;
+    } while (length >= 32);
+    uint32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    for (int i = 0; i < 8; ++i) {
+      sum += lanes[i];
+    }
+  }
+#elif defined(__SSE2__)
+  if (length >= 16) {
+    // Widen each 16 bit word to a 32 bit lane before accumulating; a
+    // lane can then absorb 2^15 iterations without overflowing, far
+    // more than any packet needs.
+    __m128i acc = _mm_setzero_si128();
+    const __m128i zero = _mm_setzero_si128();
+    do {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer));
+      acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+      acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+      buffer += 16;
+      length -= 16;
+    } while (length >= 16);
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    for (int i = 0; i < 4; ++i) {
+      sum += lanes[i];
+    }
+  }
+#endif
+
+  // Scalar fallback and vector tail. 32 bit loads can be accumulated
+  // directly: 2^16 == 1 (mod 0xffff), so the fold at the end collapses
+  // the high and low halves into the right 16 bit sum.
+  while (length >= 4) {
+    uint32_t word;
+    memcpy(&word, buffer, sizeof(word));
+    sum += word;
+    buffer += 4;
+    length -= 4;
+  }
+  if (length >= 2) {
+    uint16_t word;
+    memcpy(&word, buffer, sizeof(word));
+    sum += word;
+  }
+  return sum;
+}
+
+} // unnamed namespace
+
 namespace facebook { namespace fboss {
 
 MacAddress PktUtil::readMac(Cursor* cursor) {
@@ -76,21 +161,68 @@ uint16_t PktUtil::internetChecksum(const IOBuf* buf) {
   return finalizeChecksum(Cursor(buf), buf->computeChainDataLength(), 0);
 }
 
+uint32_t PktUtil::checksumFast(const uint8_t* buffer,
+                               uint64_t length,
+                               uint32_t value) {
+  uint64_t sum = sumNativeWords(buffer, length & ~static_cast<uint64_t>(1));
+  // Fold to 16 bits with the end-around carry, then swap back to
+  // network word order. The fold has to happen before the swap for the
+  // native word sum to be equivalent to the big-endian one.
+  while (sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  value += folly::Endian::big(static_cast<uint16_t>(sum));
+  if (length & 1) {
+    // Bytes are interpreted in n/w byte order, so a trailing odd byte
+    // represents the 8 MSbits of the last 16 bit number in this buffer.
+    value += buffer[length - 1] << 8;
+  }
+  return value;
+}
+
 uint32_t PktUtil::partialChecksumImpl(folly::io::Cursor cursor,
                                       uint64_t length,
                                       uint32_t value) {
-  // Checksum all the pairs of bytes first
-  while  (length > 1) {
-    value += cursor.readBE<uint16_t>();
-    length -= 2;
-  }
-  if (length) {
-    // Bytes are interpreted in n/w byte order
-    // so this last octet represents the 8 MSbits
-    // of the last 16 bit number in this buffer.
-    uint16_t last = cursor.read<uint8_t>();
-    value += (last << 8);
-    --length;
+  // Walk the contiguous segments of the buffer chain and feed each one
+  // to checksumFast(). A segment boundary may fall in the middle of a
+  // 16 bit word, in which case the straddling byte is held back and
+  // paired with the first byte of the next segment: the words are
+  // summed in network byte order irrespective of how the chain happens
+  // to be segmented.
+  int pending = -1;
+  while (length > 0) {
+    auto segment = cursor.peek();
+    auto data = segment.first;
+    uint64_t available = std::min<uint64_t>(segment.second, length);
+    if (available == 0) {
+      // Ran off the end of the buffer chain; let the Cursor throw the
+      // same exception the word-at-a-time reads used to.
+      cursor.skip(length);
+    }
+    if (pending >= 0) {
+      value += (pending << 8) | *data;
+      pending = -1;
+      cursor.skip(1);
+      ++data;
+      --available;
+      --length;
+    }
+    uint64_t even = available & ~static_cast<uint64_t>(1);
+    value = checksumFast(data, even, value);
+    cursor.skip(even);
+    length -= even;
+    if (available & 1) {
+      uint8_t last = data[even];
+      cursor.skip(1);
+      --length;
+      if (length == 0) {
+        // Trailing odd byte of the whole range: the 8 MSbits of the
+        // last 16 bit number.
+        value += last << 8;
+      } else {
+        pending = last;
+      }
+    }
   }
   return value;
 }
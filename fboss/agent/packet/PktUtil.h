@@ -85,6 +85,25 @@ class PktUtil {
                                    uint32_t value);
   static uint16_t finalizeChecksum(uint32_t value);
 
+  /*
+   * Compute a partial checksum over a contiguous buffer.
+   *
+   * This is the fast path underneath partialChecksum()/finalizeChecksum():
+   * it sums whole words at a time (with SSE2/AVX2 kernels where the
+   * compiler targets them, and a 32-bit-at-a-time scalar fallback
+   * otherwise) instead of walking the buffer one 16-bit read at a time.
+   *
+   * The return value is an unfolded partial sum with the same semantics
+   * as partialChecksum(): pass it as the initial value of a subsequent
+   * partialChecksum()/checksumFast() call, or to finalizeChecksum() to
+   * get the final checksum. An odd trailing byte is treated as the high
+   * 8 bits of a final 16-bit word, so odd lengths are only valid for the
+   * last piece of a packet.
+   */
+  static uint32_t checksumFast(const uint8_t* buffer,
+                               uint64_t length,
+                               uint32_t value = 0);
+
   /**
    * Return a string containing a human readable hex dump of the binary data.
    */
@@ -192,6 +192,38 @@ TEST(DHCPv4Packet, getOption) {
   EXPECT_EQ(0, optData.size());
 }
 
+TEST(DHCPv4Packet, getOptionIndexed) {
+  auto dhcpPkt = makeDHCPPacket();
+  // Indexed lookup points into the packet's own storage, no copy
+  folly::ByteRange optData;
+  EXPECT_TRUE(dhcpPkt.getOption(DHCPv4Handler::DHCP_MESSAGE_TYPE, optData));
+  EXPECT_EQ(1, optData.size());
+  EXPECT_EQ(1, optData[0]);
+  EXPECT_EQ(dhcpPkt.options.data() + 2, optData.data());
+
+  uint8_t msgType = 0;
+  EXPECT_TRUE(dhcpPkt.getOptionByte(DHCPv4Handler::DHCP_MESSAGE_TYPE,
+        msgType));
+  EXPECT_EQ(1, msgType);
+  // One byte of data is too short for a uint16_t read
+  uint16_t wideValue = 0;
+  EXPECT_FALSE(dhcpPkt.getOptionUint16(DHCPv4Handler::DHCP_MESSAGE_TYPE,
+        wideValue));
+
+  EXPECT_FALSE(dhcpPkt.getOption(DHCPv4Handler::DHCP_AGENT_OPTIONS, optData));
+
+  // The index tracks a rewritten option list once rebuilt
+  uint8_t maxSize[2] = {0x02, 0x40};
+  dhcpPkt.clearOptions();
+  dhcpPkt.appendOption(DHCPv4Handler::DHCP_MAX_MESSAGE_SIZE, 2, maxSize);
+  dhcpPkt.appendOption(DHCPv4Handler::END, 0, nullptr);
+  dhcpPkt.indexOptions();
+  EXPECT_FALSE(dhcpPkt.getOption(DHCPv4Handler::DHCP_MESSAGE_TYPE, optData));
+  EXPECT_TRUE(dhcpPkt.getOptionUint16(DHCPv4Handler::DHCP_MAX_MESSAGE_SIZE,
+        wideValue));
+  EXPECT_EQ(0x0240, wideValue);
+}
+
 TEST(DHCPv4Handler, pad) {
   auto dhcpPkt = makeDHCPPacket();
   auto origSize = dhcpPkt.size();
@@ -0,0 +1,62 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/packet/DispatchTable.h"
+
+#include <gtest/gtest.h>
+
+#include "fboss/agent/packet/Ethertype.h"
+
+using namespace facebook::fboss;
+
+namespace {
+
+struct Handlers {
+  void ipv4() { ++ipv4Calls; }
+  void ipv6() { ++ipv6Calls; }
+  void arp() { ++arpCalls; }
+
+  int ipv4Calls{0};
+  int ipv6Calls{0};
+  int arpCalls{0};
+};
+
+typedef void (Handlers::*HandlerFn)();
+typedef DispatchTable<uint16_t, HandlerFn, 8> EthertypeTable;
+
+const EthertypeTable kTable = EthertypeTable::make({
+  {ETHERTYPE_IPV4, &Handlers::ipv4},
+  {ETHERTYPE_IPV6, &Handlers::ipv6},
+  {ETHERTYPE_ARP, &Handlers::arp},
+});
+
+} // unnamed namespace
+
+TEST(DispatchTableTest, lookupHit) {
+  Handlers handlers;
+  for (auto key : {ETHERTYPE_IPV4, ETHERTYPE_IPV6, ETHERTYPE_ARP}) {
+    auto handler = kTable.lookup(key);
+    ASSERT_TRUE(handler != nullptr);
+    (handlers.*handler)();
+  }
+  EXPECT_EQ(1, handlers.ipv4Calls);
+  EXPECT_EQ(1, handlers.ipv6Calls);
+  EXPECT_EQ(1, handlers.arpCalls);
+}
+
+TEST(DispatchTableTest, lookupMiss) {
+  // No slot at all for these keys
+  EXPECT_TRUE(kTable.lookup(0) == nullptr);
+  EXPECT_TRUE(kTable.lookup(ETHERTYPE_LLDP) == nullptr);
+  // These fold into the same slots as registered keys, but the stored
+  // key comparison must still reject them
+  for (auto key : {ETHERTYPE_IPV4, ETHERTYPE_IPV6, ETHERTYPE_ARP}) {
+    EXPECT_TRUE(kTable.lookup(key ^ 0x0101) == nullptr);
+  }
+}
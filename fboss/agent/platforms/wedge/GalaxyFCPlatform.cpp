@@ -11,46 +11,49 @@
 #include "fboss/agent/platforms/wedge/GalaxyPort.h"
 #include "fboss/agent/platforms/wedge/WedgePortMapping.h"
 
-using folly::none;
+namespace {
+constexpr auto kNone = facebook::fboss::WedgePortMapping::kNoTransceiver;
+constexpr facebook::fboss::WedgePortMapping::QuadEntry kPorts[] = {
+  {72, kNone},
+  {76, kNone},
+  {68, kNone},
+  {80, kNone},
+  {62, kNone},
+  {58, kNone},
+  {54, kNone},
+  {50, kNone},
+  {110, kNone},
+  {106, kNone},
+  {102, kNone},
+  {114, kNone},
+  {96, kNone},
+  {92, kNone},
+  {84, kNone},
+  {88, kNone},
+  {5, kNone},
+  {9, kNone},
+  {1, kNone},
+  {13, kNone},
+  {130, kNone},
+  {118, kNone},
+  {122, kNone},
+  {126, kNone},
+  {42, kNone},
+  {38, kNone},
+  {29, kNone},
+  {46, kNone},
+  {34, kNone},
+  {21, kNone},
+  {25, kNone},
+  {17, kNone},
+};
+}
 
 namespace facebook { namespace fboss {
 
 std::unique_ptr<WedgePortMapping> GalaxyFCPlatform::createPortMapping() {
-  WedgePortMapping::PortTransceiverMap ports = {
-    {PortID(72), none},
-    {PortID(76), none},
-    {PortID(68), none},
-    {PortID(80), none},
-    {PortID(62), none},
-    {PortID(58), none},
-    {PortID(54), none},
-    {PortID(50), none},
-    {PortID(110), none},
-    {PortID(106), none},
-    {PortID(102), none},
-    {PortID(114), none},
-    {PortID(96), none},
-    {PortID(92), none},
-    {PortID(84), none},
-    {PortID(88), none},
-    {PortID(5), none},
-    {PortID(9), none},
-    {PortID(1), none},
-    {PortID(13), none},
-    {PortID(130), none},
-    {PortID(118), none},
-    {PortID(122), none},
-    {PortID(126), none},
-    {PortID(42), none},
-    {PortID(38), none},
-    {PortID(29), none},
-    {PortID(46), none},
-    {PortID(34), none},
-    {PortID(21), none},
-    {PortID(25), none},
-    {PortID(17), none},
-  };
-  return WedgePortMapping::create<WedgePortMappingT<GalaxyPort>>(this, ports);
+  return WedgePortMapping::create<WedgePortMappingT<GalaxyPort>>(
+      this, folly::range(kPorts));
 }
 
 }} // namespace facebook::fboss
@@ -11,46 +11,49 @@
 #include "fboss/agent/platforms/wedge/Wedge40Port.h"
 #include "fboss/agent/platforms/wedge/WedgePortMapping.h"
 
-using folly::none;
+namespace {
+constexpr auto kNone = facebook::fboss::WedgePortMapping::kNoTransceiver;
+constexpr facebook::fboss::WedgePortMapping::QuadEntry kPorts[] = {
+  {1, kNone},
+  {5, kNone},
+  {9, kNone},
+  {13, kNone},
+  {17, kNone},
+  {21, kNone},
+  {25, kNone},
+  {29, kNone},
+  {33, kNone},
+  {37, kNone},
+  {41, kNone},
+  {45, kNone},
+  {49, kNone},
+  {53, kNone},
+  {57, kNone},
+  {61, kNone},
+  {65, kNone},
+  {69, kNone},
+  {73, kNone},
+  {77, kNone},
+  {81, kNone},
+  {85, kNone},
+  {89, kNone},
+  {93, kNone},
+  {97, kNone},
+  {101, kNone},
+  {105, kNone},
+  {109, kNone},
+  {113, kNone},
+  {117, kNone},
+  {121, kNone},
+  {125, kNone}
+};
+}
 
 namespace facebook { namespace fboss {
 
 std::unique_ptr<WedgePortMapping> SixpackFCPlatform::createPortMapping() {
-  WedgePortMapping::PortTransceiverMap ports = {
-    {PortID(1), none},
-    {PortID(5), none},
-    {PortID(9), none},
-    {PortID(13), none},
-    {PortID(17), none},
-    {PortID(21), none},
-    {PortID(25), none},
-    {PortID(29), none},
-    {PortID(33), none},
-    {PortID(37), none},
-    {PortID(41), none},
-    {PortID(45), none},
-    {PortID(49), none},
-    {PortID(53), none},
-    {PortID(57), none},
-    {PortID(61), none},
-    {PortID(65), none},
-    {PortID(69), none},
-    {PortID(73), none},
-    {PortID(77), none},
-    {PortID(81), none},
-    {PortID(85), none},
-    {PortID(89), none},
-    {PortID(93), none},
-    {PortID(97), none},
-    {PortID(101), none},
-    {PortID(105), none},
-    {PortID(109), none},
-    {PortID(113), none},
-    {PortID(117), none},
-    {PortID(121), none},
-    {PortID(125), none}
-  };
-  return WedgePortMapping::create<WedgePortMappingT<Wedge40Port>>(this, ports);
+  return WedgePortMapping::create<WedgePortMappingT<Wedge40Port>>(
+      this, folly::range(kPorts));
 }
 
 }} // namespace facebook::fboss
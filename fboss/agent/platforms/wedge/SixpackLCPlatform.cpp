@@ -11,46 +11,49 @@
 #include "fboss/agent/platforms/wedge/Wedge40Port.h"
 #include "fboss/agent/platforms/wedge/WedgePortMapping.h"
 
-using folly::none;
+namespace {
+constexpr auto kNone = facebook::fboss::WedgePortMapping::kNoTransceiver;
+constexpr facebook::fboss::WedgePortMapping::QuadEntry kPorts[] = {
+  {1, 0},
+  {5, 1},
+  {9, 2},
+  {13, 3},
+  {17, 4},
+  {21, 5},
+  {25, 6},
+  {29, 7},
+  {33, 8},
+  {37, 9},
+  {41, 10},
+  {45, 11},
+  {49, 12},
+  {53, 13},
+  {57, 14},
+  {61, 15},
+  {65, kNone},
+  {69, kNone},
+  {73, kNone},
+  {77, kNone},
+  {81, kNone},
+  {85, kNone},
+  {89, kNone},
+  {93, kNone},
+  {97, kNone},
+  {101, kNone},
+  {105, kNone},
+  {109, kNone},
+  {113, kNone},
+  {117, kNone},
+  {121, kNone},
+  {125, kNone}
+};
+}
 
 namespace facebook { namespace fboss {
 
 std::unique_ptr<WedgePortMapping> SixpackLCPlatform::createPortMapping() {
-  WedgePortMapping::PortTransceiverMap ports = {
-    {PortID(1), TransceiverID(0)},
-    {PortID(5), TransceiverID(1)},
-    {PortID(9), TransceiverID(2)},
-    {PortID(13), TransceiverID(3)},
-    {PortID(17), TransceiverID(4)},
-    {PortID(21), TransceiverID(5)},
-    {PortID(25), TransceiverID(6)},
-    {PortID(29), TransceiverID(7)},
-    {PortID(33), TransceiverID(8)},
-    {PortID(37), TransceiverID(9)},
-    {PortID(41), TransceiverID(10)},
-    {PortID(45), TransceiverID(11)},
-    {PortID(49), TransceiverID(12)},
-    {PortID(53), TransceiverID(13)},
-    {PortID(57), TransceiverID(14)},
-    {PortID(61), TransceiverID(15)},
-    {PortID(65), none},
-    {PortID(69), none},
-    {PortID(73), none},
-    {PortID(77), none},
-    {PortID(81), none},
-    {PortID(85), none},
-    {PortID(89), none},
-    {PortID(93), none},
-    {PortID(97), none},
-    {PortID(101), none},
-    {PortID(105), none},
-    {PortID(109), none},
-    {PortID(113), none},
-    {PortID(117), none},
-    {PortID(121), none},
-    {PortID(125), none}
-  };
-  return WedgePortMapping::create<WedgePortMappingT<Wedge40Port>>(this, ports);
+  return WedgePortMapping::create<WedgePortMappingT<Wedge40Port>>(
+      this, folly::range(kPorts));
 }
 
 }} // namespace facebook::fboss
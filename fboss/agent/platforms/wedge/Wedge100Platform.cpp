@@ -17,6 +17,43 @@
 
 #include <folly/Memory.h>
 
+namespace {
+constexpr facebook::fboss::WedgePortMapping::QuadEntry kPorts[] = {
+  {118, 0},
+  {122, 1},
+  {126, 2},
+  {130, 3},
+  {1, 4},
+  {5, 5},
+  {9, 6},
+  {13, 7},
+  {17, 8},
+  {21, 9},
+  {25, 10},
+  {29, 11},
+  {34, 12},
+  {38, 13},
+  {42, 14},
+  {46, 15},
+  {50, 16},
+  {54, 17},
+  {58, 18},
+  {62, 19},
+  {68, 20},
+  {72, 21},
+  {76, 22},
+  {80, 23},
+  {84, 24},
+  {88, 25},
+  {92, 26},
+  {96, 27},
+  {102, 28},
+  {106, 29},
+  {110, 30},
+  {114, 31}
+};
+}
+
 namespace facebook { namespace fboss {
 
 std::unique_ptr<BaseWedgeI2CBus> Wedge100Platform::getI2CBus() {
@@ -24,41 +61,8 @@ std::unique_ptr<BaseWedgeI2CBus> Wedge100Platform::getI2CBus() {
 }
 
 std::unique_ptr<WedgePortMapping> Wedge100Platform::createPortMapping() {
-  WedgePortMapping::PortTransceiverMap ports = {
-    {PortID(118), TransceiverID(0)},
-    {PortID(122), TransceiverID(1)},
-    {PortID(126), TransceiverID(2)},
-    {PortID(130), TransceiverID(3)},
-    {PortID(1), TransceiverID(4)},
-    {PortID(5), TransceiverID(5)},
-    {PortID(9), TransceiverID(6)},
-    {PortID(13), TransceiverID(7)},
-    {PortID(17), TransceiverID(8)},
-    {PortID(21), TransceiverID(9)},
-    {PortID(25), TransceiverID(10)},
-    {PortID(29), TransceiverID(11)},
-    {PortID(34), TransceiverID(12)},
-    {PortID(38), TransceiverID(13)},
-    {PortID(42), TransceiverID(14)},
-    {PortID(46), TransceiverID(15)},
-    {PortID(50), TransceiverID(16)},
-    {PortID(54), TransceiverID(17)},
-    {PortID(58), TransceiverID(18)},
-    {PortID(62), TransceiverID(19)},
-    {PortID(68), TransceiverID(20)},
-    {PortID(72), TransceiverID(21)},
-    {PortID(76), TransceiverID(22)},
-    {PortID(80), TransceiverID(23)},
-    {PortID(84), TransceiverID(24)},
-    {PortID(88), TransceiverID(25)},
-    {PortID(92), TransceiverID(26)},
-    {PortID(96), TransceiverID(27)},
-    {PortID(102), TransceiverID(28)},
-    {PortID(106), TransceiverID(29)},
-    {PortID(110), TransceiverID(30)},
-    {PortID(114), TransceiverID(31)}
-  };
-  return WedgePortMapping::create<WedgePortMappingT<Wedge100Port>>(this, ports);
+  return WedgePortMapping::create<WedgePortMappingT<Wedge100Port>>(
+      this, folly::range(kPorts));
 }
 
 void Wedge100Platform::enableLedMode() {
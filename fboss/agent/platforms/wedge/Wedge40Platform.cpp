@@ -11,28 +11,32 @@
 #include "fboss/agent/platforms/wedge/Wedge40Port.h"
 #include "fboss/agent/platforms/wedge/WedgePortMapping.h"
 
+namespace {
+constexpr facebook::fboss::WedgePortMapping::QuadEntry kPorts[] = {
+  {1, 0},
+  {5, 1},
+  {9, 2},
+  {13, 3},
+  {17, 4},
+  {21, 5},
+  {25, 6},
+  {29, 7},
+  {33, 8},
+  {37, 9},
+  {41, 10},
+  {45, 11},
+  {49, 12},
+  {53, 13},
+  {57, 14},
+  {61, 15}
+};
+}
+
 namespace facebook { namespace fboss {
 
 std::unique_ptr<WedgePortMapping> Wedge40Platform::createPortMapping() {
-  const WedgePortMapping::PortTransceiverMap ports = {
-    {PortID(1), TransceiverID(0)},
-    {PortID(5), TransceiverID(1)},
-    {PortID(9), TransceiverID(2)},
-    {PortID(13), TransceiverID(3)},
-    {PortID(17), TransceiverID(4)},
-    {PortID(21), TransceiverID(5)},
-    {PortID(25), TransceiverID(6)},
-    {PortID(29), TransceiverID(7)},
-    {PortID(33), TransceiverID(8)},
-    {PortID(37), TransceiverID(9)},
-    {PortID(41), TransceiverID(10)},
-    {PortID(45), TransceiverID(11)},
-    {PortID(49), TransceiverID(12)},
-    {PortID(53), TransceiverID(13)},
-    {PortID(57), TransceiverID(14)},
-    {PortID(61), TransceiverID(15)}
-  };
-  return WedgePortMapping::create<WedgePortMappingT<Wedge40Port>>(this, ports);
+  return WedgePortMapping::create<WedgePortMappingT<Wedge40Port>>(
+      this, folly::range(kPorts));
 }
 
 }} // namespace facebook::fboss
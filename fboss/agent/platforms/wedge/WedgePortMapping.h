@@ -16,23 +16,39 @@
 
 #include <boost/container/flat_map.hpp>
 #include <folly/Optional.h>
+#include <folly/Range.h>
+
+#include <cstdint>
 
 namespace facebook { namespace fboss {
 
 /*
  * This class begins encapsulating all port mapping logic in a more
- * organized manner. The main mechanism for this is the
- * PortTransceiverMap type that we pass in to the constructor. This
- * map defines every quad in the system (set of 4 contiguous related
- * ports that share a SerDes), and the corresponding front panel port
- * (TransceiverID) if it exists. If a quad is a backplane port and is
- * not associated w/ any transceiver, the value should be nullptr.
+ * organized manner. The main mechanism for this is the QuadEntry
+ * table that we pass in to create(). The table defines every quad in
+ * the system (set of 4 contiguous related ports that share a SerDes),
+ * and the corresponding front panel port (transceiver) if it exists.
+ * If a quad is a backplane port and is not associated w/ any
+ * transceiver, the entry should use kNoTransceiver.
  */
 class WedgePortMapping {
  public:
   enum : uint8_t { CHANNELS_IN_QSFP = 4 };
 
-  typedef std::map<PortID, folly::Optional<TransceiverID>> PortTransceiverMap;
+  /*
+   * One quad of a per-platform port table: the logical port of the
+   * first channel and the front panel transceiver it maps to. The
+   * entries use plain integers rather than PortID/TransceiverID so
+   * each platform's table can be a file-scope constexpr array, built
+   * into .rodata at compile time instead of constructed (as a
+   * temporary std::map, previously) on every cold boot.
+   */
+  struct QuadEntry {
+    uint16_t port;
+    int16_t transceiver;
+  };
+  static constexpr int16_t kNoTransceiver = -1;
+
   typedef boost::container::flat_map<
     PortID, std::unique_ptr<WedgePort>>::iterator MappingIterator;
   typedef boost::container::flat_map<
@@ -43,10 +59,14 @@ class WedgePortMapping {
 
   template<typename MappingT>
   static std::unique_ptr<WedgePortMapping> create(
-      WedgePlatform* platform, const PortTransceiverMap& portMapping) {
+      WedgePlatform* platform, folly::Range<const QuadEntry*> quads) {
     auto mapping = std::make_unique<MappingT>(platform);
-    for (auto& kv : portMapping) {
-      mapping->addQuad(kv.first, kv.second);
+    for (const auto& quad : quads) {
+      folly::Optional<TransceiverID> frontPanel;
+      if (quad.transceiver != kNoTransceiver) {
+        frontPanel = TransceiverID(quad.transceiver);
+      }
+      mapping->addQuad(PortID(quad.port), frontPanel);
     }
     return std::move(mapping);
   }
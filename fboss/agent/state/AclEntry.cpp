@@ -283,6 +283,66 @@ void AclEntryFields::checkFollyDynamic(const folly::dynamic& aclEntryJson) {
   }
 }
 
+bool AclEntry::matches(const AclPacketFields& pkt) const {
+  const auto& fields = *getFields();
+  if (fields.srcIp.first &&
+      (!pkt.srcIp ||
+       !pkt.srcIp.inSubnet(fields.srcIp.first, fields.srcIp.second))) {
+    return false;
+  }
+  if (fields.dstIp.first &&
+      (!pkt.dstIp ||
+       !pkt.dstIp.inSubnet(fields.dstIp.first, fields.dstIp.second))) {
+    return false;
+  }
+  if (fields.proto && fields.proto != pkt.proto) {
+    return false;
+  }
+  if (fields.tcpFlags || fields.tcpFlagsMask) {
+    // An entry with flags but no mask requires all of its flags to be set.
+    uint8_t mask = fields.tcpFlagsMask ? fields.tcpFlagsMask : fields.tcpFlags;
+    if ((pkt.tcpFlags & mask) != (fields.tcpFlags & mask)) {
+      return false;
+    }
+  }
+  if (fields.srcPort != AclEntryFields::kInvalidPhysicalPort &&
+      (!pkt.srcPort || *pkt.srcPort != fields.srcPort)) {
+    return false;
+  }
+  if (fields.dstPort != AclEntryFields::kInvalidPhysicalPort &&
+      (!pkt.dstPort || *pkt.dstPort != fields.dstPort)) {
+    return false;
+  }
+  if (fields.srcL4PortRange &&
+      (!pkt.l4SrcPort ||
+       *pkt.l4SrcPort < fields.srcL4PortRange->getMin() ||
+       *pkt.l4SrcPort > fields.srcL4PortRange->getMax())) {
+    return false;
+  }
+  if (fields.dstL4PortRange &&
+      (!pkt.l4DstPort ||
+       *pkt.l4DstPort < fields.dstL4PortRange->getMin() ||
+       *pkt.l4DstPort > fields.dstL4PortRange->getMax())) {
+    return false;
+  }
+  if (fields.pktLenRange &&
+      (!pkt.pktLen ||
+       *pkt.pktLen < fields.pktLenRange->getMin() ||
+       *pkt.pktLen > fields.pktLenRange->getMax())) {
+    return false;
+  }
+  if (fields.ipFrag && fields.ipFrag != pkt.ipFrag) {
+    return false;
+  }
+  if (fields.icmpType && fields.icmpType != pkt.icmpType) {
+    return false;
+  }
+  if (fields.icmpCode && fields.icmpCode != pkt.icmpCode) {
+    return false;
+  }
+  return true;
+}
+
 AclEntry::AclEntry(AclEntryID id)
   : NodeBaseT(id) {
 }
@@ -161,6 +161,28 @@ struct AclEntryFields {
   cfg::AclAction action{cfg::AclAction::PERMIT};
 };
 
+/*
+ * The packet fields a software ACL classification consults.
+ *
+ * Fields left at their defaults (or unset optionals) are treated as
+ * "not supplied": an entry that qualifies on such a field will not
+ * match the packet.
+ */
+struct AclPacketFields {
+  folly::IPAddress srcIp;
+  folly::IPAddress dstIp;
+  uint8_t proto{0};
+  uint8_t tcpFlags{0};
+  folly::Optional<uint16_t> srcPort{folly::none};
+  folly::Optional<uint16_t> dstPort{folly::none};
+  folly::Optional<uint16_t> l4SrcPort{folly::none};
+  folly::Optional<uint16_t> l4DstPort{folly::none};
+  folly::Optional<uint16_t> pktLen{folly::none};
+  folly::Optional<cfg::IpFragMatch> ipFrag{folly::none};
+  folly::Optional<uint8_t> icmpType{folly::none};
+  folly::Optional<uint8_t> icmpCode{folly::none};
+};
+
 /*
  * AclEntry stores state about one of the access control entries on
  * the switch.
@@ -318,10 +340,22 @@ class AclEntry :
     writableFields()->icmpType = type;
   }
 
+  /*
+   * Returns true if every qualifier configured on this entry matches the
+   * given packet fields. Used by the software classification path in
+   * AclMap and for validating configs against sample packets.
+   */
+  bool matches(const AclPacketFields& pkt) const;
+
  private:
   // Inherit the constructors required for clone()
   using NodeBaseT::NodeBaseT;
   friend class CloneAllocator;
 };
 
+// Config reloads rebuild ACL entries from scratch; fingerprint them at
+// publish so rebuilt-but-identical entries don't show up in deltas
+template <>
+struct NodeUsesFingerprint<AclEntry> : std::true_type {};
+
 }} // facebook::fboss
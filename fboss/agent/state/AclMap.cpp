@@ -9,6 +9,7 @@
  */
 #include "fboss/agent/state/AclMap.h"
 
+#include "fboss/agent/state/AclEntry.h"
 #include "fboss/agent/state/NodeMap-defs.h"
 
 namespace facebook { namespace fboss {
@@ -19,6 +20,53 @@ AclMap::AclMap() {
 AclMap::~AclMap() {
 }
 
+std::shared_ptr<AclEntry> AclMap::getMatchingEntryIf(
+    const AclPacketFields& pkt) const {
+  if (!isPublished()) {
+    // NodeMap iteration is in ID order, which is the match priority.
+    for (auto itr = begin(); itr != end(); ++itr) {
+      if ((*itr)->matches(pkt)) {
+        return *itr;
+      }
+    }
+    return nullptr;
+  }
+  static const EntryList emptyEntries;
+  const auto bucketItr = proto2Entries_.find(pkt.proto);
+  const auto& protoEntries =
+    bucketItr == proto2Entries_.end() ? emptyEntries : bucketItr->second;
+  // Merge-walk the two ID-sorted buckets in priority order.
+  auto pItr = protoEntries.begin();
+  auto aItr = anyProtoEntries_.begin();
+  while (pItr != protoEntries.end() || aItr != anyProtoEntries_.end()) {
+    const std::shared_ptr<AclEntry>* candidate;
+    if (aItr == anyProtoEntries_.end() ||
+        (pItr != protoEntries.end() && (*pItr)->getID() < (*aItr)->getID())) {
+      candidate = &*pItr++;
+    } else {
+      candidate = &*aItr++;
+    }
+    if ((*candidate)->matches(pkt)) {
+      return *candidate;
+    }
+  }
+  return nullptr;
+}
+
+void AclMap::publishSelf() {
+  proto2Entries_.clear();
+  anyProtoEntries_.clear();
+  for (auto itr = begin(); itr != end(); ++itr) {
+    const auto& entry = *itr;
+    if (entry->getProto()) {
+      proto2Entries_[entry->getProto()].push_back(entry);
+    } else {
+      anyProtoEntries_.push_back(entry);
+    }
+  }
+  NodeMapT::publishSelf();
+}
+
 FBOSS_INSTANTIATE_NODE_MAP(AclMap, AclMapTraits);
 
 }} // facebook::fboss
@@ -9,12 +9,16 @@
  */
 #pragma once
 
+#include <vector>
+#include <boost/container/flat_map.hpp>
+
 #include "fboss/agent/types.h"
 #include "fboss/agent/state/NodeMap.h"
 
 namespace facebook { namespace fboss {
 
 class AclEntry;
+struct AclPacketFields;
 using AclMapTraits = NodeMapTraits<AclEntryID, AclEntry>;
 
 /*
@@ -48,7 +52,33 @@ class AclMap : public NodeMapT<AclMap, AclMapTraits> {
     addNode(aclEntry);
   }
 
+  /*
+   * Find the highest priority (lowest ID) entry matching the given packet
+   * fields, or null if no entry matches. On published maps this consults
+   * a matcher compiled at publish() time, which partitions the entries by
+   * their IP protocol qualifier so a lookup only evaluates entries that
+   * could match the packet's protocol; unpublished maps are walked
+   * linearly in ID order.
+   */
+  std::shared_ptr<AclEntry> getMatchingEntryIf(
+      const AclPacketFields& pkt) const;
+
+  /*
+   * Compile the lookup structures for getMatchingEntryIf() before marking
+   * the map immutable. Clones start with empty structures and rebuild
+   * them when they are published in turn.
+   */
+  void publishSelf() override;
+
  private:
+  // Entries bucketed by their IP protocol qualifier, plus the entries
+  // that do not qualify on protocol. Buckets are in ID (priority) order;
+  // a lookup merge-walks the packet's protocol bucket with the wildcard
+  // bucket, so entries are still evaluated in priority order.
+  using EntryList = std::vector<std::shared_ptr<AclEntry>>;
+  boost::container::flat_map<uint8_t, EntryList> proto2Entries_;
+  EntryList anyProtoEntries_;
+
   // Inherit the constructors required for clone()
   using NodeMapT::NodeMapT;
   friend class CloneAllocator;
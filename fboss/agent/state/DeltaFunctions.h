@@ -9,9 +9,15 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <exception>
 #include <memory>
+#include <thread>
 #include <type_traits>
+#include <vector>
+
+#include <glog/logging.h>
 
 namespace facebook { namespace fboss {
 /*
@@ -69,6 +75,131 @@ forEachChanged(const Delta& delta,
   return LoopAction::CONTINUE;
 }
 
+/*
+ * Invoke the specified functions for each modified, added, and removed
+ * node, splitting the walk across several threads.
+ *
+ * The union of the old and new key spaces is divided into contiguous
+ * chunks and each chunk is walked with the same merge-style iteration
+ * as forEachChanged(), so every change is seen exactly once, in key
+ * order within its chunk. Chunks run concurrently: the supplied
+ * functions (and whatever they touch) must be thread safe. Early
+ * termination via LoopAction::BREAK is not supported.
+ *
+ * Deltas too small to be worth the thread handoff are processed inline
+ * on the calling thread, as are deltas where one side is missing.
+ */
+template<typename Delta,
+         typename ChangedFn, typename AddFn, typename RemoveFn,
+         typename... Args>
+detail::EnableIfChangedAddRmFn<ChangedFn, AddFn, RemoveFn,
+                               typename Delta::Node, Args...>
+forEachChangedParallel(const Delta& delta,
+                       uint32_t numThreads,
+                       ChangedFn changedFn,
+                       AddFn addedFn,
+                       RemoveFn removedFn,
+                       const Args&... args) {
+  // Below this many entries per thread the merge walk is cheaper than
+  // spawning workers.
+  constexpr size_t kMinEntriesPerThread = 512;
+
+  const auto* oldMap = delta.getOld();
+  const auto* newMap = delta.getNew();
+  if (oldMap == newMap) {
+    return LoopAction::CONTINUE;
+  }
+
+  using NodeContainer = typename Delta::MapType::NodeContainer;
+  static const NodeContainer emptyNodes;
+  const auto& oldNodes = oldMap ? oldMap->getAllNodes() : emptyNodes;
+  const auto& newNodes = newMap ? newMap->getAllNodes() : emptyNodes;
+
+  auto processRange = [&](typename NodeContainer::const_iterator oldIt,
+                          typename NodeContainer::const_iterator oldEnd,
+                          typename NodeContainer::const_iterator newIt,
+                          typename NodeContainer::const_iterator newEnd) {
+    while (oldIt != oldEnd || newIt != newEnd) {
+      LoopAction action;
+      if (oldIt == oldEnd) {
+        action = detail::invokeFn(addedFn, args..., newIt->second);
+        ++newIt;
+      } else if (newIt == newEnd) {
+        action = detail::invokeFn(removedFn, args..., oldIt->second);
+        ++oldIt;
+      } else if (oldIt->first < newIt->first) {
+        action = detail::invokeFn(removedFn, args..., oldIt->second);
+        ++oldIt;
+      } else if (newIt->first < oldIt->first) {
+        action = detail::invokeFn(addedFn, args..., newIt->second);
+        ++newIt;
+      } else {
+        if (oldIt->second != newIt->second) {
+          action = detail::invokeFn(changedFn, args...,
+                                    oldIt->second, newIt->second);
+        } else {
+          action = LoopAction::CONTINUE;
+        }
+        ++oldIt;
+        ++newIt;
+      }
+      CHECK(action == LoopAction::CONTINUE)
+          << "LoopAction::BREAK is not supported by forEachChangedParallel()";
+    }
+  };
+
+  const auto maxEntries = std::max(oldNodes.size(), newNodes.size());
+  size_t numChunks = std::max<uint32_t>(numThreads, 1);
+  numChunks = std::min(numChunks, maxEntries / kMinEntriesPerThread);
+  if (numChunks <= 1) {
+    processRange(oldNodes.begin(), oldNodes.end(),
+                 newNodes.begin(), newNodes.end());
+    return LoopAction::CONTINUE;
+  }
+
+  // Pick chunk boundary keys from the larger side; lower_bound() maps
+  // them into the other side, so each chunk covers the same contiguous
+  // key range in both maps.
+  const auto& boundarySource =
+      oldNodes.size() >= newNodes.size() ? oldNodes : newNodes;
+  std::vector<std::exception_ptr> exceptions(numChunks);
+  std::vector<std::thread> workers;
+  workers.reserve(numChunks);
+  auto oldBegin = oldNodes.begin();
+  auto newBegin = newNodes.begin();
+  for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+    auto oldEnd = oldNodes.end();
+    auto newEnd = newNodes.end();
+    if (chunk + 1 < numChunks) {
+      const auto& boundaryKey =
+          (boundarySource.begin() +
+           (chunk + 1) * boundarySource.size() / numChunks)->first;
+      oldEnd = oldNodes.lower_bound(boundaryKey);
+      newEnd = newNodes.lower_bound(boundaryKey);
+    }
+    workers.emplace_back(
+        [&processRange, &exceptions, chunk,
+         oldBegin, oldEnd, newBegin, newEnd]() {
+      try {
+        processRange(oldBegin, oldEnd, newBegin, newEnd);
+      } catch (...) {
+        exceptions[chunk] = std::current_exception();
+      }
+    });
+    oldBegin = oldEnd;
+    newBegin = newEnd;
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  for (const auto& exception : exceptions) {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+  return LoopAction::CONTINUE;
+}
+
 /*
  * Invoke the specified function for each modified node.
  */
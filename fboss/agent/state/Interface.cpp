@@ -59,7 +59,7 @@ folly::dynamic InterfaceFields::toFollyDynamic() const {
   intf[kIntfId] = static_cast<uint32_t>(id);
   intf[kRouterId] = static_cast<uint32_t>(routerID);
   intf[kVlanId] = static_cast<uint16_t>(vlanID);
-  intf[kName] = name;
+  intf[kName] = name.str();
   intf[kMac] = to<string>(mac);
   intf[kMtu] = to<string>(mtu);
   intf[kIsVirtual] = to<string>(isVirtual);
@@ -9,6 +9,7 @@
  */
 #pragma once
 
+#include "fboss/agent/InternedString.h"
 #include "fboss/agent/gen-cpp2/switch_config_types.h"
 #include "fboss/agent/types.h"
 #include "fboss/agent/state/NodeBase.h"
@@ -37,7 +38,7 @@ struct InterfaceFields {
       : id(id),
         routerID(router),
         vlanID(vlan),
-        name(name.data(), name.size()),
+        name(InternedString::intern(name)),
         mac(mac),
         mtu(mtu),
         isVirtual(isVirtual) {}
@@ -57,7 +58,8 @@ struct InterfaceFields {
   const InterfaceID id;
   RouterID routerID;
   VlanID vlanID;
-  std::string name;
+  // Interned: interface names come from config, a bounded vocabulary
+  InternedString name;
   folly::MacAddress mac;
   Addresses addrs;
   cfg::NdpConfig ndp;
@@ -123,10 +125,10 @@ class Interface : public NodeBaseT<Interface, InterfaceFields> {
   }
 
   const std::string& getName() const {
-    return getFields()->name;
+    return getFields()->name.str();
   }
   void setName(const std::string& name) {
-    writableFields()->name = name;
+    writableFields()->name = InternedString::intern(name);
   }
 
   folly::MacAddress getMac() const {
@@ -194,4 +196,9 @@ class Interface : public NodeBaseT<Interface, InterfaceFields> {
   friend class CloneAllocator;
 };
 
+// Config reloads rebuild interfaces from scratch; fingerprint them at
+// publish so rebuilt-but-identical interfaces don't show up in deltas
+template <>
+struct NodeUsesFingerprint<Interface> : std::true_type {};
+
 }} // facebook::fboss
@@ -46,6 +46,10 @@ InterfaceMap::getInterface(RouterID router, const IPAddress& ip) const {
 
 std::shared_ptr<Interface>
 InterfaceMap::getInterfaceInVlanIf(VlanID vlan) const {
+  if (isPublished()) {
+    auto itr = vlan2Interface_.find(vlan);
+    return itr == vlan2Interface_.end() ? nullptr : itr->second;
+  }
   for (auto itr = begin(); itr != end(); ++itr) {
     if ((*itr)->getVlanID() == vlan ) {
       return *itr;
@@ -65,6 +69,17 @@ InterfaceMap::getInterfaceInVlan(VlanID vlan) const {
 
 InterfaceMap::IntfAddrToReach InterfaceMap::getIntfAddrToReach(
     RouterID router, const folly::IPAddress& dest) const {
+  if (isPublished()) {
+    auto treeItr = routerToSubnets_.find(router);
+    if (treeItr != routerToSubnets_.end()) {
+      auto match = treeItr->second.longestMatch(dest, dest.bitCount());
+      if (match != treeItr->second.end()) {
+        const auto& entry = match->value();
+        return IntfAddrToReach(entry.intf, entry.addr, entry.mask);
+      }
+    }
+    return IntfAddrToReach(nullptr, nullptr, 0);
+  }
   for (auto iter = begin(); iter != end(); iter++) {
     const auto& intf = *iter;
     if (intf->getRouterID() == router) {
@@ -77,6 +92,26 @@ InterfaceMap::IntfAddrToReach InterfaceMap::getIntfAddrToReach(
   return IntfAddrToReach(nullptr, nullptr, 0);
 }
 
+void InterfaceMap::publishSelf() {
+  // Build the indexes before marking the map published. Entries are added
+  // in InterfaceID order, and emplace() keeps the first entry for a key,
+  // so duplicate VLANs and overlapping subnets resolve to the same
+  // interface the linear scans would have picked.
+  vlan2Interface_.clear();
+  routerToSubnets_.clear();
+  for (auto itr = begin(); itr != end(); ++itr) {
+    const auto& intf = *itr;
+    vlan2Interface_.emplace(intf->getVlanID(), intf);
+    auto& subnets = routerToSubnets_[intf->getRouterID()];
+    for (const auto& addrAndMask : intf->getAddresses()) {
+      subnets.insert(
+          addrAndMask.first.mask(addrAndMask.second), addrAndMask.second,
+          IntfAddrEntry(intf.get(), &addrAndMask.first, addrAndMask.second));
+    }
+  }
+  NodeMapT::publishSelf();
+}
+
 folly::dynamic InterfaceMap::toFollyDynamic() const {
   folly::dynamic intfs = folly::dynamic::array;
   for (const auto& intf: *this) {
@@ -9,9 +9,11 @@
  */
 #pragma once
 #include <vector>
+#include <boost/container/flat_map.hpp>
 #include <folly/IPAddress.h>
 #include "fboss/agent/types.h"
 #include "fboss/agent/state/NodeMap.h"
+#include "fboss/lib/RadixTree.h"
 namespace facebook { namespace fboss {
 
 class Interface;
@@ -114,7 +116,37 @@ class InterfaceMap : public NodeMapT<InterfaceMap, InterfaceMapTraits> {
     return fromFollyDynamic(folly::parseJson(jsonStr));
   }
 
+  /*
+   * Build the derived lookup indexes before marking the map (and its
+   * interfaces) immutable. getInterfaceInVlanIf() and getIntfAddrToReach()
+   * are called from per-packet paths, and scanning every interface there
+   * is measurable once the interface count grows. The indexes are built
+   * once per published version and shared read-only with it; clones start
+   * with empty indexes and rebuild them when they are published in turn.
+   */
+  void publishSelf() override;
+
  private:
+  // Value stored in the subnet index. The pointers reference the owning
+  // Interface node and its address entry, which are immutable for as long
+  // as this published map version is alive.
+  struct IntfAddrEntry {
+    IntfAddrEntry(const Interface* intf, const folly::IPAddress* addr,
+                  uint8_t mask) : intf(intf), addr(addr), mask(mask) {}
+    const Interface* intf{nullptr};
+    const folly::IPAddress* addr{nullptr};
+    uint8_t mask{0};
+  };
+  using VlanIndex =
+      boost::container::flat_map<VlanID, std::shared_ptr<Interface>>;
+  using SubnetIndex = boost::container::flat_map<
+      RouterID, facebook::network::RadixTree<folly::IPAddress, IntfAddrEntry>>;
+
+  // Derived indexes, valid only once the map is published. Queries on
+  // unpublished maps fall back to a linear scan.
+  VlanIndex vlan2Interface_;
+  SubnetIndex routerToSubnets_;
+
   // Inherit the constructors required for clone()
   using NodeMapT::NodeMapT;
   friend class CloneAllocator;
@@ -11,6 +11,7 @@
 
 #include <folly/MacAddress.h>
 #include <folly/Optional.h>
+#include "fboss/agent/AddressUtil.h"
 #include "fboss/agent/state/NodeBase.h"
 
 #include <boost/container/flat_map.hpp>
@@ -48,7 +49,10 @@ struct NeighborResponseEntry {
 template<typename IPADDR>
 struct NeighborResponseTableFields {
   typedef IPADDR AddressType;
-  typedef boost::container::flat_map<AddressType, NeighborResponseEntry> Table;
+  // Ordered with the fixed-width comparison kernel rather than the
+  // generic bytewise operator<, since these tables are probed per packet
+  typedef boost::container::flat_map<AddressType, NeighborResponseEntry,
+                                     AddressLessFast> Table;
 
   NeighborResponseTableFields() {}
   explicit NeighborResponseTableFields(Table&& t) : table(std::move(t)) {}
@@ -72,12 +72,19 @@ void NeighborTable<IPADDR, ENTRY, SUBCLASS>::updateEntry(
   if (it == nodes.end()) {
     throw FbossError("Neighbor entry for ", ip, " does not exist");
   }
-  auto entry = it->second->clone();
+  // Only clone the entry if it is still shared with a published
+  // generation; repeated updates to the same neighbor within one state
+  // update batch mutate the already-cloned entry in place.
+  auto* entry = it->second.get();
+  if (entry->isPublished()) {
+    auto newEntry = entry->clone();
+    entry = newEntry.get();
+    it->second = std::move(newEntry);
+  }
   entry->setMAC(mac);
   entry->setPort(port);
   entry->setIntfID(intfID);
   entry->setState(NeighborState::REACHABLE);
-  it->second = entry;
 }
 
 template<typename IPADDR, typename ENTRY, typename SUBCLASS>
@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include "fboss/agent/state/NodeCloneProfiler.h"
+
 #include "fboss/agent/state/AclEntry.h"
 #include "fboss/agent/state/AclMap.h"
 #include "fboss/agent/state/Port.h"
@@ -24,9 +26,22 @@ namespace facebook { namespace fboss {
 
 template<typename NodeT, typename FieldsT>
 std::shared_ptr<NodeT> NodeBaseT<NodeT, FieldsT>::clone() const {
+  noteNodeClone<NodeT>();
   return std::allocate_shared<NodeT>(CloneAllocator(), self());
 }
 
+template<typename NodeT, typename FieldsT>
+void NodeBaseT<NodeT, FieldsT>::publishSelf() {
+  if (isPublished()) {
+    return;
+  }
+  noteNodePublish<NodeT>();
+  if (NodeUsesFingerprint<NodeT>::value) {
+    setFingerprint(computeFingerprint(toFollyDynamic()));
+  }
+  NodeBase::publish();
+}
+
 template<typename NodeT, typename FieldsT>
 void NodeBaseT<NodeT, FieldsT>::publish() {
   if (isPublished()) {
@@ -35,7 +50,7 @@ void NodeBaseT<NodeT, FieldsT>::publish() {
   writableFields()->forEachChild([](NodeBase* child) {
     child->publish();
   });
-  NodeBase::publish();
+  publishSelf();
 }
 
 }} // facebook::fboss
@@ -9,7 +9,10 @@
  */
 #include "fboss/agent/state/NodeBase.h"
 
+#include <folly/Hash.h>
+
 #include <atomic>
+#include <cstring>
 
 namespace {
 std::atomic<uint64_t> nextNodeID;
@@ -19,6 +22,52 @@ namespace facebook { namespace fboss {
 
 NodeBase::NodeBase()
   : nodeID_(nextNodeID.fetch_add(1, std::memory_order_relaxed)) {
+  PublishTracker::noteConstructed(this);
+}
+
+uint64_t computeFingerprint(const folly::dynamic& value) {
+  using folly::dynamic;
+  // Seed with the type so e.g. the integer 1 and the string "1" differ
+  uint64_t seed = folly::hash::twang_mix64(
+      static_cast<uint64_t>(value.type()));
+  switch (value.type()) {
+  case dynamic::NULLT:
+    return seed;
+  case dynamic::BOOL:
+    return folly::hash::hash_128_to_64(seed, value.asBool() ? 1 : 0);
+  case dynamic::INT64:
+    return folly::hash::hash_128_to_64(
+        seed, folly::hash::twang_mix64(static_cast<uint64_t>(value.asInt())));
+  case dynamic::DOUBLE: {
+    double d = value.asDouble();
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return folly::hash::hash_128_to_64(seed, bits);
+  }
+  case dynamic::STRING: {
+    const auto& str = value.getString();
+    return folly::hash::hash_128_to_64(
+        seed, folly::hash::fnv64_buf(str.data(), str.size()));
+  }
+  case dynamic::ARRAY: {
+    uint64_t hash = seed;
+    for (const auto& element: value) {
+      hash = folly::hash::hash_128_to_64(hash, computeFingerprint(element));
+    }
+    return hash;
+  }
+  case dynamic::OBJECT: {
+    // folly::dynamic does not define the iteration order of object keys,
+    // so combine the entries commutatively
+    uint64_t hash = seed;
+    for (const auto& entry: value.items()) {
+      hash += folly::hash::hash_128_to_64(computeFingerprint(entry.first),
+                                          computeFingerprint(entry.second));
+    }
+    return hash;
+  }
+  }
+  return seed;
 }
 
 }} // facebook::fboss
@@ -11,6 +11,8 @@
 
 #include "fboss/agent/types.h"
 #include "fboss/agent/Utils.h"
+#include "fboss/agent/state/NodeCloneProfiler.h"
+#include "fboss/agent/state/PublishTracker.h"
 
 #include <boost/cast.hpp>
 #include <boost/container/flat_map.hpp>
@@ -40,7 +42,9 @@ namespace facebook { namespace fboss {
  */
 class NodeBase {
  public:
-  virtual ~NodeBase() {}
+  virtual ~NodeBase() {
+    PublishTracker::noteDestroyed(this);
+  }
 
   /*
    * Returns if this state is published yet.
@@ -62,6 +66,20 @@ class NodeBase {
     published_ = true;
   }
 
+  /*
+   * Publish this node without descending into its children.
+   *
+   * This is the per-node half of publish(): it performs everything
+   * publish() does for the node itself but skips the recursive child
+   * walk. PublishTracker uses it to publish exactly the set of nodes an
+   * update created, in arbitrary order; nodes whose publish() has
+   * per-node side effects (index building, fingerprinting) implement
+   * them here so both the recursive and the tracked path run them.
+   */
+  virtual void publishSelf() {
+    published_ = true;
+  }
+
   /*
    * Get the generation number for this state object.
    *
@@ -113,18 +131,60 @@ class NodeBase {
     return nodeID_;
   }
 
+  /*
+   * Get the content fingerprint for this node, or 0 if none was computed.
+   *
+   * The fingerprint is a hash of the node's serialized contents, computed
+   * once at publish() for node types that opt in via NodeUsesFingerprint.
+   * Two published nodes with the same non-zero fingerprint hold identical
+   * contents even when they are distinct objects, which lets delta
+   * processing skip nodes that were recreated unchanged (e.g. by a config
+   * reload) instead of reprogramming hardware from them.
+   */
+  uint64_t getFingerprint() const {
+    return fingerprint_;
+  }
+
  protected:
   NodeBase();
   NodeBase(NodeID id, uint32_t generation)
     : nodeID_(id),
-      generation_(generation) {}
+      generation_(generation) {
+    PublishTracker::noteConstructed(this);
+  }
+
+  void setFingerprint(uint64_t fingerprint) {
+    CHECK(!published_);
+    fingerprint_ = fingerprint;
+  }
 
  private:
   NodeID nodeID_{0};
   uint32_t generation_{0};
+  uint64_t fingerprint_{0};
   bool published_{false};
 };
 
+/*
+ * Hash a folly::dynamic into a 64-bit content fingerprint.
+ *
+ * Object entries are combined commutatively, so the result is independent
+ * of key iteration order.
+ */
+uint64_t computeFingerprint(const folly::dynamic& value);
+
+/*
+ * Node types opt into publish-time fingerprinting by specializing this
+ * to std::true_type after their class definition.
+ *
+ * Only opt in leaf-ish nodes whose toFollyDynamic() is cheap: the
+ * fingerprint serializes the node's entire subtree, so enabling it on a
+ * node with large or runtime-churning children (route tables, neighbor
+ * tables) would pay that serialization on every publish of the node.
+ */
+template <typename NodeT>
+struct NodeUsesFingerprint : std::false_type {};
+
 /*
  * NodeBaseT is a helper class for implementing nodes in the SwitchState tree.
  *
@@ -158,7 +218,9 @@ class NodeBaseT : public NodeBase {
   typedef NodeT Node;
   typedef FieldsT Fields;
 
-  ~NodeBaseT() override {}
+  ~NodeBaseT() override {
+    noteNodeDestroy<NodeT>();
+  }
 
   /*
    * Create a new version of the node, cloned from this one.
@@ -194,11 +256,13 @@ class NodeBaseT : public NodeBase {
     std::is_constructible<Fields, const Fields&, Args...>::value,
     std::shared_ptr<Node>>::type
   clone(Args&&... args) const {
+    noteNodeClone<NodeT>();
     return std::allocate_shared<NodeT>(CloneAllocator(), self(),
                                        std::forward<Args>(args)...);
   }
 
   void publish() override;
+  void publishSelf() override;
 
   const Fields* getFields() const {
     return &fields_;
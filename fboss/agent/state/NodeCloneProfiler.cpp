@@ -0,0 +1,88 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/state/NodeCloneProfiler.h"
+
+#include <folly/Demangle.h>
+#include <glog/logging.h>
+
+#include <unordered_map>
+
+namespace facebook { namespace fboss {
+
+NodeCloneProfiler& NodeCloneProfiler::get() {
+  // Intentionally leaked: node destructors report here, and nodes held
+  // by static state can outlive any normally-destroyed singleton.
+  static NodeCloneProfiler* instance = new NodeCloneProfiler();
+  return *instance;
+}
+
+NodeCloneProfiler::Counters& NodeCloneProfiler::counters(
+    const std::type_info& type) {
+  auto name = folly::demangle(type).toStdString();
+  std::lock_guard<std::mutex> g(mutex_);
+  for (auto& entry : entries_) {
+    if (entry.name == name) {
+      return entry.counters;
+    }
+  }
+  entries_.emplace_back();
+  entries_.back().name = std::move(name);
+  return entries_.back().counters;
+}
+
+std::vector<NodeCloneProfiler::Snapshot> NodeCloneProfiler::snapshot(
+    bool clearAfterRead) {
+  std::vector<Snapshot> stats;
+  std::lock_guard<std::mutex> g(mutex_);
+  stats.reserve(entries_.size());
+  for (auto& entry : entries_) {
+    Snapshot s;
+    s.nodeType = entry.name;
+    s.clones = entry.counters.clones.load(std::memory_order_relaxed);
+    s.publishes = entry.counters.publishes.load(std::memory_order_relaxed);
+    s.destroys = entry.counters.destroys.load(std::memory_order_relaxed);
+    s.bytes = entry.counters.bytes.load(std::memory_order_relaxed);
+    stats.push_back(std::move(s));
+    if (clearAfterRead) {
+      entry.counters.clones.store(0, std::memory_order_relaxed);
+      entry.counters.publishes.store(0, std::memory_order_relaxed);
+      entry.counters.destroys.store(0, std::memory_order_relaxed);
+      entry.counters.bytes.store(0, std::memory_order_relaxed);
+    }
+  }
+  return stats;
+}
+
+void NodeCloneProfiler::logDelta(folly::StringPiece label,
+                                 const std::vector<Snapshot>& before,
+                                 const std::vector<Snapshot>& after) {
+  std::unordered_map<std::string, const Snapshot*> prev;
+  for (const auto& s : before) {
+    prev[s.nodeType] = &s;
+  }
+  for (const auto& s : after) {
+    int64_t clones = s.clones;
+    int64_t bytes = s.bytes;
+    int64_t publishes = s.publishes;
+    auto it = prev.find(s.nodeType);
+    if (it != prev.end()) {
+      clones -= it->second->clones;
+      bytes -= it->second->bytes;
+      publishes -= it->second->publishes;
+    }
+    if (clones == 0 && publishes == 0) {
+      continue;
+    }
+    VLOG(0) << "update " << label << ": " << s.nodeType << " cloned "
+            << clones << " (" << bytes << " bytes), published " << publishes;
+  }
+}
+
+}} // facebook::fboss
@@ -0,0 +1,139 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+/*
+ * NodeCloneProfiler accounts for copy-on-write traffic in the
+ * SwitchState tree: how many nodes of each type are cloned, published
+ * and destroyed, and how many bytes those clones allocate.
+ *
+ * The instrumentation is compile-time optional.  Build with
+ * -DFBOSS_PROFILE_NODE_CLONES and NodeBaseT's clone(), publish() and
+ * destructor report into per-type counters; without the define the
+ * hooks compile to nothing and the state tree is untouched.  Counters
+ * are read (and optionally cleared) through the getNodeCloneStats()
+ * Thrift call, and each state update batch logs the per-type delta it
+ * produced, so a slow update can be attributed to the node types it
+ * actually cloned.
+ *
+ * Each node type pays one registry lookup for its first event; after
+ * that the hooks are single relaxed atomic increments, cheap enough to
+ * leave enabled on a dev agent under load.
+ */
+class NodeCloneProfiler {
+ public:
+  struct Counters {
+    std::atomic<uint64_t> clones{0};
+    std::atomic<uint64_t> publishes{0};
+    std::atomic<uint64_t> destroys{0};
+    std::atomic<uint64_t> bytes{0};
+  };
+
+  // A plain copy of one type's counters, for snapshots and the Thrift
+  // layer (which converts it to the NodeCloneStats wire struct).
+  struct Snapshot {
+    std::string nodeType;
+    uint64_t clones{0};
+    uint64_t publishes{0};
+    uint64_t destroys{0};
+    uint64_t bytes{0};
+  };
+
+  static NodeCloneProfiler& get();
+
+  static constexpr bool isEnabled() {
+#ifdef FBOSS_PROFILE_NODE_CLONES
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /*
+   * Get the counters for a node type, registering it on first use.
+   * The returned reference stays valid for the process lifetime.
+   */
+  Counters& counters(const std::type_info& type);
+
+  /*
+   * Take a snapshot of every registered node type, optionally
+   * resetting the counters afterwards.
+   */
+  std::vector<Snapshot> snapshot(bool clearAfterRead = false);
+
+  /*
+   * Log the per-type difference between two snapshots, labeled with
+   * the update that produced it.  Types with no activity are skipped.
+   */
+  static void logDelta(folly::StringPiece label,
+                       const std::vector<Snapshot>& before,
+                       const std::vector<Snapshot>& after);
+
+ private:
+  NodeCloneProfiler() {}
+
+  // Forbidden copy constructor and assignment operator
+  NodeCloneProfiler(NodeCloneProfiler const &) = delete;
+  NodeCloneProfiler& operator=(NodeCloneProfiler const &) = delete;
+
+  struct Entry {
+    std::string name;
+    Counters counters;
+  };
+
+  std::mutex mutex_;
+  // deque so counters never move as new types register
+  std::deque<Entry> entries_;
+};
+
+/*
+ * Hooks called from NodeBaseT.  Each template instantiation resolves
+ * its counters once, through a function-local static.
+ */
+template <typename NodeT>
+inline void noteNodeClone() {
+#ifdef FBOSS_PROFILE_NODE_CLONES
+  static NodeCloneProfiler::Counters& ctrs =
+      NodeCloneProfiler::get().counters(typeid(NodeT));
+  ctrs.clones.fetch_add(1, std::memory_order_relaxed);
+  ctrs.bytes.fetch_add(sizeof(NodeT), std::memory_order_relaxed);
+#endif
+}
+
+template <typename NodeT>
+inline void noteNodePublish() {
+#ifdef FBOSS_PROFILE_NODE_CLONES
+  static NodeCloneProfiler::Counters& ctrs =
+      NodeCloneProfiler::get().counters(typeid(NodeT));
+  ctrs.publishes.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+template <typename NodeT>
+inline void noteNodeDestroy() {
+#ifdef FBOSS_PROFILE_NODE_CLONES
+  static NodeCloneProfiler::Counters& ctrs =
+      NodeCloneProfiler::get().counters(typeid(NodeT));
+  ctrs.destroys.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+}} // facebook::fboss
@@ -63,6 +63,7 @@ class NodeMapDelta {
  public:
   using MapPointerType = typename MAPPOINTERTRAITS::MapPointerType;
   using RawConstPointerType = typename MAPPOINTERTRAITS::RawConstPointerType;
+  using MapType = MAP;
   using Node = typename MAP::Node;
   class Iterator;
 
@@ -185,6 +186,23 @@ class NodeMapDelta<MAP, VALUE, MAPPOINTERTRAITS>::Iterator {
   typedef typename MapType::Iterator InnerIter;
   typedef typename MapType::Traits Traits;
 
+  /*
+   * Whether a pair of nodes at the same position should be skipped as
+   * unchanged. Same pointer always matches; beyond that, nodes that were
+   * recreated with identical contents match via their publish-time
+   * content fingerprints (when their type computes one), so e.g. a
+   * config reload that rebuilds an identical node does not surface it
+   * as a change.
+   */
+  static bool nodesMatch(const std::shared_ptr<Node>& oldNode,
+                         const std::shared_ptr<Node>& newNode) {
+    if (oldNode == newNode) {
+      return true;
+    }
+    auto fingerprint = oldNode->getFingerprint();
+    return fingerprint != 0 && fingerprint == newNode->getFingerprint();
+  }
+
   void advance();
   void updateValue();
 
@@ -48,8 +48,8 @@ PortFields::VlanInfo::fromFollyDynamic(const folly::dynamic& json) {
 folly::dynamic PortFields::toFollyDynamic() const {
   folly::dynamic port = folly::dynamic::object;
   port[kPortId] = static_cast<uint16_t>(id);
-  port[kPortName] = name;
-  port[kPortDescription] = description;
+  port[kPortName] = config->name.str();
+  port[kPortDescription] = config->description.str();
   auto itr_state  = cfg::_PortState_VALUES_TO_NAMES.find(state);
   CHECK(itr_state != cfg::_PortState_VALUES_TO_NAMES.end());
   port[kPortState] = itr_state->second;
@@ -72,8 +72,8 @@ folly::dynamic PortFields::toFollyDynamic() const {
 
 PortFields PortFields::fromFollyDynamic(const folly::dynamic& portJson) {
   PortFields port(PortID(portJson[kPortId].asInt()),
-      portJson[kPortName].asString());
-  port.description = portJson[kPortDescription].asString();
+      portJson[kPortName].asString(),
+      portJson[kPortDescription].asString());
   auto itr_state  = cfg::_PortState_NAMES_TO_VALUES.find(
       StateUtils::getCpp2EnumName(portJson[kPortState].asString()).c_str());
   CHECK(itr_state != cfg::_PortState_NAMES_TO_VALUES.end());
@@ -9,11 +9,13 @@
  */
 #pragma once
 
+#include "fboss/agent/InternedString.h"
 #include "fboss/agent/gen-cpp2/switch_config_types.h"
 #include "fboss/agent/types.h"
 #include "fboss/agent/state/NodeBase.h"
 
 #include <boost/container/flat_map.hpp>
+#include <memory>
 #include <string>
 
 namespace facebook { namespace fboss {
@@ -35,9 +37,25 @@ struct PortFields {
   };
   typedef boost::container::flat_map<VlanID, VlanInfo> VlanMembership;
 
-  PortFields(PortID id, std::string name)
+  /*
+   * Config-only fields that operational updates never touch. They are
+   * kept in their own block shared between clones, so cloning a port
+   * for a link event copies one shared_ptr instead of the strings.
+   * The block is immutable once shared; the mutators in Port replace
+   * it with a fresh copy (copy-on-write).
+   */
+  struct ConfigFields {
+    // Interned: the names come from config, a bounded vocabulary, and
+    // interning makes copying this block two pointer copies.
+    InternedString name;
+    InternedString description;
+  };
+
+  PortFields(PortID id, std::string name, std::string description = "")
     : id(id),
-      name(name) {}
+      config(std::make_shared<const ConfigFields>(
+          ConfigFields{InternedString::intern(name),
+                       InternedString::intern(description)})) {}
 
   template<typename Fn>
   void forEachChild(Fn fn) {}
@@ -46,8 +64,7 @@ struct PortFields {
   static PortFields fromFollyDynamic(const folly::dynamic& json);
 
   const PortID id{0};
-  std::string name;
-  std::string description;
+  std::shared_ptr<const ConfigFields> config;
   cfg::PortState state{cfg::PortState::DOWN};   // Administrative state
   bool operState{false};    // Operational state of port. UP(true), DOWN(false)
   VlanID ingressVlan{0};
@@ -96,19 +113,25 @@ class Port : public NodeBaseT<Port, PortFields> {
   }
 
   const std::string& getName() const {
-    return getFields()->name;
+    return getFields()->config->name.str();
   }
 
   void setName(const std::string& name) {
-    writableFields()->name = name;
+    auto config = std::make_shared<PortFields::ConfigFields>(
+        *getFields()->config);
+    config->name = InternedString::intern(name);
+    writableFields()->config = std::move(config);
   }
 
   const std::string& getDescription() const {
-    return getFields()->description;
+    return getFields()->config->description.str();
   }
 
   void setDescription(const std::string& description) {
-    writableFields()->description = description;
+    auto config = std::make_shared<PortFields::ConfigFields>(
+        *getFields()->config);
+    config->description = InternedString::intern(description);
+    writableFields()->config = std::move(config);
   }
 
   cfg::PortState getState() const {
@@ -185,4 +208,9 @@ class Port : public NodeBaseT<Port, PortFields> {
   friend class CloneAllocator;
 };
 
+// Config reloads rebuild ports from scratch; fingerprint them at publish
+// so rebuilt-but-identical ports don't show up in deltas
+template <>
+struct NodeUsesFingerprint<Port> : std::true_type {};
+
 }} // facebook::fboss
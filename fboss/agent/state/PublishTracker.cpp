@@ -0,0 +1,48 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/state/PublishTracker.h"
+
+#include "fboss/agent/state/NodeBase.h"
+
+#include <glog/logging.h>
+
+namespace facebook { namespace fboss {
+
+thread_local PublishTracker* PublishTracker::active_{nullptr};
+
+PublishTracker::PublishTracker() {
+  CHECK(active_ == nullptr) << "PublishTracker does not nest";
+  active_ = this;
+}
+
+PublishTracker::~PublishTracker() {
+  active_ = nullptr;
+}
+
+void PublishTracker::publishTracked() {
+  for (auto node: nodes_) {
+    node->publishSelf();
+  }
+  nodes_.clear();
+}
+
+void PublishTracker::noteConstructed(NodeBase* node) {
+  if (active_) {
+    active_->nodes_.insert(node);
+  }
+}
+
+void PublishTracker::noteDestroyed(NodeBase* node) {
+  if (active_) {
+    active_->nodes_.erase(node);
+  }
+}
+
+}} // facebook::fboss
@@ -0,0 +1,70 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <unordered_set>
+
+namespace facebook { namespace fboss {
+
+class NodeBase;
+
+/*
+ * PublishTracker records the state tree nodes constructed while it is
+ * active, so that publishing a new SwitchState after an update only
+ * visits those nodes.
+ *
+ * NodeBaseT::publish() recursively walks every child of every
+ * unpublished node to find what needs publishing. A state update only
+ * clones the spine from the changed nodes up to the root, but the
+ * cloned parents still iterate all of their children during the walk,
+ * which with a large route table costs milliseconds per update. Every
+ * unpublished node in the new state was by definition constructed while
+ * the update ran, so a tracker activated around the update functions
+ * knows the complete set: publishTracked() publishes exactly those
+ * nodes via publishSelf(), making publish cost proportional to the
+ * delta rather than the tree.
+ *
+ * Activation is per thread and does not nest. Nodes destroyed while the
+ * tracker is active (clones that did not make it into the final tree)
+ * unregister themselves, so the tracker never publishes through a
+ * dangling pointer. The tracker must go out of scope before the new
+ * state is shared with other threads; nodes another thread could
+ * destroy must never be in the tracked set.
+ */
+class PublishTracker {
+ public:
+  PublishTracker();
+  ~PublishTracker();
+
+  /*
+   * Publish every node constructed since the tracker was activated (or
+   * since the previous publishTracked() call), without walking any
+   * children, and forget them.
+   */
+  void publishTracked();
+
+  /*
+   * Registration hooks called from NodeBase's constructors and
+   * destructor. No-ops when no tracker is active on this thread.
+   */
+  static void noteConstructed(NodeBase* node);
+  static void noteDestroyed(NodeBase* node);
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  PublishTracker(PublishTracker const&) = delete;
+  PublishTracker& operator=(PublishTracker const&) = delete;
+
+  std::unordered_set<NodeBase*> nodes_;
+
+  static thread_local PublishTracker* active_;
+};
+
+}} // facebook::fboss
@@ -135,6 +135,26 @@ RouteFields<AddrT>::fromFollyDynamic(const folly::dynamic& routeJson) {
   return rt;
 }
 
+template<typename AddrT>
+state::RouteFields RouteFields<AddrT>::toThrift() const {
+  state::RouteFields routeFields;
+  routeFields.prefix = prefix.toThrift();
+  routeFields.nexthopsMulti = nexthopsmulti.toThrift();
+  routeFields.fwd = fwd.toThrift();
+  routeFields.flags = flags;
+  return routeFields;
+}
+
+template<typename AddrT>
+RouteFields<AddrT>
+RouteFields<AddrT>::fromThrift(const state::RouteFields& routeFields) {
+  RouteFields rt(Prefix::fromThrift(routeFields.prefix));
+  rt.nexthopsmulti = RouteNextHopsMulti::fromThrift(routeFields.nexthopsMulti);
+  rt.fwd = RouteForwardInfo::fromThrift(routeFields.fwd);
+  rt.flags = routeFields.flags;
+  return rt;
+}
+
 template class RouteFields<folly::IPAddressV4>;
 template class RouteFields<folly::IPAddressV6>;
 
@@ -47,9 +47,22 @@ struct RouteFields {
    */
   static RouteFields fromFollyDynamic(const folly::dynamic& routeJson);
 
+  /*
+   * Serialize to/from the typed thrift representation
+   */
+  state::RouteFields toThrift() const;
+  static RouteFields fromThrift(const state::RouteFields& routeFields);
+
   RouteDetails toRouteDetails() const;
 
   Prefix prefix;
+  /*
+   * Route state flags (see the bit definitions in Route<>). Only four
+   * bits are used, so a single byte here packs into the padding after
+   * the prefix mask instead of adding another padded word to every
+   * route. Like fwd, it is not copied during clone().
+   */
+  uint8_t flags{0};
   // The following fields will not be copied during clone()
   /*
    * All next hops of the routes. This set could be empty if and only if
@@ -57,7 +70,6 @@ struct RouteFields {
    */
   RouteNextHopsMulti nexthopsmulti;
   RouteForwardInfo fwd;
-  uint32_t flags{0};
 };
 
 /// Route<> Class
@@ -92,6 +104,16 @@ class Route : public NodeBaseT<Route<AddrT>, RouteFields<AddrT>> {
     return this->getFields()->toFollyDynamic();
   }
 
+  static std::shared_ptr<Route<AddrT>>
+  fromThrift(const state::RouteFields& fieldsThrift) {
+    const auto& fields = RouteFields<AddrT>::fromThrift(fieldsThrift);
+    return std::make_shared<Route<AddrT>>(fields);
+  }
+
+  state::RouteFields toThrift() const {
+    return this->getFields()->toThrift();
+  }
+
   RouteDetails toRouteDetails() const {
     RouteDetails rd = this->getFields()->toRouteDetails();
     rd.isConnected = isConnected();
@@ -151,6 +173,12 @@ class Route : public NodeBaseT<Route<AddrT>, RouteFields<AddrT>> {
   bool hasNextHopsForClient(ClientID clientId) const {
     return RouteBase::getFields()->nexthopsmulti.hasNextHopsForClient(clientId);
   }
+  size_t numClients() const {
+    return RouteBase::getFields()->nexthopsmulti.numClients();
+  }
+  std::vector<ClientID> getClientIds() const {
+    return RouteBase::getFields()->nexthopsmulti.getClientIds();
+  }
 
   /*
    * The following functions modify the route object.
@@ -212,7 +240,7 @@ class Route : public NodeBaseT<Route<AddrT>, RouteFields<AddrT>> {
    *             This bit is cleared when setting this route as RESOLVED or
    *             UNRESOLVABLE.
    */
-  enum : uint32_t {
+  enum : uint8_t {
     CONNECTED = 0x1,
     RESOLVED = 0x2,
     UNRESOLVABLE = 0x4,
@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <folly/Hash.h>
+
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteTypes.h"
+
+namespace facebook { namespace fboss {
+
+/*
+ * A small cache of recently resolved (prefix, nexthop set) transitions.
+ *
+ * BGP route churn is repetitive: the same prefixes flap back and forth
+ * between the same two nexthop sets. Each flap normally clones the
+ * Route node, re-runs nexthop resolution and re-allocates the forward
+ * info, even though the exact same transition was computed moments ago.
+ * RouteFlapCache interns the resolved Route node of each transition in
+ * a direct mapped, array backed cache keyed by (vrf, prefix, nexthop
+ * set hash), so RouteUpdater can reinsert the interned node when the
+ * transition recurs.
+ *
+ * Reuse is only legal while the interned node's forwarding info is
+ * still what resolution would produce. Each entry therefore records
+ * the route every nexthop resolved through when the node was built;
+ * RouteUpdater revalidates those against the current rib (routes are
+ * copy-on-write, so pointer equality of the resolving route implies
+ * identical forwarding info) and falls back to full resolution on any
+ * mismatch.
+ *
+ * The cache is not thread safe; route updates are serialized on the
+ * update thread, so use threadLocal() there. Entries pin their route
+ * nodes via shared_ptr, so superseded routes can be briefly kept alive
+ * until their slots are overwritten; the cache is small, so this is
+ * bounded.
+ */
+template <typename AddrT>
+class RouteFlapCache {
+ public:
+  struct Entry {
+    RouterID rid{0};
+    RoutePrefix<AddrT> prefix{AddrT(), 0};
+    size_t nhsHash{0};
+    // The interned resolved route node for this transition
+    std::shared_ptr<Route<AddrT>> route;
+    // The route each nexthop resolved through when 'route' was built,
+    // split by nexthop address family
+    std::vector<std::pair<folly::IPAddressV4, std::shared_ptr<RouteV4>>> viaV4;
+    std::vector<std::pair<folly::IPAddressV6, std::shared_ptr<RouteV6>>> viaV6;
+  };
+
+  RouteFlapCache() {}
+
+  static size_t hashNexthops(const RouteNextHops& nhs) {
+    size_t seed = nhs.size();
+    for (const auto& nh : nhs) {
+      seed = folly::hash::hash_combine(seed, nh.hash());
+    }
+    return seed;
+  }
+
+  /*
+   * Look up the interned transition, or nullptr if the slot holds a
+   * different one. Callers still must revalidate the entry against the
+   * current rib before reusing its route node.
+   */
+  Entry* find(RouterID rid, const RoutePrefix<AddrT>& prefix,
+              size_t nhsHash) {
+    auto& entry = entries_[slot(rid, prefix, nhsHash)];
+    if (entry.route && entry.rid == rid && entry.nhsHash == nhsHash &&
+        entry.prefix == prefix) {
+      ++hits_;
+      return &entry;
+    }
+    ++misses_;
+    return nullptr;
+  }
+
+  /*
+   * Intern a freshly resolved transition, evicting whatever the slot
+   * held before.
+   */
+  void insert(Entry entry) {
+    entries_[slot(entry.rid, entry.prefix, entry.nhsHash)] =
+        std::move(entry);
+  }
+
+  void noteReuse() {
+    ++reuses_;
+  }
+
+  /*
+   * Per-thread cache instance.
+   */
+  static RouteFlapCache* threadLocal() {
+    static thread_local RouteFlapCache cache;
+    return &cache;
+  }
+
+  void clear() {
+    entries_.fill(Entry());
+  }
+
+  uint64_t hits() const {
+    return hits_;
+  }
+  uint64_t misses() const {
+    return misses_;
+  }
+  uint64_t reuses() const {
+    return reuses_;
+  }
+
+ private:
+  static constexpr size_t kEntries = 256;
+  static_assert((kEntries & (kEntries - 1)) == 0,
+                "kEntries must be a power of two");
+
+  // Forbidden copy constructor and assignment operator
+  RouteFlapCache(RouteFlapCache const&) = delete;
+  RouteFlapCache& operator=(RouteFlapCache const&) = delete;
+
+  static size_t slot(RouterID rid, const RoutePrefix<AddrT>& prefix,
+                     size_t nhsHash) {
+    return folly::hash::hash_combine(static_cast<uint32_t>(rid),
+                                     prefix.network.hash(), prefix.mask,
+                                     nhsHash) &
+        (kEntries - 1);
+  }
+
+  std::array<Entry, kEntries> entries_;
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+  uint64_t reuses_{0};
+};
+
+}} // facebook::fboss
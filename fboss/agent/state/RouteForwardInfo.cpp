@@ -8,6 +8,7 @@
  *
  */
 #include "RouteForwardInfo.h"
+#include <folly/Hash.h>
 #include <vector>
 
 namespace {
@@ -22,12 +23,12 @@ namespace facebook { namespace fboss {
 using std::string;
 using std::vector;
 
-// RouteForwardInfo::Nexthop class
-std::string RouteForwardInfo::Nexthop::str() const {
+// RouteNexthop class
+std::string RouteNexthop::str() const {
   return folly::to<string>(nexthop, "@I", intf);
 }
 
-bool RouteForwardInfo::Nexthop::operator<(const Nexthop& fwd) const {
+bool RouteNexthop::operator<(const RouteNexthop& fwd) const {
   if (intf < fwd.intf) {
     return true;
   } else if (intf > fwd.intf) {
@@ -37,10 +38,29 @@ bool RouteForwardInfo::Nexthop::operator<(const Nexthop& fwd) const {
   }
 }
 
-bool RouteForwardInfo::Nexthop::operator==(const Nexthop& fwd) const {
+bool RouteNexthop::operator==(const RouteNexthop& fwd) const {
   return intf == fwd.intf && nexthop == fwd.nexthop;
 }
 
+// RouteForwardNexthops class
+size_t RouteForwardNexthops::hashOf(const RouteNexthop& nhop) {
+  return folly::hash::hash_combine(static_cast<uint32_t>(nhop.intf),
+                                   nhop.nexthop.hash());
+}
+
+std::pair<RouteForwardNexthops::const_iterator, bool>
+RouteForwardNexthops::insert(const RouteNexthop& nhop) {
+  auto itr = std::lower_bound(nhops_.begin(), nhops_.end(), nhop);
+  if (itr != nhops_.end() && *itr == nhop) {
+    return {itr, false};
+  }
+  itr = nhops_.insert(itr, nhop);
+  // XOR makes the hash independent of insertion order, matching the
+  // set semantics.
+  hash_ ^= hashOf(nhop);
+  return {itr, true};
+}
+
 // RouteForwardInfo class
 std::string RouteForwardInfo::str() const {
   std::string result;
@@ -82,19 +102,51 @@ RouteForwardInfo::fromFollyDynamic(const folly::dynamic& fwdInfoJson) {
   return fwdInfo;
 }
 
-folly::dynamic RouteForwardInfo::Nexthop::toFollyDynamic() const {
+folly::dynamic RouteNexthop::toFollyDynamic() const {
   folly::dynamic nhop = folly::dynamic::object;
   nhop[kInterface] = static_cast<uint32_t>(intf);
   nhop[kNexthop] = nexthop.str();
   return nhop;
 }
 
-RouteForwardInfo::Nexthop
-RouteForwardInfo::Nexthop::fromFollyDynamic(const folly::dynamic& nhopJson) {
-  return Nexthop(InterfaceID(nhopJson[kInterface].asInt()),
+RouteNexthop
+RouteNexthop::fromFollyDynamic(const folly::dynamic& nhopJson) {
+  return RouteNexthop(InterfaceID(nhopJson[kInterface].asInt()),
       folly::IPAddress(nhopJson[kNexthop].stringPiece()));
 }
 
+state::RouteNexthop RouteNexthop::toThrift() const {
+  state::RouteNexthop nhop;
+  nhop.interfaceId = static_cast<uint32_t>(intf);
+  nhop.nexthop = network::toBinaryAddress(nexthop);
+  return nhop;
+}
+
+RouteNexthop RouteNexthop::fromThrift(const state::RouteNexthop& nhopThrift) {
+  return RouteNexthop(InterfaceID(nhopThrift.interfaceId),
+      network::toIPAddress(nhopThrift.nexthop));
+}
+
+state::RouteForwardInfo RouteForwardInfo::toThrift() const {
+  state::RouteForwardInfo fwdInfo;
+  fwdInfo.action = static_cast<state::RouteForwardAction>(action_);
+  fwdInfo.nexthops.reserve(nexthops_.size());
+  for (const auto& nhop : nexthops_) {
+    fwdInfo.nexthops.push_back(nhop.toThrift());
+  }
+  return fwdInfo;
+}
+
+RouteForwardInfo
+RouteForwardInfo::fromThrift(const state::RouteForwardInfo& fwdInfoThrift) {
+  RouteForwardInfo fwdInfo;
+  fwdInfo.action_ = static_cast<Action>(fwdInfoThrift.action);
+  for (const auto& nhop : fwdInfoThrift.nexthops) {
+    fwdInfo.nexthops_.insert(Nexthop::fromThrift(nhop));
+  }
+  return fwdInfo;
+}
+
 // Methods for RouteForwardInfo
 void toAppend(const RouteForwardInfo& fwd, std::string *result) {
   result->append(fwd.str());
@@ -103,7 +155,7 @@ std::ostream& operator<<(std::ostream& os, const RouteForwardInfo& fwd) {
   return os << fwd.str();
 }
 
-// Methods for RouteForwardInfo::Nexthops
+// Methods for RouteForwardNexthops
 void toAppend(const RouteForwardNexthops& nhops, std::string *result) {
   for (const auto& nhop : nhops) {
     result->append(folly::to<std::string>(nhop.str(), " "));
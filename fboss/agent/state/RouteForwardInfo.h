@@ -12,13 +12,129 @@
 
 #include <folly/dynamic.h>
 #include <folly/IPAddress.h>
+#include <folly/small_vector.h>
 #include "fboss/agent/types.h"
 #include "fboss/agent/state/RouteTypes.h"
 
-#include <boost/container/flat_set.hpp>
+#include <algorithm>
+#include <utility>
 
 namespace facebook { namespace fboss {
 
+/**
+ * RouteNexthop Class
+ *
+ * A RouteNexthop is a path to reach a given nexthop, which is set
+ * after the route is resolved.
+ * In the case for the directly connected route, the 'nexthop' is the
+ * interface IP address on the network.
+ */
+struct RouteNexthop {
+  InterfaceID intf;
+  folly::IPAddress nexthop;
+  RouteNexthop(InterfaceID intf, folly::IPAddress nh)
+      : intf(intf), nexthop(nh) {}
+  bool operator<(const RouteNexthop& nhop) const;
+  bool operator==(const RouteNexthop& nhop) const;
+  bool operator!=(const RouteNexthop& nhop) const {
+    return !operator==(nhop);
+  }
+  /*
+   * Serialize to folly::dynamic
+   */
+  folly::dynamic toFollyDynamic() const;
+
+  /*
+   * Deserialize from folly::dynamic
+   */
+  static RouteNexthop fromFollyDynamic(const folly::dynamic& nhopJson);
+
+  /*
+   * Serialize to/from the typed thrift representation
+   */
+  state::RouteNexthop toThrift() const;
+  static RouteNexthop fromThrift(const state::RouteNexthop& nhopThrift);
+
+  std::string str() const;
+};
+
+/**
+ * The set of nexthops for a resolved route.
+ *
+ * Semantically a sorted, duplicate-free set of RouteNexthop entries.
+ * Storage is a folly::small_vector with inline room for the ECMP widths
+ * seen in practice, so building and copying forwarding info during route
+ * resolution does not touch the heap. A hash of the contents is
+ * maintained incrementally on insert and consulted first by operator==,
+ * since delta processing compares forwarding info in bulk and the
+ * common answer is "not equal".
+ */
+class RouteForwardNexthops {
+ public:
+  // Inline capacity, covering the common 1-16 way ECMP spreads.
+  static constexpr size_t kInlineNexthops = 16;
+  typedef folly::small_vector<RouteNexthop, kInlineNexthops> Container;
+  typedef RouteNexthop value_type;
+  typedef Container::const_iterator const_iterator;
+  // Iteration is read-only: mutating an entry in place would break both
+  // the sort order and the precomputed hash.
+  typedef const_iterator iterator;
+
+  const_iterator begin() const {
+    return nhops_.begin();
+  }
+  const_iterator end() const {
+    return nhops_.end();
+  }
+  size_t size() const {
+    return nhops_.size();
+  }
+  bool empty() const {
+    return nhops_.empty();
+  }
+  void reserve(size_t n) {
+    nhops_.reserve(n);
+  }
+  void clear() {
+    nhops_.clear();
+    hash_ = 0;
+  }
+
+  std::pair<const_iterator, bool> insert(const RouteNexthop& nhop);
+  template<typename... Args>
+  std::pair<const_iterator, bool> emplace(Args&&... args) {
+    return insert(RouteNexthop(std::forward<Args>(args)...));
+  }
+  template<typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  size_t hash() const {
+    return hash_;
+  }
+
+  bool operator==(const RouteForwardNexthops& nhops) const {
+    return hash_ == nhops.hash_ && size() == nhops.size() &&
+      std::equal(begin(), end(), nhops.begin());
+  }
+  bool operator!=(const RouteForwardNexthops& nhops) const {
+    return !operator==(nhops);
+  }
+  bool operator<(const RouteForwardNexthops& nhops) const {
+    return std::lexicographical_compare(begin(), end(),
+                                        nhops.begin(), nhops.end());
+  }
+
+ private:
+  static size_t hashOf(const RouteNexthop& nhop);
+
+  Container nhops_;
+  size_t hash_{0};
+};
+
 /**
  * RouteForwardInfo defines how to forward packets based on a route
  *
@@ -38,8 +154,8 @@ class RouteForwardInfo {
    * It includes a set of nexthops on where the route shall forward the packet.
    * In the case if action_ is not Action::NEXTHOPS, the set shall be empty.
    */
-  struct Nexthop;
-  typedef boost::container::flat_set<Nexthop> Nexthops;
+  typedef RouteNexthop Nexthop;
+  typedef RouteForwardNexthops Nexthops;
 
   explicit RouteForwardInfo(Action action = Action::DROP)
       : action_(action) {
@@ -67,6 +183,13 @@ class RouteForwardInfo {
    */
   static RouteForwardInfo fromFollyDynamic(const folly::dynamic& fwdInfoJson);
 
+  /*
+   * Serialize to/from the typed thrift representation
+   */
+  state::RouteForwardInfo toThrift() const;
+  static RouteForwardInfo fromThrift(
+      const state::RouteForwardInfo& fwdInfoThrift);
+
   bool operator==(const RouteForwardInfo& info) const {
     return action_ == info.action_ && nexthops_ == info.nexthops_;
   }
@@ -121,42 +244,9 @@ class RouteForwardInfo {
   Action action_;
 };
 
-typedef RouteForwardInfo::Nexthops RouteForwardNexthops;
-
 void toAppend(const RouteForwardInfo& fwd, std::string *result);
 std::ostream& operator<<(std::ostream& os, const RouteForwardInfo& fwd);
 
-/**
- * RouteForwardInfo::Nexthop Class
- *
- * A RouteForwardInfo::Nexthop is a path to reach a given nexthop, which is set
- * after the route is resolved.
- * In the case for the directly connected route, the 'nexthop' is the
- * interface IP address on the network.
- */
-struct RouteForwardInfo::Nexthop {
-  InterfaceID intf;
-  folly::IPAddress nexthop;
-  Nexthop(InterfaceID intf, folly::IPAddress nh)
-      : intf(intf), nexthop(nh) {}
-  bool operator<(const Nexthop& nhop) const;
-  bool operator==(const Nexthop& nhop) const;
-  bool operator!=(const Nexthop& nhop) const {
-    return !operator==(nhop);
-  }
-  /*
-   * Serialize to folly::dynamic
-   */
-  folly::dynamic toFollyDynamic() const;
-
-  /*
-   * Deserialize from folly::dynamic
-   */
-  static Nexthop fromFollyDynamic(const folly::dynamic& nhopJson);
-
-  std::string str() const;
-};
-
 void toAppend(const RouteForwardNexthops& fwd, std::string *result);
 std::ostream& operator<<(std::ostream& os, const RouteForwardNexthops& fwd);
 
@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <functional>
+#include <memory>
+
+#include "fboss/agent/state/NodeBase.h"
+#include "fboss/agent/state/RouteTableRib.h"
+
+namespace facebook { namespace fboss {
+
+/*
+ * A small cache of recent longest match lookups against a RouteTableRib.
+ *
+ * Punted traffic is typically heavily skewed towards a few destinations,
+ * so repeated forwarding decisions mostly walk the radix tree to the same
+ * node. RouteLookupCache keeps a direct mapped, array backed cache of
+ * (address -> route) results so repeat lookups skip the bit-walk.
+ *
+ * Each entry records which version of the rib produced it (the rib
+ * pointer along with its NodeID and generation) and is revalidated
+ * against the rib passed to every lookup. A route update clones the
+ * RouteTableRib with a bumped generation, so entries cached against the
+ * old version simply stop matching; stale results are never returned.
+ *
+ * The cache is not thread safe. Use threadLocal() for a per-thread
+ * instance that needs no synchronization.
+ *
+ * Note that cached entries hold shared_ptr references, so a cache can
+ * briefly pin routes from a superseded rib version until the entries are
+ * overwritten. The cache is small, so this is bounded.
+ */
+template <typename AddrT>
+class RouteLookupCache {
+ public:
+  RouteLookupCache() {}
+
+  std::shared_ptr<Route<AddrT>> longestMatch(
+      const RouteTableRib<AddrT>* rib, const AddrT& addr) {
+    auto& entry = entries_[std::hash<AddrT>()(addr) & (kEntries - 1)];
+    if (entry.rib == rib && entry.nodeId == rib->getNodeID() &&
+        entry.generation == rib->getGeneration() && entry.addr == addr) {
+      ++hits_;
+      return entry.route;
+    }
+    ++misses_;
+    auto route = rib->longestMatch(addr);
+    entry.rib = rib;
+    entry.nodeId = rib->getNodeID();
+    entry.generation = rib->getGeneration();
+    entry.addr = addr;
+    entry.route = route;
+    return route;
+  }
+
+  /*
+   * Per-thread cache instance.
+   */
+  static RouteLookupCache* threadLocal() {
+    static thread_local RouteLookupCache cache;
+    return &cache;
+  }
+
+  void clear() {
+    entries_.fill(Entry());
+  }
+
+  uint64_t hits() const {
+    return hits_;
+  }
+  uint64_t misses() const {
+    return misses_;
+  }
+
+ private:
+  // Power of 2, so the hash can be masked into an index
+  enum : size_t { kEntries = 64 };
+
+  struct Entry {
+    const RouteTableRib<AddrT>* rib{nullptr};
+    NodeID nodeId{0};
+    uint32_t generation{0};
+    AddrT addr;
+    std::shared_ptr<Route<AddrT>> route;
+  };
+
+  // No copy or assignment.
+  RouteLookupCache(const RouteLookupCache&) = delete;
+  RouteLookupCache& operator=(const RouteLookupCache&) = delete;
+
+  std::array<Entry, kEntries> entries_;
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+};
+
+}} // facebook::fboss
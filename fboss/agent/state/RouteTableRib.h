@@ -90,10 +90,12 @@ class RouteTableRib : public NodeBase {
   }
 
   void publish() override {
-    NodeBase::publish();
+    // The radix tree is not visible to forEachChild(), so publish the
+    // routes explicitly.
     for (auto routeIter: rib_) {
       routeIter->value()->publish();
     }
+    this->publishSelf();
   }
   std::shared_ptr<Route<AddrT>> exactMatch(const Prefix& prefix) const {
     auto citr = rib_.exactMatch(prefix.network, prefix.mask);
@@ -107,14 +109,14 @@ class RouteTableRib : public NodeBase {
   std::shared_ptr<RouteTableRib> clone() const {
     auto routeTableRib = std::make_shared<RouteTableRib>(getNodeID(),
         getGeneration() + 1);
-    for (auto& routeItr: rib_) {
-      /* Explicitly insert cloned routes rather than calling
-       * rib_.clone(), which will just use the shared_ptr copy
-       * constructor
-       */
-      routeTableRib->rib_.insert(routeItr->ipAddress(),
-          routeItr->masklen(), routeItr->value()->clone());
-    }
+    /*
+     * Share the route objects with the original rib rather than copying
+     * them.  Every mutating path in RouteUpdater clones a published route
+     * before touching it, so an update only ever copies the routes it
+     * actually changes -- e.g. a client's full sync copies that client's
+     * routes, not the whole table.
+     */
+    routeTableRib->rib_ = rib_.clone();
     return routeTableRib;
   }
   /*
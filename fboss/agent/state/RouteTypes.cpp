@@ -84,6 +84,34 @@ RoutePrefix<AddrT>::fromFollyDynamic(const folly::dynamic& pfxJson) {
   return pfx;
 }
 
+namespace {
+void binAddrToNetwork(const network::thrift::BinaryAddress& addr,
+                      folly::IPAddressV4* network) {
+  *network = network::toIPAddress(addr).asV4();
+}
+void binAddrToNetwork(const network::thrift::BinaryAddress& addr,
+                      folly::IPAddressV6* network) {
+  *network = network::toIPAddress(addr).asV6();
+}
+}
+
+template<typename AddrT>
+state::RoutePrefix RoutePrefix<AddrT>::toThrift() const {
+  state::RoutePrefix pfx;
+  pfx.network = toBinaryAddress(network);
+  pfx.mask = mask;
+  return pfx;
+}
+
+template<typename AddrT>
+RoutePrefix<AddrT>
+RoutePrefix<AddrT>::fromThrift(const state::RoutePrefix& prefixThrift) {
+  RoutePrefix pfx;
+  binAddrToNetwork(prefixThrift.network, &pfx.network);
+  pfx.mask = prefixThrift.mask;
+  return pfx;
+}
+
 void toAppend(const RoutePrefixV4& prefix, std::string *result) {
   result->append(prefix.str());
 }
@@ -121,6 +149,19 @@ std::vector<ClientAndNextHops> RouteNextHopsMulti::toThrift() const {
   return list;
 }
 
+RouteNextHopsMulti
+RouteNextHopsMulti::fromThrift(const std::vector<ClientAndNextHops>& nhm) {
+  RouteNextHopsMulti nh;
+  for (const auto& entry : nhm) {
+    RouteNextHops list;
+    for (const auto& addr : entry.nextHopAddrs) {
+      list.emplace(network::toIPAddress(addr));
+    }
+    nh.update(ClientID(entry.clientId), std::move(list));
+  }
+  return nh;
+}
+
 RouteNextHopsMulti
 RouteNextHopsMulti::fromFollyDynamic(const folly::dynamic& json) {
   RouteNextHopsMulti nh;
@@ -168,6 +209,15 @@ bool RouteNextHopsMulti::hasNextHopsForClient(ClientID clientId) const {
   return map_.find(clientId) != map_.end();
 }
 
+std::vector<ClientID> RouteNextHopsMulti::getClientIds() const {
+  std::vector<ClientID> clientIds;
+  clientIds.reserve(map_.size());
+  for (const auto& entry : map_) {
+    clientIds.push_back(entry.first);
+  }
+  return clientIds;
+}
+
 bool RouteNextHopsMulti::isSame(ClientID id, const RouteNextHops& nhs) const {
   auto iter = map_.find(id);
   if (iter == map_.end()) {
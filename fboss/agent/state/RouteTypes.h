@@ -15,6 +15,7 @@
 #include "fboss/agent/types.h"
 #include <folly/IPAddress.h>
 #include "fboss/agent/if/gen-cpp2/ctrl_types.h"
+#include "fboss/agent/state/gen-cpp2/switch_state_types.h"
 
 #include <boost/container/flat_set.hpp>
 #include <boost/container/flat_map.hpp>
@@ -36,6 +37,8 @@ class RouteNextHopsMulti {
   folly::dynamic toFollyDynamic() const;
   std::vector<ClientAndNextHops> toThrift() const;
   static RouteNextHopsMulti fromFollyDynamic(const folly::dynamic& json);
+  static RouteNextHopsMulti fromThrift(
+      const std::vector<ClientAndNextHops>& nhm);
   std::string str() const;
   void update(ClientID clientid, const RouteNextHops& nhs);
   void update(ClientID clientid, const RouteNextHops&& nhs);
@@ -53,9 +56,15 @@ class RouteNextHopsMulti {
 
   void delNexthopsForClient(ClientID clientId);
 
-  // Just used for testing
   bool hasNextHopsForClient(ClientID clientId) const;
 
+  size_t numClients() const {
+    return map_.size();
+  }
+
+  // Return the IDs of all clients that have next hops for this route.
+  std::vector<ClientID> getClientIds() const;
+
   bool isSame(ClientID clientId, const RouteNextHops& nhs) const;
 
   const RouteNextHops& bestNextHopList() const;
@@ -94,6 +103,12 @@ struct RoutePrefix {
    */
   static RoutePrefix fromFollyDynamic(const folly::dynamic& prefixJson);
 
+  /*
+   * Serialize to/from the typed thrift representation
+   */
+  state::RoutePrefix toThrift() const;
+  static RoutePrefix fromThrift(const state::RoutePrefix& prefixThrift);
+
   bool operator<(const RoutePrefix&) const;
   bool operator>(const RoutePrefix&) const;
   bool operator==(const RoutePrefix& p2) const {
@@ -15,16 +15,25 @@
 #include "fboss/agent/state/NodeBase.h"
 #include "fboss/agent/state/NodeBase-defs.h"
 #include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteFlapCache.h"
 #include "fboss/agent/state/RouteTable.h"
 #include "fboss/agent/state/RouteTableMap.h"
 #include "fboss/agent/state/RouteTableRib.h"
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/if/gen-cpp2/ctrl_types.h"
 
+#include <deque>
+
+DEFINE_bool(route_flap_cache, true,
+            "Intern resolved routes per (prefix, nexthop set) transition "
+            "and reuse them when the same transition recurs, so repeated "
+            "BGP flaps skip route cloning and nexthop re-resolution");
+
 using folly::IPAddress;
 using folly::IPAddressV4;
 using folly::IPAddressV6;
 using boost::container::flat_map;
+using boost::container::flat_multimap;
 using boost::container::flat_set;
 using folly::CIDRNetwork;
 
@@ -122,6 +131,7 @@ void RouteUpdater::addRoute(const PrefixT& prefix, RibT *ribCloned,
     rib->addRoute(newRoute);
     VLOG(3) << "Added route " << newRoute->str();
   }
+  ribCloned->dirty.insert(prefix);
   CHECK(ribCloned->cloned);
 }
 
@@ -169,6 +179,9 @@ void RouteUpdater::addRoute(RouterID id,
                             ClientID clientId, const RouteNextHops& nhs) {
   if (network.isV4()) {
     PrefixV4 prefix{network.asV4().mask(mask), mask};
+    if (tryReuseInterned(id, prefix, getRibV4(id), clientId, nhs)) {
+      return;
+    }
     return addRoute(prefix, getRibV4(id), clientId, nhs);
   } else {
     PrefixV6 prefix{network.asV6().mask(mask), mask};
@@ -176,6 +189,9 @@ void RouteUpdater::addRoute(RouterID id,
       throw FbossError("Unexpected v6 routable route for link local address ",
                        prefix);
     }
+    if (tryReuseInterned(id, prefix, getRibV6(id), clientId, nhs)) {
+      return;
+    }
     return addRoute(prefix, getRibV6(id), clientId, nhs);
   }
 }
@@ -185,6 +201,9 @@ void RouteUpdater::addRoute(RouterID id,
                             ClientID clientId, RouteNextHops&& nhs) {
   if (network.isV4()) {
     PrefixV4 prefix{network.asV4().mask(mask), mask};
+    if (tryReuseInterned(id, prefix, getRibV4(id), clientId, nhs)) {
+      return;
+    }
     return addRoute(prefix, getRibV4(id), clientId, std::move(nhs));
   } else {
     PrefixV6 prefix{network.asV6().mask(mask), mask};
@@ -192,10 +211,116 @@ void RouteUpdater::addRoute(RouterID id,
       throw FbossError("Unexpected v6 routable route for link local address ",
                        prefix);
     }
+    if (tryReuseInterned(id, prefix, getRibV6(id), clientId, nhs)) {
+      return;
+    }
     return addRoute(prefix, getRibV6(id), clientId, std::move(nhs));
   }
 }
 
+template<typename PrefixT, typename RibT>
+bool RouteUpdater::tryReuseInterned(RouterID id, const PrefixT& prefix,
+                                    RibT* ribCloned, ClientID clientId,
+                                    const RouteNextHops& nhs) {
+  typedef typename PrefixT::AddressT AddrT;
+  if (!FLAGS_route_flap_cache) {
+    return false;
+  }
+  auto* cache = RouteFlapCache<AddrT>::threadLocal();
+  auto* entry =
+      cache->find(id, prefix, RouteFlapCache<AddrT>::hashNexthops(nhs));
+  if (!entry) {
+    return false;
+  }
+  const auto& interned = entry->route;
+  // The interned node can only stand in for the update's result if it is
+  // exactly what the update would have produced: published (so sharing
+  // it is legal), resolved, and carrying just this client's nexthops.
+  if (!interned->isPublished() || !interned->isResolved() ||
+      interned->numClients() != 1 || !interned->isSame(clientId, nhs)) {
+    return false;
+  }
+  auto old = ribCloned->rib->exactMatch(prefix);
+  if (old) {
+    if (old->isSame(clientId, nhs)) {
+      // No-op update; leave the current node alone
+      return false;
+    }
+    if (old->numClients() != 1 || !old->hasNextHopsForClient(clientId)) {
+      // Another client also holds nexthops here; the merged result
+      // would differ from the interned single-client node
+      return false;
+    }
+  }
+  // Revalidate the resolution inputs: every nexthop must still resolve
+  // through the exact route it resolved through when the interned node
+  // was built. Routes are copy-on-write, so pointer equality implies
+  // identical forwarding info.
+  auto it = clonedRibs_.find(id);
+  CHECK(it != clonedRibs_.end());
+  auto* clonedRib = &it->second;
+  for (const auto& via : entry->viaV4) {
+    auto rt = clonedRib->v4.rib->longestMatch(via.first);
+    if (rt.get() != via.second.get() || !rt->isResolved()) {
+      return false;
+    }
+  }
+  for (const auto& via : entry->viaV6) {
+    auto rt = clonedRib->v6.rib->longestMatch(via.first);
+    if (rt.get() != via.second.get() || !rt->isResolved()) {
+      return false;
+    }
+  }
+  auto rib = makeClone(ribCloned);
+  if (old) {
+    rib->updateRoute(interned);
+  } else {
+    rib->addRoute(interned);
+  }
+  // Dirty so dependents get re-resolved against the new forwarding
+  // info, prebuilt so the node itself is not re-resolved.
+  ribCloned->dirty.insert(prefix);
+  ribCloned->prebuilt.insert(prefix);
+  cache->noteReuse();
+  VLOG(3) << "Reused interned route " << interned->str();
+  return true;
+}
+
+template<typename RtRibT, typename PrefixT>
+void RouteUpdater::captureFlapEntry(RouterID id, ClonedRib* clonedRib,
+                                    RtRibT* rib, const PrefixT& prefix) {
+  typedef typename PrefixT::AddressT AddrT;
+  auto route = rib->exactMatch(prefix);
+  // Only single-client nexthop routes are interned: those are the ones
+  // BGP flaps, and their update result is determined by (clientId, nhs)
+  // alone.
+  if (!route || !route->isResolved() || route->isConnected() ||
+      !route->isWithNexthops() || route->numClients() != 1) {
+    return;
+  }
+  typename RouteFlapCache<AddrT>::Entry entry;
+  entry.rid = id;
+  entry.prefix = prefix;
+  entry.nhsHash = RouteFlapCache<AddrT>::hashNexthops(route->bestNextHopList());
+  entry.route = route;
+  for (const auto& nh : route->bestNextHopList()) {
+    if (nh.isV4()) {
+      auto via = clonedRib->v4.rib->longestMatch(nh.asV4());
+      if (!via || !via->isResolved()) {
+        return;
+      }
+      entry.viaV4.emplace_back(nh.asV4(), std::move(via));
+    } else {
+      auto via = clonedRib->v6.rib->longestMatch(nh.asV6());
+      if (!via || !via->isResolved()) {
+        return;
+      }
+      entry.viaV6.emplace_back(nh.asV6(), std::move(via));
+    }
+  }
+  RouteFlapCache<AddrT>::threadLocal()->insert(std::move(entry));
+}
+
 void RouteUpdater::addLinkLocalRoutes(RouterID id) {
   // NOTE: v4 link-local route is not added because currently fboss handles
   // v4 link-locals as normal routes.
@@ -233,6 +358,7 @@ void RouteUpdater::delRouteWithNoNexthops(const PrefixT& prefix,
   }
   rib = makeClone(ribCloned);
   rib->removeRoute(old);
+  ribCloned->dirty.insert(prefix);
   VLOG(3) << "Deleted route " << prefix.str();
   CHECK(ribCloned->cloned);
 }
@@ -262,8 +388,15 @@ void RouteUpdater::delNexthopsForClient(const PrefixT& prefix,
     return;
   }
   rib = makeClone(ribCloned);
-  // Re-get the route from the cloned RIB
+  // Re-get the route from the cloned RIB.  The clone shares route
+  // objects with the original rib, so copy this one before mutating it.
   old = rib->exactMatch(prefix);
+  if (old->isPublished()) {
+    auto newRoute = old->clone(
+        RouteFields<typename PrefixT::AddressT>::COPY_PREFIX_AND_NEXTHOPS);
+    rib->updateRoute(newRoute);
+    old = newRoute;
+  }
   old->delNexthopsForClient(clientId);
   // TODO Do I need to publish the change??
   VLOG(3) << "Deleted nexthops for client " << clientId <<
@@ -272,6 +405,7 @@ void RouteUpdater::delNexthopsForClient(const PrefixT& prefix,
     rib->removeRoute(old);
     VLOG(3) << "...and then deleted route " << prefix.str();
   }
+  ribCloned->dirty.insert(prefix);
   CHECK(ribCloned->cloned);
 }
 
@@ -296,10 +430,20 @@ void RouteUpdater::removeAllNexthopsForClient(RibT *ribCloned,
 
   for (auto& rt : rib->routes()) {
     auto route = rt.value().get();
-    if (route->nexthopsIsEmpty()) {
+    // Leave routes the client has no nexthops in alone -- this keeps a
+    // client sync from cloning interface, static and other clients'
+    // routes, so its cost is bounded by the syncing client's table size.
+    if (!route->hasNextHopsForClient(clientId)) {
       continue;
     }
+    if (route->isPublished()) {
+      auto newRoute = route->clone(
+          RouteFields<AddrT>::COPY_PREFIX_AND_NEXTHOPS);
+      rib->updateRoute(newRoute);
+      route = newRoute.get();
+    }
     route->delNexthopsForClient(clientId);
+    ribCloned->dirty.insert(route->prefix());
     if (route->nexthopsIsEmpty()) {
       // The nexthops we removed was the only one.  Delete the route.
       routesToDelete.push_back(rt.value());
@@ -409,67 +553,190 @@ void RouteUpdater::resolve(RouteT* route, RtRibT* rib, ClonedRib* ribCloned) {
 }
 
 
-template<typename RibT>
-void RouteUpdater::setRoutesWithNhopsForResolution(RibT* rib) {
-  for (auto& rt : rib->routes()) {
-    auto route = rt.value().get();
-    if (route->isWithNexthops()) {
-      if (route->isPublished()) {
-        auto newRoute =
-          route->clone(RibT::RouteType::Fields::COPY_PREFIX_AND_NEXTHOPS);
-        rib->updateRoute(newRoute);
-        route = newRoute.get();
-      }
-      route->clearFlags();
-    }
-  }
-}
-
 namespace {
+/**
+ * A route that depends on a nexthop for its resolution.  'v4' says which
+ * RIB the dependent route lives in; the prefix is kept family agnostic so
+ * v4 and v6 dependents can share one index entry type.
+ */
+struct DependentRoute {
+  bool v4;
+  folly::IPAddress network;
+  uint8_t mask;
+};
+
+// Reverse index from a nexthop address to the routes which use it.  The
+// keys are kept sorted, so all nexthops covered by a changed prefix form a
+// contiguous range starting at lower_bound(prefix.network).
+typedef flat_multimap<IPAddressV4, DependentRoute> NhopToRoutesV4;
+typedef flat_multimap<IPAddressV6, DependentRoute> NhopToRoutesV6;
+
 template<typename RibT>
-bool allRouteFlagsCleared(const RibT* rib) {
+void indexNexthops(const RibT* rib, bool v4Rib,
+                   NhopToRoutesV4* nhopsV4, NhopToRoutesV6* nhopsV6) {
   for (const auto& rt : rib->routes()) {
     const auto& route = rt.value();
-    if (route->isWithNexthops() && !route->flagsCleared()) {
-      return false;
+    if (!route->isWithNexthops()) {
+      continue;
+    }
+    DependentRoute dep{v4Rib, IPAddress(route->prefix().network),
+                       route->prefix().mask};
+    for (const auto& nh : route->bestNextHopList()) {
+      if (nh.isV4()) {
+        nhopsV4->emplace(nh.asV4(), dep);
+      } else {
+        nhopsV6->emplace(nh.asV6(), dep);
+      }
     }
   }
-  return true;
 }
+} // anonymous namespace
+
+template<typename RibT, typename PrefixT>
+void RouteUpdater::markForResolution(RibT* ribCloned, const PrefixT& prefix) {
+  auto rib = makeClone(ribCloned);
+  auto route = rib->exactMatch(prefix);
+  if (!route || !route->isWithNexthops()) {
+    return;
+  }
+  if (route->isPublished()) {
+    auto newRoute = route->clone(
+        RouteFields<typename PrefixT::AddressT>::COPY_PREFIX_AND_NEXTHOPS);
+    rib->updateRoute(newRoute);
+    route = newRoute;
+  }
+  route->clearFlags();
 }
 
-void RouteUpdater::resolve() {
-  // Ideally, just need to resolve the routes that is changed or impacted by
-  // the changed routes.
-  // However, Without copy-on-write RadixTree, it is O(n) to find out the
-  // routes that are changed. In this case, we just simply loop through all
-  // routes and resolve those that are not resolved yet.
+void RouteUpdater::resolveIncremental(ClonedRib* clonedRib) {
+  // Build the reverse index from nexthop address to dependent routes.
+  // Both RIBs are indexed regardless of whether they were cloned, since a
+  // route in one address family can recursively resolve via the other.
+  NhopToRoutesV4 nhopsV4;
+  NhopToRoutesV6 nhopsV6;
+  indexNexthops(clonedRib->v4.rib.get(), true, &nhopsV4, &nhopsV6);
+  indexNexthops(clonedRib->v6.rib.get(), false, &nhopsV4, &nhopsV6);
+
+  // Seed the closure with the prefixes touched through this updater.  Each
+  // of them needs to be re-resolved itself (if it still exists), and so
+  // does every route whose nexthop now resolves through it (or used to).
+  flat_set<PrefixV4> affectedV4 = clonedRib->v4.dirty;
+  flat_set<PrefixV6> affectedV6 = clonedRib->v6.dirty;
+  std::deque<PrefixV4> worklistV4(affectedV4.begin(), affectedV4.end());
+  std::deque<PrefixV6> worklistV6(affectedV6.begin(), affectedV6.end());
+  // Prebuilt prefixes were satisfied with an interned, already resolved
+  // node from the flap cache; they seed the dependent closure but are
+  // not themselves re-resolved.
+  for (const auto& prefix : affectedV4) {
+    if (!clonedRib->v4.prebuilt.count(prefix)) {
+      markForResolution(&clonedRib->v4, prefix);
+    }
+  }
+  for (const auto& prefix : affectedV6) {
+    if (!clonedRib->v6.prebuilt.count(prefix)) {
+      markForResolution(&clonedRib->v6, prefix);
+    }
+  }
 
-  for (auto& ribCloned : clonedRibs_) {
-    if (ribCloned.second.v4.cloned) {
-      auto rib = ribCloned.second.v4.rib.get();
-      setRoutesWithNhopsForResolution(rib);
-      for (auto& rt : rib->routes()) {
-        if (rt.value()->needResolve()) {
-          resolve(rt.value().get(), rib, &ribCloned.second);
-        }
+  // Expand to the transitive closure of recursive-nexthop dependencies.
+  // A route can only change resolution if some changed prefix covers one
+  // of its nexthops, so walking the covered index ranges finds exactly the
+  // candidates which need another look.
+  auto addDependent = [&](const DependentRoute& dep) {
+    if (dep.v4) {
+      PrefixV4 prefix{dep.network.asV4(), dep.mask};
+      if (affectedV4.insert(prefix).second) {
+        markForResolution(&clonedRib->v4, prefix);
+        worklistV4.push_back(prefix);
+      } else if (clonedRib->v4.prebuilt.erase(prefix)) {
+        // A later change in this update touched one of the interned
+        // node's resolution inputs after it was validated; fall back
+        // to re-resolving it.
+        markForResolution(&clonedRib->v4, prefix);
+      }
+    } else {
+      PrefixV6 prefix{dep.network.asV6(), dep.mask};
+      if (affectedV6.insert(prefix).second) {
+        markForResolution(&clonedRib->v6, prefix);
+        worklistV6.push_back(prefix);
+      } else if (clonedRib->v6.prebuilt.erase(prefix)) {
+        markForResolution(&clonedRib->v6, prefix);
       }
     }
-    if (ribCloned.second.v6.cloned) {
-      auto rib = ribCloned.second.v6.rib.get();
-      setRoutesWithNhopsForResolution(rib);
-      for (auto& rt : rib->routes()) {
-        if (rt.value()->needResolve()) {
-          resolve(rt.value().get(), rib, &ribCloned.second);
-        }
+  };
+  while (!worklistV4.empty() || !worklistV6.empty()) {
+    if (!worklistV4.empty()) {
+      auto prefix = worklistV4.front();
+      worklistV4.pop_front();
+      for (auto iter = nhopsV4.lower_bound(prefix.network);
+           iter != nhopsV4.end()
+             && iter->first.inSubnet(prefix.network, prefix.mask);
+           ++iter) {
+        addDependent(iter->second);
+      }
+    } else {
+      auto prefix = worklistV6.front();
+      worklistV6.pop_front();
+      for (auto iter = nhopsV6.lower_bound(prefix.network);
+           iter != nhopsV6.end()
+             && iter->first.inSubnet(prefix.network, prefix.mask);
+           ++iter) {
+        addDependent(iter->second);
       }
     }
   }
+
+  // Finally re-resolve just the affected routes.  resolve() may pull in
+  // further routes recursively via getFwdInfoFromNhop(), but only routes
+  // marked above can still report needResolve().
+  for (const auto& prefix : affectedV4) {
+    auto route = clonedRib->v4.rib->exactMatch(prefix);
+    if (route && route->needResolve()) {
+      resolve(route.get(), clonedRib->v4.rib.get(), clonedRib);
+    }
+  }
+  for (const auto& prefix : affectedV6) {
+    auto route = clonedRib->v6.rib->exactMatch(prefix);
+    if (route && route->needResolve()) {
+      resolve(route.get(), clonedRib->v6.rib.get(), clonedRib);
+    }
+  }
+}
+
+void RouteUpdater::resolve() {
+  // Only re-resolve the routes changed through this updater and the routes
+  // that (recursively) resolve through them.  The dirty prefixes recorded
+  // by the add/delete helpers seed the closure; the reverse nexthop index
+  // finds the dependents without an O(table) resolution pass.
+  for (auto& ribCloned : clonedRibs_) {
+    if (ribCloned.second.v4.cloned || ribCloned.second.v6.cloned) {
+      resolveIncremental(&ribCloned.second);
+    }
+  }
 }
 
 std::shared_ptr<RouteTableMap> RouteUpdater::updateDone() {
   // resolve all routes
   resolve();
+  // Intern the freshly resolved transitions so the next occurrence of
+  // the same flap can reuse them. Prebuilt prefixes came out of the
+  // cache and are already interned.
+  if (FLAGS_route_flap_cache) {
+    for (auto& ribCloned : clonedRibs_) {
+      auto id = ribCloned.first;
+      auto& rib = ribCloned.second;
+      for (const auto& prefix : rib.v4.dirty) {
+        if (!rib.v4.prebuilt.count(prefix)) {
+          captureFlapEntry(id, &rib, rib.v4.rib.get(), prefix);
+        }
+      }
+      for (const auto& prefix : rib.v6.dirty) {
+        if (!rib.v6.prebuilt.count(prefix)) {
+          captureFlapEntry(id, &rib, rib.v6.rib.get(), prefix);
+        }
+      }
+    }
+  }
   RouteTableMap::NodeContainer map;
   bool changed = false;
   for (const auto& ribPair : clonedRibs_) {
@@ -632,13 +899,22 @@ bool RouteUpdater::dedupRoutes(const RibT* oldRib, RibT* newRib) {
       continue;
     }
     auto& newRt = newIter->value();
+    if (oldRt.get() == newRt.get()) {
+      // Shared with the old rib, i.e. untouched by this update.
+      continue;
+    }
     if (oldRt->isSame(newRt.get())) {
       // both routes are completely same, instead of using the new route,
       // we re-use the old route.
       newIter->value() = oldRt;
     } else {
       isSame = false;
-      newRt->inheritGeneration(*oldRt);
+      // An interned node reused from the flap cache is already
+      // published and keeps the generation from when it was first
+      // built; nothing consumes per-route generation ordering.
+      if (!newRt->isPublished()) {
+        newRt->inheritGeneration(*oldRt);
+      }
     }
   }
   if (newRoutes.size() != oldRoutes.size()) {
@@ -96,10 +96,19 @@ class RouteUpdater {
     struct RibV4 {
       std::shared_ptr<RouteTableRibV4> rib;
       bool cloned{false};
+      // Prefixes added, deleted, or whose nexthops were changed through
+      // this updater. Drives incremental resolution in resolve().
+      boost::container::flat_set<RoutePrefixV4> dirty;
+      // Dirty prefixes satisfied with an interned node from the flap
+      // cache. They arrive already resolved, so resolve() skips
+      // re-resolving them (their dependents are still re-resolved).
+      boost::container::flat_set<RoutePrefixV4> prebuilt;
     } v4;
     struct RibV6 {
       std::shared_ptr<RouteTableRibV6> rib;
       bool cloned{false};
+      boost::container::flat_set<RoutePrefixV6> dirty;
+      boost::container::flat_set<RoutePrefixV6> prebuilt;
     } v6;
   };
   boost::container::flat_map<RouterID, ClonedRib> clonedRibs_;
@@ -112,8 +121,6 @@ class RouteUpdater {
   template<typename RibT>
   auto makeClone(RibT* rib) -> decltype(rib->rib.get());
 
-  template<typename RibT>
-  void setRoutesWithNhopsForResolution(RibT* rib);
   // Helper functions to add or delete a route
   template<typename PrefixT, typename RibT, typename... Args>
   void addRoute(const PrefixT& prefix, RibT *rib, Args&&... args);
@@ -126,12 +133,34 @@ class RouteUpdater {
 
   // resolve all routes that are not resolved yet
   void resolve();
+  // Re-resolve only the routes touched through this updater, plus any
+  // routes that (recursively) resolve through them.
+  void resolveIncremental(ClonedRib* clonedRib);
+  // Clear the resolution state of a single route (cloning it first if it
+  // has been published) so the resolve() loop will re-resolve it.
+  template<typename RibT, typename PrefixT>
+  void markForResolution(RibT* ribCloned, const PrefixT& prefix);
   template<typename RouteT, typename RtRibT>
   void resolve(RouteT* rt, RtRibT* rib, ClonedRib* clonedRib);
   template<typename RtRibT, typename AddrT>
   void getFwdInfoFromNhop(RtRibT* nRib, ClonedRib* ribCloned,
       const AddrT& nh, bool* hasToCpuNhops, bool* hasDropNhops,
       RouteForwardNexthops* fwd);
+  /*
+   * Try to satisfy an add/update from the flap cache: if the same
+   * (prefix, nexthop set) transition was resolved before and every
+   * route those nexthops resolved through is unchanged, reinsert the
+   * interned node instead of cloning and re-resolving. Returns true if
+   * the interned node was used.
+   */
+  template<typename PrefixT, typename RibT>
+  bool tryReuseInterned(RouterID id, const PrefixT& prefix, RibT* ribCloned,
+                        ClientID clientId, const RouteNextHops& nhs);
+  // Intern the freshly resolved route for a dirty prefix into the flap
+  // cache, recording the routes its nexthops resolved through.
+  template<typename RtRibT, typename PrefixT>
+  void captureFlapEntry(RouterID id, ClonedRib* clonedRib, RtRibT* rib,
+                        const PrefixT& prefix);
   // Functions to deduplicate routing tables during sync mode
   template<typename RibT>
   bool dedupRoutes(const RibT* origRib, RibT* newRib);
@@ -0,0 +1,160 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/agent/FbossError.h"
+
+#include "fboss/agent/state/NodeBase-defs.h"
+#include "fboss/agent/state/ShardedNodeMap.h"
+#include <folly/dynamic.h>
+#include <folly/json.h>
+
+#define FBOSS_INSTANTIATE_SHARDED_NODE_MAP(MapType, TraitsType) \
+  template class \
+    ::facebook::fboss::NodeBaseT<MapType, ShardedNodeMapFields<TraitsType>>; \
+  template class ::facebook::fboss::ShardedNodeMapT<MapType, TraitsType>;
+
+namespace facebook { namespace fboss {
+
+template <typename MapTypeT, typename TraitsT>
+constexpr char ShardedNodeMapT<MapTypeT, TraitsT>::kExtraFields[];
+
+template <typename MapTypeT, typename TraitsT>
+constexpr char ShardedNodeMapT<MapTypeT, TraitsT>::kEntries[];
+
+template <typename MapTypeT, typename TraitsT>
+const std::shared_ptr<typename TraitsT::Node>&
+ShardedNodeMapT<MapTypeT, TraitsT>::getNode(KeyType key) const {
+  const auto& shard = getShards()[TraitsT::getShard(key)];
+  if (shard) {
+    auto iter = shard->find(key);
+    if (iter != shard->end()) {
+      return iter->second;
+    }
+  }
+  throw FbossError("No node ", key);
+}
+
+template <typename MapTypeT, typename TraitsT>
+std::shared_ptr<typename TraitsT::Node>
+ShardedNodeMapT<MapTypeT, TraitsT>::getNodeIf(KeyType key) const {
+  const auto& shard = getShards()[TraitsT::getShard(key)];
+  if (!shard) {
+    return nullptr;
+  }
+  auto iter = shard->find(key);
+  if (iter == shard->end()) {
+    return nullptr;
+  }
+  return iter->second;
+}
+
+template <typename MapTypeT, typename TraitsT>
+typename ShardedNodeMapT<MapTypeT, TraitsT>::NodeContainer&
+ShardedNodeMapT<MapTypeT, TraitsT>::writableShard(const KeyType& key) {
+  auto& shard = this->writableFields()->shards[TraitsT::getShard(key)];
+  if (!shard) {
+    shard = std::make_shared<NodeContainer>();
+  } else if (shard.use_count() > 1) {
+    // The shard is still shared with an older version of the map; copy
+    // just this shard before modifying it.
+    shard = std::make_shared<NodeContainer>(*shard);
+  }
+  return *shard;
+}
+
+template <typename MapTypeT, typename TraitsT>
+void ShardedNodeMapT<MapTypeT, TraitsT>::addNode(
+    const std::shared_ptr<Node>& node) {
+  auto key = TraitsT::getKey(node);
+  auto& shard = writableShard(key);
+  auto ret = shard.insert(std::make_pair(key, node));
+  if (!ret.second) {
+    throw FbossError("duplicate node ID ", key);
+  }
+  ++this->writableFields()->size;
+}
+
+template <typename MapTypeT, typename TraitsT>
+void ShardedNodeMapT<MapTypeT, TraitsT>::updateNode(
+    const std::shared_ptr<Node>& node) {
+  auto key = TraitsT::getKey(node);
+  auto& shard = writableShard(key);
+  auto it = shard.find(key);
+  if (it == shard.end()) {
+    throw FbossError("node ID ", key, " does not exist");
+  }
+  it->second = node;
+}
+
+template <typename MapTypeT, typename TraitsT>
+void ShardedNodeMapT<MapTypeT, TraitsT>::removeNode(
+    const std::shared_ptr<Node>& node) {
+  auto key = TraitsT::getKey(node);
+  auto& shard = writableShard(key);
+  auto it = shard.find(key);
+  if (it == shard.end()) {
+    throw FbossError("node ID ", key, " does not exist");
+  }
+  shard.erase(it);
+  --this->writableFields()->size;
+}
+
+template <typename MapTypeT, typename TraitsT>
+std::shared_ptr<typename TraitsT::Node>
+ShardedNodeMapT<MapTypeT, TraitsT>::removeNode(const KeyType& key) {
+  auto node = removeNodeIf(key);
+  if (!node) {
+    throw FbossError("node ID ", key, " does not exist");
+  }
+  return node;
+}
+
+template <typename MapTypeT, typename TraitsT>
+std::shared_ptr<typename TraitsT::Node>
+ShardedNodeMapT<MapTypeT, TraitsT>::removeNodeIf(const KeyType& key) {
+  if (!getNodeIf(key)) {
+    return nullptr;
+  }
+  auto& shard = writableShard(key);
+  auto it = shard.find(key);
+  std::shared_ptr<Node> node = it->second;
+  shard.erase(it);
+  --this->writableFields()->size;
+  return node;
+}
+
+template <typename MapTypeT, typename TraitsT>
+folly::dynamic ShardedNodeMapT<MapTypeT, TraitsT>::toFollyDynamic() const {
+  folly::dynamic nodesJson = folly::dynamic::array;
+  for (const auto& node: *this) {
+    nodesJson.push_back(node->toFollyDynamic());
+  }
+  folly::dynamic json = folly::dynamic::object;
+  json[kEntries] = std::move(nodesJson);
+  json[kExtraFields] = getExtraFields().toFollyDynamic();
+  return json;
+}
+
+template <typename MapTypeT, typename TraitsT>
+std::shared_ptr<MapTypeT>
+ShardedNodeMapT<MapTypeT, TraitsT>::fromFollyDynamic(
+    const folly::dynamic& nodesJson) {
+  auto nodeMap = std::make_shared<MapTypeT>();
+  auto entries = nodesJson[kEntries];
+  for (const auto& entry: entries) {
+    nodeMap->addNode(Node::fromFollyDynamic(entry));
+  }
+  nodeMap->writableExtraFields() =
+    ExtraFields::fromFollyDynamic(nodesJson[kExtraFields]);
+  return nodeMap;
+}
+
+}} // namespace facebook::fboss
@@ -0,0 +1,264 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <boost/container/flat_map.hpp>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+
+#include "fboss/agent/state/NodeBase.h"
+#include "fboss/agent/state/NodeMap.h"
+
+namespace facebook { namespace fboss {
+
+/*
+ * ShardedNodeMapT is a drop-in alternative to NodeMapT for maps with very
+ * large numbers of children (e.g. route tables).
+ *
+ * NodeMapT keeps all children in one flat_map, so every copy-on-write
+ * clone copies the full vector of refcounted pointers -- O(n) work and
+ * refcount traffic even when a single child changes. ShardedNodeMapT
+ * splits the children across a fixed number of shards, each itself a
+ * flat_map held by shared_ptr. clone() copies only the array of shard
+ * pointers, and a modification copies just the one shard holding the
+ * affected key.
+ *
+ * The traits' getShard() must be monotone with respect to the key
+ * ordering: key1 < key2 implies getShard(key1) <= getShard(key2).
+ * Iterating shard by shard then visits nodes in ascending key order, the
+ * same contract NodeMapT provides and NodeMapDelta relies on.
+ */
+
+template<typename KeyT, typename NodeT, typename ExtraT = NodeMapNoExtraFields>
+struct ShardedNodeMapTraits : public NodeMapTraits<KeyT, NodeT, ExtraT> {
+  enum : size_t { kNumShards = 256 };
+  // Number of consecutive keys mapped to the same shard by the default
+  // getShard() below.
+  enum : size_t { kShardBlockSize = 1024 };
+
+  /*
+   * Shard assignment for a key. The default maps consecutive blocks of
+   * kShardBlockSize keys to the same shard, which is monotone for any
+   * key type convertible to an unsigned integer. Traits for keys with a
+   * different ordering (e.g. route prefixes) must override this with
+   * their own monotone function.
+   */
+  static size_t getShard(const KeyT& key) {
+    auto block = static_cast<uint64_t>(key) / kShardBlockSize;
+    return std::min(static_cast<size_t>(block),
+                    static_cast<size_t>(kNumShards) - 1);
+  }
+};
+
+template <typename TraitsT>
+struct ShardedNodeMapFields {
+  typedef typename TraitsT::KeyType KeyType;
+  typedef typename TraitsT::Node Node;
+  typedef typename TraitsT::ExtraFields ExtraFields;
+  typedef boost::container::flat_map<KeyType, std::shared_ptr<Node>>
+    NodeContainer;
+  enum : size_t { kNumShards = TraitsT::kNumShards };
+  typedef std::array<std::shared_ptr<NodeContainer>, kNumShards> ShardArray;
+
+  ShardedNodeMapFields() {}
+  // The (compiler generated) copy constructor copies the shard pointers,
+  // not the shards themselves; that is what makes clone() cheap. Shards
+  // are copied one at a time as they are modified.
+
+  template<typename Fn>
+  void forEachChild(Fn fn) {
+    for (const auto& shard : shards) {
+      if (!shard) {
+        continue;
+      }
+      for (const auto& nodePtr : *shard) {
+        fn(nodePtr.second.get());
+      }
+    }
+    extra.forEachChild(fn);
+  }
+
+  ShardArray shards;
+  size_t size{0};
+  typename TraitsT::ExtraFields extra;
+};
+
+/*
+ * An iterator over all nodes of a ShardedNodeMapT, visiting the shards in
+ * order and the nodes within each shard in key order. Dereferencing
+ * returns only the Node, like NodeMapIterator.
+ */
+template <typename TraitsT>
+class ShardedNodeMapIterator
+    : public std::iterator<std::forward_iterator_tag,
+                           std::shared_ptr<typename TraitsT::Node>> {
+ public:
+  typedef typename TraitsT::Node Node;
+  typedef ShardedNodeMapFields<TraitsT> Fields;
+  typedef typename Fields::NodeContainer NodeContainer;
+
+  ShardedNodeMapIterator() {}
+
+  static ShardedNodeMapIterator begin(const Fields* fields) {
+    ShardedNodeMapIterator iter(fields, 0);
+    iter.skipEmptyShards();
+    return iter;
+  }
+  static ShardedNodeMapIterator end(const Fields* fields) {
+    return ShardedNodeMapIterator(fields, Fields::kNumShards);
+  }
+
+  const std::shared_ptr<Node>& operator*() const {
+    return it_->second;
+  }
+  const std::shared_ptr<Node>* operator->() const {
+    return &(it_->second);
+  }
+
+  ShardedNodeMapIterator& operator++() {
+    ++it_;
+    if (it_ == fields_->shards[shard_]->end()) {
+      ++shard_;
+      skipEmptyShards();
+    }
+    return *this;
+  }
+  ShardedNodeMapIterator operator++(int) {
+    ShardedNodeMapIterator tmp(*this);
+    ++(*this);
+    return tmp;
+  }
+
+  bool operator==(const ShardedNodeMapIterator& other) const {
+    if (shard_ != other.shard_) {
+      return false;
+    }
+    return shard_ == Fields::kNumShards || it_ == other.it_;
+  }
+  bool operator!=(const ShardedNodeMapIterator& other) const {
+    return !operator==(other);
+  }
+
+ private:
+  ShardedNodeMapIterator(const Fields* fields, size_t shard)
+    : fields_(fields),
+      shard_(shard) {}
+
+  // Position it_ at the start of the first non-empty shard at or after
+  // shard_, or move to the end position.
+  void skipEmptyShards() {
+    while (shard_ < Fields::kNumShards) {
+      const auto& shard = fields_->shards[shard_];
+      if (shard && !shard->empty()) {
+        it_ = shard->begin();
+        return;
+      }
+      ++shard_;
+    }
+    it_ = typename NodeContainer::const_iterator();
+  }
+
+  const Fields* fields_{nullptr};
+  size_t shard_{0};
+  typename NodeContainer::const_iterator it_;
+};
+
+/*
+ * A helper class for implementing state nodes that store a large set of
+ * Node children sharded by key. See the file comment for how this
+ * differs from NodeMapT.
+ */
+template <typename MapTypeT, typename TraitsT>
+class ShardedNodeMapT : public NodeBaseT<MapTypeT,
+                                         ShardedNodeMapFields<TraitsT>> {
+ public:
+  typedef TraitsT Traits;
+  typedef typename TraitsT::KeyType KeyType;
+  typedef typename TraitsT::Node Node;
+  typedef typename TraitsT::ExtraFields ExtraFields;
+  typedef MapTypeT MapType;
+  typedef ShardedNodeMapFields<TraitsT> Fields;
+  typedef typename Fields::NodeContainer NodeContainer;
+  typedef typename Fields::ShardArray ShardArray;
+  typedef ShardedNodeMapIterator<TraitsT> Iterator;
+
+  const std::shared_ptr<Node>& getNode(KeyType key) const;
+  std::shared_ptr<Node> getNodeIf(KeyType key) const;
+
+  size_t size() const {
+    return this->getFields()->size;
+  }
+
+  const ShardArray& getShards() const {
+    return this->getFields()->shards;
+  }
+
+  const ExtraFields& getExtraFields() const {
+    return this->getFields()->extra;
+  }
+  ExtraFields& writableExtraFields() {
+    return this->writableFields()->extra;
+  }
+
+  Iterator begin() const {
+    return Iterator::begin(this->getFields());
+  }
+  Iterator end() const {
+    return Iterator::end(this->getFields());
+  }
+
+  /*
+   * The following functions modify the static state.
+   * These should only be called on unpublished objects which are only visible
+   * to a single thread.
+   */
+  void addNode(const std::shared_ptr<Node>& node);
+  void updateNode(const std::shared_ptr<Node>& node);
+  void removeNode(const std::shared_ptr<Node>& node);
+  std::shared_ptr<Node> removeNode(const KeyType& key);
+  std::shared_ptr<Node> removeNodeIf(const KeyType& key);
+
+  /*
+   * Serialize to folly::dynamic
+   */
+  folly::dynamic toFollyDynamic() const override;
+
+  /*
+   * Deserialize from json string
+   */
+  static std::shared_ptr<MapTypeT> fromJson(const folly::fbstring& jsonStr) {
+    return fromFollyDynamic(folly::parseJson(jsonStr));
+  }
+
+  /*
+   * Deserialize from folly::dynamic
+   */
+  static std::shared_ptr<MapTypeT>
+    fromFollyDynamic(const folly::dynamic& json);
+
+  static constexpr char kExtraFields[] = "extraFields";
+  static constexpr char kEntries[] = "entries";
+
+ private:
+  /*
+   * Return a writable version of the shard for the given key, copying
+   * the shard first if it is still shared with an older version of the
+   * map.
+   */
+  NodeContainer& writableShard(const KeyType& key);
+
+  // Inherit the constructor required for clone()
+  using NodeBaseT<MapTypeT, ShardedNodeMapFields<TraitsT>>::NodeBaseT;
+  friend class CloneAllocator;
+};
+
+}} // namespace facebook::fboss
@@ -58,6 +58,41 @@ NodeMapDelta<AclMap> StateDelta::getAclsDelta() const {
   return NodeMapDelta<AclMap>(old_->getAcls().get(), new_->getAcls().get());
 }
 
+uint32_t StateDelta::changedSections() const {
+  if (changedSections_) {
+    return *changedSections_;
+  }
+  uint32_t changed = 0;
+  if (old_->getPorts() != new_->getPorts()) {
+    changed |= SECTION_PORTS;
+  }
+  if (old_->getVlans() != new_->getVlans()) {
+    changed |= SECTION_VLANS;
+  }
+  if (old_->getInterfaces() != new_->getInterfaces()) {
+    changed |= SECTION_INTERFACES;
+  }
+  if (old_->getRouteTables() != new_->getRouteTables()) {
+    changed |= SECTION_ROUTE_TABLES;
+  }
+  if (old_->getAcls() != new_->getAcls()) {
+    changed |= SECTION_ACLS;
+  }
+  // The scalar settings live directly on the SwitchState rather than in
+  // their own copy-on-write node, so compare the values themselves.
+  if (old_->getDefaultVlan() != new_->getDefaultVlan() ||
+      old_->getArpTimeout() != new_->getArpTimeout() ||
+      old_->getNdpTimeout() != new_->getNdpTimeout() ||
+      old_->getArpAgerInterval() != new_->getArpAgerInterval() ||
+      old_->getMaxNeighborProbes() != new_->getMaxNeighborProbes() ||
+      old_->getStaleEntryInterval() != new_->getStaleEntryInterval() ||
+      old_->getCpuQueues() != new_->getCpuQueues()) {
+    changed |= SECTION_SWITCH_SETTINGS;
+  }
+  changedSections_ = changed;
+  return changed;
+}
+
 // Explicit instantiations of NodeMapDelta that are used by StateDelta.
 // This prevents users of StateDelta from needing to include
 // NodeMapDelta-defs.h
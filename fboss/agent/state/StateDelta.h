@@ -12,6 +12,8 @@
 #include <functional>
 #include <memory>
 
+#include <folly/Optional.h>
+
 #include "fboss/agent/state/AclMap.h"
 #include "fboss/agent/state/DeltaFunctions.h"
 #include "fboss/agent/state/InterfaceMap.h"
@@ -50,6 +52,26 @@ class StateDelta {
   RTMapDelta getRouteTablesDelta() const;
   NodeMapDelta<AclMap> getAclsDelta() const;
 
+  /*
+   * Which sections of the SwitchState differ between the two states.
+   *
+   * Since SwitchState is copy-on-write, this is computed with a handful
+   * of pointer comparisons (plus value comparisons for the scalar
+   * settings stored directly on the state) rather than by walking any of
+   * the sub-deltas, and the result is cached on first use. Callers can
+   * consult it to skip sub-delta processing entirely for sections that
+   * did not change.
+   */
+  enum Section : uint32_t {
+    SECTION_PORTS = 0x01,
+    SECTION_VLANS = 0x02,
+    SECTION_INTERFACES = 0x04,
+    SECTION_ROUTE_TABLES = 0x08,
+    SECTION_ACLS = 0x10,
+    SECTION_SWITCH_SETTINGS = 0x20,
+  };
+  uint32_t changedSections() const;
+
  private:
   // Forbidden copy constructor and assignment operator
   StateDelta(StateDelta const &) = delete;
@@ -57,6 +79,8 @@ class StateDelta {
 
   std::shared_ptr<SwitchState> old_;
   std::shared_ptr<SwitchState> new_;
+  // Lazily computed changedSections() result.
+  mutable folly::Optional<uint32_t> changedSections_;
 };
 
 }} // facebook::fboss
@@ -9,8 +9,10 @@
  */
 #pragma once
 
+#include <chrono>
 #include <memory>
 
+#include <folly/AtomicIntrusiveLinkedList.h>
 #include <folly/IntrusiveList.h>
 #include <folly/FBString.h>
 
@@ -32,9 +34,34 @@ class SwitchState;
  */
 class StateUpdate {
  public:
-  explicit StateUpdate(folly::StringPiece name, bool allowCoalesce = true)
+  /*
+   * Scheduling class of an update.
+   *
+   * The update thread orders each sweep of drained updates by class:
+   * URGENT runs before NORMAL, NORMAL before BULK, while relative order
+   * within a class is preserved.  Lower numeric values run first, and
+   * aging in SwSwitch promotes an update that has waited too long to
+   * the next higher class so bulk work cannot be starved forever.
+   */
+  enum class Priority : uint8_t {
+    // Fix-the-dataplane updates: port down, neighbor flush.  Must never
+    // wait behind queued bulk work, and must therefore not depend on
+    // being ordered after earlier updates.
+    URGENT = 0,
+    // The default for everything without an explicit tag.
+    NORMAL = 1,
+    // Large background work such as a full FIB sync or a
+    // monitoring-triggered config reapply.
+    BULK = 2,
+  };
+  static constexpr size_t kNumPriorities = 3;
+
+  explicit StateUpdate(folly::StringPiece name,
+                       bool allowCoalesce = true,
+                       Priority priority = Priority::NORMAL)
       : name_(name.str()),
-        allowCoalesce_(allowCoalesce) {}
+        allowCoalesce_(allowCoalesce),
+        priority_(priority) {}
   virtual ~StateUpdate() {}
 
   const std::string& getName() const {
@@ -45,6 +72,53 @@ class StateUpdate {
     return allowCoalesce_;
   }
 
+  Priority getPriority() const {
+    return priority_;
+  }
+
+  bool isUrgent() const {
+    return priority_ == Priority::URGENT;
+  }
+
+  /*
+   * Convergence tracing.
+   *
+   * Each update carries a timestamp per pipeline stage, recorded as it
+   * moves from the producer thread through the update thread to
+   * hardware programming completion. SwSwitch aggregates the stage
+   * deltas into histograms and keeps the slowest recent traces for the
+   * getConvergenceTraces() thrift call, answering "how long from
+   * updateState() to packets flowing on the new state".
+   */
+  enum TraceStage : uint8_t {
+    TRACE_ENQUEUE = 0,  // queued on the pending update list
+    TRACE_APPLY = 1,    // update function about to run on the update thread
+    TRACE_HW_SYNC = 2,  // batch delta handed to the hardware
+    TRACE_HW_DONE = 3,  // hardware programming complete, state published
+    TRACE_NUM_STAGES = 4,
+  };
+  typedef std::chrono::steady_clock::time_point TracePoint;
+
+  void traceStamp(TraceStage stage) {
+    traceStampAt(stage, std::chrono::steady_clock::now());
+    if (stage == TRACE_ENQUEUE) {
+      enqueuedAt_ = std::chrono::system_clock::now();
+    }
+  }
+  // Stages shared by a whole update batch (the hardware sync) are
+  // stamped with the batch's timestamps rather than per-update reads.
+  void traceStampAt(TraceStage stage, TracePoint when) {
+    traceTime_[stage] = when;
+  }
+  TracePoint getTraceTime(TraceStage stage) const {
+    return traceTime_[stage];
+  }
+  // Wall clock time the update was enqueued, for correlating traces
+  // with external events.
+  std::chrono::system_clock::time_point getEnqueuedAt() const {
+    return enqueuedAt_;
+  }
+
   /*
    * Apply the update, and return a new SwitchState.
    *
@@ -79,11 +153,18 @@ class StateUpdate {
 
   std::string name_;
   bool allowCoalesce_;
+  Priority priority_;
+  TracePoint traceTime_[TRACE_NUM_STAGES];
+  std::chrono::system_clock::time_point enqueuedAt_;
 
-  // An intrusive list hook for maintaining the list of pending updates.
+  // A lock-free hook used by producer threads to enqueue this update on
+  // the SwSwitch pending update queue without taking a lock.
+  folly::AtomicIntrusiveLinkedListHook<StateUpdate> nextUpdate_;
+  // An intrusive list hook for maintaining the list of updates drained
+  // from the queue by the update thread.
   folly::IntrusiveListHook listHook_;
-  // The SwSwitch code needs access to our listHook_ member so it can maintain
-  // the update list.
+  // The SwSwitch code needs access to our hook members so it can maintain
+  // the update queue.
   friend class SwSwitch;
 };
 
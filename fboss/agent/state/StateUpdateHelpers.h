@@ -18,6 +18,7 @@
 
 #include <folly/Range.h>
 #include <folly/String.h>
+#include <folly/futures/Promise.h>
 #include "fboss/agent/state/StateUpdate.h"
 
 namespace facebook { namespace fboss {
@@ -29,8 +30,9 @@ class FunctionStateUpdate : public StateUpdate {
     StateUpdateFn;
 
   FunctionStateUpdate(folly::StringPiece name, StateUpdateFn fn,
-                      bool allowCoalesce = true)
-    : StateUpdate(name, allowCoalesce),
+                      bool allowCoalesce = true,
+                      Priority priority = Priority::NORMAL)
+    : StateUpdate(name, allowCoalesce, priority),
       function_(fn) {}
 
   std::shared_ptr<SwitchState> applyUpdate(
@@ -92,6 +94,52 @@ class BlockingUpdateResult {
   bool done_{false};
 };
 
+/*
+ * A StateUpdate that fulfills a folly::Promise once the update has been
+ * applied (or has failed).
+ *
+ * This serves callers that cannot afford to park their thread the way
+ * BlockingStateUpdate does -- notably Thrift workers -- and instead
+ * chain any follow-up work on the corresponding Future. Both callbacks
+ * run in the update thread, so continuations that should not run there
+ * need to be attached via an executor.
+ */
+class FutureStateUpdate : public StateUpdate {
+ public:
+  typedef std::function<
+    std::shared_ptr<SwitchState>(const std::shared_ptr<SwitchState>&)>
+    StateUpdateFn;
+
+  FutureStateUpdate(folly::StringPiece name,
+                    StateUpdateFn fn,
+                    folly::Promise<folly::Unit> promise,
+                    bool allowCoalesce = true,
+                    Priority priority = Priority::NORMAL)
+    : StateUpdate(name, allowCoalesce, priority),
+      function_(fn),
+      promise_(std::move(promise)) {}
+
+  std::shared_ptr<SwitchState> applyUpdate(
+      const std::shared_ptr<SwitchState>& origState) override {
+    return function_(origState);
+  }
+
+  void onError(const std::exception& ex) noexcept override {
+    // As in BlockingStateUpdate, std::current_exception() is used so the
+    // original exception type survives the trip across threads.
+    promise_.setException(
+        folly::exception_wrapper(std::current_exception(), ex));
+  }
+
+  void onSuccess() override {
+    promise_.setValue();
+  }
+
+ private:
+  StateUpdateFn function_;
+  folly::Promise<folly::Unit> promise_;
+};
+
 class BlockingStateUpdate : public StateUpdate {
  public:
   typedef std::function<
@@ -101,8 +149,9 @@ class BlockingStateUpdate : public StateUpdate {
   BlockingStateUpdate(folly::StringPiece name,
                       StateUpdateFn fn,
                       std::shared_ptr<BlockingUpdateResult> result,
-                      bool allowCoalesce = true)
-    : StateUpdate(name, allowCoalesce),
+                      bool allowCoalesce = true,
+                      Priority priority = Priority::NORMAL)
+    : StateUpdate(name, allowCoalesce, priority),
       function_(fn),
       result_(result) {}
 
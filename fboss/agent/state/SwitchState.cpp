@@ -23,6 +23,8 @@
 
 #include "fboss/agent/state/NodeBase-defs.h"
 
+#include <atomic>
+
 using std::make_shared;
 using std::shared_ptr;
 using std::chrono::seconds;
@@ -77,6 +79,26 @@ SwitchStateFields::fromFollyDynamic(const folly::dynamic& swJson) {
   return switchState;
 }
 
+namespace {
+std::atomic<uint32_t> liveSwitchStates{0};
+}
+
+SwitchState::LiveStateCounter::LiveStateCounter() {
+  liveSwitchStates.fetch_add(1, std::memory_order_relaxed);
+}
+
+SwitchState::LiveStateCounter::LiveStateCounter(const LiveStateCounter&) {
+  liveSwitchStates.fetch_add(1, std::memory_order_relaxed);
+}
+
+SwitchState::LiveStateCounter::~LiveStateCounter() {
+  liveSwitchStates.fetch_sub(1, std::memory_order_relaxed);
+}
+
+uint32_t SwitchState::getLiveStateCount() {
+  return liveSwitchStates.load(std::memory_order_relaxed);
+}
+
 SwitchState::SwitchState() {
 }
 
@@ -136,6 +158,10 @@ void SwitchState::setMaxNeighborProbes(uint32_t maxNeighborProbes) {
   writableFields()->maxNeighborProbes = maxNeighborProbes;
 }
 
+void SwitchState::setCpuQueues(std::vector<cfg::CPUQueueConfig> cpuQueues) {
+  writableFields()->cpuQueues = std::move(cpuQueues);
+}
+
 void SwitchState::setStaleEntryInterval(seconds interval) {
   writableFields()->staleEntryInterval = interval;
 }
@@ -11,12 +11,14 @@
 
 #include <chrono>
 #include <memory>
+#include <vector>
 
 #include <folly/FBString.h>
 #include <folly/dynamic.h>
 #include <folly/Memory.h>
 
 #include "fboss/agent/types.h"
+#include "fboss/agent/gen-cpp2/switch_config_types.h"
 #include "fboss/agent/state/NodeBase.h"
 
 namespace facebook { namespace fboss {
@@ -72,6 +74,10 @@ struct SwitchStateFields {
   // agent restart on our neighbors
   uint32_t maxNeighborProbes{300};
   std::chrono::seconds staleEntryInterval{10};
+
+  // CPU CoS queue settings; reapplied from the config on every start,
+  // like the timeout settings above
+  std::vector<cfg::CPUQueueConfig> cpuQueues;
 };
 
 /*
@@ -114,6 +120,17 @@ class SwitchState : public NodeBaseT<SwitchState, SwitchStateFields> {
   SwitchState();
   ~SwitchState() override;
 
+  /*
+   * Number of SwitchState instances currently alive in the process.
+   *
+   * Every state update creates a new generation, and old generations
+   * stay alive for as long as any reader still holds the shared_ptr it
+   * got from SwSwitch::getState(). During route churn a slow reader can
+   * pin dozens of full route-table generations, so this count is
+   * exported as a gauge to make that memory multiplier observable.
+   */
+  static uint32_t getLiveStateCount();
+
   static std::shared_ptr<SwitchState>
   fromFollyDynamic(const folly::dynamic& json) {
     const auto& fields = SwitchStateFields::fromFollyDynamic(json);
@@ -198,6 +215,12 @@ class SwitchState : public NodeBaseT<SwitchState, SwitchStateFields> {
 
   void setStaleEntryInterval(std::chrono::seconds interval);
 
+  const std::vector<cfg::CPUQueueConfig>& getCpuQueues() const {
+    return getFields()->cpuQueues;
+  }
+
+  void setCpuQueues(std::vector<cfg::CPUQueueConfig> cpuQueues);
+
 
   /*
    * The following functions modify the static state.
@@ -218,6 +241,21 @@ class SwitchState : public NodeBaseT<SwitchState, SwitchStateFields> {
   void resetAcls(std::shared_ptr<AclMap> acls);
 
  private:
+  /*
+   * Counts live SwitchState instances via construction/destruction of a
+   * member, so every constructor path (including the inherited ones used
+   * by clone() and deserialization) is accounted for.
+   */
+  struct LiveStateCounter {
+    LiveStateCounter();
+    LiveStateCounter(const LiveStateCounter&);
+    LiveStateCounter& operator=(const LiveStateCounter&) {
+      return *this;
+    }
+    ~LiveStateCounter();
+  };
+  LiveStateCounter liveStateCounter_;
+
   // Inherit the constructor required for clone()
   using NodeBaseT::NodeBaseT;
   friend class CloneAllocator;
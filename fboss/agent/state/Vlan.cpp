@@ -64,7 +64,9 @@ VlanFields::PortInfo::fromFollyDynamic(const folly::dynamic& json) {
 
 VlanFields::VlanFields(VlanID _id, string _name)
   : id(_id),
-    name(std::move(_name)),
+    config(std::make_shared<const ConfigFields>(
+        ConfigFields{InternedString::intern(_name),
+                     IPAddressV4(), IPAddressV6(), {}, {}})),
     arpTable(new ArpTable),
     arpResponseTable(new ArpResponseTable),
     ndpTable(new NdpTable),
@@ -78,10 +80,9 @@ VlanFields::VlanFields(VlanID _id,
                        IPAddressV6 v6Relay,
                        MemberPorts&& ports)
   : id(_id),
-    name(std::move(_name)),
+    config(std::make_shared<const ConfigFields>(
+        ConfigFields{InternedString::intern(_name), v4Relay, v6Relay, {}, {}})),
     intfID(_intfID),
-    dhcpV4Relay(v4Relay),
-    dhcpV6Relay(v6Relay),
     ports(std::move(ports)),
     arpTable(new ArpTable),
     arpResponseTable(new ArpResponseTable),
@@ -92,16 +93,16 @@ VlanFields::VlanFields(VlanID _id,
 folly::dynamic VlanFields::toFollyDynamic() const {
   folly::dynamic vlan = folly::dynamic::object;
   vlan[kVlanId] = static_cast<uint16_t>(id);
-  vlan[kVlanName] = name;
+  vlan[kVlanName] = config->name.str();
   vlan[kIntfID] = static_cast<uint32_t>(intfID);
-  vlan[kDhcpV4Relay] = dhcpV4Relay.str();
-  vlan[kDhcpV6Relay] = dhcpV6Relay.str();
+  vlan[kDhcpV4Relay] = config->dhcpV4Relay.str();
+  vlan[kDhcpV6Relay] = config->dhcpV6Relay.str();
   vlan[kDhcpV4RelayOverrides] = folly::dynamic::object;
-  for (const auto& o: dhcpRelayOverridesV4) {
+  for (const auto& o: config->dhcpRelayOverridesV4) {
     vlan[kDhcpV4RelayOverrides][o.first.toString()] = o.second.str();
   }
   vlan[kDhcpV6RelayOverrides] = folly::dynamic::object;
-  for (const auto& o: dhcpRelayOverridesV6) {
+  for (const auto& o: config->dhcpRelayOverridesV6) {
     vlan[kDhcpV6RelayOverrides][o.first.toString()] = o.second.str();
   }
   folly::dynamic memberPorts = folly::dynamic::object;
@@ -122,18 +123,20 @@ VlanFields VlanFields::fromFollyDynamic(const folly::dynamic& vlanJson) {
   VlanFields vlan(VlanID(vlanJson[kVlanId].asInt()),
       vlanJson[kVlanName].asString());
   vlan.intfID = InterfaceID(vlanJson[kIntfID].asInt());
-  vlan.dhcpV4Relay = folly::IPAddressV4(
+  auto config = std::make_shared<ConfigFields>(*vlan.config);
+  config->dhcpV4Relay = folly::IPAddressV4(
       vlanJson[kDhcpV4Relay].stringPiece());
-  vlan.dhcpV6Relay = folly::IPAddressV6(
+  config->dhcpV6Relay = folly::IPAddressV6(
       vlanJson[kDhcpV6Relay].stringPiece());
   for (const auto& o: vlanJson[kDhcpV4RelayOverrides].items()) {
-    vlan.dhcpRelayOverridesV4[MacAddress(o.first.asString())] =
+    config->dhcpRelayOverridesV4[MacAddress(o.first.asString())] =
         folly::IPAddressV4(o.second.stringPiece());
   }
   for (const auto& o: vlanJson[kDhcpV6RelayOverrides].items()) {
-    vlan.dhcpRelayOverridesV6[MacAddress(o.first.asString())] =
+    config->dhcpRelayOverridesV6[MacAddress(o.first.asString())] =
         folly::IPAddressV6(o.second.stringPiece());
   }
+  vlan.config = std::move(config);
   for (const auto& portInfo: vlanJson[kMemberPorts].items()) {
     vlan.ports.emplace(PortID(to<uint16_t>(portInfo.first.asString())),
           PortInfo::fromFollyDynamic(portInfo.second));
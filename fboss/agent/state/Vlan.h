@@ -12,6 +12,7 @@
 #include <folly/IPAddressV4.h>
 #include <folly/IPAddressV6.h>
 #include <folly/MacAddress.h>
+#include "fboss/agent/InternedString.h"
 #include "fboss/agent/types.h"
 #include "fboss/agent/state/NodeBase.h"
 #include "fboss/agent/state/ArpResponseTable.h"
@@ -20,6 +21,7 @@
 #include "fboss/agent/state/NdpTable.h"
 
 #include <boost/container/flat_map.hpp>
+#include <memory>
 #include <set>
 #include <string>
 #include <map>
@@ -52,6 +54,23 @@ struct VlanFields {
   };
   typedef boost::container::flat_map<PortID, PortInfo> MemberPorts;
 
+  /*
+   * Config-only fields that operational updates (neighbor table
+   * changes in particular) never touch. They are kept in their own
+   * block shared between clones, so cloning a vlan for a neighbor
+   * update copies one shared_ptr instead of the name string and the
+   * DHCP relay maps. The block is immutable once shared; the mutators
+   * in Vlan replace it with a fresh copy (copy-on-write).
+   */
+  struct ConfigFields {
+    // Interned: vlan names come from config, a bounded vocabulary
+    InternedString name;
+    folly::IPAddressV4 dhcpV4Relay;
+    folly::IPAddressV6 dhcpV6Relay;
+    DhcpV4OverrideMap dhcpRelayOverridesV4;
+    DhcpV6OverrideMap dhcpRelayOverridesV6;
+  };
+
   VlanFields(VlanID id, std::string name);
   VlanFields(VlanID id,
              std::string name,
@@ -72,12 +91,8 @@ struct VlanFields {
   static VlanFields fromFollyDynamic(const folly::dynamic& vlanJson);
 
   const VlanID id{0};
-  std::string name;
+  std::shared_ptr<const ConfigFields> config;
   InterfaceID intfID{0};
-  folly::IPAddressV4 dhcpV4Relay;
-  folly::IPAddressV6 dhcpV6Relay;
-  DhcpV4OverrideMap dhcpRelayOverridesV4;
-  DhcpV6OverrideMap dhcpRelayOverridesV6;
   // The list of ports in the VLAN.
   // We only store PortIDs, and not pointers to the actual Port objects.
   // This way VLAN objects don't need to change when a Port object is modified.
@@ -121,7 +136,7 @@ class Vlan : public NodeBaseT<Vlan, VlanFields> {
   }
 
   const std::string& getName() const {
-    return getFields()->name;
+    return getFields()->config->name.str();
   }
 
   InterfaceID getInterfaceID() const {
@@ -133,7 +148,9 @@ class Vlan : public NodeBaseT<Vlan, VlanFields> {
   }
 
   void setName(std::string name) {
-    writableFields()->name = name;
+    auto config = cloneConfig();
+    config->name = InternedString::intern(name);
+    writableFields()->config = std::move(config);
   }
 
   const MemberPorts& getPorts() const {
@@ -187,36 +204,49 @@ class Vlan : public NodeBaseT<Vlan, VlanFields> {
   // dhcp relay
 
   folly::IPAddressV4 getDhcpV4Relay() const {
-    return getFields()->dhcpV4Relay;
+    return getFields()->config->dhcpV4Relay;
   }
   void setDhcpV4Relay(folly::IPAddressV4 v4Relay) {
-     writableFields()->dhcpV4Relay = v4Relay;
+    auto config = cloneConfig();
+    config->dhcpV4Relay = v4Relay;
+    writableFields()->config = std::move(config);
   }
 
   folly::IPAddressV6 getDhcpV6Relay() const {
-    return getFields()->dhcpV6Relay;
+    return getFields()->config->dhcpV6Relay;
   }
   void setDhcpV6Relay(folly::IPAddressV6 v6Relay) {
-     writableFields()->dhcpV6Relay = v6Relay;
+    auto config = cloneConfig();
+    config->dhcpV6Relay = v6Relay;
+    writableFields()->config = std::move(config);
   }
 
   // dhcp overrides
 
   DhcpV4OverrideMap getDhcpV4RelayOverrides() const {
-    return getFields()->dhcpRelayOverridesV4;
+    return getFields()->config->dhcpRelayOverridesV4;
   }
   void setDhcpV4RelayOverrides(DhcpV4OverrideMap map) {
-    writableFields()->dhcpRelayOverridesV4 = map;
+    auto config = cloneConfig();
+    config->dhcpRelayOverridesV4 = std::move(map);
+    writableFields()->config = std::move(config);
   }
 
   DhcpV6OverrideMap getDhcpV6RelayOverrides() const {
-    return getFields()->dhcpRelayOverridesV6;
+    return getFields()->config->dhcpRelayOverridesV6;
   }
   void setDhcpV6RelayOverrides(DhcpV6OverrideMap map) {
-    writableFields()->dhcpRelayOverridesV6 = map;
+    auto config = cloneConfig();
+    config->dhcpRelayOverridesV6 = std::move(map);
+    writableFields()->config = std::move(config);
   }
 
  private:
+  // Copy the shared config block so a mutator can change it
+  std::shared_ptr<VlanFields::ConfigFields> cloneConfig() const {
+    return std::make_shared<VlanFields::ConfigFields>(*getFields()->config);
+  }
+
   // Inherit the constructors required for clone()
   using NodeBaseT::NodeBaseT;
   friend class CloneAllocator;
@@ -0,0 +1,154 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+namespace cpp2 facebook.fboss.state
+namespace py fboss.switch_state
+
+include "common/network/if/Address.thrift"
+include "fboss/agent/if/ctrl.thrift"
+
+/*
+ * Typed, compact counterparts of the folly::dynamic serialization
+ * implemented by the state node classes under fboss/agent/state.
+ *
+ * The dynamic form builds a string-keyed map per field per node, which
+ * is fine for one-off debug dumps but far too slow at FIB scale. Nodes
+ * grow a parallel toThrift()/fromThrift() interface over these structs;
+ * a struct here must stay in sync with the node's field list the same
+ * way its toFollyDynamic() does. Serialized with a binary protocol this
+ * is the basis for compact state snapshots.
+ */
+
+enum RouteForwardAction {
+  DROP = 0,
+  TO_CPU = 1,
+  NEXTHOPS = 2,
+}
+
+struct RoutePrefix {
+  1: required Address.BinaryAddress network,
+  2: required i16 mask,
+}
+
+struct RouteNexthop {
+  1: required i32 interfaceId,
+  2: required Address.BinaryAddress nexthop,
+}
+
+struct RouteForwardInfo {
+  1: required RouteForwardAction action,
+  2: required list<RouteNexthop> nexthops,
+}
+
+struct RouteFields {
+  1: required RoutePrefix prefix,
+  2: required list<ctrl.ClientAndNextHops> nexthopsMulti,
+  3: required RouteForwardInfo fwd,
+  4: required i32 flags,
+}
+
+struct RouteTableFields {
+  1: required i32 routerId,
+  2: required list<RouteFields> routesV4,
+  3: required list<RouteFields> routesV6,
+}
+
+/*
+ * A point-in-time dump of every route table. Saved in compact binary
+ * form when the FIB syncs and on graceful exit, and read back on warm
+ * boot to preload routes before the route server replays the live
+ * table.
+ */
+struct FibSnapshot {
+  1: required list<RouteTableFields> tables,
+  /*
+   * The update journal sequence number current when this snapshot was
+   * taken.  Crash recovery replays journal records with a higher
+   * sequence over the snapshot; absent when the journal is disabled.
+   */
+  2: optional i64 journalSequence,
+}
+
+/*
+ * One route's client next hop changes from an applied state update, as
+ * recorded in the update journal.  removedClients lists the clients
+ * whose next hop sets the update dropped for this prefix (all of them,
+ * for a removed route); nexthopsMulti carries the client next hop sets
+ * it added or replaced.
+ */
+struct JournalRouteEntry {
+  1: required i32 routerId,
+  2: required RoutePrefix prefix,
+  3: required list<i32> removedClients,
+  4: required list<ctrl.ClientAndNextHops> nexthopsMulti,
+}
+
+/*
+ * One applied state update's route changes.  SwSwitch::applyUpdate
+ * appends these to the memory-mapped update journal ring; after a
+ * crash restart they are replayed in sequence order over the last FIB
+ * snapshot, bringing crash recovery close to warm boot speed without
+ * waiting for the route server to resync.
+ */
+struct JournalRecord {
+  1: required i64 sequence,
+  2: required i64 timestampMs,
+  3: required list<JournalRouteEntry> routes,
+}
+
+struct NeighborEntryFields {
+  1: required Address.BinaryAddress ip,
+  2: required string mac,
+  3: required i32 port,
+  4: required i32 interfaceId,
+}
+
+struct NeighborTableFields {
+  1: required i32 vlanId,
+  2: required list<NeighborEntryFields> entriesV4,
+  3: required list<NeighborEntryFields> entriesV6,
+}
+
+/*
+ * The resolved ARP/NDP entries of every vlan. Saved in compact binary
+ * form on graceful exit and restored into the neighbor caches on warm
+ * boot as STALE entries, so the post-restart probe storm becomes paced
+ * background revalidation.
+ */
+struct NeighborSnapshot {
+  1: required list<NeighborTableFields> tables,
+}
+
+struct PortFields {
+  1: required i32 portId,
+  2: required string name,
+  3: required string description,
+  4: required i32 adminState,
+  5: required bool operUp,
+  6: required i32 speedMbps,
+  7: required i32 ingressVlan,
+}
+
+struct PortSnapshot {
+  1: required list<PortFields> ports,
+}
+
+/*
+ * An on-demand operational state dump of selected subtrees, written in
+ * compact binary form by the dumpOperState() Thrift call. Unlike the
+ * folly::dynamic/JSON dump this is cheap enough to take during an
+ * incident; the pretty printing happens off box
+ * (fboss/agent/tools/dump_state.py).
+ */
+struct OperStateSnapshot {
+  1: required i64 timestampMs,
+  2: optional PortSnapshot ports,
+  3: optional NeighborSnapshot neighbors,
+  4: optional FibSnapshot fib,
+}
@@ -230,3 +230,53 @@ TEST(Acl, Icmp) {
   EXPECT_THROW(
     publishAndApplyConfig(stateV1, &config, platform.get()), FbossError);
 }
+
+TEST(Acl, softwareMatch) {
+  auto aclMap = make_shared<AclMap>();
+
+  auto permitSsh = make_shared<AclEntry>(AclEntryID(1));
+  permitSsh->setProto(6);
+  permitSsh->setDstL4PortRange(AclL4PortRange(22, 22));
+  permitSsh->setAction(cfg::AclAction::PERMIT);
+  aclMap->addEntry(permitSsh);
+
+  auto denyTcp = make_shared<AclEntry>(AclEntryID(2));
+  denyTcp->setProto(6);
+  denyTcp->setAction(cfg::AclAction::DENY);
+  aclMap->addEntry(denyTcp);
+
+  auto denySubnet = make_shared<AclEntry>(AclEntryID(3));
+  denySubnet->setSrcIp(folly::IPAddress::createNetwork("10.0.0.0/8"));
+  denySubnet->setAction(cfg::AclAction::DENY);
+  aclMap->addEntry(denySubnet);
+
+  AclPacketFields sshPkt;
+  sshPkt.srcIp = folly::IPAddress("10.1.1.1");
+  sshPkt.proto = 6;
+  sshPkt.l4DstPort = 22;
+
+  AclPacketFields httpPkt = sshPkt;
+  httpPkt.l4DstPort = 80;
+
+  AclPacketFields udpPkt;
+  udpPkt.srcIp = folly::IPAddress("10.1.1.1");
+  udpPkt.proto = 17;
+
+  AclPacketFields cleanPkt;
+  cleanPkt.srcIp = folly::IPAddress("192.168.1.1");
+  cleanPkt.proto = 17;
+
+  // Unpublished maps use the linear walk.
+  EXPECT_EQ(permitSsh, aclMap->getMatchingEntryIf(sshPkt));
+  EXPECT_EQ(denyTcp, aclMap->getMatchingEntryIf(httpPkt));
+  EXPECT_EQ(denySubnet, aclMap->getMatchingEntryIf(udpPkt));
+  EXPECT_EQ(nullptr, aclMap->getMatchingEntryIf(cleanPkt));
+
+  // The compiled matcher built at publish() must classify identically,
+  // including preferring the lower ID among entries that both match.
+  aclMap->publish();
+  EXPECT_EQ(permitSsh, aclMap->getMatchingEntryIf(sshPkt));
+  EXPECT_EQ(denyTcp, aclMap->getMatchingEntryIf(httpPkt));
+  EXPECT_EQ(denySubnet, aclMap->getMatchingEntryIf(udpPkt));
+  EXPECT_EQ(nullptr, aclMap->getMatchingEntryIf(cleanPkt));
+}
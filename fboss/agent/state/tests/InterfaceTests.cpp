@@ -86,6 +86,34 @@ TEST(Interface, addrToReach) {
   EXPECT_EQ(nullptr, ret.intf);
   EXPECT_EQ(nullptr, ret.addr);
   EXPECT_EQ(0, ret.mask);
+
+  // Publishing the state builds the derived lookup indexes; the indexed
+  // queries must return the same results as the linear scans above.
+  state->publish();
+  ASSERT_TRUE(intfs->isPublished());
+
+  ret = intfs->getIntfAddrToReach(RouterID(1), IPAddress("20.1.1.100"));
+  EXPECT_EQ(intf1.get(), ret.intf);
+  EXPECT_EQ(IPAddress("20.1.1.2"), *ret.addr);
+  EXPECT_EQ(24, ret.mask);
+
+  ret = intfs->getIntfAddrToReach(RouterID(2), IPAddress("::22:33:4f"));
+  EXPECT_EQ(intf2.get(), ret.intf);
+  EXPECT_EQ(IPAddress("::22:33:44"), *ret.addr);
+  EXPECT_EQ(120, ret.mask);
+
+  ret = intfs->getIntfAddrToReach(RouterID(2), IPAddress("::22:34:5f"));
+  EXPECT_EQ(nullptr, ret.intf);
+  EXPECT_EQ(nullptr, ret.addr);
+  EXPECT_EQ(0, ret.mask);
+
+  // No interfaces in this router at all.
+  ret = intfs->getIntfAddrToReach(RouterID(3), IPAddress("20.1.1.100"));
+  EXPECT_EQ(nullptr, ret.intf);
+
+  EXPECT_EQ(intf1, intfs->getInterfaceInVlanIf(VlanID(1)));
+  EXPECT_EQ(intf2, intfs->getInterfaceInVlanIf(VlanID(2)));
+  EXPECT_EQ(nullptr, intfs->getInterfaceInVlanIf(VlanID(3)));
 }
 
 TEST(Interface, applyConfig) {
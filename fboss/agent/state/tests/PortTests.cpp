@@ -119,6 +119,52 @@ TEST(Port, applyConfig) {
     publishAndApplyConfig(stateV3, &config, platform.get()), FbossError);
 }
 
+TEST(Port, sectionChangeDetection) {
+  auto platform = createMockPlatform();
+  auto stateV0 = make_shared<SwitchState>();
+  stateV0->registerPort(PortID(1), "port1");
+
+  cfg::SwitchConfig config;
+  config.ports.resize(1);
+  config.ports[0].logicalID = 1;
+  config.ports[0].name = "port1";
+  config.ports[0].state = cfg::PortState::UP;
+  config.vlans.resize(1);
+  config.vlans[0].id = 2;
+  config.vlanPorts.resize(1);
+  config.vlanPorts[0].logicalPort = 1;
+  config.vlanPorts[0].vlanID = 2;
+  config.vlanPorts[0].emitTags = false;
+  config.interfaces.resize(1);
+  config.interfaces[0].intfID = 2;
+  config.interfaces[0].vlanID = 2;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:00:00:00:00:22";
+
+  auto stateV1 = publishAndApplyConfig(stateV0, &config, platform.get());
+  ASSERT_NE(nullptr, stateV1);
+
+  // A one-line port change applied with the previous config supplied
+  // should rebuild only the ports and reuse all the other subtrees from
+  // the current state as-is.
+  auto prevConfig = config;
+  config.ports[0].description = "uplink";
+  auto stateV2 = publishAndApplyConfig(stateV1, &config, platform.get(),
+                                       &prevConfig);
+  ASSERT_NE(nullptr, stateV2);
+  EXPECT_NE(stateV1->getPorts(), stateV2->getPorts());
+  EXPECT_EQ("uplink", stateV2->getPort(PortID(1))->getDescription());
+  EXPECT_EQ(stateV1->getVlans(), stateV2->getVlans());
+  EXPECT_EQ(stateV1->getInterfaces(), stateV2->getInterfaces());
+  EXPECT_EQ(stateV1->getRouteTables(), stateV2->getRouteTables());
+  EXPECT_EQ(stateV1->getAcls(), stateV2->getAcls());
+
+  // Re-applying the same config with itself as the previous config
+  // should result in no changes at all.
+  EXPECT_EQ(nullptr,
+            publishAndApplyConfig(stateV2, &config, platform.get(), &config));
+}
+
 TEST(Port, initDefaultConfig) {
   auto platform = createMockPlatform();
   PortID portID(1);
@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/state/PublishTracker.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using std::make_shared;
+
+TEST(PublishTracker, publishesTrackedNodes) {
+  auto oldState = make_shared<SwitchState>();
+  oldState->addVlan(make_shared<Vlan>(VlanID(1), "Vlan1"));
+  oldState->publish();
+
+  // Everything constructed from here on is tracked.
+  PublishTracker tracker;
+  auto newState = oldState->clone();
+  newState->addVlan(make_shared<Vlan>(VlanID(2), "Vlan2"));
+  tracker.publishTracked();
+
+  // The cloned spine and the new VLAN are published without a recursive
+  // walk of the tree.
+  EXPECT_TRUE(newState->isPublished());
+  EXPECT_TRUE(newState->getVlans()->isPublished());
+  EXPECT_TRUE(newState->getVlans()->getVlan(VlanID(2))->isPublished());
+  // The unchanged VLAN is still the object shared with the old state.
+  EXPECT_EQ(oldState->getVlans()->getVlan(VlanID(1)),
+            newState->getVlans()->getVlan(VlanID(1)));
+}
+
+TEST(PublishTracker, discardedNodesUnregister) {
+  auto state = make_shared<SwitchState>();
+  state->publish();
+
+  PublishTracker tracker;
+  {
+    // A node that never makes it into the new tree must drop out of the
+    // tracked set when it is destroyed.
+    auto discarded = make_shared<Vlan>(VlanID(99), "discarded");
+  }
+  auto newState = state->clone();
+  tracker.publishTracked();
+  EXPECT_TRUE(newState->isPublished());
+}
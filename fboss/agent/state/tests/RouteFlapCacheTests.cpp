@@ -0,0 +1,192 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/test/TestUtils.h"
+#include "fboss/agent/hw/mock/MockPlatform.h"
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteFlapCache.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/RouteTableMap.h"
+#include "fboss/agent/state/RouteTableRib.h"
+#include "fboss/agent/state/RouteUpdater.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/gen-cpp2/switch_config_types.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::IPAddressV4;
+using folly::IPAddressV6;
+using std::make_shared;
+using std::shared_ptr;
+
+namespace {
+
+const ClientID kClientA(1001);
+const ClientID kClientB(1002);
+
+/*
+ * Build a published state with two interfaces, so nexthops in
+ * 1.1.1.0/24 resolve via intf 1 and nexthops in 2.2.2.0/24 via intf 2.
+ */
+shared_ptr<SwitchState> makeBaseState(MockPlatform* platform) {
+  auto stateV0 = make_shared<SwitchState>();
+  cfg::SwitchConfig config;
+  config.vlans.resize(2);
+  config.vlans[0].id = 1;
+  config.vlans[1].id = 2;
+  config.interfaces.resize(2);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:00:00:00:00:11";
+  config.interfaces[0].ipAddresses.resize(1);
+  config.interfaces[0].ipAddresses[0] = "1.1.1.1/24";
+  config.interfaces[1].intfID = 2;
+  config.interfaces[1].vlanID = 2;
+  config.interfaces[1].routerID = 0;
+  config.interfaces[1].__isset.mac = true;
+  config.interfaces[1].mac = "00:00:00:00:00:22";
+  config.interfaces[1].ipAddresses.resize(1);
+  config.interfaces[1].ipAddresses[0] = "2.2.2.2/24";
+  auto state = publishAndApplyConfig(stateV0, &config, platform);
+  CHECK(state != nullptr);
+  state->publish();
+  return state;
+}
+
+void clearFlapCaches() {
+  RouteFlapCache<IPAddressV4>::threadLocal()->clear();
+  RouteFlapCache<IPAddressV6>::threadLocal()->clear();
+}
+
+} // unnamed namespace
+
+TEST(RouteFlapCache, ReuseOnRepeatedFlap) {
+  clearFlapCaches();
+  auto platform = createMockPlatform();
+  auto state = makeBaseState(platform.get());
+  auto rid = RouterID(0);
+  RouteV4::Prefix prefix{IPAddressV4("10.1.1.0"), 24};
+  auto nhopA = makeNextHops({"1.1.1.10"});
+  auto nhopB = makeNextHops({"2.2.2.10"});
+
+  RouteUpdater u1(state->getRouteTables());
+  u1.addRoute(rid, prefix.network, prefix.mask, kClientA, nhopA);
+  auto tables1 = u1.updateDone();
+  ASSERT_NE(nullptr, tables1);
+  tables1->publish();
+  auto rtA = GET_ROUTE_V4(tables1, rid, prefix);
+
+  // Flap to the other nexthop set
+  RouteUpdater u2(tables1);
+  u2.addRoute(rid, prefix.network, prefix.mask, kClientA, nhopB);
+  auto tables2 = u2.updateDone();
+  ASSERT_NE(nullptr, tables2);
+  tables2->publish();
+  auto rtB = GET_ROUTE_V4(tables2, rid, prefix);
+  EXPECT_NE(rtA.get(), rtB.get());
+
+  // Flap back: the interned node from tables1 must be reused as-is
+  auto reusesBefore = RouteFlapCache<IPAddressV4>::threadLocal()->reuses();
+  RouteUpdater u3(tables2);
+  u3.addRoute(rid, prefix.network, prefix.mask, kClientA, nhopA);
+  auto tables3 = u3.updateDone();
+  ASSERT_NE(nullptr, tables3);
+  tables3->publish();
+  auto rtA2 = GET_ROUTE_V4(tables3, rid, prefix);
+  EXPECT_EQ(rtA.get(), rtA2.get());
+  EXPECT_EQ(reusesBefore + 1,
+            RouteFlapCache<IPAddressV4>::threadLocal()->reuses());
+  EXPECT_TRUE(rtA2->isResolved());
+  EXPECT_EQ(1, rtA2->getForwardInfo().getNexthops().size());
+  EXPECT_EQ(InterfaceID(1),
+            rtA2->getForwardInfo().getNexthops().begin()->intf);
+}
+
+TEST(RouteFlapCache, RevalidateOnResolutionChange) {
+  clearFlapCaches();
+  auto platform = createMockPlatform();
+  auto state = makeBaseState(platform.get());
+  auto rid = RouterID(0);
+  RouteV4::Prefix prefix{IPAddressV4("10.1.1.0"), 24};
+  auto nhopA = makeNextHops({"1.1.1.10"});
+  auto nhopB = makeNextHops({"2.2.2.10"});
+
+  RouteUpdater u1(state->getRouteTables());
+  u1.addRoute(rid, prefix.network, prefix.mask, kClientA, nhopA);
+  auto tables1 = u1.updateDone();
+  ASSERT_NE(nullptr, tables1);
+  tables1->publish();
+  auto rtA = GET_ROUTE_V4(tables1, rid, prefix);
+
+  RouteUpdater u2(tables1);
+  u2.addRoute(rid, prefix.network, prefix.mask, kClientA, nhopB);
+  auto tables2 = u2.updateDone();
+  ASSERT_NE(nullptr, tables2);
+  tables2->publish();
+
+  // A more specific route now covers the interned node's nexthop, so
+  // its recorded resolution inputs no longer hold
+  RouteUpdater u3(tables2);
+  u3.addRoute(rid, folly::IPAddress("1.1.1.8"), 29, kClientB,
+              makeNextHops({"2.2.2.20"}));
+  auto tables3 = u3.updateDone();
+  ASSERT_NE(nullptr, tables3);
+  tables3->publish();
+
+  // Flapping back must not reuse the stale interned node; the fresh
+  // resolution goes through the new more specific route
+  RouteUpdater u4(tables3);
+  u4.addRoute(rid, prefix.network, prefix.mask, kClientA, nhopA);
+  auto tables4 = u4.updateDone();
+  ASSERT_NE(nullptr, tables4);
+  tables4->publish();
+  auto rtA2 = GET_ROUTE_V4(tables4, rid, prefix);
+  EXPECT_NE(rtA.get(), rtA2.get());
+  EXPECT_TRUE(rtA2->isResolved());
+  EXPECT_EQ(InterfaceID(2),
+            rtA2->getForwardInfo().getNexthops().begin()->intf);
+}
+
+TEST(RouteFlapCache, NoReuseAcrossClients) {
+  clearFlapCaches();
+  auto platform = createMockPlatform();
+  auto state = makeBaseState(platform.get());
+  auto rid = RouterID(0);
+  RouteV4::Prefix prefix{IPAddressV4("10.1.1.0"), 24};
+  auto nhopA = makeNextHops({"1.1.1.10"});
+
+  RouteUpdater u1(state->getRouteTables());
+  u1.addRoute(rid, prefix.network, prefix.mask, kClientA, nhopA);
+  auto tables1 = u1.updateDone();
+  ASSERT_NE(nullptr, tables1);
+  tables1->publish();
+  auto rtA = GET_ROUTE_V4(tables1, rid, prefix);
+
+  RouteUpdater u2(tables1);
+  u2.addRoute(rid, prefix.network, prefix.mask, kClientA,
+              makeNextHops({"2.2.2.10"}));
+  auto tables2 = u2.updateDone();
+  ASSERT_NE(nullptr, tables2);
+  tables2->publish();
+
+  // Same prefix and nexthop set, but a different client: the interned
+  // single-client node would misrepresent the merged result
+  RouteUpdater u3(tables2);
+  u3.addRoute(rid, prefix.network, prefix.mask, kClientB, nhopA);
+  auto tables3 = u3.updateDone();
+  ASSERT_NE(nullptr, tables3);
+  tables3->publish();
+  auto rt = GET_ROUTE_V4(tables3, rid, prefix);
+  EXPECT_NE(rtA.get(), rt.get());
+  EXPECT_TRUE(rt->hasNextHopsForClient(kClientB));
+  EXPECT_TRUE(rt->hasNextHopsForClient(kClientA));
+}
@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteLookupCache.h"
+#include "fboss/agent/state/RouteTableRib.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::IPAddressV4;
+using std::make_shared;
+using std::shared_ptr;
+
+namespace {
+
+typedef Route<IPAddressV4> RouteV4;
+typedef RouteTableRib<IPAddressV4> RibV4;
+
+shared_ptr<RibV4> makeRib() {
+  auto rib = make_shared<RibV4>();
+  rib->addRoute(make_shared<RouteV4>(
+      RouteV4::Prefix{IPAddressV4("10.1.0.0"), 16}, RouteV4::Action::DROP));
+  rib->addRoute(make_shared<RouteV4>(
+      RouteV4::Prefix{IPAddressV4("10.1.2.0"), 24}, RouteV4::Action::TO_CPU));
+  return rib;
+}
+
+} // unnamed namespace
+
+TEST(RouteLookupCache, HitsAndMisses) {
+  auto rib = makeRib();
+  RouteLookupCache<IPAddressV4> cache;
+
+  IPAddressV4 addr("10.1.2.3");
+  auto route = cache.longestMatch(rib.get(), addr);
+  EXPECT_EQ(rib->longestMatch(addr), route);
+  EXPECT_EQ(0, cache.hits());
+  EXPECT_EQ(1, cache.misses());
+
+  // Repeat lookups for the same address are served from the cache
+  EXPECT_EQ(route, cache.longestMatch(rib.get(), addr));
+  EXPECT_EQ(route, cache.longestMatch(rib.get(), addr));
+  EXPECT_EQ(2, cache.hits());
+  EXPECT_EQ(1, cache.misses());
+
+  // A different address in the same rib is a miss, and returns the less
+  // specific match
+  IPAddressV4 addr2("10.1.3.4");
+  auto route2 = cache.longestMatch(rib.get(), addr2);
+  EXPECT_EQ(rib->longestMatch(addr2), route2);
+  EXPECT_NE(route, route2);
+  EXPECT_EQ(2, cache.misses());
+
+  // Negative results are cached too
+  IPAddressV4 noMatch("192.168.0.1");
+  EXPECT_EQ(nullptr, cache.longestMatch(rib.get(), noMatch));
+  EXPECT_EQ(nullptr, cache.longestMatch(rib.get(), noMatch));
+  EXPECT_EQ(3, cache.hits());
+  EXPECT_EQ(3, cache.misses());
+}
+
+TEST(RouteLookupCache, InvalidatedByNewRibVersion) {
+  auto rib = makeRib();
+  RouteLookupCache<IPAddressV4> cache;
+
+  IPAddressV4 addr("10.1.2.3");
+  auto route = cache.longestMatch(rib.get(), addr);
+  EXPECT_EQ(1, cache.misses());
+
+  // A route update produces a new rib with a bumped generation. The
+  // cached entry no longer matches and the lookup returns the new route.
+  auto newRib = rib->clone();
+  EXPECT_EQ(rib->getNodeID(), newRib->getNodeID());
+  EXPECT_EQ(rib->getGeneration() + 1, newRib->getGeneration());
+  auto newRoute = cache.longestMatch(newRib.get(), addr);
+  EXPECT_EQ(2, cache.misses());
+  EXPECT_EQ(newRib->longestMatch(addr), newRoute);
+  EXPECT_NE(route, newRoute);
+
+  // Looking up against the old rib again misses (the entry now belongs
+  // to the new version) but still returns the old version's route.
+  EXPECT_EQ(route, cache.longestMatch(rib.get(), addr));
+}
+
+TEST(RouteLookupCache, Clear) {
+  auto rib = makeRib();
+  RouteLookupCache<IPAddressV4> cache;
+
+  IPAddressV4 addr("10.1.2.3");
+  cache.longestMatch(rib.get(), addr);
+  cache.longestMatch(rib.get(), addr);
+  EXPECT_EQ(1, cache.hits());
+
+  cache.clear();
+  cache.longestMatch(rib.get(), addr);
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_EQ(2, cache.misses());
+}
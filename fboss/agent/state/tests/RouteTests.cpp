@@ -1030,6 +1030,58 @@ TEST(Route, modRoutes) {
   ASSERT_EQ(t3rt10, nullptr);
 }
 
+// A client's full sync should only copy that client's routes; routes
+// owned solely by other clients must stay shared with the previous
+// tables instead of being recreated.
+TEST(Route, clientSyncSharesUntouchedRoutes) {
+  auto stateV1 = make_shared<SwitchState>();
+  stateV1->publish();
+  auto tables1 = stateV1->getRouteTables();
+  auto rid = RouterID(0);
+
+  RouteV4::Prefix prefixA{IPAddressV4("10.10.10.10"), 32};
+  RouteV4::Prefix prefixB{IPAddressV4("20.20.20.20"), 32};
+  RouteV4::Prefix prefixShared{IPAddressV4("30.30.30.30"), 32};
+
+  RouteUpdater u1(tables1);
+  u1.addRoute(rid, IPAddress("10.10.10.10"), 32,
+              CLIENT_A, newNextHops(3, "1.1.1."));
+  u1.addRoute(rid, IPAddress("20.20.20.20"), 32,
+              CLIENT_B, newNextHops(3, "2.2.2."));
+  u1.addRoute(rid, IPAddress("30.30.30.30"), 32,
+              CLIENT_A, newNextHops(3, "3.3.3."));
+  u1.addRoute(rid, IPAddress("30.30.30.30"), 32,
+              CLIENT_B, newNextHops(3, "2.2.2."));
+  tables1 = u1.updateDone();
+  tables1->publish();
+
+  // Simulate CLIENT_A syncing its FIB: drop everything it owns, then
+  // re-add a different set.
+  RouteUpdater u2(tables1);
+  u2.removeAllNexthopsForClient(rid, CLIENT_A);
+  u2.addRoute(rid, IPAddress("10.10.10.10"), 32,
+              CLIENT_A, newNextHops(3, "4.4.4."));
+  auto tables2 = u2.updateDone();
+
+  auto rib1 = tables1->getRouteTable(rid)->getRibV4();
+  auto rib2 = tables2->getRouteTable(rid)->getRibV4();
+  // CLIENT_B's own route was untouched by the sync, so the route object
+  // is shared with the previous tables rather than recreated.
+  EXPECT_EQ(rib1->exactMatch(prefixB), rib2->exactMatch(prefixB));
+  // Routes CLIENT_A owned or co-owned were copied.
+  EXPECT_NE(rib1->exactMatch(prefixA), rib2->exactMatch(prefixA));
+  EXPECT_NE(rib1->exactMatch(prefixShared), rib2->exactMatch(prefixShared));
+  // The sync only dropped CLIENT_A's entries from the co-owned route.
+  auto shared2 = rib2->exactMatch(prefixShared);
+  EXPECT_FALSE(shared2->hasNextHopsForClient(CLIENT_A));
+  EXPECT_TRUE(shared2->isSame(CLIENT_B, newNextHops(3, "2.2.2.")));
+  EXPECT_TRUE(rib2->exactMatch(prefixA)->isSame(CLIENT_A,
+                                                newNextHops(3, "4.4.4.")));
+  // The old tables are untouched.
+  EXPECT_TRUE(rib1->exactMatch(prefixShared)->isSame(CLIENT_A,
+                                                     newNextHops(3, "3.3.3.")));
+}
+
 // Test adding empty nextHops lists
 TEST(Route, disallowEmptyNexthops) {
   auto stateV1 = make_shared<SwitchState>();
@@ -1171,6 +1223,21 @@ TEST(Route, serializeNextHops) {
   EXPECT_TRUE(nhm1 == nhm2);
 }
 
+// Test thrift serialization of RouteNextHopsMulti.
+TEST(Route, thriftNextHops) {
+
+  RouteNextHopsMulti nhm1;
+  nhm1.update(CLIENT_A, newNextHops(3, "1.1.1."));
+  nhm1.update(CLIENT_B, newNextHops(1, "2.2.2."));
+  nhm1.update(CLIENT_C, newNextHops(4, "3.3.3."));
+
+  auto serialized = nhm1.toThrift();
+
+  auto nhm2 = RouteNextHopsMulti::fromThrift(serialized);
+
+  EXPECT_TRUE(nhm1 == nhm2);
+}
+
 // Test priority ranking of nexthop lists within a RouteNextHopsMulti.
 TEST(Route, listRanking) {
 
@@ -1443,6 +1510,21 @@ TEST(Route, serializeRoute) {
   ASSERT_TRUE(rt2->isSame(clientId, nxtHops));
 }
 
+// Same round trip through the typed thrift representation
+TEST(Route, thriftRoute) {
+
+  ClientID clientId = ClientID(1);
+  auto nxtHops = makeNextHops({"10.10.10.10", "11.11.11.11"});
+  Route<IPAddressV4> rt(makePrefixV4("1.2.3.4/32"));
+  rt.update(clientId, nxtHops);
+
+  // to thrift struct and back to a Route object
+  auto fieldsThrift = rt.toThrift();
+  auto rt2 = Route<IPAddressV4>::fromThrift(fieldsThrift);
+  ASSERT_TRUE(rt2->isSame(clientId, nxtHops));
+  EXPECT_EQ(rt.prefix(), rt2->prefix());
+}
+
 // Test deserialization of old version of the Route object (from before
 // multi-nexthops were implemented)
 TEST(Route, deserializeOldVersionRoute) {
@@ -0,0 +1,228 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/ApplyThriftConfig.h"
+#include "fboss/agent/test/TestUtils.h"
+#include "fboss/agent/hw/mock/MockPlatform.h"
+#include "fboss/agent/state/DeltaFunctions.h"
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteDelta.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/RouteTableMap.h"
+#include "fboss/agent/state/RouteTableRib.h"
+#include "fboss/agent/state/RouteUpdater.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/gen-cpp2/switch_config_types.h"
+
+#include <folly/Benchmark.h>
+
+#include <chrono>
+#include <malloc.h>
+
+using namespace facebook::fboss;
+using folly::IPAddress;
+using folly::IPAddressV4;
+using std::make_shared;
+using std::shared_ptr;
+
+DEFINE_int64(fib_size, 600000,
+             "Number of IPv4 routes used for the syncFib-style benchmarks");
+DEFINE_int32(ecmp_flap_prefixes, 1000,
+             "Number of ECMP routes re-resolved per ECMP member flap");
+
+namespace {
+
+const RouterID kRid(0);
+const ClientID kClient(1001);
+
+// Global state used by the benchmarks, set up once in init() so the
+// expensive FIB construction is not repeated inside each benchmark.
+std::unique_ptr<MockPlatform> platform;
+shared_ptr<SwitchState> baseState;     // interfaces only, no routes
+shared_ptr<RouteTableMap> fibTables;   // full FIB of FLAGS_fib_size routes
+shared_ptr<SwitchState> fibStateOld;   // full FIB
+shared_ptr<SwitchState> fibStateNew;   // full FIB with one churned prefix
+RouteNextHops nhopsEcmp8;              // 8-way ECMP
+RouteNextHops nhopsEcmp7;              // same set with one member down
+RouteNextHops nhopsChurnA;
+RouteNextHops nhopsChurnB;
+
+// Distinct /24 prefixes: 10.0.0.0/24, 10.0.1.0/24, ...
+IPAddressV4 prefixForIndex(uint64_t idx) {
+  return IPAddressV4::fromLongHBO(0x0A000000 + idx * 256);
+}
+
+shared_ptr<SwitchState> setupBaseState() {
+  auto stateV0 = make_shared<SwitchState>();
+
+  cfg::SwitchConfig config;
+  config.vlans.resize(2);
+  config.vlans[0].id = 1;
+  config.vlans[1].id = 2;
+
+  config.interfaces.resize(2);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:00:00:00:00:11";
+  config.interfaces[0].ipAddresses.resize(1);
+  config.interfaces[0].ipAddresses[0] = "1.1.1.1/24";
+  config.interfaces[1].intfID = 2;
+  config.interfaces[1].vlanID = 2;
+  config.interfaces[1].routerID = 0;
+  config.interfaces[1].__isset.mac = true;
+  config.interfaces[1].mac = "00:00:00:00:00:22";
+  config.interfaces[1].ipAddresses.resize(1);
+  config.interfaces[1].ipAddresses[0] = "2.2.2.2/24";
+
+  auto state = publishAndApplyConfig(stateV0, &config, platform.get());
+  CHECK(state != nullptr);
+  state->publish();
+  return state;
+}
+
+// Build a FIB of nRoutes /24s on top of orig, all pointing at nhops.
+// This is the same work a full syncFib does on the state side.
+shared_ptr<RouteTableMap> buildFib(const shared_ptr<RouteTableMap>& orig,
+                                   uint64_t nRoutes,
+                                   const RouteNextHops& nhops) {
+  RouteUpdater updater(orig);
+  for (uint64_t i = 0; i < nRoutes; ++i) {
+    updater.addRoute(kRid, IPAddress(prefixForIndex(i)), 24, kClient, nhops);
+  }
+  auto tables = updater.updateDone();
+  CHECK(tables != nullptr);
+  tables->publish();
+  return tables;
+}
+
+shared_ptr<SwitchState> stateWithTables(
+    const shared_ptr<RouteTableMap>& tables) {
+  auto state = make_shared<SwitchState>();
+  state->resetRouteTables(tables);
+  state->publish();
+  return state;
+}
+
+void init() {
+  platform = createMockPlatform();
+  baseState = setupBaseState();
+
+  // All nexthops resolve over interface 1's subnet
+  nhopsEcmp8 = makeNextHops({"1.1.1.10", "1.1.1.11", "1.1.1.12", "1.1.1.13",
+                             "1.1.1.14", "1.1.1.15", "1.1.1.16", "1.1.1.17"});
+  nhopsEcmp7 = makeNextHops({"1.1.1.10", "1.1.1.11", "1.1.1.12", "1.1.1.13",
+                             "1.1.1.14", "1.1.1.15", "1.1.1.16"});
+  nhopsChurnA = makeNextHops({"1.1.1.10"});
+  nhopsChurnB = makeNextHops({"2.2.2.10"});
+
+  fibTables = buildFib(baseState->getRouteTables(), FLAGS_fib_size,
+                       nhopsEcmp8);
+
+  // Two full-FIB states differing in a single prefix, for the delta
+  // traversal benchmark
+  fibStateOld = stateWithTables(fibTables);
+  RouteUpdater updater(fibTables);
+  updater.addRoute(kRid, IPAddress(prefixForIndex(0)), 24, kClient,
+                   nhopsChurnA);
+  auto churned = updater.updateDone();
+  churned->publish();
+  fibStateNew = stateWithTables(churned);
+}
+
+} // unnamed namespace
+
+// Full syncFib-style rebuild of the entire FIB from an empty table.
+BENCHMARK(fullSyncFib, numIters) {
+  for (size_t n = 0; n < numIters; ++n) {
+    auto tables = buildFib(baseState->getRouteTables(), FLAGS_fib_size,
+                           nhopsEcmp8);
+    folly::doNotOptimizeAway(tables.get());
+  }
+}
+
+// Repeatedly repoint one prefix in a full FIB between two nexthops,
+// the way BGP churn on a single destination shows up.
+BENCHMARK(singlePrefixChurn, numIters) {
+  auto tables = fibTables;
+  for (size_t n = 0; n < numIters; ++n) {
+    RouteUpdater updater(tables);
+    updater.addRoute(kRid, IPAddress(prefixForIndex(0)), 24, kClient,
+                     (n & 1) ? nhopsChurnA : nhopsChurnB);
+    tables = updater.updateDone();
+    tables->publish();
+  }
+  folly::doNotOptimizeAway(tables.get());
+}
+
+// Flap one member of an 8-way ECMP group: every affected prefix has to
+// be re-resolved and rewritten.
+BENCHMARK(ecmpMemberFlap, numIters) {
+  auto tables = fibTables;
+  for (size_t n = 0; n < numIters; ++n) {
+    const auto& nhops = (n & 1) ? nhopsEcmp8 : nhopsEcmp7;
+    RouteUpdater updater(tables);
+    for (int i = 0; i < FLAGS_ecmp_flap_prefixes; ++i) {
+      updater.addRoute(kRid, IPAddress(prefixForIndex(i)), 24, kClient,
+                       nhops);
+    }
+    tables = updater.updateDone();
+    tables->publish();
+  }
+  folly::doNotOptimizeAway(tables.get());
+}
+
+// Walk the StateDelta between two full-FIB states differing in one
+// prefix, the way the hardware sync does after every update.
+BENCHMARK(stateDeltaTraversal, numIters) {
+  for (size_t n = 0; n < numIters; ++n) {
+    size_t changed = 0;
+    StateDelta delta(fibStateOld, fibStateNew);
+    for (auto const& rtDelta : delta.getRouteTablesDelta()) {
+      DeltaFunctions::forEachChanged(
+          rtDelta.getRoutesV4Delta(),
+          [&](const shared_ptr<RouteV4>& /*oldRt*/,
+              const shared_ptr<RouteV4>& /*newRt*/) { ++changed; },
+          [&](const shared_ptr<RouteV4>& /*rt*/) { ++changed; },
+          [&](const shared_ptr<RouteV4>& /*rt*/) { ++changed; });
+    }
+    CHECK_EQ(changed, 1);
+    folly::doNotOptimizeAway(changed);
+  }
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  init();
+
+  // Report routes/sec and heap growth for one explicitly timed full
+  // sync, since folly::Benchmark only reports time per iteration.
+  // mallinfo's counters are ints and can wrap on very large FIBs, so
+  // treat the allocation number as approximate.
+  auto before = mallinfo();
+  auto start = std::chrono::steady_clock::now();
+  auto tables = buildFib(baseState->getRouteTables(), FLAGS_fib_size,
+                         nhopsEcmp8);
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  auto after = mallinfo();
+  folly::doNotOptimizeAway(tables.get());
+
+  LOG(INFO) << "syncFib of " << FLAGS_fib_size << " routes took "
+            << elapsed.count() << "us ("
+            << (FLAGS_fib_size * 1000000.0 / elapsed.count())
+            << " routes/sec), heap grew by approximately "
+            << (after.uordblks - before.uordblks) << " bytes";
+
+  folly::runBenchmarks();
+  return 0;
+}
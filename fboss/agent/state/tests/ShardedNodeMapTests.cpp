@@ -0,0 +1,143 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/state/NodeMapDelta.h"
+#include "fboss/agent/state/NodeMapDelta-defs.h"
+#include "fboss/agent/state/Port.h"
+#include "fboss/agent/state/ShardedNodeMap.h"
+#include "fboss/agent/state/ShardedNodeMap-defs.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using std::make_shared;
+using std::shared_ptr;
+
+namespace {
+
+// Shard by blocks of 4 port IDs so a small test spreads across shards.
+struct TestTraits : public ShardedNodeMapTraits<PortID, Port> {
+  static size_t getShard(const PortID& key) {
+    return std::min(static_cast<size_t>(static_cast<uint16_t>(key) / 4),
+                    static_cast<size_t>(kNumShards) - 1);
+  }
+};
+
+class ShardedPortMap
+    : public ShardedNodeMapT<ShardedPortMap, TestTraits> {
+ public:
+  ShardedPortMap() {}
+  ~ShardedPortMap() override {}
+
+ private:
+  // Inherit the constructor required for clone()
+  using ShardedNodeMapT::ShardedNodeMapT;
+  friend class CloneAllocator;
+};
+
+shared_ptr<Port> makePort(int id) {
+  return make_shared<Port>(PortID(id), folly::to<std::string>("port", id));
+}
+
+} // unnamed namespace
+
+TEST(ShardedNodeMap, AddRemove) {
+  auto map = make_shared<ShardedPortMap>();
+  EXPECT_EQ(0, map->size());
+  for (int id = 1; id <= 20; ++id) {
+    map->addNode(makePort(id));
+  }
+  EXPECT_EQ(20, map->size());
+  EXPECT_THROW(map->addNode(makePort(7)), FbossError);
+  EXPECT_EQ(PortID(7), map->getNode(PortID(7))->getID());
+  EXPECT_EQ(nullptr, map->getNodeIf(PortID(21)));
+  EXPECT_THROW(map->getNode(PortID(21)), FbossError);
+
+  auto removed = map->removeNode(PortID(7));
+  EXPECT_EQ(PortID(7), removed->getID());
+  EXPECT_EQ(19, map->size());
+  EXPECT_EQ(nullptr, map->getNodeIf(PortID(7)));
+  EXPECT_EQ(nullptr, map->removeNodeIf(PortID(7)));
+  EXPECT_THROW(map->removeNode(PortID(7)), FbossError);
+
+  // Iteration visits all nodes in ascending key order, across shards
+  int expectedId = 1;
+  for (const auto& port : *map) {
+    if (expectedId == 7) {
+      ++expectedId; // removed above
+    }
+    EXPECT_EQ(PortID(expectedId), port->getID());
+    ++expectedId;
+  }
+  EXPECT_EQ(21, expectedId);
+}
+
+TEST(ShardedNodeMap, CloneSharesUnmodifiedShards) {
+  auto map = make_shared<ShardedPortMap>();
+  for (int id = 1; id <= 20; ++id) {
+    map->addNode(makePort(id));
+  }
+  map->publish();
+
+  auto clone = map->clone();
+  // A clone shares all shards with the original
+  for (size_t n = 0; n < TestTraits::kNumShards; ++n) {
+    EXPECT_EQ(map->getShards()[n], clone->getShards()[n]);
+  }
+
+  // Modifying one node copies only the shard holding it
+  clone->updateNode(makePort(10));
+  auto modifiedShard = TestTraits::getShard(PortID(10));
+  for (size_t n = 0; n < TestTraits::kNumShards; ++n) {
+    if (n == modifiedShard) {
+      EXPECT_NE(map->getShards()[n], clone->getShards()[n]);
+    } else {
+      EXPECT_EQ(map->getShards()[n], clone->getShards()[n]);
+    }
+  }
+  EXPECT_EQ(map->size(), clone->size());
+
+  // The original still sees the old node
+  EXPECT_NE(map->getNode(PortID(10)), clone->getNode(PortID(10)));
+  EXPECT_EQ(map->getNode(PortID(11)), clone->getNode(PortID(11)));
+}
+
+TEST(ShardedNodeMap, Delta) {
+  auto oldMap = make_shared<ShardedPortMap>();
+  for (int id = 1; id <= 20; ++id) {
+    oldMap->addNode(makePort(id));
+  }
+  oldMap->publish();
+
+  auto newMap = oldMap->clone();
+  newMap->updateNode(makePort(3)); // changed
+  newMap->removeNode(PortID(10)); // removed
+  newMap->addNode(makePort(25)); // added
+
+  NodeMapDelta<ShardedPortMap> delta(oldMap.get(), newMap.get());
+  int changed = 0;
+  int added = 0;
+  int removed = 0;
+  for (const auto& entry : delta) {
+    if (entry.getOld() && entry.getNew()) {
+      ++changed;
+      EXPECT_EQ(PortID(3), entry.getNew()->getID());
+    } else if (entry.getNew()) {
+      ++added;
+      EXPECT_EQ(PortID(25), entry.getNew()->getID());
+    } else {
+      ++removed;
+      EXPECT_EQ(PortID(10), entry.getOld()->getID());
+    }
+  }
+  EXPECT_EQ(1, changed);
+  EXPECT_EQ(1, added);
+  EXPECT_EQ(1, removed);
+}
@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/state/DeltaFunctions.h"
+#include "fboss/agent/state/Port.h"
+#include "fboss/agent/state/PortMap.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+
+#include <folly/Conv.h>
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <set>
+
+using namespace facebook::fboss;
+using std::make_shared;
+using std::shared_ptr;
+
+TEST(StateDelta, changedSections) {
+  auto stateA = make_shared<SwitchState>();
+  stateA->addVlan(make_shared<Vlan>(VlanID(1), "Vlan1"));
+  stateA->publish();
+
+  // Identical states: no sections changed.
+  EXPECT_EQ(0, StateDelta(stateA, stateA).changedSections());
+
+  // Adding a VLAN only touches the VLAN section; the unchanged sections
+  // still share their nodes with the old state and must not be flagged.
+  auto stateB = stateA->clone();
+  stateB->addVlan(make_shared<Vlan>(VlanID(2), "Vlan2"));
+  stateB->publish();
+  EXPECT_EQ(StateDelta::SECTION_VLANS,
+            StateDelta(stateA, stateB).changedSections());
+
+  // Scalar settings live directly on the SwitchState and are detected by
+  // value comparison.
+  auto stateC = stateB->clone();
+  stateC->setArpTimeout(std::chrono::seconds(123));
+  stateC->publish();
+  EXPECT_EQ(StateDelta::SECTION_SWITCH_SETTINGS,
+            StateDelta(stateB, stateC).changedSections());
+}
+
+TEST(StateDelta, recreatedIdenticalNodesSkipped) {
+  auto stateA = make_shared<SwitchState>();
+  stateA->registerPort(PortID(1), "port1");
+  stateA->registerPort(PortID(2), "port2");
+  stateA->publish();
+
+  // Rebuild the same ports from scratch, the way a config reload does.
+  auto stateB = make_shared<SwitchState>();
+  stateB->registerPort(PortID(1), "port1");
+  stateB->registerPort(PortID(2), "port2");
+  stateB->publish();
+
+  // The ports are distinct objects with matching content fingerprints,
+  // so the delta must not surface them as changed.
+  EXPECT_NE(stateA->getPort(PortID(1)), stateB->getPort(PortID(1)));
+  EXPECT_NE(0, stateA->getPort(PortID(1))->getFingerprint());
+  EXPECT_EQ(stateA->getPort(PortID(1))->getFingerprint(),
+            stateB->getPort(PortID(1))->getFingerprint());
+  auto portsDelta = StateDelta(stateA, stateB).getPortsDelta();
+  EXPECT_TRUE(portsDelta.begin() == portsDelta.end());
+
+  // A genuinely different rebuilt port still surfaces.
+  auto stateC = make_shared<SwitchState>();
+  stateC->registerPort(PortID(1), "port1");
+  stateC->registerPort(PortID(2), "port2.renamed");
+  stateC->publish();
+  auto changed = StateDelta(stateA, stateC).getPortsDelta();
+  auto it = changed.begin();
+  ASSERT_TRUE(it != changed.end());
+  EXPECT_EQ(PortID(2), it->getNew()->getID());
+  ++it;
+  EXPECT_TRUE(it == changed.end());
+}
+
+TEST(DeltaFunctions, forEachChangedParallel) {
+  // Build a VLAN delta large enough that the parallel walk actually
+  // splits into multiple chunks: VLAN 1 is removed, VLAN 3000 is added,
+  // every 10th VLAN is modified and the rest are shared unchanged.
+  auto oldState = make_shared<SwitchState>();
+  auto newState = make_shared<SwitchState>();
+  for (uint32_t i = 1; i < 3000; i++) {
+    auto vlan = make_shared<Vlan>(VlanID(i), folly::to<std::string>("Vlan", i));
+    oldState->addVlan(vlan);
+    if (i == 1) {
+      continue;
+    }
+    if (i % 10 == 0) {
+      newState->addVlan(make_shared<Vlan>(VlanID(i), "modified"));
+    } else {
+      newState->addVlan(vlan);
+    }
+  }
+  newState->addVlan(make_shared<Vlan>(VlanID(3000), "Vlan3000"));
+  oldState->publish();
+  newState->publish();
+  StateDelta delta(oldState, newState);
+
+  std::set<VlanID> expectedChanged;
+  std::set<VlanID> expectedAdded;
+  std::set<VlanID> expectedRemoved;
+  DeltaFunctions::forEachChanged(
+      delta.getVlansDelta(),
+      [&](const shared_ptr<Vlan>& /*oldVlan*/, const shared_ptr<Vlan>& vlan) {
+        expectedChanged.insert(vlan->getID());
+      },
+      [&](const shared_ptr<Vlan>& vlan) {
+        expectedAdded.insert(vlan->getID());
+      },
+      [&](const shared_ptr<Vlan>& vlan) {
+        expectedRemoved.insert(vlan->getID());
+      });
+  EXPECT_EQ(299, expectedChanged.size());
+  EXPECT_EQ(1, expectedAdded.size());
+  EXPECT_EQ(1, expectedRemoved.size());
+
+  // The parallel walk must classify exactly the same nodes.
+  std::mutex mutex;
+  std::set<VlanID> changed;
+  std::set<VlanID> added;
+  std::set<VlanID> removed;
+  DeltaFunctions::forEachChangedParallel(
+      delta.getVlansDelta(), 4,
+      [&](const shared_ptr<Vlan>& /*oldVlan*/, const shared_ptr<Vlan>& vlan) {
+        std::lock_guard<std::mutex> guard(mutex);
+        changed.insert(vlan->getID());
+      },
+      [&](const shared_ptr<Vlan>& vlan) {
+        std::lock_guard<std::mutex> guard(mutex);
+        added.insert(vlan->getID());
+      },
+      [&](const shared_ptr<Vlan>& vlan) {
+        std::lock_guard<std::mutex> guard(mutex);
+        removed.insert(vlan->getID());
+      });
+  EXPECT_EQ(expectedChanged, changed);
+  EXPECT_EQ(expectedAdded, added);
+  EXPECT_EQ(expectedRemoved, removed);
+}
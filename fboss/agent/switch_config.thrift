@@ -386,6 +386,37 @@ struct AclEntry {
   15: optional i16 icmpCode
 }
 
+/**
+ * The reasons a packet can be trapped to the CPU, used to steer trap
+ * traffic onto distinct CPU CoS queues.
+ */
+enum PacketRxReason {
+  UNMATCHED    = 0,
+  ARP          = 1,
+  DHCP         = 2,
+  BPDU         = 3,
+  L3_SLOW_PATH = 4,
+  L3_DEST_MISS = 5,
+  TTL_1        = 6,
+  CPU_IS_NHOP  = 7,
+}
+
+/**
+ * Settings for one CPU CoS queue: which rx reasons land on it, how it is
+ * policed and how it competes with the other CPU queues. Queues not
+ * listed in the config keep their hardware defaults.
+ */
+struct CPUQueueConfig {
+  1: required i32 id
+  // Weight for weighted round robin scheduling between the CPU queues
+  2: i32 weight = 1
+  // Cap on packets per second delivered to this queue; omit to leave the
+  // queue unpoliced
+  3: optional i32 maxPps
+  // Rx reasons whose traffic should be steered to this queue
+  4: list<PacketRxReason> rxReasons = []
+}
+
 /**
  * The configuration for a switch.
  *
@@ -436,4 +467,7 @@ struct SwitchConfig {
   // seconds.
   16: i32 maxNeighborProbes = 300
   17: i32 staleEntryInterval = 10
+  // CPU CoS queue settings, so protocol traffic (e.g. BGP) is not
+  // crowded out of the CPU path by ARP/LLDP floods
+  18: optional list<CPUQueueConfig> cpuQueues = []
 }
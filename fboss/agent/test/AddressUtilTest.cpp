@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/AddressUtil.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::IPAddressV4;
+using folly::IPAddressV6;
+using folly::MacAddress;
+
+TEST(AddressUtilTest, fastKernelsMatchGenericOperators) {
+  std::vector<IPAddressV4> v4s = {
+    IPAddressV4("0.0.0.0"),
+    IPAddressV4("10.0.0.1"),
+    IPAddressV4("10.0.0.2"),
+    IPAddressV4("255.255.255.255"),
+  };
+  for (const auto& a : v4s) {
+    for (const auto& b : v4s) {
+      EXPECT_EQ(a == b, equalsFast(a, b));
+      EXPECT_EQ(a < b, lessFast(a, b));
+    }
+  }
+
+  std::vector<IPAddressV6> v6s = {
+    IPAddressV6("::"),
+    IPAddressV6("fe80::1"),
+    // Differ from fe80::1 only in the low and high word respectively
+    IPAddressV6("fe80::2"),
+    IPAddressV6("fe81::1"),
+    IPAddressV6("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"),
+  };
+  for (const auto& a : v6s) {
+    for (const auto& b : v6s) {
+      EXPECT_EQ(a == b, equalsFast(a, b));
+      EXPECT_EQ(a < b, lessFast(a, b));
+    }
+  }
+
+  std::vector<MacAddress> macs = {
+    MacAddress::ZERO,
+    MacAddress("02:00:01:02:03:04"),
+    MacAddress("02:00:01:02:03:05"),
+    MacAddress::BROADCAST,
+  };
+  for (const auto& a : macs) {
+    for (const auto& b : macs) {
+      EXPECT_EQ(a == b, equalsFast(a, b));
+    }
+  }
+}
+
+TEST(AddressUtilTest, hashersDifferentiate) {
+  EXPECT_NE(hashFast(IPAddressV4("10.0.0.1")), hashFast(IPAddressV4("10.0.0.2")));
+  EXPECT_NE(hashFast(IPAddressV6("fe80::1")), hashFast(IPAddressV6("fe80::2")));
+  EXPECT_NE(hashFast(IPAddressV6("fe80::1")), hashFast(IPAddressV6("fe81::1")));
+  EXPECT_NE(hashFast(MacAddress("02:00:01:02:03:04")),
+            hashFast(MacAddress("02:00:01:02:03:05")));
+
+  // Equal inputs must hash equal through the functor wrapper too
+  EXPECT_EQ(AddressHashFast()(IPAddressV6("fe80::1")),
+            AddressHashFast()(IPAddressV6("fe80::1")));
+}
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+#include "fboss/agent/test/TestUtils.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::IPAddressV4;
+using std::shared_ptr;
+
+namespace {
+
+// A trivial update that always produces a new state
+shared_ptr<SwitchState> touchVlan(const shared_ptr<SwitchState>& in) {
+  auto newState = in->clone();
+  auto vlan = newState->getVlans()->getVlan(VlanID(1))->modify(&newState);
+  vlan->setDhcpV4Relay(IPAddressV4("20.20.20.20"));
+  return newState;
+}
+
+}
+
+TEST(ConvergenceTraceTest, RecordsCompletedUpdates) {
+  auto sw = createMockSw(testStateA());
+
+  sw->updateStateBlocking("convergence test update", touchVlan);
+
+  auto traces = sw->getConvergenceTraces(0);
+  ASSERT_GE(traces.size(), 1);
+
+  bool found = false;
+  for (const auto& trace : traces) {
+    if (trace.name != "convergence test update") {
+      continue;
+    }
+    found = true;
+    // Stage durations are non-negative and (up to the truncation of
+    // each stage to whole microseconds) sum to the total
+    EXPECT_GE(trace.queueUsec, 0);
+    EXPECT_GE(trace.applyUsec, 0);
+    EXPECT_GE(trace.hwUsec, 0);
+    EXPECT_LE(trace.queueUsec + trace.applyUsec + trace.hwUsec,
+              trace.totalUsec + 3);
+    EXPECT_GT(trace.enqueuedMsec, 0);
+  }
+  EXPECT_TRUE(found);
+
+  // The list is sorted slowest first
+  for (size_t i = 1; i < traces.size(); ++i) {
+    EXPECT_GE(traces[i - 1].totalUsec, traces[i].totalUsec);
+  }
+
+  // numTraces limits the result
+  EXPECT_EQ(1, sw->getConvergenceTraces(1).size());
+}
@@ -0,0 +1,78 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/DhcpRelayTable.h"
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+#include "fboss/agent/test/TestUtils.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::IPAddressV4;
+using folly::MacAddress;
+using std::shared_ptr;
+
+namespace {
+const IPAddressV4 kRelay("20.20.20.20");
+const IPAddressV4 kNewRelay("40.40.40.40");
+const IPAddressV4 kOverrideRelay("30.30.30.30");
+const MacAddress kClientMac("02:00:00:00:00:02");
+}
+
+TEST(DhcpRelayTableTest, Lookup) {
+  auto state = testStateA();
+  auto vlan = state->getVlans()->getVlan(VlanID(1));
+  vlan->setDhcpV4Relay(kRelay);
+  DhcpV4OverrideMap overrides;
+  overrides[kClientMac] = kOverrideRelay;
+  vlan->setDhcpV4RelayOverrides(overrides);
+  auto sw = createMockSw(state);
+
+  auto entry = sw->getDhcpRelayTable()->getEntry(VlanID(1));
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(kRelay, entry->relay);
+  // testStateA gives VLAN 1's interface the address 10.0.0.1
+  EXPECT_EQ(IPAddressV4("10.0.0.1"), entry->switchIp);
+  auto overrideItr = entry->overrides.find(kClientMac);
+  ASSERT_TRUE(overrideItr != entry->overrides.end());
+  EXPECT_EQ(kOverrideRelay, overrideItr->second);
+
+  // Unknown VLANs have no entry
+  EXPECT_EQ(nullptr, sw->getDhcpRelayTable()->getEntry(VlanID(4000)));
+}
+
+TEST(DhcpRelayTableTest, FollowsStateUpdates) {
+  auto state = testStateA();
+  state->getVlans()->getVlan(VlanID(1))->setDhcpV4Relay(kRelay);
+  auto sw = createMockSw(state);
+
+  auto entry = sw->getDhcpRelayTable()->getEntry(VlanID(1));
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(kRelay, entry->relay);
+
+  sw->updateStateBlocking("change dhcp relay",
+      [](const shared_ptr<SwitchState>& in) {
+        auto newState = in->clone();
+        auto newVlan = newState->getVlans()->getVlan(VlanID(1))
+            ->modify(&newState);
+        newVlan->setDhcpV4Relay(kNewRelay);
+        return newState;
+      });
+  waitForStateUpdates(sw.get());
+
+  // The table follows the published state; entries handed out earlier
+  // still see the snapshot they were resolved against.
+  auto newEntry = sw->getDhcpRelayTable()->getEntry(VlanID(1));
+  ASSERT_NE(nullptr, newEntry);
+  EXPECT_EQ(kNewRelay, newEntry->relay);
+  EXPECT_EQ(kRelay, entry->relay);
+}
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/DhcpTransactionCache.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::MacAddress;
+
+namespace {
+const MacAddress kClientMac("02:00:00:00:00:02");
+const MacAddress kOtherMac("02:00:00:00:00:03");
+}
+
+TEST(DhcpTransactionCacheTest, RecordAndLookup) {
+  DhcpTransactionCache cache;
+
+  EXPECT_FALSE(cache.lookup(0x1234, kClientMac).hasValue());
+
+  cache.recordRequest(0x1234, kClientMac, VlanID(1), PortID(5));
+  auto txn = cache.lookup(0x1234, kClientMac);
+  ASSERT_TRUE(txn.hasValue());
+  EXPECT_EQ(VlanID(1), txn->vlan);
+  EXPECT_EQ(PortID(5), txn->port);
+
+  // One transaction sees two replies (OFFER and ACK), so a hit must
+  // not consume the entry.
+  EXPECT_TRUE(cache.lookup(0x1234, kClientMac).hasValue());
+
+  // A different client can never match this transaction, even with
+  // the same ID.
+  EXPECT_FALSE(cache.lookup(0x1234, kOtherMac).hasValue());
+}
+
+TEST(DhcpTransactionCacheTest, RerecordUpdates) {
+  DhcpTransactionCache cache;
+
+  // A client re-requesting after moving takes over its own entry.
+  cache.recordRequest(0x1234, kClientMac, VlanID(1), PortID(5));
+  cache.recordRequest(0x1234, kClientMac, VlanID(2), PortID(7));
+  auto txn = cache.lookup(0x1234, kClientMac);
+  ASSERT_TRUE(txn.hasValue());
+  EXPECT_EQ(VlanID(2), txn->vlan);
+  EXPECT_EQ(PortID(7), txn->port);
+}
+
+TEST(DhcpTransactionCacheTest, Bounded) {
+  DhcpTransactionCache cache;
+
+  // Insert far more transactions than the cache holds.  Nothing
+  // grows; colliding slots are simply evicted, and the survivors
+  // still resolve correctly.
+  for (uint32_t xid = 0; xid < 100000; ++xid) {
+    cache.recordRequest(xid, kClientMac, VlanID(1), PortID(xid % 32));
+  }
+  size_t hits = 0;
+  for (uint32_t xid = 0; xid < 100000; ++xid) {
+    auto txn = cache.lookup(xid, kClientMac);
+    if (txn) {
+      EXPECT_EQ(PortID(xid % 32), txn->port);
+      ++hits;
+    }
+  }
+  EXPECT_GT(hits, 0);
+  EXPECT_LE(hits, 1024);
+}
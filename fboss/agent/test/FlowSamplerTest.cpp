@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/FlowSampler.h"
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+#include "fboss/agent/if/gen-cpp2/ctrl_types.h"
+#include "fboss/agent/test/TestUtils.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::IPAddress;
+
+namespace {
+
+// A sampled TCP-in-IPv4 packet from 1.2.3.4:80 to 10.0.0.10; the TCP
+// destination port is passed in as two hex bytes (e.g. "04 01" for 1025)
+std::unique_ptr<MockRxPacket> makeSample(uint8_t srcPort,
+                                         const std::string& dstL4PortHex) {
+  auto pkt = MockRxPacket::fromHex(std::string(
+    // dst mac, src mac
+    "02 00 01 00 00 01  02 00 02 01 02 03"
+    // 802.1q, VLAN 1
+    "81 00 00 01"
+    // IPv4
+    "08 00"
+    // Version(4), IHL(5), DSCP(0), ECN(0), Total Length(40)
+    "45  00  00 28"
+    // Identification(0), Flags(0), Fragment offset(0)
+    "00 00  00 00"
+    // TTL(31), Protocol(6, TCP), Checksum (0, fake)
+    "1F  06  00 00"
+    // Source IP (1.2.3.4)
+    "01 02 03 04"
+    // Destination IP (10.0.0.10)
+    "0a 00 00 0a"
+    // TCP src port (80)
+    "00 50")
+    // TCP dst port
+    + dstL4PortHex
+  );
+  pkt->padToLength(68);
+  pkt->setSrcPort(PortID(srcPort));
+  pkt->setSrcVlan(VlanID(1));
+  pkt->setSampled(true);
+  return pkt;
+}
+
+}
+
+TEST(FlowSamplerTest, AggregatesSamples) {
+  auto sw = createMockSw(testStateA());
+  auto* sampler = sw->getFlowSampler();
+
+  // Three samples of one flow, one sample of another
+  sampler->sampledPacketReceived(makeSample(5, "04 01").get());
+  sampler->sampledPacketReceived(makeSample(5, "04 01").get());
+  sampler->sampledPacketReceived(makeSample(5, "04 01").get());
+  sampler->sampledPacketReceived(makeSample(5, "04 02").get());
+
+  std::vector<SampledFlow> flows;
+  sampler->exportFlows(&flows, true);
+  ASSERT_EQ(2, flows.size());
+
+  for (const auto& flow : flows) {
+    EXPECT_EQ(IPAddress("1.2.3.4"),
+              facebook::network::toIPAddress(flow.srcIp));
+    EXPECT_EQ(IPAddress("10.0.0.10"),
+              facebook::network::toIPAddress(flow.dstIp));
+    EXPECT_EQ(6, flow.ipProtocol);
+    EXPECT_EQ(80, flow.srcL4Port);
+    EXPECT_EQ(5, flow.ingressPort);
+    EXPECT_EQ(1, flow.vlan);
+    if (flow.dstL4Port == 1025) {
+      EXPECT_EQ(3, flow.packets);
+      EXPECT_EQ(3 * 68, flow.bytes);
+    } else {
+      EXPECT_EQ(1026, flow.dstL4Port);
+      EXPECT_EQ(1, flow.packets);
+    }
+    EXPECT_LE(flow.firstSeenMsec, flow.lastSeenMsec);
+  }
+
+  // The export above cleared the cache
+  flows.clear();
+  sampler->exportFlows(&flows, false);
+  EXPECT_EQ(0, flows.size());
+}
+
+TEST(FlowSamplerTest, DistinctPortsAreDistinctFlows) {
+  auto sw = createMockSw(testStateA());
+  auto* sampler = sw->getFlowSampler();
+
+  // The same 5-tuple sampled on two ingress ports stays separate, so
+  // the collector can attribute traffic per port.
+  sampler->sampledPacketReceived(makeSample(5, "04 01").get());
+  sampler->sampledPacketReceived(makeSample(6, "04 01").get());
+
+  std::vector<SampledFlow> flows;
+  sampler->exportFlows(&flows, true);
+  EXPECT_EQ(2, flows.size());
+}
+
+TEST(FlowSamplerTest, IgnoresUnparseableSamples) {
+  auto sw = createMockSw(testStateA());
+  auto* sampler = sw->getFlowSampler();
+
+  // A non-IP frame can't be attributed to a flow
+  auto pkt = MockRxPacket::fromHex(
+    "02 00 01 00 00 01  02 00 02 01 02 03"
+    "81 00 00 01"
+    // ARP
+    "08 06");
+  pkt->padToLength(68);
+  pkt->setSrcPort(PortID(5));
+  pkt->setSrcVlan(VlanID(1));
+  pkt->setSampled(true);
+  sampler->sampledPacketReceived(pkt.get());
+
+  std::vector<SampledFlow> flows;
+  sampler->exportFlows(&flows, true);
+  EXPECT_EQ(0, flows.size());
+}
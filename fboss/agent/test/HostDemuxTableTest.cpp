@@ -0,0 +1,112 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/HostDemuxTable.h"
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/packet/PktUtil.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/test/TestUtils.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::io::Cursor;
+
+namespace {
+constexpr uint16_t kEtherTypeIPv4 = 0x0800;
+constexpr uint16_t kEtherTypeIPv6 = 0x86dd;
+}
+
+TEST(HostDemuxTableTest, LookupV4) {
+  auto sw = createMockSw(testStateA());
+
+  // TCP segment to 10.0.0.1 (interface 1), dst port 179 (BGP)
+  auto pkt = PktUtil::parseHexData(
+      "45 00 00 28" // ver/IHL, DSCP/ECN, total length 40
+      "00 00 00 00" // identification, flags/fragment offset
+      "40 06 00 00" // TTL 64, protocol TCP, checksum
+      "0a 00 00 16" // src 10.0.0.22
+      "0a 00 00 01" // dst 10.0.0.1
+      "c0 00 00 b3" // src port 49152, dst port 179
+      "00 00 00 00" // sequence number
+      "00 00 00 00" // ack number
+      "50 10 00 00" // data offset/flags, window
+      "00 00 00 00"); // checksum, urgent pointer
+  InterfaceID intf(0);
+  EXPECT_TRUE(sw->getHostDemuxTable()->lookup(
+      kEtherTypeIPv4, Cursor(&pkt), &intf));
+  EXPECT_EQ(InterfaceID(1), intf);
+
+  // Locally initiated session: the well known port shows up in the
+  // source field instead
+  auto fromLocalPeer = PktUtil::parseHexData(
+      "45 00 00 28"
+      "00 00 00 00"
+      "40 06 00 00"
+      "0a 00 37 16" // src 10.0.55.22
+      "0a 00 37 01" // dst 10.0.55.1
+      "00 b3 c0 00" // src port 179, dst port 49152
+      "00 00 00 00"
+      "00 00 00 00"
+      "50 10 00 00"
+      "00 00 00 00");
+  EXPECT_TRUE(sw->getHostDemuxTable()->lookup(
+      kEtherTypeIPv4, Cursor(&fromLocalPeer), &intf));
+  EXPECT_EQ(InterfaceID(55), intf);
+
+  // Flows on other ports take the slow path
+  auto ssh = PktUtil::parseHexData(
+      "45 00 00 28"
+      "00 00 00 00"
+      "40 06 00 00"
+      "0a 00 00 16"
+      "0a 00 00 01"
+      "c0 00 00 16" // src port 49152, dst port 22
+      "00 00 00 00"
+      "00 00 00 00"
+      "50 10 00 00"
+      "00 00 00 00");
+  EXPECT_FALSE(sw->getHostDemuxTable()->lookup(
+      kEtherTypeIPv4, Cursor(&ssh), &intf));
+
+  // So do packets to addresses that are not ours
+  auto transit = PktUtil::parseHexData(
+      "45 00 00 28"
+      "00 00 00 00"
+      "40 06 00 00"
+      "0a 00 00 16"
+      "0a 01 01 01" // dst 10.1.1.1: routed, not local
+      "c0 00 00 b3"
+      "00 00 00 00"
+      "00 00 00 00"
+      "50 10 00 00"
+      "00 00 00 00");
+  EXPECT_FALSE(sw->getHostDemuxTable()->lookup(
+      kEtherTypeIPv4, Cursor(&transit), &intf));
+}
+
+TEST(HostDemuxTableTest, LookupV6) {
+  auto sw = createMockSw(testStateA());
+
+  // TCP segment to 2401:db00:2110:3001::1 (interface 1), dst port 179
+  auto pkt = PktUtil::parseHexData(
+      "60 00 00 00" // version, traffic class, flow label
+      "00 14 06 40" // payload length 20, next header TCP, hop limit
+      "24 01 db 00 21 10 30 01 00 00 00 00 00 00 00 02" // src ::2
+      "24 01 db 00 21 10 30 01 00 00 00 00 00 00 00 01" // dst ::1
+      "c0 00 00 b3" // src port 49152, dst port 179
+      "00 00 00 00"
+      "00 00 00 00"
+      "50 10 00 00"
+      "00 00 00 00");
+  InterfaceID intf(0);
+  EXPECT_TRUE(sw->getHostDemuxTable()->lookup(
+      kEtherTypeIPv6, Cursor(&pkt), &intf));
+  EXPECT_EQ(InterfaceID(1), intf);
+}
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/IcmpErrorRateLimiter.h"
+
+#include <gtest/gtest.h>
+
+using facebook::fboss::IcmpErrorRateLimiter;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+TEST(IcmpErrorRateLimiter, PerSourceBudget) {
+  IcmpErrorRateLimiter limiter(10, 0);
+  auto now = steady_clock::now();
+
+  // The bucket starts full: exactly one second's worth of burst.
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(limiter.allow(1, now));
+  }
+  EXPECT_FALSE(limiter.allow(1, now));
+
+  // A different source is unaffected by the noisy one.
+  EXPECT_TRUE(limiter.allow(2, now));
+
+  // Tokens come back at the configured rate.
+  now += milliseconds(100);
+  EXPECT_TRUE(limiter.allow(1, now));
+  EXPECT_FALSE(limiter.allow(1, now));
+  now += seconds(10);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(limiter.allow(1, now));
+  }
+  EXPECT_FALSE(limiter.allow(1, now));
+}
+
+TEST(IcmpErrorRateLimiter, GlobalBudget) {
+  IcmpErrorRateLimiter limiter(0, 5);
+  auto now = steady_clock::now();
+
+  // With the per-source check disabled, distinct sources still share
+  // the global budget.
+  for (size_t src = 0; src < 5; ++src) {
+    EXPECT_TRUE(limiter.allow(src, now));
+  }
+  EXPECT_FALSE(limiter.allow(100, now));
+
+  now += seconds(1);
+  EXPECT_TRUE(limiter.allow(100, now));
+}
+
+TEST(IcmpErrorRateLimiter, SourceOverBudgetDoesNotDrainGlobal) {
+  IcmpErrorRateLimiter limiter(2, 4);
+  auto now = steady_clock::now();
+
+  // Source 1 burns through its own budget; the denials must not
+  // consume global tokens.
+  EXPECT_TRUE(limiter.allow(1, now));
+  EXPECT_TRUE(limiter.allow(1, now));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_FALSE(limiter.allow(1, now));
+  }
+
+  // Source 2 still gets the remaining global tokens.
+  EXPECT_TRUE(limiter.allow(2, now));
+  EXPECT_TRUE(limiter.allow(2, now));
+  EXPECT_FALSE(limiter.allow(2, now));
+}
+
+TEST(IcmpErrorRateLimiter, Disabled) {
+  IcmpErrorRateLimiter limiter(0, 0);
+  auto now = steady_clock::now();
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(limiter.allow(1, now));
+  }
+}
@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/InternedString.h"
+
+#include <folly/Conv.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using facebook::fboss::InternedString;
+
+TEST(InternedString, PointerEquality) {
+  auto a = InternedString::intern("eth1/1/1");
+  auto b = InternedString::intern(std::string("eth1/") + "1/1");
+  // Same contents intern to the same handle and the same backing
+  // string object.
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(&a.str(), &b.str());
+  EXPECT_EQ("eth1/1/1", a.str());
+
+  auto c = InternedString::intern("eth1/1/2");
+  EXPECT_NE(a, c);
+  EXPECT_NE(&a.str(), &c.str());
+}
+
+TEST(InternedString, EmptyString) {
+  InternedString dflt;
+  EXPECT_TRUE(dflt.empty());
+  // The default-constructed handle is the interned empty string, not a
+  // distinct object.
+  EXPECT_EQ(dflt, InternedString::intern(""));
+}
+
+TEST(InternedString, HandlesAreCopies) {
+  const std::string* stored;
+  {
+    auto a = InternedString::intern("scratch");
+    stored = &a.str();
+  }
+  // The pool entry outlives every handle; a fresh intern of the same
+  // contents still points at it.
+  EXPECT_EQ(stored, &InternedString::intern("scratch").str());
+}
+
+TEST(InternedString, ConcurrentIntern) {
+  // All threads interning the same contents must agree on the handle,
+  // however the insert races resolve.
+  constexpr int kThreads = 8;
+  std::vector<std::thread> threads;
+  std::vector<const std::string*> seen(kThreads);
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([i, &seen] {
+      for (int iter = 0; iter < 1000; ++iter) {
+        auto handle =
+            InternedString::intern(folly::to<std::string>("name", iter % 10));
+        seen[i] = &handle.str();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int i = 1; i < kThreads; ++i) {
+    EXPECT_EQ(seen[0], seen[i]);
+  }
+}
@@ -0,0 +1,50 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/test/TestUtils.h"
+
+#include <folly/io/async/EventBase.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace facebook::fboss;
+
+TEST(PacketPathThreadTest, MarkIsPerThread) {
+  // The test thread itself is not part of the packet path
+  EXPECT_FALSE(SwSwitch::isPacketPathThread());
+
+  // Marking happens on the calling thread only
+  std::thread t([] {
+    EXPECT_FALSE(SwSwitch::isPacketPathThread());
+    SwSwitch::markPacketPathThread();
+    EXPECT_TRUE(SwSwitch::isPacketPathThread());
+  });
+  t.join();
+  EXPECT_FALSE(SwSwitch::isPacketPathThread());
+}
+
+TEST(PacketPathThreadTest, SwitchThreadsAreMarked) {
+  auto sw = createMockSw(testStateA());
+
+  // The background and update threads are created through
+  // SwSwitch::threadLoop, which marks them
+  bool bgMarked = false;
+  sw->getBackgroundEVB()->runInEventBaseThreadAndWait([&] {
+    bgMarked = SwSwitch::isPacketPathThread();
+  });
+  EXPECT_TRUE(bgMarked);
+
+  bool updMarked = false;
+  sw->getUpdateEVB()->runInEventBaseThreadAndWait([&] {
+    updMarked = SwSwitch::isPacketPathThread();
+  });
+  EXPECT_TRUE(updMarked);
+}
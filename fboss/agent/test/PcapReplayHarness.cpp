@@ -0,0 +1,141 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+//
+// Replays a pcap capture into the slow path of a real SwSwitch running
+// over SimSwitch.  Feed it a capture collected on a production switch
+// with PktCaptureManager and it reproduces the same rx workload on a
+// dev machine, at the original timing, at an accelerated rate, or in a
+// loop for sustained load:
+//
+//   pcap_replay_harness --pcap=rx.pcap --speedup=10 --loop=0
+//
+// This is the quickest way to replay a production slow-path overload
+// against a candidate rx-path fix without hardware.
+//
+#include <folly/Memory.h>
+#include <gflags/gflags.h>
+
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/TunManager.h"
+#include "fboss/agent/capture/PcapReplayer.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+#include "fboss/agent/hw/sim/SimPlatform.h"
+#include "fboss/agent/state/ArpResponseTable.h"
+#include "fboss/agent/state/Interface.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+
+#include <chrono>
+
+using namespace facebook::fboss;
+using folly::IOBuf;
+using folly::IPAddress;
+using folly::IPAddressV4;
+using folly::MacAddress;
+using std::make_unique;
+using std::make_shared;
+using std::shared_ptr;
+using std::unique_ptr;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+DEFINE_string(pcap, "", "Capture file to replay (required)");
+DEFINE_double(speedup, 1.0,
+              "Replay rate relative to the capture timing; 10 replays 10x "
+              "faster, 0 replays as fast as possible");
+DEFINE_int64(loop, 1,
+             "How many times to replay the capture; 0 loops forever");
+DEFINE_int32(src_port, 1, "Ingress port to attribute replayed packets to");
+DEFINE_int32(src_vlan, 1, "Ingress VLAN to attribute replayed packets to");
+DEFINE_string(local_mac, "02:00:01:00:00:01",
+              "The local MAC address of the simulated switch");
+
+namespace {
+
+unique_ptr<SwSwitch> setupSwitch() {
+  MacAddress localMac(FLAGS_local_mac);
+  auto sw = make_unique<SwSwitch>(make_unique<SimPlatform>(localMac, 10));
+  sw->init(nullptr /* No custom TunManager */);
+
+  auto updateFn = [&](const shared_ptr<SwitchState>& oldState) {
+    auto state = oldState->clone();
+
+    // Add VLAN 1, and ports 1-9 which belong to it.
+    auto vlan1 = make_shared<Vlan>(VlanID(1), "Vlan1");
+    state->addVlan(vlan1);
+    for (int idx = 1; idx < 10; ++idx) {
+      vlan1->addPort(PortID(idx), false);
+    }
+    // Add Interface 1 to VLAN 1
+    auto intf1 = make_shared<Interface>(
+        InterfaceID(1),
+        RouterID(0),
+        VlanID(1),
+        "interface1",
+        localMac,
+        9000,
+        false /* is virtual */);
+    Interface::Addresses addrs1;
+    addrs1.emplace(IPAddress("10.0.0.1"), 24);
+    addrs1.emplace(IPAddress("192.168.0.1"), 24);
+    intf1->setAddresses(addrs1);
+    state->addIntf(intf1);
+
+    auto respTable1 = make_shared<ArpResponseTable>();
+    respTable1->setEntry(IPAddressV4("10.0.0.1"),
+                         localMac,
+                         InterfaceID(1));
+    state->getVlans()->getVlan(VlanID(1))->setArpResponseTable(respTable1);
+    return state;
+  };
+
+  sw->updateStateBlocking("replay setup", updateFn);
+  return sw;
+}
+
+} // unnamed namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_pcap.empty()) {
+    LOG(ERROR) << "--pcap is required";
+    return 1;
+  }
+
+  PcapReplayer replayer(FLAGS_pcap);
+  LOG(INFO) << "loaded " << replayer.pkts().size() << " packets from "
+            << FLAGS_pcap;
+
+  auto sw = setupSwitch();
+  PortID srcPort(FLAGS_src_port);
+  VlanID srcVlan(FLAGS_src_vlan);
+
+  auto start = steady_clock::now();
+  auto delivered = replayer.replay(
+      [&](const PcapReplayer::Pkt& pkt) {
+        // Copy the frame out of the mapping: handlers take ownership
+        // of the packet buffer and may hold it past this callback.
+        auto rxPkt = make_unique<MockRxPacket>(
+            IOBuf::copyBuffer(pkt.data.data(), pkt.data.size()));
+        rxPkt->setSrcPort(srcPort);
+        rxPkt->setSrcVlan(srcVlan);
+        sw->packetReceived(std::move(rxPkt));
+      },
+      FLAGS_speedup, FLAGS_loop < 0 ? 1 : FLAGS_loop);
+  auto elapsedMs =
+      duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+  LOG(INFO) << "replayed " << delivered << " packets in " << elapsedMs
+            << "ms (" << (elapsedMs ? delivered * 1000 / elapsedMs : 0)
+            << " pkts/sec)";
+  return 0;
+}
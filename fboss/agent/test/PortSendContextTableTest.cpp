@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/PortSendContextTable.h"
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/TxPacket.h"
+#include "fboss/agent/state/Port.h"
+#include "fboss/agent/state/PortMap.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/test/TestUtils.h"
+
+#include <folly/io/IOBuf.h>
+#include <folly/io/Cursor.h>
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::IOBuf;
+using folly::MacAddress;
+using folly::io::Cursor;
+using folly::io::RWPrivateCursor;
+using std::shared_ptr;
+
+namespace {
+const MacAddress kLocalMac("02:00:01:00:00:01");
+const MacAddress kDstMac("01:80:c2:00:00:0e");
+}
+
+TEST(PortSendContextTableTest, Lookup) {
+  auto state = testStateA();
+  // testStateA ports default to ingress VLAN 0; give port 1 a real one
+  state->getPorts()->getPort(PortID(1))->setIngressVlan(VlanID(1));
+  auto sw = createMockSw(state, kLocalMac);
+
+  auto ctx = sw->getPortSendContextTable()->getContext(PortID(1));
+  ASSERT_NE(nullptr, ctx);
+  EXPECT_EQ(PortID(1), ctx->port);
+  EXPECT_EQ(VlanID(1), ctx->vlan);
+  EXPECT_EQ(kLocalMac, ctx->srcMac);
+
+  // Unknown ports have no context
+  EXPECT_EQ(nullptr, sw->getPortSendContextTable()->getContext(PortID(500)));
+
+  // Writing a header from the template matches writing it field by field
+  IOBuf fromCtx(IOBuf::CREATE, EthHdr::SIZE);
+  fromCtx.append(EthHdr::SIZE);
+  RWPrivateCursor ctxCursor(&fromCtx);
+  ctx->writeEthHeader(&ctxCursor, kDstMac, 0x88cc);
+
+  IOBuf fromFields(IOBuf::CREATE, EthHdr::SIZE);
+  fromFields.append(EthHdr::SIZE);
+  RWPrivateCursor fieldCursor(&fromFields);
+  TxPacket::writeEthHeader(&fieldCursor, kDstMac, kLocalMac, VlanID(1),
+                           0x88cc);
+
+  EXPECT_EQ(0, memcmp(fromCtx.data(), fromFields.data(), EthHdr::SIZE));
+}
+
+TEST(PortSendContextTableTest, FollowsStateUpdates) {
+  auto state = testStateA();
+  state->getPorts()->getPort(PortID(1))->setIngressVlan(VlanID(1));
+  auto sw = createMockSw(state, kLocalMac);
+
+  auto ctx = sw->getPortSendContextTable()->getContext(PortID(1));
+  ASSERT_NE(nullptr, ctx);
+  EXPECT_EQ(VlanID(1), ctx->vlan);
+
+  sw->updateStateBlocking("change ingress vlan",
+      [](const shared_ptr<SwitchState>& in) {
+        auto newState = in->clone();
+        auto newPort = newState->getPorts()->getPort(PortID(1))
+            ->modify(&newState);
+        newPort->setIngressVlan(VlanID(55));
+        return newState;
+      });
+  waitForStateUpdates(sw.get());
+
+  // The table follows the published state; contexts handed out earlier
+  // still see the snapshot they were resolved against.
+  auto newCtx = sw->getPortSendContextTable()->getContext(PortID(1));
+  ASSERT_NE(nullptr, newCtx);
+  EXPECT_EQ(VlanID(55), newCtx->vlan);
+  EXPECT_EQ(VlanID(1), ctx->vlan);
+}
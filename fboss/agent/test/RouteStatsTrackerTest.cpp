@@ -0,0 +1,98 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/RouteStatsTracker.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/RouteTableMap.h"
+#include "fboss/agent/state/RouteTableRib.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/test/TestUtils.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+using namespace facebook::fboss;
+
+namespace {
+
+// Count routes the slow way, by walking the route tables, so we can
+// verify the incrementally maintained counts against ground truth.
+void expectedCounts(const std::shared_ptr<SwitchState>& state,
+                    int64_t* v4, int64_t* v6) {
+  *v4 = 0;
+  *v6 = 0;
+  for (const auto& rt : *state->getRouteTables()) {
+    *v4 += rt->getRibV4()->size();
+    *v6 += rt->getRibV6()->size();
+  }
+}
+
+int64_t sumMaskLenCounts(const int64_t* counts, int numCounts) {
+  int64_t sum = 0;
+  for (int i = 0; i < numCounts; ++i) {
+    sum += counts[i];
+  }
+  return sum;
+}
+
+class RouteStatsTrackerTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    sw = createMockSw();
+    initState = sw->getState();
+    stateA = testStateA();
+    deltaAdd = std::make_shared<StateDelta>(initState, stateA);
+    deltaRemove = std::make_shared<StateDelta>(stateA, initState);
+    tracker = std::make_unique<RouteStatsTracker>(sw.get());
+  }
+
+  void expectMatchesState(const std::shared_ptr<SwitchState>& state) {
+    int64_t expectedV4;
+    int64_t expectedV6;
+    expectedCounts(state, &expectedV4, &expectedV6);
+    auto stats = tracker->getRouteStats();
+    EXPECT_EQ(expectedV4, stats.v4Routes);
+    EXPECT_EQ(expectedV6, stats.v6Routes);
+    // The per-mask-length breakdowns partition the totals.
+    EXPECT_EQ(expectedV4, sumMaskLenCounts(stats.v4RoutesByMaskLen, 33));
+    EXPECT_EQ(expectedV6, sumMaskLenCounts(stats.v6RoutesByMaskLen, 129));
+  }
+
+  std::unique_ptr<SwSwitch> sw;
+  std::shared_ptr<SwitchState> initState;
+  std::shared_ptr<SwitchState> stateA;
+  std::shared_ptr<StateDelta> deltaAdd;
+  std::shared_ptr<StateDelta> deltaRemove;
+  std::unique_ptr<RouteStatsTracker> tracker;
+};
+
+TEST_F(RouteStatsTrackerTest, AddRoutes) {
+  tracker->stateUpdated(*deltaAdd);
+  expectMatchesState(stateA);
+}
+
+TEST_F(RouteStatsTrackerTest, RemoveRoutes) {
+  tracker->stateUpdated(*deltaAdd);
+  tracker->stateUpdated(*deltaRemove);
+  expectMatchesState(initState);
+  // Client counts may retain zero entries, but must all be zero.
+  for (const auto& entry : tracker->getRouteStats().routesByClient) {
+    EXPECT_EQ(0, entry.second);
+  }
+}
+
+TEST_F(RouteStatsTrackerTest, RepeatedUpdatesStayConsistent) {
+  tracker->stateUpdated(*deltaAdd);
+  tracker->stateUpdated(*deltaRemove);
+  tracker->stateUpdated(*deltaAdd);
+  expectMatchesState(stateA);
+}
+
+} // anonymous namespace
@@ -100,6 +100,13 @@ class RouteUpdateLoggerTest : public ::testing::Test {
     startLogging("0.0.0.0", 0);
   }
 
+  // Logging is asynchronous; wait for the formatter thread to catch up
+  // before checking what was written.
+  void updateAndFlush(const StateDelta& delta) {
+    routeUpdateLogger->stateUpdated(delta);
+    routeUpdateLogger->flush();
+  }
+
   void expectNoChanged() {
     EXPECT_EQ(0, mockRouteLoggerV4->changed.size());
     EXPECT_EQ(0, mockRouteLoggerV6->changed.size());
@@ -135,7 +142,7 @@ class RouteUpdateLoggerTest : public ::testing::Test {
 // Adding some routes will get logged correctly
 TEST_F(RouteUpdateLoggerTest, LogAdded) {
   logAllRouteUpdates();
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(5, mockRouteLoggerV4->added.size());
   EXPECT_EQ(3, mockRouteLoggerV6->added.size());
   expectNoChanged();
@@ -145,7 +152,7 @@ TEST_F(RouteUpdateLoggerTest, LogAdded) {
 // Removing some routes will get logged correctly
 TEST_F(RouteUpdateLoggerTest, LogRemoved) {
   logAllRouteUpdates();
-  routeUpdateLogger->stateUpdated(*deltaRemove);
+  updateAndFlush(*deltaRemove);
   EXPECT_EQ(5, mockRouteLoggerV4->removed.size());
   EXPECT_EQ(3, mockRouteLoggerV6->removed.size());
   expectNoChanged();
@@ -154,8 +161,8 @@ TEST_F(RouteUpdateLoggerTest, LogRemoved) {
 
 // If no logging is enabled, nothing gets logged
 TEST_F(RouteUpdateLoggerTest, LogUntracked) {
-  routeUpdateLogger->stateUpdated(*deltaAdd);
-  routeUpdateLogger->stateUpdated(*deltaRemove);
+  updateAndFlush(*deltaAdd);
+  updateAndFlush(*deltaRemove);
   expectNoLogging();
 }
 
@@ -163,7 +170,7 @@ TEST_F(RouteUpdateLoggerTest, LogUntracked) {
 TEST_F(RouteUpdateLoggerTest, TrackWrongPrefix) {
   startLogging("1:1:1:1::", 64);
   startLogging("1.1.1.1", 16);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   expectNoChanged();
 }
 
@@ -172,7 +179,7 @@ TEST_F(RouteUpdateLoggerTest, TrackWrongPrefix) {
 TEST_F(RouteUpdateLoggerTest, LogTrackedPrefix) {
   startLogging("192.168.0.0", 24);
   startLogging("2401:db00:2110:3001::", 64);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(1, mockRouteLoggerV4->added.size());
   EXPECT_EQ(1, mockRouteLoggerV6->added.size());
 }
@@ -181,7 +188,7 @@ TEST_F(RouteUpdateLoggerTest, LogTrackedPrefix) {
 TEST_F(RouteUpdateLoggerTest, MoreSpecificPrefix) {
   startLogging("192.168.0.0", 16);
   startLogging("2401:db00::", 32);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(2, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
 }
@@ -191,7 +198,7 @@ TEST_F(RouteUpdateLoggerTest, MoreSpecificPrefix) {
 TEST_F(RouteUpdateLoggerTest, MoreSpecificPrefixExactLogging) {
   startLogging("192.168.0.0", 16, "", true);
   startLogging("2401:db00::", 32, "", true);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   expectNoChanged();
   expectNoRemoved();
 }
@@ -200,15 +207,15 @@ TEST_F(RouteUpdateLoggerTest, MoreSpecificPrefixExactLogging) {
 TEST_F(RouteUpdateLoggerTest, StopLogging) {
   startLogging("192.168.0.0", 16);
   startLogging("2401:db00::", 32);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(2, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
   stopLogging("2401:db00::", 32);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(4, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
   stopLogging("192.168.0.0", 16);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(4, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
   expectNoChanged();
@@ -219,16 +226,16 @@ TEST_F(RouteUpdateLoggerTest, StopLogging) {
 TEST_F(RouteUpdateLoggerTest, RestartLogging) {
   startLogging("192.168.0.0", 16);
   startLogging("2401:db00::", 32);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(2, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
   stopLogging("192.168.0.0", 16);
   stopLogging("2401:db00::", 32);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(2, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
   startLogging("2401:db00::", 32);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(2, mockRouteLoggerV4->added.size());
   EXPECT_EQ(4, mockRouteLoggerV6->added.size());
   expectNoChanged();
@@ -240,12 +247,12 @@ TEST_F(RouteUpdateLoggerTest, RestartLogging) {
 TEST_F(RouteUpdateLoggerTest, SwitchToExact) {
   startLogging("192.168.0.0", 16);
   startLogging("2401:db00::", 32);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(2, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
   startLogging("192.168.0.0", 16, "", true);
   startLogging("2401:db00::", 32, "", true);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(2, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
   expectNoChanged();
@@ -257,11 +264,11 @@ TEST_F(RouteUpdateLoggerTest, SwitchToExact) {
 TEST_F(RouteUpdateLoggerTest, SwitchToAllowMoreSpecific) {
   startLogging("192.168.0.0", 16, "", true);
   startLogging("2401:db00::", 32, "", true);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   expectNoLogging();
   startLogging("192.168.0.0", 16);
   startLogging("2401:db00::", 32);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(2, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
   expectNoChanged();
@@ -273,7 +280,7 @@ TEST_F(RouteUpdateLoggerTest, SwitchToAllowMoreSpecific) {
 TEST_F(RouteUpdateLoggerTest, StartLoggingFromDifferentUsers) {
   startLogging("192.168.0.0", 16, "foo", false);
   startLogging("2401:db00::", 32, "bar", false);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(2, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
   expectNoChanged();
@@ -284,15 +291,15 @@ TEST_F(RouteUpdateLoggerTest, StartLoggingFromDifferentUsers) {
 TEST_F(RouteUpdateLoggerTest, StopForOneUser) {
   startLogging("2401:db00::", 32, "foo", false);
   startLogging("2401:db00::", 32, "bar", false);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(0, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
   stopLogging("2401:db00::", 32, "bar");
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(0, mockRouteLoggerV4->added.size());
   EXPECT_EQ(4, mockRouteLoggerV6->added.size());
   stopLogging("2401:db00::", 32, "foo");
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(0, mockRouteLoggerV4->added.size());
   EXPECT_EQ(4, mockRouteLoggerV6->added.size());
   expectNoChanged();
@@ -304,11 +311,11 @@ TEST_F(RouteUpdateLoggerTest, ClearForOneUser) {
   startLogging("192.168.0.0", 16, "foo", false);
   startLogging("2401:db00::", 32, "foo", false);
   startLogging("2401:db00::", 32, "bar", false);
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(2, mockRouteLoggerV4->added.size());
   EXPECT_EQ(2, mockRouteLoggerV6->added.size());
   routeUpdateLogger->stopLoggingForIdentifier("foo");
-  routeUpdateLogger->stateUpdated(*deltaAdd);
+  updateAndFlush(*deltaAdd);
   EXPECT_EQ(2, mockRouteLoggerV4->added.size());
   EXPECT_EQ(4, mockRouteLoggerV6->added.size());
 }
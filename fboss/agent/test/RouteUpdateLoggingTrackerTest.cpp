@@ -142,6 +142,23 @@ TEST_F(PrefixTrackerTest, DeleteLessSpecificTracked) {
   checkNotTracking(p2);
 }
 
+// Track a batch of prefixes in one call
+TEST_F(PrefixTrackerTest, BulkTrack) {
+  checkNotTracking(p1);
+  checkNotTracking(pFull);
+  std::vector<RouteUpdateLoggingInstance> reqs{
+      {RoutePrefix<folly::IPAddress>{folly::IPAddress{"1:1:1:1::"}, 64},
+       "",
+       false},
+      {RoutePrefix<folly::IPAddress>{folly::IPAddress{"::1:1:1:1"}, 128},
+       "",
+       false}};
+  tracker.track(reqs);
+  checkTracking(p1);
+  checkTracking(pFull);
+  checkNotTracking(p2);
+}
+
 // Try to stop tracking a less specific (but untracked) prefix than one we are
 // actually tracking. The more specific prefix should still be tracked
 TEST_F(PrefixTrackerTest, DeleteLessSpecificUntracked) {
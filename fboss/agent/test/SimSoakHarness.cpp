@@ -0,0 +1,389 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+//
+// Long-running soak harness that drives the real SwSwitch against the
+// software-only SimSwitch.  It applies scripted workloads -- BGP-style
+// route churn, neighbor create/flush flaps, port link flaps, config
+// reapplies and rx packet floods -- in a loop for a configurable
+// duration, and periodically reports per-update latency, update counts
+// and process memory growth.
+//
+// This is intended for qualifying agent builds for performance and
+// memory stability before they ever touch hardware:
+//
+//   sim_soak_harness --soak_duration_secs=14400 --churn_routes=4000
+//
+// A steadily growing RSS across report intervals with a flat workload
+// is a leak; a growing per-update latency is accumulating state-update
+// cost.  Stats histograms (update queue depth, batch latency, rx trace)
+// are also populated and can be inspected via the normal counters.
+//
+#include <boost/cast.hpp>
+
+#include <folly/Memory.h>
+#include <folly/String.h>
+#include <gflags/gflags.h>
+
+#include "fboss/agent/ApplyThriftConfig.h"
+#include "fboss/agent/NeighborUpdater.h"
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/TunManager.h"
+#include "fboss/agent/gen-cpp2/switch_config_types.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+#include "fboss/agent/hw/sim/SimPlatform.h"
+#include "fboss/agent/hw/sim/SimSwitch.h"
+#include "fboss/agent/state/ArpResponseTable.h"
+#include "fboss/agent/state/Interface.h"
+#include "fboss/agent/state/RouteUpdater.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+
+#include <chrono>
+#include <fstream>
+#include <unistd.h>
+
+using namespace facebook::fboss;
+using folly::IPAddress;
+using folly::IPAddressV4;
+using folly::MacAddress;
+using std::make_unique;
+using std::make_shared;
+using std::shared_ptr;
+using std::unique_ptr;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+DEFINE_int32(soak_duration_secs, 3600,
+             "How long to run the soak workloads, in seconds");
+DEFINE_int32(report_interval_secs, 60,
+             "How often to log a progress/memory report, in seconds");
+DEFINE_int32(churn_routes, 4000,
+             "Number of routes whose next hops are flipped per churn cycle");
+DEFINE_int32(neighbor_flaps, 64,
+             "Number of neighbor entries created and flushed per cycle");
+DEFINE_int32(flood_pkts, 2000,
+             "Number of rx packets injected per flood burst");
+
+namespace {
+
+constexpr auto kVlan = VlanID(1);
+constexpr auto kRid = RouterID(0);
+constexpr auto kClient = ClientID(1001);
+
+// Global state used by the workloads
+unique_ptr<SwSwitch> sw;
+cfg::SwitchConfig config;
+
+// Simple latency accumulator, reset at each report interval.
+struct LatencyStats {
+  uint64_t count{0};
+  uint64_t sumUs{0};
+  uint64_t maxUs{0};
+
+  void record(uint64_t us) {
+    ++count;
+    sumUs += us;
+    maxUs = std::max(maxUs, us);
+  }
+  uint64_t avgUs() const {
+    return count == 0 ? 0 : sumUs / count;
+  }
+  void reset() {
+    count = sumUs = maxUs = 0;
+  }
+};
+
+LatencyStats routeLatency;
+LatencyStats configLatency;
+
+/*
+ * Current resident set size in bytes, read from /proc/self/statm.
+ * Unlike mallinfo() this doesn't wrap at 2GB and includes everything
+ * the process maps, which is what matters for a soak run.
+ */
+uint64_t rssBytes() {
+  uint64_t pages = 0;
+  uint64_t rss = 0;
+  std::ifstream statm("/proc/self/statm");
+  statm >> pages >> rss;
+  return rss * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+/*
+ * Thrift config describing the same topology setupSwitch() builds
+ * directly on the SwitchState.  Reapplying it exercises the full
+ * applyThriftConfig() path the way a config push in production would.
+ */
+cfg::SwitchConfig createSwitchConfig() {
+  cfg::SwitchConfig cfg;
+  cfg.vlans.resize(1);
+  cfg.vlans[0].name = "Vlan1";
+  cfg.vlans[0].id = 1;
+  cfg.vlans[0].routable = true;
+
+  cfg.ports.resize(9);
+  cfg.vlanPorts.resize(9);
+  for (int n = 0; n < 9; ++n) {
+    cfg.ports[n].logicalID = n + 1;
+    cfg.ports[n].state = cfg::PortState::UP;
+    cfg.ports[n].minFrameSize = 64;
+    cfg.ports[n].maxFrameSize = 9000;
+    cfg.ports[n].routable = true;
+    cfg.ports[n].ingressVlan = 1;
+
+    cfg.vlanPorts[n].vlanID = 1;
+    cfg.vlanPorts[n].logicalPort = n + 1;
+    cfg.vlanPorts[n].spanningTreeState = cfg::SpanningTreeState::FORWARDING;
+    cfg.vlanPorts[n].emitTags = false;
+  }
+
+  cfg.interfaces.resize(1);
+  cfg.interfaces[0].intfID = 1;
+  cfg.interfaces[0].vlanID = 1;
+  cfg.interfaces[0].routerID = 0;
+  cfg.interfaces[0].mac = "02:00:01:00:00:01";
+  cfg.interfaces[0].__isset.mac = true;
+  cfg.interfaces[0].mtu = 9000;
+  cfg.interfaces[0].__isset.mtu = true;
+  cfg.interfaces[0].ipAddresses.resize(2);
+  cfg.interfaces[0].ipAddresses[0] = "10.0.0.1/24";
+  cfg.interfaces[0].ipAddresses[1] = "192.168.0.1/24";
+  return cfg;
+}
+
+unique_ptr<SwSwitch> setupSwitch() {
+  MacAddress localMac("02:00:01:00:00:01");
+  auto sw = make_unique<SwSwitch>(make_unique<SimPlatform>(localMac, 10));
+  sw->init(nullptr /* No custom TunManager */);
+
+  auto updateFn = [&](const shared_ptr<SwitchState>& oldState) {
+    auto state = oldState->clone();
+
+    // Add VLAN 1, and ports 1-9 which belong to it.
+    auto vlan1 = make_shared<Vlan>(kVlan, "Vlan1");
+    state->addVlan(vlan1);
+    for (int idx = 1; idx < 10; ++idx) {
+      vlan1->addPort(PortID(idx), false);
+    }
+    // Add Interface 1 to VLAN 1
+    auto intf1 = make_shared<Interface>(
+        InterfaceID(1),
+        kRid,
+        kVlan,
+        "interface1",
+        MacAddress("02:00:01:00:00:01"),
+        9000,
+        false /* is virtual */);
+    Interface::Addresses addrs1;
+    addrs1.emplace(IPAddress("10.0.0.1"), 24);
+    addrs1.emplace(IPAddress("192.168.0.1"), 24);
+    intf1->setAddresses(addrs1);
+    state->addIntf(intf1);
+
+    // Answer ARP for the interface address so injected traffic resolves.
+    auto respTable1 = make_shared<ArpResponseTable>();
+    respTable1->setEntry(IPAddressV4("10.0.0.1"),
+                         MacAddress("02:00:01:00:00:01"),
+                         InterfaceID(1));
+    state->getVlans()->getVlan(kVlan)->setArpResponseTable(respTable1);
+    return state;
+  };
+
+  sw->updateStateBlocking("soak setup", updateFn);
+  return sw;
+}
+
+/*
+ * An ARP request from a host on VLAN 1 for our interface address.
+ * The sender IP varies with idx so each packet creates (or refreshes)
+ * a distinct neighbor entry.
+ */
+unique_ptr<MockRxPacket> makeArpRequest(int idx) {
+  auto pkt = MockRxPacket::fromHex(folly::stringPrintf(
+      // dst mac, src mac
+      "ff ff ff ff ff ff  00 02 00 %02x %02x 01"
+      // 802.1q, VLAN 1
+      "81 00  00 01"
+      // ARP, htype: ethernet, ptype: IPv4, hlen: 6, plen: 4
+      "08 06  00 01  08 00  06  04"
+      // ARP Request
+      "00 01"
+      // Sender MAC
+      "00 02 00 %02x %02x 01"
+      // Sender IP: 10.0.x.y
+      "0a 00 %02x %02x"
+      // Target MAC
+      "00 00 00 00 00 00"
+      // Target IP: 10.0.0.1
+      "0a 00 00 01",
+      (idx >> 8) & 0xff, idx & 0xff,
+      (idx >> 8) & 0xff, idx & 0xff,
+      (idx >> 8) & 0x0f, 2 + (idx & 0x3f)));
+  pkt->padToLength(68);
+  pkt->setSrcPort(PortID(1 + idx % 9));
+  pkt->setSrcVlan(kVlan);
+  return pkt;
+}
+
+/*
+ * Flip the next hop of FLAGS_churn_routes routes, the way a BGP peer
+ * bounce replays a table.  Odd and even cycles use different next hops
+ * so every cycle is a real change, never a no-op update.
+ */
+void churnRoutes(uint64_t cycle) {
+  const int numRoutes = FLAGS_churn_routes;
+  IPAddress nhop(cycle % 2 ? "10.0.0.10" : "10.0.0.20");
+  auto updateFn = [=](const shared_ptr<SwitchState>& state) {
+    RouteUpdater updater(state->getRouteTables());
+    for (int i = 0; i < numRoutes; ++i) {
+      RouteNextHops nhops;
+      nhops.emplace(nhop);
+      updater.addRoute(kRid,
+                       IPAddress(folly::stringPrintf(
+                           "10.%d.%d.0", 1 + i / 256, i % 256)),
+                       24, kClient, std::move(nhops));
+    }
+    auto newRt = updater.updateDone();
+    if (!newRt) {
+      return shared_ptr<SwitchState>();
+    }
+    auto newState = state->clone();
+    newState->resetRouteTables(std::move(newRt));
+    return newState;
+  };
+
+  auto start = steady_clock::now();
+  sw->updateStateBlocking("soak route churn", updateFn);
+  routeLatency.record(
+      duration_cast<microseconds>(steady_clock::now() - start).count());
+}
+
+/*
+ * Create neighbor entries by injecting ARP requests from distinct
+ * hosts, then flush them again, so the neighbor tables continuously
+ * grow and shrink instead of converging to a steady state.
+ */
+void flapNeighbors() {
+  for (int i = 0; i < FLAGS_neighbor_flaps; ++i) {
+    sw->packetReceived(makeArpRequest(i)->clone());
+  }
+  for (int i = 0; i < FLAGS_neighbor_flaps; ++i) {
+    sw->getNeighborUpdater()->flushEntry(
+        kVlan,
+        IPAddress(folly::stringPrintf(
+            "10.0.%d.%d", (i >> 8) & 0x0f, 2 + (i & 0x3f))));
+  }
+}
+
+/*
+ * Bounce a front panel port.  This exercises the port-down pruning
+ * paths (neighbor entries, route resolution) and the port-up recovery.
+ */
+void flapPort(uint64_t cycle) {
+  PortID port(1 + cycle % 9);
+  sw->linkStateChanged(port, false);
+  sw->linkStateChanged(port, true);
+}
+
+/*
+ * Reapply the current config.  applyThriftConfig() returns null when
+ * nothing changed, so steady-state cycles measure the cost of a no-op
+ * config push -- exactly what periodic config management does to a
+ * production switch.
+ */
+void reapplyConfig() {
+  auto platform = sw->getPlatform();
+  auto updateFn = [=](const shared_ptr<SwitchState>& state) {
+    return applyThriftConfig(state, &config, platform);
+  };
+
+  auto start = steady_clock::now();
+  sw->updateStateBlocking("soak config reapply", updateFn);
+  configLatency.record(
+      duration_cast<microseconds>(steady_clock::now() - start).count());
+}
+
+/*
+ * Blast ARP requests at the switch as fast as we can hand them over,
+ * simulating an rx trap storm.
+ */
+void floodRx(unique_ptr<MockRxPacket>& pkt) {
+  for (int i = 0; i < FLAGS_flood_pkts; ++i) {
+    sw->packetReceived(pkt->clone());
+  }
+}
+
+void report(uint64_t cycle, uint64_t baselineRss) {
+  SimSwitch* sim = boost::polymorphic_downcast<SimSwitch*>(sw->getHw());
+  uint64_t rss = rssBytes();
+  LOG(INFO) << "soak cycle " << cycle
+            << ": route update avg/max us " << routeLatency.avgUs()
+            << "/" << routeLatency.maxUs
+            << " (" << routeLatency.count << " updates)"
+            << ", config reapply avg/max us " << configLatency.avgUs()
+            << "/" << configLatency.maxUs
+            << ", tx pkts " << sim->getTxCount()
+            << ", rss " << (rss >> 20) << "MB"
+            << " (+" << ((rss - std::min(rss, baselineRss)) >> 20)
+            << "MB since start)";
+  routeLatency.reset();
+  configLatency.reset();
+}
+
+} // unnamed namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  sw = setupSwitch();
+  config = createSwitchConfig();
+  reapplyConfig();
+
+  auto floodPkt = makeArpRequest(0);
+
+  const auto deadline =
+      steady_clock::now() + seconds(FLAGS_soak_duration_secs);
+  auto nextReport = steady_clock::now() + seconds(FLAGS_report_interval_secs);
+  // Let the memory footprint of the first few cycles settle before
+  // taking the growth baseline; allocator pools warming up is expected.
+  uint64_t baselineRss = 0;
+
+  LOG(INFO) << "starting soak: " << FLAGS_soak_duration_secs << "s, "
+            << FLAGS_churn_routes << " routes churned per cycle, "
+            << FLAGS_flood_pkts << " pkts per flood burst";
+
+  uint64_t cycle = 0;
+  while (steady_clock::now() < deadline) {
+    churnRoutes(cycle);
+    flapNeighbors();
+    flapPort(cycle);
+    reapplyConfig();
+    floodRx(floodPkt);
+
+    if (cycle == 10) {
+      baselineRss = rssBytes();
+    }
+    if (steady_clock::now() >= nextReport) {
+      report(cycle, baselineRss ? baselineRss : rssBytes());
+      nextReport += seconds(FLAGS_report_interval_secs);
+    }
+    ++cycle;
+  }
+
+  report(cycle, baselineRss ? baselineRss : rssBytes());
+  LOG(INFO) << "soak complete: " << cycle << " cycles";
+
+  // Tear down in the foreground so leak tooling sees a clean exit.
+  sw.reset();
+  return 0;
+}
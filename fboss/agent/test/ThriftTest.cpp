@@ -17,8 +17,14 @@
 #include "fboss/agent/ApplyThriftConfig.h"
 #include "fboss/agent/state/Route.h"
 
+#include "fboss/agent/state/PortMap.h"
+#include "fboss/agent/state/gen-cpp2/switch_state_types.h"
+
+#include <folly/FileUtil.h>
 #include <folly/IPAddress.h>
+#include <folly/experimental/TestUtil.h>
 #include <gtest/gtest.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
 
 using namespace facebook::fboss;
 using folly::IPAddress;
@@ -29,6 +35,7 @@ using std::unique_ptr;
 using std::shared_ptr;
 using testing::UnorderedElementsAreArray;
 using facebook::network::toBinaryAddress;
+using facebook::network::toIPAddress;
 using cfg::PortSpeed;
 
 namespace {
@@ -281,3 +288,163 @@ TEST(ThriftTest, syncFib) {
   EXPECT_EQ(4, tables3->getRouteTable(rid)->getRibV4()->size());
   EXPECT_EQ(4, tables3->getRouteTable(rid)->getRibV6()->size());
 }
+
+// Test for the paged route table dump
+TEST(ThriftTest, getRouteTableChunk) {
+  // Create a config
+  cfg::SwitchConfig config;
+  config.vlans.resize(1);
+  config.vlans[0].id = 1;
+  config.interfaces.resize(1);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:02:00:00:00:01";
+  config.interfaces[0].ipAddresses.resize(2);
+  config.interfaces[0].ipAddresses[0] = "10.0.0.1/24";
+  config.interfaces[0].ipAddresses[1] = "2401:db00:2110:3001::0001/64";
+
+  auto mockSw = createMockSw(&config);
+  mockSw->initialConfigApplied(std::chrono::steady_clock::now());
+  mockSw->fibSynced();
+  ThriftHandler handler(mockSw.get());
+
+  handler.addUnicastRoute(1, makeUnicastRoute("7.1.0.0/16", "10.0.0.10"));
+  handler.addUnicastRoute(1, makeUnicastRoute("7.2.0.0/16", "10.0.0.10"));
+  handler.addUnicastRoute(1, makeUnicastRoute("aaaa:1::0/64",
+                                              "2401:db00:2110:3001::0002"));
+
+  // The paged dump must return exactly the same routes as the one-shot
+  // dump, in the same order.
+  std::vector<UnicastRoute> expected;
+  handler.getRouteTable(expected);
+  ASSERT_GT(expected.size(), 2);
+
+  std::vector<UnicastRoute> paged;
+  RouteTableChunk chunk;
+  int64_t cursor = 0;
+  do {
+    chunk = RouteTableChunk();
+    handler.getRouteTableChunk(chunk, cursor, 2);
+    EXPECT_LE(chunk.routes.size(), 2);
+    paged.insert(paged.end(), chunk.routes.begin(), chunk.routes.end());
+    cursor = chunk.cursor;
+  } while (!chunk.isLast);
+  EXPECT_EQ(0, chunk.cursor);
+  EXPECT_EQ(expected, paged);
+
+  // A dump started before a route change still serves the snapshot it
+  // was started from.
+  RouteTableChunk first;
+  handler.getRouteTableChunk(first, 0, 2);
+  ASSERT_FALSE(first.isLast);
+  handler.addUnicastRoute(1, makeUnicastRoute("7.3.0.0/16", "10.0.0.10"));
+  std::vector<UnicastRoute> snapshot(first.routes);
+  cursor = first.cursor;
+  do {
+    chunk = RouteTableChunk();
+    handler.getRouteTableChunk(chunk, cursor, 2);
+    snapshot.insert(snapshot.end(), chunk.routes.begin(), chunk.routes.end());
+    cursor = chunk.cursor;
+  } while (!chunk.isLast);
+  EXPECT_EQ(expected, snapshot);
+
+  // An unknown cursor should be rejected
+  EXPECT_THROW(handler.getRouteTableChunk(chunk, 999999, 2), FbossError);
+}
+
+// Test for the prefix-range route details query
+TEST(ThriftTest, getRouteTableDetailsRange) {
+  // Create a config
+  cfg::SwitchConfig config;
+  config.vlans.resize(1);
+  config.vlans[0].id = 1;
+  config.interfaces.resize(1);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:02:00:00:00:01";
+  config.interfaces[0].ipAddresses.resize(2);
+  config.interfaces[0].ipAddresses[0] = "10.0.0.1/24";
+  config.interfaces[0].ipAddresses[1] = "2401:db00:2110:3001::0001/64";
+
+  auto mockSw = createMockSw(&config);
+  mockSw->initialConfigApplied(std::chrono::steady_clock::now());
+  mockSw->fibSynced();
+  ThriftHandler handler(mockSw.get());
+
+  handler.addUnicastRoute(1, makeUnicastRoute("7.1.0.0/16", "10.0.0.10"));
+  handler.addUnicastRoute(1, makeUnicastRoute("7.2.0.0/16", "10.0.0.10"));
+  handler.addUnicastRoute(1, makeUnicastRoute("7.3.0.0/16", "10.0.0.10"));
+  handler.addUnicastRoute(1, makeUnicastRoute("aaaa:1::0/64",
+                                              "2401:db00:2110:3001::0002"));
+
+  // The paged walk must return exactly the v4 routes the one-shot dump
+  // returns, in the same order.
+  std::vector<RouteDetails> expected;
+  handler.getRouteTableDetails(expected);
+  std::vector<RouteDetails> expectedV4;
+  for (const auto& rd : expected) {
+    if (toIPAddress(rd.dest.ip).isV4()) {
+      expectedV4.push_back(rd);
+    }
+  }
+  ASSERT_GT(expectedV4.size(), 2);
+
+  std::vector<RouteDetails> paged;
+  auto cursor = ipPrefix("0.0.0.0", 0);
+  RouteTableDetailsPage page;
+  do {
+    page = RouteTableDetailsPage();
+    handler.getRouteTableDetailsRange(
+        page, 0, std::make_unique<IpPrefix>(cursor), 2);
+    EXPECT_LE(page.routes.size(), 2);
+    paged.insert(paged.end(), page.routes.begin(), page.routes.end());
+    if (!page.isLast) {
+      cursor = page.nextPrefix;
+    }
+  } while (!page.isLast);
+  EXPECT_EQ(expectedV4, paged);
+
+  // An unknown VRF should be rejected
+  EXPECT_THROW(
+      handler.getRouteTableDetailsRange(
+          page, 99, std::make_unique<IpPrefix>(cursor), 2),
+      FbossError);
+}
+
+TEST(ThriftTest, dumpOperState) {
+  auto sw = setupSwitch();
+  ThriftHandler handler(sw.get());
+  handler.addUnicastRoute(1, makeUnicastRoute("7.1.0.0/16", "10.0.0.10"));
+
+  folly::test::TemporaryFile dumpFile;
+  auto path = dumpFile.path().string();
+  handler.dumpOperState(std::make_unique<std::string>("ports,routes:0"),
+                        std::make_unique<std::string>(path));
+
+  std::string in;
+  ASSERT_TRUE(folly::readFile(path.c_str(), in));
+  state::OperStateSnapshot snapshot;
+  apache::thrift::CompactSerializer::deserialize(in, snapshot);
+
+  ASSERT_TRUE(snapshot.__isset.ports);
+  EXPECT_EQ(sw->getState()->getPorts()->numPorts(),
+            snapshot.ports.ports.size());
+  ASSERT_TRUE(snapshot.__isset.fib);
+  ASSERT_EQ(1, snapshot.fib.tables.size());
+  EXPECT_EQ(0, snapshot.fib.tables[0].routerId);
+  EXPECT_FALSE(snapshot.__isset.neighbors);
+
+  // Unknown subtrees and vrfs are rejected
+  EXPECT_THROW(
+      handler.dumpOperState(std::make_unique<std::string>("bogus"),
+                            std::make_unique<std::string>(path)),
+      FbossError);
+  EXPECT_THROW(
+      handler.dumpOperState(std::make_unique<std::string>("routes:99"),
+                            std::make_unique<std::string>(path)),
+      FbossError);
+}
@@ -20,6 +20,9 @@
 #include "fboss/agent/test/TestUtils.h"
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/UDPHeader.h"
+#include "fboss/agent/packet/IPProto.h"
+#include "fboss/agent/packet/IPv4Hdr.h"
+#include "fboss/agent/packet/PktUtil.h"
 
 #include <boost/cast.hpp>
 #include <gtest/gtest.h>
@@ -81,6 +84,42 @@ TEST(UDPTest, Parse) {
 }
 
 
+TEST(UDPTest, IncrementalChecksumPatch) {
+  IPv4Hdr ipHdr(4, IPv4Hdr::minSize() / 4, 0, 0,
+      IPv4Hdr::minSize() + UDPHeader::size() + 8, 0, false, false, 0, 64,
+      IP_PROTO::IP_PROTO_UDP, 0,
+      folly::IPAddressV4("10.0.0.1"), folly::IPAddressV4("10.0.0.2"));
+  auto payload = MockRxPacket::fromHex("00 01 02 03 04 05 06 07");
+  UDPHeader hdr(1024, 2048, UDPHeader::size() + 8);
+  hdr.updateChecksum(ipHdr, Cursor(payload->buf()));
+
+  // Rewrite the addresses and ports, NAT style, and patch the checksum
+  // incrementally; it must match a from-scratch computation.
+  IPv4Hdr newIpHdr(ipHdr);
+  newIpHdr.srcAddr = folly::IPAddressV4("192.168.0.1");
+  newIpHdr.dstAddr = folly::IPAddressV4("192.168.255.2");
+  UDPHeader newHdr(4096, 67, hdr.length, hdr.csum);
+  newHdr.patchChecksum(ipHdr.srcAddr, newIpHdr.srcAddr);
+  newHdr.patchChecksum(ipHdr.dstAddr, newIpHdr.dstAddr);
+  newHdr.patchChecksum(hdr.srcPort, newHdr.srcPort);
+  newHdr.patchChecksum(hdr.dstPort, newHdr.dstPort);
+  EXPECT_EQ(newHdr.computeChecksum(newIpHdr, Cursor(payload->buf())),
+            newHdr.csum);
+
+  // Replace a block of the payload and patch from the partial sums.
+  auto newPayload = MockRxPacket::fromHex("00 01 02 03 ff fe fd 00");
+  newHdr.patchChecksumPartial(
+      PktUtil::partialChecksum(Cursor(payload->buf()), 8),
+      PktUtil::partialChecksum(Cursor(newPayload->buf()), 8));
+  EXPECT_EQ(newHdr.computeChecksum(newIpHdr, Cursor(newPayload->buf())),
+            newHdr.csum);
+
+  // A zero checksum means "not computed" and must stay untouched.
+  UDPHeader noCsumHdr(1024, 2048, UDPHeader::size() + 8, 0);
+  noCsumHdr.patchChecksum(hdr.srcPort, newHdr.srcPort);
+  EXPECT_EQ(0, noCsumHdr.csum);
+}
+
 TEST(UDPTest, Write) {
   UDPHeader hdr1(1667, 1668, 512, 0x3412);
   auto buf = IOBuf::create(0);
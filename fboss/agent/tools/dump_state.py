@@ -0,0 +1,93 @@
+#!/usr/bin/env python
+# Copyright (C) 2004-present Facebook. All Rights Reserved
+
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+from __future__ import absolute_import
+
+"""Pretty print an operational state dump taken with the dumpOperState
+thrift call.
+
+The agent writes the dump as a compact-binary OperStateSnapshot so the
+on-box cost stays sub-second even at full FIB scale; this tool does the
+expensive formatting off box:
+
+    fboss_agent_client dumpOperState "ports,routes:0" /tmp/dump.bin
+    dump_state.py /tmp/dump.bin
+"""
+
+import socket
+import time
+
+from argparse import ArgumentParser
+from thrift.protocol import TCompactProtocol
+from thrift.transport import TTransport
+from fboss.switch_state.ttypes import OperStateSnapshot
+
+
+def format_ip(binary_addr):
+    family = socket.AF_INET if len(binary_addr.addr) == 4 else socket.AF_INET6
+    return socket.inet_ntop(family, binary_addr.addr)
+
+
+def print_ports(ports):
+    print('== Ports ==')
+    for port in sorted(ports.ports, key=lambda p: p.portId):
+        print('  port {} ({}): admin={} oper={} speed={}Mbps '
+              'ingressVlan={}{}'.format(
+                  port.portId, port.name or '-', port.adminState,
+                  'up' if port.operUp else 'down', port.speedMbps,
+                  port.ingressVlan,
+                  ' # {}'.format(port.description) if port.description
+                  else ''))
+
+
+def print_neighbors(neighbors):
+    print('== Neighbors ==')
+    for table in neighbors.tables:
+        print('  vlan {}:'.format(table.vlanId))
+        for entry in table.entriesV4 + table.entriesV6:
+            print('    {} -> {} port={} intf={}'.format(
+                format_ip(entry.ip), entry.mac, entry.port,
+                entry.interfaceId))
+
+
+def print_routes(fib):
+    print('== Routes ==')
+    for table in fib.tables:
+        print('  vrf {}:'.format(table.routerId))
+        for route in table.routesV4 + table.routesV6:
+            nexthops = ', '.join(
+                '{}@intf{}'.format(format_ip(nh.nexthop), nh.interfaceId)
+                for nh in route.fwd.nexthops)
+            print('    {}/{} action={} [{}]'.format(
+                format_ip(route.prefix.network), route.prefix.mask,
+                route.fwd.action, nexthops))
+
+
+def main():
+    ap = ArgumentParser()
+    ap.add_argument('dump', help='file written by the dumpOperState call')
+    args = ap.parse_args()
+
+    with open(args.dump, 'rb') as f:
+        data = f.read()
+    snapshot = OperStateSnapshot()
+    transport = TTransport.TMemoryBuffer(data)
+    snapshot.read(TCompactProtocol.TCompactProtocol(transport))
+
+    print('dump taken at {} ({} bytes)'.format(
+        time.strftime('%Y-%m-%d %H:%M:%S',
+                      time.localtime(snapshot.timestampMs / 1000.0)),
+        len(data)))
+    if snapshot.ports is not None:
+        print_ports(snapshot.ports)
+    if snapshot.neighbors is not None:
+        print_neighbors(snapshot.neighbors)
+    if snapshot.fib is not None:
+        print_routes(snapshot.fib)
+
+
+if __name__ == '__main__':
+    main()
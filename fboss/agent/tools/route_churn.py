@@ -0,0 +1,306 @@
+#!/usr/bin/env python
+# Copyright (C) 2004-present Facebook. All Rights Reserved
+
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+from __future__ import absolute_import
+
+"""Route churn simulator for the FBOSS agent.
+
+Replays recorded or synthetic route-update traces (add/del/syncFib
+mixes with configurable rates, ECMP widths and prefix distributions)
+against a running agent over its FbossCtrl Thrift interface, then
+reports the server-side apply latency from the agent's convergence
+tracker. Intended as a pre-deploy performance gate on a lab switch:
+run the same workload against two agent builds and compare the
+latency summaries.
+
+Synthetic workload:
+
+    python route_churn.py synth --entries 16000 --rate 500 \\
+        --add-weight 6 --del-weight 3 --sync-weight 1 \\
+        --ecmp-width 8 --minprefix 48 --maxprefix 64 --duration 60
+
+Replay a recorded trace (one JSON object per line, see --help):
+
+    python route_churn.py replay --trace churn.trace --rate 500
+
+Each trace line is {"op": "add"|"del"|"sync", "routes": [...]} where a
+route is {"prefix": "2401:db00::/48", "nexthops": ["fe80::1", ...]}.
+A synthetic run can be saved with --record for later replay.
+"""
+
+import contextlib
+import ipaddr
+import json
+import random
+import time
+
+from argparse import ArgumentParser
+from thrift.transport import TSocket
+from thrift.protocol import TBinaryProtocol
+from neteng.fboss.ctrl import FbossCtrl
+from neteng.fboss.ctrl.ttypes import IpPrefix
+from neteng.fboss.ctrl.ttypes import UnicastRoute
+from facebook.network.Address.ttypes import BinaryAddress
+
+DEFAULT_CLIENTID = 31337
+
+
+def make_prefix(prefix_str):
+    network = ipaddr.IPNetwork(prefix_str)
+    return IpPrefix(ip=BinaryAddress(addr=network.ip.packed),
+                    prefixLength=network.prefixlen)
+
+
+def make_route(prefix_str, nexthop_strs):
+    nexthops = [BinaryAddress(addr=ipaddr.IPAddress(nh).packed)
+                for nh in nexthop_strs]
+    return UnicastRoute(dest=make_prefix(prefix_str), nextHopAddrs=nexthops)
+
+
+class Workload(object):
+    """Generates a synthetic add/del/sync trace.
+
+    Keeps a model of the routes currently installed so deletes target
+    live prefixes and syncFib carries the full current table, the way a
+    route server would.
+    """
+
+    def __init__(self, args):
+        random.seed(args.seed)
+        self.args = args
+        self.installed = {}
+        self.nexthop_pool = ['fe80::%x' % (i + 1)
+                             for i in range(args.nexthop_pool)]
+
+    def random_prefix(self):
+        prefixlen = random.randint(self.args.minprefix, self.args.maxprefix)
+        # Confine the address bits to the prefix, quantized to bytes so
+        # packing stays simple.
+        addr = bytearray(16)
+        for i in range(prefixlen // 8):
+            addr[i] = random.randint(0, 255)
+        addr[0] = 0x24  # stay in global unicast space
+        value = 0
+        for byte in addr:
+            value = (value << 8) | byte
+        return '%s/%d' % (ipaddr.IPv6Address(value), prefixlen)
+
+    def random_nexthops(self):
+        return random.sample(self.nexthop_pool, self.args.ecmp_width)
+
+    def prefill(self):
+        """The initial table the churn runs against."""
+        while len(self.installed) < self.args.entries:
+            self.installed[self.random_prefix()] = self.random_nexthops()
+        return [{'op': 'sync',
+                 'routes': [{'prefix': p, 'nexthops': nh}
+                            for p, nh in self.installed.items()]}]
+
+    def next_op(self):
+        weights = [('add', self.args.add_weight),
+                   ('del', self.args.del_weight),
+                   ('sync', self.args.sync_weight)]
+        total = sum(w for _, w in weights)
+        pick = random.uniform(0, total)
+        for op, weight in weights:
+            pick -= weight
+            if pick <= 0:
+                break
+        if op == 'del' and not self.installed:
+            op = 'add'
+
+        if op == 'add':
+            prefix = self.random_prefix()
+            nexthops = self.random_nexthops()
+            self.installed[prefix] = nexthops
+            routes = [{'prefix': prefix, 'nexthops': nexthops}]
+        elif op == 'del':
+            prefix = random.choice(list(self.installed))
+            del self.installed[prefix]
+            routes = [{'prefix': prefix}]
+        else:
+            # Re-sync the full current table, plus a batch of fresh
+            # routes so the sync isn't a no-op delta.
+            for _ in range(self.args.sync_batch):
+                self.installed[self.random_prefix()] = self.random_nexthops()
+            routes = [{'prefix': p, 'nexthops': nh}
+                      for p, nh in self.installed.items()]
+        return {'op': op, 'routes': routes}
+
+
+class Replayer(object):
+    def __init__(self, client, args):
+        self.client = client
+        self.args = args
+        self.ops = {'add': 0, 'del': 0, 'sync': 0}
+        self.routes_sent = 0
+
+    def apply(self, entry):
+        op = entry['op']
+        routes = entry['routes']
+        if op == 'add':
+            self.client.addUnicastRoutes(
+                self.args.client,
+                [make_route(r['prefix'], r['nexthops']) for r in routes])
+        elif op == 'del':
+            self.client.deleteUnicastRoutes(
+                self.args.client,
+                [make_prefix(r['prefix']) for r in routes])
+        elif op == 'sync':
+            self.client.syncFib(
+                self.args.client,
+                [make_route(r['prefix'], r['nexthops']) for r in routes])
+        else:
+            raise Exception('unknown trace op %r' % op)
+        self.ops[op] += 1
+        self.routes_sent += len(routes)
+
+    def run(self, trace):
+        """Apply trace entries, paced to --rate operations per second."""
+        interval = 1.0 / self.args.rate if self.args.rate > 0 else 0
+        start = time.time()
+        next_deadline = start
+        for entry in trace:
+            now = time.time()
+            if now < next_deadline:
+                time.sleep(next_deadline - now)
+            self.apply(entry)
+            next_deadline += interval
+        return time.time() - start
+
+
+def percentile(sorted_values, pct):
+    if not sorted_values:
+        return 0
+    idx = min(len(sorted_values) - 1,
+              int(len(sorted_values) * pct / 100.0))
+    return sorted_values[idx]
+
+
+def report_convergence(client):
+    """Summarize the agent-side latency of the updates we generated."""
+    traces = client.getConvergenceTraces(0)
+    if not traces:
+        print('no convergence traces reported by the agent')
+        return
+    print('%d convergence traces:' % len(traces))
+    for field in ('queueUsec', 'applyUsec', 'hwUsec', 'totalUsec'):
+        values = sorted(getattr(t, field) for t in traces)
+        print('  %-9s p50=%8dus  p90=%8dus  p99=%8dus  max=%8dus' % (
+            field[:-4], percentile(values, 50), percentile(values, 90),
+            percentile(values, 99), values[-1]))
+    slowest = max(traces, key=lambda t: t.totalUsec)
+    print('  slowest: %s (%dus total)' % (slowest.updateName,
+                                          slowest.totalUsec))
+
+
+def run_synth(args):
+    workload = Workload(args)
+    trace = workload.prefill()
+    count = int(args.duration * args.rate)
+    for _ in range(count):
+        trace.append(workload.next_op())
+    if args.record:
+        with open(args.record, 'w') as f:
+            for entry in trace:
+                f.write(json.dumps(entry) + '\n')
+        print('recorded %d trace entries to %s' % (len(trace), args.record))
+    run_trace(args, trace)
+
+
+def run_replay(args):
+    with open(args.trace) as f:
+        trace = [json.loads(line) for line in f if line.strip()]
+    run_trace(args, trace)
+
+
+def run_trace(args, trace):
+    with get_client(args) as client:
+        replayer = Replayer(client, args)
+        elapsed = replayer.run(trace)
+        print('replayed %d ops (%d adds, %d dels, %d syncs), '
+              '%d routes in %.1fs' % (
+                  sum(replayer.ops.values()), replayer.ops['add'],
+                  replayer.ops['del'], replayer.ops['sync'],
+                  replayer.routes_sent, elapsed))
+        report_convergence(client)
+        if args.cleanup:
+            client.syncFib(args.client, [])
+
+
+@contextlib.contextmanager
+def get_client(args, timeout=60.0):
+    sock = TSocket.TSocket(args.host, args.port)
+    sock.setTimeout(timeout * 1000)  # thrift timeout is in ms
+    protocol = TBinaryProtocol.TBinaryProtocol(sock)
+    transport = protocol.trans
+    transport.open()
+    client = FbossCtrl.Client(protocol)
+    yield client
+    transport.close()
+
+
+def add_common_args(parser):
+    parser.add_argument('--host', default='localhost',
+                        help='the host to connect to')
+    parser.add_argument('--port', type=int, default=5909,
+                        help='the controller thrift port')
+    parser.add_argument('--client', type=int, default=DEFAULT_CLIENTID,
+                        help='the client ID used to manipulate the routes')
+    parser.add_argument('--rate', type=float, default=100,
+                        help='operations per second; 0 replays flat out')
+    parser.add_argument('--no-cleanup', dest='cleanup', action='store_false',
+                        default=True,
+                        help='leave the generated routes installed on exit')
+
+
+def main():
+    ap = ArgumentParser(description=__doc__)
+    subparsers = ap.add_subparsers(dest='command')
+    subparsers.required = True
+
+    synth = subparsers.add_parser(
+        'synth', help='generate and replay a synthetic churn workload')
+    add_common_args(synth)
+    synth.add_argument('--entries', type=int, default=16000,
+                       help='routes installed before the churn starts')
+    synth.add_argument('--duration', type=float, default=60,
+                       help='seconds of churn to generate')
+    synth.add_argument('--add-weight', type=int, default=6,
+                       help='relative frequency of single-route adds')
+    synth.add_argument('--del-weight', type=int, default=3,
+                       help='relative frequency of single-route deletes')
+    synth.add_argument('--sync-weight', type=int, default=1,
+                       help='relative frequency of full syncFib calls')
+    synth.add_argument('--sync-batch', type=int, default=100,
+                       help='new routes folded into each syncFib')
+    synth.add_argument('--ecmp-width', type=int, default=8,
+                       help='nexthops per route')
+    synth.add_argument('--nexthop-pool', type=int, default=64,
+                       help='distinct nexthops the routes draw from')
+    synth.add_argument('--minprefix', type=int, default=48,
+                       help='shortest generated prefix length')
+    synth.add_argument('--maxprefix', type=int, default=64,
+                       help='longest generated prefix length')
+    synth.add_argument('--seed', type=int, default=0,
+                       help='pseudorandom seed, for repeatable workloads')
+    synth.add_argument('--record', metavar='FILE',
+                       help='also save the generated trace for replay')
+    synth.set_defaults(func=run_synth)
+
+    replay = subparsers.add_parser(
+        'replay', help='replay a recorded trace file')
+    add_common_args(replay)
+    replay.add_argument('--trace', required=True,
+                        help='trace file, one JSON op per line')
+    replay.set_defaults(func=run_replay)
+
+    args = ap.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/lib/HugePages.h"
+
+#include <folly/String.h>
+#include <glog/logging.h>
+
+#include <sys/mman.h>
+
+#include <atomic>
+
+namespace {
+std::atomic<uint64_t> hugePageMaps{0};
+std::atomic<uint64_t> hugePageMapFallbacks{0};
+}
+
+namespace facebook { namespace network {
+
+void* mapHugePages(size_t bytes) {
+  DCHECK_EQ(0, bytes % kHugePageSize);
+  void* mem = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (mem != MAP_FAILED) {
+    hugePageMaps.fetch_add(1, std::memory_order_relaxed);
+    return mem;
+  }
+  // The explicit hugepage pool is sized via vm.nr_hugepages and can be
+  // exhausted (or empty on hosts that never configured it). Fall back
+  // to normal pages and let transparent hugepages back the range if
+  // the kernel can assemble them.
+  LOG_FIRST_N(WARNING, 1) << "explicit 2MB hugepage mapping of " << bytes
+    << " bytes failed (" << folly::errnoStr(errno)
+    << "), falling back to normal pages";
+  mem = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED) {
+    PLOG(ERROR) << "failed to map " << bytes << " bytes of fallback memory";
+    return nullptr;
+  }
+#ifdef MADV_HUGEPAGE
+  ::madvise(mem, bytes, MADV_HUGEPAGE);
+#endif
+  hugePageMapFallbacks.fetch_add(1, std::memory_order_relaxed);
+  return mem;
+}
+
+void unmapHugePages(void* ptr, size_t bytes) {
+  if (::munmap(ptr, bytes) != 0) {
+    PLOG(ERROR) << "failed to unmap " << bytes << " byte hugepage range";
+  }
+}
+
+uint64_t numHugePageMaps() {
+  return hugePageMaps.load(std::memory_order_relaxed);
+}
+
+uint64_t numHugePageMapFallbacks() {
+  return hugePageMapFallbacks.load(std::memory_order_relaxed);
+}
+
+}} // facebook::network
@@ -0,0 +1,56 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace facebook { namespace network {
+
+/*
+ * Helpers for backing large, long lived pools with 2MB hugepages.
+ *
+ * A pool that spans hundreds of megabytes touches a new dTLB entry
+ * every 4KB when backed by normal pages; with 2MB pages the same pool
+ * needs 1/512th of the entries, so walks over it (e.g. longest match
+ * lookups across a full route table arena) stop thrashing the TLB.
+ */
+
+// Size of an explicit hugepage on the platforms we deploy on (x86_64)
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+// Round bytes up to the next hugepage boundary
+constexpr size_t roundUpToHugePageSize(size_t bytes) {
+  return (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+}
+
+/*
+ * Map bytes (which must be a multiple of kHugePageSize) of anonymous
+ * memory backed by explicit 2MB hugepages. If the kernel's hugepage
+ * pool is exhausted, or hugepages are unavailable altogether, fall
+ * back to normal anonymous pages with an madvise(MADV_HUGEPAGE) hint
+ * so transparent hugepages may still assemble 2MB mappings behind the
+ * range. Returns nullptr only if even the fallback mapping fails.
+ */
+void* mapHugePages(size_t bytes);
+
+// Unmap a range obtained from mapHugePages()
+void unmapHugePages(void* ptr, size_t bytes);
+
+/*
+ * Number of successful explicit hugepage mappings, and of fallbacks to
+ * normal pages, since process start. Exported as counters so we can
+ * tell in production whether pools that asked for hugepages actually
+ * got them.
+ */
+uint64_t numHugePageMaps();
+uint64_t numHugePageMapFallbacks();
+
+}} // facebook::network
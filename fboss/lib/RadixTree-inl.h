@@ -33,9 +33,10 @@ RadixTreeNode<IPADDRTYPE, T>::searchDirection(const IPADDRTYPE& toSearch,
   return TreeDirection::PARENT;
 }
 
-template<typename IPADDRTYPE, typename T, typename TreeTraits>
-const typename RadixTree<IPADDRTYPE, T, TreeTraits>::TreeNode*
-RadixTree<IPADDRTYPE, T, TreeTraits>::longestMatchImpl(const IPADDRTYPE& ipaddr,
+template<typename IPADDRTYPE, typename T, typename TreeTraits,
+  typename NodeAlloc>
+const typename RadixTree<IPADDRTYPE, T, TreeTraits, NodeAlloc>::TreeNode*
+RadixTree<IPADDRTYPE, T, TreeTraits, NodeAlloc>::longestMatchImpl(const IPADDRTYPE& ipaddr,
     uint8_t masklen, bool& foundExact, bool includeNonValueNodes,
     VecConstIterators* trail) const {
   // Track parent pointer. This is done rather than relying
@@ -90,8 +91,9 @@ RadixTree<IPADDRTYPE, T, TreeTraits>::longestMatchImpl(const IPADDRTYPE& ipaddr,
 }
 
 
-template<typename IPADDRTYPE, typename T, typename TreeTraits>
-inline void  RadixTree<IPADDRTYPE, T, TreeTraits>
+template<typename IPADDRTYPE, typename T, typename TreeTraits,
+  typename NodeAlloc>
+inline void  RadixTree<IPADDRTYPE, T, TreeTraits, NodeAlloc>
 ::trailAppend(VecConstIterators* trail,
     bool includeNonValueNodes, const TreeNode* node) const {
   if (trail) {
@@ -101,10 +103,11 @@ inline void  RadixTree<IPADDRTYPE, T, TreeTraits>
   }
 }
 
-template <typename IPADDRTYPE, typename T, typename TreeTraits>
+template <typename IPADDRTYPE, typename T, typename TreeTraits,
+  typename NodeAlloc>
 template <typename VALUE>
-std::pair<typename RadixTree<IPADDRTYPE, T, TreeTraits>::Iterator, bool>
-RadixTree<IPADDRTYPE, T, TreeTraits>::insert(const IPADDRTYPE& ipaddr,
+std::pair<typename RadixTree<IPADDRTYPE, T, TreeTraits, NodeAlloc>::Iterator, bool>
+RadixTree<IPADDRTYPE, T, TreeTraits, NodeAlloc>::insert(const IPADDRTYPE& ipaddr,
     uint8_t mask, VALUE&& value) {
   auto foundExact = false;
   // Can't trust the clients to have 0s in all bits after mask length
@@ -137,7 +140,7 @@ RadixTree<IPADDRTYPE, T, TreeTraits>::insert(const IPADDRTYPE& ipaddr,
       // specific root.
       auto prefix = IPADDRTYPE::longestCommonPrefix(
         {root_->ipAddress(), root_->masklen()}, {toAdd, mask});
-      std::unique_ptr<TreeNode> newRoot = nullptr;
+      NodePtr newRoot = nullptr;
       if (prefix.first == toAdd && prefix.second == mask) {
         // To be added node is the new root
         newRoot = std::move(newNode);
@@ -206,7 +209,7 @@ RadixTree<IPADDRTYPE, T, TreeTraits>::insert(const IPADDRTYPE& ipaddr,
         // bestMatchChild and new node.
         auto internalNode = makeNode(prefix.first, prefix.second);
         auto internalNodeRaw = internalNode.get();
-        std::unique_ptr<TreeNode> oldBestMatchChild = nullptr;
+        NodePtr oldBestMatchChild = nullptr;
         if (toAddDirection ==  TreeDirection::LEFT) {
           oldBestMatchChild = bestMatch->resetLeft(std::move(internalNode));
         } else {
@@ -225,7 +228,7 @@ RadixTree<IPADDRTYPE, T, TreeTraits>::insert(const IPADDRTYPE& ipaddr,
         CHECK(internalNode == nullptr);
       } else {
         // New node needs to be inserted  b/w bestMatch and bestMatchChild
-        std::unique_ptr<TreeNode> oldBestMatchChild = nullptr;
+        NodePtr oldBestMatchChild = nullptr;
         if (toAddDirection ==  TreeDirection::LEFT) {
           oldBestMatchChild = bestMatch->resetLeft(std::move(newNode));
         } else {
@@ -248,6 +251,123 @@ RadixTree<IPADDRTYPE, T, TreeTraits>::insert(const IPADDRTYPE& ipaddr,
   return std::make_pair(traits_.makeItr(newNodeRaw), true);
 }
 
+/*
+ * Bottom up build from sorted entries. Since entries are sorted by
+ * (ip, masklen), a prefix always appears after all its ancestors and
+ * after everything under its left sibling subtrees. This means the
+ * attachment point for every new prefix lies on the path from the root
+ * to the most recently attached node, which we keep on a stack (the
+ * "spine"). Each entry then costs amortized O(1) stack work instead of
+ * insert's root to leaf traversal.
+ */
+template<typename IPADDRTYPE, typename T, typename TreeTraits,
+  typename NodeAlloc>
+void RadixTree<IPADDRTYPE, T, TreeTraits, NodeAlloc>::bulkBuild(
+    std::vector<BulkEntry>& entries) {
+  CHECK(root_ == nullptr);
+  CHECK_EQ(0, size_);
+  DCHECK(std::is_sorted(entries.begin(), entries.end(),
+        [](const BulkEntry& a, const BulkEntry& b) {
+          return a.ip < b.ip || (a.ip == b.ip && a.masklen < b.masklen);
+        }));
+  // Path from the root to the most recently attached node. Masklens
+  // strictly increase along any root to leaf path, bounding its depth.
+  std::vector<TreeNode*> spine;
+  spine.reserve(IPADDRTYPE::bitCount() + 1);
+  for (auto& entry : entries) {
+    // Can't trust the clients to have 0s in all bits after mask length
+    auto toAdd = entry.ip.mask(entry.masklen);
+    auto masklen = entry.masklen;
+    // Pop the spine until the top is an ancestor of the new prefix.
+    // The last node popped (if any) is the top's child on the side
+    // the new prefix goes.
+    TreeNode* popped = nullptr;
+    while (!spine.empty()) {
+      auto candidate = spine.back();
+      if (candidate->masklen() <= masklen &&
+          toAdd.mask(candidate->masklen()) == candidate->ipAddress()) {
+        break;
+      }
+      popped = candidate;
+      spine.pop_back();
+    }
+    auto top = spine.empty() ? nullptr : spine.back();
+    if (top && top->masklen() == masklen) {
+      // Duplicate prefix, first value wins as with repeated inserts
+      continue;
+    }
+    auto newNode = makeNode(toAdd, masklen, std::move(entry.value));
+    auto newNodeRaw = newNode.get();
+    if (!top) {
+      if (!popped) {
+        // Very first entry
+        makeRoot(std::move(newNode));
+      } else {
+        // New prefix does not descend from the current root, join the
+        // two under their longest common prefix
+        CHECK_EQ(popped, root_.get());
+        auto prefix = IPADDRTYPE::longestCommonPrefix(
+            {popped->ipAddress(), popped->masklen()}, {toAdd, masklen});
+        // Sorted order puts ancestors first, so the new prefix can't
+        // be an ancestor of the old root; the join node is a proper
+        // ancestor of both
+        auto join = makeNode(prefix.first, prefix.second);
+        auto joinRaw = join.get();
+        auto oldRoot = std::move(root_);
+        if (join->searchDirection(oldRoot.get()) == TreeDirection::LEFT) {
+          join->resetLeft(std::move(oldRoot));
+          join->resetRight(std::move(newNode));
+        } else {
+          join->resetRight(std::move(oldRoot));
+          join->resetLeft(std::move(newNode));
+        }
+        makeRoot(std::move(join));
+        spine.push_back(joinRaw);
+      }
+    } else {
+      auto direction = top->searchDirection(toAdd, masklen);
+      CHECK(direction == TreeDirection::LEFT ||
+          direction == TreeDirection::RIGHT);
+      auto sibling = direction == TreeDirection::LEFT ? top->left() :
+        top->right();
+      if (!sibling) {
+        // Free slot, attach directly
+        if (direction == TreeDirection::LEFT) {
+          top->resetLeft(std::move(newNode));
+        } else {
+          top->resetRight(std::move(newNode));
+        }
+      } else {
+        // The occupied slot must hold the node we just popped; join it
+        // and the new prefix under their longest common prefix, which
+        // is a proper descendant of top and proper ancestor of both
+        CHECK_EQ(sibling, popped);
+        auto prefix = IPADDRTYPE::longestCommonPrefix(
+            {sibling->ipAddress(), sibling->masklen()}, {toAdd, masklen});
+        auto join = makeNode(prefix.first, prefix.second);
+        auto joinRaw = join.get();
+        auto detached = direction == TreeDirection::LEFT ?
+          top->resetLeft(nullptr) : top->resetRight(nullptr);
+        if (join->searchDirection(detached.get()) == TreeDirection::LEFT) {
+          join->resetLeft(std::move(detached));
+          join->resetRight(std::move(newNode));
+        } else {
+          join->resetRight(std::move(detached));
+          join->resetLeft(std::move(newNode));
+        }
+        if (direction == TreeDirection::LEFT) {
+          top->resetLeft(std::move(join));
+        } else {
+          top->resetRight(std::move(join));
+        }
+        spine.push_back(joinRaw);
+      }
+    }
+    spine.push_back(newNodeRaw);
+    ++size_;
+  }
+}
+
 /*
  * One condition that must be true before and after erase
  * is that all non value nodes should have 2 children. Assuming
@@ -259,8 +379,9 @@ RadixTree<IPADDRTYPE, T, TreeTraits>::insert(const IPADDRTYPE& ipaddr,
  * as well. Why this is true is explained below for each of the
  * different cases of erase.
  */
-template<typename IPADDRTYPE, typename T, typename TreeTraits>
-bool RadixTree<IPADDRTYPE, T, TreeTraits>::erase(TreeNode* toDelete) {
+template<typename IPADDRTYPE, typename T, typename TreeTraits,
+  typename NodeAlloc>
+bool RadixTree<IPADDRTYPE, T, TreeTraits, NodeAlloc>::erase(TreeNode* toDelete) {
   if (!toDelete) {
     return false;
   }
@@ -372,8 +493,9 @@ bool RadixTree<IPADDRTYPE, T, TreeTraits>::erase(TreeNode* toDelete) {
 }
 
 
-template<typename IPADDRTYPE, typename T, typename TreeTraits>
-bool RadixTree<IPADDRTYPE, T, TreeTraits>::radixSubTreesEqual(
+template<typename IPADDRTYPE, typename T, typename TreeTraits,
+  typename NodeAlloc>
+bool RadixTree<IPADDRTYPE, T, TreeTraits, NodeAlloc>::radixSubTreesEqual(
     const TreeNode* nodeA, const TreeNode* nodeB) {
   if (nodeA && nodeB) {
     if (nodeA->equalSansLinks(*nodeB)) {
@@ -387,19 +509,18 @@ bool RadixTree<IPADDRTYPE, T, TreeTraits>::radixSubTreesEqual(
 }
 
 
-template<typename IPADDRTYPE, typename T, typename TreeTraits>
-std::unique_ptr<typename RadixTree<IPADDRTYPE, T, TreeTraits>::TreeNode>
-RadixTree<IPADDRTYPE, T, TreeTraits>::cloneSubTree(const TreeNode* node) {
+template<typename IPADDRTYPE, typename T, typename TreeTraits,
+  typename NodeAlloc>
+typename RadixTree<IPADDRTYPE, T, TreeTraits, NodeAlloc>::NodePtr
+RadixTree<IPADDRTYPE, T, TreeTraits, NodeAlloc>::cloneSubTree(const TreeNode* node) {
   if (!node) {
     return nullptr;
   }
-  std::unique_ptr<TreeNode> copy;
+  NodePtr copy;
   if (node->isValueNode()) {
-    copy = std::make_unique<TreeNode>(node->ipAddress(),
-      node->masklen(), node->value(), node->nodeDeleteCallback());
+    copy = makeNode(node->ipAddress(), node->masklen(), node->value());
   } else {
-    copy = std::make_unique<TreeNode>(node->ipAddress(),
-      node->masklen(), node->nodeDeleteCallback());
+    copy = makeNode(node->ipAddress(), node->masklen());
   }
   copy->resetLeft(cloneSubTree(node->left()));
   copy->resetRight(cloneSubTree(node->right()));
@@ -9,6 +9,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include <folly/Conv.h>
@@ -18,7 +19,120 @@
 #include <folly/IPAddressV4.h>
 #include <folly/IPAddressV6.h>
 
+#include "fboss/lib/HugePages.h"
+
 namespace facebook { namespace network {
+
+/*
+ * Slab arena for radix tree nodes. Nodes are placement constructed in
+ * contiguous slabs rather than individually heap allocated, which keeps
+ * them close together in memory and makes longest match walks over big
+ * trees considerably more cache friendly. Freed slots are recycled via a
+ * free list.
+ * With useHugePages set, slabs are mapped from 2MB hugepages (falling
+ * back to normal pages when the hugepage pool is empty), so a big
+ * tree's worth of nodes also stops thrashing the dTLB; see HugePages.h.
+ * Note: the arena is not thread safe, it is meant for trees which are
+ * built and destroyed on a single thread.
+ */
+template<typename NodeT>
+class RadixTreeNodeArena {
+ public:
+  explicit RadixTreeNodeArena(uint32_t nodesPerSlab = kDefaultNodesPerSlab,
+                              bool useHugePages = false):
+    nodesPerSlab_(nodesPerSlab), useHugePages_(useHugePages) {}
+
+  ~RadixTreeNodeArena() {
+    for (const auto& slab : slabs_) {
+      if (slab.mappedBytes) {
+        unmapHugePages(slab.slots, slab.mappedBytes);
+      } else {
+        delete[] slab.slots;
+      }
+    }
+  }
+
+  RadixTreeNodeArena(const RadixTreeNodeArena&) = delete;
+  RadixTreeNodeArena& operator=(const RadixTreeNodeArena&) = delete;
+
+  // Get a raw slot of node size, adding a slab if we ran out
+  void* allocate() {
+    if (freeList_.empty()) {
+      addSlab();
+    }
+    auto mem = freeList_.back();
+    freeList_.pop_back();
+    return mem;
+  }
+
+  // Return a (already destructed) node's slot to the free list
+  void recycle(NodeT* node) {
+    freeList_.push_back(node);
+  }
+
+  size_t numSlabs() const { return slabs_.size(); }
+
+ private:
+  enum : uint32_t { kDefaultNodesPerSlab = 1024 };
+  typedef typename std::aligned_storage<sizeof(NodeT), alignof(NodeT)>::type
+    Slot;
+
+  struct Slab {
+    Slot* slots{nullptr};
+    // Bytes mapped via mapHugePages(), or 0 for a heap allocated slab
+    size_t mappedBytes{0};
+  };
+
+  void addSlab() {
+    Slab slab;
+    size_t numSlots = nodesPerSlab_;
+    if (useHugePages_) {
+      // Round the slab up to whole hugepages and carve slots out of
+      // the entire mapping, so none of the mapped memory is wasted.
+      auto bytes = roundUpToHugePageSize(numSlots * sizeof(Slot));
+      slab.slots = static_cast<Slot*>(mapHugePages(bytes));
+      if (slab.slots) {
+        slab.mappedBytes = bytes;
+        numSlots = bytes / sizeof(Slot);
+      }
+    }
+    if (!slab.slots) {
+      slab.slots = new Slot[numSlots];
+    }
+    slabs_.push_back(slab);
+    freeList_.reserve(freeList_.size() + numSlots);
+    for (size_t i = 0; i < numSlots; ++i) {
+      freeList_.push_back(&slab.slots[i]);
+    }
+  }
+
+  uint32_t nodesPerSlab_;
+  bool useHugePages_;
+  std::vector<Slab> slabs_;
+  std::vector<void*> freeList_;
+};
+
+/*
+ * Deleter for radix tree nodes. Nodes carved out of an arena are
+ * destructed in place and their slot returned to the arena; nodes
+ * without an arena are individually heap allocated and freed with
+ * delete. Holding the arena via shared_ptr keeps it alive for as long
+ * as any node allocated from it, even if the tree that created the
+ * arena has been moved from or destroyed.
+ */
+template<typename NodeT>
+struct RadixTreeNodeDeleter {
+  void operator()(NodeT* node) const {
+    if (arena) {
+      node->~NodeT();
+      arena->recycle(node);
+    } else {
+      delete node;
+    }
+  }
+  std::shared_ptr<RadixTreeNodeArena<NodeT>> arena{nullptr};
+};
+
 /*
  * Node in RadixTree, holds IP, mask. Will hold  value for nodes
  * created as a result of user inserts. Other type of nodes are
@@ -32,6 +146,10 @@ class RadixTreeNode {
   // Optional function parameter to call from destructor
   typedef std::function<void(const RadixTreeNode<IPADDRTYPE, T>&)>
     NodeDeleteCallback;
+  // Owning pointer for tree nodes. The deleter knows whether the node
+  // came from an arena or from the heap.
+  typedef std::unique_ptr<RadixTreeNode, RadixTreeNodeDeleter<RadixTreeNode>>
+    UniquePtr;
 
   RadixTreeNode(const IPADDRTYPE& ipAddr, uint8_t mlen,
       NodeDeleteCallback deleteCallback):
@@ -90,8 +208,7 @@ class RadixTreeNode {
           this->value() == r.value());
   }
 
-  std::unique_ptr<RadixTreeNode>
-    resetLeft(std::unique_ptr<RadixTreeNode> newLeft) {
+  UniquePtr resetLeft(UniquePtr newLeft) {
     auto old = std::move(left_);
     left_ = std::move(newLeft);
     if (left_) {
@@ -100,8 +217,7 @@ class RadixTreeNode {
     return old;
   }
 
-  std::unique_ptr<RadixTreeNode>
-    resetRight(std::unique_ptr<RadixTreeNode> newRight) {
+  UniquePtr resetRight(UniquePtr newRight) {
     auto old = std::move(right_);
     right_ = std::move(newRight);
     if (right_) {
@@ -126,8 +242,8 @@ class RadixTreeNode {
   IPADDRTYPE ipAddress_;
   uint32_t masklen_{0}; // Number of bits to match.
   folly::Optional<T> value_;
-  std::unique_ptr<RadixTreeNode> left_{nullptr};
-  std::unique_ptr<RadixTreeNode> right_{nullptr};
+  UniquePtr left_{nullptr};
+  UniquePtr right_{nullptr};
   RadixTreeNode* parent_{nullptr};
   NodeDeleteCallback deleteCallback_;
 };
@@ -337,11 +453,61 @@ struct RadixTreeTraits {
   }
 };
 
+/*
+ * Default node allocator: each node is individually heap allocated.
+ */
+template<typename NodeT>
+struct RadixTreeNodeHeapAllocator {
+  typedef typename NodeT::UniquePtr NodePtr;
+
+  template<typename... Args>
+  NodePtr makeNode(Args&&... args) {
+    return NodePtr(new NodeT(std::forward<Args>(args)...),
+        RadixTreeNodeDeleter<NodeT>());
+  }
+};
+
+/*
+ * Arena backed node allocator: nodes are placement constructed in the
+ * contiguous slabs of a RadixTreeNodeArena, so a big tree's nodes stay
+ * packed together rather than scattered across the heap. See the arena's
+ * comments for the (single threaded) usage restrictions.
+ */
+template<typename NodeT>
+struct RadixTreeNodeArenaAllocator {
+  typedef typename NodeT::UniquePtr NodePtr;
+
+  RadixTreeNodeArenaAllocator()
+    : RadixTreeNodeArenaAllocator(
+        std::make_shared<RadixTreeNodeArena<NodeT>>()) {}
+
+  // Allocate from a caller supplied arena, e.g. one with hugepage
+  // backed slabs
+  explicit RadixTreeNodeArenaAllocator(
+      std::shared_ptr<RadixTreeNodeArena<NodeT>> arena)
+    : arena_(std::move(arena)) {}
+
+  template<typename... Args>
+  NodePtr makeNode(Args&&... args) {
+    auto node = new (arena_->allocate()) NodeT(std::forward<Args>(args)...);
+    return NodePtr(node, RadixTreeNodeDeleter<NodeT>{arena_});
+  }
+
+  const std::shared_ptr<RadixTreeNodeArena<NodeT>>& arena() const {
+    return arena_;
+  }
+
+ private:
+  std::shared_ptr<RadixTreeNodeArena<NodeT>> arena_;
+};
+
 template<typename IPADDRTYPE, typename T,
-  typename TreeTraits = RadixTreeTraits<IPADDRTYPE, T>>
+  typename TreeTraits = RadixTreeTraits<IPADDRTYPE, T>,
+  typename NodeAlloc = RadixTreeNodeHeapAllocator<RadixTreeNode<IPADDRTYPE, T>>>
 class RadixTree {
  public:
   typedef RadixTreeNode<IPADDRTYPE, T>           TreeNode;
+  typedef typename TreeNode::UniquePtr           NodePtr;
   typedef typename TreeNode::TreeDirection       TreeDirection;
   typedef typename TreeNode::NodeDeleteCallback  NodeDeleteCallback;
   typedef typename TreeTraits::Iterator          Iterator;
@@ -350,8 +516,10 @@ class RadixTree {
 
   explicit RadixTree(NodeDeleteCallback nodeDelCallback =
       NodeDeleteCallback(),
-      const TreeTraits& treeTraits = TreeTraits()):
-    nodeDeleteCallback_(nodeDelCallback), traits_(treeTraits) {}
+      const TreeTraits& treeTraits = TreeTraits(),
+      NodeAlloc nodeAlloc = NodeAlloc()):
+    nodeDeleteCallback_(nodeDelCallback), traits_(treeTraits),
+    alloc_(std::move(nodeAlloc)) {}
 
   RadixTree(const RadixTree& r) = delete;
   RadixTree& operator=(const RadixTree& r) = delete;
@@ -368,13 +536,15 @@ class RadixTree {
   }
   RadixTree(RadixTree&& r) noexcept
    : nodeDeleteCallback_(r.nodeDeleteCallback_),
-  traits_(r.traits_) {
+  traits_(r.traits_), alloc_(r.alloc_) {
     *this = std::move(r);
   }
   // Move radix tree onto this
   RadixTree& operator=(RadixTree&& r) noexcept {
-    // Don't copy the traits and delete callback, use
-    // ones with which this Radix tree was created
+    // Don't copy the traits, delete callback and allocator, use
+    // ones with which this Radix tree was created. Nodes moved over
+    // from r carry their own deleters, so they are freed correctly
+    // even if r used a different allocator
     size_ = r.size_;
     makeRoot(std::move(r.root_));
     r.size_ = 0;
@@ -386,9 +556,11 @@ class RadixTree {
     clone() const {
     static_assert(std::is_same<T, U>::value,
         "clone template type must be the same as Radix tree value type");
+    // Note the copy gets a fresh allocator (and thus its own arena when
+    // one is in use), so the cloned nodes are packed independently of ours
     RadixTree copy(nodeDeleteCallback_, traits_);
     copy.size_ = size_;
-    copy.root_ = cloneSubTree(root_.get());
+    copy.root_ = copy.cloneSubTree(root_.get());
     return copy;
   }
   /*
@@ -403,6 +575,25 @@ class RadixTree {
   std::pair<Iterator, bool>  insert(const IPADDRTYPE& ipaddr,
       uint8_t masklen, VALUE&& value);
 
+  // Prefix, value entry for bulkBuild
+  struct BulkEntry {
+    IPADDRTYPE ip;
+    uint8_t masklen;
+    T value;
+  };
+
+  /*
+   * Build the tree bottom up from entries sorted by (ip, masklen).
+   * Where insert pays a root to leaf traversal per prefix, bulkBuild
+   * makes a single pass over the sorted entries, keeping the path to
+   * the most recently attached node on a stack. Each node is pushed
+   * and popped at most once, so building a full FIB worth of prefixes
+   * is linear in the number of entries. The tree must be empty; values
+   * are moved out of the passed in entries. Duplicate prefixes keep
+   * the first value, same as repeated inserts would.
+   */
+  void bulkBuild(std::vector<BulkEntry>& entries);
+
   // Erase a IP, mask
   bool erase(const IPADDRTYPE& ipaddr, uint8_t masklen) {
     return erase(exactMatch(ipaddr, masklen));
@@ -528,8 +719,9 @@ class RadixTree {
   TreeNode* root() { return root_.get();  }
   NodeDeleteCallback nodeDeleteCallback() const { return nodeDeleteCallback_; }
   const TreeTraits&  traits() const { return traits_; }
+  const NodeAlloc&   nodeAllocator() const { return alloc_; }
  private:
-  static std::unique_ptr<TreeNode> cloneSubTree(const TreeNode* node);
+  NodePtr cloneSubTree(const TreeNode* node);
   // Worker function to do the actual longest match lookup.
   const TreeNode* longestMatchImpl(const IPADDRTYPE& ipaddr,
       uint8_t masklen, bool& foundExact, bool includeNonValueNodes = false,
@@ -544,20 +736,20 @@ class RadixTree {
             masklen, foundExact, includeNonValueNodes, trail));
   }
 
-  std::unique_ptr<TreeNode> makeNode(const IPADDRTYPE& ip,
+  NodePtr makeNode(const IPADDRTYPE& ip,
       uint8_t masklen) {
-    return std::make_unique<TreeNode>(ip, masklen, nodeDeleteCallback_);
+    return alloc_.makeNode(ip, masklen, nodeDeleteCallback_);
   }
 
   template<typename VALUE>
-  std::unique_ptr<TreeNode> makeNode(const IPADDRTYPE& ip,
+  NodePtr makeNode(const IPADDRTYPE& ip,
       uint8_t masklen, VALUE&& value) {
-    return std::make_unique<TreeNode>(ip, masklen,
-                                        std::forward<VALUE>(value),
-                                        nodeDeleteCallback_);
+    return alloc_.makeNode(ip, masklen,
+                           std::forward<VALUE>(value),
+                           nodeDeleteCallback_);
   }
 
-  void makeRoot(std::unique_ptr<TreeNode> newRoot) {
+  void makeRoot(NodePtr newRoot) {
     CHECK(root_ != newRoot || root_ == nullptr);
     if (newRoot) {
         newRoot->setParent(nullptr);
@@ -568,10 +760,11 @@ class RadixTree {
   inline void trailAppend(VecConstIterators* trail,
   bool includeNonValueNodes, const TreeNode* node) const;
 
-  std::unique_ptr<TreeNode> root_{nullptr};
+  NodePtr root_{nullptr};
   size_t  size_{0};
   NodeDeleteCallback nodeDeleteCallback_;
   TreeTraits  traits_;
+  NodeAlloc  alloc_;
 };
 
 
@@ -866,7 +1059,8 @@ struct V4TreeInCompositeTreeTraits {
 
 // Template specialization for RadixTree of folly::IPAddress
 template<typename T>
-class RadixTree<folly::IPAddress, T> {
+class RadixTree<folly::IPAddress, T, RadixTreeTraits<folly::IPAddress, T>,
+      RadixTreeNodeHeapAllocator<RadixTreeNode<folly::IPAddress, T>>> {
  public:
   typedef RadixTreeNode<folly::IPAddressV4, T>  TreeNode4;
   typedef RadixTreeNode<folly::IPAddressV6, T>  TreeNode6;
@@ -948,6 +1142,39 @@ class RadixTree<folly::IPAddress, T> {
     return ipv6Tree_.insert(ipaddr.asV6(), masklen, std::forward<VALUE>(value));
   }
 
+  // Prefix, value entry for bulkBuild
+  struct BulkEntry {
+    folly::IPAddress ip;
+    uint8_t masklen;
+    T value;
+  };
+
+  /*
+   * Bulk build counterpart for the composite tree. Entries must be
+   * sorted by (ip, masklen) within each address family; the two
+   * families are split out and handed to the per family trees. See
+   * the per family bulkBuild for the requirements and semantics.
+   */
+  void bulkBuild(std::vector<BulkEntry>& entries) {
+    typedef typename RadixTree<folly::IPAddressV4, T,
+      V4TreeInCompositeTreeTraits<T>>::BulkEntry BulkEntry4;
+    typedef typename RadixTree<folly::IPAddressV6, T,
+      V6TreeInCompositeTreeTraits<T>>::BulkEntry BulkEntry6;
+    std::vector<BulkEntry4> entries4;
+    std::vector<BulkEntry6> entries6;
+    for (auto& entry : entries) {
+      if (entry.ip.isV4()) {
+        entries4.push_back(BulkEntry4{entry.ip.asV4(), entry.masklen,
+            std::move(entry.value)});
+      } else {
+        entries6.push_back(BulkEntry6{entry.ip.asV6(), entry.masklen,
+            std::move(entry.value)});
+      }
+    }
+    ipv4Tree_.bulkBuild(entries4);
+    ipv6Tree_.bulkBuild(entries6);
+  }
+
   // Erase a IP, mask
   bool erase(const folly::IPAddress& ipaddr, uint8_t masklen) {
     if (ipaddr.isV4()) {
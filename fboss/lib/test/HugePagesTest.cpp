@@ -0,0 +1,59 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <cstring>
+#include <gtest/gtest.h>
+
+#include "fboss/lib/HugePages.h"
+#include "fboss/lib/RadixTree.h"
+
+using namespace facebook::network;
+
+TEST(HugePages, RoundUpToHugePageSize) {
+  EXPECT_EQ(kHugePageSize, roundUpToHugePageSize(1));
+  EXPECT_EQ(kHugePageSize, roundUpToHugePageSize(kHugePageSize));
+  EXPECT_EQ(2 * kHugePageSize, roundUpToHugePageSize(kHugePageSize + 1));
+}
+
+TEST(HugePages, MapIsWritable) {
+  auto mapsBefore = numHugePageMaps();
+  auto fallbacksBefore = numHugePageMapFallbacks();
+  auto bytes = kHugePageSize;
+  void* mem = mapHugePages(bytes);
+  // Whether we got explicit hugepages depends on the host's
+  // vm.nr_hugepages setting; either way the mapping must be usable and
+  // exactly one of the counters must have advanced.
+  ASSERT_NE(nullptr, mem);
+  memset(mem, 0xa5, bytes);
+  EXPECT_EQ(1, (numHugePageMaps() - mapsBefore) +
+               (numHugePageMapFallbacks() - fallbacksBefore));
+  unmapHugePages(mem, bytes);
+}
+
+TEST(HugePages, ArenaBackedByHugePages) {
+  struct Node {
+    uint64_t payload[4];
+  };
+  // More nodes than fit in one hugepage worth of slab
+  constexpr uint32_t kNodes = 3 *
+    (kHugePageSize / sizeof(Node)) / 2;
+  RadixTreeNodeArena<Node> arena(kNodes, true /* useHugePages */);
+  std::vector<Node*> nodes;
+  for (uint32_t i = 0; i < kNodes; ++i) {
+    auto* node = new (arena.allocate()) Node();
+    node->payload[0] = i;
+    nodes.push_back(node);
+  }
+  for (uint32_t i = 0; i < kNodes; ++i) {
+    EXPECT_EQ(i, nodes[i]->payload[0]);
+  }
+  for (auto* node : nodes) {
+    node->~Node();
+    arena.recycle(node);
+  }
+  // Recycled slots must be reused rather than growing the arena
+  auto slabs = arena.numSlabs();
+  auto* node = new (arena.allocate()) Node();
+  EXPECT_EQ(slabs, arena.numSlabs());
+  node->~Node();
+  arena.recycle(node);
+}
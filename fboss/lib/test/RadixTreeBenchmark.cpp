@@ -21,6 +21,8 @@ DEFINE_int32(erase_count, 1000,
              "The number of elements to erase on each erase iteration");
 DEFINE_int32(lookup_count, 5000,
              "The number of elements to look up on each lookup iteration");
+DEFINE_int32(fib_size, 600000,
+             "The number of prefixes in the FIB scale datasets");
 namespace {
 set<Prefix4> insertSet4;
 set<Prefix4> eraseSet4;
@@ -191,6 +193,98 @@ BENCHMARK_RELATIVE(RadixTreeLongestMatch6) {
   }
 }
 
+/*
+ * FIB scale benchmarks. These use FLAGS_fib_size prefixes, the size of
+ * a full FIB our syncFib path builds trees from at startup. The entry
+ * vectors are sorted by (ip, masklen) so the same dataset drives both
+ * the per prefix insert path and bulkBuild. Lookup and iteration
+ * benchmarks run against a tree built once in main(); their loops are
+ * per operation, so the reported time is directly time per
+ * longestMatch / per visited node.
+ */
+vector<RadixTree<IPAddressV4, int>::BulkEntry> fibEntries4;
+vector<RadixTree<IPAddressV6, int>::BulkEntry> fibEntries6;
+vector<IPAddressV4> fibLookups4;
+vector<IPAddressV6> fibLookups6;
+RadixTree<IPAddressV4, int> fibTree4;
+RadixTree<IPAddressV6, int> fibTree6;
+
+BENCHMARK(RadixTreeFibInsert4) {
+  RadixTree<IPAddressV4, int> rtree;
+  for (auto const& entry: fibEntries4) {
+    rtree.insert(entry.ip, entry.masklen, entry.value);
+  }
+  folly::doNotOptimizeAway(rtree.size());
+}
+
+BENCHMARK_RELATIVE(RadixTreeFibBulkBuild4) {
+  RadixTree<IPAddressV4, int> rtree;
+  auto entries = fibEntries4;
+  rtree.bulkBuild(entries);
+  folly::doNotOptimizeAway(rtree.size());
+}
+
+BENCHMARK(RadixTreeFibLongestMatch4, numIters) {
+  size_t idx = 0;
+  for (size_t n = 0; n < numIters; ++n) {
+    folly::doNotOptimizeAway(fibTree4.longestMatch(fibLookups4[idx], 32)
+        .node());
+    if (++idx == fibLookups4.size()) {
+      idx = 0;
+    }
+  }
+}
+
+BENCHMARK(RadixTreeFibIteration4, numIters) {
+  size_t visited = 0;
+  while (visited < numIters) {
+    for (auto itr = fibTree4.begin(); itr != fibTree4.end(); ++itr) {
+      folly::doNotOptimizeAway(itr.value());
+      if (++visited == numIters) {
+        break;
+      }
+    }
+  }
+}
+
+BENCHMARK(RadixTreeFibInsert6) {
+  RadixTree<IPAddressV6, int> rtree;
+  for (auto const& entry: fibEntries6) {
+    rtree.insert(entry.ip, entry.masklen, entry.value);
+  }
+  folly::doNotOptimizeAway(rtree.size());
+}
+
+BENCHMARK_RELATIVE(RadixTreeFibBulkBuild6) {
+  RadixTree<IPAddressV6, int> rtree;
+  auto entries = fibEntries6;
+  rtree.bulkBuild(entries);
+  folly::doNotOptimizeAway(rtree.size());
+}
+
+BENCHMARK(RadixTreeFibLongestMatch6, numIters) {
+  size_t idx = 0;
+  for (size_t n = 0; n < numIters; ++n) {
+    folly::doNotOptimizeAway(fibTree6.longestMatch(fibLookups6[idx], 128)
+        .node());
+    if (++idx == fibLookups6.size()) {
+      idx = 0;
+    }
+  }
+}
+
+BENCHMARK(RadixTreeFibIteration6, numIters) {
+  size_t visited = 0;
+  while (visited < numIters) {
+    for (auto itr = fibTree6.begin(); itr != fibTree6.end(); ++itr) {
+      folly::doNotOptimizeAway(itr.value());
+      if (++visited == numIters) {
+        break;
+      }
+    }
+  }
+}
+
 }
 
 int main (int argc, char *argv[]) {
@@ -246,6 +340,55 @@ int main (int argc, char *argv[]) {
     auto newIp = pfx.ip.mask(newMask);
     longestMatchSet6.insert(Prefix6(newIp, newMask));
   }
+
+  // FIB scale datasets, sorted by (ip, masklen) as bulkBuild requires
+  set<Prefix4> fibSeen4;
+  while (fibSeen4.size() < FLAGS_fib_size) {
+    auto mask = 8 + folly::Random::rand32(25); // /8 through /32
+    auto ip = IPAddressV4::fromLongHBO(folly::Random::rand32()).mask(mask);
+    if (fibSeen4.insert(Prefix4(ip, mask)).second) {
+      fibEntries4.push_back({ip, static_cast<uint8_t>(mask),
+          static_cast<int>(ip.toLong())});
+    }
+  }
+  sort(fibEntries4.begin(), fibEntries4.end(),
+      [](const RadixTree<IPAddressV4, int>::BulkEntry& a,
+         const RadixTree<IPAddressV4, int>::BulkEntry& b) {
+        return a.ip < b.ip || (a.ip == b.ip && a.masklen < b.masklen);
+      });
+  set<Prefix6> fibSeen6;
+  while (fibSeen6.size() < FLAGS_fib_size) {
+    auto mask = 16 + folly::Random::rand32(113); // /16 through /128
+    ByteArray16 ba;
+    *(uint64_t*)(&ba[0]) = folly::Random::rand64();
+    *(uint64_t*)(&ba[8]) = folly::Random::rand64();
+    auto ip = IPAddressV6(ba).mask(mask);
+    if (fibSeen6.insert(Prefix6(ip, mask)).second) {
+      fibEntries6.push_back({ip, static_cast<uint8_t>(mask),
+          static_cast<int>(fibSeen6.size())});
+    }
+  }
+  sort(fibEntries6.begin(), fibEntries6.end(),
+      [](const RadixTree<IPAddressV6, int>::BulkEntry& a,
+         const RadixTree<IPAddressV6, int>::BulkEntry& b) {
+        return a.ip < b.ip || (a.ip == b.ip && a.masklen < b.masklen);
+      });
+  for (auto i = 0; i < FLAGS_lookup_count; ++i) {
+    fibLookups4.push_back(
+        IPAddressV4::fromLongHBO(folly::Random::rand32()));
+    ByteArray16 ba;
+    *(uint64_t*)(&ba[0]) = folly::Random::rand64();
+    *(uint64_t*)(&ba[8]) = folly::Random::rand64();
+    fibLookups6.push_back(IPAddressV6(ba));
+  }
+  // Trees the FIB lookup and iteration benchmarks run against
+  {
+    auto entries4 = fibEntries4;
+    fibTree4.bulkBuild(entries4);
+    auto entries6 = fibEntries6;
+    fibTree6.bulkBuild(entries6);
+  }
+
   runBenchmarks();
 }
 
@@ -1302,6 +1302,133 @@ TEST(RadixTree, Clone) {
   EXPECT_TRUE(v6Tree == v6TreeCopy);
   EXPECT_TRUE(ipTree == ipTreeCopy);
 }
+
+/*
+ * Arena backed tree should behave identically to the default heap
+ * allocated one, with all nodes carved out of the arena's slabs.
+ */
+TEST(RadixTree, ArenaAllocator) {
+  typedef RadixTreeNode<IPAddressV4, int> TreeNode4;
+  RadixTree<IPAddressV4, int, RadixTreeTraits<IPAddressV4, int>,
+    RadixTreeNodeArenaAllocator<TreeNode4>> arenaTree;
+  RadixTree<IPAddressV4, int> heapTree;
+
+  vector<pair<IPAddressV4, uint8_t>> inserted;
+  set<Prefix4> prefixesSeen;
+  auto const kInsertCount = 2000;
+  for (auto i = 0; i < kInsertCount; ) {
+    auto mask = folly::Random::rand32(32);
+    auto ip = IPAddressV4::fromLongHBO(folly::Random::rand32()).mask(mask);
+    if (prefixesSeen.find(Prefix4(ip, mask)) != prefixesSeen.end()) {
+      continue;
+    }
+    prefixesSeen.insert(Prefix4(ip, mask));
+    ++i;
+    arenaTree.insert(ip, mask, i);
+    heapTree.insert(ip, mask, i);
+    inserted.emplace_back(ip, mask);
+  }
+  EXPECT_EQ(kInsertCount, arenaTree.size());
+  // Node type is independent of the allocator, so the subtree comparison
+  // works across the two tree types
+  EXPECT_TRUE((RadixTree<IPAddressV4, int>::radixSubTreesEqual(
+      arenaTree.root(), heapTree.root())));
+  // More nodes were created than fit in a single slab
+  EXPECT_GT(arenaTree.nodeAllocator().arena()->numSlabs(), 1);
+
+  // Erase some prefixes, slots get recycled via the arena free list
+  auto const kEraseCount = 500;
+  for (auto i = 0; i < kEraseCount;) {
+    auto erase = folly::Random::rand32(inserted.size());
+    if (arenaTree.exactMatch(inserted[erase].first, inserted[erase].second)
+        != arenaTree.end()) {
+      arenaTree.erase(inserted[erase].first, inserted[erase].second);
+      heapTree.erase(inserted[erase].first, inserted[erase].second);
+      ++i;
+    }
+  }
+  EXPECT_EQ(kInsertCount - kEraseCount, arenaTree.size());
+  EXPECT_TRUE((RadixTree<IPAddressV4, int>::radixSubTreesEqual(
+      arenaTree.root(), heapTree.root())));
+}
+
+/*
+ * The Patricia structure over a set of prefixes is canonical (value
+ * nodes plus the join nodes where two branches diverge), so a tree
+ * bulk built from sorted entries must be identical to one built by
+ * repeated inserts of the same prefixes in any order.
+ */
+TEST(RadixTree, BulkBuild4) {
+  RadixTree<IPAddressV4, int> insertTree;
+  set<Prefix4> prefixesSeen;
+  vector<RadixTree<IPAddressV4, int>::BulkEntry> entries;
+  auto const kInsertCount = 2000;
+  for (auto i = 0; i < kInsertCount; ) {
+    auto mask = folly::Random::rand32(32);
+    auto ip = IPAddressV4::fromLongHBO(folly::Random::rand32()).mask(mask);
+    if (prefixesSeen.find(Prefix4(ip, mask)) != prefixesSeen.end()) {
+      continue;
+    }
+    prefixesSeen.insert(Prefix4(ip, mask));
+    ++i;
+    insertTree.insert(ip, mask, i);
+    entries.push_back({ip, static_cast<uint8_t>(mask), i});
+  }
+  sort(entries.begin(), entries.end(),
+      [](const RadixTree<IPAddressV4, int>::BulkEntry& a,
+         const RadixTree<IPAddressV4, int>::BulkEntry& b) {
+        return a.ip < b.ip || (a.ip == b.ip && a.masklen < b.masklen);
+      });
+
+  RadixTree<IPAddressV4, int> bulkTree;
+  bulkTree.bulkBuild(entries);
+  EXPECT_EQ(kInsertCount, bulkTree.size());
+  EXPECT_TRUE(insertTree == bulkTree);
+  // Longest match behaves the same on both trees
+  for (auto pfx: prefixesSeen) {
+    auto iitr = insertTree.longestMatch(pfx.ip, pfx.mask);
+    auto bitr = bulkTree.longestMatch(pfx.ip, pfx.mask);
+    ASSERT_NE(bulkTree.end(), bitr);
+    EXPECT_EQ(iitr->value(), bitr->value());
+    EXPECT_EQ(iitr->ipAddress(), bitr->ipAddress());
+    EXPECT_EQ(iitr->masklen(), bitr->masklen());
+  }
+}
+
+TEST(RadixTree, BulkBuildComposite) {
+  RadixTree<IPAddress, int> insertTree;
+  vector<RadixTree<IPAddress, int>::BulkEntry> entries;
+  // A handful of hand picked prefixes exercising nested, disjoint
+  // and duplicate cases in both families
+  vector<pair<string, uint8_t>> prefixes = {
+    {"0.0.0.0", 0}, {"10.0.0.0", 8}, {"10.1.0.0", 16}, {"10.1.1.0", 24},
+    {"10.2.0.0", 16}, {"192.168.0.0", 16}, {"192.168.0.0", 24},
+    {"::", 0}, {"2001:db8::", 32}, {"2001:db8:1::", 48},
+    {"2401:db00::", 32}, {"fe80::", 10},
+  };
+  auto value = 0;
+  for (auto const& pfx: prefixes) {
+    auto ip = IPAddress(pfx.first);
+    insertTree.insert(ip, pfx.second, value);
+    entries.push_back({ip, pfx.second, value});
+    ++value;
+  }
+  // Entries above are already sorted by (ip, masklen) within each family
+  RadixTree<IPAddress, int> bulkTree;
+  bulkTree.bulkBuild(entries);
+  EXPECT_EQ(insertTree.size(), bulkTree.size());
+  EXPECT_TRUE(insertTree == bulkTree);
+  // Duplicate prefixes keep the first value, same as insert
+  vector<RadixTree<IPAddressV4, int>::BulkEntry> dup = {
+    {folly::IPAddressV4("10.0.0.0"), 8, 1},
+    {folly::IPAddressV4("10.0.0.0"), 8, 2},
+  };
+  RadixTree<IPAddressV4, int> dupTree;
+  dupTree.bulkBuild(dup);
+  EXPECT_EQ(1, dupTree.size());
+  EXPECT_EQ(1, dupTree.exactMatch(folly::IPAddressV4("10.0.0.0"), 8).value());
+}
+
 /*
  * Compare with py-radix
  * Insert a set of random prefixes on both py-radix and our radix tree
@@ -26,6 +26,7 @@
  *   XFER_STATUS_RESPONSE has previously indicated that the read is complete.
  */
 #include "fboss/lib/usb/CP2112.h"
+#include "fboss/lib/usb/UsbDeviceMonitor.h"
 #include "fboss/lib/usb/UsbError.h"
 #include "fboss/agent/BmcRestClient.h"
 
@@ -38,11 +39,38 @@ using folly::Endian;
 using folly::StringPiece;
 using folly::MutableByteRange;
 using std::chrono::duration_cast;
+using std::chrono::microseconds;
 using std::chrono::milliseconds;
 using std::chrono::steady_clock;
 
 namespace {
 
+/*
+ * Bounds for the exponential backoff used while waiting on the device.
+ *
+ * The old code slept a fixed 10ms between polls, which quantized every
+ * I2C transaction on the bus to multiples of 10ms; across a full QSFP
+ * scan those sleeps dominated the latency.  Most transactions complete
+ * within a few hundred microseconds of the first poll, so we start
+ * there and back off to keep USB poll traffic bounded when a transfer
+ * really does take a while.
+ */
+constexpr microseconds kMinPollInterval(200);
+constexpr microseconds kMaxPollInterval(2000);
+
+/*
+ * Bounds for recovery after a device reset.
+ *
+ * With hotplug support the arrival event re-opens the device as soon
+ * as it re-enumerates (typically well under a second); the timeout
+ * only bounds how long we wait for a chip that never comes back.
+ * Without hotplug support we rescan the bus with exponential backoff
+ * between the limits below.
+ */
+constexpr milliseconds kReattachTimeout(10000);
+constexpr milliseconds kMinReattachBackoff(50);
+constexpr milliseconds kMaxReattachBackoff(1600);
+
 struct ReportType {
   enum : uint16_t {
     INPUT = 0x0100,
@@ -125,6 +153,8 @@ CP2112::CP2112(libusb_context* ctx)
 
 CP2112::~CP2112() {
   close();
+  // The monitor's event thread must stop before the context goes away.
+  monitor_.reset();
   if (ctx_ && ownCtx_) {
     libusb_exit(ctx_);
   }
@@ -135,7 +165,8 @@ void CP2112::open(bool setSmbusConfig) {
     close();
   };
 
-  openDevice();
+  startDeviceMonitor();
+  openDevice(milliseconds(0));
   if (setSmbusConfig) {
     initSettings();
   }
@@ -197,6 +228,40 @@ void CP2112::resetDevice() {
   VLOG(1) << "resetting CP2112 device";
   lastResetTime_ = nowTime;
   resetFromUserver();
+  // The chip drops off the bus to re-enumerate, so our handle is now
+  // stale.  Drop it and re-open once the device comes back.
+  close();
+  reopenAfterReset();
+}
+
+void CP2112::reopenAfterReset() {
+  if (monitor_ && monitor_->isRunning()) {
+    // The arrival event re-opens the handle as soon as the chip
+    // re-enumerates, rather than sleeping and rescanning the bus.
+    SCOPE_FAIL {
+      close();
+    };
+    openDevice(kReattachTimeout);
+    initSettings();
+    flushTransfers();
+    return;
+  }
+
+  // No hotplug support: rescan the bus with exponential backoff.
+  auto backoff = kMinReattachBackoff;
+  auto end = steady_clock::now() + kReattachTimeout;
+  while (true) {
+    try {
+      open();
+      return;
+    } catch (const UsbError& ex) {
+      if (steady_clock::now() >= end) {
+        throw;
+      }
+      usleep(duration_cast<microseconds>(backoff).count());
+      backoff = std::min(backoff * 2, kMaxReattachBackoff);
+    }
+  }
 }
 
 CP2112::VersionInfo CP2112::getVersion() {
@@ -283,8 +348,8 @@ void CP2112::setSMBusConfig(SMBusConfig config) {
 void CP2112::read(uint8_t address,
                   MutableByteRange buf,
                   milliseconds timeout) {
-  if (buf.size() > 512) {
-    throw UsbError("cannot read more than 512 bytes at once");
+  if (buf.size() > MAX_READ_SIZE) {
+    throw UsbError("cannot read more than ", MAX_READ_SIZE, " bytes at once");
   }
   if (buf.size() < 1) {
     // As far as I can tell, CP2112 doesn't support 0-length "quick" reads.
@@ -306,8 +371,9 @@ void CP2112::read(uint8_t address,
 }
 
 void CP2112::write(uint8_t address, ByteRange buf, milliseconds timeout) {
-  if (buf.size() > 61) {
-    throw UsbError("cannot write more than 61 bytes at once");
+  if (buf.size() > MAX_WRITE_SIZE) {
+    throw UsbError("cannot write more than ", MAX_WRITE_SIZE,
+                   " bytes at once");
   }
   if (buf.size() < 1) {
     // As far as I can tell, CP2112 doesn't support 0-length "quick" writes.
@@ -334,15 +400,16 @@ void CP2112::writeReadUnsafe(uint8_t address,
                              ByteRange writeBuf,
                              MutableByteRange readBuf,
                              milliseconds timeout) {
-  if (writeBuf.size() > 16) {
-    throw UsbError("cannot write more than 16 bytes at once for "
-                   "read-after-write");
+  if (writeBuf.size() > MAX_WRITE_READ_ADDR_SIZE) {
+    throw UsbError("cannot write more than ", MAX_WRITE_READ_ADDR_SIZE,
+                   " bytes at once for read-after-write");
   }
   if (writeBuf.size() < 1) {
     throw UsbError("must write at least 1 byte for read-after-write");
   }
-  if (readBuf.size() > 512) {
-    throw UsbError("cannot read more than 512 bytes at once");
+  if (readBuf.size() > MAX_READ_SIZE) {
+    throw UsbError("cannot read more than ", MAX_READ_SIZE,
+                   " bytes at once");
   }
   if (readBuf.size() < 1) {
     throw UsbError("0-length reads are not allowed");
@@ -362,8 +429,27 @@ void CP2112::writeReadUnsafe(uint8_t address,
   processReadResponse(readBuf, timeout);
 }
 
-void CP2112::openDevice() {
-  dev_ = UsbDevice::find(ctx_, VENDOR_ID, PRODUCT_ID);
+void CP2112::startDeviceMonitor() {
+  if (monitor_) {
+    return;
+  }
+  monitor_ = std::make_unique<UsbDeviceMonitor>(ctx_, VENDOR_ID, PRODUCT_ID);
+  if (!monitor_->start()) {
+    // No hotplug support in this libusb; every open falls back to
+    // scanning the bus.
+    monitor_.reset();
+  }
+}
+
+void CP2112::openDevice(milliseconds attachTimeout) {
+  if (monitor_ && monitor_->isRunning()) {
+    // The monitor already knows whether the device is attached, so no
+    // bus scan is needed.  A non-zero timeout waits for the device to
+    // (re-)enumerate.
+    dev_ = monitor_->waitForDevice(attachTimeout);
+  } else {
+    dev_ = UsbDevice::find(ctx_, VENDOR_ID, PRODUCT_ID);
+  }
   handle_ = dev_.open();
   handle_.claimInterface(0);
 }
@@ -561,6 +647,7 @@ void CP2112::processReadResponse(MutableByteRange buf, milliseconds timeout) {
   uint8_t usbBuf[64];
   uint16_t bytesRead{0};
   bool sendRead = true;
+  microseconds readPollInterval = kMinPollInterval;
   while (true) {
     // Send READ_FORCE_SEND if we think the device won't send data to us
     // otherwise.
@@ -590,7 +677,7 @@ void CP2112::processReadResponse(MutableByteRange buf, milliseconds timeout) {
       if (ex.errorCode() != LIBUSB_ERROR_TIMEOUT) {
         throw;
       }
-      timeLeft = updateTimeLeft(end, false);
+      timeLeft = updateTimeLeft(end, microseconds(0));
       if (timeLeft <= milliseconds(0)) {
         throw UsbError("timed out waiting on read response data");
       }
@@ -646,10 +733,18 @@ void CP2112::processReadResponse(MutableByteRange buf, milliseconds timeout) {
     sendRead = (bytesRead < buf.size()) && (length < 61);
 
     // If we are still here the transaction is still in progress.
-    // Update timeLeft.  If no data was returned, also sleep briefly to avoid
-    // spinning on the CPU.
-    bool sleep = (length == 0);
-    timeLeft = updateTimeLeft(end, sleep);
+    // Update timeLeft.  If no data was returned, also sleep briefly to
+    // avoid spinning on the CPU.  The sleep starts well under a
+    // millisecond and backs off exponentially: response data usually
+    // arrives within a poll interval or two, and a fixed sleep quantum
+    // here gets paid by every read on the bus.
+    if (length == 0) {
+      timeLeft = updateTimeLeft(end, readPollInterval);
+      readPollInterval = std::min(readPollInterval * 2, kMaxPollInterval);
+    } else {
+      timeLeft = updateTimeLeft(end, microseconds(0));
+      readPollInterval = kMinPollInterval;
+    }
     if (timeLeft <= milliseconds(0)) {
       throw UsbError("timed out waiting on read response data");
     }
@@ -721,6 +816,7 @@ milliseconds CP2112::waitForTransfer(StringPiece operation,
 
   uint8_t usbBuf[64];
   uint32_t loopIter{0};
+  microseconds pollInterval = kMinPollInterval;
   while (true) {
     ++loopIter;
     getTransferStatusImpl(usbBuf, timeLeft, operation, loopIter);
@@ -749,7 +845,8 @@ milliseconds CP2112::waitForTransfer(StringPiece operation,
                      " while waiting on ", operation, " completion");
     }
 
-    timeLeft = updateTimeLeft(end, true);
+    timeLeft = updateTimeLeft(end, pollInterval);
+    pollInterval = std::min(pollInterval * 2, kMaxPollInterval);
     if (timeLeft < milliseconds(0)) {
       cancelTransfer();
       throw UsbError("timed out waiting on ", operation, " response: ",
@@ -758,13 +855,15 @@ milliseconds CP2112::waitForTransfer(StringPiece operation,
   }
 }
 
-milliseconds CP2112::updateTimeLeft(steady_clock::time_point end, bool sleep) {
+milliseconds CP2112::updateTimeLeft(steady_clock::time_point end,
+                                    microseconds sleepTime) {
   auto now = steady_clock::now();
   auto timeLeft = duration_cast<milliseconds>(end - now);
-  if (timeLeft >= milliseconds(0) && sleep) {
-    auto sleepDuration = std::min(timeLeft, milliseconds(10));
-    usleep(sleepDuration.count() * 1000);
-    timeLeft -= sleepDuration;
+  if (timeLeft >= milliseconds(0) && sleepTime > microseconds(0)) {
+    auto sleepDuration =
+        std::min(duration_cast<microseconds>(end - now), sleepTime);
+    usleep(sleepDuration.count());
+    timeLeft = duration_cast<milliseconds>(end - steady_clock::now());
   }
 
   return timeLeft;
@@ -16,11 +16,14 @@
 
 #include <chrono>
 #include <cstdint>
+#include <memory>
 
 struct libusb_transfer;
 
 namespace facebook { namespace fboss {
 
+class UsbDeviceMonitor;
+
 /*
  * An interface to the Silicon Labs CP2112 USB to SMBus bridge.
  *
@@ -205,6 +208,15 @@ class CP2112 {
     uint16_t bytesRead;
   };
 
+  enum : uint16_t {
+    // The largest single SMBus read the chip can perform.
+    MAX_READ_SIZE = 512,
+    // The largest single SMBus write the chip can perform.
+    MAX_WRITE_SIZE = 61,
+    // The largest write (address) phase for a read-after-write.
+    MAX_WRITE_READ_ADDR_SIZE = 16,
+  };
+
   CP2112();
   explicit CP2112(libusb_context* ctx);
   ~CP2112();
@@ -226,11 +238,16 @@ class CP2112 {
    * Reset the CP2112 chip.
    *
    * This will cause the chip to disconnect and re-enumerate on the USB bus.
-   * This function will wait for the device to reinitialize and then will
-   * re-connect to it before returning.
    */
   void resetFromUserver();
   bool resetFromRestEndpoint();
+  /*
+   * Reset the chip and re-open it once it reappears on the bus.
+   *
+   * When libusb hotplug support is available the re-open is driven by
+   * the device arrival event; otherwise we poll the bus with
+   * exponential backoff until the device re-enumerates.
+   */
   void resetDevice();
 
   VersionInfo getVersion();
@@ -360,7 +377,9 @@ class CP2112 {
   CP2112(CP2112 const &) = delete;
   CP2112& operator=(CP2112 const &) = delete;
 
-  void openDevice();
+  void startDeviceMonitor();
+  void openDevice(std::chrono::milliseconds attachTimeout);
+  void reopenAfterReset();
   void initSettings();
 
   void ensureGoodState();
@@ -379,7 +398,7 @@ class CP2112 {
       std::chrono::steady_clock::time_point end);
   std::chrono::milliseconds updateTimeLeft(
       std::chrono::steady_clock::time_point end,
-      bool sleep);
+      std::chrono::microseconds sleepTime);
 
   uint16_t featureReportIn(ReportID report, uint8_t* buf, uint16_t length);
   void fullFeatureReportIn(ReportID report, uint8_t* buf, uint16_t length);
@@ -390,6 +409,9 @@ class CP2112 {
               std::chrono::milliseconds timeout);
 
   libusb_context* ctx_{nullptr};
+  // Tracks the device's attachment state via hotplug events; null when
+  // the running libusb has no hotplug support.
+  std::unique_ptr<UsbDeviceMonitor> monitor_;
   UsbDevice dev_;
   UsbHandle handle_;
   bool ownCtx_{false};
@@ -9,10 +9,25 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace facebook { namespace fboss {
 
+/*
+ * Scheduling class for an I2C transaction.  The bus arbiter grants a
+ * waiting lower-numbered class the bus ahead of any higher-numbered
+ * one, and slices BULK transfers so they can be preempted at segment
+ * boundaries, bounding the latency a presence check can see behind a
+ * large EEPROM dump.
+ */
+enum class I2cClass : uint8_t {
+  INTERACTIVE,  // latency-sensitive, e.g. presence detection
+  PERIODIC,     // steady-state DOM refresh traffic
+  BULK,         // full-EEPROM dumps and other large transfers
+};
+constexpr std::size_t kNumI2cClasses = 3;
+
 /*
  * Abstract away some of the details of handling the I2C bus to query
  * QSFP and SFP transceiver modules.
@@ -0,0 +1,142 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/lib/usb/UsbDeviceMonitor.h"
+
+#include <glog/logging.h>
+
+#include <libusb-1.0/libusb.h>
+
+#include "fboss/lib/usb/UsbDevice.h"
+#include "fboss/lib/usb/UsbError.h"
+
+namespace {
+
+int hotplugCallback(libusb_context* /* ctx */,
+                    libusb_device* dev,
+                    libusb_hotplug_event event,
+                    void* userData) {
+  auto* monitor = static_cast<facebook::fboss::UsbDeviceMonitor*>(userData);
+  monitor->handleDeviceEvent(
+      dev, event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED);
+  // Returning 0 keeps the callback registered.
+  return 0;
+}
+
+}
+
+namespace facebook { namespace fboss {
+
+UsbDeviceMonitor::UsbDeviceMonitor(libusb_context* ctx,
+                                   uint16_t vendor,
+                                   uint16_t product)
+  : ctx_(ctx),
+    vendor_(vendor),
+    product_(product) {
+}
+
+UsbDeviceMonitor::~UsbDeviceMonitor() {
+  stop();
+}
+
+bool UsbDeviceMonitor::start() {
+  if (running_.load(std::memory_order_acquire)) {
+    return true;
+  }
+  if (!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+    VLOG(1) << "libusb has no hotplug support; "
+            << "falling back to scanning the bus";
+    return false;
+  }
+
+  // LIBUSB_HOTPLUG_ENUMERATE makes libusb invoke the callback for
+  // matching devices that are already attached, so the monitor starts
+  // out knowing about the device.
+  int rc = libusb_hotplug_register_callback(
+      ctx_,
+      static_cast<libusb_hotplug_event>(
+          LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED |
+          LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT),
+      LIBUSB_HOTPLUG_ENUMERATE,
+      vendor_,
+      product_,
+      LIBUSB_HOTPLUG_MATCH_ANY,
+      hotplugCallback,
+      this,
+      &callbackHandle_);
+  if (rc != 0) {
+    throw LibusbError(rc, "failed to register USB hotplug callback");
+  }
+
+  running_.store(true, std::memory_order_release);
+  eventThread_ = std::thread([this] { eventLoop(); });
+  return true;
+}
+
+void UsbDeviceMonitor::stop() {
+  if (!running_.load(std::memory_order_acquire)) {
+    return;
+  }
+  running_.store(false, std::memory_order_release);
+  // Deregistering the callback also wakes up the event thread.
+  libusb_hotplug_deregister_callback(ctx_, callbackHandle_);
+  callbackHandle_ = -1;
+  eventThread_.join();
+
+  std::lock_guard<std::mutex> g(mutex_);
+  if (device_) {
+    libusb_unref_device(device_);
+    device_ = nullptr;
+  }
+}
+
+UsbDevice UsbDeviceMonitor::waitForDevice(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (!cv_.wait_for(lk, timeout, [&] { return device_ != nullptr; })) {
+    throw UsbError("timed out waiting for device to attach");
+  }
+  // UsbDevice takes its own reference; ours stays with the monitor.
+  return UsbDevice(device_);
+}
+
+void UsbDeviceMonitor::handleDeviceEvent(libusb_device* dev, bool arrived) {
+  {
+    std::lock_guard<std::mutex> g(mutex_);
+    if (device_) {
+      libusb_unref_device(device_);
+      device_ = nullptr;
+    }
+    if (arrived) {
+      libusb_ref_device(dev);
+      device_ = dev;
+    }
+  }
+  VLOG(1) << "USB device " << (arrived ? "arrived" : "left")
+          << " (vendor 0x" << std::hex << vendor_
+          << " product 0x" << product_ << ")";
+  if (arrived) {
+    cv_.notify_all();
+  }
+}
+
+void UsbDeviceMonitor::eventLoop() {
+  while (running_.load(std::memory_order_acquire)) {
+    // The timeout bounds how long shutdown can take if the
+    // deregistration wakeup is missed.
+    timeval tv;
+    tv.tv_sec = 1;
+    tv.tv_usec = 0;
+    int rc = libusb_handle_events_timeout_completed(ctx_, &tv, nullptr);
+    if (rc != 0 && rc != LIBUSB_ERROR_INTERRUPTED) {
+      LOG(ERROR) << "error handling USB events: " << libusb_error_name(rc);
+    }
+  }
+}
+
+}} // facebook::fboss
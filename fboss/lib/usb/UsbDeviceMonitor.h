@@ -0,0 +1,97 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+struct libusb_context;
+struct libusb_device;
+
+namespace facebook { namespace fboss {
+
+class UsbDevice;
+
+/*
+ * Tracks the attachment state of a single vendor/product pair using
+ * libusb hotplug callbacks.
+ *
+ * Once started, the monitor always holds a reference to the device
+ * while it is attached, so callers can open it without scanning the
+ * whole USB bus.  More importantly, waitForDevice() blocks until the
+ * device is present, which lets recovery from a USB reset re-open the
+ * handle as soon as the chip re-enumerates instead of polling the bus
+ * with sleeps in between.
+ *
+ * The monitor runs its own thread to service libusb events.  libusb
+ * supports this alongside synchronous transfers made on the same
+ * context from other threads.
+ */
+class UsbDeviceMonitor {
+ public:
+  UsbDeviceMonitor(libusb_context* ctx, uint16_t vendor, uint16_t product);
+  ~UsbDeviceMonitor();
+
+  /*
+   * Register the hotplug callback and start the event thread.
+   *
+   * Returns false, leaving the monitor inactive, if the libusb we are
+   * running against has no hotplug support.  Callers should fall back
+   * to scanning the bus in that case.
+   */
+  bool start();
+  void stop();
+
+  bool isRunning() const {
+    return running_.load(std::memory_order_acquire);
+  }
+
+  /*
+   * Wait for the device to be attached, and return a reference to it.
+   *
+   * Returns immediately if the device is already present.  Throws
+   * UsbError if the device does not appear within the timeout.
+   */
+  UsbDevice waitForDevice(std::chrono::milliseconds timeout);
+
+  /*
+   * Record an arrival or departure.  This is invoked from the libusb
+   * hotplug callback; it is not intended for other callers.
+   */
+  void handleDeviceEvent(libusb_device* dev, bool arrived);
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  UsbDeviceMonitor(UsbDeviceMonitor const &) = delete;
+  UsbDeviceMonitor& operator=(UsbDeviceMonitor const &) = delete;
+
+  void eventLoop();
+
+  libusb_context* ctx_{nullptr};
+  uint16_t vendor_{0};
+  uint16_t product_{0};
+  // libusb_hotplug_callback_handle is a typedef for int; using the
+  // plain type here keeps libusb.h out of this header.
+  int callbackHandle_{-1};
+  std::thread eventThread_;
+  std::atomic<bool> running_{false};
+
+  // The members below are guarded by mutex_.  device_ holds a libusb
+  // reference from arrival until departure (or stop()).
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  libusb_device* device_{nullptr};
+};
+
+}} // facebook::fboss
@@ -10,8 +10,11 @@
 
 #pragma once
 
+#include "fboss/lib/usb/TransceiverI2CApi.h"
 #include "fboss/qsfp_service/TransceiverManager.h"
 
+#include <cstdint>
+
 namespace facebook { namespace fboss {
 class StatsPublisher {
  public:
@@ -22,6 +25,8 @@ class StatsPublisher {
   static void bumpPciLockHeld();
   static void bumpReadFailure();
   static void bumpWriteFailure();
+  // Per-class I2C transaction latency (queueing plus transfer)
+  static void publishI2cLatency(I2cClass cls, int64_t usecs);
 
  private:
   TransceiverManager* transceiverManager_{nullptr};
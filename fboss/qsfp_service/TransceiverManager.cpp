@@ -0,0 +1,115 @@
+#include "fboss/qsfp_service/TransceiverManager.h"
+
+#include <glog/logging.h>
+
+#include <chrono>
+
+namespace {
+// How long one full refresh pass over the inventory should take.  This
+// matches the minimum DOM cache age in QsfpModule, so by the time the
+// loop comes back around to a module its cache is due again.
+constexpr std::chrono::seconds kRefreshInterval(5);
+// How long the presence event thread blocks in waitForPresenceChange()
+// before re-checking whether it should exit.
+constexpr std::chrono::milliseconds kPresenceWaitTimeout(1000);
+}
+
+namespace facebook { namespace fboss {
+
+TransceiverManager::~TransceiverManager() {
+  stopRefreshThread();
+  stopPresenceEventThread();
+}
+
+void TransceiverManager::startRefreshThread() {
+  if (refreshRunning_) {
+    return;
+  }
+  refreshRunning_ = true;
+  refreshThread_ = std::thread([this] { refreshLoop(); });
+}
+
+void TransceiverManager::stopRefreshThread() {
+  if (!refreshRunning_) {
+    return;
+  }
+  refreshRunning_ = false;
+  refreshThread_.join();
+}
+
+void TransceiverManager::refreshLoop() {
+  while (refreshRunning_) {
+    auto numModules = transceivers_.size();
+    if (numModules == 0) {
+      std::this_thread::sleep_for(kRefreshInterval);
+      continue;
+    }
+    // Spread the refreshes evenly across the interval.  A refresh that
+    // finds a fresh cache is nearly free, so the pacing below bounds
+    // the bus duty cycle rather than the pass rate.
+    auto slice = kRefreshInterval / numModules;
+    for (auto& transceiver : transceivers_) {
+      if (!refreshRunning_) {
+        return;
+      }
+      try {
+        transceiver->refresh();
+      } catch (const std::exception& ex) {
+        LOG(ERROR) << "error refreshing transceiver: " << ex.what();
+      }
+      std::this_thread::sleep_for(slice);
+    }
+  }
+}
+
+bool TransceiverManager::waitForPresenceChange(
+    std::vector<int32_t>& /* changedIds */,
+    std::chrono::milliseconds /* timeout */) {
+  // No event source on this platform.
+  return false;
+}
+
+void TransceiverManager::startPresenceEventThread() {
+  if (!supportsPresenceEvents() || presenceRunning_) {
+    return;
+  }
+  presenceRunning_ = true;
+  presenceThread_ = std::thread([this] { presenceEventLoop(); });
+}
+
+void TransceiverManager::stopPresenceEventThread() {
+  if (!presenceRunning_) {
+    return;
+  }
+  presenceRunning_ = false;
+  presenceThread_.join();
+}
+
+void TransceiverManager::presenceEventLoop() {
+  std::vector<int32_t> changedIds;
+  while (presenceRunning_) {
+    changedIds.clear();
+    if (!waitForPresenceChange(changedIds, kPresenceWaitTimeout)) {
+      continue;
+    }
+    // Re-detect just the slots the event named; the rest of the
+    // inventory stays off the bus.
+    for (auto id : changedIds) {
+      if (!presenceRunning_) {
+        return;
+      }
+      if (!isValidTransceiver(id)) {
+        LOG(ERROR) << "presence event for unknown transceiver " << id;
+        continue;
+      }
+      try {
+        transceivers_[id]->detectTransceiver();
+      } catch (const std::exception& ex) {
+        LOG(ERROR) << "error re-detecting transceiver " << id << ": "
+                   << ex.what();
+      }
+    }
+  }
+}
+
+}} // facebook::fboss
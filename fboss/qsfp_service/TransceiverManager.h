@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <vector>
 
 #include "fboss/agent/types.h"
@@ -10,7 +13,7 @@ namespace facebook { namespace fboss {
 class TransceiverManager {
  public:
   TransceiverManager() {};
-  virtual ~TransceiverManager() {};
+  virtual ~TransceiverManager();
   virtual void initTransceiverMap() = 0;
   virtual void getTransceiversInfo(std::map<int32_t, TransceiverInfo>& info,
     std::unique_ptr<std::vector<int32_t>> ids) = 0;
@@ -19,11 +22,74 @@ class TransceiverManager {
     return id < transceivers_.size() && id >= 0;
   }
   virtual int getNumQsfpModules() = 0;
+
+  /*
+   * Start the background refresh thread.
+   *
+   * The thread walks the transceivers continuously, pacing itself so a
+   * full pass takes one refresh interval instead of bursting all of
+   * the bus traffic at once.  Each module's cache is refreshed as it
+   * comes due, so getTransceiversInfo() is normally served straight
+   * from warm caches instead of paying for a full-inventory bus scan
+   * inline.
+   *
+   * Called by initTransceiverMap() implementations once the
+   * transceiver map is populated.
+   */
+  void startRefreshThread();
+  void stopRefreshThread();
+
+  /*
+   * Start the presence event thread.
+   *
+   * On platforms whose CPLD raises an interrupt when a transceiver is
+   * inserted or removed, the thread blocks on waitForPresenceChange()
+   * and re-runs detection for just the slots that changed, giving
+   * sub-second insertion detection without periodic presence sweeps
+   * over the bus.  Platforms without an event source leave
+   * supportsPresenceEvents() false, and this call is a no-op.
+   *
+   * Managers that override waitForPresenceChange() must call
+   * stopPresenceEventThread() from their own destructor: the base
+   * class destructor also stops the thread, but only after the
+   * override has been torn down.
+   */
+  void startPresenceEventThread();
+  void stopPresenceEventThread();
+
  private:
   // Forbidden copy constructor and assignment operator
   TransceiverManager(TransceiverManager const &) = delete;
   TransceiverManager& operator=(TransceiverManager const &) = delete;
+
+  void refreshLoop();
+  void presenceEventLoop();
+
+  std::thread refreshThread_;
+  std::atomic<bool> refreshRunning_{false};
+  std::thread presenceThread_;
+  std::atomic<bool> presenceRunning_{false};
+
  protected:
+  /*
+   * Does this platform have a transceiver presence change event
+   * source?
+   */
+  virtual bool supportsPresenceEvents() const {
+    return false;
+  }
+
+  /*
+   * Block until the platform's event source reports presence changes,
+   * or the timeout expires.  Returns true and fills changedIds with
+   * the affected transceiver IDs when an event fired, false on
+   * timeout.  The default implementation has no event source and
+   * always times out.
+   */
+  virtual bool waitForPresenceChange(
+      std::vector<int32_t>& changedIds,
+      std::chrono::milliseconds timeout);
+
   std::vector<std::unique_ptr<Transceiver>> transceivers_;
 };
 }} // facebook::fboss
@@ -25,4 +25,8 @@ void StatsPublisher::bumpReadFailure() {
 // static
 void StatsPublisher::bumpWriteFailure() {
 }
+// static
+void StatsPublisher::publishI2cLatency(I2cClass /* cls */,
+                                       int64_t /* usecs */) {
+}
 }}
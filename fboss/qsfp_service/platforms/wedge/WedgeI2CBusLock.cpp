@@ -12,9 +12,25 @@
 
 #include "fboss/qsfp_service/StatsPublisher.h"
 
+#include <algorithm>
+#include <chrono>
+
 using folly::MutableByteRange;
 using std::lock_guard;
 
+namespace {
+
+// Publish the wall-clock latency of a transaction (queueing plus
+// transfer) to the per-class histogram.
+void publishLatency(facebook::fboss::I2cClass cls,
+                    std::chrono::steady_clock::time_point start) {
+  auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+  facebook::fboss::StatsPublisher::publishI2cLatency(cls, usecs);
+}
+
+}
+
 namespace facebook { namespace fboss {
 
 WedgeI2CBusLock::WedgeI2CBusLock(std::unique_ptr<BaseWedgeI2CBus> wedgeI2CBus)
@@ -28,8 +44,14 @@ void WedgeI2CBusLock::openLocked() {
 }
 
 void WedgeI2CBusLock::open() {
-  lock_guard<std::mutex> g(busMutex_);
-  openLocked();
+  acquireBus(I2cClass::INTERACTIVE);
+  try {
+    openLocked();
+  } catch (...) {
+    releaseBus();
+    throw;
+  }
+  releaseBus();
 }
 
 void WedgeI2CBusLock::closeLocked() {
@@ -38,32 +60,114 @@ void WedgeI2CBusLock::closeLocked() {
 }
 
 void WedgeI2CBusLock::close() {
-  lock_guard<std::mutex> g(busMutex_);
-  closeLocked();
+  acquireBus(I2cClass::INTERACTIVE);
+  try {
+    closeLocked();
+  } catch (...) {
+    releaseBus();
+    throw;
+  }
+  releaseBus();
+}
+
+bool WedgeI2CBusLock::higherClassWaitingLocked(I2cClass cls) const {
+  for (std::size_t pri = 0; pri < static_cast<std::size_t>(cls); ++pri) {
+    if (waiting_[pri] != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void WedgeI2CBusLock::acquireBus(I2cClass cls) {
+  auto pri = static_cast<std::size_t>(cls);
+  std::unique_lock<std::mutex> lk(busMutex_);
+  ++waiting_[pri];
+  busCv_.wait(lk, [&] {
+    return !busBusy_ && !higherClassWaitingLocked(cls);
+  });
+  --waiting_[pri];
+  busBusy_ = true;
+}
+
+void WedgeI2CBusLock::releaseBus() {
+  {
+    lock_guard<std::mutex> g(busMutex_);
+    busBusy_ = false;
+  }
+  busCv_.notify_all();
+}
+
+void WedgeI2CBusLock::yieldIfContended(I2cClass cls) {
+  {
+    std::unique_lock<std::mutex> lk(busMutex_);
+    if (!higherClassWaitingLocked(cls)) {
+      return;
+    }
+    busBusy_ = false;
+  }
+  busCv_.notify_all();
+  acquireBus(cls);
 }
 
 void WedgeI2CBusLock::moduleRead(unsigned int module, uint8_t address,
-                             int offset, int len, uint8_t *buf) {
-  BusGuard g(this);
-  wedgeI2CBus_->moduleRead(module, address, offset, len, buf);
+                             int offset, int len, uint8_t *buf,
+                             I2cClass cls) {
+  auto start = std::chrono::steady_clock::now();
+  {
+    BusGuard g(this, cls);
+    if (cls == I2cClass::BULK && len > kBulkSegmentBytes) {
+      // Slice the transfer so latency-sensitive waiters can take the
+      // bus at segment boundaries.  The underlying bus re-selects the
+      // module per segment, so interleaving is safe.
+      int done = 0;
+      while (done < len) {
+        auto seg = std::min(len - done, static_cast<int>(kBulkSegmentBytes));
+        wedgeI2CBus_->moduleRead(module, address, offset + done, seg,
+                                 buf + done);
+        done += seg;
+        if (done < len) {
+          g.yieldIfContended();
+        }
+      }
+    } else {
+      wedgeI2CBus_->moduleRead(module, address, offset, len, buf);
+    }
+  }
+  publishLatency(cls, start);
 }
 
 void WedgeI2CBusLock::moduleWrite(unsigned int module, uint8_t address,
-                              int offset, int len, const uint8_t *buf) {
-  BusGuard g(this);
-  wedgeI2CBus_->moduleWrite(module, address, offset, len, buf);
+                              int offset, int len, const uint8_t *buf,
+                              I2cClass cls) {
+  auto start = std::chrono::steady_clock::now();
+  {
+    // Writes are capped at 60 bytes by the CP2112, so they never need
+    // slicing.
+    BusGuard g(this, cls);
+    wedgeI2CBus_->moduleWrite(module, address, offset, len, buf);
+  }
+  publishLatency(cls, start);
 }
 
 void WedgeI2CBusLock::read(uint8_t address, int offset,
-                           int len, uint8_t *buf) {
-  BusGuard g(this);
-  wedgeI2CBus_->read(address, offset, len, buf);
+                           int len, uint8_t *buf, I2cClass cls) {
+  auto start = std::chrono::steady_clock::now();
+  {
+    BusGuard g(this, cls);
+    wedgeI2CBus_->read(address, offset, len, buf);
+  }
+  publishLatency(cls, start);
 }
 
 void WedgeI2CBusLock::write(uint8_t address, int offset,
-                            int len, const uint8_t *buf) {
-  BusGuard g(this);
-  wedgeI2CBus_->write(address, offset, len, buf);
+                            int len, const uint8_t *buf, I2cClass cls) {
+  auto start = std::chrono::steady_clock::now();
+  {
+    BusGuard g(this, cls);
+    wedgeI2CBus_->write(address, offset, len, buf);
+  }
+  publishLatency(cls, start);
 }
 
 }} // facebook::fboss
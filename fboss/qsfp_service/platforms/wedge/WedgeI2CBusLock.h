@@ -11,6 +11,7 @@
 
 #include "fboss/lib/usb/BaseWedgeI2CBus.h"
 
+#include <condition_variable>
 #include <mutex>
 #include <folly/Range.h>
 
@@ -19,6 +20,15 @@ namespace facebook { namespace fboss {
 /*
  * A small wrapper around CP2112 which is aware of the topology of wedge's QSFP
  * I2C bus, and can select specific QSFPs to query.
+ *
+ * Transactions are scheduled by class rather than arrival order: a
+ * waiting INTERACTIVE op (a presence check) is granted the bus before
+ * any waiting PERIODIC or BULK op, and BULK transfers are sliced so
+ * higher classes can take the bus at segment boundaries.  This keeps
+ * worst-case presence-detect latency bounded during full-EEPROM dumps.
+ * A steady stream of higher-class traffic can starve lower classes;
+ * that does not arise with the current callers (presence checks are
+ * rare and short).
  */
 class WedgeI2CBusLock {
  public:
@@ -26,13 +36,21 @@ class WedgeI2CBusLock {
   void open();
   void close();
   void moduleRead(unsigned int module, uint8_t i2cAddress,
-                  int offset, int len, uint8_t* buf);
+                  int offset, int len, uint8_t* buf,
+                  I2cClass cls = I2cClass::PERIODIC);
   void moduleWrite(unsigned int module, uint8_t i2cAddress,
-                  int offset, int len, const uint8_t* buf);
-  void read(uint8_t i2cAddress, int offset, int len, uint8_t* buf);
-  void write(uint8_t i2cAddress, int offset, int len, const uint8_t* buf);
+                  int offset, int len, const uint8_t* buf,
+                  I2cClass cls = I2cClass::PERIODIC);
+  void read(uint8_t i2cAddress, int offset, int len, uint8_t* buf,
+            I2cClass cls = I2cClass::PERIODIC);
+  void write(uint8_t i2cAddress, int offset, int len, const uint8_t* buf,
+             I2cClass cls = I2cClass::PERIODIC);
 
  private:
+  // BULK transfers release the bus to higher-class waiters every this
+  // many bytes.
+  enum : int { kBulkSegmentBytes = 32 };
+
   // Forbidden copy constructor and assignment operator
   WedgeI2CBusLock(WedgeI2CBusLock const &) = delete;
   WedgeI2CBusLock& operator=(WedgeI2CBusLock const &) = delete;
@@ -40,13 +58,29 @@ class WedgeI2CBusLock {
   void openLocked();
   void closeLocked();
 
+  /*
+   * Bus ownership.  acquireBus() blocks until no one owns the bus and
+   * no higher class is waiting; the owner may call yieldIfContended()
+   * mid-transfer to let a higher-class waiter in.  busMutex_ only
+   * guards the scheduler state below; the device itself is protected
+   * by ownership.
+   */
+  void acquireBus(I2cClass cls);
+  void releaseBus();
+  void yieldIfContended(I2cClass cls);
+  bool higherClassWaitingLocked(I2cClass cls) const;
+
   std::unique_ptr<BaseWedgeI2CBus> wedgeI2CBus_{nullptr};
   mutable std::mutex busMutex_;
+  std::condition_variable busCv_;
+  bool busBusy_{false};
+  unsigned int waiting_[kNumI2cClasses] = {};
+  // Only touched while owning the bus
   bool opened_{false};
 
   class BusGuard {
     /* This class is a simple guard that:
-       1. locks access to the device
+       1. acquires bus ownership for the transaction's class
        2. opens/closes the device if it is not already open
 
        This makes sure that only one person is accessing the device,
@@ -54,12 +88,18 @@ class WedgeI2CBusLock {
        read/writes.
     */
    public:
-    explicit BusGuard(WedgeI2CBusLock* busLock) :
+    BusGuard(WedgeI2CBusLock* busLock, I2cClass cls) :
         busLock_(busLock),
-        lock_(busLock->busMutex_)
+        cls_(cls)
       {
+        busLock_->acquireBus(cls_);
         if (!busLock_->opened_) {
-          busLock_->openLocked();
+          try {
+            busLock_->openLocked();
+          } catch (...) {
+            busLock_->releaseBus();
+            throw;
+          }
           performedOpen_ = true;
         }
       }
@@ -68,12 +108,17 @@ class WedgeI2CBusLock {
       if (performedOpen_) {
         busLock_->closeLocked();
       }
+      busLock_->releaseBus();
+    }
+
+    void yieldIfContended() {
+      busLock_->yieldIfContended(cls_);
     }
 
    private:
     WedgeI2CBusLock* busLock_{nullptr};
+    I2cClass cls_;
     bool performedOpen_{false};
-    std::lock_guard<std::mutex> lock_;
   };
 };
 
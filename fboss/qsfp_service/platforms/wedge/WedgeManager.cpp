@@ -30,6 +30,15 @@ void WedgeManager::initTransceiverMap(){
     transceivers_.push_back(move(qsfp));
     LOG(INFO) << "making QSFP for " << idx;
   }
+
+  // Keep the caches warm in the background so thrift queries don't have
+  // to walk the whole bus inline.
+  startRefreshThread();
+
+  // No-op unless the platform manager wires up a CPLD presence event
+  // source; with one, insertions and removals re-detect just the
+  // affected slot instead of waiting for a sweep.
+  startPresenceEventThread();
 }
 
 void WedgeManager::getTransceiversInfo(std::map<int32_t, TransceiverInfo>& info,
@@ -38,8 +38,11 @@ WedgeQsfp::~WedgeQsfp() {
 bool WedgeQsfp::detectTransceiver() {
   uint8_t buf[1];
   try {
+    // Presence checks are latency sensitive; they jump ahead of any
+    // queued refresh or bulk EEPROM traffic.
     wedgeI2CBusLock_->moduleRead(module_ + 1, TransceiverI2CApi::ADDR_QSFP,
-                                 0, sizeof(buf), buf);
+                                 0, sizeof(buf), buf,
+                                 I2cClass::INTERACTIVE);
   } catch (const UsbError& ex) {
     /*
      * This can either mean that we failed to open the USB device
@@ -55,8 +58,11 @@ bool WedgeQsfp::detectTransceiver() {
 int WedgeQsfp::readTransceiver(int dataAddress, int offset,
                                int len, uint8_t* fieldValue) {
   try {
+    // Full-page reads are bulk work that yields to presence checks;
+    // smaller reads are part of the periodic refresh traffic.
+    auto cls = len >= 128 ? I2cClass::BULK : I2cClass::PERIODIC;
     wedgeI2CBusLock_->moduleRead(module_ + 1, dataAddress, offset, len,
-                                  fieldValue);
+                                  fieldValue, cls);
   } catch (const UsbError& ex) {
     LOG(ERROR) << "Read from transceiver " << module_ << " at offset " <<
       offset << " with length " << len << " failed: " << ex.what();
@@ -18,6 +18,12 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 using namespace facebook::fboss;
 using namespace ::testing;
 namespace {
@@ -25,6 +31,9 @@ namespace {
 class MockWedgeManager : public WedgeManager {
  public:
   explicit MockWedgeManager() : WedgeManager() {}
+  ~MockWedgeManager() override {
+    stopPresenceEventThread();
+  }
   void makeTransceiverMap() {
     for (int idx = 0; idx < getNumQsfpModules(); idx++) {
       std::unique_ptr<MockQsfpModule> qsfp =
@@ -34,7 +43,37 @@ class MockWedgeManager : public WedgeManager {
     }
   }
 
+  // Stand in for a CPLD presence interrupt: events injected by the
+  // test wake the presence thread with the changed slots.
+  void injectPresenceEvent(std::vector<int32_t> ids) {
+    {
+      std::lock_guard<std::mutex> lk(eventLock_);
+      pendingEvents_ = std::move(ids);
+    }
+    eventCv_.notify_one();
+  }
+
   std::vector<MockQsfpModule*> mockTransceivers_;
+
+ protected:
+  bool supportsPresenceEvents() const override {
+    return true;
+  }
+  bool waitForPresenceChange(std::vector<int32_t>& changedIds,
+                             std::chrono::milliseconds timeout) override {
+    std::unique_lock<std::mutex> lk(eventLock_);
+    if (!eventCv_.wait_for(lk, timeout,
+                           [&] { return !pendingEvents_.empty(); })) {
+      return false;
+    }
+    changedIds.swap(pendingEvents_);
+    return true;
+  }
+
+ private:
+  std::mutex eventLock_;
+  std::condition_variable eventCv_;
+  std::vector<int32_t> pendingEvents_;
 };
 
 class WedgeManagerTest : public ::testing::Test {
@@ -65,4 +104,27 @@ TEST_F(WedgeManagerTest, getTransceiverInfo) {
       std::make_unique<std::vector<int32_t>>(data));
 }
 
+TEST_F(WedgeManagerTest, presenceEventTargetedDetect) {
+  std::atomic<int> detects{0};
+  for (int i : {2, 5}) {
+    EXPECT_CALL(*wedgeManager_->mockTransceivers_[i], detectTransceiver())
+        .WillOnce(InvokeWithoutArgs([&detects] { ++detects; }));
+  }
+
+  wedgeManager_->startPresenceEventThread();
+  wedgeManager_->injectPresenceEvent({2, 5});
+  for (int i = 0; i < 5000 && detects < 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  wedgeManager_->stopPresenceEventThread();
+
+  // Only the slots named by the event were re-detected
+  EXPECT_EQ(2, detects);
+  // An event for an out-of-range slot is ignored, not fatal
+  wedgeManager_->startPresenceEventThread();
+  wedgeManager_->injectPresenceEvent({wedgeManager_->getNumQsfpModules() + 10});
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  wedgeManager_->stopPresenceEventThread();
+}
+
 }
@@ -26,7 +26,7 @@ static const time_t kQsfpMinReadIntervalSecs = 5;
 
 // As per SFF-8436, QSFP+ 10 Gbs 4X PLUGGABLE TRANSCEIVER spec
 
-static SffFieldInfo::SffFieldMap qsfpFields = {
+static constexpr SffFieldTableEntry kQsfpFieldEntries[] = {
   // Base page values, including alarms and sensors
   {SffField::IDENTIFIER, {QsfpPages::LOWER, 0, 1} },
   {SffField::STATUS, {QsfpPages::LOWER, 1, 2} },
@@ -74,7 +74,26 @@ static SffFieldInfo::SffFieldMap qsfpFields = {
   {SffField::TX_BIAS_THRESH, {QsfpPages::PAGE3, 184, 8} },
 };
 
-static SffFieldMultiplier qsfpMultiplier = {
+// Built at compile time; field lookups are a plain array index.
+static constexpr SffFieldTable qsfpFields =
+    makeSffFieldTable(kQsfpFieldEntries);
+
+// Spot-check the generated table against a few register addresses taken
+// straight from the SFF-8436 memory map.
+static_assert(
+    qsfpFields.fields[static_cast<std::size_t>(SffField::TEMPERATURE)]
+        .offset == 22,
+    "QSFP temperature is at lower page byte 22");
+static_assert(
+    qsfpFields.fields[static_cast<std::size_t>(SffField::PAGE_SELECT_BYTE)]
+        .offset == 127,
+    "QSFP page select is at lower page byte 127");
+static_assert(
+    qsfpFields.fields[static_cast<std::size_t>(SffField::VENDOR_NAME)]
+        .length == 16,
+    "QSFP vendor name is 16 bytes");
+
+static constexpr SffFieldMultiplierEntry kQsfpMultiplierEntries[] = {
   {SffField::LENGTH_SM_KM, 1000},
   {SffField::LENGTH_OM3, 2},
   {SffField::LENGTH_OM2, 1},
@@ -82,6 +101,9 @@ static SffFieldMultiplier qsfpMultiplier = {
   {SffField::LENGTH_COPPER, 1},
 };
 
+static constexpr SffFieldMultiplier qsfpMultiplier =
+    makeSffFieldMultiplier(kQsfpMultiplierEntries);
+
 void getQsfpFieldAddress(SffField field, int &dataAddress,
                          int &offset, int &length) {
   auto info = SffFieldInfo::getSffFieldAddress(qsfpFields, field);
@@ -434,7 +456,8 @@ int QsfpModule::getQsfpCableLength(SffField field) {
   auto info = SffFieldInfo::getSffFieldAddress(qsfpFields, field);
   const uint8_t *data = getQsfpValuePtr(info.dataAddress,
                                         info.offset, info.length);
-  auto multiplier = qsfpMultiplier.at(field);
+  auto multiplier =
+      qsfpMultiplier.multipliers[static_cast<std::size_t>(field)];
   length = *data * multiplier;
   if (*data == MAX_CABLE_LEN) {
     length = -(MAX_CABLE_LEN - 1) * multiplier;
@@ -467,7 +490,8 @@ QsfpModule::QsfpModule(std::unique_ptr<TransceiverImpl> qsfpImpl)
   : qsfpImpl_(std::move(qsfpImpl)),
     present_(false),
     dirty_(true),
-    lastReadTime_(0) {
+    lastReadTime_(0),
+    lastStaticReadTime_(0) {
 }
 
 void QsfpModule::setQsfpIdprom() {
@@ -540,6 +564,9 @@ void QsfpModule::setPresent(bool present) {
    */
   if (present_ == false) {
     dirty_ = true;
+    // The next module seated here may be a different part entirely;
+    // the static pages have to be read again.
+    staticPagesValid_ = false;
   }
 }
 
@@ -550,8 +577,20 @@ bool QsfpModule::cacheIsValid() const {
 }
 
 TransceiverInfo QsfpModule::getTransceiverInfo() {
+  // Serve the snapshot published by the last refresh; monitoring reads
+  // never wait on DOM I2C work happening under qsfpModuleMutex_.
+  auto snapshot = std::atomic_load(&snapshot_);
+  if (snapshot) {
+    return *snapshot;
+  }
+  // Nothing published yet; assemble inline under the lock.
   lock_guard<std::mutex> g(qsfpModuleMutex_);
   refreshCacheIfPossibleLocked();
+  publishSnapshotLocked();
+  return *std::atomic_load(&snapshot_);
+}
+
+TransceiverInfo QsfpModule::assembleTransceiverInfoLocked() {
   TransceiverInfo info;
   info.present = present_;
   info.transceiver = type();
@@ -588,6 +627,19 @@ TransceiverInfo QsfpModule::getTransceiverInfo() {
   return info;
 }
 
+void QsfpModule::publishSnapshotLocked() {
+  std::atomic_store(
+      &snapshot_,
+      std::shared_ptr<const TransceiverInfo>(
+          std::make_shared<TransceiverInfo>(assembleTransceiverInfoLocked())));
+}
+
+void QsfpModule::refresh() {
+  lock_guard<std::mutex> g(qsfpModuleMutex_);
+  refreshCacheIfPossibleLocked();
+  publishSnapshotLocked();
+}
+
 // Must be called with lock held on qsfpModuleMutex_
 void QsfpModule::refreshCacheIfPossibleLocked() {
   // Check whether we should refresh data
@@ -596,8 +648,9 @@ void QsfpModule::refreshCacheIfPossibleLocked() {
   }
   if (!cacheIsValid()) {
     if (present_) {
-      // Cache is dirty, refresh
-      updateQsfpData();
+      // Cache is dirty; refresh the dynamic DOM bytes.  The static
+      // pages are reused unless they were invalidated by a removal.
+      updateQsfpData(false);
     } else {
       // Check again
       detectTransceiverLocked();
@@ -620,6 +673,8 @@ void QsfpModule::detectTransceiverLocked() {
       updateQsfpData();
       customizeTransceiverLocked();
     }
+    // Presence changed, so the published snapshot is out of date
+    publishSnapshotLocked();
   }
 }
 
@@ -643,22 +698,27 @@ int QsfpModule::getFieldValue(SffField fieldName,
   return -1;
 }
 
-void QsfpModule::updateQsfpData() {
+void QsfpModule::updateQsfpData(bool allPages) {
   if (present_) {
     try {
-      LOG(INFO) << "Performing qsfp data cache refresh for transceiver " <<
-        folly::to<std::string>(qsfpImpl_->getName());
+      VLOG(2) << "Performing " << ((allPages) ? "full" : "partial")
+              << " qsfp data cache refresh for transceiver "
+              << folly::to<std::string>(qsfpImpl_->getName());
+      // The entire lower page is fetched in one bulk transaction; this
+      // covers all of the dynamic DOM bytes (sensors, flags, settings)
+      // that change from refresh to refresh.
       qsfpImpl_->readTransceiver(TransceiverI2CApi::ADDR_QSFP, 0,
           sizeof(qsfpIdprom_), qsfpIdprom_);
       lastReadTime_ = std::time(nullptr);
       dirty_ = false;
       setQsfpIdprom();
-      /*
-       * XXX:  Should we bother to read this other data every time?
-       *       Surely, it isn't changing?  Is there some other utility to
-       *       update this stuff?  Perhaps just reading the base 128 bytes
-       *       is enough after we initially determine that somethings there?
-       */
+
+      if (!allPages && staticPagesValid_) {
+        // The upper pages only hold static data (vendor info, cable
+        // type, thresholds), so a steady-state refresh stops here and
+        // skips their page selects and reads entirely.
+        return;
+      }
 
       // If we have flat memory, we don't have to set the page
       if (!flatMem_) {
@@ -675,8 +735,11 @@ void QsfpModule::updateQsfpData() {
         qsfpImpl_->readTransceiver(TransceiverI2CApi::ADDR_QSFP, 128,
             sizeof(qsfpPage3_), qsfpPage3_);
       }
+      staticPagesValid_ = true;
+      lastStaticReadTime_ = lastReadTime_.load();
     } catch (const std::exception& ex) {
       dirty_ = true;
+      staticPagesValid_ = false;
       LOG(WARNING) << "Error reading data for transceiver:" <<
            folly::to<std::string>(qsfpImpl_->getName()) << " " << ex.what();
     }
@@ -9,6 +9,7 @@
  */
 #pragma once
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include "fboss/qsfp_service/sff/Transceiver.h"
 #include "fboss/agent/gen-cpp2/switch_config_types.h"
@@ -76,8 +77,18 @@ class QsfpModule : public Transceiver {
   void customizeTransceiver(cfg::PortSpeed speed) override;
   /*
    * Returns the entire QSFP information
+   *
+   * Served from the immutable snapshot published by the last refresh
+   * or detection, so thrift pollers never contend with DOM I2C work
+   * under qsfpModuleMutex_.  Before the first snapshot exists the
+   * response is assembled inline under the lock.
    */
   virtual TransceiverInfo getTransceiverInfo() override;
+  /*
+   * Refresh the DOM cache if it is due, re-detecting the transceiver
+   * if it is not currently present
+   */
+  void refresh() override;
 
   /*
    * The size of the pages used by QSFP.  See below for an explanation of
@@ -114,6 +125,12 @@ class QsfpModule : public Transceiver {
   bool present_{false};
   // Denotes if the cache value is valid or stale
   bool dirty_{false};
+  // Whether the static pages (page0 upper, page3) have been read since
+  // the transceiver was last inserted.  Vendor info and thresholds
+  // don't change while a module is seated, so these pages are only
+  // re-read on insertion (or an explicit full refresh), not on every
+  // DOM refresh.
+  bool staticPagesValid_{false};
   // Flat memory systems don't support paged access to extra data
   bool flatMem_{false};
 
@@ -126,13 +143,26 @@ class QsfpModule : public Transceiver {
    */
   mutable std::mutex qsfpModuleMutex_;
 
+  /*
+   * The snapshot served by getTransceiverInfo().  Written only while
+   * qsfpModuleMutex_ is held (via publishSnapshotLocked()) and read
+   * without the lock through std::atomic_load, so once published it
+   * is never mutated in place - a new snapshot is swapped in instead.
+   */
+  std::shared_ptr<const TransceiverInfo> snapshot_;
+
   /*
    * We don't want to read from the qsfps excessively as there's a single lock
    * held to read from all of them.
    * Instead, only refresh data if it hasn't been updated in
    * kQsfpMinReadIntervalMs.
+   *
+   * Ages are tracked per page class: lastReadTime_ covers the dynamic
+   * DOM bytes in the lower page, lastStaticReadTime_ the static upper
+   * pages.
    */
   std::atomic<time_t> lastReadTime_;
+  std::atomic<time_t> lastStaticReadTime_;
 
   /*
    * Perform transceiver customization
@@ -161,6 +191,20 @@ class QsfpModule : public Transceiver {
    */
   virtual void refreshCacheIfPossibleLocked();
 
+  /*
+   * Assemble a TransceiverInfo response from the cached page data.
+   *
+   * This must be called with a lock held on qsfpModuleMutex_
+   */
+  TransceiverInfo assembleTransceiverInfoLocked();
+
+  /*
+   * Publish a fresh immutable snapshot for getTransceiverInfo().
+   *
+   * This must be called with a lock held on qsfpModuleMutex_
+   */
+  void publishSnapshotLocked();
+
   /*
    * This function returns a pointer to the value in the static cached
    * data after checking the length fits. The thread needs to have the lock
@@ -285,8 +329,13 @@ class QsfpModule : public Transceiver {
   virtual bool cacheIsValid() const;
   /*
    * Update the cached data with the information from the physical QSFP.
+   *
+   * The refresh is page-granular: the dynamic DOM bytes in the lower
+   * page are always re-read, with a single bulk I2C transaction.  The
+   * static upper pages (page0, page3) are only read when allPages is
+   * true or they have not been read since the module was inserted.
    */
-  virtual void updateQsfpData();
+  virtual void updateQsfpData(bool allPages = true);
 };
 
 }} //namespace facebook::fboss
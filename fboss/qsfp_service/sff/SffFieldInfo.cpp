@@ -53,13 +53,14 @@ FeatureState SffFieldInfo::getFeatureState(const uint8_t support,
   return enabled ? FeatureState::ENABLED : FeatureState::DISABLED;
 }
 
-SffFieldInfo SffFieldInfo::getSffFieldAddress(const SffFieldMap& map,
+SffFieldInfo SffFieldInfo::getSffFieldAddress(const SffFieldTable& table,
                                               const SffField field) {
-  auto info = map.find(field);
-  if (info == map.end()) {
+  auto idx = static_cast<std::size_t>(field);
+  if (idx >= kSffFieldCount ||
+      table.fields[idx].dataAddress == kSffInvalidDataAddress) {
     throw FbossError("Invalid SFF Field ID");
   }
-  return info->second;
+  return table.fields[idx];
 }
 
 
@@ -5,8 +5,9 @@
  * of patent rights can be found in the PATENTS file in the same directory.
  */
 #pragma once
+#include <cstddef>
 #include <cstdint>
-#include <map>
+#include <stdexcept>
 
 #include "fboss/qsfp_service/if/gen-cpp2/transceiver_types.h"
 
@@ -93,8 +94,15 @@ enum class SffField {
   VENDOR_MEM_ADDRESS, // Vendor Specific memory address
   USER_EEPROM, // User Writable NVM
   VENDOR_CONTROL, // Vendor Specific Control
+
+  // Must be last:  not a real field, used to size the lookup tables below
+  SFF_FIELD_MAX,
 };
 
+// Number of SffField enumerators, used to size per-field lookup tables
+constexpr std::size_t kSffFieldCount =
+    static_cast<std::size_t>(SffField::SFF_FIELD_MAX);
+
 enum DeviceTechnology : uint8_t {
   TRANSMITTER_TECH_SHIFT = 4,
   OPTICAL_MAX_VALUE = 0b1001,
@@ -153,6 +161,8 @@ enum CdrControl : uint8_t {
   CDR_CONTROL_TX_MASK = 0xf0,
 };
 
+struct SffFieldTable;
+
 class SffFieldInfo {
  public:
   int dataAddress;
@@ -176,19 +186,76 @@ class SffFieldInfo {
   // Render result as a member of FeatureState enum
   static FeatureState getFeatureState(uint8_t support, uint8_t enabled = 1);
 
-  typedef std::map<SffField, SffFieldInfo> SffFieldMap;
-
   /*
    * This function takes the SfpIDPromField name and returns
    * the dataAddress, offset and the length as per the SFP DOM
    * Document mentioned above.
    */
-  static SffFieldInfo getSffFieldAddress(const SffFieldMap& map,
+  static SffFieldInfo getSffFieldAddress(const SffFieldTable& table,
                                          SffField field);
 };
 
+/*
+ * Field tables map each SffField to its (dataAddress, offset, length)
+ * triple.  They are built at compile time by makeSffFieldTable() from a
+ * list of entries, so resolving a field is a plain array index and no
+ * map needs to be allocated at startup.  Fields absent from the entry
+ * list keep kSffInvalidDataAddress and are rejected by
+ * getSffFieldAddress().
+ */
+constexpr int kSffInvalidDataAddress = -1;
+
+struct SffFieldTableEntry {
+  SffField field;
+  SffFieldInfo info;
+};
+
+struct SffFieldTable {
+  SffFieldInfo fields[kSffFieldCount];
+};
+
+template <std::size_t N>
+constexpr SffFieldTable makeSffFieldTable(
+    const SffFieldTableEntry (&entries)[N]) {
+  SffFieldTable table{};
+  for (std::size_t idx = 0; idx < kSffFieldCount; ++idx) {
+    table.fields[idx].dataAddress = kSffInvalidDataAddress;
+  }
+  for (std::size_t entry = 0; entry < N; ++entry) {
+    auto idx = static_cast<std::size_t>(entries[entry].field);
+    // These throws are evaluated during constant initialization, so an
+    // out-of-range or duplicated field in the entry list fails the build.
+    if (idx >= kSffFieldCount) {
+      throw std::logic_error("SffField table entry out of range");
+    }
+    if (table.fields[idx].dataAddress != kSffInvalidDataAddress) {
+      throw std::logic_error("duplicate SffField table entry");
+    }
+    table.fields[idx] = entries[entry].info;
+  }
+  return table;
+}
+
 // Store multipliers for various conversion functions:
 
-typedef std::map<SffField, std::uint32_t> SffFieldMultiplier;
+struct SffFieldMultiplierEntry {
+  SffField field;
+  std::uint32_t multiplier;
+};
+
+struct SffFieldMultiplier {
+  std::uint32_t multipliers[kSffFieldCount];
+};
+
+template <std::size_t N>
+constexpr SffFieldMultiplier makeSffFieldMultiplier(
+    const SffFieldMultiplierEntry (&entries)[N]) {
+  SffFieldMultiplier table{};
+  for (std::size_t entry = 0; entry < N; ++entry) {
+    table.multipliers[static_cast<std::size_t>(entries[entry].field)] =
+        entries[entry].multiplier;
+  }
+  return table;
+}
 
 }} //namespace facebook::fboss
@@ -40,6 +40,14 @@ class Transceiver {
    * Return all of the transceiver information
    */
   virtual TransceiverInfo getTransceiverInfo() = 0;
+  /*
+   * Refresh the cached transceiver data if it has gone stale.
+   *
+   * This is called periodically from the TransceiverManager refresh
+   * thread so that queries can be served from a warm cache instead of
+   * paying for bus I/O inline.
+   */
+  virtual void refresh() = 0;
   /*
    * Set speed specific settings for the transceiver
    */
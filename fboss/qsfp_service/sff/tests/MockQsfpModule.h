@@ -28,10 +28,11 @@ class MockQsfpModule : public QsfpModule {
     QsfpModule(std::move(qsfpImpl)) {}
   MOCK_METHOD1(setPowerOverrideIfSupported, void(PowerControlState));
   MOCK_CONST_METHOD0(cacheIsValid, bool());
-  MOCK_METHOD0(updateQsfpData, void());
+  MOCK_METHOD1(updateQsfpData, void(bool));
   MOCK_METHOD2(getSettingsValue, uint8_t(SffField, uint8_t));
   MOCK_METHOD0(refreshCacheIfPossibleLocked, void());
   MOCK_METHOD0(getTransceiverInfo, TransceiverInfo());
+  MOCK_METHOD0(detectTransceiver, void());
 
   MOCK_METHOD3(setCdrIfSupported, void(cfg::PortSpeed, FeatureState,
         FeatureState));
@@ -45,6 +45,11 @@ class SffTransceiver : public TransceiverImpl {
   folly::StringPiece getName() override;
   int getNum() override;
 
+  // Number of reads that touched the lower page / an upper page, so
+  // tests can check how much I2C traffic a refresh generates.
+  int lowerPageReads_{0};
+  int upperPageReads_{0};
+
  private:
   int module_;
   std::string moduleName_;
@@ -119,6 +124,12 @@ int SffTransceiver::readTransceiver(int dataAddress, int offset,
                                     int len, uint8_t* fieldValue) {
   int read = 0;
   EXPECT_EQ(0x50, dataAddress);
+  if (offset < QsfpModule::MAX_QSFP_PAGE_SIZE) {
+    ++lowerPageReads_;
+  }
+  if (offset + len > QsfpModule::MAX_QSFP_PAGE_SIZE) {
+    ++upperPageReads_;
+  }
   if (offset < QsfpModule::MAX_QSFP_PAGE_SIZE) {
     read = len;
     if (QsfpModule::MAX_QSFP_PAGE_SIZE - offset < len) {
@@ -164,6 +175,7 @@ TEST(SffTest, simpleRead) {
   int idx = 1;
   std::unique_ptr<SffTransceiver> qsfpImpl =
     std::make_unique<SffTransceiver>(idx);
+  SffTransceiver* impl = qsfpImpl.get();
   std::unique_ptr<QsfpModule> qsfp =
     std::make_unique<QsfpModule>(std::move(qsfpImpl));
 
@@ -177,6 +189,54 @@ TEST(SffTest, simpleRead) {
   EXPECT_DOUBLE_EQ(-5.0, info.thresholds.temp.alarm.low);
   EXPECT_TRUE(info.channels[0].sensors.txBias.flags.alarm.low);
   EXPECT_FALSE(info.channels[1].sensors.txBias.flags.alarm.low);
+
+  // Repeat queries are served from the published snapshot without
+  // touching the bus again.
+  auto lowerReads = impl->lowerPageReads_;
+  auto upperReads = impl->upperPageReads_;
+  info = qsfp->getTransceiverInfo();
+  EXPECT_EQ("FACETEST", info.vendor.name);
+  EXPECT_EQ(lowerReads, impl->lowerPageReads_);
+  EXPECT_EQ(upperReads, impl->upperPageReads_);
+}
+
+// Expose the protected refresh entry point so the test can drive
+// partial and full refreshes directly.
+class TestQsfpModule : public QsfpModule {
+ public:
+  using QsfpModule::QsfpModule;
+  using QsfpModule::updateQsfpData;
+};
+
+TEST(SffTest, pageCaching) {
+  int idx = 1;
+  std::unique_ptr<SffTransceiver> qsfpImpl =
+    std::make_unique<SffTransceiver>(idx);
+  SffTransceiver* impl = qsfpImpl.get();
+  std::unique_ptr<TestQsfpModule> qsfp =
+    std::make_unique<TestQsfpModule>(std::move(qsfpImpl));
+
+  // The initial refresh reads everything: lower page plus both upper
+  // pages.
+  TransceiverInfo info = qsfp->getTransceiverInfo();
+  EXPECT_EQ("FACETEST", info.vendor.name);
+  EXPECT_EQ(1, impl->lowerPageReads_);
+  EXPECT_EQ(2, impl->upperPageReads_);
+
+  // A steady-state DOM refresh is one bulk lower page read; the static
+  // pages are served from the cache.
+  qsfp->updateQsfpData(false);
+  EXPECT_EQ(2, impl->lowerPageReads_);
+  EXPECT_EQ(2, impl->upperPageReads_);
+
+  // Static data remains available after the partial refresh.
+  info = qsfp->getTransceiverInfo();
+  EXPECT_EQ("FACETEST", info.vendor.name);
+  EXPECT_DOUBLE_EQ(75.0, info.thresholds.temp.alarm.high);
+
+  // An explicit full refresh re-reads the upper pages.
+  qsfp->updateQsfpData(true);
+  EXPECT_EQ(4, impl->upperPageReads_);
 }
 
 } // namespace facebook::fboss
@@ -3,9 +3,11 @@
 
 #include <folly/Conv.h>
 #include <folly/Range.h>
+#include <folly/String.h>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -52,6 +54,13 @@ DEFINE_int32(scl_low_timeout, -1,
 DEFINE_int32(smbus_retry_limit, -1,
              "The SMBus retry limit for the set_smbus_config command");
 
+// Flags for the bus_audit command.
+DEFINE_string(mux_addrs, "",
+              "Comma-separated list of PCA9548-style mux addresses to walk "
+              "for the bus_audit command (e.g. \"0xe0,0xe2\")");
+DEFINE_int32(mux_channels, 8,
+             "The number of channels per mux for the bus_audit command");
+
 class ArgError : public std::exception {
  public:
   template<typename... Args>
@@ -401,6 +410,145 @@ int cmdWrite(CP2112* dev, const vector<StringPiece>& args) {
   return 0;
 }
 
+/*
+ * Read a large block using maximum-size transfers.
+ *
+ * The target read pointer is written once and the device's address
+ * auto-increment carries us through the rest of the block, so there are
+ * no per-chunk address writes or status round-trips beyond what each
+ * maximum-size read already requires.
+ */
+void readBulk(CP2112* dev, uint8_t address, uint8_t offset,
+              MutableByteRange buf) {
+  dev->write(address, ByteRange(&offset, 1));
+  while (!buf.empty()) {
+    auto chunkLen = std::min(buf.size(),
+                             static_cast<size_t>(CP2112::MAX_READ_SIZE));
+    dev->read(address, MutableByteRange(buf.begin(), chunkLen));
+    buf.advance(chunkLen);
+  }
+}
+
+int cmdEepromRead(CP2112* dev, const vector<StringPiece>& args) {
+  if (args.size() != 3) {
+    fprintf(stderr, "error: incorrect number of arguments\n");
+    fprintf(stderr,
+            "usage: cp2112_util eeprom_read DEV_ADDRESS OFFSET LENGTH\n");
+    return 1;
+  }
+
+  uint8_t address = parseInt(args[0], "address", 0, 0xff);
+  if (address & 0x1) {
+    fprintf(stderr, "error: bad address %s: least significant bit must be 0\n",
+            args[0].str().c_str());
+    return 1;
+  }
+
+  uint8_t offset = parseInt(args[1], "offset", 0, 0xff);
+  uint32_t length = parseInt(args[2], "length", 1, 0xffff);
+
+  vector<uint8_t> buf(length, 0x55);
+  try {
+    readBulk(dev, address, offset, MutableByteRange(buf.data(), length));
+  } catch (const std::exception& ex) {
+    fprintf(stderr, "error performing read: %s\n", ex.what());
+    return 2;
+  }
+
+  printf("Read %u bytes at device 0x%02x offset 0x%02x:\n",
+         length, address, offset);
+  hexdump(buf.data(), length);
+  return 0;
+}
+
+vector<uint8_t> parseMuxAddrs() {
+  vector<uint8_t> addrs;
+  vector<StringPiece> pieces;
+  folly::split(',', FLAGS_mux_addrs, pieces, true);
+  for (const auto& piece : pieces) {
+    addrs.push_back(parseInt(piece, "mux address", 0, 0xff));
+  }
+  return addrs;
+}
+
+/*
+ * Dump the EEPROM of every device sharing one address behind the
+ * configured muxes in a single pass over the bus.  Without --mux_addrs
+ * this degenerates to a single bulk dump of the addressed device.
+ * Unreachable devices are reported and skipped rather than aborting the
+ * audit.
+ */
+int cmdBusAudit(CP2112* dev, const vector<StringPiece>& args) {
+  if (args.empty() || args.size() > 2) {
+    fprintf(stderr, "error: incorrect number of arguments\n");
+    fprintf(stderr, "usage: cp2112_util bus_audit DEV_ADDRESS [LENGTH]\n");
+    return 1;
+  }
+
+  uint8_t address = parseInt(args[0], "address", 0, 0xff);
+  if (address & 0x1) {
+    fprintf(stderr, "error: bad address %s: least significant bit must be 0\n",
+            args[0].str().c_str());
+    return 1;
+  }
+  uint32_t length = 256;
+  if (args.size() == 2) {
+    length = parseInt(args[1], "length", 1, 0xffff);
+  }
+
+  vector<uint8_t> buf(length);
+  auto dumpOne = [&](const std::string& label) {
+    memset(buf.data(), 0x55, length);
+    try {
+      readBulk(dev, address, 0, MutableByteRange(buf.data(), length));
+    } catch (const std::exception& ex) {
+      printf("%s: unreachable (%s)\n", label.c_str(), ex.what());
+      return false;
+    }
+    printf("%s: %u bytes at device 0x%02x:\n", label.c_str(), length, address);
+    hexdump(buf.data(), length);
+    return true;
+  };
+
+  auto muxes = parseMuxAddrs();
+  if (muxes.empty()) {
+    return dumpOne("bus") ? 0 : 2;
+  }
+
+  int found = 0;
+  int unreachable = 0;
+  for (auto mux : muxes) {
+    for (int channel = 0; channel < FLAGS_mux_channels; ++channel) {
+      try {
+        dev->writeByte(mux, 1 << channel);
+      } catch (const std::exception& ex) {
+        fprintf(stderr, "error selecting mux 0x%02x channel %d: %s\n",
+                mux, channel, ex.what());
+        ++unreachable;
+        continue;
+      }
+      auto label = folly::to<std::string>(
+          "mux 0x", folly::hexlify(ByteRange(&mux, 1)),
+          " channel ", channel);
+      if (dumpOne(label)) {
+        ++found;
+      } else {
+        ++unreachable;
+      }
+    }
+    // Deselect all channels so devices behind this mux don't shadow the
+    // devices behind the next one.
+    try {
+      dev->writeByte(mux, 0);
+    } catch (const std::exception& ex) {
+      fprintf(stderr, "error deselecting mux 0x%02x: %s\n", mux, ex.what());
+    }
+  }
+
+  printf("Audited %d devices (%d unreachable)\n", found, unreachable);
+  return 0;
+}
+
 bool scanAddress(CP2112* dev, uint8_t address) {
   if (address == 0 || address == 2) {
     // Don't try scanning address 0 (general call address, which addresses all
@@ -508,8 +656,10 @@ struct CommandInfo {
 std::map<std::string, CommandInfo> kCommands = {
   {"addr_read", {cmdAddrRead, " DEV_ADDRESS ADDRESS LENGTH"}},
   {"addr_read_unsafe", {cmdAddrReadUnsafe, " DEV_ADDRESS ADDRESS LENGTH"}},
+  {"bus_audit", {cmdBusAudit, " DEV_ADDRESS [LENGTH]"}},
   {"cancel_xfer", {cmdCancelXfer, ""}},
   {"detect", {cmdDetect, ""}},
+  {"eeprom_read", {cmdEepromRead, " DEV_ADDRESS OFFSET LENGTH"}},
   {"get_gpio", {cmdGetGpio, ""}},
   {"set_gpio", {cmdSetGpio, "VALUES MASK"}},
   {"get_gpio_config", {cmdGetGpioConfig, ""}},
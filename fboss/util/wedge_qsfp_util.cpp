@@ -9,6 +9,7 @@
 #include <folly/Memory.h>
 #include <folly/FileUtil.h>
 #include <folly/Exception.h>
+#include <folly/json.h>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
@@ -47,6 +48,12 @@ DEFINE_bool(cdr_disable, false,
 DEFINE_string(platform, "", "Platform on which we are running."
              " One of (galaxy, wedge100, wedge)");
 DEFINE_int32(open_timeout, 30, "Number of seconds to wait to open bus");
+DEFINE_bool(sweep, false,
+            "Sweep every module on the box and print a machine-readable "
+            "JSON health summary");
+DEFINE_int32(sweep_modules, 0,
+             "Number of modules to sweep; defaults to the platform's "
+             "full complement");
 
 bool overrideLowPower(
     TransceiverI2CApi* bus,
@@ -142,6 +149,107 @@ bool setTxDisable(TransceiverI2CApi* bus, unsigned int port, uint8_t value) {
   return true;
 }
 
+StringPiece sfpString(const uint8_t* buf, size_t offset, size_t len) {
+  const uint8_t* start = buf + offset;
+  while (len > 0 && start[len - 1] == ' ') {
+    --len;
+  }
+  return StringPiece(reinterpret_cast<const char*>(start), len);
+}
+
+/*
+ * Gather the health of one module with the minimum possible bus
+ * traffic: a single bulk read of the lower page doubles as the
+ * presence probe and supplies all of the DOM data, and a second bulk
+ * read pulls the vendor info from the upper page.  Any failure is
+ * recorded in the result rather than aborting the sweep.
+ */
+folly::dynamic sweepModule(TransceiverI2CApi* bus, unsigned int port) {
+  folly::dynamic result = folly::dynamic::object("port", static_cast<int>(port));
+  uint8_t buf[256];
+  try {
+    bus->moduleRead(port, TransceiverI2CApi::ADDR_QSFP, 0, 128, buf);
+  } catch (const UsbError& ex) {
+    result["present"] = false;
+    return result;
+  }
+
+  result["present"] = true;
+  result["id"] = buf[0];
+  result["temperature_c"] =
+      static_cast<int8_t>(buf[22]) + (buf[23] / 256.0);
+  result["vcc_v"] = ((buf[26] << 8) | buf[27]) / 10000.0;
+  result["tx_disable"] = buf[86];
+  result["power_set"] = buf[93];
+  result["cdr"] = buf[98];
+
+  folly::dynamic channels = folly::dynamic::array;
+  for (int chan = 0; chan < 4; ++chan) {
+    uint16_t rxValue = (buf[34 + 2 * chan] << 8) | buf[35 + 2 * chan];
+    uint16_t txValue = (buf[42 + 2 * chan] << 8) | buf[43 + 2 * chan];
+    channels.push_back(folly::dynamic::object
+                       ("rx_power_mw", 0.0001 * rxValue)
+                       ("tx_bias_ma", (131.0 * txValue) / 65535));
+  }
+  result["channels"] = std::move(channels);
+
+  try {
+    // Select page 0 if the module is paged and isn't there already.
+    if ((buf[2] & (1 << 2)) == 0) {
+      uint8_t page0 = 0;
+      if (buf[127] != page0) {
+        bus->moduleWrite(port, TransceiverI2CApi::ADDR_QSFP, 127, 1, &page0);
+      }
+    }
+    bus->moduleRead(port, TransceiverI2CApi::ADDR_QSFP, 128, 128, buf + 128);
+    result["vendor"] = sfpString(buf, 148, 16).str();
+    result["vendor_pn"] = sfpString(buf, 168, 16).str();
+    result["vendor_sn"] = sfpString(buf, 196, 16).str();
+    result["date_code"] = sfpString(buf, 212, 8).str();
+  } catch (const UsbError& ex) {
+    result["vendor_error"] = std::string(ex.what());
+  }
+  return result;
+}
+
+unsigned int getNumModules() {
+  if (FLAGS_sweep_modules > 0) {
+    return FLAGS_sweep_modules;
+  }
+  if (FLAGS_platform == "galaxy") {
+    return GalaxyI2CBus::NUM_PORTS;
+  } else if (FLAGS_platform == "wedge100") {
+    return Wedge100I2CBus::NUM_PORTS;
+  }
+  // Wedge has two PCA9548 switches of 8 QSFPs each.
+  return 16;
+}
+
+int sweepAllModules(TransceiverI2CApi* bus) {
+  auto start = steady_clock::now();
+  auto numModules = getNumModules();
+
+  folly::dynamic modules = folly::dynamic::array;
+  unsigned int numPresent = 0;
+  for (unsigned int port = 1; port <= numModules; ++port) {
+    auto result = sweepModule(bus, port);
+    if (result["present"].asBool()) {
+      ++numPresent;
+    }
+    modules.push_back(std::move(result));
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      steady_clock::now() - start);
+  folly::dynamic summary = folly::dynamic::object
+    ("modules", std::move(modules))
+    ("num_modules", static_cast<int>(numModules))
+    ("num_present", static_cast<int>(numPresent))
+    ("sweep_ms", elapsed.count());
+  printf("%s\n", folly::toJson(summary).c_str());
+  return EX_OK;
+}
+
 void printPortSummary(TransceiverI2CApi*) {
   // TODO: Implement code for showing a summary of all ports.
   // At the moment I haven't tested this since my test switch has some
@@ -151,14 +259,6 @@ void printPortSummary(TransceiverI2CApi*) {
   exit(1);
 }
 
-StringPiece sfpString(const uint8_t* buf, size_t offset, size_t len) {
-  const uint8_t* start = buf + offset;
-  while (len > 0 && start[len - 1] == ' ') {
-    --len;
-  }
-  return StringPiece(reinterpret_cast<const char*>(start), len);
-}
-
 void printChannelMonitor(unsigned int index,
                          const uint8_t* buf,
                          unsigned int rxMSB,
@@ -398,6 +498,15 @@ int main(int argc, char* argv[]) {
       return EX_IOERR;
   }
 
+  if (FLAGS_sweep) {
+    try {
+      return sweepAllModules(bus.get());
+    } catch (const std::exception& ex) {
+      fprintf(stderr, "error: %s\n", ex.what());
+      return EX_SOFTWARE;
+    }
+  }
+
   if (ports.empty()) {
     try {
       printPortSummary(bus.get());